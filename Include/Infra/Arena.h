@@ -0,0 +1,158 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+
+namespace ToolKit
+{
+/**
+ * @brief 单线程的线性（bump）分配器，可作为 std::pmr::memory_resource 交给 pmr 容器使用
+ * 分配只是在当前内存块中移动指针，deallocate 不做任何事，内存在 reset 时整体回收。
+ * reset 只把游标移回第一个内存块，已向上游申请的常规块全部保留，下一轮复用时不再分配；
+ * 超过块大小的单次分配单独向上游申请，在 reset 时归还。
+ * 适合请求作用域的数据：连接上每个请求结束时 reset，持久连接的后续请求不再触发 malloc/free。
+ */
+class Arena : public std::pmr::memory_resource
+{
+public:
+    static constexpr size_t DEFAULT_BLOCK_SIZE = 4096;
+
+    explicit Arena(size_t BlockSize = DEFAULT_BLOCK_SIZE, std::pmr::memory_resource* Upstream = std::pmr::new_delete_resource())
+            : m_blockSize(BlockSize < 256 ? 256 : BlockSize)
+            , m_upstream(Upstream)
+    {
+    }
+    ~Arena() override
+    {
+        releaseLarge();
+        while (m_blocks != nullptr)
+        {
+            Block* next = m_blocks->m_next;
+            m_upstream->deallocate(m_blocks, m_blockSize, alignof(std::max_align_t));
+            m_blocks = next;
+        }
+    }
+    Arena(const Arena&) = delete;
+    const Arena& operator=(const Arena&) = delete;
+
+    /**
+     * @brief 回收全部分配，保留常规内存块；之前分配出去的内存全部失效
+     */
+    void reset()
+    {
+        releaseLarge();
+        m_current = m_blocks;
+        m_cursor = m_current != nullptr ? m_current->begin() : nullptr;
+        m_end = m_current != nullptr ? m_current->end(m_blockSize) : nullptr;
+        m_used = 0;
+    }
+
+    /**
+     * @brief 自上次 reset 以来分配出去的字节数
+     */
+    size_t used() const { return m_used; }
+
+    /**
+     * @brief 保留的常规内存块个数
+     */
+    size_t blockCount() const { return m_blockCount; }
+
+protected:
+    void* do_allocate(size_t Bytes, size_t Alignment) override
+    {
+        m_used += Bytes;
+        if (void* ptr = bump(Bytes, Alignment))
+            return ptr;
+        if (Bytes + Alignment + sizeof(Block) > m_blockSize)
+            return allocateLarge(Bytes, Alignment);
+        /* 当前块放不下，依次尝试上一轮保留下来的后续块，都用完了才向上游申请 */
+        while (m_current != nullptr && m_current->m_next != nullptr)
+        {
+            enter(m_current->m_next);
+            if (void* ptr = bump(Bytes, Alignment))
+                return ptr;
+        }
+        auto* block = static_cast<Block*>(m_upstream->allocate(m_blockSize, alignof(std::max_align_t)));
+        block->m_next = nullptr;
+        if (m_current != nullptr)
+            m_current->m_next = block;
+        else
+            m_blocks = block;
+        m_blockCount++;
+        enter(block);
+        return bump(Bytes, Alignment);
+    }
+
+    void do_deallocate(void*, size_t, size_t) override {}
+
+    bool do_is_equal(const std::pmr::memory_resource& Other) const noexcept override { return this == &Other; }
+
+private:
+    struct Block
+    {
+        Block* m_next;
+
+        char* begin() { return reinterpret_cast<char*>(this + 1); }
+        char* end(size_t Size) { return reinterpret_cast<char*>(this) + Size; }
+    };
+
+    struct LargeBlock
+    {
+        LargeBlock* m_next;
+        size_t m_size;
+        size_t m_alignment;
+    };
+
+    void* bump(size_t Bytes, size_t Alignment)
+    {
+        if (m_cursor == nullptr)
+            return nullptr;
+        auto address = reinterpret_cast<uintptr_t>(m_cursor);
+        auto aligned = (address + Alignment - 1) & ~(static_cast<uintptr_t>(Alignment) - 1);
+        if (aligned + Bytes > reinterpret_cast<uintptr_t>(m_end))
+            return nullptr;
+        m_cursor = reinterpret_cast<char*>(aligned + Bytes);
+        return reinterpret_cast<void*>(aligned);
+    }
+
+    void enter(Block* Target)
+    {
+        m_current = Target;
+        m_cursor = Target->begin();
+        m_end = Target->end(m_blockSize);
+    }
+
+    void* allocateLarge(size_t Bytes, size_t Alignment)
+    {
+        size_t alignment = Alignment > alignof(LargeBlock) ? Alignment : alignof(LargeBlock);
+        size_t header = (sizeof(LargeBlock) + alignment - 1) / alignment * alignment;
+        auto* block = static_cast<LargeBlock*>(m_upstream->allocate(header + Bytes, alignment));
+        block->m_next = m_large;
+        block->m_size = header + Bytes;
+        block->m_alignment = alignment;
+        m_large = block;
+        return reinterpret_cast<char*>(block) + header;
+    }
+
+    void releaseLarge()
+    {
+        while (m_large != nullptr)
+        {
+            LargeBlock* next = m_large->m_next;
+            m_upstream->deallocate(m_large, m_large->m_size, m_large->m_alignment);
+            m_large = next;
+        }
+    }
+
+    const size_t m_blockSize;
+    std::pmr::memory_resource* const m_upstream;
+    Block* m_blocks { nullptr };
+    Block* m_current { nullptr };
+    LargeBlock* m_large { nullptr };
+    char* m_cursor { nullptr };
+    char* m_end { nullptr };
+    size_t m_used { 0 };
+    size_t m_blockCount { 0 };
+};
+}   // namespace ToolKit
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace ToolKit
+{
+/**
+ * @brief Chase–Lev 工作窃取双端队列
+ * 所有者线程在底部 push/pop（LIFO），其他线程从顶部 steal（FIFO）。
+ * 元素为指针，空队列或窃取竞争失败时返回 nullptr。
+ * 实现参照 Lê 等人 "Correct and Efficient Work-Stealing for Weak Memory Models" (PPoPP'13)。
+ * 扩容时旧数组可能仍在被窃取者读取，因此保留到队列析构时统一释放。
+ */
+template <typename T>
+class ChaseLevDeque
+{
+public:
+    explicit ChaseLevDeque(size_t Capacity = 256);
+    ChaseLevDeque(const ChaseLevDeque&) = delete;
+    const ChaseLevDeque& operator=(const ChaseLevDeque&) = delete;
+
+    /**
+     * @brief 只能由所有者线程调用
+     */
+    void push(T* Item);
+
+    /**
+     * @brief 只能由所有者线程调用，取最近 push 的元素
+     */
+    T* pop();
+
+    /**
+     * @brief 可被任意线程调用，取最早 push 的元素
+     */
+    T* steal();
+
+    bool empty() const
+    {
+        return m_top.load(std::memory_order_relaxed) >= m_bottom.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct Array
+    {
+        explicit Array(int64_t Capacity)
+                : m_mask(Capacity - 1)
+                , m_cells(new std::atomic<T*>[Capacity])
+        {
+        }
+        int64_t capacity() const { return m_mask + 1; }
+        T* get(int64_t Index) const { return m_cells[Index & m_mask].load(std::memory_order_relaxed); }
+        void put(int64_t Index, T* Item) { m_cells[Index & m_mask].store(Item, std::memory_order_relaxed); }
+
+        const int64_t m_mask;
+        std::unique_ptr<std::atomic<T*>[]> m_cells;
+    };
+
+    Array* grow(Array* Current, int64_t Bottom, int64_t Top);
+
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+
+    alignas(CACHE_LINE_SIZE) std::atomic<int64_t> m_top { 0 };
+    alignas(CACHE_LINE_SIZE) std::atomic<int64_t> m_bottom { 0 };
+    std::atomic<Array*> m_array;
+    std::vector<std::unique_ptr<Array>> m_arrays;
+};
+
+template <typename T>
+ChaseLevDeque<T>::ChaseLevDeque(size_t Capacity)
+{
+    int64_t capacity = 2;
+    while (capacity < static_cast<int64_t>(Capacity))
+        capacity <<= 1;
+    m_arrays.emplace_back(new Array(capacity));
+    m_array.store(m_arrays.back().get(), std::memory_order_relaxed);
+}
+
+template <typename T>
+typename ChaseLevDeque<T>::Array* ChaseLevDeque<T>::grow(Array* Current, int64_t Bottom, int64_t Top)
+{
+    m_arrays.emplace_back(new Array(Current->capacity() * 2));
+    Array* bigger = m_arrays.back().get();
+    for (int64_t i = Top; i < Bottom; i++)
+        bigger->put(i, Current->get(i));
+    m_array.store(bigger, std::memory_order_release);
+    return bigger;
+}
+
+template <typename T>
+void ChaseLevDeque<T>::push(T* Item)
+{
+    int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+    int64_t top = m_top.load(std::memory_order_acquire);
+    Array* array = m_array.load(std::memory_order_relaxed);
+    if (bottom - top > array->capacity() - 1)
+        array = grow(array, bottom, top);
+    array->put(bottom, Item);
+    m_bottom.store(bottom + 1, std::memory_order_release);
+}
+
+template <typename T>
+T* ChaseLevDeque<T>::pop()
+{
+    int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+    Array* array = m_array.load(std::memory_order_relaxed);
+    m_bottom.store(bottom, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t top = m_top.load(std::memory_order_relaxed);
+
+    if (top > bottom)
+    {
+        m_bottom.store(bottom + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    T* item = array->get(bottom);
+    if (top == bottom)
+    {
+        /* 只剩最后一个元素，与窃取者竞争 */
+        if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            item = nullptr;
+        m_bottom.store(bottom + 1, std::memory_order_relaxed);
+    }
+    return item;
+}
+
+template <typename T>
+T* ChaseLevDeque<T>::steal()
+{
+    int64_t top = m_top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t bottom = m_bottom.load(std::memory_order_acquire);
+    if (top >= bottom)
+        return nullptr;
+    Array* array = m_array.load(std::memory_order_acquire);
+    T* item = array->get(top);
+    if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+        return nullptr;
+    return item;
+}
+}   // namespace ToolKit
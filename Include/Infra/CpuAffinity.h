@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <linux/mempolicy.h>
+#include <pthread.h>
+#include <sched.h>
+#include <string>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <vector>
+
+namespace ToolKit
+{
+/**
+ * @brief 解析 Linux cpulist 格式的 CPU 列表（如 "0-3,8,10-11"），按书写顺序返回，格式错误或为空时返回空列表
+ */
+inline std::vector<int> parseCpuList(const std::string& List)
+{
+    std::vector<int> cpus;
+    const char* cursor = List.c_str();
+    while (*cursor != '\0')
+    {
+        char* end;
+        long first = strtol(cursor, &end, 10);
+        if (end == cursor || first < 0 || first >= CPU_SETSIZE)
+            return {};
+        long last = first;
+        cursor = end;
+        if (*cursor == '-')
+        {
+            last = strtol(cursor + 1, &end, 10);
+            if (end == cursor + 1 || last < first || last >= CPU_SETSIZE)
+                return {};
+            cursor = end;
+        }
+        for (long cpu = first; cpu <= last; cpu++)
+            cpus.push_back(static_cast<int>(cpu));
+        if (*cursor == ',')
+            cursor++;
+        else if (*cursor != '\0')
+            return {};
+    }
+    return cpus;
+}
+
+/**
+ * @brief 把线程限定在 Cpus 上运行，Cpus 为空时不做任何事
+ */
+inline bool setThreadAffinity(pthread_t Thread, const std::vector<int>& Cpus)
+{
+    if (Cpus.empty())
+        return true;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : Cpus)
+        CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(Thread, sizeof(set), &set) == 0;
+}
+
+/**
+ * @brief CPU 所在的 NUMA 节点，读取 sysfs 中 cpuN 目录下的 nodeK 链接；非 NUMA 内核或查不到时返回 -1
+ */
+inline int cpuNode(int Cpu)
+{
+    std::string path = "/sys/devices/system/cpu/cpu" + std::to_string(Cpu);
+    DIR* dir = opendir(path.c_str());
+    if (dir == nullptr)
+        return -1;
+    int node = -1;
+    while (struct dirent* entry = readdir(dir))
+    {
+        char* end;
+        if (strncmp(entry->d_name, "node", 4) != 0)
+            continue;
+        long value = strtol(entry->d_name + 4, &end, 10);
+        if (end != entry->d_name + 4 && *end == '\0')
+        {
+            node = static_cast<int>(value);
+            break;
+        }
+    }
+    closedir(dir);
+    return node;
+}
+
+/**
+ * @brief 作用域内调用线程新分配的页优先取自 Node 节点，析构时恢复原来的内存策略
+ * Linux 按首次访问分配物理页：在主线程上为某个 Reactor 预先创建的队列、事件循环与缓冲区环，
+ * 放在对应节点的作用域中创建就落在该 Reactor 所在的节点上。Node 小于 0 或内核不支持时不做任何事。
+ * 直接使用系统调用，不依赖 libnuma。
+ */
+class MemoryNodeScope
+{
+public:
+    explicit MemoryNodeScope(int Node)
+    {
+        if (Node < 0 || Node >= static_cast<int>(MAX_NODES))
+            return;
+        if (syscall(SYS_get_mempolicy, &m_savedMode, m_savedMask, MAX_NODES, nullptr, 0UL) != 0)
+            return;
+        unsigned long mask[MASK_WORDS] {};
+        mask[Node / BITS_PER_WORD] = 1UL << (Node % BITS_PER_WORD);
+        m_active = syscall(SYS_set_mempolicy, MPOL_PREFERRED, mask, MAX_NODES) == 0;
+    }
+    ~MemoryNodeScope()
+    {
+        if (m_active)
+            syscall(SYS_set_mempolicy, m_savedMode, m_savedMode == MPOL_DEFAULT ? nullptr : m_savedMask, MAX_NODES);
+    }
+    MemoryNodeScope(const MemoryNodeScope&) = delete;
+    const MemoryNodeScope& operator=(const MemoryNodeScope&) = delete;
+
+    /**
+     * @brief 内存策略已切换到目标节点
+     */
+    bool active() const { return m_active; }
+
+private:
+    static constexpr unsigned long MAX_NODES = 1024;
+    static constexpr unsigned long BITS_PER_WORD = sizeof(unsigned long) * 8;
+    static constexpr unsigned long MASK_WORDS = MAX_NODES / BITS_PER_WORD;
+
+    int m_savedMode { MPOL_DEFAULT };
+    unsigned long m_savedMask[MASK_WORDS] {};
+    bool m_active { false };
+};
+}   // namespace ToolKit
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace ToolKit
+{
+/**
+ * @brief 有界无锁多生产者单消费者队列
+ * 基于 Vyukov 的环形缓冲区算法：每个槽位带一个序号，生产者通过 CAS 抢占写位置，
+ * 唯一的消费者按序读取，不需要任何 CAS。容量向上取整为 2 的幂。
+ * 队列满时 tryPush 失败返回 false，由调用方决定丢弃或改投其他队列。
+ */
+template <typename T>
+class MpscQueue
+{
+public:
+    explicit MpscQueue(size_t Capacity);
+    ~MpscQueue();
+    MpscQueue(const MpscQueue&) = delete;
+    const MpscQueue& operator=(const MpscQueue&) = delete;
+
+    /**
+     * @brief 可被任意线程并发调用
+     */
+    template <typename U>
+    bool tryPush(U&& Value);
+
+    /**
+     * @brief 只能由唯一的消费者线程调用
+     */
+    bool tryPop(T& Value);
+
+    size_t capacity() const { return m_mask + 1; }
+
+private:
+    struct Slot
+    {
+        std::atomic<size_t> m_sequence;
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type m_storage;
+    };
+
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+
+    static size_t roundUpPowerOfTwo(size_t Value)
+    {
+        size_t result = 2;
+        while (result < Value)
+            result <<= 1;
+        return result;
+    }
+
+    const size_t m_mask;
+    Slot* const m_slots;
+    /* 生产者与消费者的游标分处不同缓存行，避免伪共享 */
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> m_tail { 0 };
+    alignas(CACHE_LINE_SIZE) size_t m_head { 0 };
+};
+
+template <typename T>
+MpscQueue<T>::MpscQueue(size_t Capacity)
+        : m_mask(roundUpPowerOfTwo(Capacity) - 1)
+        , m_slots(new Slot[m_mask + 1])
+{
+    for (size_t i = 0; i <= m_mask; i++)
+        m_slots[i].m_sequence.store(i, std::memory_order_relaxed);
+}
+
+template <typename T>
+MpscQueue<T>::~MpscQueue()
+{
+    T value;
+    while (tryPop(value))
+        ;
+    delete[] m_slots;
+}
+
+template <typename T>
+template <typename U>
+bool MpscQueue<T>::tryPush(U&& Value)
+{
+    size_t pos = m_tail.load(std::memory_order_relaxed);
+    Slot* slot;
+    for (;;)
+    {
+        slot = &m_slots[pos & m_mask];
+        size_t sequence = slot->m_sequence.load(std::memory_order_acquire);
+        auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos);
+        if (diff == 0)
+        {
+            if (m_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                break;
+        }
+        else if (diff < 0)
+        {
+            /* 槽位尚未被消费者释放，队列已满 */
+            return false;
+        }
+        else
+        {
+            pos = m_tail.load(std::memory_order_relaxed);
+        }
+    }
+    new (&slot->m_storage) T(std::forward<U>(Value));
+    slot->m_sequence.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+template <typename T>
+bool MpscQueue<T>::tryPop(T& Value)
+{
+    Slot* slot = &m_slots[m_head & m_mask];
+    size_t sequence = slot->m_sequence.load(std::memory_order_acquire);
+    if (static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(m_head + 1) < 0)
+        return false;
+    T* item = std::launder(reinterpret_cast<T*>(&slot->m_storage));
+    Value = std::move(*item);
+    item->~T();
+    slot->m_sequence.store(m_head + m_mask + 1, std::memory_order_release);
+    m_head++;
+    return true;
+}
+}   // namespace ToolKit
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <utility>
+
+namespace ToolKit
+{
+/**
+ * @brief 引用计数的不可变字节缓冲区，计数与数据在同一次分配中
+ * 创建后内容不再修改，可以被任意多个线程同时读取；最后一个引用释放时整体回收。
+ * 除了 Ptr 持有的引用外，还可以通过 retain 交出一个裸引用给 C 回调（例如 evbuffer_add_reference 的
+ * cleanup 参数），由 releaseCallback 归还，这样同一份数据挂到多个输出缓冲区上都不需要拷贝。
+ */
+class SharedBuffer
+{
+public:
+    /**
+     * @brief 持有一个引用的智能指针
+     */
+    class Ptr
+    {
+    public:
+        Ptr() = default;
+        ~Ptr() { reset(); }
+        Ptr(const Ptr& Other)
+                : m_buffer(Other.m_buffer)
+        {
+            if (m_buffer != nullptr)
+                m_buffer->retain();
+        }
+        Ptr(Ptr&& Other) noexcept
+                : m_buffer(std::exchange(Other.m_buffer, nullptr))
+        {
+        }
+        Ptr& operator=(Ptr Other) noexcept
+        {
+            std::swap(m_buffer, Other.m_buffer);
+            return *this;
+        }
+
+        void reset()
+        {
+            if (m_buffer != nullptr)
+                std::exchange(m_buffer, nullptr)->release();
+        }
+
+        const SharedBuffer* get() const { return m_buffer; }
+        const SharedBuffer* operator->() const { return m_buffer; }
+        explicit operator bool() const { return m_buffer != nullptr; }
+
+    private:
+        friend class SharedBuffer;
+        explicit Ptr(const SharedBuffer* Buffer)
+                : m_buffer(Buffer)
+        {
+        }
+
+        const SharedBuffer* m_buffer { nullptr };
+    };
+
+    /**
+     * @brief 复制 Data 的内容创建缓冲区
+     */
+    static Ptr copyOf(const void* Data, size_t Size)
+    {
+        void* memory = ::operator new(sizeof(SharedBuffer) + Size);
+        auto* buffer = new (memory) SharedBuffer(Size);
+        if (Size > 0)
+            memcpy(buffer->bytes(), Data, Size);
+        return Ptr(buffer);
+    }
+
+    SharedBuffer(const SharedBuffer&) = delete;
+    const SharedBuffer& operator=(const SharedBuffer&) = delete;
+
+    const char* data() const { return const_cast<SharedBuffer*>(this)->bytes(); }
+    size_t size() const { return m_size; }
+
+    /**
+     * @brief 增加一个裸引用，须由 release 或 releaseCallback 归还
+     */
+    void retain() const { m_refs.fetch_add(1, std::memory_order_relaxed); }
+
+    void release() const
+    {
+        if (m_refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            this->~SharedBuffer();
+            ::operator delete(const_cast<SharedBuffer*>(this));
+        }
+    }
+
+    /**
+     * @brief 与 evbuffer_ref_cleanup_cb 签名一致的释放回调，Self 为 retain 过的缓冲区
+     */
+    static void releaseCallback(const void*, size_t, void* Self) { static_cast<const SharedBuffer*>(Self)->release(); }
+
+private:
+    explicit SharedBuffer(size_t Size)
+            : m_size(Size)
+    {
+    }
+    ~SharedBuffer() = default;
+
+    char* bytes() { return reinterpret_cast<char*>(this + 1); }
+
+    mutable std::atomic<size_t> m_refs { 1 };
+    const size_t m_size;
+};
+}   // namespace ToolKit
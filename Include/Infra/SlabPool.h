@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace ToolKit
+{
+/**
+ * @brief 单线程对象池，对象按 slab 成批分配，释放后保持构造状态等待复用
+ * acquire 优先返回之前 release 的对象（其成员及其持有的资源原样保留，由调用方重新初始化），
+ * 没有空闲对象时在 slab 的空槽位上构造新对象，slab 用完才向堆申请下一块。
+ * 空闲对象超过 MaxIdle 时 release 直接析构对象，只把槽位留给之后的 acquire，避免连接风暴后常驻过多资源。
+ * 对象按 alignof(T) 对齐，T 声明为缓存行对齐时相邻对象不会共享缓存行。
+ * 析构时只销毁空闲对象，仍在使用中的对象须由调用方先 release。
+ */
+template <typename T, size_t SLAB_OBJECTS = 64>
+class SlabPool
+{
+public:
+    explicit SlabPool(size_t MaxIdle = SIZE_MAX)
+            : m_maxIdle(MaxIdle)
+    {
+    }
+    ~SlabPool()
+    {
+        for (T* object : m_idle)
+            object->~T();
+    }
+    SlabPool(const SlabPool&) = delete;
+    const SlabPool& operator=(const SlabPool&) = delete;
+
+    /**
+     * @brief 取一个对象；Args 只在新构造对象时使用
+     */
+    template <class... Args>
+    T* acquire(Args&&... ParamArgs)
+    {
+        if (!m_idle.empty())
+        {
+            T* object = m_idle.back();
+            m_idle.pop_back();
+            return object;
+        }
+        return new (slot()) T(std::forward<Args>(ParamArgs)...);
+    }
+
+    void release(T* Object)
+    {
+        if (m_idle.size() < m_maxIdle)
+        {
+            m_idle.push_back(Object);
+            return;
+        }
+        Object->~T();
+        m_freeSlots.push_back(Object);
+    }
+
+    /**
+     * @brief 等待复用的对象数
+     */
+    size_t idle() const { return m_idle.size(); }
+
+    /**
+     * @brief 已分配的槽位总数
+     */
+    size_t capacity() const { return m_slabs.size() * SLAB_OBJECTS; }
+
+private:
+    struct alignas(T) Storage
+    {
+        unsigned char m_bytes[sizeof(T)];
+    };
+
+    void* slot()
+    {
+        if (!m_freeSlots.empty())
+        {
+            void* storage = m_freeSlots.back();
+            m_freeSlots.pop_back();
+            return storage;
+        }
+        if (m_nextInSlab == SLAB_OBJECTS || m_slabs.empty())
+        {
+            m_slabs.emplace_back(new Storage[SLAB_OBJECTS]);
+            m_nextInSlab = 0;
+        }
+        return &m_slabs.back()[m_nextInSlab++];
+    }
+
+    const size_t m_maxIdle;
+    std::vector<std::unique_ptr<Storage[]>> m_slabs;
+    size_t m_nextInSlab { 0 };
+    std::vector<T*> m_idle;
+    std::vector<void*> m_freeSlots;
+};
+}   // namespace ToolKit
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace ToolKit
+{
+/**
+ * @brief 只可移动的 void() 任务，带小缓冲区优化
+ * 捕获不超过 INLINE_SIZE 字节且 noexcept 可移动的可调用对象直接存放在对象内部，不分配堆内存；
+ * 更大的对象退化为一次堆分配。整个对象恰好占一个缓存行。
+ * 与 std::function 不同，它可以保存 std::packaged_task 这类只可移动的对象。
+ */
+class SmallTask
+{
+public:
+    static constexpr size_t INLINE_SIZE = 48;
+
+    template <class F>
+    static constexpr bool storedInline()
+    {
+        return sizeof(F) <= INLINE_SIZE && alignof(F) <= alignof(std::max_align_t)
+            && std::is_nothrow_move_constructible<F>::value;
+    }
+
+    SmallTask() noexcept = default;
+
+    template <class F, class = typename std::enable_if<!std::is_same<typename std::decay<F>::type, SmallTask>::value>::type>
+    SmallTask(F&& Func)
+    {
+        using Callable = typename std::decay<F>::type;
+        if constexpr (storedInline<Callable>())
+        {
+            new (m_storage) Callable(std::forward<F>(Func));
+            m_ops = &INLINE_OPS<Callable>;
+        }
+        else
+        {
+            *reinterpret_cast<Callable**>(m_storage) = new Callable(std::forward<F>(Func));
+            m_ops = &HEAP_OPS<Callable>;
+        }
+    }
+
+    SmallTask(SmallTask&& Other) noexcept { moveFrom(Other); }
+
+    SmallTask& operator=(SmallTask&& Other) noexcept
+    {
+        if (this != &Other)
+        {
+            reset();
+            moveFrom(Other);
+        }
+        return *this;
+    }
+
+    SmallTask(const SmallTask&) = delete;
+    const SmallTask& operator=(const SmallTask&) = delete;
+
+    ~SmallTask() { reset(); }
+
+    void operator()() { m_ops->m_invoke(m_storage); }
+
+    explicit operator bool() const { return m_ops != nullptr; }
+
+    void reset()
+    {
+        if (m_ops != nullptr)
+        {
+            m_ops->m_destroy(m_storage);
+            m_ops = nullptr;
+        }
+    }
+
+private:
+    struct Ops
+    {
+        void (*m_invoke)(void* Storage);
+        /* 把 Src 中的对象移动构造到 Dst，并销毁 Src 中的对象 */
+        void (*m_relocate)(void* Dst, void* Src);
+        void (*m_destroy)(void* Storage);
+    };
+
+    template <class Callable>
+    static constexpr Ops INLINE_OPS {
+        [](void* Storage) { (*std::launder(reinterpret_cast<Callable*>(Storage)))(); },
+        [](void* Dst, void* Src)
+        {
+            auto* source = std::launder(reinterpret_cast<Callable*>(Src));
+            new (Dst) Callable(std::move(*source));
+            source->~Callable();
+        },
+        [](void* Storage) { std::launder(reinterpret_cast<Callable*>(Storage))->~Callable(); },
+    };
+
+    template <class Callable>
+    static constexpr Ops HEAP_OPS {
+        [](void* Storage) { (**reinterpret_cast<Callable**>(Storage))(); },
+        [](void* Dst, void* Src) { *reinterpret_cast<Callable**>(Dst) = *reinterpret_cast<Callable**>(Src); },
+        [](void* Storage) { delete *reinterpret_cast<Callable**>(Storage); },
+    };
+
+    void moveFrom(SmallTask& Other) noexcept
+    {
+        if (Other.m_ops != nullptr)
+        {
+            Other.m_ops->m_relocate(m_storage, Other.m_storage);
+            m_ops = Other.m_ops;
+            Other.m_ops = nullptr;
+        }
+    }
+
+    alignas(std::max_align_t) unsigned char m_storage[INLINE_SIZE];
+    const Ops* m_ops { nullptr };
+};
+}   // namespace ToolKit
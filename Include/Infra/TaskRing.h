@@ -0,0 +1,57 @@
+#pragma once
+
+#include "Infra/SmallTask.h"
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace ToolKit
+{
+/**
+ * @brief SmallTask 的环形队列，容量只增不减
+ * 队列增长到工作负载所需的大小后，入队出队都只是在已有槽位上移动任务，不再分配内存。
+ * 不是线程安全的，由调用方加锁。
+ */
+class TaskRing
+{
+public:
+    explicit TaskRing(size_t Capacity = 64)
+            : m_slots(Capacity < 2 ? 2 : Capacity)
+    {
+    }
+
+    void push(SmallTask&& Task)
+    {
+        if (m_size == m_slots.size())
+            grow();
+        m_slots[(m_head + m_size) % m_slots.size()] = std::move(Task);
+        m_size++;
+    }
+
+    SmallTask pop()
+    {
+        SmallTask task = std::move(m_slots[m_head]);
+        m_head = (m_head + 1) % m_slots.size();
+        m_size--;
+        return task;
+    }
+
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+private:
+    void grow()
+    {
+        std::vector<SmallTask> bigger(m_slots.size() * 2);
+        for (size_t i = 0; i < m_size; i++)
+            bigger[i] = std::move(m_slots[(m_head + i) % m_slots.size()]);
+        m_slots.swap(bigger);
+        m_head = 0;
+    }
+
+    std::vector<SmallTask> m_slots;
+    size_t m_head { 0 };
+    size_t m_size { 0 };
+};
+}   // namespace ToolKit
@@ -1,29 +1,63 @@
 #pragma once
 
+#include "Infra/CpuAffinity.h"
+#include "Infra/SmallTask.h"
+#include "Infra/TaskRing.h"
+
 #include <condition_variable>
 #include <functional>
 #include <future>
 #include <memory>
 #include <mutex>
-#include <queue>
 #include <stdexcept>
 #include <thread>
+#include <tuple>
 #include <vector>
 namespace ToolKit
 {
+/**
+ * @brief 把 Func 与参数打包成一个 void() 任务，参数按值保存，调用时以左值传入（与 std::bind 一致）
+ */
+template <class F, class... Args>
+SmallTask makeTask(F&& Func, Args&&... ParamArgs)
+{
+    if constexpr (sizeof...(Args) == 0)
+        return SmallTask(std::forward<F>(Func));
+    else
+        return SmallTask(
+            [func = std::forward<F>(Func), args = std::make_tuple(std::forward<Args>(ParamArgs)...)]() mutable
+            { std::apply(func, args); });
+}
+
 class ThreadPool
 {
 public:
-    ThreadPool(size_t);
+    /**
+     * @brief 启动 Threads 个工作线程，Cpus 不为空时每个工作线程都限定在这组 CPU 上运行
+     */
+    ThreadPool(size_t Threads, const std::vector<int>& Cpus = {});
     template <class F, class... Args>
     auto enqueue(F&& Func, Args&&... ParamArgs) -> std::future<typename std::result_of<F(Args...)>::type>;
+
+    /**
+     * @brief 提交不需要结果的任务，不创建 future；任务较小时整个提交过程不分配堆内存
+     */
+    template <class F, class... Args>
+    void post(F&& Func, Args&&... ParamArgs);
+
+    /**
+     * @brief 在一次加锁内提交 [First, Last) 中的全部可调用对象，元素会被移走
+     */
+    template <class Iterator>
+    void enqueueBulk(Iterator First, Iterator Last);
+
     ~ThreadPool();
 
 private:
     // need to keep track of threads so we can join them
     std::vector<std::thread> m_workers;
-    // the task queue
-    std::queue<std::function<void()>> m_tasks;
+    // the task queue, it only grows so steady state submission does not allocate
+    TaskRing m_tasks;
 
     // synchronization
     std::mutex m_queueMutex;
@@ -32,28 +66,30 @@ private:
 };
 
 // the constructor just launches some amount of workers
-inline ThreadPool::ThreadPool(size_t Threads)
+inline ThreadPool::ThreadPool(size_t Threads, const std::vector<int>& Cpus)
         : m_stop(false)
 {
     for (size_t i = 0; i < Threads; ++i)
+    {
         m_workers.emplace_back(
             [this]
             {
                 for (;;)
                 {
-                    std::function<void()> task;
+                    SmallTask task;
                     {
                         std::unique_lock<std::mutex> lock(this->m_queueMutex);
                         this->m_condition.wait(lock, [this] { return this->m_stop || !this->m_tasks.empty(); });
                         if (this->m_stop && this->m_tasks.empty())
                             return;
-                        task = std::move(this->m_tasks.front());
-                        this->m_tasks.pop();
+                        task = this->m_tasks.pop();
                     }
 
                     task();
                 }
             });
+        setThreadAffinity(m_workers.back().native_handle(), Cpus);
+    }
 }
 
 // add new work item to the pool
@@ -62,10 +98,10 @@ auto ThreadPool::enqueue(F&& Func, Args&&... ParamArgs) -> std::future<typename
 {
     using return_type = typename std::result_of<F(Args...)>::type;
 
-    auto task =
-        std::make_shared<std::packaged_task<return_type()>>(std::bind(std::forward<F>(Func), std::forward<Args>(ParamArgs)...));
+    // packaged_task is move-only, SmallTask stores it inline so only the future state is allocated
+    std::packaged_task<return_type()> task(std::bind(std::forward<F>(Func), std::forward<Args>(ParamArgs)...));
 
-    std::future<return_type> res = task->get_future();
+    std::future<return_type> res = task.get_future();
     {
         std::unique_lock<std::mutex> lock(m_queueMutex);
 
@@ -73,12 +109,42 @@ auto ThreadPool::enqueue(F&& Func, Args&&... ParamArgs) -> std::future<typename
         if (m_stop)
             throw std::runtime_error("enqueue on stopped ThreadPool");
 
-        m_tasks.emplace([task]() { (*task)(); });
+        m_tasks.push(SmallTask(std::move(task)));
     }
     m_condition.notify_one();
     return res;
 }
 
+template <class F, class... Args>
+void ThreadPool::post(F&& Func, Args&&... ParamArgs)
+{
+    SmallTask task = makeTask(std::forward<F>(Func), std::forward<Args>(ParamArgs)...);
+    {
+        std::unique_lock<std::mutex> lock(m_queueMutex);
+        if (m_stop)
+            throw std::runtime_error("post on stopped ThreadPool");
+        m_tasks.push(std::move(task));
+    }
+    m_condition.notify_one();
+}
+
+template <class Iterator>
+void ThreadPool::enqueueBulk(Iterator First, Iterator Last)
+{
+    size_t count = 0;
+    {
+        std::unique_lock<std::mutex> lock(m_queueMutex);
+        if (m_stop)
+            throw std::runtime_error("enqueueBulk on stopped ThreadPool");
+        for (; First != Last; ++First, ++count)
+            m_tasks.push(SmallTask(std::move(*First)));
+    }
+    if (count == 1)
+        m_condition.notify_one();
+    else if (count > 1)
+        m_condition.notify_all();
+}
+
 // the destructor joins all threads
 inline ThreadPool::~ThreadPool()
 {
@@ -90,4 +156,4 @@ inline ThreadPool::~ThreadPool()
     for (std::thread& worker : m_workers)
         worker.join();
 }
-}   // namespace ToolKit
\ No newline at end of file
+}   // namespace ToolKit
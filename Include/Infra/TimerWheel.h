@@ -0,0 +1,212 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+
+namespace ToolKit
+{
+class TimerWheel;
+
+/**
+ * @brief 挂在 TimerWheel 上的侵入式定时器
+ * 节点直接嵌在使用者对象中，布防、重新布防与取消都只是链表指针操作，不分配内存。
+ * 析构时自动从时间轮上摘除；到期后先摘除再调用回调，回调中可以重新布防或销毁定时器本身。
+ */
+class WheelTimer
+{
+public:
+    using Callback = std::function<void()>;
+
+    WheelTimer() = default;
+    explicit WheelTimer(Callback Func)
+            : m_callback(std::move(Func))
+    {
+    }
+    ~WheelTimer() { unlink(); }
+    WheelTimer(const WheelTimer&) = delete;
+    const WheelTimer& operator=(const WheelTimer&) = delete;
+
+    void setCallback(Callback Func) { m_callback = std::move(Func); }
+
+    bool armed() const { return m_pprev != nullptr; }
+
+    /**
+     * @brief 从所在的时间轮上摘除，与 TimerWheel::cancel 相同，不需要知道是哪个时间轮
+     */
+    void cancel() { unlink(); }
+
+    /**
+     * @brief 到期的时钟刻度，仅在 armed 时有意义
+     */
+    uint64_t expiry() const { return m_expiry; }
+
+private:
+    friend class TimerWheel;
+
+    void unlink()
+    {
+        if (m_pprev == nullptr)
+            return;
+        *m_pprev = m_next;
+        if (m_next != nullptr)
+            m_next->m_pprev = m_pprev;
+        m_next = nullptr;
+        m_pprev = nullptr;
+    }
+
+    void linkTo(WheelTimer*& Head)
+    {
+        m_next = Head;
+        if (Head != nullptr)
+            Head->m_pprev = &m_next;
+        Head = this;
+        m_pprev = &Head;
+    }
+
+    Callback m_callback;
+    WheelTimer* m_next { nullptr };
+    /* 指向前一个节点的 m_next 或槽位头指针，为空表示未布防 */
+    WheelTimer** m_pprev { nullptr };
+    uint64_t m_expiry { 0 };
+};
+
+/**
+ * @brief 分层时间轮，以粗粒度的时钟刻度管理大量定时器
+ * 结构与 Linux 早期的 timer wheel 相同：第 0 层 256 个槽位每槽一个刻度，其上三层各 64 个槽位，
+ * 每层一个槽位覆盖下一层一整圈。定时器按到期距离放入对应层级，低层转完一圈时把上一层当前槽位的
+ * 定时器重新分配到下层（cascade）。布防、重新布防、取消都是 O(1)，每个定时器在到期前最多被搬移三次。
+ * 超出最大跨度（2^26 个刻度）的定时器放在最高层末尾，转到时再重新分配。
+ * 时间只由 advance 推动，不读取时钟；不是线程安全的，只应在所属事件循环线程上使用。
+ */
+class TimerWheel
+{
+public:
+    static constexpr int ROOT_BITS = 8;
+    static constexpr int LEVEL_BITS = 6;
+    static constexpr int UPPER_LEVELS = 3;
+    static constexpr uint64_t MAX_TICKS = (uint64_t(1) << (ROOT_BITS + UPPER_LEVELS * LEVEL_BITS)) - 1;
+
+    explicit TimerWheel(uint64_t Now = 0)
+            : m_current(Now)
+    {
+    }
+    TimerWheel(const TimerWheel&) = delete;
+    const TimerWheel& operator=(const TimerWheel&) = delete;
+
+    /**
+     * @brief 已处理到的时钟刻度
+     */
+    uint64_t now() const { return m_current; }
+
+    /**
+     * @brief 在 Ticks 个刻度后到期，已布防的定时器先从原位置摘除；Ticks 为 0 时按 1 处理
+     */
+    void arm(WheelTimer& Timer, uint64_t Ticks)
+    {
+        Timer.unlink();
+        Timer.m_expiry = m_current + (Ticks == 0 ? 1 : Ticks);
+        insert(Timer);
+    }
+
+    void cancel(WheelTimer& Timer) { Timer.unlink(); }
+
+    /**
+     * @brief 推进到刻度 Now 并依次调用到期定时器的回调，返回到期个数
+     */
+    size_t advance(uint64_t Now);
+
+private:
+    static constexpr size_t ROOT_SIZE = size_t(1) << ROOT_BITS;
+    static constexpr size_t LEVEL_SIZE = size_t(1) << LEVEL_BITS;
+    static constexpr uint64_t ROOT_MASK = ROOT_SIZE - 1;
+    static constexpr uint64_t LEVEL_MASK = LEVEL_SIZE - 1;
+
+    static size_t levelIndex(uint64_t Tick, int Level)
+    {
+        return static_cast<size_t>((Tick >> (ROOT_BITS + Level * LEVEL_BITS)) & LEVEL_MASK);
+    }
+
+    void insert(WheelTimer& Timer);
+
+    /**
+     * @brief 把上层 Level 的 Index 号槽位重新分配到下层，返回 Index，为 0 时表示该层也转完了一圈
+     */
+    size_t cascade(int Level, size_t Index);
+
+    WheelTimer* m_root[ROOT_SIZE] {};
+    WheelTimer* m_levels[UPPER_LEVELS][LEVEL_SIZE] {};
+    uint64_t m_current;
+};
+
+inline void TimerWheel::insert(WheelTimer& Timer)
+{
+    /* 下一个要处理的刻度是 m_current + 1，arm 保证 expiry 不早于它 */
+    const uint64_t next = m_current + 1;
+    const uint64_t expiry = Timer.m_expiry;
+    const uint64_t delta = expiry - next;
+    if (delta < ROOT_SIZE)
+    {
+        Timer.linkTo(m_root[expiry & ROOT_MASK]);
+        return;
+    }
+    for (int level = 0; level < UPPER_LEVELS; level++)
+    {
+        if (delta < (uint64_t(1) << (ROOT_BITS + (level + 1) * LEVEL_BITS)))
+        {
+            Timer.linkTo(m_levels[level][levelIndex(expiry, level)]);
+            return;
+        }
+    }
+    /* 超出跨度的定时器放进最高层最远的槽位，转到时再按剩余距离重新分配 */
+    Timer.linkTo(m_levels[UPPER_LEVELS - 1][levelIndex(next + MAX_TICKS, UPPER_LEVELS - 1)]);
+}
+
+inline size_t TimerWheel::cascade(int Level, size_t Index)
+{
+    WheelTimer* list = m_levels[Level][Index];
+    m_levels[Level][Index] = nullptr;
+    while (list != nullptr)
+    {
+        WheelTimer* timer = list;
+        list = timer->m_next;
+        timer->m_next = nullptr;
+        timer->m_pprev = nullptr;
+        insert(*timer);
+    }
+    return Index;
+}
+
+inline size_t TimerWheel::advance(uint64_t Now)
+{
+    size_t expired = 0;
+    while (m_current < Now)
+    {
+        const uint64_t tick = m_current + 1;
+        const size_t index = static_cast<size_t>(tick & ROOT_MASK);
+        /* 第 0 层转完一圈，逐层把上一层当前槽位分配下来，直到某层没有转完一圈为止 */
+        if (index == 0)
+        {
+            for (int level = 0; level < UPPER_LEVELS && cascade(level, levelIndex(tick, level)) == 0; level++)
+                ;
+        }
+        m_current = tick;
+
+        /* 先把整个槽位摘到局部链表上，回调中取消的其他定时器会从这里摘除，新布防的定时器不会落到这里 */
+        WheelTimer* pending = m_root[index];
+        m_root[index] = nullptr;
+        if (pending != nullptr)
+            pending->m_pprev = &pending;
+        while (pending != nullptr)
+        {
+            WheelTimer* timer = pending;
+            timer->unlink();
+            expired++;
+            if (timer->m_callback)
+                timer->m_callback();
+        }
+    }
+    return expired;
+}
+}   // namespace ToolKit
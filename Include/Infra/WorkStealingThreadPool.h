@@ -0,0 +1,382 @@
+#pragma once
+
+#include "Infra/ChaseLevDeque.h"
+#include "Infra/CpuAffinity.h"
+#include "Infra/SmallTask.h"
+#include "Infra/TaskRing.h"
+#include "Infra/ThreadPool.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+namespace ToolKit
+{
+/**
+ * @brief 工作窃取线程池，enqueue 接口与 ThreadPool 一致，可直接替换
+ * 每个工作线程持有一个 Chase–Lev 双端队列：工作线程内提交的任务压入自己队列的底部并以 LIFO 取出，
+ * 空闲时随机挑选其他线程从顶部窃取。外部线程提交的任务轮询分散到各工作线程的收件箱，
+ * 每个收件箱各有一把只保护一次 push 的锁，多个生产者之间不再争用同一把锁。
+ * 找不到任务的线程短暂自旋后在条件变量上休眠，提交方只在存在休眠线程时才去加锁唤醒。
+ * 双端队列中的任务节点执行后归还给分配它的工作线程：本线程执行的直接放回空闲链表，
+ * 被窃取的通过无锁栈送回；收件箱是只增不减的环形队列，稳定运行后 post 不再分配堆内存。
+ */
+class WorkStealingThreadPool
+{
+public:
+    /**
+     * @brief 启动 Threads 个工作线程，Cpus 不为空时工作线程都限定在这组 CPU 上运行，各线程的队列分配在第一个 CPU 所在的节点
+     */
+    WorkStealingThreadPool(size_t Threads, const std::vector<int>& Cpus = {});
+    template <class F, class... Args>
+    auto enqueue(F&& Func, Args&&... ParamArgs) -> std::future<typename std::result_of<F(Args...)>::type>;
+
+    /**
+     * @brief 提交不需要结果的任务，不创建 future
+     */
+    template <class F, class... Args>
+    void post(F&& Func, Args&&... ParamArgs);
+
+    /**
+     * @brief 一次性提交 [First, Last) 中的全部可调用对象，外部线程只加一次收件箱锁，元素会被移走
+     */
+    template <class Iterator>
+    void enqueueBulk(Iterator First, Iterator Last);
+
+    ~WorkStealingThreadPool();
+
+private:
+    struct Worker;
+
+    struct TaskNode
+    {
+        SmallTask m_task;
+        TaskNode* m_next { nullptr };
+        Worker* m_owner { nullptr };
+    };
+
+    struct Worker
+    {
+        Worker();
+        ~Worker();
+        /* 只能由所属工作线程调用 */
+        TaskNode* allocNode(SmallTask&& Task);
+        /* 由执行完节点的工作线程调用 */
+        void freeNode(TaskNode* Node);
+
+        ChaseLevDeque<TaskNode> m_deque;
+        std::mutex m_inboxMutex;
+        TaskRing m_inbox;
+        /* 收件箱非空的提示，避免窃取时对空收件箱加锁 */
+        std::atomic<bool> m_inboxReady { false };
+        /* 空闲链表只由所属工作线程访问 */
+        TaskNode* m_freeNodes { nullptr };
+        /* 其他线程执行完的节点压入该栈，所属线程整体取走，不存在 ABA 问题 */
+        std::atomic<TaskNode*> m_remoteFreeNodes { nullptr };
+    };
+
+    static constexpr int SPIN_ROUNDS = 64;
+    /* 每次从收件箱最多取出的任务数，其余留给其他线程，也限制了同时在途的任务节点数 */
+    static constexpr size_t INBOX_BATCH = 32;
+    /* 预先为每个工作线程准备的任务节点数，覆盖一批收件箱任务加上被窃取后尚未归还的节点 */
+    static constexpr size_t PREALLOCATED_NODES = 2 * INBOX_BATCH;
+
+    void checkRunning(const char* Operation) const;
+    void submit(SmallTask&& Task);
+    void notify(bool All = false);
+    void workerLoop(size_t Index);
+    TaskNode* findTask(size_t Index, uint32_t& Seed);
+    TaskNode* takeInbox(Worker& Owner, Worker& From);
+    bool hasWork() const;
+
+    /* 当前线程所属的线程池与工作线程序号，外部线程为 nullptr */
+    static inline thread_local WorkStealingThreadPool* m_currentPool { nullptr };
+    static inline thread_local size_t m_currentIndex { 0 };
+
+    std::vector<std::unique_ptr<Worker>> m_queues;
+    std::vector<std::thread> m_workers;
+    std::atomic<size_t> m_nextInbox { 0 };
+
+    // parking
+    std::mutex m_parkMutex;
+    std::condition_variable m_condition;
+    std::atomic<int> m_sleepers { 0 };
+    std::atomic<uint64_t> m_epoch { 0 };
+    std::atomic<bool> m_stop { false };
+};
+
+inline WorkStealingThreadPool::WorkStealingThreadPool(size_t Threads, const std::vector<int>& Cpus)
+{
+    if (Threads == 0)
+        Threads = 1;
+    {
+        MemoryNodeScope nodeScope(Cpus.empty() ? -1 : cpuNode(Cpus.front()));
+        for (size_t i = 0; i < Threads; ++i)
+            m_queues.emplace_back(new Worker {});
+    }
+    for (size_t i = 0; i < Threads; ++i)
+    {
+        m_workers.emplace_back([this, i] { workerLoop(i); });
+        setThreadAffinity(m_workers.back().native_handle(), Cpus);
+    }
+}
+
+template <class F, class... Args>
+auto WorkStealingThreadPool::enqueue(F&& Func, Args&&... ParamArgs) -> std::future<typename std::result_of<F(Args...)>::type>
+{
+    using return_type = typename std::result_of<F(Args...)>::type;
+
+    std::packaged_task<return_type()> task(std::bind(std::forward<F>(Func), std::forward<Args>(ParamArgs)...));
+
+    std::future<return_type> res = task.get_future();
+    checkRunning("enqueue");
+    submit(SmallTask(std::move(task)));
+    return res;
+}
+
+template <class F, class... Args>
+void WorkStealingThreadPool::post(F&& Func, Args&&... ParamArgs)
+{
+    checkRunning("post");
+    submit(makeTask(std::forward<F>(Func), std::forward<Args>(ParamArgs)...));
+}
+
+template <class Iterator>
+void WorkStealingThreadPool::enqueueBulk(Iterator First, Iterator Last)
+{
+    checkRunning("enqueueBulk");
+    if (m_currentPool == this)
+    {
+        auto& self = *m_queues[m_currentIndex];
+        for (; First != Last; ++First)
+            self.m_deque.push(self.allocNode(SmallTask(std::move(*First))));
+    }
+    else
+    {
+        auto& worker = *m_queues[m_nextInbox.fetch_add(1, std::memory_order_relaxed) % m_queues.size()];
+        std::lock_guard<std::mutex> lock(worker.m_inboxMutex);
+        for (; First != Last; ++First)
+            worker.m_inbox.push(SmallTask(std::move(*First)));
+        worker.m_inboxReady.store(true, std::memory_order_relaxed);
+    }
+    notify(true);
+}
+
+inline void WorkStealingThreadPool::checkRunning(const char* Operation) const
+{
+    // don't allow enqueueing after stopping the pool, tasks spawned by running tasks are still accepted
+    if (m_stop.load(std::memory_order_relaxed) && m_currentPool != this)
+        throw std::runtime_error(std::string(Operation) + " on stopped WorkStealingThreadPool");
+}
+
+inline WorkStealingThreadPool::Worker::Worker()
+{
+    for (size_t i = 0; i < PREALLOCATED_NODES; i++)
+    {
+        auto* node = new TaskNode {};
+        node->m_owner = this;
+        node->m_next = m_freeNodes;
+        m_freeNodes = node;
+    }
+}
+
+inline WorkStealingThreadPool::Worker::~Worker()
+{
+    for (TaskNode* list : { m_freeNodes, m_remoteFreeNodes.load() })
+    {
+        while (list != nullptr)
+        {
+            TaskNode* next = list->m_next;
+            delete list;
+            list = next;
+        }
+    }
+}
+
+inline WorkStealingThreadPool::TaskNode* WorkStealingThreadPool::Worker::allocNode(SmallTask&& Task)
+{
+    if (m_freeNodes == nullptr)
+        m_freeNodes = m_remoteFreeNodes.exchange(nullptr, std::memory_order_acquire);
+    TaskNode* node = m_freeNodes;
+    if (node != nullptr)
+    {
+        m_freeNodes = node->m_next;
+    }
+    else
+    {
+        node = new TaskNode {};
+        node->m_owner = this;
+    }
+    node->m_task = std::move(Task);
+    return node;
+}
+
+inline void WorkStealingThreadPool::Worker::freeNode(TaskNode* Node)
+{
+    Node->m_task.reset();
+    Worker* owner = Node->m_owner;
+    if (owner == this)
+    {
+        Node->m_next = m_freeNodes;
+        m_freeNodes = Node;
+        return;
+    }
+    Node->m_next = owner->m_remoteFreeNodes.load(std::memory_order_relaxed);
+    while (!owner->m_remoteFreeNodes.compare_exchange_weak(
+        Node->m_next, Node, std::memory_order_release, std::memory_order_relaxed))
+        ;
+}
+
+inline void WorkStealingThreadPool::submit(SmallTask&& Task)
+{
+    if (m_currentPool == this)
+    {
+        auto& self = *m_queues[m_currentIndex];
+        self.m_deque.push(self.allocNode(std::move(Task)));
+    }
+    else
+    {
+        auto& worker = *m_queues[m_nextInbox.fetch_add(1, std::memory_order_relaxed) % m_queues.size()];
+        std::lock_guard<std::mutex> lock(worker.m_inboxMutex);
+        worker.m_inbox.push(std::move(Task));
+        worker.m_inboxReady.store(true, std::memory_order_relaxed);
+    }
+    notify();
+}
+
+inline void WorkStealingThreadPool::notify(bool All)
+{
+    /* 与 workerLoop 中 m_sleepers 自增后的复查配对：要么这里看到休眠者，要么休眠者复查时看到新任务 */
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_sleepers.load(std::memory_order_relaxed) == 0)
+        return;
+    m_epoch.fetch_add(1, std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(m_parkMutex);
+    if (All)
+        m_condition.notify_all();
+    else
+        m_condition.notify_one();
+}
+
+inline WorkStealingThreadPool::TaskNode* WorkStealingThreadPool::takeInbox(Worker& Owner, Worker& From)
+{
+    if (!From.m_inboxReady.load(std::memory_order_relaxed))
+        return nullptr;
+    TaskNode* batch[INBOX_BATCH];
+    size_t count = 0;
+    {
+        std::lock_guard<std::mutex> lock(From.m_inboxMutex);
+        while (count < INBOX_BATCH && !From.m_inbox.empty())
+            batch[count++] = Owner.allocNode(From.m_inbox.pop());
+        From.m_inboxReady.store(!From.m_inbox.empty(), std::memory_order_relaxed);
+    }
+    if (count == 0)
+        return nullptr;
+    /* 第一个任务立即执行，其余转入自己的双端队列供其他线程窃取 */
+    for (size_t i = count - 1; i > 0; i--)
+        Owner.m_deque.push(batch[i]);
+    return batch[0];
+}
+
+inline WorkStealingThreadPool::TaskNode* WorkStealingThreadPool::findTask(size_t Index, uint32_t& Seed)
+{
+    auto& self = *m_queues[Index];
+    if (TaskNode* task = self.m_deque.pop())
+        return task;
+    if (TaskNode* task = takeInbox(self, self))
+        return task;
+
+    size_t count = m_queues.size();
+    /* xorshift 随机选择起始受害者，再依次遍历其余线程 */
+    Seed ^= Seed << 13;
+    Seed ^= Seed >> 17;
+    Seed ^= Seed << 5;
+    size_t start = Seed % count;
+    for (size_t i = 0; i < count; i++)
+    {
+        size_t victim = (start + i) % count;
+        if (victim == Index)
+            continue;
+        if (TaskNode* task = m_queues[victim]->m_deque.steal())
+            return task;
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        size_t victim = (start + i) % count;
+        if (victim == Index)
+            continue;
+        if (TaskNode* task = takeInbox(self, *m_queues[victim]))
+            return task;
+    }
+    return nullptr;
+}
+
+inline bool WorkStealingThreadPool::hasWork() const
+{
+    for (auto& worker : m_queues)
+        if (!worker->m_deque.empty() || worker->m_inboxReady.load(std::memory_order_relaxed))
+            return true;
+    return false;
+}
+
+inline void WorkStealingThreadPool::workerLoop(size_t Index)
+{
+    m_currentPool = this;
+    m_currentIndex = Index;
+    uint32_t seed = static_cast<uint32_t>(Index) * 2654435761u + 1;
+    for (;;)
+    {
+        TaskNode* task = nullptr;
+        for (int spin = 0; spin < SPIN_ROUNDS && task == nullptr; spin++)
+        {
+            task = findTask(Index, seed);
+            if (task == nullptr)
+                std::this_thread::yield();
+        }
+        if (task != nullptr)
+        {
+            task->m_task();
+            m_queues[Index]->freeNode(task);
+            continue;
+        }
+
+        uint64_t epoch = m_epoch.load(std::memory_order_relaxed);
+        m_sleepers.fetch_add(1, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (hasWork())
+        {
+            m_sleepers.fetch_sub(1, std::memory_order_relaxed);
+            continue;
+        }
+        if (m_stop.load())
+        {
+            m_sleepers.fetch_sub(1, std::memory_order_relaxed);
+            return;
+        }
+        {
+            std::unique_lock<std::mutex> lock(m_parkMutex);
+            m_condition.wait(lock, [this, epoch] { return m_stop.load() || m_epoch.load(std::memory_order_relaxed) != epoch; });
+        }
+        m_sleepers.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+// the destructor runs the remaining tasks and joins all threads
+inline WorkStealingThreadPool::~WorkStealingThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_parkMutex);
+        m_stop = true;
+    }
+    m_condition.notify_all();
+    for (std::thread& worker : m_workers)
+        worker.join();
+}
+}   // namespace ToolKit
@@ -0,0 +1,487 @@
+#include "ByteScanner.h"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define TOOLKIT_SCAN_X86 1
+#endif
+
+namespace
+{
+using CharTable = std::array<bool, 256>;
+
+/* RFC 9110 tchar */
+constexpr CharTable TOKEN_TABLE = []
+{
+    CharTable table {};
+    for (int c = '0'; c <= '9'; c++)
+        table[c] = true;
+    for (int c = 'a'; c <= 'z'; c++)
+        table[c] = true;
+    for (int c = 'A'; c <= 'Z'; c++)
+        table[c] = true;
+    for (char c : std::string_view("!#$%&'*+-.^_`|~"))
+        table[static_cast<unsigned char>(c)] = true;
+    return table;
+}();
+
+/* field-vchar / obs-text / HTAB / SP */
+constexpr CharTable FIELD_VALUE_TABLE = []
+{
+    CharTable table {};
+    for (int c = 0; c < 256; c++)
+        table[c] = (c >= 0x20 && c != 0x7f) || c == '\t';
+    return table;
+}();
+
+/* 不含空格与控制字符的可见字符 */
+constexpr CharTable VISIBLE_TABLE = []
+{
+    CharTable table {};
+    for (int c = 0; c < 256; c++)
+        table[c] = c > 0x20 && c != 0x7f;
+    return table;
+}();
+
+inline size_t runLength(const CharTable& Table, const char* Data, size_t Len)
+{
+    size_t i = 0;
+    while (i < Len && Table[static_cast<unsigned char>(Data[i])])
+        i++;
+    return i;
+}
+
+struct ScanKernels
+{
+    ptrdiff_t (*m_headTerminator)(const char*, size_t);
+    size_t (*m_tokenLength)(const char*, size_t);
+    size_t (*m_fieldValueLength)(const char*, size_t);
+    size_t (*m_visibleLength)(const char*, size_t);
+    void (*m_mask)(char*, size_t, uint32_t);
+};
+
+ptrdiff_t headTerminatorScalar(const char* Data, size_t Len)
+{
+    const char* cur = Data;
+    const char* end = Data + Len;
+    while (cur < end)
+    {
+        auto* lf = static_cast<const char*>(memchr(cur, '\n', static_cast<size_t>(end - cur)));
+        if (lf == nullptr)
+            return -1;
+        if (lf - Data >= 3 && lf[-1] == '\r' && lf[-2] == '\n' && lf[-3] == '\r')
+            return lf - Data + 1;
+        cur = lf + 1;
+    }
+    return -1;
+}
+
+size_t tokenLengthScalar(const char* Data, size_t Len)
+{
+    return runLength(TOKEN_TABLE, Data, Len);
+}
+
+size_t fieldValueLengthScalar(const char* Data, size_t Len)
+{
+    return runLength(FIELD_VALUE_TABLE, Data, Len);
+}
+
+size_t visibleLengthScalar(const char* Data, size_t Len)
+{
+    return runLength(VISIBLE_TABLE, Data, Len);
+}
+
+/* 按 8 字节一组异或，掩码周期 4 整除 8，组内不需要轮转 */
+void maskScalar(char* Data, size_t Len, uint32_t Key)
+{
+    uint64_t key64;
+    memcpy(&key64, &Key, 4);
+    memcpy(reinterpret_cast<char*>(&key64) + 4, &Key, 4);
+    size_t i = 0;
+    for (; i + 8 <= Len; i += 8)
+    {
+        uint64_t block;
+        memcpy(&block, Data + i, 8);
+        block ^= key64;
+        memcpy(Data + i, &block, 8);
+    }
+    const auto* key = reinterpret_cast<const unsigned char*>(&Key);
+    for (; i < Len; i++)
+        Data[i] = static_cast<char>(Data[i] ^ key[i & 3]);
+}
+
+constexpr ScanKernels SCALAR_KERNELS { headTerminatorScalar, tokenLengthScalar, fieldValueLengthScalar, visibleLengthScalar,
+    maskScalar };
+
+#ifdef TOOLKIT_SCAN_X86
+/**
+ * @brief 在 "\r" 与 "\n" 的位掩码上匹配 "\r\n\r\n"
+ * 每个块的掩码左移 3 位后拼上上一块的最高 3 位，这样跨越块边界的结束符也能在一次位运算中找到
+ *
+ * @return int 结束符最后一个 '\n' 在本块内的位置，未找到返回 -1
+ */
+inline int matchTerminator(uint64_t Cr, uint64_t Lf, uint64_t PrevCr, uint64_t PrevLf)
+{
+    uint64_t c = (Cr << 3) | PrevCr;
+    uint64_t l = (Lf << 3) | PrevLf;
+    uint64_t hits = l & (c << 1) & (l << 2) & (c << 3) & ~uint64_t { 7 };
+    return hits == 0 ? -1 : __builtin_ctzll(hits) - 3;
+}
+
+ptrdiff_t finishTerminatorScalar(const char* Data, size_t Len, size_t Scanned)
+{
+    size_t start = Scanned >= 3 ? Scanned - 3 : 0;
+    ptrdiff_t hit = headTerminatorScalar(Data + start, Len - start);
+    return hit < 0 ? -1 : static_cast<ptrdiff_t>(start) + hit;
+}
+
+/* pcmpestri 的区间表，命中区间即停止 */
+alignas(16) constexpr char TOKEN_STOP_RANGES[16] = { '\x00', ' ', '"', '"', '(', ')', ',', ',', '/', '/', ':', '@', '[', ']',
+    '{', '\xff' };
+alignas(16) constexpr char FIELD_VALUE_STOP_RANGES[16] = { '\x00', '\x08', '\x0a', '\x1f', '\x7f', '\x7f' };
+alignas(16) constexpr char VISIBLE_STOP_RANGES[16] = { '\x00', ' ', '\x7f', '\x7f' };
+
+__attribute__((target("sse4.2"))) ptrdiff_t headTerminatorSse42(const char* Data, size_t Len)
+{
+    const __m128i cr = _mm_set1_epi8('\r');
+    const __m128i lf = _mm_set1_epi8('\n');
+    uint64_t prevCr = 0;
+    uint64_t prevLf = 0;
+    size_t i = 0;
+    for (; i + 16 <= Len; i += 16)
+    {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Data + i));
+        auto crMask = static_cast<uint64_t>(static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, cr))));
+        auto lfMask = static_cast<uint64_t>(static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, lf))));
+        if (lfMask != 0)
+        {
+            int hit = matchTerminator(crMask, lfMask, prevCr, prevLf);
+            if (hit >= 0)
+                return static_cast<ptrdiff_t>(i) + hit + 1;
+        }
+        prevCr = crMask >> 13;
+        prevLf = lfMask >> 13;
+    }
+    return finishTerminatorScalar(Data, Len, i);
+}
+
+/**
+ * @brief 以 16 字节为单位查找第一个落在 Ranges 区间内的字节
+ *
+ * @return bool 是否命中，未命中时 Pos 为剩余不足 16 字节的尾部起点
+ */
+template <int RangesLen>
+__attribute__((target("sse4.2"))) inline bool rangeStopSse42(const char* Ranges, const char* Data, size_t Len, size_t& Pos)
+{
+    const __m128i ranges = _mm_load_si128(reinterpret_cast<const __m128i*>(Ranges));
+    size_t i = 0;
+    for (; i + 16 <= Len; i += 16)
+    {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Data + i));
+        int index = _mm_cmpestri(ranges, RangesLen, block, 16, _SIDD_UBYTE_OPS | _SIDD_CMP_RANGES | _SIDD_LEAST_SIGNIFICANT);
+        if (index != 16)
+        {
+            Pos = i + static_cast<size_t>(index);
+            return true;
+        }
+    }
+    Pos = i;
+    return false;
+}
+
+__attribute__((target("sse4.2"))) size_t tokenLengthSse42(const char* Data, size_t Len)
+{
+    size_t i = 0;
+    for (;;)
+    {
+        size_t stop = 0;
+        if (!rangeStopSse42<16>(TOKEN_STOP_RANGES, Data + i, Len - i, stop))
+        {
+            i += stop;
+            return i + tokenLengthScalar(Data + i, Len - i);
+        }
+        i += stop;
+        /* 区间表只有 8 组，'|' '~' 被并入了停止区间，需要查表确认 */
+        if (!TOKEN_TABLE[static_cast<unsigned char>(Data[i])])
+            return i;
+        i++;
+    }
+}
+
+__attribute__((target("sse4.2"))) size_t fieldValueLengthSse42(const char* Data, size_t Len)
+{
+    size_t i = 0;
+    if (rangeStopSse42<6>(FIELD_VALUE_STOP_RANGES, Data, Len, i))
+        return i;
+    return i + fieldValueLengthScalar(Data + i, Len - i);
+}
+
+__attribute__((target("sse4.2"))) size_t visibleLengthSse42(const char* Data, size_t Len)
+{
+    size_t i = 0;
+    if (rangeStopSse42<4>(VISIBLE_STOP_RANGES, Data, Len, i))
+        return i;
+    return i + visibleLengthScalar(Data + i, Len - i);
+}
+
+/**
+ * @brief vpshufb 半字节查表：低 4 位选出允许的高半字节位图，高 4 位选出对应的位，两者相与非零即属于集合
+ */
+struct NibbleLut
+{
+    alignas(16) uint8_t m_low[16];
+    alignas(16) uint8_t m_high[16];
+};
+
+constexpr NibbleLut makeNibbleLut(const CharTable& Table)
+{
+    NibbleLut lut {};
+    for (int low = 0; low < 16; low++)
+    {
+        for (int high = 0; high < 8; high++)
+        {
+            if (Table[static_cast<size_t>(high << 4 | low)])
+                lut.m_low[low] |= static_cast<uint8_t>(1 << high);
+        }
+    }
+    for (int high = 0; high < 8; high++)
+        lut.m_high[high] = static_cast<uint8_t>(1 << high);
+    return lut;
+}
+
+constexpr NibbleLut TOKEN_LUT = makeNibbleLut(TOKEN_TABLE);
+
+__attribute__((target("avx2"))) ptrdiff_t headTerminatorAvx2(const char* Data, size_t Len)
+{
+    const __m256i cr = _mm256_set1_epi8('\r');
+    const __m256i lf = _mm256_set1_epi8('\n');
+    uint64_t prevCr = 0;
+    uint64_t prevLf = 0;
+    size_t i = 0;
+    for (; i + 32 <= Len; i += 32)
+    {
+        __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(Data + i));
+        auto crMask = static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, cr))));
+        auto lfMask = static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, lf))));
+        /* 块内没有 '\n' 时不可能有结束符落在本块 */
+        if (lfMask != 0)
+        {
+            int hit = matchTerminator(crMask, lfMask, prevCr, prevLf);
+            if (hit >= 0)
+                return static_cast<ptrdiff_t>(i) + hit + 1;
+        }
+        prevCr = crMask >> 29;
+        prevLf = lfMask >> 29;
+    }
+    return finishTerminatorScalar(Data, Len, i);
+}
+
+__attribute__((target("avx2"))) size_t tokenLengthAvx2(const char* Data, size_t Len)
+{
+    const __m256i lutLow = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(TOKEN_LUT.m_low)));
+    const __m256i lutHigh = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(TOKEN_LUT.m_high)));
+    const __m256i nibble = _mm256_set1_epi8(0x0f);
+    const __m256i zero = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 32 <= Len; i += 32)
+    {
+        __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(Data + i));
+        __m256i low = _mm256_and_si256(block, nibble);
+        __m256i high = _mm256_and_si256(_mm256_srli_epi16(block, 4), nibble);
+        __m256i bits = _mm256_and_si256(_mm256_shuffle_epi8(lutLow, low), _mm256_shuffle_epi8(lutHigh, high));
+        auto stop = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(bits, zero)));
+        if (stop != 0)
+            return i + static_cast<size_t>(__builtin_ctz(stop));
+    }
+    return i + tokenLengthScalar(Data + i, Len - i);
+}
+
+__attribute__((target("avx2"))) size_t fieldValueLengthAvx2(const char* Data, size_t Len)
+{
+    const __m256i space = _mm256_set1_epi8(0x20);
+    const __m256i tab = _mm256_set1_epi8('\t');
+    const __m256i del = _mm256_set1_epi8(0x7f);
+    size_t i = 0;
+    for (; i + 32 <= Len; i += 32)
+    {
+        __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(Data + i));
+        /* max(c, 0x20) == c 即 c >= 0x20（无符号比较） */
+        __m256i printable = _mm256_cmpeq_epi8(_mm256_max_epu8(block, space), block);
+        __m256i allowed = _mm256_andnot_si256(_mm256_cmpeq_epi8(block, del), _mm256_or_si256(printable, _mm256_cmpeq_epi8(block, tab)));
+        auto stop = ~static_cast<uint32_t>(_mm256_movemask_epi8(allowed));
+        if (stop != 0)
+            return i + static_cast<size_t>(__builtin_ctz(stop));
+    }
+    return i + fieldValueLengthScalar(Data + i, Len - i);
+}
+
+__attribute__((target("avx2"))) size_t visibleLengthAvx2(const char* Data, size_t Len)
+{
+    const __m256i space = _mm256_set1_epi8(0x20);
+    const __m256i del = _mm256_set1_epi8(0x7f);
+    size_t i = 0;
+    for (; i + 32 <= Len; i += 32)
+    {
+        __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(Data + i));
+        /* min(c, 0x20) == c 即 c <= 0x20（无符号比较） */
+        __m256i stopBytes = _mm256_or_si256(_mm256_cmpeq_epi8(_mm256_min_epu8(block, space), block), _mm256_cmpeq_epi8(block, del));
+        auto stop = static_cast<uint32_t>(_mm256_movemask_epi8(stopBytes));
+        if (stop != 0)
+            return i + static_cast<size_t>(__builtin_ctz(stop));
+    }
+    return i + visibleLengthScalar(Data + i, Len - i);
+}
+
+/* 掩码只需要 SSE2，归入 SSE4.2 级别；每轮处理 64 字节，减少循环开销 */
+__attribute__((target("sse2"))) void maskSse2(char* Data, size_t Len, uint32_t Key)
+{
+    const __m128i key = _mm_set1_epi32(static_cast<int>(Key));
+    size_t i = 0;
+    for (; i + 64 <= Len; i += 64)
+    {
+        auto* p = reinterpret_cast<__m128i*>(Data + i);
+        _mm_storeu_si128(p, _mm_xor_si128(_mm_loadu_si128(p), key));
+        _mm_storeu_si128(p + 1, _mm_xor_si128(_mm_loadu_si128(p + 1), key));
+        _mm_storeu_si128(p + 2, _mm_xor_si128(_mm_loadu_si128(p + 2), key));
+        _mm_storeu_si128(p + 3, _mm_xor_si128(_mm_loadu_si128(p + 3), key));
+    }
+    for (; i + 16 <= Len; i += 16)
+    {
+        auto* p = reinterpret_cast<__m128i*>(Data + i);
+        _mm_storeu_si128(p, _mm_xor_si128(_mm_loadu_si128(p), key));
+    }
+    maskScalar(Data + i, Len - i, Key);
+}
+
+__attribute__((target("avx2"))) void maskAvx2(char* Data, size_t Len, uint32_t Key)
+{
+    const __m256i key = _mm256_set1_epi32(static_cast<int>(Key));
+    size_t i = 0;
+    for (; i + 128 <= Len; i += 128)
+    {
+        auto* p = reinterpret_cast<__m256i*>(Data + i);
+        _mm256_storeu_si256(p, _mm256_xor_si256(_mm256_loadu_si256(p), key));
+        _mm256_storeu_si256(p + 1, _mm256_xor_si256(_mm256_loadu_si256(p + 1), key));
+        _mm256_storeu_si256(p + 2, _mm256_xor_si256(_mm256_loadu_si256(p + 2), key));
+        _mm256_storeu_si256(p + 3, _mm256_xor_si256(_mm256_loadu_si256(p + 3), key));
+    }
+    for (; i + 32 <= Len; i += 32)
+    {
+        auto* p = reinterpret_cast<__m256i*>(Data + i);
+        _mm256_storeu_si256(p, _mm256_xor_si256(_mm256_loadu_si256(p), key));
+    }
+    /* 尾调用不会自动插入 vzeroupper，带着脏的高位状态执行非 VEX 编码的 SSE 指令代价很高 */
+    _mm256_zeroupper();
+    maskSse2(Data + i, Len - i, Key);
+}
+
+constexpr ScanKernels SSE42_KERNELS { headTerminatorSse42, tokenLengthSse42, fieldValueLengthSse42, visibleLengthSse42,
+    maskSse2 };
+constexpr ScanKernels AVX2_KERNELS { headTerminatorAvx2, tokenLengthAvx2, fieldValueLengthAvx2, visibleLengthAvx2, maskAvx2 };
+#endif
+
+ToolKit::SCAN_LEVEL detectScanLevel()
+{
+#ifdef TOOLKIT_SCAN_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return ToolKit::SCAN_LEVEL::AVX2;
+    if (__builtin_cpu_supports("sse4.2"))
+        return ToolKit::SCAN_LEVEL::SSE42;
+#endif
+    return ToolKit::SCAN_LEVEL::SCALAR;
+}
+
+const ScanKernels* kernelsOf(ToolKit::SCAN_LEVEL Level)
+{
+    switch (Level)
+    {
+#ifdef TOOLKIT_SCAN_X86
+        case ToolKit::SCAN_LEVEL::AVX2:
+            return &AVX2_KERNELS;
+        case ToolKit::SCAN_LEVEL::SSE42:
+            return &SSE42_KERNELS;
+#endif
+        default:
+            return &SCALAR_KERNELS;
+    }
+}
+
+/* 常量初始化为标量实现，保证其它编译单元在静态初始化阶段调用时也是安全的 */
+std::atomic<ToolKit::SCAN_LEVEL> activeLevel { ToolKit::SCAN_LEVEL::SCALAR };
+std::atomic<const ScanKernels*> activeKernels { &SCALAR_KERNELS };
+
+inline const ScanKernels* kernels()
+{
+    return activeKernels.load(std::memory_order_relaxed);
+}
+}   // namespace
+
+namespace ToolKit
+{
+ptrdiff_t scanHeadTerminator(const char* Data, size_t Len)
+{
+    return kernels()->m_headTerminator(Data, Len);
+}
+
+size_t scanTokenLength(const char* Data, size_t Len)
+{
+    return kernels()->m_tokenLength(Data, Len);
+}
+
+size_t scanFieldValueLength(const char* Data, size_t Len)
+{
+    return kernels()->m_fieldValueLength(Data, Len);
+}
+
+size_t scanVisibleLength(const char* Data, size_t Len)
+{
+    return kernels()->m_visibleLength(Data, Len);
+}
+
+void applyMask(char* Data, size_t Len, uint32_t Key)
+{
+    kernels()->m_mask(Data, Len, Key);
+}
+
+SCAN_LEVEL currentScanLevel()
+{
+    return activeLevel.load(std::memory_order_relaxed);
+}
+
+SCAN_LEVEL supportedScanLevel()
+{
+    static const SCAN_LEVEL level = detectScanLevel();
+    return level;
+}
+
+/* 启动时切换到 CPU 支持的最高级别 */
+static const SCAN_LEVEL INITIAL_SCAN_LEVEL = setScanLevel(supportedScanLevel());
+
+SCAN_LEVEL setScanLevel(SCAN_LEVEL Level)
+{
+    if (static_cast<int>(Level) > static_cast<int>(supportedScanLevel()))
+        Level = supportedScanLevel();
+    activeLevel.store(Level, std::memory_order_relaxed);
+    activeKernels.store(kernelsOf(Level), std::memory_order_relaxed);
+    return Level;
+}
+
+const char* scanLevelName(SCAN_LEVEL Level)
+{
+    switch (Level)
+    {
+        case SCAN_LEVEL::AVX2:
+            return "avx2";
+        case SCAN_LEVEL::SSE42:
+            return "sse4.2";
+        default:
+            return "scalar";
+    }
+}
+}   // namespace ToolKit
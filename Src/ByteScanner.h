@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ToolKit
+{
+/**
+ * @brief 字节扫描使用的指令集级别
+ */
+enum class SCAN_LEVEL
+{
+    SCALAR,
+    SSE42,
+    AVX2
+};
+
+/**
+ * @brief 查找 "\r\n\r\n"
+ *
+ * @return ptrdiff_t 结束符之后的偏移，未找到返回 -1
+ */
+ptrdiff_t scanHeadTerminator(const char* Data, size_t Len);
+
+/**
+ * @brief 返回开头连续 tchar 的长度，遇到 ':'、空格等分隔符即停止，用于方法名与首部名
+ */
+size_t scanTokenLength(const char* Data, size_t Len);
+
+/**
+ * @brief 返回开头连续合法首部值字符（HTAB、可见字符、obs-text）的长度，通常停在行尾的 '\r'
+ */
+size_t scanFieldValueLength(const char* Data, size_t Len);
+
+/**
+ * @brief 返回开头连续可见字符（不含空格与控制字符）的长度，用于 request-target
+ */
+size_t scanVisibleLength(const char* Data, size_t Len);
+
+/**
+ * @brief 把 Data 与 4 字节掩码循环异或（WebSocket 的负载掩码），Key 为掩码字节按内存顺序拼成的 32 位值
+ * 从掩码的第 k 个字节开始时，调用者先把 Key 按字节轮转 k 位。
+ */
+void applyMask(char* Data, size_t Len, uint32_t Key);
+
+/**
+ * @brief 当前生效的指令集级别，首次调用时根据 CPU 特性自动选择
+ */
+SCAN_LEVEL currentScanLevel();
+
+/**
+ * @brief 强制使用指定级别（超出 CPU 支持范围时降级到可用的最高级别），供基准测试与单元测试使用
+ *
+ * @return SCAN_LEVEL 实际生效的级别
+ */
+SCAN_LEVEL setScanLevel(SCAN_LEVEL Level);
+
+/**
+ * @brief CPU 支持的最高级别
+ */
+SCAN_LEVEL supportedScanLevel();
+
+const char* scanLevelName(SCAN_LEVEL Level);
+}   // namespace ToolKit
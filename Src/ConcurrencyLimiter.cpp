@@ -0,0 +1,119 @@
+#include "ConcurrencyLimiter.h"
+
+#include "HttpResponse.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+int64_t nanosecondsOf(std::chrono::steady_clock::time_point Time)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Time.time_since_epoch()).count();
+}
+}   // namespace
+
+namespace ToolKit
+{
+ConcurrencyLimiter::ConcurrencyLimiter(ConcurrencyLimiterOptions Options)
+        : m_options([&Options]
+              {
+                  Options.m_maxLimit = std::max<uint32_t>(1, Options.m_maxLimit);
+                  Options.m_minLimit = std::clamp<uint32_t>(Options.m_minLimit, 1, Options.m_maxLimit);
+                  Options.m_initialLimit = std::clamp(Options.m_initialLimit, Options.m_minLimit, Options.m_maxLimit);
+                  Options.m_minSamples = std::max<uint32_t>(1, Options.m_minSamples);
+                  Options.m_baselineWindows = std::max<uint32_t>(1, Options.m_baselineWindows);
+                  Options.m_smoothing = std::clamp(Options.m_smoothing, 0.01, 1.0);
+                  return Options;
+              }())
+        , m_limit(m_options.m_initialLimit)
+        , m_windowStart(nanosecondsOf(std::chrono::steady_clock::now()))
+        , m_estimate(m_options.m_initialLimit)
+{
+}
+
+bool ConcurrencyLimiter::tryAcquire()
+{
+    uint32_t current = m_inflight.load(std::memory_order_relaxed);
+    do
+    {
+        if (current >= m_limit.load(std::memory_order_relaxed))
+        {
+            m_shed.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+    } while (!m_inflight.compare_exchange_weak(current, current + 1, std::memory_order_relaxed));
+    m_admitted.fetch_add(1, std::memory_order_relaxed);
+    /* 峰值只用来判断负载高低，并发更新丢掉个别值不影响结论 */
+    if (current + 1 > m_peakInflight.load(std::memory_order_relaxed))
+        m_peakInflight.store(current + 1, std::memory_order_relaxed);
+    return true;
+}
+
+void ConcurrencyLimiter::release(std::chrono::nanoseconds Latency, std::chrono::steady_clock::time_point Now)
+{
+    m_sampleSum.fetch_add(static_cast<uint64_t>(std::max<int64_t>(0, Latency.count())), std::memory_order_relaxed);
+    const uint32_t count = m_sampleCount.fetch_add(1, std::memory_order_relaxed) + 1;
+    m_inflight.fetch_sub(1, std::memory_order_relaxed);
+    const int64_t now = nanosecondsOf(Now);
+    const int64_t window = std::chrono::duration_cast<std::chrono::nanoseconds>(m_options.m_window).count();
+    if (count < m_options.m_minSamples || now - m_windowStart.load(std::memory_order_relaxed) < window)
+        return;
+    if (m_adjusting.exchange(true, std::memory_order_acquire))
+        return;
+    adjust(now);
+    m_adjusting.store(false, std::memory_order_release);
+}
+
+void ConcurrencyLimiter::adjust(int64_t Now)
+{
+    const uint32_t count = m_sampleCount.exchange(0, std::memory_order_relaxed);
+    const uint64_t sum = m_sampleSum.exchange(0, std::memory_order_relaxed);
+    const uint32_t peak = m_peakInflight.exchange(m_inflight.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    m_windowStart.store(Now, std::memory_order_relaxed);
+    if (count == 0)
+        return;
+    const double latency = std::max(1.0, static_cast<double>(sum) / count);
+    if (m_baseline <= 0)
+    {
+        m_baseline = latency;
+    }
+    else
+    {
+        m_baseline += (latency - m_baseline) / m_options.m_baselineWindows;
+        /* 负载回落后延迟远低于基线，基线加快回落，否则此后很长一段时间都不会收缩 */
+        if (m_baseline > 2 * latency)
+            m_baseline *= 0.95;
+    }
+    m_lastLatency.store(static_cast<int64_t>(latency), std::memory_order_relaxed);
+    m_lastBaseline.store(static_cast<int64_t>(m_baseline), std::memory_order_relaxed);
+    if (peak < m_estimate / 2)
+        return;
+    const double gradient = std::clamp(m_options.m_tolerance * m_baseline / latency, 0.5, 1.0);
+    const double target = m_estimate * gradient + std::sqrt(m_estimate);
+    m_estimate = std::clamp(m_estimate * (1 - m_options.m_smoothing) + target * m_options.m_smoothing,
+        static_cast<double>(m_options.m_minLimit), static_cast<double>(m_options.m_maxLimit));
+    m_limit.store(static_cast<uint32_t>(m_estimate), std::memory_order_relaxed);
+}
+
+ConcurrencyLimiter::Stats ConcurrencyLimiter::stats() const
+{
+    Stats stats;
+    stats.m_admitted = m_admitted.load(std::memory_order_relaxed);
+    stats.m_shed = m_shed.load(std::memory_order_relaxed);
+    stats.m_limit = limit();
+    stats.m_inflight = inflight();
+    stats.m_latency = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::nanoseconds(m_lastLatency.load(std::memory_order_relaxed)));
+    stats.m_baseline = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::nanoseconds(m_lastBaseline.load(std::memory_order_relaxed)));
+    return stats;
+}
+
+void setOverloaded(HttpResponse& Response)
+{
+    Response.clearBody();
+    Response.setStatus(503);
+    Response.addHeader("Retry-After", "1");
+}
+}   // namespace ToolKit
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+
+namespace ToolKit
+{
+class HttpResponse;
+
+struct ConcurrencyLimiterOptions
+{
+    /* 并发上限的调整范围，m_maxLimit 为 0 表示不启用 */
+    uint32_t m_initialLimit { 32 };
+    uint32_t m_minLimit { 4 };
+    uint32_t m_maxLimit { 0 };
+    /* 采样窗口结束且样本数不少于 m_minSamples 时调整一次上限 */
+    std::chrono::milliseconds m_window { 100 };
+    uint32_t m_minSamples { 16 };
+    /* 窗口平均延迟不超过长期基线的 m_tolerance 倍时不收缩 */
+    double m_tolerance { 1.5 };
+    /* 新上限并入当前上限的比例，越小调整越平缓 */
+    double m_smoothing { 0.2 };
+    /* 长期基线以这么多个窗口为周期做指数平均 */
+    uint32_t m_baselineWindows { 100 };
+};
+
+/**
+ * @brief 按处理延迟自适应的并发限制
+ * 交给阻塞线程池的请求先 tryAcquire，未完成的请求数达到上限时立即拒绝（回复 503），不在线程池队列中无限积压；
+ * 完成时 release 带上从获准到执行完毕的延迟，其中包含排队时间，过载首先体现在这里。
+ * 上限按梯度算法调整：窗口平均延迟 short 与长期基线 long 给出梯度 clamp(m_tolerance * long / short, 0.5, 1)，
+ * 新上限为 limit * 梯度 + sqrt(limit)，延迟平稳时以 sqrt(limit) 的余量增长，排队使延迟上升时按比例收缩。
+ * 窗口内未完成请求数的峰值不到上限一半时说明负载本身不高，上限保持不变。
+ * tryAcquire 与 release 只有原子操作；调整由结束窗口的那次 release 完成，同一时刻只有一个线程执行，
+ * 与之并发的少量样本可能被计入下一个窗口。
+ */
+class ConcurrencyLimiter
+{
+public:
+    struct Stats
+    {
+        uint64_t m_admitted { 0 };
+        uint64_t m_shed { 0 };
+        uint32_t m_limit { 0 };
+        uint32_t m_inflight { 0 };
+        /* 最近一个窗口的平均延迟与长期基线 */
+        std::chrono::microseconds m_latency { 0 };
+        std::chrono::microseconds m_baseline { 0 };
+    };
+
+    explicit ConcurrencyLimiter(ConcurrencyLimiterOptions Options);
+    ConcurrencyLimiter(const ConcurrencyLimiter&) = delete;
+    const ConcurrencyLimiter& operator=(const ConcurrencyLimiter&) = delete;
+
+    /**
+     * @brief 未完成的请求数低于上限时占用一个名额并返回 true，否则计入拒绝数并返回 false；可并发调用
+     */
+    bool tryAcquire();
+
+    /**
+     * @brief 归还 tryAcquire 占用的名额并记录这次请求的延迟，可在任意线程调用
+     */
+    void release(std::chrono::nanoseconds Latency, std::chrono::steady_clock::time_point Now = std::chrono::steady_clock::now());
+
+    uint32_t limit() const { return m_limit.load(std::memory_order_relaxed); }
+    uint32_t inflight() const { return m_inflight.load(std::memory_order_relaxed); }
+
+    Stats stats() const;
+
+private:
+    /**
+     * @brief 结束当前窗口并按其样本调整上限，调用时持有 m_adjusting
+     */
+    void adjust(int64_t Now);
+
+    const ConcurrencyLimiterOptions m_options;
+    /* 每个请求都要读写的计数放在独立的缓存行上 */
+    alignas(64) std::atomic<uint32_t> m_inflight { 0 };
+    std::atomic<uint32_t> m_limit;
+    std::atomic<uint32_t> m_peakInflight { 0 };
+    std::atomic<uint64_t> m_admitted { 0 };
+    std::atomic<uint64_t> m_shed { 0 };
+    alignas(64) std::atomic<uint64_t> m_sampleSum { 0 };
+    std::atomic<uint32_t> m_sampleCount { 0 };
+    /* 窗口开始时间，steady_clock 的纳秒数 */
+    std::atomic<int64_t> m_windowStart;
+    std::atomic<bool> m_adjusting { false };
+    /* 只由持有 m_adjusting 的线程读写 */
+    double m_estimate;
+    double m_baseline { 0 };
+    /* 供 stats 读取的最近结果，纳秒 */
+    std::atomic<int64_t> m_lastLatency { 0 };
+    std::atomic<int64_t> m_lastBaseline { 0 };
+};
+
+/**
+ * @brief 协程处理函数的 offload 被并发限制拒绝时抛出，处理函数未捕获时回复 503
+ */
+class OverloadedError : public std::runtime_error
+{
+public:
+    using std::runtime_error::runtime_error;
+};
+
+/**
+ * @brief 把 Response 改为过载拒绝的响应：503 加 Retry-After，不带响应体
+ */
+void setOverloaded(HttpResponse& Response);
+}   // namespace ToolKit
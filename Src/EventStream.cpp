@@ -0,0 +1,84 @@
+#include "EventStream.h"
+
+#include <event2/buffer.h>
+
+namespace
+{
+constexpr std::string_view STREAM_HEAD
+    = "HTTP/1.1 200 OK\r\nCache-Control: no-cache\r\nConnection: close\r\nContent-Type: ";
+}   // namespace
+
+namespace ToolKit
+{
+EventStreamSession::EventStreamSession(const HttpConnectionOptions& Options, const HttpActionNotifier* Notifier)
+        : m_options(Options)
+{
+    m_subscriber.m_notifier = Notifier;
+}
+
+EventStreamSession::~EventStreamSession() = default;
+
+void EventStreamSession::open(
+    std::shared_ptr<const EventStreamHandler> Handler, const HttpRequest& Request, struct evbuffer* Output)
+{
+    m_handler = std::move(Handler);
+    m_open = true;
+    m_subscriber.m_output = Output;
+    m_subscriber.m_format = m_handler->m_format;
+    m_subscriber.m_maxPendingBytes = m_handler->m_maxPendingBytes;
+
+    std::string_view contentType = m_handler->m_contentType;
+    if (contentType.empty())
+        contentType = m_handler->m_format == STREAM_FORMAT::SSE ? "text/event-stream" : "application/octet-stream";
+    evbuffer_add(Output, STREAM_HEAD.data(), STREAM_HEAD.size());
+    evbuffer_add(Output, contentType.data(), contentType.size());
+    evbuffer_add(Output, "\r\n\r\n", 4);
+    if (m_handler->m_onOpen)
+        m_handler->m_onOpen(*this, Request);
+}
+
+void EventStreamSession::reset()
+{
+    if (m_options.m_pubSub != nullptr)
+        m_options.m_pubSub->unsubscribeAll(m_subscriber);
+    if (m_open && m_handler->m_onClose)
+        m_handler->m_onClose(*this);
+    m_handler.reset();
+    m_context.reset();
+    m_subscriber.m_output = nullptr;
+    m_open = false;
+}
+
+CONN_ACTION EventStreamSession::onInput(struct evbuffer* Input, struct evbuffer* Output)
+{
+    evbuffer_drain(Input, evbuffer_get_length(Input));
+    return CONN_ACTION::KEEP_READING;
+}
+
+DEADLINE EventStreamSession::pendingDeadline(struct evbuffer* Input, struct evbuffer* Output) const
+{
+    return evbuffer_get_length(Output) > 0 ? DEADLINE::WRITE : DEADLINE::NONE;
+}
+
+bool EventStreamSession::subscribe(std::string_view Topic)
+{
+    if (m_options.m_pubSub == nullptr || !m_open)
+        return false;
+    m_options.m_pubSub->subscribe(m_subscriber, Topic);
+    return true;
+}
+
+void EventStreamSession::unsubscribe(std::string_view Topic)
+{
+    if (m_options.m_pubSub != nullptr)
+        m_options.m_pubSub->unsubscribe(m_subscriber, Topic);
+}
+
+void EventStreamSession::send(std::string_view Data)
+{
+    if (!m_open)
+        return;
+    auto message = formatStreamMessage(m_handler->m_format, Data);
+    evbuffer_add(m_subscriber.m_output, message.data(), message.size());
+}
+}   // namespace ToolKit
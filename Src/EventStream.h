@@ -0,0 +1,90 @@
+#pragma once
+
+#include "HttpConnection.h"
+#include "PubSub.h"
+
+#include <any>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+
+struct evbuffer;
+
+namespace ToolKit
+{
+class EventStreamSession;
+
+/**
+ * @brief 一个推送流路由，回调都在连接所属的事件循环线程上执行
+ * GET 请求命中路由后回复 200 与流式响应首部（不带长度，Connection: close），连接随后只用于推送：
+ * m_onOpen 中通常根据请求订阅主题，也可以直接 send。m_format 为 SSE 时 Content-Type 默认为 text/event-stream，
+ * 为 RAW 时默认为 application/octet-stream，m_contentType 不为空时以它为准。
+ * m_maxPendingBytes 为 0 时使用 PubSub 的默认积压上限。m_onClose 在连接结束时恰好调用一次。
+ */
+struct EventStreamHandler
+{
+    STREAM_FORMAT m_format { STREAM_FORMAT::SSE };
+    std::string m_contentType;
+    size_t m_maxPendingBytes { 0 };
+    std::function<void(EventStreamSession& Session, const HttpRequest& Request)> m_onOpen;
+    std::function<void(EventStreamSession& Session)> m_onClose;
+};
+
+/**
+ * @brief 一个推送流连接的状态，由 HttpConnection 在回复流式响应首部后接管
+ * 对端之后发来的数据直接丢弃。订阅的消息由 PubSub 在本 Reactor 线程上写入输出缓冲区，
+ * 积压超限被断开时通过 Notifier 关闭连接。有待发送的数据时使用写超时，否则不设超时。
+ */
+class EventStreamSession
+{
+public:
+    EventStreamSession(const HttpConnectionOptions& Options, const HttpActionNotifier* Notifier);
+    ~EventStreamSession();
+    EventStreamSession(const EventStreamSession&) = delete;
+    const EventStreamSession& operator=(const EventStreamSession&) = delete;
+
+    /**
+     * @brief 写出响应首部并调用 m_onOpen，Output 须在会话存续期间有效
+     */
+    void open(std::shared_ptr<const EventStreamHandler> Handler, const HttpRequest& Request, struct evbuffer* Output);
+
+    CONN_ACTION onInput(struct evbuffer* Input, struct evbuffer* Output);
+
+    DEADLINE pendingDeadline(struct evbuffer* Input, struct evbuffer* Output) const;
+
+    /**
+     * @brief 退订全部主题并调用 m_onClose，恢复初始状态以便随连接对象复用
+     */
+    void reset();
+
+    /**
+     * @brief 订阅主题，HttpConnectionOptions 中没有配置 PubSub 时返回 false
+     */
+    bool subscribe(std::string_view Topic);
+    void unsubscribe(std::string_view Topic);
+
+    /**
+     * @brief 按路由的编码直接向本连接发送一条消息
+     */
+    void send(std::string_view Data);
+
+    /**
+     * @brief 因积压超限丢弃的消息数
+     */
+    size_t dropped() const { return m_subscriber.dropped(); }
+
+    /**
+     * @brief 处理函数挂载的连接级数据，随会话复用清空
+     */
+    std::any& context() { return m_context; }
+
+private:
+    const HttpConnectionOptions& m_options;
+    std::shared_ptr<const EventStreamHandler> m_handler;
+    PubSubSubscriber m_subscriber;
+    std::any m_context;
+    bool m_open { false };
+};
+}   // namespace ToolKit
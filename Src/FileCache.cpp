@@ -0,0 +1,253 @@
+#include "FileCache.h"
+
+#include "StaticFileHandler.h"
+#include "spdlog/spdlog.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <event2/buffer.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+/* 目录中文件内容、元数据或目录项的变化，以及目录自身被删除、移动 */
+constexpr uint32_t WATCH_MASK = IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO
+    | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+}   // namespace
+
+namespace ToolKit
+{
+FileCache::FileCache(size_t MaxEntries, size_t Shards)
+        : m_shardCapacity(std::max<size_t>(1, (MaxEntries + std::max<size_t>(1, Shards) - 1) / std::max<size_t>(1, Shards)))
+        , m_shards(std::max<size_t>(1, std::min(Shards, MaxEntries)))
+{
+    if (MaxEntries == 0)
+        return;
+    m_inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    m_stopFd = eventfd(0, EFD_CLOEXEC);
+    if (m_inotifyFd < 0 || m_stopFd < 0)
+    {
+        spdlog::warn("{} inotify unavailable, errno[{}], files are opened on every request", __FUNCTION__, errno);
+        if (m_inotifyFd >= 0)
+            close(m_inotifyFd);
+        m_inotifyFd = -1;
+        return;
+    }
+    m_watcher = std::thread([this] { watchLoop(); });
+}
+
+FileCache::~FileCache()
+{
+    if (m_watcher.joinable())
+    {
+        uint64_t one = 1;
+        if (write(m_stopFd, &one, sizeof(one)) != sizeof(one))
+            spdlog::warn("{} wake watcher failed, errno[{}]", __FUNCTION__, errno);
+        m_watcher.join();
+    }
+    if (m_inotifyFd >= 0)
+        close(m_inotifyFd);
+    if (m_stopFd >= 0)
+        close(m_stopFd);
+}
+
+std::shared_ptr<const CachedFile> FileCache::load(const std::string& Path, int& Error)
+{
+    int fd = ::open(Path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        Error = errno;
+        return nullptr;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode))
+    {
+        Error = ENOENT;
+        close(fd);
+        return nullptr;
+    }
+    /* Segment 接管 fd，最后一个引用（缓存条目、响应或输出缓冲区中的数据）释放时关闭 */
+    struct evbuffer_file_segment* segment = evbuffer_file_segment_new(fd, 0, st.st_size, EVBUF_FS_CLOSE_ON_FREE);
+    if (segment == nullptr)
+    {
+        Error = EIO;
+        close(fd);
+        return nullptr;
+    }
+    auto file = std::make_shared<CachedFile>();
+    file->m_segment.reset(segment, evbuffer_file_segment_free);
+    file->m_size = st.st_size;
+    file->m_mtime = st.st_mtime;
+    char etag[48];
+    int etagLen = snprintf(etag, sizeof(etag), "\"%llx-%llx\"", static_cast<unsigned long long>(st.st_mtime),
+        static_cast<unsigned long long>(st.st_size));
+    file->m_etag.assign(etag, static_cast<size_t>(etagLen));
+    char date[32];
+    file->m_lastModified = formatHttpDate(st.st_mtime, date);
+    file->m_mimeType = mimeTypeOf(Path);
+    return file;
+}
+
+std::shared_ptr<const CachedFile> FileCache::open(const std::string& Path, int& Error)
+{
+    if (!enabled())
+    {
+        std::lock_guard<std::mutex> lk(m_shards[0].m_mutex);
+        m_shards[0].m_misses++;
+        return load(Path, Error);
+    }
+
+    Shard& shard = shardOf(Path);
+    uint64_t generation = 0;
+    {
+        std::lock_guard<std::mutex> lk(shard.m_mutex);
+        auto it = shard.m_index.find(Path);
+        if (it != shard.m_index.end())
+        {
+            shard.m_lru.splice(shard.m_lru.begin(), shard.m_lru, it->second);
+            shard.m_hits++;
+            return it->second->m_file;
+        }
+        shard.m_misses++;
+        generation = shard.m_generation;
+    }
+
+    /* 先建立监视再打开文件，打开之后发生的修改一定会产生事件 */
+    bool cacheable = watchDirectory(Path);
+    auto file = load(Path, Error);
+    if (!file || !cacheable)
+        return file;
+
+    std::list<Entry> evicted;
+    std::lock_guard<std::mutex> lk(shard.m_mutex);
+    if (shard.m_generation != generation || shard.m_index.count(Path) != 0)
+        return file;
+    shard.m_lru.push_front(Entry { Path, file });
+    shard.m_index.emplace(shard.m_lru.front().m_path, shard.m_lru.begin());
+    while (shard.m_lru.size() > m_shardCapacity)
+    {
+        shard.m_index.erase(shard.m_lru.back().m_path);
+        evicted.splice(evicted.begin(), shard.m_lru, std::prev(shard.m_lru.end()));
+        shard.m_evictions++;
+    }
+    return file;
+}
+
+bool FileCache::watchDirectory(std::string_view Path)
+{
+    auto slash = Path.rfind('/');
+    if (slash == std::string_view::npos)
+        return false;
+    std::string directory(Path.substr(0, slash == 0 ? 1 : slash));
+    std::lock_guard<std::mutex> lk(m_watchMutex);
+    if (m_watchByDirectory.count(directory) != 0)
+        return true;
+    int wd = inotify_add_watch(m_inotifyFd, directory.c_str(), WATCH_MASK);
+    if (wd < 0)
+    {
+        spdlog::warn("{} watch [{}] failed, errno[{}]", __FUNCTION__, directory, errno);
+        return false;
+    }
+    m_directoriesByWatch[wd].push_back(directory);
+    m_watchByDirectory.emplace(std::move(directory), wd);
+    return true;
+}
+
+void FileCache::invalidate(const std::string& Path)
+{
+    Shard& shard = shardOf(Path);
+    std::list<Entry> removed;
+    std::lock_guard<std::mutex> lk(shard.m_mutex);
+    /* 即使没有条目也要推进代数，正在加载这个路径的未命中不能把旧版本放进来 */
+    shard.m_generation++;
+    auto it = shard.m_index.find(Path);
+    if (it == shard.m_index.end())
+        return;
+    removed.splice(removed.begin(), shard.m_lru, it->second);
+    shard.m_index.erase(it);
+    shard.m_invalidations++;
+}
+
+void FileCache::invalidateAll()
+{
+    for (auto& shard : m_shards)
+    {
+        std::list<Entry> removed;
+        std::lock_guard<std::mutex> lk(shard.m_mutex);
+        shard.m_generation++;
+        shard.m_invalidations += shard.m_lru.size();
+        shard.m_index.clear();
+        removed.swap(shard.m_lru);
+    }
+}
+
+void FileCache::watchLoop()
+{
+    alignas(struct inotify_event) char buffer[16 * 1024];
+    struct pollfd fds[2] = { { m_inotifyFd, POLLIN, 0 }, { m_stopFd, POLLIN, 0 } };
+    while (true)
+    {
+        if (poll(fds, 2, -1) < 0 && errno != EINTR)
+            break;
+        if (fds[1].revents != 0)
+            break;
+        ssize_t len = read(m_inotifyFd, buffer, sizeof(buffer));
+        if (len <= 0)
+            continue;
+        for (char* ptr = buffer; ptr < buffer + len;)
+        {
+            auto* event = reinterpret_cast<struct inotify_event*>(ptr);
+            ptr += sizeof(struct inotify_event) + event->len;
+
+            std::vector<std::string> directories;
+            {
+                std::lock_guard<std::mutex> lk(m_watchMutex);
+                auto it = m_directoriesByWatch.find(event->wd);
+                if (it != m_directoriesByWatch.end())
+                {
+                    directories = it->second;
+                    /* 目录被删除或所在文件系统卸载，内核已移除监视 */
+                    if (event->mask & IN_IGNORED)
+                    {
+                        for (auto& directory : it->second)
+                            m_watchByDirectory.erase(directory);
+                        m_directoriesByWatch.erase(it);
+                    }
+                }
+            }
+            /* 丢失了事件、目录自身或其子目录改变了位置时无法逐条确定受影响的路径，整体清空 */
+            if ((event->mask & (IN_Q_OVERFLOW | IN_IGNORED | IN_DELETE_SELF | IN_MOVE_SELF))
+                || ((event->mask & IN_ISDIR) && (event->mask & (IN_DELETE | IN_MOVED_FROM))))
+            {
+                invalidateAll();
+                continue;
+            }
+            if (event->len == 0)
+                continue;
+            for (auto& directory : directories)
+                invalidate((directory == "/" ? std::string() : directory) + "/" + event->name);
+        }
+    }
+}
+
+FileCache::Stats FileCache::stats() const
+{
+    Stats stats;
+    for (auto& shard : m_shards)
+    {
+        std::lock_guard<std::mutex> lk(shard.m_mutex);
+        stats.m_hits += shard.m_hits;
+        stats.m_misses += shard.m_misses;
+        stats.m_invalidations += shard.m_invalidations;
+        stats.m_evictions += shard.m_evictions;
+        stats.m_entries += shard.m_lru.size();
+    }
+    return stats;
+}
+}   // namespace ToolKit
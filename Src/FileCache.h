@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <sys/types.h>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+struct evbuffer_file_segment;
+
+namespace ToolKit
+{
+/**
+ * @brief 一个已打开的普通文件及其发送响应所需的元数据
+ * 文件描述符由 m_segment 持有，缓存淘汰后仍被响应或输出缓冲区引用时保持打开，最后一个引用释放时关闭。
+ */
+struct CachedFile
+{
+    std::shared_ptr<struct evbuffer_file_segment> m_segment;
+    off_t m_size { 0 };
+    time_t m_mtime { 0 };
+    std::string m_etag;
+    std::string m_lastModified;
+    std::string_view m_mimeType;
+};
+
+/**
+ * @brief 分片的打开文件缓存：缓存 fd、stat 结果、ETag 与 MIME 类型，命中时不再 open/fstat/close
+ * 路径按哈希分到各分片，每个分片一把锁、一条 LRU 链，条目数超过 MaxEntries / Shards 时淘汰最久未用的条目。
+ * 文件所在目录在首次缓存时加入 inotify 监视，后台线程收到目录下的修改、替换、删除事件后使对应条目失效，
+ * 而不是每次请求重新 stat；事件队列溢出或目录本身被移动、删除时清空整个缓存。
+ * 只能看到被监视目录中的变化：符号链接指向的目标在别处被修改时不会失效。
+ * MaxEntries 为 0 或 inotify 不可用时退化为每次打开文件，不做缓存。
+ */
+class FileCache
+{
+public:
+    struct Stats
+    {
+        uint64_t m_hits { 0 };
+        uint64_t m_misses { 0 };
+        uint64_t m_invalidations { 0 };
+        uint64_t m_evictions { 0 };
+        size_t m_entries { 0 };
+    };
+
+    explicit FileCache(size_t MaxEntries, size_t Shards = 16);
+    ~FileCache();
+    FileCache(const FileCache&) = delete;
+    const FileCache& operator=(const FileCache&) = delete;
+
+    /**
+     * @brief 取得 Path 对应的文件，可并发调用；打开失败或不是普通文件时返回空指针，Error 为对应的 errno
+     * Path 应当是规范化的路径（不含 //、/./），同一文件的不同写法会各占一个条目且可能无法失效。
+     */
+    std::shared_ptr<const CachedFile> open(const std::string& Path, int& Error);
+
+    Stats stats() const;
+
+    /**
+     * @brief 是否真正在缓存文件（容量非 0 且 inotify 可用）
+     */
+    bool enabled() const { return m_inotifyFd >= 0; }
+
+private:
+    struct Entry
+    {
+        std::string m_path;
+        std::shared_ptr<const CachedFile> m_file;
+    };
+
+    struct alignas(64) Shard
+    {
+        mutable std::mutex m_mutex;
+        /* 表头是最近使用的条目 */
+        std::list<Entry> m_lru;
+        /* 键指向链表节点中的路径，节点不会搬移 */
+        std::unordered_map<std::string_view, std::list<Entry>::iterator> m_index;
+        /* 每次失效加一，未命中期间发生过失效的加载结果不放入缓存，避免把旧版本写回去 */
+        uint64_t m_generation { 0 };
+        uint64_t m_hits { 0 };
+        uint64_t m_misses { 0 };
+        uint64_t m_invalidations { 0 };
+        uint64_t m_evictions { 0 };
+    };
+
+    static std::shared_ptr<const CachedFile> load(const std::string& Path, int& Error);
+
+    Shard& shardOf(std::string_view Path) { return m_shards[std::hash<std::string_view> {}(Path) % m_shards.size()]; }
+
+    /**
+     * @brief 确保 Path 所在目录已被监视，失败时该文件不能缓存
+     */
+    bool watchDirectory(std::string_view Path);
+
+    void invalidate(const std::string& Path);
+    void invalidateAll();
+    void watchLoop();
+
+    const size_t m_shardCapacity;
+    std::vector<Shard> m_shards;
+
+    int m_inotifyFd { -1 };
+    /* 通知后台线程退出 */
+    int m_stopFd { -1 };
+    std::mutex m_watchMutex;
+    std::unordered_map<std::string, int> m_watchByDirectory;
+    /* 同一目录可能经由不同路径（符号链接）被监视，共用一个 wd */
+    std::unordered_map<int, std::vector<std::string>> m_directoriesByWatch;
+    std::thread m_watcher;
+};
+}   // namespace ToolKit
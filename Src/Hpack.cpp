@@ -0,0 +1,503 @@
+#include "Hpack.h"
+
+#include <algorithm>
+#include <array>
+#include <unordered_map>
+
+namespace
+{
+/* RFC 7541 附录 A */
+constexpr std::pair<std::string_view, std::string_view> STATIC_TABLE[] = { { ":authority", "" }, { ":method", "GET" },
+    { ":method", "POST" }, { ":path", "/" }, { ":path", "/index.html" }, { ":scheme", "http" }, { ":scheme", "https" },
+    { ":status", "200" }, { ":status", "204" }, { ":status", "206" }, { ":status", "304" }, { ":status", "400" },
+    { ":status", "404" }, { ":status", "500" }, { "accept-charset", "" }, { "accept-encoding", "gzip, deflate" },
+    { "accept-language", "" }, { "accept-ranges", "" }, { "accept", "" }, { "access-control-allow-origin", "" },
+    { "age", "" }, { "allow", "" }, { "authorization", "" }, { "cache-control", "" }, { "content-disposition", "" },
+    { "content-encoding", "" }, { "content-language", "" }, { "content-length", "" }, { "content-location", "" },
+    { "content-range", "" }, { "content-type", "" }, { "cookie", "" }, { "date", "" }, { "etag", "" }, { "expect", "" },
+    { "expires", "" }, { "from", "" }, { "host", "" }, { "if-match", "" }, { "if-modified-since", "" },
+    { "if-none-match", "" }, { "if-range", "" }, { "if-unmodified-since", "" }, { "last-modified", "" }, { "link", "" },
+    { "location", "" }, { "max-forwards", "" }, { "proxy-authenticate", "" }, { "proxy-authorization", "" },
+    { "range", "" }, { "referer", "" }, { "refresh", "" }, { "retry-after", "" }, { "server", "" }, { "set-cookie", "" },
+    { "strict-transport-security", "" }, { "transfer-encoding", "" }, { "user-agent", "" }, { "vary", "" }, { "via", "" },
+    { "www-authenticate", "" } };
+constexpr size_t STATIC_COUNT = sizeof(STATIC_TABLE) / sizeof(STATIC_TABLE[0]);
+
+/* RFC 7541 附录 B 中各符号（含 EOS）的编码长度；该编码是规范 Huffman 编码，码字可由长度依次推出 */
+constexpr uint8_t HUFFMAN_LENGTHS[257] = { 13, 23, 28, 28, 28, 28, 28, 28, 28, 24, 30, 28, 28, 30, 28, 28, 28, 28, 28, 28,
+    28, 28, 30, 28, 28, 28, 28, 28, 28, 28, 28, 28, 6, 10, 10, 12, 13, 6, 8, 11, 10, 10, 8, 11, 8, 6, 6, 6, 5, 5, 5, 6, 6,
+    6, 6, 6, 6, 6, 7, 8, 15, 6, 12, 10, 13, 6, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 8, 7, 8,
+    13, 19, 13, 14, 6, 15, 5, 6, 5, 6, 5, 6, 6, 6, 5, 7, 7, 6, 6, 6, 5, 6, 7, 6, 5, 5, 6, 7, 7, 7, 7, 7, 15, 11, 14, 13,
+    28, 20, 22, 20, 20, 22, 22, 22, 23, 22, 23, 23, 23, 23, 23, 24, 23, 24, 24, 22, 23, 24, 23, 23, 23, 23, 21, 22, 23, 22,
+    23, 23, 24, 22, 21, 20, 22, 22, 23, 23, 21, 23, 22, 22, 24, 21, 22, 23, 23, 21, 21, 22, 21, 23, 22, 23, 23, 20, 22, 22,
+    22, 23, 22, 22, 23, 26, 26, 20, 19, 22, 23, 22, 25, 26, 26, 26, 27, 27, 26, 24, 25, 19, 21, 26, 27, 27, 26, 27, 24, 21,
+    21, 26, 26, 28, 27, 27, 27, 20, 24, 20, 21, 22, 21, 21, 23, 22, 22, 25, 25, 24, 24, 26, 23, 26, 27, 26, 26, 27, 27, 27,
+    27, 27, 28, 27, 27, 27, 27, 27, 26, 30 };
+constexpr int HUFFMAN_MAX_LENGTH = 30;
+constexpr uint16_t HUFFMAN_EOS = 256;
+
+/**
+ * @brief 由编码长度生成的码表
+ * 解码时取输入的高 32 位与各长度的上界比较：规范编码中同一长度的码字连续，且短码字左对齐后都小于长码字，
+ * 第一个满足 top < m_limit[L] 的 L 就是当前符号的长度，常见字符只需比较几次。
+ */
+struct HuffmanTable
+{
+    std::array<uint32_t, 257> m_codes {};
+    std::array<uint32_t, HUFFMAN_MAX_LENGTH + 1> m_first {};
+    std::array<uint16_t, HUFFMAN_MAX_LENGTH + 1> m_offset {};
+    std::array<uint64_t, HUFFMAN_MAX_LENGTH + 1> m_limit {};
+    std::array<uint16_t, 257> m_symbols {};
+
+    HuffmanTable()
+    {
+        uint32_t code = 0;
+        uint16_t next = 0;
+        for (int len = 1; len <= HUFFMAN_MAX_LENGTH; len++)
+        {
+            m_first[len] = code;
+            m_offset[len] = next;
+            for (uint16_t symbol = 0; symbol <= HUFFMAN_EOS; symbol++)
+            {
+                if (HUFFMAN_LENGTHS[symbol] == len)
+                {
+                    m_codes[symbol] = code++;
+                    m_symbols[next++] = symbol;
+                }
+            }
+            m_limit[len] = static_cast<uint64_t>(code) << (32 - len);
+            code <<= 1;
+        }
+    }
+};
+
+const HuffmanTable& huffmanTable()
+{
+    static const HuffmanTable table;
+    return table;
+}
+
+/**
+ * @brief 小写的静态表名称到其第一个索引
+ */
+const std::unordered_map<std::string_view, uint8_t>& staticNames()
+{
+    static const auto names = []
+    {
+        std::unordered_map<std::string_view, uint8_t> map;
+        for (size_t i = STATIC_COUNT; i > 0; i--)
+            map[STATIC_TABLE[i - 1].first] = static_cast<uint8_t>(i);
+        return map;
+    }();
+    return names;
+}
+
+void encodeInteger(std::string& Out, uint8_t Flags, int PrefixBits, uint64_t Value)
+{
+    const uint64_t max = (1u << PrefixBits) - 1;
+    if (Value < max)
+    {
+        Out.push_back(static_cast<char>(Flags | Value));
+        return;
+    }
+    Out.push_back(static_cast<char>(Flags | max));
+    Value -= max;
+    while (Value >= 128)
+    {
+        Out.push_back(static_cast<char>((Value & 0x7f) | 0x80));
+        Value >>= 7;
+    }
+    Out.push_back(static_cast<char>(Value));
+}
+
+bool decodeInteger(const uint8_t*& Cur, const uint8_t* End, int PrefixBits, uint64_t& Value)
+{
+    if (Cur == End)
+        return false;
+    const uint64_t max = (1u << PrefixBits) - 1;
+    Value = *Cur++ & max;
+    if (Value < max)
+        return true;
+    for (int shift = 0; Cur != End; shift += 7)
+    {
+        /* 首部中的整数都远小于 2^32，更长的编码视为格式错误 */
+        if (shift > 28)
+            return false;
+        uint8_t byte = *Cur++;
+        Value += static_cast<uint64_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0)
+            return true;
+    }
+    return false;
+}
+
+void encodeString(std::string& Out, std::string_view Text)
+{
+    size_t huffman = ToolKit::huffmanEncodedLength(Text);
+    if (huffman < Text.size())
+    {
+        encodeInteger(Out, 0x80, 7, huffman);
+        ToolKit::huffmanEncode(Text, Out);
+        return;
+    }
+    encodeInteger(Out, 0, 7, Text.size());
+    Out.append(Text);
+}
+
+/**
+ * @brief 每个响应都不同的字段，加入动态表只会挤掉可复用的条目
+ */
+bool volatileField(std::string_view Name)
+{
+    return Name == "content-length" || Name == "date" || Name == "etag" || Name == "last-modified"
+        || Name == "content-range" || Name == "set-cookie" || Name == "location";
+}
+
+constexpr size_t entrySize(std::string_view Name, std::string_view Value)
+{
+    /* RFC 7541 4.1：条目大小为名称与值的长度加 32 字节开销 */
+    return Name.size() + Value.size() + 32;
+}
+}   // namespace
+
+namespace ToolKit
+{
+void huffmanEncode(std::string_view Text, std::string& Out)
+{
+    const auto& table = huffmanTable();
+    uint64_t bits = 0;
+    int count = 0;
+    for (unsigned char c : Text)
+    {
+        bits = (bits << HUFFMAN_LENGTHS[c]) | table.m_codes[c];
+        count += HUFFMAN_LENGTHS[c];
+        while (count >= 8)
+        {
+            count -= 8;
+            Out.push_back(static_cast<char>(bits >> count));
+        }
+    }
+    if (count > 0)
+        Out.push_back(static_cast<char>((bits << (8 - count)) | (0xff >> count)));
+}
+
+size_t huffmanEncodedLength(std::string_view Text)
+{
+    size_t bits = 0;
+    for (unsigned char c : Text)
+        bits += HUFFMAN_LENGTHS[c];
+    return (bits + 7) / 8;
+}
+
+bool huffmanDecode(std::string_view Encoded, std::string& Out)
+{
+    const auto& table = huffmanTable();
+    auto cur = reinterpret_cast<const uint8_t*>(Encoded.data());
+    const auto end = cur + Encoded.size();
+    /* 未消费的位左对齐保存在 bits 的高位 */
+    uint64_t bits = 0;
+    int count = 0;
+    while (true)
+    {
+        while (count <= 56 && cur != end)
+        {
+            bits |= static_cast<uint64_t>(*cur++) << (56 - count);
+            count += 8;
+        }
+        /* 末尾不足一个字节的全 1 位是填充；最短的码字有 5 位，全 1 的码字至少 8 位，两者不会混淆 */
+        if (count == 0 || (cur == end && count <= 7 && (bits >> (64 - count)) == (1u << count) - 1))
+            break;
+        const uint64_t top = bits >> 32;
+        int len = 5;
+        while (top >= table.m_limit[len])
+            len++;
+        /* 剩余的位不足一个完整码字，或者填充不是全 1 */
+        if (len > count)
+            return false;
+        auto symbol = table.m_symbols[table.m_offset[len] + (static_cast<uint32_t>(top >> (32 - len)) - table.m_first[len])];
+        if (symbol == HUFFMAN_EOS)
+            return false;
+        Out.push_back(static_cast<char>(symbol));
+        bits <<= len;
+        count -= len;
+    }
+    return true;
+}
+
+void HpackDynamicTable::add(std::string_view Name, std::string_view Value)
+{
+    const size_t size = entrySize(Name, Value);
+    /* 比整张表还大的条目会清空动态表，本身不加入 */
+    if (size > m_maxSize)
+    {
+        evict(0);
+        return;
+    }
+    evict(m_maxSize - size);
+    m_entries.push_front({ std::string(Name), std::string(Value) });
+    m_size += size;
+}
+
+void HpackDynamicTable::setMaxSize(size_t MaxSize)
+{
+    m_maxSize = MaxSize;
+    evict(MaxSize);
+}
+
+void HpackDynamicTable::evict(size_t Limit)
+{
+    while (m_size > Limit)
+    {
+        m_size -= entrySize(m_entries.back().m_name, m_entries.back().m_value);
+        m_entries.pop_back();
+    }
+}
+
+int HpackDynamicTable::find(std::string_view Name, std::string_view Value, bool& Exact) const
+{
+    int nameMatch = -1;
+    for (size_t i = 0; i < m_entries.size(); i++)
+    {
+        if (m_entries[i].m_name != Name)
+            continue;
+        if (m_entries[i].m_value == Value)
+        {
+            Exact = true;
+            return static_cast<int>(i);
+        }
+        if (nameMatch < 0)
+            nameMatch = static_cast<int>(i);
+    }
+    Exact = false;
+    return nameMatch;
+}
+
+HpackDecoder::HpackDecoder(size_t MaxTableSize)
+        : m_table(MaxTableSize)
+        , m_maxTableSize(MaxTableSize)
+{
+}
+
+void HpackDecoder::reset()
+{
+    m_table.setMaxSize(0);
+    m_table.setMaxSize(m_maxTableSize);
+    m_lastBlockSize = 0;
+}
+
+bool HpackDecoder::readString(const uint8_t*& Cur, const uint8_t* End, std::string& Storage)
+{
+    if (Cur == End)
+        return false;
+    const bool huffman = (*Cur & 0x80) != 0;
+    uint64_t length = 0;
+    if (!decodeInteger(Cur, End, 7, length) || length > static_cast<uint64_t>(End - Cur))
+        return false;
+    std::string_view text(reinterpret_cast<const char*>(Cur), length);
+    Cur += length;
+    if (huffman)
+        return huffmanDecode(text, Storage);
+    Storage.append(text);
+    return true;
+}
+
+bool HpackDecoder::skipString(const uint8_t*& Cur, const uint8_t* End)
+{
+    if (Cur == End)
+        return false;
+    uint64_t length = 0;
+    if (!decodeInteger(Cur, End, 7, length) || length > static_cast<uint64_t>(End - Cur))
+        return false;
+    Cur += length;
+    return true;
+}
+
+bool HpackDecoder::readField(const uint8_t*& Cur, const uint8_t* End, uint64_t Index, bool Indexed, std::string& Storage,
+    HpackField& Field)
+{
+    Field.m_nameOffset = static_cast<uint32_t>(Storage.size());
+    if (Index == 0)
+    {
+        if (!readString(Cur, End, Storage))
+            return false;
+    }
+    else if (Index <= STATIC_COUNT)
+    {
+        Storage.append(STATIC_TABLE[Index - 1].first);
+    }
+    else
+    {
+        Storage.append(m_table.at(Index - STATIC_COUNT - 1).m_name);
+    }
+    Field.m_nameLength = static_cast<uint32_t>(Storage.size() - Field.m_nameOffset);
+
+    Field.m_valueOffset = static_cast<uint32_t>(Storage.size());
+    if (!Indexed)
+    {
+        if (!readString(Cur, End, Storage))
+            return false;
+    }
+    else if (Index <= STATIC_COUNT)
+    {
+        Storage.append(STATIC_TABLE[Index - 1].second);
+    }
+    else
+    {
+        Storage.append(m_table.at(Index - STATIC_COUNT - 1).m_value);
+    }
+    Field.m_valueLength = static_cast<uint32_t>(Storage.size() - Field.m_valueOffset);
+    return true;
+}
+
+bool HpackDecoder::decode(std::string_view Block, std::string& Storage, std::vector<HpackField>& Fields, size_t MaxBlockSize)
+{
+    auto cur = reinterpret_cast<const uint8_t*>(Block.data());
+    const auto end = cur + Block.size();
+    const size_t storageStart = Storage.size();
+    const size_t fieldStart = Fields.size();
+    m_lastBlockSize = 0;
+    bool fieldSeen = false;
+    while (cur != end)
+    {
+        const uint8_t byte = *cur;
+        uint64_t index = 0;
+        if ((byte & 0xe0) == 0x20)
+        {
+            /* 动态表大小更新只能出现在块首，且不能超过本端通告的上限 */
+            if (fieldSeen || !decodeInteger(cur, end, 5, index) || index > m_maxTableSize)
+                return false;
+            m_table.setMaxSize(index);
+            continue;
+        }
+        fieldSeen = true;
+
+        bool indexed = (byte & 0x80) != 0;
+        bool incremental = (byte & 0xc0) == 0x40;
+        if (!decodeInteger(cur, end, indexed ? 7 : (incremental ? 6 : 4), index))
+            return false;
+        if (indexed && index == 0)
+            return false;
+        if (index > STATIC_COUNT + m_table.count())
+            return false;
+
+        /* 超限后字段不再保存也不再展开，反复引用同一个大表项的块不会撑大内存；
+         * 只有增量索引的字段会改变动态表，仍需解出名称与值 */
+        const bool overflow = m_lastBlockSize > MaxBlockSize;
+        if (overflow && !incremental)
+        {
+            if ((index == 0 && !skipString(cur, end)) || (!indexed && !skipString(cur, end)))
+                return false;
+            continue;
+        }
+        std::string& target = overflow ? m_overflow : Storage;
+        if (overflow)
+            m_overflow.clear();
+        HpackField field;
+        if (!readField(cur, end, index, indexed, target, field))
+            return false;
+
+        std::string_view name(target.data() + field.m_nameOffset, field.m_nameLength);
+        std::string_view value(target.data() + field.m_valueOffset, field.m_valueLength);
+        if (incremental)
+            m_table.add(name, value);
+        if (overflow)
+            continue;
+        m_lastBlockSize += entrySize(name, value);
+        if (m_lastBlockSize > MaxBlockSize)
+        {
+            Storage.resize(storageStart);
+            Fields.resize(fieldStart);
+            continue;
+        }
+        Fields.push_back(field);
+    }
+    return true;
+}
+
+void HpackEncoder::setMaxTableSize(size_t Size)
+{
+    Size = std::min(Size, HPACK_DEFAULT_TABLE_SIZE);
+    if (!m_sizeChanged)
+    {
+        if (Size == m_table.maxSize())
+            return;
+        m_pendingSize = Size;
+        m_sizeChanged = true;
+    }
+    else
+    {
+        /* 两个首部块之间对端可能先缩小再放大，须先告知其中的最小值，双方淘汰的条目才一致 */
+        m_pendingSize = std::min(m_pendingSize, Size);
+    }
+    m_table.setMaxSize(Size);
+}
+
+void HpackEncoder::beginBlock(std::string& Out)
+{
+    if (!m_sizeChanged)
+        return;
+    if (m_pendingSize < m_table.maxSize())
+        encodeInteger(Out, 0x20, 5, m_pendingSize);
+    encodeInteger(Out, 0x20, 5, m_table.maxSize());
+    m_sizeChanged = false;
+}
+
+void HpackEncoder::encode(std::string_view Name, std::string_view Value, std::string& Out)
+{
+    bool exact = false;
+    int dynamic = m_table.find(Name, Value, exact);
+    if (exact)
+    {
+        encodeInteger(Out, 0x80, 7, STATIC_COUNT + 1 + static_cast<size_t>(dynamic));
+        return;
+    }
+    size_t nameIndex = 0;
+    auto& names = staticNames();
+    auto it = names.find(Name);
+    if (it != names.end())
+        nameIndex = it->second;
+    else if (dynamic >= 0)
+        nameIndex = STATIC_COUNT + 1 + static_cast<size_t>(dynamic);
+
+    if (volatileField(Name))
+    {
+        /* 不加入动态表的字面量 */
+        encodeInteger(Out, 0, 4, nameIndex);
+    }
+    else
+    {
+        encodeInteger(Out, 0x40, 6, nameIndex);
+        m_table.add(Name, Value);
+    }
+    if (nameIndex == 0)
+        encodeString(Out, Name);
+    encodeString(Out, Value);
+}
+
+void HpackEncoder::encodeStatus(int Code, std::string& Out)
+{
+    /* 静态表 8-14 */
+    static constexpr int CODES[] = { 200, 204, 206, 304, 400, 404, 500 };
+    for (size_t i = 0; i < sizeof(CODES) / sizeof(CODES[0]); i++)
+    {
+        if (CODES[i] == Code)
+        {
+            encodeInteger(Out, 0x80, 7, 8 + i);
+            return;
+        }
+    }
+    char text[4];
+    text[0] = static_cast<char>('0' + Code / 100 % 10);
+    text[1] = static_cast<char>('0' + Code / 10 % 10);
+    text[2] = static_cast<char>('0' + Code % 10);
+    encode(":status", std::string_view(text, 3), Out);
+}
+
+void HpackEncoder::reset()
+{
+    m_table.setMaxSize(0);
+    m_table.setMaxSize(HPACK_DEFAULT_TABLE_SIZE);
+    m_pendingSize = 0;
+    m_sizeChanged = false;
+}
+}   // namespace ToolKit
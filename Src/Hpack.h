@@ -0,0 +1,160 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ToolKit
+{
+/* SETTINGS_HEADER_TABLE_SIZE 的初始值，也是编码端使用的动态表上限 */
+constexpr size_t HPACK_DEFAULT_TABLE_SIZE = 4096;
+
+/**
+ * @brief 以 RFC 7541 附录 B 的 Huffman 编码追加 Text 到 Out，末尾不足一个字节的部分以 EOS 前缀（全 1）填充
+ */
+void huffmanEncode(std::string_view Text, std::string& Out);
+
+/**
+ * @brief Text 经 Huffman 编码后的字节数
+ */
+size_t huffmanEncodedLength(std::string_view Text);
+
+/**
+ * @brief 解码 Huffman 串并追加到 Out，遇到 EOS、多于 7 位或不是全 1 的填充时返回 false
+ */
+bool huffmanDecode(std::string_view Encoded, std::string& Out);
+
+/**
+ * @brief HPACK 动态表，新条目在前，索引 0 对应整体索引 62
+ */
+class HpackDynamicTable
+{
+public:
+    struct Entry
+    {
+        std::string m_name;
+        std::string m_value;
+    };
+
+    explicit HpackDynamicTable(size_t MaxSize = HPACK_DEFAULT_TABLE_SIZE)
+            : m_maxSize(MaxSize)
+    {
+    }
+
+    void add(std::string_view Name, std::string_view Value);
+
+    /**
+     * @brief 调整容量，超出的旧条目立即淘汰
+     */
+    void setMaxSize(size_t MaxSize);
+
+    /**
+     * @brief 查找完全匹配（Exact 为 true）或只有名称匹配的条目，返回动态表内的下标，不存在时返回 -1
+     */
+    int find(std::string_view Name, std::string_view Value, bool& Exact) const;
+
+    const Entry& at(size_t Index) const { return m_entries[Index]; }
+    size_t count() const { return m_entries.size(); }
+    size_t size() const { return m_size; }
+    size_t maxSize() const { return m_maxSize; }
+
+private:
+    void evict(size_t Limit);
+
+    std::deque<Entry> m_entries;
+    size_t m_size { 0 };
+    size_t m_maxSize;
+};
+
+/**
+ * @brief 解码得到的首部字段，偏移指向 decode 时给定的存储字符串
+ */
+struct HpackField
+{
+    uint32_t m_nameOffset;
+    uint32_t m_nameLength;
+    uint32_t m_valueOffset;
+    uint32_t m_valueLength;
+};
+
+/**
+ * @brief HPACK 解码器，每个 HTTP/2 连接一个，连接上的所有首部块必须按到达顺序解码
+ */
+class HpackDecoder
+{
+public:
+    /**
+     * @brief MaxTableSize 为本端通告的 SETTINGS_HEADER_TABLE_SIZE，对端的表大小更新不能超过它
+     */
+    explicit HpackDecoder(size_t MaxTableSize = HPACK_DEFAULT_TABLE_SIZE);
+
+    /**
+     * @brief 解码一个完整的首部块，字段的名称与值依次追加到 Storage，偏移追加到 Fields
+     * 块格式错误时返回 false，按协议这是连接级的 COMPRESSION_ERROR，解码器此后不再可用。
+     * 解码出的字段总长度（按 RFC 7541 的条目大小计算）保存在 lastBlockSize 中。总长度一旦超过 MaxBlockSize，
+     * 本块已追加的字段被撤回，其余字段只为保持与编码端的动态表同步而解码，不再保存，此时 lastBlockSize
+     * 大于 MaxBlockSize，超限由调用者处理。
+     */
+    bool decode(std::string_view Block, std::string& Storage, std::vector<HpackField>& Fields,
+        size_t MaxBlockSize = std::numeric_limits<size_t>::max());
+
+    size_t lastBlockSize() const { return m_lastBlockSize; }
+
+    void reset();
+
+private:
+    bool readString(const uint8_t*& Cur, const uint8_t* End, std::string& Storage);
+    bool skipString(const uint8_t*& Cur, const uint8_t* End);
+    bool readField(const uint8_t*& Cur, const uint8_t* End, uint64_t Index, bool Indexed, std::string& Storage,
+        HpackField& Field);
+
+    HpackDynamicTable m_table;
+    size_t m_maxTableSize;
+    size_t m_lastBlockSize { 0 };
+    /* 超限后增量索引字段的临时空间 */
+    std::string m_overflow;
+};
+
+/**
+ * @brief HPACK 编码器
+ * 完全匹配静态表或动态表的字段只输出索引；其余字段以增量索引的字面量输出并加入动态表，
+ * 同一连接上重复出现的响应首部（content-type、server、vary 等）此后只占一两个字节。
+ * 每个请求都不同的字段（content-length、date、etag 等）不加入动态表，避免冲掉可复用的条目。
+ * 字符串在 Huffman 编码更短时使用 Huffman 编码。
+ */
+class HpackEncoder
+{
+public:
+    /**
+     * @brief 对端通告的 SETTINGS_HEADER_TABLE_SIZE，实际使用不超过 HPACK_DEFAULT_TABLE_SIZE；
+     * 变化会在下一个首部块开头以表大小更新告知对端
+     */
+    void setMaxTableSize(size_t Size);
+
+    /**
+     * @brief 开始一个首部块，输出待发送的表大小更新
+     */
+    void beginBlock(std::string& Out);
+
+    /**
+     * @brief 编码一个字段，Name 须为小写
+     */
+    void encode(std::string_view Name, std::string_view Value, std::string& Out);
+
+    /**
+     * @brief 编码 :status，常见状态码直接使用静态表索引
+     */
+    void encodeStatus(int Code, std::string& Out);
+
+    void reset();
+
+private:
+    HpackDynamicTable m_table;
+    size_t m_pendingSize { 0 };
+    bool m_sizeChanged { false };
+};
+}   // namespace ToolKit
@@ -0,0 +1,1040 @@
+#include "Http2Session.h"
+
+#include "RateLimiter.h"
+#include "ResponseCache.h"
+#include "ResponseCompressor.h"
+#include "spdlog/spdlog.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <event2/buffer.h>
+
+namespace
+{
+constexpr std::string_view SWITCHING_PROTOCOLS = "HTTP/1.1 101 Switching Protocols\r\nConnection: Upgrade\r\nUpgrade: h2c\r\n\r\n";
+/* 回收的流对象保留的请求体容量上限，避免偶发的大请求长期占用内存 */
+constexpr size_t RETAINED_BODY_CAPACITY = 64 * 1024;
+/* 解码首部的存储保留的容量上限，同上 */
+constexpr size_t RETAINED_HEADER_CAPACITY = 16 * 1024;
+
+uint32_t readUint32(const uint8_t* Data)
+{
+    return (static_cast<uint32_t>(Data[0]) << 24) | (static_cast<uint32_t>(Data[1]) << 16)
+        | (static_cast<uint32_t>(Data[2]) << 8) | Data[3];
+}
+
+void writeUint32(uint8_t* Data, uint32_t Value)
+{
+    Data[0] = static_cast<uint8_t>(Value >> 24);
+    Data[1] = static_cast<uint8_t>(Value >> 16);
+    Data[2] = static_cast<uint8_t>(Value >> 8);
+    Data[3] = static_cast<uint8_t>(Value);
+}
+
+void writeWindowUpdate(struct evbuffer* Output, uint32_t StreamId, uint32_t Increment)
+{
+    uint8_t payload[4];
+    writeUint32(payload, Increment);
+    ToolKit::writeHttp2FrameHeader(Output, sizeof(payload), ToolKit::HTTP2_FRAME::WINDOW_UPDATE, 0, StreamId);
+    evbuffer_add(Output, payload, sizeof(payload));
+}
+
+void writeRstStream(struct evbuffer* Output, uint32_t StreamId, ToolKit::HTTP2_ERROR Code)
+{
+    uint8_t payload[4];
+    writeUint32(payload, static_cast<uint32_t>(Code));
+    ToolKit::writeHttp2FrameHeader(Output, sizeof(payload), ToolKit::HTTP2_FRAME::RST_STREAM, 0, StreamId);
+    evbuffer_add(Output, payload, sizeof(payload));
+}
+
+/**
+ * @brief 解码 HTTP2-Settings 使用的 base64url（无填充，也接受末尾的 =）
+ */
+bool decodeBase64Url(std::string_view Text, std::string& Out)
+{
+    uint32_t bits = 0;
+    int count = 0;
+    for (char c : Text)
+    {
+        int value;
+        if (c >= 'A' && c <= 'Z')
+            value = c - 'A';
+        else if (c >= 'a' && c <= 'z')
+            value = c - 'a' + 26;
+        else if (c >= '0' && c <= '9')
+            value = c - '0' + 52;
+        else if (c == '-' || c == '+')
+            value = 62;
+        else if (c == '_' || c == '/')
+            value = 63;
+        else if (c == '=')
+            break;
+        else
+            return false;
+        bits = (bits << 6) | static_cast<uint32_t>(value);
+        count += 6;
+        if (count >= 8)
+        {
+            count -= 8;
+            Out.push_back(static_cast<char>(bits >> count));
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief 只属于单个 HTTP/1.1 连接的首部，在 HTTP/2 中不允许出现
+ */
+bool connectionSpecific(std::string_view Name)
+{
+    return Name == "connection" || Name == "keep-alive" || Name == "proxy-connection" || Name == "transfer-encoding"
+        || Name == "upgrade";
+}
+
+/**
+ * @brief 去掉 PADDED 标志对应的填充，填充长度非法时返回 false
+ */
+bool stripPadding(uint8_t Flags, const uint8_t*& Payload, size_t& Length)
+{
+    if ((Flags & ToolKit::HTTP2_FLAG_PADDED) == 0)
+        return true;
+    if (Length == 0 || Payload[0] >= Length)
+        return false;
+    Length -= 1 + Payload[0];
+    Payload += 1;
+    return true;
+}
+
+std::string_view trim(std::string_view Text)
+{
+    while (!Text.empty() && (Text.front() == ' ' || Text.front() == '\t'))
+        Text.remove_prefix(1);
+    while (!Text.empty() && (Text.back() == ' ' || Text.back() == '\t'))
+        Text.remove_suffix(1);
+    return Text;
+}
+}   // namespace
+
+namespace ToolKit
+{
+void writeHttp2FrameHeader(struct evbuffer* Output, size_t Length, HTTP2_FRAME Type, uint8_t Flags, uint32_t StreamId)
+{
+    uint8_t header[HTTP2_FRAME_HEADER_SIZE];
+    header[0] = static_cast<uint8_t>(Length >> 16);
+    header[1] = static_cast<uint8_t>(Length >> 8);
+    header[2] = static_cast<uint8_t>(Length);
+    header[3] = static_cast<uint8_t>(Type);
+    header[4] = Flags;
+    writeUint32(header + 5, StreamId & HTTP2_MAX_WINDOW);
+    evbuffer_add(Output, header, sizeof(header));
+}
+
+struct Http2Session::Stream
+{
+    Stream()
+            : m_pending(evbuffer_new())
+    {
+    }
+    ~Stream() { evbuffer_free(m_pending); }
+    Stream(const Stream&) = delete;
+    const Stream& operator=(const Stream&) = delete;
+
+    std::string_view field(uint32_t Offset, uint32_t Length) const { return { m_storage.data() + Offset, Length }; }
+
+    void addField(std::string_view Name, std::string_view Value)
+    {
+        HpackField field;
+        field.m_nameOffset = static_cast<uint32_t>(m_storage.size());
+        field.m_nameLength = static_cast<uint32_t>(Name.size());
+        m_storage.append(Name);
+        field.m_valueOffset = static_cast<uint32_t>(m_storage.size());
+        field.m_valueLength = static_cast<uint32_t>(Value.size());
+        m_storage.append(Value);
+        m_fields.push_back(field);
+    }
+
+    uint32_t m_id { 0 };
+    /* 解码后的首部字段，HttpRequest 中的视图指向这里与 m_body */
+    std::string m_storage;
+    std::vector<HpackField> m_fields;
+    std::string m_body;
+    HttpRequest m_request;
+    const HttpHandler* m_handler { nullptr };
+    ResponseQueue::Slot m_slot;
+    /* 尚未以 DATA 帧发出的响应体 */
+    struct evbuffer* m_pending;
+    int64_t m_sendWindow { 0 };
+    size_t m_recvUnacked { 0 };
+    /* 对端已发送 END_STREAM */
+    bool m_remoteClosed { false };
+    /* 阻塞调用执行期间流被重置，调用完成后直接回收 */
+    bool m_cancelled { false };
+};
+
+Http2Session::Http2Session(const HttpConnectionOptions& Options, const HttpHandlerResolver& Resolver,
+    const HttpBlockingOffloader& Offloader, const uint64_t& ClientKey)
+        : m_options(Options)
+        , m_resolver(Resolver)
+        , m_offloader(Offloader)
+        , m_clientKey(ClientKey)
+        , m_call(std::pmr::get_default_resource())
+{
+}
+
+Http2Session::~Http2Session() = default;
+
+void Http2Session::reset()
+{
+    while (!m_streams.empty())
+        recycleStream(*m_streams.begin()->second);
+    m_sending.clear();
+    m_blockingQueue.clear();
+    m_callStream = nullptr;
+    m_call.m_request.clear();
+    m_call.m_handler = nullptr;
+    m_call.m_slot = nullptr;
+    m_headerBlock.clear();
+    m_headerStream = 0;
+    m_headerEndStream = false;
+    m_decoder.reset();
+    m_encoder.reset();
+    m_prefaceReceived = false;
+    m_lastStreamId = 0;
+    m_peerInitialWindow = HTTP2_DEFAULT_WINDOW;
+    m_peerMaxFrameSize = HTTP2_DEFAULT_FRAME_SIZE;
+    m_sendWindow = HTTP2_DEFAULT_WINDOW;
+    m_recvUnacked = 0;
+    m_handledRequests = 0;
+    m_goingAway = false;
+    m_closing = false;
+}
+
+void Http2Session::writeSettings(struct evbuffer* Output)
+{
+    const auto& options = m_options.m_http2;
+    uint8_t payload[4 * 6];
+    size_t length = 0;
+    auto add = [&payload, &length](HTTP2_SETTING Id, uint32_t Value)
+    {
+        payload[length] = static_cast<uint8_t>(static_cast<uint16_t>(Id) >> 8);
+        payload[length + 1] = static_cast<uint8_t>(Id);
+        writeUint32(payload + length + 2, Value);
+        length += 6;
+    };
+    add(HTTP2_SETTING::MAX_CONCURRENT_STREAMS, options.m_maxConcurrentStreams);
+    if (options.m_streamWindow != HTTP2_DEFAULT_WINDOW)
+        add(HTTP2_SETTING::INITIAL_WINDOW_SIZE, options.m_streamWindow);
+    if (options.m_maxFrameSize != HTTP2_DEFAULT_FRAME_SIZE)
+        add(HTTP2_SETTING::MAX_FRAME_SIZE, options.m_maxFrameSize);
+    add(HTTP2_SETTING::MAX_HEADER_LIST_SIZE, static_cast<uint32_t>(m_options.m_maxHeaderBytes));
+    writeHttp2FrameHeader(Output, length, HTTP2_FRAME::SETTINGS, 0, 0);
+    evbuffer_add(Output, payload, length);
+    /* 连接级接收窗口只能通过 WINDOW_UPDATE 放大 */
+    if (options.m_connectionWindow > HTTP2_DEFAULT_WINDOW)
+        writeWindowUpdate(Output, 0, options.m_connectionWindow - HTTP2_DEFAULT_WINDOW);
+}
+
+HTTP2_ERROR Http2Session::applySettings(const uint8_t* Payload, size_t Length)
+{
+    for (size_t i = 0; i + 6 <= Length; i += 6)
+    {
+        const auto id = static_cast<HTTP2_SETTING>((Payload[i] << 8) | Payload[i + 1]);
+        const uint32_t value = readUint32(Payload + i + 2);
+        switch (id)
+        {
+            case HTTP2_SETTING::HEADER_TABLE_SIZE:
+                m_encoder.setMaxTableSize(value);
+                break;
+            case HTTP2_SETTING::ENABLE_PUSH:
+                if (value > 1)
+                    return HTTP2_ERROR::PROTOCOL_ERROR;
+                break;
+            case HTTP2_SETTING::INITIAL_WINDOW_SIZE:
+            {
+                if (value > HTTP2_MAX_WINDOW)
+                    return HTTP2_ERROR::FLOW_CONTROL_ERROR;
+                /* 新的初始窗口按差值作用于所有已打开的流，窗口可以因此变为负数 */
+                const int64_t delta = static_cast<int64_t>(value) - m_peerInitialWindow;
+                for (auto& [streamId, stream] : m_streams)
+                {
+                    stream->m_sendWindow += delta;
+                    if (stream->m_sendWindow > HTTP2_MAX_WINDOW)
+                        return HTTP2_ERROR::FLOW_CONTROL_ERROR;
+                }
+                m_peerInitialWindow = value;
+                break;
+            }
+            case HTTP2_SETTING::MAX_FRAME_SIZE:
+                if (value < HTTP2_DEFAULT_FRAME_SIZE || value > 0xffffff)
+                    return HTTP2_ERROR::PROTOCOL_ERROR;
+                m_peerMaxFrameSize = value;
+                break;
+            default:
+                /* 服务端不推送，MAX_CONCURRENT_STREAMS 与 MAX_HEADER_LIST_SIZE 无需处理；未知设置按协议忽略 */
+                break;
+        }
+    }
+    return HTTP2_ERROR::NO_ERROR;
+}
+
+void Http2Session::start(struct evbuffer* Output)
+{
+    writeSettings(Output);
+}
+
+bool Http2Session::upgrade(const HttpRequest& Request, std::string_view Settings, struct evbuffer* Output)
+{
+    std::string payload;
+    if (!decodeBase64Url(Settings, payload) || payload.size() % 6 != 0
+        || applySettings(reinterpret_cast<const uint8_t*>(payload.data()), payload.size()) != HTTP2_ERROR::NO_ERROR)
+    {
+        reset();
+        return false;
+    }
+    /* HTTP2-Settings 中的设置视为已确认，不回复 ACK */
+    evbuffer_add(Output, SWITCHING_PROTOCOLS.data(), SWITCHING_PROTOCOLS.size());
+    writeSettings(Output);
+
+    /* 升级请求成为流 1，对端随后处于半关闭（本地）状态，只等待响应 */
+    auto& stream = acquireStream(1);
+    m_lastStreamId = 1;
+    stream.addField(":method", Request.m_method);
+    stream.addField(":path", Request.m_target);
+    stream.addField(":scheme", "http");
+    for (auto& header : Request.m_headers)
+    {
+        m_lowerName.assign(header.m_name);
+        std::transform(m_lowerName.begin(), m_lowerName.end(), m_lowerName.begin(),
+            [](char C) { return static_cast<char>(C >= 'A' && C <= 'Z' ? C - 'A' + 'a' : C); });
+        if (connectionSpecific(m_lowerName) || m_lowerName == "http2-settings" || m_lowerName == "te")
+            continue;
+        stream.addField(m_lowerName, header.m_value);
+    }
+    stream.m_body.assign(Request.m_body);
+    stream.m_remoteClosed = true;
+    if (buildRequest(stream))
+        dispatch(stream, Output);
+    else
+        resetStream(stream, HTTP2_ERROR::PROTOCOL_ERROR, Output);
+    return true;
+}
+
+CONN_ACTION Http2Session::onInput(struct evbuffer* Input, struct evbuffer* Output)
+{
+    if (!m_prefaceReceived && !m_closing)
+    {
+        char preface[HTTP2_PREFACE.size()];
+        if (evbuffer_copyout(Input, preface, sizeof(preface)) < static_cast<ev_ssize_t>(sizeof(preface)))
+        {
+            /* 升级请求的响应不必等客户端的连接前言 */
+            flushStreams(Output);
+            return nextAction(Output, false);
+        }
+        if (memcmp(preface, HTTP2_PREFACE.data(), sizeof(preface)) != 0)
+            connectionError(HTTP2_ERROR::PROTOCOL_ERROR, Output);
+        else
+            evbuffer_drain(Input, sizeof(preface));
+        m_prefaceReceived = true;
+    }
+
+    bool paused = false;
+    while (!m_closing)
+    {
+        /* 对端不读取时停止处理后续帧，未处理的数据留在输入缓冲区中 */
+        if (evbuffer_get_length(Output) >= m_options.m_outputHighWater)
+        {
+            paused = true;
+            break;
+        }
+        uint8_t header[HTTP2_FRAME_HEADER_SIZE];
+        if (evbuffer_copyout(Input, header, sizeof(header)) < static_cast<ev_ssize_t>(sizeof(header)))
+            break;
+        const size_t length = (static_cast<size_t>(header[0]) << 16) | (static_cast<size_t>(header[1]) << 8) | header[2];
+        if (length > m_options.m_http2.m_maxFrameSize)
+        {
+            connectionError(HTTP2_ERROR::FRAME_SIZE_ERROR, Output);
+            break;
+        }
+        const size_t total = sizeof(header) + length;
+        if (evbuffer_get_length(Input) < total)
+            break;
+        /* 帧负载不超过 m_maxFrameSize，pullup 的拷贝量有限 */
+        const uint8_t* frame = evbuffer_pullup(Input, static_cast<ev_ssize_t>(total));
+        processFrame(static_cast<HTTP2_FRAME>(header[3]), header[4], readUint32(header + 5) & HTTP2_MAX_WINDOW,
+            frame + sizeof(header), length, Output);
+        evbuffer_drain(Input, total);
+    }
+    if (!m_closing)
+        flushStreams(Output);
+    return nextAction(Output, paused || evbuffer_get_length(Output) >= m_options.m_outputHighWater);
+}
+
+void Http2Session::processFrame(
+    HTTP2_FRAME Type, uint8_t Flags, uint32_t StreamId, const uint8_t* Payload, size_t Length, struct evbuffer* Output)
+{
+    /* 首部块必须由同一个流上连续的 CONTINUATION 帧补全，中间不能插入其他帧 */
+    if (m_headerStream != 0 && (Type != HTTP2_FRAME::CONTINUATION || StreamId != m_headerStream))
+    {
+        connectionError(HTTP2_ERROR::PROTOCOL_ERROR, Output);
+        return;
+    }
+    switch (Type)
+    {
+        case HTTP2_FRAME::DATA:
+            onData(Flags, StreamId, Payload, Length, Output);
+            break;
+        case HTTP2_FRAME::HEADERS:
+            onHeaders(Flags, StreamId, Payload, Length, Output);
+            break;
+        case HTTP2_FRAME::PRIORITY:
+            /* 不实现优先级，只校验格式 */
+            if (StreamId == 0)
+                connectionError(HTTP2_ERROR::PROTOCOL_ERROR, Output);
+            else if (Length != 5)
+                writeRstStream(Output, StreamId, HTTP2_ERROR::FRAME_SIZE_ERROR);
+            break;
+        case HTTP2_FRAME::RST_STREAM:
+            if (StreamId == 0 || StreamId > m_lastStreamId)
+            {
+                connectionError(HTTP2_ERROR::PROTOCOL_ERROR, Output);
+            }
+            else if (Length != 4)
+            {
+                connectionError(HTTP2_ERROR::FRAME_SIZE_ERROR, Output);
+            }
+            else if (auto* stream = findStream(StreamId))
+            {
+                cancelStream(*stream);
+            }
+            break;
+        case HTTP2_FRAME::SETTINGS:
+            onSettings(Flags, StreamId, Payload, Length, Output);
+            break;
+        case HTTP2_FRAME::PING:
+            if (StreamId != 0)
+            {
+                connectionError(HTTP2_ERROR::PROTOCOL_ERROR, Output);
+            }
+            else if (Length != 8)
+            {
+                connectionError(HTTP2_ERROR::FRAME_SIZE_ERROR, Output);
+            }
+            else if ((Flags & HTTP2_FLAG_ACK) == 0)
+            {
+                writeHttp2FrameHeader(Output, Length, HTTP2_FRAME::PING, HTTP2_FLAG_ACK, 0);
+                evbuffer_add(Output, Payload, Length);
+            }
+            break;
+        case HTTP2_FRAME::GOAWAY:
+            if (StreamId != 0)
+                connectionError(HTTP2_ERROR::PROTOCOL_ERROR, Output);
+            else if (Length < 8)
+                connectionError(HTTP2_ERROR::FRAME_SIZE_ERROR, Output);
+            else
+                m_goingAway = true;
+            break;
+        case HTTP2_FRAME::WINDOW_UPDATE:
+            onWindowUpdate(StreamId, Payload, Length, Output);
+            break;
+        case HTTP2_FRAME::CONTINUATION:
+            if (m_headerStream == 0)
+            {
+                connectionError(HTTP2_ERROR::PROTOCOL_ERROR, Output);
+                break;
+            }
+            m_headerBlock.append(reinterpret_cast<const char*>(Payload), Length);
+            /* 首部块无法流式解码，必须整体缓存，超过首部上限数倍的块直接拒绝 */
+            if (m_headerBlock.size() > std::max<size_t>(4 * m_options.m_maxHeaderBytes, 64 * 1024))
+            {
+                connectionError(HTTP2_ERROR::ENHANCE_YOUR_CALM, Output);
+                break;
+            }
+            if (Flags & HTTP2_FLAG_END_HEADERS)
+                onHeaderBlockEnd(Output);
+            break;
+        case HTTP2_FRAME::PUSH_PROMISE:
+            /* 客户端不能推送 */
+            connectionError(HTTP2_ERROR::PROTOCOL_ERROR, Output);
+            break;
+        default:
+            /* 未知类型的帧按协议忽略 */
+            break;
+    }
+}
+
+void Http2Session::onData(uint8_t Flags, uint32_t StreamId, const uint8_t* Payload, size_t Length, struct evbuffer* Output)
+{
+    const size_t frameLength = Length;
+    if (StreamId == 0 || !stripPadding(Flags, Payload, Length))
+    {
+        connectionError(HTTP2_ERROR::PROTOCOL_ERROR, Output);
+        return;
+    }
+    /* 连接级窗口按整个负载（含填充）计算，包括随后被丢弃的帧 */
+    m_recvUnacked += frameLength;
+    if (m_recvUnacked >= m_options.m_http2.m_connectionWindow / 2)
+    {
+        writeWindowUpdate(Output, 0, static_cast<uint32_t>(m_recvUnacked));
+        m_recvUnacked = 0;
+    }
+
+    auto* stream = findStream(StreamId);
+    if (stream == nullptr)
+    {
+        /* 已关闭或已重置的流上仍在途中的数据直接丢弃 */
+        if (StreamId > m_lastStreamId)
+            connectionError(HTTP2_ERROR::PROTOCOL_ERROR, Output);
+        return;
+    }
+    if (stream->m_remoteClosed)
+    {
+        resetStream(*stream, HTTP2_ERROR::STREAM_CLOSED, Output);
+        return;
+    }
+    if (stream->m_body.size() + Length > m_options.m_maxBodyBytes)
+    {
+        respondError(*stream, 413, Output);
+        return;
+    }
+    stream->m_body.append(reinterpret_cast<const char*>(Payload), Length);
+    if (Flags & HTTP2_FLAG_END_STREAM)
+    {
+        stream->m_remoteClosed = true;
+        dispatch(*stream, Output);
+        return;
+    }
+    stream->m_recvUnacked += frameLength;
+    if (stream->m_recvUnacked >= m_options.m_http2.m_streamWindow / 2)
+    {
+        writeWindowUpdate(Output, StreamId, static_cast<uint32_t>(stream->m_recvUnacked));
+        stream->m_recvUnacked = 0;
+    }
+}
+
+void Http2Session::onHeaders(uint8_t Flags, uint32_t StreamId, const uint8_t* Payload, size_t Length, struct evbuffer* Output)
+{
+    if (StreamId == 0 || (StreamId & 1) == 0 || !stripPadding(Flags, Payload, Length))
+    {
+        connectionError(HTTP2_ERROR::PROTOCOL_ERROR, Output);
+        return;
+    }
+    if (Flags & HTTP2_FLAG_PRIORITY)
+    {
+        if (Length < 5)
+        {
+            connectionError(HTTP2_ERROR::PROTOCOL_ERROR, Output);
+            return;
+        }
+        Payload += 5;
+        Length -= 5;
+    }
+    m_headerBlock.assign(reinterpret_cast<const char*>(Payload), Length);
+    m_headerStream = StreamId;
+    m_headerEndStream = (Flags & HTTP2_FLAG_END_STREAM) != 0;
+    if (Flags & HTTP2_FLAG_END_HEADERS)
+        onHeaderBlockEnd(Output);
+}
+
+void Http2Session::onHeaderBlockEnd(struct evbuffer* Output)
+{
+    const uint32_t streamId = m_headerStream;
+    m_headerStream = 0;
+
+    auto* stream = findStream(streamId);
+    if (stream != nullptr || streamId <= m_lastStreamId)
+    {
+        /* trailer 或已关闭流上的首部块：先解码以保持动态表同步，内容丢弃 */
+        m_trailerStorage.clear();
+        m_trailerFields.clear();
+        const bool decoded = m_decoder.decode(m_headerBlock, m_trailerStorage, m_trailerFields, m_options.m_maxHeaderBytes);
+        if (m_trailerStorage.capacity() > RETAINED_HEADER_CAPACITY)
+            std::string().swap(m_trailerStorage);
+        if (!decoded)
+        {
+            connectionError(HTTP2_ERROR::COMPRESSION_ERROR, Output);
+            return;
+        }
+        /* RFC 9113 5.1：已关闭的流上收到 HEADERS 是连接级的 STREAM_CLOSED */
+        if (stream == nullptr)
+        {
+            connectionError(HTTP2_ERROR::STREAM_CLOSED, Output);
+            return;
+        }
+        if (m_decoder.lastBlockSize() > m_options.m_maxHeaderBytes)
+        {
+            connectionError(HTTP2_ERROR::ENHANCE_YOUR_CALM, Output);
+            return;
+        }
+        if (stream->m_remoteClosed || !m_headerEndStream)
+        {
+            resetStream(*stream, stream->m_remoteClosed ? HTTP2_ERROR::STREAM_CLOSED : HTTP2_ERROR::PROTOCOL_ERROR, Output);
+            return;
+        }
+        stream->m_remoteClosed = true;
+        dispatch(*stream, Output);
+        return;
+    }
+
+    m_lastStreamId = streamId;
+    auto& created = acquireStream(streamId);
+    if (!m_decoder.decode(m_headerBlock, created.m_storage, created.m_fields, m_options.m_maxHeaderBytes))
+    {
+        recycleStream(created);
+        connectionError(HTTP2_ERROR::COMPRESSION_ERROR, Output);
+        return;
+    }
+    /* 已发出 GOAWAY 后的新流不处理，对端可以在新连接上重试 */
+    if (m_goingAway)
+    {
+        recycleStream(created);
+        return;
+    }
+    if (m_streams.size() > m_options.m_http2.m_maxConcurrentStreams)
+    {
+        resetStream(created, HTTP2_ERROR::REFUSED_STREAM, Output);
+        return;
+    }
+    created.m_remoteClosed = m_headerEndStream;
+    if (m_decoder.lastBlockSize() > m_options.m_maxHeaderBytes)
+    {
+        respondError(created, 431, Output);
+        return;
+    }
+    if (!buildRequest(created))
+    {
+        resetStream(created, HTTP2_ERROR::PROTOCOL_ERROR, Output);
+        return;
+    }
+    if (created.m_remoteClosed)
+        dispatch(created, Output);
+}
+
+void Http2Session::onSettings(uint8_t Flags, uint32_t StreamId, const uint8_t* Payload, size_t Length, struct evbuffer* Output)
+{
+    if (StreamId != 0)
+    {
+        connectionError(HTTP2_ERROR::PROTOCOL_ERROR, Output);
+        return;
+    }
+    if (Flags & HTTP2_FLAG_ACK)
+    {
+        if (Length != 0)
+            connectionError(HTTP2_ERROR::FRAME_SIZE_ERROR, Output);
+        return;
+    }
+    if (Length % 6 != 0)
+    {
+        connectionError(HTTP2_ERROR::FRAME_SIZE_ERROR, Output);
+        return;
+    }
+    auto error = applySettings(Payload, Length);
+    if (error != HTTP2_ERROR::NO_ERROR)
+    {
+        connectionError(error, Output);
+        return;
+    }
+    writeHttp2FrameHeader(Output, 0, HTTP2_FRAME::SETTINGS, HTTP2_FLAG_ACK, 0);
+}
+
+void Http2Session::onWindowUpdate(uint32_t StreamId, const uint8_t* Payload, size_t Length, struct evbuffer* Output)
+{
+    if (Length != 4)
+    {
+        connectionError(HTTP2_ERROR::FRAME_SIZE_ERROR, Output);
+        return;
+    }
+    const uint32_t increment = readUint32(Payload) & HTTP2_MAX_WINDOW;
+    if (StreamId == 0)
+    {
+        m_sendWindow += increment;
+        if (increment == 0)
+            connectionError(HTTP2_ERROR::PROTOCOL_ERROR, Output);
+        else if (m_sendWindow > HTTP2_MAX_WINDOW)
+            connectionError(HTTP2_ERROR::FLOW_CONTROL_ERROR, Output);
+        return;
+    }
+    auto* stream = findStream(StreamId);
+    if (stream == nullptr)
+    {
+        if (StreamId > m_lastStreamId)
+            connectionError(HTTP2_ERROR::PROTOCOL_ERROR, Output);
+        return;
+    }
+    stream->m_sendWindow += increment;
+    if (increment == 0)
+        resetStream(*stream, HTTP2_ERROR::PROTOCOL_ERROR, Output);
+    else if (stream->m_sendWindow > HTTP2_MAX_WINDOW)
+        resetStream(*stream, HTTP2_ERROR::FLOW_CONTROL_ERROR, Output);
+}
+
+Http2Session::Stream* Http2Session::findStream(uint32_t StreamId)
+{
+    auto it = m_streams.find(StreamId);
+    if (it == m_streams.end() || it->second->m_cancelled)
+        return nullptr;
+    return it->second.get();
+}
+
+Http2Session::Stream& Http2Session::acquireStream(uint32_t StreamId)
+{
+    std::unique_ptr<Stream> stream;
+    if (m_freeStreams.empty())
+    {
+        stream = std::make_unique<Stream>();
+    }
+    else
+    {
+        stream = std::move(m_freeStreams.back());
+        m_freeStreams.pop_back();
+    }
+    stream->m_id = StreamId;
+    stream->m_sendWindow = m_peerInitialWindow;
+    auto& created = *stream;
+    m_streams.emplace(StreamId, std::move(stream));
+    return created;
+}
+
+void Http2Session::recycleStream(Stream& Target)
+{
+    auto it = m_streams.find(Target.m_id);
+    auto stream = std::move(it->second);
+    m_streams.erase(it);
+    if (stream->m_storage.capacity() > RETAINED_HEADER_CAPACITY)
+        std::string().swap(stream->m_storage);
+    else
+        stream->m_storage.clear();
+    stream->m_fields.clear();
+    if (stream->m_body.capacity() > RETAINED_BODY_CAPACITY)
+        std::string().swap(stream->m_body);
+    else
+        stream->m_body.clear();
+    stream->m_request.clear();
+    stream->m_handler = nullptr;
+    stream->m_slot.m_response.reset();
+    evbuffer_drain(stream->m_pending, evbuffer_get_length(stream->m_pending));
+    stream->m_recvUnacked = 0;
+    stream->m_remoteClosed = false;
+    stream->m_cancelled = false;
+    m_freeStreams.push_back(std::move(stream));
+}
+
+bool Http2Session::buildRequest(Stream& Target)
+{
+    auto& request = Target.m_request;
+    request.clear();
+    std::string_view authority;
+    std::string_view scheme;
+    bool regular = false;
+    for (auto& field : Target.m_fields)
+    {
+        auto name = Target.field(field.m_nameOffset, field.m_nameLength);
+        auto value = Target.field(field.m_valueOffset, field.m_valueLength);
+        if (name.empty())
+            return false;
+        if (name.front() == ':')
+        {
+            /* 伪首部必须位于普通首部之前 */
+            if (regular)
+                return false;
+            if (name == ":method")
+                request.m_method = value;
+            else if (name == ":path")
+                request.m_target = value;
+            else if (name == ":authority")
+                authority = value;
+            else if (name == ":scheme")
+                scheme = value;
+            else
+                return false;
+            continue;
+        }
+        regular = true;
+        if (connectionSpecific(name) || std::any_of(name.begin(), name.end(), [](char C) { return C >= 'A' && C <= 'Z'; }))
+            return false;
+        request.m_headers.push_back({ name, value });
+    }
+    if (request.m_method.empty() || request.m_target.empty() || scheme.empty())
+        return false;
+    if (!authority.empty() && request.header("Host").empty())
+        request.m_headers.push_back({ "host", authority });
+    auto question = request.m_target.find('?');
+    request.m_path = request.m_target.substr(0, question);
+    if (question != std::string_view::npos)
+        request.m_query = request.m_target.substr(question + 1);
+    return true;
+}
+
+void Http2Session::dispatch(Stream& Target, struct evbuffer* Output)
+{
+    auto& request = Target.m_request;
+    request.m_body = Target.m_body;
+    auto& slot = Target.m_slot;
+    auto& response = slot.m_response;
+    slot.m_headOnly = request.m_method == "HEAD";
+    auto* limiter = m_options.m_rateLimiter;
+    Target.m_handler = limiter != nullptr && !limiter->allowRequest(request, m_clientKey) ? &rateLimitedHandler()
+                                                                                          : m_resolver(request);
+    const auto* handler = Target.m_handler;
+    if (!handler->m_handler)
+    {
+        /* 只接受 WebSocket 或推送流的路由，二者都只在 HTTP/1.1 上提供 */
+        response.setStatus(handler->m_webSocket != nullptr ? 426 : 505);
+        respond(Target, Output);
+        return;
+    }
+    auto* cache = m_options.m_responseCache;
+    const bool cached = cache != nullptr && cache->lookup(request, &handler->m_handler, response);
+    if (!cached && handler->m_mode == HANDLER_MODE::BLOCKING && m_offloader)
+    {
+        m_blockingQueue.push_back(&Target);
+        startBlocking(Output);
+        return;
+    }
+    if (!cached)
+    {
+        handler->m_handler(request, response);
+        if (cache != nullptr)
+            cache->store(request, &handler->m_handler, response);
+    }
+    if (m_options.m_compressor != nullptr)
+        m_options.m_compressor->apply(request, &handler->m_handler, response);
+    respond(Target, Output);
+}
+
+void Http2Session::startBlocking(struct evbuffer* Output)
+{
+    auto* limiter = m_options.m_limiter;
+    while (m_callStream == nullptr && !m_blockingQueue.empty())
+    {
+        auto& stream = *m_blockingQueue.front();
+        m_blockingQueue.pop_front();
+        if (limiter != nullptr && !limiter->tryAcquire())
+        {
+            /* 线程池已过载，立即拒绝，继续看队列中的下一个流 */
+            if (!m_closing)
+            {
+                setOverloaded(stream.m_slot.m_response);
+                respond(stream, Output);
+            }
+            continue;
+        }
+        m_callStream = &stream;
+        /* 流的首部与请求体在流回收之前不会移动，不需要像 HTTP/1.1 那样拷贝报文 */
+        m_call.m_request = stream.m_request;
+        m_call.m_handler = &stream.m_handler->m_handler;
+        m_call.m_slot = &stream.m_slot;
+        m_call.m_limiter = limiter;
+        m_call.m_admitted = std::chrono::steady_clock::now();
+        m_offloader(m_call);
+    }
+}
+
+CONN_ACTION Http2Session::onBlockingDone(struct evbuffer* Input, struct evbuffer* Output)
+{
+    auto& stream = *m_callStream;
+    m_callStream = nullptr;
+    if (stream.m_cancelled)
+    {
+        recycleStream(stream);
+    }
+    else if (!m_closing)
+    {
+        auto& response = stream.m_slot.m_response;
+        if (m_options.m_responseCache != nullptr)
+            m_options.m_responseCache->store(m_call.m_request, m_call.m_handler, response);
+        if (m_options.m_compressor != nullptr)
+            m_options.m_compressor->apply(m_call.m_request, m_call.m_handler, response);
+        respond(stream, Output);
+    }
+    m_call.m_request.clear();
+    m_call.m_slot = nullptr;
+    startBlocking(Output);
+    return onInput(Input, Output);
+}
+
+void Http2Session::respond(Stream& Target, struct evbuffer* Output)
+{
+    auto& response = Target.m_slot.m_response;
+    const int status = response.status();
+    m_encoded.clear();
+    m_encoder.beginBlock(m_encoded);
+    m_encoder.encodeStatus(status, m_encoded);
+    auto headers = response.serializedHeaders();
+    while (!headers.empty())
+    {
+        auto end = headers.find("\r\n");
+        auto line = headers.substr(0, end);
+        headers.remove_prefix(end == std::string_view::npos ? headers.size() : end + 2);
+        auto colon = line.find(':');
+        if (colon == std::string_view::npos || colon == 0)
+            continue;
+        /* HTTP/2 的首部名必须小写 */
+        m_lowerName.assign(line.substr(0, colon));
+        std::transform(m_lowerName.begin(), m_lowerName.end(), m_lowerName.begin(),
+            [](char C) { return static_cast<char>(C >= 'A' && C <= 'Z' ? C - 'A' + 'a' : C); });
+        if (connectionSpecific(m_lowerName) || m_lowerName == "content-length")
+            continue;
+        m_encoder.encode(m_lowerName, trim(line.substr(colon + 1)), m_encoded);
+    }
+    /* 与 HTTP/1.1 一样，1xx、204 与 304 不带消息体；HEAD 声明完整长度但不发送 */
+    const bool noBody = status < 200 || status == 204 || status == 304;
+    const size_t bodyLength = response.bodyLength();
+    if (!noBody)
+    {
+        char length[24];
+        int len = snprintf(length, sizeof(length), "%zu", bodyLength);
+        m_encoder.encode("content-length", std::string_view(length, static_cast<size_t>(len)), m_encoded);
+    }
+    const bool endStream = noBody || Target.m_slot.m_headOnly || bodyLength == 0;
+    writeHeaderBlock(Target.m_id, endStream, Output);
+    m_handledRequests++;
+    if (endStream)
+    {
+        response.reset();
+        closeStream(Target, Output);
+    }
+    else
+    {
+        response.takeBody(Target.m_pending);
+        response.reset();
+        m_sending.push_back(&Target);
+    }
+    if (!m_goingAway && m_handledRequests >= m_options.m_maxKeepAliveRequests)
+        goAway(HTTP2_ERROR::NO_ERROR, Output);
+}
+
+void Http2Session::writeHeaderBlock(uint32_t StreamId, bool EndStream, struct evbuffer* Output)
+{
+    size_t offset = 0;
+    bool first = true;
+    do
+    {
+        const size_t length = std::min<size_t>(m_encoded.size() - offset, m_peerMaxFrameSize);
+        uint8_t flags = offset + length == m_encoded.size() ? HTTP2_FLAG_END_HEADERS : 0;
+        if (first && EndStream)
+            flags |= HTTP2_FLAG_END_STREAM;
+        writeHttp2FrameHeader(Output, length, first ? HTTP2_FRAME::HEADERS : HTTP2_FRAME::CONTINUATION, flags, StreamId);
+        evbuffer_add(Output, m_encoded.data() + offset, length);
+        offset += length;
+        first = false;
+    } while (offset < m_encoded.size());
+}
+
+void Http2Session::respondError(Stream& Target, int Code, struct evbuffer* Output)
+{
+    auto& slot = Target.m_slot;
+    slot.m_response.reset();
+    slot.m_response.setStatus(Code);
+    slot.m_headOnly = false;
+    respond(Target, Output);
+}
+
+void Http2Session::closeStream(Stream& Target, struct evbuffer* Output)
+{
+    /* 请求还没发完就已回复完毕，通知对端停止发送 */
+    if (!Target.m_remoteClosed)
+        writeRstStream(Output, Target.m_id, HTTP2_ERROR::NO_ERROR);
+    recycleStream(Target);
+}
+
+void Http2Session::resetStream(Stream& Target, HTTP2_ERROR Code, struct evbuffer* Output)
+{
+    writeRstStream(Output, Target.m_id, Code);
+    cancelStream(Target);
+}
+
+void Http2Session::cancelStream(Stream& Target)
+{
+    auto sending = std::find(m_sending.begin(), m_sending.end(), &Target);
+    if (sending != m_sending.end())
+        m_sending.erase(sending);
+    auto queued = std::find(m_blockingQueue.begin(), m_blockingQueue.end(), &Target);
+    if (queued != m_blockingQueue.end())
+        m_blockingQueue.erase(queued);
+    /* 线程池仍在使用流中的请求与响应，等完成回调再回收 */
+    if (&Target == m_callStream)
+        Target.m_cancelled = true;
+    else
+        recycleStream(Target);
+}
+
+void Http2Session::goAway(HTTP2_ERROR Code, struct evbuffer* Output)
+{
+    uint8_t payload[8];
+    writeUint32(payload, m_lastStreamId);
+    writeUint32(payload + 4, static_cast<uint32_t>(Code));
+    writeHttp2FrameHeader(Output, sizeof(payload), HTTP2_FRAME::GOAWAY, 0, 0);
+    evbuffer_add(Output, payload, sizeof(payload));
+    m_goingAway = true;
+}
+
+void Http2Session::connectionError(HTTP2_ERROR Code, struct evbuffer* Output)
+{
+    spdlog::warn("{} error[{}] last stream[{}]", __FUNCTION__, static_cast<uint32_t>(Code), m_lastStreamId);
+    goAway(Code, Output);
+    m_closing = true;
+    m_headerStream = 0;
+}
+
+void Http2Session::flushStreams(struct evbuffer* Output)
+{
+    /* 每轮给每个流发一帧，多个大响应交错发送，不会由第一个流独占连接窗口 */
+    bool progress = true;
+    while (progress && !m_sending.empty() && m_sendWindow > 0)
+    {
+        progress = false;
+        for (size_t i = 0; i < m_sending.size() && m_sendWindow > 0;)
+        {
+            if (evbuffer_get_length(Output) >= m_options.m_outputHighWater)
+                return;
+            auto& stream = *m_sending[i];
+            if (stream.m_sendWindow <= 0)
+            {
+                i++;
+                continue;
+            }
+            const size_t pending = evbuffer_get_length(stream.m_pending);
+            const size_t length = std::min({ pending, static_cast<size_t>(m_peerMaxFrameSize),
+                static_cast<size_t>(m_sendWindow), static_cast<size_t>(stream.m_sendWindow) });
+            const bool last = length == pending;
+            writeHttp2FrameHeader(Output, length, HTTP2_FRAME::DATA, last ? HTTP2_FLAG_END_STREAM : 0, stream.m_id);
+            evbuffer_remove_buffer(stream.m_pending, Output, length);
+            m_sendWindow -= static_cast<int64_t>(length);
+            stream.m_sendWindow -= static_cast<int64_t>(length);
+            progress = true;
+            if (last)
+            {
+                m_sending.erase(m_sending.begin() + static_cast<std::ptrdiff_t>(i));
+                closeStream(stream, Output);
+            }
+            else
+            {
+                i++;
+            }
+        }
+    }
+}
+
+CONN_ACTION Http2Session::nextAction(struct evbuffer* Output, bool Paused) const
+{
+    if (m_closing || (m_goingAway && m_streams.empty()))
+        return blocked() ? CONN_ACTION::PAUSE_READING : CONN_ACTION::CLOSE_AFTER_WRITE;
+    return Paused ? CONN_ACTION::PAUSE_READING : CONN_ACTION::KEEP_READING;
+}
+
+DEADLINE Http2Session::pendingDeadline(struct evbuffer* Input, struct evbuffer* Output) const
+{
+    /* 响应体因对端窗口耗尽而积压，同样视为对端不读取 */
+    if (evbuffer_get_length(Output) > 0 || !m_sending.empty())
+        return DEADLINE::WRITE;
+    if (blocked())
+        return DEADLINE::NONE;
+    for (auto& [streamId, stream] : m_streams)
+    {
+        if (!stream->m_remoteClosed)
+            return DEADLINE::BODY_READ;
+    }
+    return evbuffer_get_length(Input) > 0 ? DEADLINE::HEADER_READ : DEADLINE::IDLE;
+}
+}   // namespace ToolKit
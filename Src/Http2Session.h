@@ -0,0 +1,215 @@
+#pragma once
+
+#include "Hpack.h"
+#include "HttpConnection.h"
+#include "ResponseQueue.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+struct evbuffer;
+
+namespace ToolKit
+{
+/* 客户端连接前言，以先验知识建立 h2c 时出现在连接的最开头 */
+constexpr std::string_view HTTP2_PREFACE = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+constexpr size_t HTTP2_FRAME_HEADER_SIZE = 9;
+constexpr uint32_t HTTP2_DEFAULT_WINDOW = 65535;
+constexpr uint32_t HTTP2_MAX_WINDOW = 0x7fffffff;
+constexpr uint32_t HTTP2_DEFAULT_FRAME_SIZE = 16384;
+
+enum class HTTP2_FRAME : uint8_t
+{
+    DATA = 0,
+    HEADERS = 1,
+    PRIORITY = 2,
+    RST_STREAM = 3,
+    SETTINGS = 4,
+    PUSH_PROMISE = 5,
+    PING = 6,
+    GOAWAY = 7,
+    WINDOW_UPDATE = 8,
+    CONTINUATION = 9
+};
+
+/* 帧标志位，同一数值在不同帧类型中含义不同 */
+constexpr uint8_t HTTP2_FLAG_END_STREAM = 0x1;
+constexpr uint8_t HTTP2_FLAG_ACK = 0x1;
+constexpr uint8_t HTTP2_FLAG_END_HEADERS = 0x4;
+constexpr uint8_t HTTP2_FLAG_PADDED = 0x8;
+constexpr uint8_t HTTP2_FLAG_PRIORITY = 0x20;
+
+enum class HTTP2_SETTING : uint16_t
+{
+    HEADER_TABLE_SIZE = 1,
+    ENABLE_PUSH = 2,
+    MAX_CONCURRENT_STREAMS = 3,
+    INITIAL_WINDOW_SIZE = 4,
+    MAX_FRAME_SIZE = 5,
+    MAX_HEADER_LIST_SIZE = 6
+};
+
+enum class HTTP2_ERROR : uint32_t
+{
+    NO_ERROR = 0,
+    PROTOCOL_ERROR = 1,
+    INTERNAL_ERROR = 2,
+    FLOW_CONTROL_ERROR = 3,
+    SETTINGS_TIMEOUT = 4,
+    STREAM_CLOSED = 5,
+    FRAME_SIZE_ERROR = 6,
+    REFUSED_STREAM = 7,
+    CANCEL = 8,
+    COMPRESSION_ERROR = 9,
+    CONNECT_ERROR = 10,
+    ENHANCE_YOUR_CALM = 11
+};
+
+/**
+ * @brief 向 Output 写入 9 字节帧头
+ */
+void writeHttp2FrameHeader(struct evbuffer* Output, size_t Length, HTTP2_FRAME Type, uint8_t Flags, uint32_t StreamId);
+
+/**
+ * @brief 一个 h2c 连接的协议状态，由 HttpConnection 在收到连接前言或 Upgrade: h2c 请求后接管
+ * 与 HttpConnection 一样只在输入、输出两个 evbuffer 上工作：一次 onInput 处理输入中所有完整的帧，
+ * 请求在其流收齐后立即分发，处理函数、响应缓存与压缩的使用方式与 HTTP/1.1 相同；本轮产生的
+ * SETTINGS/PING 应答、WINDOW_UPDATE、响应的 HEADERS 与 DATA 帧都追加在输出缓冲区中，由事件循环一次 writev 发出。
+ * 响应体按流轮转切分成 DATA 帧，受连接级与流级发送窗口约束；窗口耗尽的流留在发送队列中，
+ * 等对端的 WINDOW_UPDATE 到达后继续。输出积压超过高水位时停止处理输入与发送，等待对端读走数据。
+ * 接收方向上收到的请求体计入窗口后立即补充，请求体大小由 m_maxBodyBytes 限制。
+ * 阻塞处理函数同一时刻只有一个在线程池中执行（连接对象只跟踪一个 BlockingCall），其余排队；
+ * 排队期间其他流的帧照常处理，内联处理函数的流不受影响。
+ * 流对象连同其首部存储、响应对象与待发送缓冲区在流结束后回收复用。
+ */
+class Http2Session
+{
+public:
+    /**
+     * @brief ClientKey 是连接对端地址的限速键，由连接持有并在连接复用时更新
+     */
+    Http2Session(const HttpConnectionOptions& Options, const HttpHandlerResolver& Resolver, const HttpBlockingOffloader& Offloader,
+        const uint64_t& ClientKey);
+    ~Http2Session();
+    Http2Session(const Http2Session&) = delete;
+    const Http2Session& operator=(const Http2Session&) = delete;
+
+    /**
+     * @brief 以先验知识开始：发送本端 SETTINGS，等待输入中的客户端连接前言
+     */
+    void start(struct evbuffer* Output);
+
+    /**
+     * @brief 从 HTTP/1.1 升级：Settings 为 HTTP2-Settings 首部的值，格式非法时返回 false 且不做任何输出
+     * 成功时依次写出 101 响应与本端 SETTINGS，并把 Request 拷贝为流 1 的请求处理，之后 Request 可以释放。
+     */
+    bool upgrade(const HttpRequest& Request, std::string_view Settings, struct evbuffer* Output);
+
+    CONN_ACTION onInput(struct evbuffer* Input, struct evbuffer* Output);
+
+    /**
+     * @brief 阻塞调用完成后在事件循环线程上调用
+     */
+    CONN_ACTION onBlockingDone(struct evbuffer* Input, struct evbuffer* Output);
+
+    bool blocked() const { return m_callStream != nullptr; }
+
+    DEADLINE pendingDeadline(struct evbuffer* Input, struct evbuffer* Output) const;
+
+    /**
+     * @brief 已发出响应的流数
+     */
+    size_t handledRequests() const { return m_handledRequests; }
+
+    /**
+     * @brief 当前打开的流数
+     */
+    size_t activeStreams() const { return m_streams.size(); }
+
+    /**
+     * @brief 恢复初始状态以便随连接对象复用，保留流对象与各缓冲区
+     */
+    void reset();
+
+private:
+    struct Stream;
+
+    void writeSettings(struct evbuffer* Output);
+    HTTP2_ERROR applySettings(const uint8_t* Payload, size_t Length);
+    void processFrame(HTTP2_FRAME Type, uint8_t Flags, uint32_t StreamId, const uint8_t* Payload, size_t Length,
+        struct evbuffer* Output);
+    void onData(uint8_t Flags, uint32_t StreamId, const uint8_t* Payload, size_t Length, struct evbuffer* Output);
+    void onHeaders(uint8_t Flags, uint32_t StreamId, const uint8_t* Payload, size_t Length, struct evbuffer* Output);
+    void onHeaderBlockEnd(struct evbuffer* Output);
+    void onSettings(uint8_t Flags, uint32_t StreamId, const uint8_t* Payload, size_t Length, struct evbuffer* Output);
+    void onWindowUpdate(uint32_t StreamId, const uint8_t* Payload, size_t Length, struct evbuffer* Output);
+
+    Stream* findStream(uint32_t StreamId);
+    Stream& acquireStream(uint32_t StreamId);
+    void recycleStream(Stream& Target);
+    bool buildRequest(Stream& Target);
+    void dispatch(Stream& Target, struct evbuffer* Output);
+    /**
+     * @brief 没有进行中的阻塞调用时取出队列中的下一个流交给 Offloader，并发限制已满的流直接回复 503
+     */
+    void startBlocking(struct evbuffer* Output);
+    void respond(Stream& Target, struct evbuffer* Output);
+    void writeHeaderBlock(uint32_t StreamId, bool EndStream, struct evbuffer* Output);
+    void respondError(Stream& Target, int Code, struct evbuffer* Output);
+    void closeStream(Stream& Target, struct evbuffer* Output);
+    void resetStream(Stream& Target, HTTP2_ERROR Code, struct evbuffer* Output);
+    void cancelStream(Stream& Target);
+    void connectionError(HTTP2_ERROR Code, struct evbuffer* Output);
+    void goAway(HTTP2_ERROR Code, struct evbuffer* Output);
+    void flushStreams(struct evbuffer* Output);
+    CONN_ACTION nextAction(struct evbuffer* Output, bool Paused) const;
+
+    const HttpConnectionOptions& m_options;
+    const HttpHandlerResolver& m_resolver;
+    const HttpBlockingOffloader& m_offloader;
+    const uint64_t& m_clientKey;
+
+    HpackDecoder m_decoder;
+    HpackEncoder m_encoder;
+
+    std::unordered_map<uint32_t, std::unique_ptr<Stream>> m_streams;
+    std::vector<std::unique_ptr<Stream>> m_freeStreams;
+    /* 响应体尚未发完的流，按轮转顺序发送 */
+    std::vector<Stream*> m_sending;
+    /* 等待线程池的阻塞请求，以及正在执行的一个 */
+    std::deque<Stream*> m_blockingQueue;
+    Stream* m_callStream { nullptr };
+    BlockingCall m_call;
+
+    /* 跨 CONTINUATION 帧拼接的首部块 */
+    std::string m_headerBlock;
+    uint32_t m_headerStream { 0 };
+    bool m_headerEndStream { false };
+    /* 首部编码与首部名小写化的临时空间 */
+    std::string m_encoded;
+    std::string m_lowerName;
+    /* 丢弃的 trailer 字段 */
+    std::string m_trailerStorage;
+    std::vector<HpackField> m_trailerFields;
+
+    bool m_prefaceReceived { false };
+    uint32_t m_lastStreamId { 0 };
+    /* 对端的设置 */
+    uint32_t m_peerInitialWindow { HTTP2_DEFAULT_WINDOW };
+    uint32_t m_peerMaxFrameSize { HTTP2_DEFAULT_FRAME_SIZE };
+    /* 连接级发送窗口与尚未通过 WINDOW_UPDATE 补充的接收字节数 */
+    int64_t m_sendWindow { HTTP2_DEFAULT_WINDOW };
+    size_t m_recvUnacked { 0 };
+    size_t m_handledRequests { 0 };
+    /* 已发送或收到 GOAWAY，不再接受新流，现有流结束后关闭连接 */
+    bool m_goingAway { false };
+    /* 连接级错误，已发送 GOAWAY，输出写完后立即关闭 */
+    bool m_closing { false };
+};
+}   // namespace ToolKit
@@ -0,0 +1,392 @@
+#include "HttpConnection.h"
+
+#include "EventStream.h"
+#include "Http2Session.h"
+#include "HttpCoroutine.h"
+#include "RateLimiter.h"
+#include "ResponseCache.h"
+#include "ResponseCompressor.h"
+#include "WebSocket.h"
+#include "spdlog/spdlog.h"
+
+#include <cstring>
+#include <event2/buffer.h>
+#include <utility>
+
+namespace ToolKit
+{
+HttpConnection::HttpConnection(const HttpConnectionOptions& Options, const HttpHandlerResolver& Resolver,
+    HttpBlockingOffloader Offloader, HttpActionNotifier Notifier, HttpTimerArmer TimerArmer)
+        : m_options(Options)
+        , m_resolver(Resolver)
+        , m_offloader(std::move(Offloader))
+        , m_notifier(std::move(Notifier))
+        , m_timerArmer(std::move(TimerArmer))
+        , m_parser(Options.m_maxHeaderBytes, Options.m_maxBodyBytes)
+{
+}
+
+HttpConnection::~HttpConnection() = default;
+
+void HttpConnection::reset()
+{
+    if (m_blocked)
+        releaseBlockingCall();
+    if (m_coroutine != nullptr)
+        m_coroutine->reset();
+    m_coroutineActive = false;
+    m_parser.reset();
+    m_request.clear();
+    endRequest();
+    m_responses.clear();
+    m_handledRequests = 0;
+    m_clientKey = 0;
+    m_closing = false;
+    if (m_http2 != nullptr)
+        m_http2->reset();
+    m_http2Active = false;
+    m_prefaceChecked = false;
+    if (m_webSocket != nullptr)
+        m_webSocket->reset();
+    m_webSocketActive = false;
+    if (m_eventStream != nullptr)
+        m_eventStream->reset();
+    m_eventStreamActive = false;
+}
+
+bool HttpConnection::blocked() const
+{
+    if (m_webSocketActive || m_eventStreamActive)
+        return false;
+    return m_http2Active ? m_http2->blocked() : m_blocked;
+}
+
+size_t HttpConnection::handledRequests() const
+{
+    return m_http2Active ? m_http2->handledRequests() : m_handledRequests;
+}
+
+Http2Session& HttpConnection::http2()
+{
+    if (m_http2 == nullptr)
+        m_http2 = std::make_unique<Http2Session>(m_options, m_resolver, m_offloader, m_clientKey);
+    return *m_http2;
+}
+
+bool HttpConnection::tryUpgrade(struct evbuffer* Input, struct evbuffer* Output)
+{
+    /* 只在没有排队响应时升级，101 之前不能有其他 HTTP/1.1 响应未发出 */
+    if (!m_options.m_http2.m_enabled || m_request.m_versionMinor != 1 || !m_responses.empty())
+        return false;
+    auto settings = m_request.header("HTTP2-Settings");
+    if (settings.empty())
+        return false;
+    if (!hasToken(m_request.header("Upgrade"), "h2c") || !http2().upgrade(m_request, settings, Output))
+        return false;
+    m_parser.consume(Input, m_request);
+    endRequest();
+    m_http2Active = true;
+    return true;
+}
+
+CONN_ACTION HttpConnection::upgradeWebSocket(struct evbuffer* Input, struct evbuffer* Output, const HttpHandler& Handler)
+{
+    if (m_webSocket == nullptr)
+        m_webSocket = std::make_unique<WebSocketSession>(m_options, &m_notifier);
+    m_handledRequests++;
+    /* 101 之前的响应都已写入输出缓冲区；m_onOpen 还要读取请求，之后才能丢弃请求报文 */
+    m_webSocket->open(Handler.m_webSocket, m_request, Output);
+    m_parser.consume(Input, m_request);
+    endRequest();
+    m_webSocketActive = true;
+    return m_webSocket->onInput(Input, Output);
+}
+
+CONN_ACTION HttpConnection::openEventStream(struct evbuffer* Input, struct evbuffer* Output, const HttpHandler& Handler)
+{
+    if (m_eventStream == nullptr)
+        m_eventStream = std::make_unique<EventStreamSession>(m_options, &m_notifier);
+    m_handledRequests++;
+    m_eventStream->open(Handler.m_eventStream, m_request, Output);
+    m_parser.consume(Input, m_request);
+    endRequest();
+    m_eventStreamActive = true;
+    return m_eventStream->onInput(Input, Output);
+}
+
+CONN_ACTION HttpConnection::openCoroutine(struct evbuffer* Input, struct evbuffer* Output, const HttpHandler& Handler)
+{
+    if (m_coroutine == nullptr)
+        m_coroutine = std::make_unique<CoroutineSession>(m_options, &m_arena, &m_notifier, &m_timerArmer,
+            [this](SmallTask& Work) { return offloadTask(Work); });
+    const bool keepAlive = m_request.m_keepAlive && ++m_handledRequests < m_options.m_maxKeepAliveRequests;
+    m_coroutineActive = true;
+    /* 会话拷贝首部并从 Input 移除，请求体留给处理函数读取 */
+    auto action = m_coroutine->open(Handler.m_coroutine, m_request, m_parser, Input, Output, keepAlive);
+    m_parser.reset();
+    m_request.clear();
+    return afterCoroutine(action, Input, Output);
+}
+
+CONN_ACTION HttpConnection::afterCoroutine(CONN_ACTION Action, struct evbuffer* Input, struct evbuffer* Output)
+{
+    if (m_coroutine->running())
+        return Action;
+    m_closing = !m_coroutine->keepAlive();
+    m_coroutine->reset();
+    m_coroutineActive = false;
+    endRequest();
+    if (m_closing)
+        return CONN_ACTION::CLOSE_AFTER_WRITE;
+    return onInput(Input, Output);
+}
+
+bool HttpConnection::offloadTask(SmallTask& Work)
+{
+    if (!m_offloader)
+        return false;
+    if (!admitBlocking())
+        throw OverloadedError("blocking pool overloaded");
+    m_blockingCall->m_task = std::move(Work);
+    m_blocked = true;
+    m_offloader(*m_blockingCall);
+    return true;
+}
+
+void HttpConnection::queueError(int Code)
+{
+    auto& slot = m_responses.push(false);
+    slot.m_response.setStatus(Code);
+    slot.m_response.setKeepAlive(false);
+    m_responses.markReady(slot);
+    m_closing = true;
+}
+
+const HttpHandler* HttpConnection::resolveHandler()
+{
+    auto* limiter = m_options.m_rateLimiter;
+    if (limiter != nullptr && !limiter->allowRequest(m_request, m_clientKey))
+        return &rateLimitedHandler();
+    return m_resolver(m_request);
+}
+
+bool HttpConnection::admitBlocking()
+{
+    auto* limiter = m_options.m_limiter;
+    if (limiter != nullptr && !limiter->tryAcquire())
+        return false;
+    if (m_blockingCall == nullptr)
+        m_blockingCall = std::make_unique<BlockingCall>(&m_arena);
+    m_blockingCall->m_limiter = limiter;
+    m_blockingCall->m_admitted = std::chrono::steady_clock::now();
+    return true;
+}
+
+void HttpConnection::offload(struct evbuffer* Input, const HttpHandler& Handler, ResponseQueue::Slot& Slot)
+{
+    auto& call = *m_blockingCall;
+    /* parse 完成后整个请求报文已是 Input 头部的连续内存，pullup 不会搬移数据，拷贝一份并把视图平移过去 */
+    const auto length = m_parser.messageLength();
+    const char* base = reinterpret_cast<const char*>(evbuffer_pullup(Input, static_cast<ev_ssize_t>(length)));
+    call.m_message.assign(base, length);
+    call.m_request = m_request;
+    call.m_request.rebase(base, call.m_message.data());
+    call.m_handler = &Handler.m_handler;
+    call.m_slot = &Slot;
+    m_blocked = true;
+    m_offloader(call);
+}
+
+void HttpConnection::endRequest()
+{
+    /* 先归还指向 Arena 的容器，再整体回收 */
+    m_request.releaseStorage();
+    m_arena.reset();
+    m_handler = nullptr;
+}
+
+CONN_ACTION HttpConnection::onInput(struct evbuffer* Input, struct evbuffer* Output)
+{
+    if (m_webSocketActive)
+        return m_webSocket->onInput(Input, Output);
+    if (m_eventStreamActive)
+        return m_eventStream->onInput(Input, Output);
+    if (m_coroutineActive)
+        return afterCoroutine(m_coroutine->onInput(Input, Output), Input, Output);
+    if (m_http2Active)
+        return m_http2->onInput(Input, Output);
+    if (!m_prefaceChecked && m_options.m_http2.m_enabled)
+    {
+        /* 连接前言与任何 HTTP/1.1 请求行都不同，凑齐前言长度或出现不一致的字节即可判断 */
+        char preface[HTTP2_PREFACE.size()];
+        const auto length = evbuffer_copyout(Input, preface, sizeof(preface));
+        if (length <= 0)
+            return CONN_ACTION::KEEP_READING;
+        if (memcmp(preface, HTTP2_PREFACE.data(), static_cast<size_t>(length)) == 0)
+        {
+            if (length < static_cast<ev_ssize_t>(sizeof(preface)))
+                return CONN_ACTION::KEEP_READING;
+            auto& session = http2();
+            session.start(Output);
+            m_http2Active = true;
+            return session.onInput(Input, Output);
+        }
+        m_prefaceChecked = true;
+    }
+
+    bool paused = false;
+    while (!m_closing)
+    {
+        /* 等待阻塞调用完成，后续请求留在输入缓冲区中 */
+        if (blocked())
+            return CONN_ACTION::PAUSE_READING;
+
+        /* 对端不读取响应时停止处理后续请求，未处理的数据留在输入缓冲区中 */
+        if (evbuffer_get_length(Output) >= m_options.m_outputHighWater)
+        {
+            paused = true;
+            break;
+        }
+
+        auto status = m_parser.parseHeader(Input, m_request);
+        if (status == PARSE_STATUS::COMPLETE && m_handler == nullptr)
+        {
+            m_handler = resolveHandler();
+            /* 协程处理函数自己读取请求体，首部完整即接管；同步处理的响应每轮都已写出，此时响应队列为空 */
+            if (m_handler->m_coroutine != nullptr && !(m_handler->m_webSocket != nullptr && isWebSocketUpgrade(m_request)))
+                return openCoroutine(Input, Output, *m_handler);
+        }
+        if (status == PARSE_STATUS::COMPLETE)
+            status = m_parser.parse(Input, m_request);
+        if (status == PARSE_STATUS::NEED_MORE)
+            break;
+        if (status != PARSE_STATUS::COMPLETE)
+        {
+            spdlog::warn("{} bad request, status[{}]", __FUNCTION__, statusCodeOf(status));
+            queueError(statusCodeOf(status));
+            break;
+        }
+        if (m_handledRequests == 0 && tryUpgrade(Input, Output))
+            return m_http2->onInput(Input, Output);
+
+        const HttpHandler* handler = m_handler;
+        /* 同步处理的响应每轮都已写出，走到这里时响应队列为空 */
+        if (handler->m_webSocket != nullptr && isWebSocketUpgrade(m_request))
+            return upgradeWebSocket(Input, Output, *handler);
+        if (handler->m_eventStream != nullptr && m_request.m_method == "GET")
+            return openEventStream(Input, Output, *handler);
+
+        auto& slot = m_responses.push(m_request.m_method == "HEAD");
+        auto& response = slot.m_response;
+        response.setHttp10(m_request.m_versionMinor == 0);
+        response.setKeepAlive(m_request.m_keepAlive && ++m_handledRequests < m_options.m_maxKeepAliveRequests);
+        if (!handler->m_handler && handler->m_webSocket != nullptr)
+        {
+            /* 只接受 WebSocket 的路由收到了普通请求或不支持的版本 */
+            response.setStatus(426);
+            response.addHeader("Sec-WebSocket-Version", "13");
+            response.addHeader("Upgrade", "websocket");
+        }
+        else if (!handler->m_handler)
+        {
+            /* 只提供推送流的路由 */
+            response.setStatus(405);
+            response.addHeader("Allow", "GET");
+        }
+        else
+        {
+            auto* cache = m_options.m_responseCache;
+            const bool cached = cache != nullptr && cache->lookup(m_request, &handler->m_handler, response);
+            const bool blocking = !cached && handler->m_mode == HANDLER_MODE::BLOCKING && m_offloader;
+            if (blocking && admitBlocking())
+            {
+                offload(Input, *handler, slot);
+                m_parser.consume(Input, m_request);
+                /* 已就绪的前序响应先发出去 */
+                m_responses.flush(Output);
+                return CONN_ACTION::PAUSE_READING;
+            }
+            if (blocking)
+            {
+                /* 线程池已过载，立即拒绝比排队之后超时更省资源 */
+                setOverloaded(response);
+            }
+            else
+            {
+                if (!cached)
+                {
+                    handler->m_handler(m_request, response);
+                    if (cache != nullptr)
+                        cache->store(m_request, &handler->m_handler, response);
+                }
+                if (m_options.m_compressor != nullptr)
+                    m_options.m_compressor->apply(m_request, &handler->m_handler, response);
+            }
+        }
+        m_responses.markReady(slot);
+        /* 回复了 Connection: close 的请求之后的流水线请求全部丢弃 */
+        m_closing = !response.keepAlive();
+        m_parser.consume(Input, m_request);
+        endRequest();
+
+        /* 同步处理的响应立即进入输出缓冲区，这样上面的积压判断能看到真实的输出长度 */
+        m_responses.flush(Output);
+    }
+    m_responses.flush(Output);
+
+    if (m_closing)
+        return CONN_ACTION::CLOSE_AFTER_WRITE;
+    return paused ? CONN_ACTION::PAUSE_READING : CONN_ACTION::KEEP_READING;
+}
+
+void HttpConnection::releaseBlockingCall()
+{
+    /* BlockingCall 对象留给下一次阻塞调用复用，其中的报文与请求随 Arena 一起回收 */
+    m_blocked = false;
+    m_blockingCall->m_slot = nullptr;
+    m_blockingCall->m_task.reset();
+    std::pmr::string(m_blockingCall->m_message.get_allocator()).swap(m_blockingCall->m_message);
+    m_blockingCall->m_request.releaseStorage();
+}
+
+CONN_ACTION HttpConnection::onBlockingDone(struct evbuffer* Input, struct evbuffer* Output)
+{
+    if (m_http2Active)
+        return m_http2->onBlockingDone(Input, Output);
+    if (m_coroutineActive)
+    {
+        releaseBlockingCall();
+        return afterCoroutine(m_coroutine->onBlockingDone(), Input, Output);
+    }
+    auto& call = *m_blockingCall;
+    auto& slot = *call.m_slot;
+    if (m_options.m_responseCache != nullptr)
+        m_options.m_responseCache->store(call.m_request, call.m_handler, slot.m_response);
+    if (m_options.m_compressor != nullptr)
+        m_options.m_compressor->apply(call.m_request, call.m_handler, slot.m_response);
+    m_responses.markReady(slot);
+    m_closing = !slot.m_response.keepAlive();
+    releaseBlockingCall();
+    endRequest();
+    return onInput(Input, Output);
+}
+
+DEADLINE HttpConnection::pendingDeadline(struct evbuffer* Input, struct evbuffer* Output) const
+{
+    if (m_webSocketActive)
+        return m_webSocket->pendingDeadline(Input, Output);
+    if (m_eventStreamActive)
+        return m_eventStream->pendingDeadline(Input, Output);
+    if (m_coroutineActive)
+        return m_coroutine->pendingDeadline(Input, Output);
+    if (m_http2Active)
+        return m_http2->pendingDeadline(Input, Output);
+    if (evbuffer_get_length(Output) > 0)
+        return DEADLINE::WRITE;
+    if (m_blocked)
+        return DEADLINE::NONE;
+    if (m_parser.inBody())
+        return DEADLINE::BODY_READ;
+    return evbuffer_get_length(Input) > 0 ? DEADLINE::HEADER_READ : DEADLINE::IDLE;
+}
+}   // namespace ToolKit
@@ -0,0 +1,305 @@
+#pragma once
+
+#include "ConcurrencyLimiter.h"
+#include "HttpParser.h"
+#include "HttpResponse.h"
+#include "Infra/Arena.h"
+#include "Infra/SmallTask.h"
+#include "ResponseQueue.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <utility>
+
+struct evbuffer;
+
+namespace ToolKit
+{
+class CoroutineSession;
+class EventStreamSession;
+class Http2Session;
+class PubSub;
+class RateLimiter;
+class ResponseCache;
+class ResponseCompressor;
+class WebSocketSession;
+class WheelTimer;
+struct CoroutineHandler;
+struct EventStreamHandler;
+struct WebSocketHandler;
+
+/**
+ * @brief 请求处理函数，Request 中的视图只在函数调用期间有效
+ */
+using HttpRequestHandler = std::function<void(const HttpRequest& Request, HttpResponse& Response)>;
+
+/**
+ * @brief 处理函数的执行方式
+ * BLOCKING 的处理函数会访问慢速存储等阻塞资源，交给线程池执行，避免拖慢同一事件循环上的其他连接。
+ */
+enum class HANDLER_MODE
+{
+    INLINE,
+    BLOCKING
+};
+
+/**
+ * @brief 一个路由的处理函数；m_webSocket 不为空时该路由接受 WebSocket 升级，m_eventStream 不为空时
+ * GET 请求打开推送流。二者存在时 m_handler 可以为空，此时其余请求得到 426 或 405 响应。
+ * m_coroutine 不为空时除 WebSocket 升级外的请求都交给协程处理函数，m_handler 不再使用
+ */
+struct HttpHandler
+{
+    HttpRequestHandler m_handler;
+    HANDLER_MODE m_mode { HANDLER_MODE::INLINE };
+    std::shared_ptr<const WebSocketHandler> m_webSocket;
+    std::shared_ptr<const EventStreamHandler> m_eventStream;
+    std::shared_ptr<const CoroutineHandler> m_coroutine;
+};
+
+/**
+ * @brief 为请求选择处理函数，返回的对象须在连接存续期间保持有效；可以在 Request 中填入路径参数
+ */
+using HttpHandlerResolver = std::function<const HttpHandler*(HttpRequest& Request)>;
+
+/**
+ * @brief 交给线程池执行的一次阻塞请求处理
+ * 请求报文拷贝到连接的 Arena 上，不再引用连接的输入缓冲区；响应写入连接响应队列中预留的槽位。
+ * run 在工作线程上执行，完成后须回到连接所属的事件循环线程调用 HttpConnection::onBlockingDone。
+ * 协程处理函数 offload 的计算同样经由它交给线程池，此时只设置 m_task。
+ * 获准于 m_limiter 的调用执行完毕后在工作线程上归还名额，连接在此期间关闭也不会漏掉。
+ */
+struct BlockingCall
+{
+    explicit BlockingCall(std::pmr::memory_resource* Arena)
+            : m_message(Arena)
+            , m_request(Arena)
+    {
+    }
+
+    void run()
+    {
+        if (m_task)
+            m_task();
+        else
+            (*m_handler)(m_request, m_slot->m_response);
+        if (m_limiter != nullptr)
+            std::exchange(m_limiter, nullptr)->release(std::chrono::steady_clock::now() - m_admitted);
+    }
+
+    std::pmr::string m_message;
+    HttpRequest m_request;
+    const HttpRequestHandler* m_handler { nullptr };
+    ResponseQueue::Slot* m_slot { nullptr };
+    /* 协程 offload 的任务，不为空时 run 只执行它 */
+    SmallTask m_task;
+    /* 占用了名额的并发限制与获准时间，run 结束时归还 */
+    ConcurrencyLimiter* m_limiter { nullptr };
+    std::chrono::steady_clock::time_point m_admitted;
+};
+
+/**
+ * @brief 把阻塞调用交给线程池，BlockingCall 在 onBlockingDone 之前保持有效
+ */
+using HttpBlockingOffloader = std::function<void(BlockingCall& Call)>;
+
+/**
+ * @brief 在连接所属的事件循环上布防定时器，Delay 之后在该线程上调用定时器回调；取消通过 WheelTimer::cancel
+ */
+using HttpTimerArmer = std::function<void(WheelTimer& Timer, std::chrono::milliseconds Delay)>;
+
+/**
+ * @brief h2c（明文 HTTP/2）的参数，窗口均为本端的接收窗口
+ */
+struct Http2Options
+{
+    bool m_enabled { true };
+    uint32_t m_maxConcurrentStreams { 256 };
+    uint32_t m_streamWindow { 1 << 20 };
+    uint32_t m_connectionWindow { 16 << 20 };
+    uint32_t m_maxFrameSize { 16384 };
+};
+
+struct HttpConnectionOptions
+{
+    size_t m_maxHeaderBytes { DEFAULT_MAX_HEADER_BYTES };
+    size_t m_maxBodyBytes { DEFAULT_MAX_BODY_BYTES };
+    /* 单个持久连接上最多处理的请求数，达到后回复 Connection: close */
+    size_t m_maxKeepAliveRequests { 10000 };
+    /* 输出缓冲区积压超过该值时暂停解析后续流水线请求，等待对端读走数据 */
+    size_t m_outputHighWater { 1024 * 1024 };
+    /* GET/HEAD 响应缓存，为空时不缓存 */
+    ResponseCache* m_responseCache { nullptr };
+    /* 响应压缩，为空时不压缩 */
+    ResponseCompressor* m_compressor { nullptr };
+    /* 推送流与 WebSocket 订阅使用的发布订阅，为空时不能订阅 */
+    PubSub* m_pubSub { nullptr };
+    /* 阻塞调用的并发限制，为空时不限制；超限的请求得到 503 */
+    ConcurrencyLimiter* m_limiter { nullptr };
+    /* 按客户端的速率限制，为空时不限制；超限的请求得到 429 */
+    RateLimiter* m_rateLimiter { nullptr };
+    Http2Options m_http2;
+};
+
+/**
+ * @brief onInput 处理后连接应采取的动作
+ */
+enum class CONN_ACTION
+{
+    KEEP_READING,
+    PAUSE_READING,
+    CLOSE_AFTER_WRITE
+};
+
+/**
+ * @brief onInput 之外（例如推送消息写入输出缓冲区后）需要连接的所有者采取动作时调用，语义与 onInput 的返回值相同
+ * 只能在连接所属的事件循环线程上、且不在 HttpConnection 的任何调用之中使用，CLOSE_AFTER_WRITE 可能立即释放连接。
+ */
+using HttpActionNotifier = std::function<void(CONN_ACTION Action)>;
+
+/**
+ * @brief 连接当前所处阶段对应的超时类型
+ */
+enum class DEADLINE
+{
+    NONE,
+    HEADER_READ,
+    BODY_READ,
+    IDLE,
+    WRITE
+};
+
+/**
+ * @brief 一个 HTTP/1.1 持久连接的协议状态
+ * 与具体的 I/O 方式无关，只在输入、输出两个 evbuffer 上工作：一次 onInput 会解析并分发输入中所有完整的
+ * 流水线请求，响应按请求顺序进入 ResponseQueue，处理结束后整批写入输出缓冲区，由事件循环在本轮中用
+ * 一次 writev 发送出去。
+ * 遇到 BLOCKING 处理函数时请求交给 Offloader，连接暂停读取与解析，直到 onBlockingDone 把响应放回队列，
+ * 之后的流水线请求仍按顺序处理。未提供 Offloader 时阻塞处理函数直接在当前线程执行。
+ * 配置了 m_limiter 时交给 Offloader 之前先占用名额，名额已满的请求直接得到 503，连接继续处理后续请求。
+ * 配置了 m_rateLimiter 时每个请求在首部完整时按 setClientKey 设置的对端地址（或配置的首部）消耗一个令牌，
+ * 没有令牌的请求不交给路由选出的处理函数，得到 429。
+ * 请求作用域的数据（首部数组、阻塞调用的报文拷贝、处理函数通过 HttpRequest::arena 申请的临时数据）
+ * 都分配在连接自己的 Arena 上，每个请求结束时整体回收，内存块在持久连接的后续请求间复用。
+ * 连接以 HTTP/2 连接前言开头，或第一个请求携带 Upgrade: h2c 时，后续输入交给 Http2Session 处理；
+ * 请求命中注册了 WebSocket 的路由且是合法的升级请求时，回复 101 后交给 WebSocketSession 处理；
+ * GET 请求命中注册了推送流的路由时，回复流式响应首部后交给 EventStreamSession 处理；
+ * 请求命中协程路由时，首部完整即交给 CoroutineSession，由处理函数自己读取请求体，结束后继续处理后续请求。
+ * 推送消息在 onInput 之外写入输出缓冲区，会话通过 Notifier 通知连接的所有者；协程的 sleep 使用 TimerArmer 布防定时器，
+ * 未提供时不等待。
+ */
+class HttpConnection
+{
+public:
+    HttpConnection(const HttpConnectionOptions& Options, const HttpHandlerResolver& Resolver,
+        HttpBlockingOffloader Offloader = nullptr, HttpActionNotifier Notifier = nullptr, HttpTimerArmer TimerArmer = nullptr);
+    ~HttpConnection();
+    HttpConnection(const HttpConnection&) = delete;
+    const HttpConnection& operator=(const HttpConnection&) = delete;
+
+    /**
+     * @brief 恢复到新连接的状态以便对象被下一个连接复用，保留 Arena 内存块与响应槽位
+     * 有阻塞调用时必须等它在线程池中执行完毕才能调用，此时会直接丢弃其响应。
+     */
+    void reset();
+
+    CONN_ACTION onInput(struct evbuffer* Input, struct evbuffer* Output);
+
+    /**
+     * @brief 阻塞调用完成后在事件循环线程上调用，输出其响应并继续处理积压的请求
+     */
+    CONN_ACTION onBlockingDone(struct evbuffer* Input, struct evbuffer* Output);
+
+    /**
+     * @brief 是否有阻塞调用尚未完成，此时连接对象不能释放
+     */
+    bool blocked() const;
+
+    /**
+     * @brief 根据连接当前的状态判断应当生效的超时
+     * 有待发送的数据时为 WRITE；等待阻塞调用时为 NONE；已收到部分请求时按解析进度为 HEADER_READ 或 BODY_READ；
+     * 否则连接空闲，为 IDLE。
+     */
+    DEADLINE pendingDeadline(struct evbuffer* Input, struct evbuffer* Output) const;
+
+    /**
+     * @brief 连接上已处理的请求数
+     */
+    size_t handledRequests() const;
+
+    /**
+     * @brief 设置对端地址的限速键（RateLimiter::addressKey），reset 时清零
+     */
+    void setClientKey(uint64_t Key) { m_clientKey = Key; }
+
+    /**
+     * @brief 连接的请求作用域内存，保留的内存块数反映单个请求的内存峰值
+     */
+    const Arena& arena() const { return m_arena; }
+
+private:
+    void queueError(int Code);
+    /**
+     * @brief 为下一次阻塞调用占用并发限制的名额，已满时返回 false
+     */
+    bool admitBlocking();
+    /**
+     * @brief 首部完整时选出处理函数，超过速率限制时为 rateLimitedHandler
+     */
+    const HttpHandler* resolveHandler();
+    void offload(struct evbuffer* Input, const HttpHandler& Handler, ResponseQueue::Slot& Slot);
+    void endRequest();
+    void releaseBlockingCall();
+    /**
+     * @brief 处理 Upgrade: h2c 请求，成功时连接切换为 HTTP/2
+     */
+    bool tryUpgrade(struct evbuffer* Input, struct evbuffer* Output);
+    Http2Session& http2();
+    /**
+     * @brief 完成 WebSocket 握手，连接切换为 WebSocket
+     */
+    CONN_ACTION upgradeWebSocket(struct evbuffer* Input, struct evbuffer* Output, const HttpHandler& Handler);
+    CONN_ACTION openEventStream(struct evbuffer* Input, struct evbuffer* Output, const HttpHandler& Handler);
+    CONN_ACTION openCoroutine(struct evbuffer* Input, struct evbuffer* Output, const HttpHandler& Handler);
+    /**
+     * @brief 协程处理函数结束后回收请求并继续处理后续请求，尚未结束时原样返回 Action
+     */
+    CONN_ACTION afterCoroutine(CONN_ACTION Action, struct evbuffer* Input, struct evbuffer* Output);
+    /**
+     * @brief 把协程 offload 的任务交给 Offloader，没有 Offloader 时返回 false；并发限制已满时抛出 OverloadedError
+     */
+    bool offloadTask(SmallTask& Work);
+
+    const HttpConnectionOptions& m_options;
+    const HttpHandlerResolver& m_resolver;
+    HttpBlockingOffloader m_offloader;
+    HttpActionNotifier m_notifier;
+    HttpTimerArmer m_timerArmer;
+    std::unique_ptr<BlockingCall> m_blockingCall;
+    HttpRequestParser m_parser;
+    Arena m_arena;
+    HttpRequest m_request { &m_arena };
+    /* 首部完整时选出的处理函数，请求结束时清空 */
+    const HttpHandler* m_handler { nullptr };
+    ResponseQueue m_responses;
+    size_t m_handledRequests { 0 };
+    uint64_t m_clientKey { 0 };
+    bool m_closing { false };
+    bool m_blocked { false };
+    /* 会话对象在连接复用时保留 */
+    std::unique_ptr<Http2Session> m_http2;
+    bool m_http2Active { false };
+    bool m_prefaceChecked { false };
+    std::unique_ptr<WebSocketSession> m_webSocket;
+    bool m_webSocketActive { false };
+    std::unique_ptr<EventStreamSession> m_eventStream;
+    bool m_eventStreamActive { false };
+    std::unique_ptr<CoroutineSession> m_coroutine;
+    bool m_coroutineActive { false };
+};
+}   // namespace ToolKit
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "HttpConnection.h"
+#include "Infra/FactoryTemplate.h"
+#include "nlohmann/json.hpp"
+
+#include <string>
+
+namespace ToolKit
+{
+/**
+ * @brief 可由配置创建的内容处理器，按 Config.json 中 ServerInfo.Handlers 的条目挂载到路径前缀上
+ * 具体实现通过 ProductClassRegistrar<HttpContentHandler, Impl, const nlohmann::json&> 以类型名注册到
+ * ContentHandlerFactory，构造参数是该条目的 json 对象。handle 可能在多个 Reactor 线程上并发调用。
+ */
+class HttpContentHandler
+{
+public:
+    virtual ~HttpContentHandler() = default;
+
+    virtual void handle(const HttpRequest& Request, HttpResponse& Response) = 0;
+
+    /**
+     * @brief 运行统计，与服务器的其他统计一起定期输出；没有统计时返回空串
+     */
+    virtual std::string stats() const { return std::string(); }
+};
+
+using ContentHandlerFactory = ProductClassFactory<HttpContentHandler>;
+}   // namespace ToolKit
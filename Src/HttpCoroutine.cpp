@@ -0,0 +1,346 @@
+#include "HttpCoroutine.h"
+
+#include "ConcurrencyLimiter.h"
+#include "spdlog/spdlog.h"
+
+#include <cstdio>
+#include <event2/buffer.h>
+#include <new>
+
+namespace
+{
+/* 帧之前保存来源内存池的指针，占用一个默认对齐单位，帧本身的对齐不受影响 */
+constexpr size_t FRAME_HEADER = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+
+thread_local std::pmr::memory_resource* currentFramePool = nullptr;
+}   // namespace
+
+namespace ToolKit
+{
+void* TaskPromiseBase::operator new(size_t Size)
+{
+    auto* resource = currentFramePool;
+    void* block = resource != nullptr ? resource->allocate(Size + FRAME_HEADER) : ::operator new(Size + FRAME_HEADER);
+    *static_cast<std::pmr::memory_resource**>(block) = resource;
+    return static_cast<char*>(block) + FRAME_HEADER;
+}
+
+void TaskPromiseBase::operator delete(void* Frame, size_t Size)
+{
+    char* block = static_cast<char*>(Frame) - FRAME_HEADER;
+    auto* resource = *reinterpret_cast<std::pmr::memory_resource**>(block);
+    if (resource != nullptr)
+        resource->deallocate(block, Size + FRAME_HEADER);
+    else
+        ::operator delete(block);
+}
+
+FramePoolScope::FramePoolScope(std::pmr::memory_resource* Pool)
+        : m_previous(std::exchange(currentFramePool, Pool))
+{
+}
+
+FramePoolScope::~FramePoolScope()
+{
+    currentFramePool = m_previous;
+}
+
+CoroutineSession::CoroutineSession(const HttpConnectionOptions& Options, std::pmr::memory_resource* Arena,
+    const HttpActionNotifier* Notifier, const HttpTimerArmer* TimerArmer, Offloader Offload)
+        : m_options(Options)
+        , m_notifier(Notifier)
+        , m_timerArmer(TimerArmer)
+        , m_offloader(std::move(Offload))
+        , m_request(Arena)
+        , m_body(Options.m_maxBodyBytes, Options.m_maxHeaderBytes)
+        , m_timer([this] { onTimer(); })
+{
+}
+
+CoroutineSession::~CoroutineSession()
+{
+    /* 协程帧中的局部对象可能引用会话的其他成员，先于它们销毁 */
+    m_task = {};
+}
+
+CONN_ACTION CoroutineSession::open(std::shared_ptr<const CoroutineHandler> Handler, const HttpRequest& Request,
+    const HttpRequestParser& Parser, struct evbuffer* Input, struct evbuffer* Output, bool KeepAlive)
+{
+    m_handler = std::move(Handler);
+    m_input = Input;
+    m_output = Output;
+    /* parseHeader 完成后首部已是 Input 头部的连续内存，pullup 不会搬移数据，拷贝一份并把视图平移过去 */
+    const auto length = Parser.headLength();
+    const char* base = reinterpret_cast<const char*>(evbuffer_pullup(Input, static_cast<ev_ssize_t>(length)));
+    m_head.assign(base, length);
+    m_request = Request;
+    m_request.rebase(base, m_head.data());
+    evbuffer_drain(Input, length);
+    m_body.start(Parser.contentLength(), Parser.chunked());
+    m_bodyStatus = PARSE_STATUS::COMPLETE;
+
+    m_keepAlive = KeepAlive;
+    m_response.setHttp10(m_request.m_versionMinor == 0);
+    m_response.setKeepAlive(KeepAlive);
+    m_headOnly = m_request.m_method == "HEAD";
+
+    {
+        FramePoolScope scope(&m_framePool);
+        m_task = m_handler->m_handler(*this);
+    }
+    m_waiting = m_task.handle();
+    return resume();
+}
+
+void CoroutineSession::reset()
+{
+    m_timer.cancel();
+    m_task = {};
+    m_waiting = {};
+    m_waitingFor = WAIT::NONE;
+    m_handler.reset();
+    /* 请求的数组分配在连接的 Arena 上，Arena 回收之前归还 */
+    m_request.releaseStorage();
+    m_response.reset();
+    m_body.reset();
+    m_chunk = {};
+    m_input = nullptr;
+    m_output = nullptr;
+    m_keepAlive = false;
+    m_headOnly = false;
+    m_headSent = false;
+    m_chunkedOutput = false;
+}
+
+CONN_ACTION CoroutineSession::onInput(struct evbuffer* Input, struct evbuffer* Output)
+{
+    if (!running())
+        return CONN_ACTION::KEEP_READING;
+    if ((m_waitingFor == WAIT::READ && pollBody()) || (m_waitingFor == WAIT::WRITE && !writeBlocked()))
+        return resume();
+    return settle();
+}
+
+CONN_ACTION CoroutineSession::onBlockingDone()
+{
+    return resume();
+}
+
+DEADLINE CoroutineSession::pendingDeadline(struct evbuffer* Input, struct evbuffer* Output) const
+{
+    if (evbuffer_get_length(Output) > 0)
+        return DEADLINE::WRITE;
+    if (!running())
+        return evbuffer_get_length(Input) > 0 ? DEADLINE::HEADER_READ : DEADLINE::IDLE;
+    return m_waitingFor == WAIT::READ ? DEADLINE::BODY_READ : DEADLINE::NONE;
+}
+
+bool CoroutineSession::pollBody()
+{
+    if (m_bodyStatus != PARSE_STATUS::COMPLETE)
+    {
+        m_chunk = {};
+        return true;
+    }
+    auto status = m_body.next(m_input, m_chunk);
+    if (status == PARSE_STATUS::NEED_MORE)
+        return false;
+    if (status != PARSE_STATUS::COMPLETE)
+    {
+        spdlog::warn("{} bad request body, status[{}]", __FUNCTION__, statusCodeOf(status));
+        m_bodyStatus = status;
+        m_keepAlive = false;
+        if (!m_headSent)
+        {
+            /* 立即回复错误，处理函数之后的输出全部丢弃 */
+            m_response.reset();
+            m_response.setStatus(statusCodeOf(status));
+            m_response.setHttp10(m_request.m_versionMinor == 0);
+            m_response.setKeepAlive(false);
+            m_response.writeTo(m_output);
+            m_headSent = true;
+            m_headOnly = true;
+        }
+    }
+    return true;
+}
+
+bool CoroutineSession::writeBlocked() const
+{
+    return evbuffer_get_length(m_output) >= m_options.m_outputHighWater;
+}
+
+void CoroutineSession::suspend(WAIT Reason, std::coroutine_handle<> Handle)
+{
+    m_waiting = Handle;
+    m_waitingFor = Reason;
+}
+
+bool CoroutineSession::suspendOffload(SmallTask& Work, std::coroutine_handle<> Handle)
+{
+    if (!m_offloader || !m_offloader(Work))
+        return false;
+    suspend(WAIT::OFFLOAD, Handle);
+    return true;
+}
+
+void CoroutineSession::startTimer(std::coroutine_handle<> Handle, std::chrono::milliseconds Delay)
+{
+    suspend(WAIT::TIMER, Handle);
+    (*m_timerArmer)(m_timer, Delay);
+}
+
+void CoroutineSession::onTimer()
+{
+    if (m_waitingFor != WAIT::TIMER)
+        return;
+    auto action = resume();
+    /* 通知放在最后，CLOSE_AFTER_WRITE 可能立即复位会话 */
+    if (m_notifier != nullptr && *m_notifier)
+        (*m_notifier)(action);
+}
+
+CoroutineSession::WriteAwaiter CoroutineSession::write(std::string_view Data)
+{
+    if (!m_headSent)
+        sendHead();
+    if (!Data.empty() && !m_headOnly && m_bodyStatus == PARSE_STATUS::COMPLETE)
+    {
+        if (m_chunkedOutput)
+        {
+            char size[24];
+            int len = snprintf(size, sizeof(size), "%zx\r\n", Data.size());
+            evbuffer_add(m_output, size, static_cast<size_t>(len));
+            evbuffer_add(m_output, Data.data(), Data.size());
+            evbuffer_add(m_output, "\r\n", 2);
+        }
+        else
+        {
+            evbuffer_add(m_output, Data.data(), Data.size());
+        }
+    }
+    return WriteAwaiter(*this);
+}
+
+void CoroutineSession::sendHead()
+{
+    m_headSent = true;
+    const int status = m_response.status();
+    if (status < 200 || status == 204 || status == 304)
+        m_headOnly = true;
+    /* HTTP/1.0 不认识 chunked，响应体以关闭连接结束 */
+    m_chunkedOutput = !m_headOnly && m_request.m_versionMinor >= 1;
+    if (!m_headOnly && !m_chunkedOutput)
+        m_response.setKeepAlive(false);
+    m_response.writeHeadTo(m_output, m_chunkedOutput);
+    const size_t pending = m_response.bodyLength();
+    if (m_headOnly || pending == 0)
+    {
+        m_response.clearBody();
+        return;
+    }
+    if (m_chunkedOutput)
+    {
+        char size[24];
+        int len = snprintf(size, sizeof(size), "%zx\r\n", pending);
+        evbuffer_add(m_output, size, static_cast<size_t>(len));
+    }
+    m_response.takeBody(m_output);
+    if (m_chunkedOutput)
+        evbuffer_add(m_output, "\r\n", 2);
+}
+
+CONN_ACTION CoroutineSession::resume()
+{
+    m_waitingFor = WAIT::NONE;
+    {
+        /* 协程中创建的辅助协程同样从会话的内存池分配 */
+        FramePoolScope scope(&m_framePool);
+        std::exchange(m_waiting, {}).resume();
+    }
+    return settle();
+}
+
+CONN_ACTION CoroutineSession::settle()
+{
+    if (running())
+    {
+        switch (m_waitingFor)
+        {
+            case WAIT::WRITE:
+            case WAIT::OFFLOAD:
+                return CONN_ACTION::PAUSE_READING;
+            case WAIT::TIMER:
+                /* 等待期间到达的流水线请求留在输入缓冲区中，积压过多时暂停读取 */
+                return evbuffer_get_length(m_input) >= m_options.m_maxHeaderBytes ? CONN_ACTION::PAUSE_READING
+                                                                                  : CONN_ACTION::KEEP_READING;
+            default:
+                return CONN_ACTION::KEEP_READING;
+        }
+    }
+    finish();
+    if (!m_keepAlive)
+        return CONN_ACTION::CLOSE_AFTER_WRITE;
+    /* 输入中已有后续请求时暂停读取，输出写出后由写回调重新处理输入 */
+    if (evbuffer_get_length(m_input) == 0)
+        return CONN_ACTION::KEEP_READING;
+    if (evbuffer_get_length(m_output) == 0)
+    {
+        /* 没有待发送的数据就不会再有写回调，只能关闭连接（仅在首部早已发出的无响应体响应上出现） */
+        m_keepAlive = false;
+        return CONN_ACTION::CLOSE_AFTER_WRITE;
+    }
+    return CONN_ACTION::PAUSE_READING;
+}
+
+void CoroutineSession::finish()
+{
+    bool failed = false;
+    bool overloaded = false;
+    if (auto exception = m_task.handle().promise().m_exception)
+    {
+        failed = true;
+        try
+        {
+            std::rethrow_exception(exception);
+        }
+        catch (const OverloadedError&)
+        {
+            /* 拒绝数已计入并发限制的统计，不再逐个记录 */
+            overloaded = true;
+        }
+        catch (const std::exception& e)
+        {
+            spdlog::warn("{} coroutine handler failed[{}]", __FUNCTION__, e.what());
+        }
+        catch (...)
+        {
+            spdlog::warn("{} coroutine handler failed", __FUNCTION__);
+        }
+    }
+    /* 协程帧立即归还到内存池 */
+    m_task = {};
+    /* 未读完的请求体留在输入缓冲区中，找不到下一个请求的起点 */
+    if (failed || !m_body.done())
+        m_keepAlive = false;
+    if (!m_headSent)
+    {
+        if (failed)
+        {
+            m_response.reset();
+            m_response.setStatus(500);
+            m_response.setHttp10(m_request.m_versionMinor == 0);
+            if (overloaded)
+                setOverloaded(m_response);
+        }
+        m_response.setKeepAlive(m_keepAlive && m_response.keepAlive());
+        m_response.writeTo(m_output, m_headOnly);
+    }
+    /* 出错时不写结束块，对端据此知道响应体不完整 */
+    else if (m_chunkedOutput && !failed && m_bodyStatus == PARSE_STATUS::COMPLETE)
+    {
+        evbuffer_add(m_output, "0\r\n\r\n", 5);
+    }
+    m_keepAlive = m_keepAlive && m_response.keepAlive();
+}
+}   // namespace ToolKit
@@ -0,0 +1,459 @@
+#pragma once
+
+#include "HttpConnection.h"
+#include "Infra/SmallTask.h"
+#include "Infra/TimerWheel.h"
+
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+struct evbuffer;
+
+namespace ToolKit
+{
+class CoroutineSession;
+template <class T>
+class HttpTask;
+
+/**
+ * @brief HttpTask 的 promise 中与返回值无关的部分
+ * 协程帧从当前线程上 FramePoolScope 指定的内存池分配，帧之前保存来源，释放时归还到同一个池；
+ * CoroutineSession 在调用处理函数与恢复协程时设置该作用域，处理函数中创建的辅助协程也使用会话的内存池，
+ * 作用域之外创建的协程使用全局 operator new。
+ * 协程结束时对称转移到 co_await 它的协程，没有时返回到 resume 的调用方。
+ */
+class TaskPromiseBase
+{
+public:
+    struct FinalAwaiter
+    {
+        bool await_ready() const noexcept { return false; }
+
+        template <class Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> Handle) noexcept
+        {
+            auto continuation = Handle.promise().m_continuation;
+            return continuation ? continuation : std::noop_coroutine();
+        }
+
+        void await_resume() const noexcept { }
+    };
+
+    static void* operator new(size_t Size);
+    static void operator delete(void* Frame, size_t Size);
+
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+    FinalAwaiter final_suspend() const noexcept { return {}; }
+    void unhandled_exception() { m_exception = std::current_exception(); }
+
+    std::coroutine_handle<> m_continuation;
+    std::exception_ptr m_exception;
+};
+
+/**
+ * @brief 作用域内当前线程上创建的协程帧从 Pool 分配，作用域可以嵌套
+ */
+class FramePoolScope
+{
+public:
+    explicit FramePoolScope(std::pmr::memory_resource* Pool);
+    ~FramePoolScope();
+    FramePoolScope(const FramePoolScope&) = delete;
+    const FramePoolScope& operator=(const FramePoolScope&) = delete;
+
+private:
+    std::pmr::memory_resource* m_previous;
+};
+
+template <class T>
+class TaskPromise : public TaskPromiseBase
+{
+public:
+    HttpTask<T> get_return_object() noexcept;
+
+    template <class U>
+    void return_value(U&& Value)
+    {
+        m_value.emplace(std::forward<U>(Value));
+    }
+
+    T result()
+    {
+        if (m_exception)
+            std::rethrow_exception(m_exception);
+        return std::move(*m_value);
+    }
+
+private:
+    std::optional<T> m_value;
+};
+
+template <>
+class TaskPromise<void> : public TaskPromiseBase
+{
+public:
+    HttpTask<void> get_return_object() noexcept;
+
+    void return_void() const noexcept { }
+
+    void result()
+    {
+        if (m_exception)
+            std::rethrow_exception(m_exception);
+    }
+};
+
+/**
+ * @brief 协程处理函数及其辅助协程的返回类型
+ * 创建后不立即执行，被 co_await 时才开始运行，结束后把返回值或异常交给 co_await 它的协程；对象析构时销毁协程帧。
+ */
+template <class T = void>
+class [[nodiscard]] HttpTask
+{
+public:
+    using promise_type = TaskPromise<T>;
+
+    HttpTask() = default;
+    explicit HttpTask(std::coroutine_handle<promise_type> Handle)
+            : m_handle(Handle)
+    {
+    }
+    HttpTask(HttpTask&& Other) noexcept
+            : m_handle(std::exchange(Other.m_handle, {}))
+    {
+    }
+    HttpTask& operator=(HttpTask&& Other) noexcept
+    {
+        if (this != &Other)
+        {
+            destroy();
+            m_handle = std::exchange(Other.m_handle, {});
+        }
+        return *this;
+    }
+    ~HttpTask() { destroy(); }
+
+    auto operator co_await() const noexcept
+    {
+        struct Awaiter
+        {
+            bool await_ready() const noexcept { return m_handle.done(); }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> Caller) noexcept
+            {
+                m_handle.promise().m_continuation = Caller;
+                return m_handle;
+            }
+
+            T await_resume() { return m_handle.promise().result(); }
+
+            std::coroutine_handle<promise_type> m_handle;
+        };
+        return Awaiter { m_handle };
+    }
+
+    std::coroutine_handle<promise_type> handle() const { return m_handle; }
+
+    explicit operator bool() const { return static_cast<bool>(m_handle); }
+
+private:
+    void destroy()
+    {
+        if (m_handle)
+            m_handle.destroy();
+        m_handle = {};
+    }
+
+    std::coroutine_handle<promise_type> m_handle;
+};
+
+template <class T>
+HttpTask<T> TaskPromise<T>::get_return_object() noexcept
+{
+    return HttpTask<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+}
+
+inline HttpTask<void> TaskPromise<void>::get_return_object() noexcept
+{
+    return HttpTask<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+}
+
+/**
+ * @brief 协程处理函数，须是协程（返回 HttpTask 且函数体中使用 co_await 或 co_return）；
+ * 请求首部完整时即被调用，在连接所属的事件循环线程上运行，请求体由它通过 CoroutineSession::read 逐段读取
+ */
+using HttpCoroutineHandler = std::function<HttpTask<>(CoroutineSession& Session)>;
+
+/**
+ * @brief 一个协程路由，单独成结构以便 HttpHandler 只需前置声明
+ */
+struct CoroutineHandler
+{
+    HttpCoroutineHandler m_handler;
+};
+
+/**
+ * @brief 由协程处理函数接管的一个 HTTP/1.1 请求
+ * HttpConnection 在请求首部完整、路由命中协程处理函数时把连接交给会话，请求体仍留在输入缓冲区中：
+ * read 每次交出输入缓冲区中连续的一段数据（chunked 编码随读随解，不拷贝、不 pullup），
+ * 没有数据时挂起到下一次输入；write 在第一次调用时发出状态行与首部，HTTP/1.1 以 chunked 编码、
+ * HTTP/1.0 以关闭连接结束响应体，输出积压达到 m_outputHighWater 时挂起，由写回调在积压降下来后恢复；
+ * offload 把计算交给阻塞线程池，完成后回到事件循环线程继续；sleep 挂在 Reactor 的时间轮上。
+ * 处理函数结束时没有调用过 write 则按普通响应输出 response()，否则写出结束块；未读完请求体时随后关闭连接，
+ * 否则继续处理后续的流水线请求。处理函数抛出异常时，首部尚未发出则回复 500，已发出则直接关闭连接；
+ * 请求体格式错误或超过 m_maxBodyBytes 时同样处理（回复 400 或 413），处理函数之后的输出被丢弃。
+ * 连接中途关闭时协程在挂起点被销毁，帧中的局部对象照常析构。
+ * 会话对象随连接对象复用，协程帧从会话的内存池中分配，持久连接上的后续请求复用同样的内存块。
+ */
+class CoroutineSession
+{
+public:
+    /**
+     * @brief 把 Work 交给线程池，接受时返回 true 并在完成后调用 onBlockingDone；返回 false 时 Work 保持原样，
+     * 由调用方就地执行；过载时抛出 OverloadedError
+     */
+    using Offloader = std::function<bool(SmallTask& Work)>;
+
+    class ReadAwaiter
+    {
+    public:
+        explicit ReadAwaiter(CoroutineSession& Session)
+                : m_session(Session)
+        {
+        }
+        bool await_ready() { return m_session.pollBody(); }
+        void await_suspend(std::coroutine_handle<> Handle) { m_session.suspend(WAIT::READ, Handle); }
+        std::string_view await_resume() const { return m_session.m_chunk; }
+
+    private:
+        CoroutineSession& m_session;
+    };
+
+    class WriteAwaiter
+    {
+    public:
+        explicit WriteAwaiter(CoroutineSession& Session)
+                : m_session(Session)
+        {
+        }
+        bool await_ready() const { return !m_session.writeBlocked(); }
+        void await_suspend(std::coroutine_handle<> Handle) { m_session.suspend(WAIT::WRITE, Handle); }
+        void await_resume() const { }
+
+    private:
+        CoroutineSession& m_session;
+    };
+
+    class SleepAwaiter
+    {
+    public:
+        SleepAwaiter(CoroutineSession& Session, std::chrono::milliseconds Delay)
+                : m_session(Session)
+                , m_delay(Delay)
+        {
+        }
+        bool await_ready() const { return m_delay.count() <= 0 || !m_session.canSleep(); }
+        void await_suspend(std::coroutine_handle<> Handle) { m_session.startTimer(Handle, m_delay); }
+        void await_resume() const { }
+
+    private:
+        CoroutineSession& m_session;
+        std::chrono::milliseconds m_delay;
+    };
+
+    template <class F>
+    class OffloadAwaiter
+    {
+    public:
+        using Result = std::invoke_result_t<F&>;
+
+        OffloadAwaiter(CoroutineSession& Session, F&& Func)
+                : m_session(Session)
+                , m_func(std::move(Func))
+        {
+        }
+        bool await_ready() const noexcept { return false; }
+        bool await_suspend(std::coroutine_handle<> Handle)
+        {
+            /* 闭包只捕获 this，SmallTask 内联保存；连接没有线程池时就地执行，不挂起 */
+            SmallTask work([this] { run(); });
+            if (m_session.suspendOffload(work, Handle))
+                return true;
+            run();
+            return false;
+        }
+        Result await_resume()
+        {
+            if (m_exception)
+                std::rethrow_exception(m_exception);
+            if constexpr (!std::is_void_v<Result>)
+                return std::move(std::get<Result>(m_result));
+        }
+
+    private:
+        /* 在工作线程上执行，结果经 Reactor 的完成队列交回事件循环线程 */
+        void run() noexcept
+        {
+            try
+            {
+                if constexpr (std::is_void_v<Result>)
+                    m_func();
+                else
+                    m_result.template emplace<Result>(m_func());
+            }
+            catch (...)
+            {
+                m_exception = std::current_exception();
+            }
+        }
+
+        CoroutineSession& m_session;
+        F m_func;
+        std::variant<std::monostate, std::conditional_t<std::is_void_v<Result>, std::monostate, Result>> m_result;
+        std::exception_ptr m_exception;
+    };
+
+    CoroutineSession(const HttpConnectionOptions& Options, std::pmr::memory_resource* Arena, const HttpActionNotifier* Notifier,
+        const HttpTimerArmer* TimerArmer, Offloader Offload);
+    ~CoroutineSession();
+    CoroutineSession(const CoroutineSession&) = delete;
+    const CoroutineSession& operator=(const CoroutineSession&) = delete;
+
+    /**
+     * @brief 接管首部已解析完成的请求并运行处理函数直到第一次挂起
+     * 首部拷贝到会话中并从 Input 移除，Parser 与 Request 随后可以复位；Input、Output 须在会话存续期间有效。
+     */
+    CONN_ACTION open(std::shared_ptr<const CoroutineHandler> Handler, const HttpRequest& Request, const HttpRequestParser& Parser,
+        struct evbuffer* Input, struct evbuffer* Output, bool KeepAlive);
+
+    /**
+     * @brief 有新的输入，或输出积压已降低，恢复在对应挂起点等待的协程
+     */
+    CONN_ACTION onInput(struct evbuffer* Input, struct evbuffer* Output);
+
+    /**
+     * @brief offload 的任务执行完毕，在事件循环线程上恢复协程
+     */
+    CONN_ACTION onBlockingDone();
+
+    DEADLINE pendingDeadline(struct evbuffer* Input, struct evbuffer* Output) const;
+
+    /**
+     * @brief 处理函数尚未结束
+     */
+    bool running() const { return m_task && !m_task.handle().done(); }
+
+    /**
+     * @brief 处理函数结束后连接能否继续处理后续请求
+     */
+    bool keepAlive() const { return m_keepAlive; }
+
+    /**
+     * @brief 销毁协程帧并恢复初始状态以便随连接对象复用，有 offload 的任务在执行时不能调用
+     */
+    void reset();
+
+    /**
+     * @brief 请求首部，m_body 为空，请求体通过 read 读取
+     */
+    const HttpRequest& request() const { return m_request; }
+
+    /**
+     * @brief 响应状态与首部在第一次 write 之前有效；此前写入 body() 的数据作为响应体的第一段发出
+     */
+    HttpResponse& response() { return m_response; }
+
+    /**
+     * @brief 读取下一段请求体，返回空视图表示请求体已读完或格式错误；视图在下一次 read 之前有效
+     */
+    ReadAwaiter read() { return ReadAwaiter(*this); }
+
+    /**
+     * @brief 请求体已完整读出，read 返回空视图后可用来区分正常结束与格式错误
+     */
+    bool bodyComplete() const { return m_body.done(); }
+
+    /**
+     * @brief 把 Data 作为响应体的下一段写入输出缓冲区，输出积压过多时挂起到写回调降低积压为止
+     */
+    WriteAwaiter write(std::string_view Data);
+
+    /**
+     * @brief 在阻塞线程池中调用 Func 并取得其返回值（或重新抛出其异常），Func 按值保存
+     * 线程池的并发限制已满时不执行 Func，抛出 OverloadedError；处理函数不捕获时回复 503。
+     */
+    template <class F>
+    OffloadAwaiter<std::decay_t<F>> offload(F&& Func)
+    {
+        return OffloadAwaiter<std::decay_t<F>>(*this, std::decay_t<F>(std::forward<F>(Func)));
+    }
+
+    /**
+     * @brief 挂起 Delay（向上取整到时间轮刻度）；连接所有者没有提供定时器时立即继续
+     */
+    SleepAwaiter sleep(std::chrono::milliseconds Delay) { return SleepAwaiter(*this, Delay); }
+
+private:
+    enum class WAIT
+    {
+        NONE,
+        READ,
+        WRITE,
+        OFFLOAD,
+        TIMER
+    };
+
+    /**
+     * @brief 取下一段请求体，有数据、已读完或出错时返回 true
+     */
+    bool pollBody();
+    bool writeBlocked() const;
+    bool canSleep() const { return m_timerArmer != nullptr && *m_timerArmer; }
+    void suspend(WAIT Reason, std::coroutine_handle<> Handle);
+    bool suspendOffload(SmallTask& Work, std::coroutine_handle<> Handle);
+    void startTimer(std::coroutine_handle<> Handle, std::chrono::milliseconds Delay);
+    void onTimer();
+    void sendHead();
+    /**
+     * @brief 恢复挂起的协程，返回连接随后应采取的动作
+     */
+    CONN_ACTION resume();
+    CONN_ACTION settle();
+    void finish();
+
+    const HttpConnectionOptions& m_options;
+    const HttpActionNotifier* m_notifier;
+    const HttpTimerArmer* m_timerArmer;
+    Offloader m_offloader;
+    /* 先于 m_task 构造，协程帧销毁之后才析构 */
+    std::pmr::unsynchronized_pool_resource m_framePool;
+    std::shared_ptr<const CoroutineHandler> m_handler;
+    std::string m_head;
+    HttpRequest m_request;
+    HttpResponse m_response;
+    HttpBodyReader m_body;
+    std::string_view m_chunk;
+    PARSE_STATUS m_bodyStatus { PARSE_STATUS::COMPLETE };
+    struct evbuffer* m_input { nullptr };
+    struct evbuffer* m_output { nullptr };
+    WheelTimer m_timer;
+    HttpTask<> m_task;
+    std::coroutine_handle<> m_waiting;
+    WAIT m_waitingFor { WAIT::NONE };
+    bool m_keepAlive { false };
+    bool m_headOnly { false };
+    bool m_headSent { false };
+    bool m_chunkedOutput { false };
+};
+}   // namespace ToolKit
@@ -0,0 +1,651 @@
+#include "HttpParser.h"
+
+#include "ByteScanner.h"
+
+#include <algorithm>
+#include <cstring>
+#include <event2/buffer.h>
+
+using namespace std;
+
+namespace
+{
+constexpr size_t MAX_CHUNK_LINE = 256;
+constexpr size_t PEEK_VECTORS = 8;
+
+inline char toLower(char C)
+{
+    return (C >= 'A' && C <= 'Z') ? static_cast<char>(C + ('a' - 'A')) : C;
+}
+
+bool equalsIgnoreCase(std::string_view Lhs, std::string_view Rhs)
+{
+    if (Lhs.size() != Rhs.size())
+        return false;
+    for (size_t i = 0; i < Lhs.size(); i++)
+    {
+        if (toLower(Lhs[i]) != toLower(Rhs[i]))
+            return false;
+    }
+    return true;
+}
+
+std::string_view trimOws(std::string_view Value)
+{
+    while (!Value.empty() && (Value.front() == ' ' || Value.front() == '\t'))
+        Value.remove_prefix(1);
+    while (!Value.empty() && (Value.back() == ' ' || Value.back() == '\t'))
+        Value.remove_suffix(1);
+    return Value;
+}
+
+bool parseDecimal(std::string_view Value, size_t& Out)
+{
+    if (Value.empty() || Value.size() > 18)
+        return false;
+    size_t result = 0;
+    for (char c : Value)
+    {
+        if (c < '0' || c > '9')
+            return false;
+        result = result * 10 + static_cast<size_t>(c - '0');
+    }
+    Out = result;
+    return true;
+}
+
+/**
+ * @brief 解析 chunk-size 行（不含 CRLF），忽略 chunk 扩展
+ */
+bool parseChunkSize(const char* Line, size_t Len, size_t& Out)
+{
+    size_t result = 0;
+    size_t digits = 0;
+    for (size_t i = 0; i < Len; i++)
+    {
+        char c = Line[i];
+        int v;
+        if (c >= '0' && c <= '9')
+            v = c - '0';
+        else if (c >= 'a' && c <= 'f')
+            v = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F')
+            v = c - 'A' + 10;
+        else if (c == ';' || c == ' ' || c == '\t')
+            break;
+        else
+            return false;
+        if (++digits > 15)
+            return false;
+        result = (result << 4) | static_cast<size_t>(v);
+    }
+    if (digits == 0)
+        return false;
+    Out = result;
+    return true;
+}
+
+/**
+ * @brief 在 evbuffer 的 [From, Limit) 区间内查找首部结束符
+ * 数据可能跨越多个 chain，块与块之间的结束符通过拼接边界两侧各 3 个字节检查
+ *
+ * @return ptrdiff_t 结束符之后的绝对偏移，未找到返回 -1
+ */
+ptrdiff_t findHeadEnd(struct evbuffer* Input, size_t From, size_t Limit)
+{
+    char window[6];
+    size_t windowLen = 0;
+    size_t offset = From;
+    while (offset < Limit)
+    {
+        struct evbuffer_ptr pos;
+        if (evbuffer_ptr_set(Input, &pos, offset, EVBUFFER_PTR_SET) != 0)
+            return -1;
+        struct evbuffer_iovec vecs[PEEK_VECTORS];
+        int n = evbuffer_peek(Input, static_cast<ev_ssize_t>(Limit - offset), &pos, vecs, PEEK_VECTORS);
+        if (n <= 0)
+            return -1;
+        n = std::min(n, static_cast<int>(PEEK_VECTORS));
+        for (int i = 0; i < n && offset < Limit; i++)
+        {
+            auto* data = static_cast<const char*>(vecs[i].iov_base);
+            size_t len = std::min(vecs[i].iov_len, Limit - offset);
+
+            /* 检查跨越上一块与本块边界的结束符 */
+            if (windowLen > 0)
+            {
+                size_t head = std::min<size_t>(3, len);
+                memcpy(window + windowLen, data, head);
+                ptrdiff_t hit = ToolKit::scanHeadTerminator(window, windowLen + head);
+                if (hit > static_cast<ptrdiff_t>(windowLen))
+                    return static_cast<ptrdiff_t>(offset) + hit - static_cast<ptrdiff_t>(windowLen);
+            }
+
+            ptrdiff_t hit = ToolKit::scanHeadTerminator(data, len);
+            if (hit >= 0)
+                return static_cast<ptrdiff_t>(offset) + hit;
+
+            /* 保留本块末尾最多 3 个字节用于下一次边界检查 */
+            size_t keep = std::min<size_t>(3, len);
+            if (len < 3 && windowLen > 0)
+            {
+                size_t total = std::min<size_t>(3, windowLen + len);
+                char merged[6];
+                memcpy(merged, window, windowLen);
+                memcpy(merged + windowLen, data, len);
+                memcpy(window, merged + windowLen + len - total, total);
+                windowLen = total;
+            }
+            else
+            {
+                memcpy(window, data + len - keep, keep);
+                windowLen = keep;
+            }
+            offset += len;
+        }
+    }
+    return -1;
+}
+}   // namespace
+
+namespace ToolKit
+{
+bool hasToken(std::string_view Value, std::string_view Token)
+{
+    while (!Value.empty())
+    {
+        auto comma = Value.find(',');
+        if (equalsIgnoreCase(trimOws(Value.substr(0, comma)), Token))
+            return true;
+        if (comma == std::string_view::npos)
+            break;
+        Value.remove_prefix(comma + 1);
+    }
+    return false;
+}
+
+std::string_view HttpRequest::header(std::string_view Name) const
+{
+    for (auto& header : m_headers)
+    {
+        if (equalsIgnoreCase(header.m_name, Name))
+            return header.m_value;
+    }
+    return {};
+}
+
+std::string_view HttpRequest::param(std::string_view Name) const
+{
+    for (auto& param : m_params)
+    {
+        if (param.m_name == Name)
+            return param.m_value;
+    }
+    return {};
+}
+
+void HttpRequest::rebase(const char* OldBase, const char* NewBase)
+{
+    auto move = [OldBase, NewBase](std::string_view& View)
+    {
+        if (View.data() != nullptr)
+            View = std::string_view(NewBase + (View.data() - OldBase), View.size());
+    };
+    move(m_method);
+    move(m_target);
+    move(m_path);
+    move(m_query);
+    move(m_body);
+    for (auto& header : m_headers)
+    {
+        move(header.m_name);
+        move(header.m_value);
+    }
+    /* 参数名属于路由表，只有值指向报文 */
+    for (auto& param : m_params)
+        move(param.m_value);
+}
+
+void HttpRequest::clear()
+{
+    m_method = m_target = m_path = m_query = m_body = {};
+    m_versionMinor = 1;
+    m_headers.clear();
+    m_keepAlive = true;
+    m_params.clear();
+}
+
+void HttpRequest::releaseStorage()
+{
+    std::pmr::vector<HttpHeader>(m_headers.get_allocator()).swap(m_headers);
+    std::pmr::vector<RouteParam>(m_params.get_allocator()).swap(m_params);
+}
+
+int statusCodeOf(PARSE_STATUS Status)
+{
+    switch (Status)
+    {
+        case PARSE_STATUS::COMPLETE:
+        case PARSE_STATUS::NEED_MORE:
+            return 200;
+        case PARSE_STATUS::BAD_REQUEST:
+            return 400;
+        case PARSE_STATUS::HEADER_TOO_LARGE:
+            return 431;
+        case PARSE_STATUS::PAYLOAD_TOO_LARGE:
+            return 413;
+        case PARSE_STATUS::NOT_IMPLEMENTED:
+            return 501;
+        case PARSE_STATUS::VERSION_NOT_SUPPORTED:
+            return 505;
+    }
+    return 400;
+}
+
+HttpRequestParser::HttpRequestParser(size_t MaxHeaderBytes, size_t MaxBodyBytes)
+        : m_maxHeaderBytes(MaxHeaderBytes)
+        , m_maxBodyBytes(MaxBodyBytes)
+{
+}
+
+void HttpRequestParser::setLimits(size_t MaxHeaderBytes, size_t MaxBodyBytes)
+{
+    m_maxHeaderBytes = MaxHeaderBytes;
+    m_maxBodyBytes = MaxBodyBytes;
+}
+
+void HttpRequestParser::reset()
+{
+    m_state = STATE::HEAD;
+    m_scanned = 0;
+    m_headLen = 0;
+    m_bodyLen = 0;
+    m_chunked = false;
+    m_bodyScan = 0;
+    m_chunkRemaining = 0;
+    m_decodedLen = 0;
+    m_messageLen = 0;
+    m_base = nullptr;
+}
+
+void HttpRequestParser::consume(struct evbuffer* Input, HttpRequest& Request)
+{
+    if (m_state == STATE::DONE)
+        evbuffer_drain(Input, m_messageLen);
+    Request.clear();
+    reset();
+}
+
+void HttpRequestParser::updateBase(const char* Base, HttpRequest& Request)
+{
+    if (m_base != Base)
+    {
+        Request.rebase(m_base, Base);
+        m_base = Base;
+    }
+}
+
+PARSE_STATUS HttpRequestParser::parseHeader(struct evbuffer* Input, HttpRequest& Request)
+{
+    if (m_state != STATE::HEAD)
+        return PARSE_STATUS::COMPLETE;
+    size_t available = evbuffer_get_length(Input);
+    /* RFC 9112 2.2: 请求行之前的空行应被忽略 */
+    if (m_scanned == 0)
+    {
+        char lead;
+        while (available > 0 && evbuffer_copyout(Input, &lead, 1) == 1 && (lead == '\r' || lead == '\n'))
+        {
+            evbuffer_drain(Input, 1);
+            available--;
+        }
+    }
+    size_t limit = std::min(available, m_maxHeaderBytes);
+    ptrdiff_t headEnd = findHeadEnd(Input, m_scanned, limit);
+    if (headEnd < 0)
+    {
+        if (available >= m_maxHeaderBytes)
+            return PARSE_STATUS::HEADER_TOO_LARGE;
+        /* 回退 3 个字节，保证跨越本次与下次数据的结束符能被找到 */
+        m_scanned = limit > 3 ? limit - 3 : 0;
+        return PARSE_STATUS::NEED_MORE;
+    }
+    m_headLen = static_cast<size_t>(headEnd);
+    m_base = reinterpret_cast<const char*>(evbuffer_pullup(Input, static_cast<ev_ssize_t>(m_headLen)));
+    if (m_base == nullptr)
+        return PARSE_STATUS::BAD_REQUEST;
+    auto status = parseHead(m_base, Request);
+    if (status != PARSE_STATUS::COMPLETE)
+        return status;
+    if (m_chunked)
+    {
+        m_bodyScan = m_headLen;
+        m_state = STATE::CHUNK_SIZE;
+    }
+    else if (m_bodyLen > 0)
+    {
+        m_state = STATE::BODY;
+    }
+    else
+    {
+        m_messageLen = m_headLen;
+        m_state = STATE::DONE;
+    }
+    return PARSE_STATUS::COMPLETE;
+}
+
+PARSE_STATUS HttpRequestParser::parse(struct evbuffer* Input, HttpRequest& Request)
+{
+    auto status = parseHeader(Input, Request);
+    if (status != PARSE_STATUS::COMPLETE)
+        return status;
+
+    const size_t available = evbuffer_get_length(Input);
+    if (m_state == STATE::BODY)
+    {
+        if (available < m_headLen + m_bodyLen)
+            return PARSE_STATUS::NEED_MORE;
+        m_messageLen = m_headLen + m_bodyLen;
+        auto* base = reinterpret_cast<const char*>(evbuffer_pullup(Input, static_cast<ev_ssize_t>(m_messageLen)));
+        updateBase(base, Request);
+        Request.m_body = std::string_view(base + m_headLen, m_bodyLen);
+        m_state = STATE::DONE;
+    }
+    else if (m_state == STATE::CHUNK_SIZE || m_state == STATE::CHUNK_DATA || m_state == STATE::CHUNK_TRAILER)
+    {
+        status = parseChunked(Input);
+        if (status != PARSE_STATUS::COMPLETE)
+            return status;
+        finishChunked(Input, Request);
+        m_state = STATE::DONE;
+    }
+    return PARSE_STATUS::COMPLETE;
+}
+
+PARSE_STATUS HttpRequestParser::parseHead(const char* Base, HttpRequest& Request)
+{
+    const char* cur = Base;
+    /* 去掉最后一个空行的 CRLF */
+    const char* end = Base + m_headLen - 2;
+
+    /* request-line = method SP request-target SP HTTP-version CRLF */
+    const char* p = cur + scanTokenLength(cur, static_cast<size_t>(end - cur));
+    if (p == cur || p >= end || *p != ' ')
+        return PARSE_STATUS::BAD_REQUEST;
+    Request.m_method = std::string_view(cur, static_cast<size_t>(p - cur));
+
+    cur = ++p;
+    p = cur + scanVisibleLength(cur, static_cast<size_t>(end - cur));
+    if (p == cur || p >= end || *p != ' ')
+        return PARSE_STATUS::BAD_REQUEST;
+    Request.m_target = std::string_view(cur, static_cast<size_t>(p - cur));
+    auto question = Request.m_target.find('?');
+    Request.m_path = Request.m_target.substr(0, question);
+    if (question != std::string_view::npos)
+        Request.m_query = Request.m_target.substr(question + 1);
+
+    cur = ++p;
+    if (end - cur < 10 || memcmp(cur, "HTTP/", 5) != 0 || cur[6] != '.' || cur[8] != '\r' || cur[9] != '\n')
+        return PARSE_STATUS::BAD_REQUEST;
+    if (cur[5] != '1')
+        return (cur[5] >= '2' && cur[5] <= '9') ? PARSE_STATUS::VERSION_NOT_SUPPORTED : PARSE_STATUS::BAD_REQUEST;
+    if (cur[7] != '0' && cur[7] != '1')
+        return PARSE_STATUS::VERSION_NOT_SUPPORTED;
+    Request.m_versionMinor = cur[7] - '0';
+    cur += 10;
+
+    bool hasContentLength = false;
+    bool closeRequested = false;
+    bool keepAliveRequested = false;
+    Request.m_headers.clear();
+    /* 常见请求的首部不超过 16 个，一次预留避免在 Arena 上留下多份扩容前的数组 */
+    Request.m_headers.reserve(16);
+    while (cur < end)
+    {
+        /* 不支持已废弃的 obs-fold 折行 */
+        if (*cur == ' ' || *cur == '\t')
+            return PARSE_STATUS::BAD_REQUEST;
+        /* 首部名为 token，遇到第一个非 token 字符必须是 ':' */
+        p = cur + scanTokenLength(cur, static_cast<size_t>(end - cur));
+        if (p == cur || p >= end || *p != ':')
+            return PARSE_STATUS::BAD_REQUEST;
+        if (Request.m_headers.size() == MAX_HEADER_COUNT)
+            return PARSE_STATUS::HEADER_TOO_LARGE;
+
+        /* 首部值中合法字符的连续区间必须恰好停在行尾的 CRLF */
+        const char* value = p + 1;
+        const char* lineEnd = value + scanFieldValueLength(value, static_cast<size_t>(end - value));
+        if (lineEnd >= end || lineEnd[0] != '\r' || lineEnd[1] != '\n')
+            return PARSE_STATUS::BAD_REQUEST;
+
+        auto& header = Request.m_headers.emplace_back();
+        header.m_name = std::string_view(cur, static_cast<size_t>(p - cur));
+        header.m_value = trimOws(std::string_view(value, static_cast<size_t>(lineEnd - value)));
+
+        if (equalsIgnoreCase(header.m_name, "Content-Length"))
+        {
+            size_t length = 0;
+            if (!parseDecimal(header.m_value, length) || (hasContentLength && length != m_bodyLen))
+                return PARSE_STATUS::BAD_REQUEST;
+            hasContentLength = true;
+            m_bodyLen = length;
+        }
+        else if (equalsIgnoreCase(header.m_name, "Transfer-Encoding"))
+        {
+            /* chunked 必须是最后一个传输编码，其它编码暂不支持 */
+            auto value = header.m_value;
+            auto comma = value.rfind(',');
+            auto last = trimOws(comma == std::string_view::npos ? value : value.substr(comma + 1));
+            if (!equalsIgnoreCase(last, "chunked") || comma != std::string_view::npos || m_chunked)
+                return PARSE_STATUS::NOT_IMPLEMENTED;
+            m_chunked = true;
+        }
+        else if (equalsIgnoreCase(header.m_name, "Connection"))
+        {
+            closeRequested = closeRequested || hasToken(header.m_value, "close");
+            keepAliveRequested = keepAliveRequested || hasToken(header.m_value, "keep-alive");
+        }
+        cur = lineEnd + 2;
+    }
+
+    /* 同时携带 Content-Length 与 Transfer-Encoding 是请求走私的典型特征，直接拒绝 */
+    if (m_chunked && hasContentLength)
+        return PARSE_STATUS::BAD_REQUEST;
+    if (m_bodyLen > m_maxBodyBytes)
+        return PARSE_STATUS::PAYLOAD_TOO_LARGE;
+    Request.m_keepAlive = Request.m_versionMinor >= 1 ? !closeRequested : (keepAliveRequested && !closeRequested);
+    return PARSE_STATUS::COMPLETE;
+}
+
+PARSE_STATUS HttpRequestParser::parseChunked(struct evbuffer* Input)
+{
+    size_t available = evbuffer_get_length(Input);
+    for (;;)
+    {
+        if (m_state == STATE::CHUNK_DATA)
+        {
+            /* 块数据之后必须紧跟 CRLF */
+            if (available < m_bodyScan + m_chunkRemaining + 2)
+                return PARSE_STATUS::NEED_MORE;
+            struct evbuffer_ptr pos;
+            evbuffer_ptr_set(Input, &pos, m_bodyScan + m_chunkRemaining, EVBUFFER_PTR_SET);
+            char crlf[2];
+            if (evbuffer_copyout_from(Input, &pos, crlf, 2) != 2 || crlf[0] != '\r' || crlf[1] != '\n')
+                return PARSE_STATUS::BAD_REQUEST;
+            m_bodyScan += m_chunkRemaining + 2;
+            m_chunkRemaining = 0;
+            m_state = STATE::CHUNK_SIZE;
+            continue;
+        }
+
+        struct evbuffer_ptr start;
+        if (evbuffer_ptr_set(Input, &start, m_bodyScan, EVBUFFER_PTR_SET) != 0)
+            return PARSE_STATUS::NEED_MORE;
+        size_t eolLen = 0;
+        auto eol = evbuffer_search_eol(Input, &start, &eolLen, EVBUFFER_EOL_CRLF_STRICT);
+        if (eol.pos < 0)
+            return available - m_bodyScan > MAX_CHUNK_LINE ? PARSE_STATUS::BAD_REQUEST : PARSE_STATUS::NEED_MORE;
+        size_t lineLen = static_cast<size_t>(eol.pos) - m_bodyScan;
+        if (lineLen > MAX_CHUNK_LINE)
+            return PARSE_STATUS::BAD_REQUEST;
+
+        if (m_state == STATE::CHUNK_TRAILER)
+        {
+            m_bodyScan = static_cast<size_t>(eol.pos) + eolLen;
+            /* 空行表示消息结束，trailer 字段直接忽略 */
+            if (lineLen == 0)
+            {
+                m_messageLen = m_bodyScan;
+                return PARSE_STATUS::COMPLETE;
+            }
+            if (m_bodyScan - m_headLen - m_decodedLen > m_maxHeaderBytes)
+                return PARSE_STATUS::HEADER_TOO_LARGE;
+            continue;
+        }
+
+        char line[MAX_CHUNK_LINE];
+        evbuffer_copyout_from(Input, &start, line, lineLen);
+        size_t chunkSize = 0;
+        if (!parseChunkSize(line, lineLen, chunkSize))
+            return PARSE_STATUS::BAD_REQUEST;
+        if (m_decodedLen + chunkSize > m_maxBodyBytes)
+            return PARSE_STATUS::PAYLOAD_TOO_LARGE;
+        m_decodedLen += chunkSize;
+        m_bodyScan = static_cast<size_t>(eol.pos) + eolLen;
+        m_chunkRemaining = chunkSize;
+        m_state = chunkSize == 0 ? STATE::CHUNK_TRAILER : STATE::CHUNK_DATA;
+    }
+}
+
+void HttpRequestParser::finishChunked(struct evbuffer* Input, HttpRequest& Request)
+{
+    auto* base = reinterpret_cast<char*>(evbuffer_pullup(Input, static_cast<ev_ssize_t>(m_messageLen)));
+    updateBase(base, Request);
+
+    /* 整个消息已在连续内存中，把各块数据向前搬移拼接成连续的请求体 */
+    char* dst = base + m_headLen;
+    const char* cur = dst;
+    const char* end = base + m_messageLen;
+    for (;;)
+    {
+        auto* lf = static_cast<const char*>(memchr(cur, '\n', std::min<size_t>(MAX_CHUNK_LINE + 2, end - cur)));
+        size_t chunkSize = 0;
+        parseChunkSize(cur, static_cast<size_t>(lf - cur - 1), chunkSize);
+        if (chunkSize == 0)
+            break;
+        memmove(dst, lf + 1, chunkSize);
+        dst += chunkSize;
+        cur = lf + 1 + chunkSize + 2;
+    }
+    Request.m_body = std::string_view(base + m_headLen, m_decodedLen);
+}
+
+HttpBodyReader::HttpBodyReader(size_t MaxBodyBytes, size_t MaxTrailerBytes)
+        : m_maxBodyBytes(MaxBodyBytes)
+        , m_maxTrailerBytes(MaxTrailerBytes)
+{
+}
+
+void HttpBodyReader::setLimits(size_t MaxBodyBytes, size_t MaxTrailerBytes)
+{
+    m_maxBodyBytes = MaxBodyBytes;
+    m_maxTrailerBytes = MaxTrailerBytes;
+}
+
+void HttpBodyReader::start(size_t ContentLength, bool Chunked)
+{
+    if (Chunked)
+        m_state = STATE::CHUNK_SIZE;
+    else
+        m_state = ContentLength > 0 ? STATE::LENGTH : STATE::DONE;
+    m_remaining = Chunked ? 0 : ContentLength;
+    m_delivered = 0;
+    m_received = 0;
+    m_trailerBytes = 0;
+}
+
+void HttpBodyReader::reset()
+{
+    m_state = STATE::DONE;
+    m_remaining = 0;
+    m_delivered = 0;
+    m_received = 0;
+    m_trailerBytes = 0;
+}
+
+PARSE_STATUS HttpBodyReader::next(struct evbuffer* Input, std::string_view& Chunk)
+{
+    evbuffer_drain(Input, m_delivered);
+    m_delivered = 0;
+    Chunk = {};
+    for (;;)
+    {
+        switch (m_state)
+        {
+            case STATE::DONE:
+                return PARSE_STATUS::COMPLETE;
+            case STATE::LENGTH:
+            case STATE::CHUNK_DATA:
+            {
+                if (m_remaining == 0)
+                {
+                    m_state = m_state == STATE::LENGTH ? STATE::DONE : STATE::CHUNK_END;
+                    continue;
+                }
+                /* 只交出第一个内存块中的数据，调用方处理完再取下一段，整个过程不搬移数据 */
+                struct evbuffer_iovec vec;
+                if (evbuffer_peek(Input, -1, nullptr, &vec, 1) < 1 || vec.iov_len == 0)
+                    return PARSE_STATUS::NEED_MORE;
+                m_delivered = std::min(vec.iov_len, m_remaining);
+                m_remaining -= m_delivered;
+                m_received += m_delivered;
+                Chunk = std::string_view(static_cast<const char*>(vec.iov_base), m_delivered);
+                return PARSE_STATUS::COMPLETE;
+            }
+            case STATE::CHUNK_END:
+            {
+                char crlf[2];
+                if (evbuffer_copyout(Input, crlf, 2) < 2)
+                    return PARSE_STATUS::NEED_MORE;
+                if (crlf[0] != '\r' || crlf[1] != '\n')
+                    return PARSE_STATUS::BAD_REQUEST;
+                evbuffer_drain(Input, 2);
+                m_state = STATE::CHUNK_SIZE;
+                continue;
+            }
+            case STATE::CHUNK_SIZE:
+            case STATE::TRAILER:
+            {
+                size_t eolLen = 0;
+                auto eol = evbuffer_search_eol(Input, nullptr, &eolLen, EVBUFFER_EOL_CRLF_STRICT);
+                if (eol.pos < 0)
+                    return evbuffer_get_length(Input) > MAX_CHUNK_LINE ? PARSE_STATUS::BAD_REQUEST : PARSE_STATUS::NEED_MORE;
+                const size_t lineLen = static_cast<size_t>(eol.pos);
+                if (lineLen > MAX_CHUNK_LINE)
+                    return PARSE_STATUS::BAD_REQUEST;
+                if (m_state == STATE::TRAILER)
+                {
+                    evbuffer_drain(Input, lineLen + eolLen);
+                    /* 空行表示消息结束，trailer 字段直接忽略 */
+                    if (lineLen == 0)
+                        m_state = STATE::DONE;
+                    else if ((m_trailerBytes += lineLen + eolLen) > m_maxTrailerBytes)
+                        return PARSE_STATUS::HEADER_TOO_LARGE;
+                    continue;
+                }
+                char line[MAX_CHUNK_LINE];
+                evbuffer_copyout(Input, line, lineLen);
+                size_t chunkSize = 0;
+                if (!parseChunkSize(line, lineLen, chunkSize))
+                    return PARSE_STATUS::BAD_REQUEST;
+                if (m_received + chunkSize > m_maxBodyBytes)
+                    return PARSE_STATUS::PAYLOAD_TOO_LARGE;
+                evbuffer_drain(Input, lineLen + eolLen);
+                m_remaining = chunkSize;
+                m_state = chunkSize == 0 ? STATE::TRAILER : STATE::CHUNK_DATA;
+                continue;
+            }
+        }
+    }
+}
+}   // namespace ToolKit
@@ -0,0 +1,242 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+#include <string_view>
+#include <vector>
+
+struct evbuffer;
+
+namespace ToolKit
+{
+constexpr size_t MAX_HEADER_COUNT = 64;
+constexpr size_t DEFAULT_MAX_HEADER_BYTES = 8 * 1024;
+constexpr size_t DEFAULT_MAX_BODY_BYTES = 1024 * 1024;
+
+struct HttpHeader
+{
+    std::string_view m_name;
+    std::string_view m_value;
+};
+
+/**
+ * @brief 路由匹配出的路径参数，名称指向路由表，值指向请求路径
+ */
+struct RouteParam
+{
+    std::string_view m_name;
+    std::string_view m_value;
+};
+
+/**
+ * @brief 解析完成的 HTTP 请求
+ * 所有字段均为指向连接输入 evbuffer 的视图，不做任何拷贝，只在 HttpRequestParser::consume 之前有效。
+ * 首部数组从构造时给定的内存资源上分配，连接上通常是每个请求结束时整体回收的 Arena。
+ */
+struct HttpRequest
+{
+    explicit HttpRequest(std::pmr::memory_resource* Resource = std::pmr::get_default_resource())
+            : m_headers(Resource)
+            , m_params(Resource)
+    {
+    }
+
+    std::string_view m_method;
+    std::string_view m_target;
+    std::string_view m_path;
+    std::string_view m_query;
+    int m_versionMinor { 1 };
+    std::pmr::vector<HttpHeader> m_headers;
+    std::string_view m_body;
+    bool m_keepAlive { true };
+    /* 由路由在选择处理函数时填入 */
+    std::pmr::vector<RouteParam> m_params;
+
+    /**
+     * @brief 按名称查找首部（大小写不敏感）
+     *
+     * @return std::string_view 不存在时返回空视图
+     */
+    std::string_view header(std::string_view Name) const;
+
+    /**
+     * @brief 按名称查找路径参数（区分大小写），不存在时返回空视图
+     */
+    std::string_view param(std::string_view Name) const;
+
+    /**
+     * @brief 请求作用域的内存资源，处理函数的临时数据可以从这里分配，请求结束后统一回收
+     */
+    std::pmr::memory_resource* arena() const { return m_headers.get_allocator().resource(); }
+
+    /**
+     * @brief 输入缓冲区被 pullup 重排后，将所有视图平移到新的内存地址
+     */
+    void rebase(const char* OldBase, const char* NewBase);
+
+    void clear();
+
+    /**
+     * @brief 归还首部与路径参数数组占用的内存；所用内存资源整体回收（如 Arena::reset）之前必须调用
+     */
+    void releaseStorage();
+};
+
+enum class PARSE_STATUS
+{
+    COMPLETE,
+    NEED_MORE,
+    BAD_REQUEST,
+    HEADER_TOO_LARGE,
+    PAYLOAD_TOO_LARGE,
+    NOT_IMPLEMENTED,
+    VERSION_NOT_SUPPORTED
+};
+
+/**
+ * @brief 解析失败状态对应的 HTTP 响应码
+ */
+int statusCodeOf(PARSE_STATUS Status);
+
+/**
+ * @brief 判断逗号分隔的首部值中是否包含某个 token（大小写不敏感）
+ */
+bool hasToken(std::string_view Value, std::string_view Token);
+
+/**
+ * @brief 可重入的 HTTP/1.1 请求解析器
+ * 直接在 bufferevent 的输入 evbuffer 上工作：通过 evbuffer_peek 扫描首部结束符，
+ * 记录已扫描位置以便数据分多次到达时不必从头扫描；首部完整后仅对请求所在区间做一次 pullup，
+ * 然后将 HttpRequest 的各字段指向这段内存。chunked 请求体在缓冲区内原地拼接。
+ */
+class HttpRequestParser
+{
+public:
+    explicit HttpRequestParser(size_t MaxHeaderBytes = DEFAULT_MAX_HEADER_BYTES, size_t MaxBodyBytes = DEFAULT_MAX_BODY_BYTES);
+
+    /**
+     * @brief 尝试从 Input 头部解析出一个完整请求，数据不足时保存进度并返回 NEED_MORE
+     */
+    PARSE_STATUS parse(struct evbuffer* Input, HttpRequest& Request);
+
+    /**
+     * @brief 只解析首部，首部完整时返回 COMPLETE，请求体留在 Input 中；首部已解析过时直接返回 COMPLETE
+     * 之后可以继续调用 parse 读取请求体，也可以由调用方自行消费：此时先丢弃 headLength 个字节再 reset。
+     */
+    PARSE_STATUS parseHeader(struct evbuffer* Input, HttpRequest& Request);
+
+    /**
+     * @brief 请求处理完毕后从 Input 中移除该请求占用的字节并复位解析状态
+     */
+    void consume(struct evbuffer* Input, HttpRequest& Request);
+
+    void reset();
+
+    void setLimits(size_t MaxHeaderBytes, size_t MaxBodyBytes);
+
+    /**
+     * @brief 当前请求在输入缓冲区中占用的字节数，仅在 parse 返回 COMPLETE 后有效
+     */
+    size_t messageLength() const { return m_messageLen; }
+
+    /**
+     * @brief 首部已完整、正在等待请求体
+     */
+    bool inBody() const { return m_state != STATE::HEAD && m_state != STATE::DONE; }
+
+    /**
+     * @brief 首部（含结束空行）的字节数与声明的请求体长度、是否为 chunked，仅在首部解析完成后有效
+     */
+    size_t headLength() const { return m_headLen; }
+    size_t contentLength() const { return m_bodyLen; }
+    bool chunked() const { return m_chunked; }
+    size_t maxBodyBytes() const { return m_maxBodyBytes; }
+
+private:
+    enum class STATE
+    {
+        HEAD,
+        BODY,
+        CHUNK_SIZE,
+        CHUNK_DATA,
+        CHUNK_TRAILER,
+        DONE
+    };
+
+    PARSE_STATUS parseHead(const char* Base, HttpRequest& Request);
+    PARSE_STATUS parseChunked(struct evbuffer* Input);
+    void finishChunked(struct evbuffer* Input, HttpRequest& Request);
+    void updateBase(const char* Base, HttpRequest& Request);
+
+    size_t m_maxHeaderBytes;
+    size_t m_maxBodyBytes;
+
+    STATE m_state { STATE::HEAD };
+    /* 已确认不含首部结束符的字节数，下次从这里继续扫描 */
+    size_t m_scanned { 0 };
+    size_t m_headLen { 0 };
+    size_t m_bodyLen { 0 };
+    bool m_chunked { false };
+    /* chunked 编码下当前扫描到的绝对偏移、当前块剩余长度及解码后的总长度 */
+    size_t m_bodyScan { 0 };
+    size_t m_chunkRemaining { 0 };
+    size_t m_decodedLen { 0 };
+    size_t m_messageLen { 0 };
+    const char* m_base { nullptr };
+};
+
+/**
+ * @brief 从输入缓冲区头部逐段读出请求体，chunked 编码随读随解
+ * 用于自行消费请求体的场景（如协程处理函数）：HttpRequestParser::parseHeader 之后移除首部，按首部声明的长度与编码 start，
+ * 之后每次 next 返回 Input 第一个内存块中的一段数据，不 pullup、不拷贝。视图在下一次 next 之前有效，
+ * 届时它占用的字节才从 Input 中移除；期间向 Input 追加数据不会使它失效。
+ */
+class HttpBodyReader
+{
+public:
+    explicit HttpBodyReader(size_t MaxBodyBytes = DEFAULT_MAX_BODY_BYTES, size_t MaxTrailerBytes = DEFAULT_MAX_HEADER_BYTES);
+
+    void start(size_t ContentLength, bool Chunked);
+
+    /**
+     * @brief 读出下一段请求体，返回 COMPLETE 时 Chunk 不为空，或者为空表示请求体已经读完
+     * 数据不足时返回 NEED_MORE；编码错误、解码长度超过上限时返回对应的错误状态，之后不应再调用。
+     */
+    PARSE_STATUS next(struct evbuffer* Input, std::string_view& Chunk);
+
+    /**
+     * @brief 请求体已读完，最后一段数据也已从 Input 中移除或将在下一次 next 时移除
+     */
+    bool done() const { return m_state == STATE::DONE; }
+
+    /**
+     * @brief 已读出的请求体字节数（chunked 时为解码后的长度）
+     */
+    size_t received() const { return m_received; }
+
+    void setLimits(size_t MaxBodyBytes, size_t MaxTrailerBytes);
+
+    void reset();
+
+private:
+    enum class STATE
+    {
+        LENGTH,
+        CHUNK_SIZE,
+        CHUNK_DATA,
+        CHUNK_END,
+        TRAILER,
+        DONE
+    };
+
+    size_t m_maxBodyBytes;
+    size_t m_maxTrailerBytes;
+    STATE m_state { STATE::DONE };
+    /* Content-Length 或当前块中尚未读出的字节数 */
+    size_t m_remaining { 0 };
+    /* 上一次 next 交出、尚未从 Input 中移除的字节数 */
+    size_t m_delivered { 0 };
+    size_t m_received { 0 };
+    size_t m_trailerBytes { 0 };
+};
+}   // namespace ToolKit
@@ -0,0 +1,300 @@
+#include "HttpResponse.h"
+
+#include <cstdio>
+#include <cstring>
+#include <event2/buffer.h>
+#include <string>
+#include <strings.h>
+
+namespace
+{
+/* 不超过该长度的首部与响应体直接拷贝进输出缓冲区，避免每个小响应都在输出链上挂多个零碎 chain */
+constexpr size_t INLINE_COPY_LIMIT = 4096;
+constexpr int INLINE_COPY_VECTORS = 4;
+
+void appendBuffer(struct evbuffer* Output, struct evbuffer* Source)
+{
+    size_t len = evbuffer_get_length(Source);
+    if (len == 0)
+        return;
+    struct evbuffer_iovec vecs[INLINE_COPY_VECTORS];
+    int n = len > INLINE_COPY_LIMIT ? INLINE_COPY_VECTORS + 1 : evbuffer_peek(Source, -1, nullptr, vecs, INLINE_COPY_VECTORS);
+    if (n > INLINE_COPY_VECTORS)
+    {
+        evbuffer_add_buffer(Output, Source);
+        return;
+    }
+    for (int i = 0; i < n; i++)
+        evbuffer_add(Output, vecs[i].iov_base, vecs[i].iov_len);
+    evbuffer_drain(Source, len);
+}
+
+std::string_view trim(std::string_view Text)
+{
+    while (!Text.empty() && (Text.front() == ' ' || Text.front() == '\t'))
+        Text.remove_prefix(1);
+    while (!Text.empty() && (Text.back() == ' ' || Text.back() == '\t'))
+        Text.remove_suffix(1);
+    return Text;
+}
+}   // namespace
+
+namespace ToolKit
+{
+void appendShared(struct evbuffer* Output, const SharedBuffer& Body)
+{
+    if (Body.size() <= INLINE_COPY_LIMIT)
+    {
+        evbuffer_add(Output, Body.data(), Body.size());
+        return;
+    }
+    Body.retain();
+    if (evbuffer_add_reference(Output, Body.data(), Body.size(), SharedBuffer::releaseCallback,
+            const_cast<SharedBuffer*>(&Body))
+        != 0)
+        Body.release();
+}
+
+std::string_view reasonPhrase(int Code)
+{
+    switch (Code)
+    {
+        case 100:
+            return "Continue";
+        case 101:
+            return "Switching Protocols";
+        case 200:
+            return "OK";
+        case 201:
+            return "Created";
+        case 204:
+            return "No Content";
+        case 206:
+            return "Partial Content";
+        case 301:
+            return "Moved Permanently";
+        case 302:
+            return "Found";
+        case 304:
+            return "Not Modified";
+        case 400:
+            return "Bad Request";
+        case 403:
+            return "Forbidden";
+        case 404:
+            return "Not Found";
+        case 405:
+            return "Method Not Allowed";
+        case 408:
+            return "Request Timeout";
+        case 412:
+            return "Precondition Failed";
+        case 413:
+            return "Content Too Large";
+        case 416:
+            return "Range Not Satisfiable";
+        case 426:
+            return "Upgrade Required";
+        case 429:
+            return "Too Many Requests";
+        case 431:
+            return "Request Header Fields Too Large";
+        case 500:
+            return "Internal Server Error";
+        case 501:
+            return "Not Implemented";
+        case 503:
+            return "Service Unavailable";
+        case 505:
+            return "HTTP Version Not Supported";
+        default:
+            return "Unknown";
+    }
+}
+
+std::string_view formatHttpDate(time_t Time, char (&Buffer)[32])
+{
+    struct tm tm;
+    gmtime_r(&Time, &tm);
+    size_t len = strftime(Buffer, sizeof(Buffer), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+    return { Buffer, len };
+}
+
+bool parseHttpDate(std::string_view Text, time_t& Time)
+{
+    char text[32];
+    Text = trim(Text);
+    if (Text.size() >= sizeof(text))
+        return false;
+    memcpy(text, Text.data(), Text.size());
+    text[Text.size()] = '\0';
+    struct tm tm;
+    memset(&tm, 0, sizeof(tm));
+    const char* end = strptime(text, "%a, %d %b %Y %H:%M:%S GMT", &tm);
+    if (end == nullptr || *end != '\0')
+        return false;
+    Time = timegm(&tm);
+    return true;
+}
+
+bool etagMatches(std::string_view Header, std::string_view Etag)
+{
+    while (!Header.empty())
+    {
+        auto comma = Header.find(',');
+        auto tag = trim(Header.substr(0, comma));
+        Header = comma == std::string_view::npos ? std::string_view {} : Header.substr(comma + 1);
+        if (tag == "*")
+            return true;
+        if (tag.substr(0, 2) == "W/")
+            tag.remove_prefix(2);
+        if (tag == Etag)
+            return true;
+    }
+    return false;
+}
+
+HttpResponse::HttpResponse()
+        : m_headers(evbuffer_new())
+        , m_body(evbuffer_new())
+{
+}
+
+HttpResponse::~HttpResponse()
+{
+    evbuffer_free(m_headers);
+    evbuffer_free(m_body);
+}
+
+void HttpResponse::addHeader(std::string_view Name, std::string_view Value)
+{
+    evbuffer_add(m_headers, Name.data(), Name.size());
+    evbuffer_add(m_headers, ": ", 2);
+    evbuffer_add(m_headers, Value.data(), Value.size());
+    evbuffer_add(m_headers, "\r\n", 2);
+}
+
+std::string_view HttpResponse::header(std::string_view Name)
+{
+    auto headers = serializedHeaders();
+    while (!headers.empty())
+    {
+        auto end = headers.find("\r\n");
+        auto line = headers.substr(0, end);
+        headers.remove_prefix(end == std::string_view::npos ? headers.size() : end + 2);
+        auto colon = line.find(':');
+        if (colon == Name.size() && strncasecmp(line.data(), Name.data(), Name.size()) == 0)
+            return trim(line.substr(colon + 1));
+    }
+    return {};
+}
+
+std::string_view HttpResponse::serializedHeaders()
+{
+    size_t len = evbuffer_get_length(m_headers);
+    if (len == 0)
+        return {};
+    return { reinterpret_cast<const char*>(evbuffer_pullup(m_headers, -1)), len };
+}
+
+void HttpResponse::addSerializedHeaders(std::string_view Headers)
+{
+    evbuffer_add(m_headers, Headers.data(), Headers.size());
+}
+
+void HttpResponse::removeHeader(std::string_view Name)
+{
+    auto headers = serializedHeaders();
+    if (headers.empty())
+        return;
+    std::string kept;
+    kept.reserve(headers.size());
+    while (!headers.empty())
+    {
+        auto end = headers.find("\r\n");
+        auto line = headers.substr(0, end == std::string_view::npos ? headers.size() : end + 2);
+        headers.remove_prefix(line.size());
+        auto colon = line.find(':');
+        if (colon == std::string_view::npos || colon != Name.size() || strncasecmp(line.data(), Name.data(), colon) != 0)
+            kept.append(line);
+    }
+    evbuffer_drain(m_headers, evbuffer_get_length(m_headers));
+    evbuffer_add(m_headers, kept.data(), kept.size());
+}
+
+void HttpResponse::setFile(std::shared_ptr<struct evbuffer_file_segment> Segment, off_t Offset, off_t Length)
+{
+    m_file = std::move(Segment);
+    m_fileOffset = Offset;
+    m_fileLength = Length;
+}
+
+void HttpResponse::writeHead(struct evbuffer* Output, std::string_view Length)
+{
+    auto reason = reasonPhrase(m_status);
+    char line[128];
+    int len = snprintf(line, sizeof(line), "HTTP/1.1 %d %.*s\r\n", m_status, static_cast<int>(reason.size()), reason.data());
+    evbuffer_add(Output, line, static_cast<size_t>(len));
+    /* 1xx、204 与 304 响应不带消息体，也不应声明 Content-Length */
+    if (m_status >= 200 && m_status != 204 && m_status != 304)
+        evbuffer_add(Output, Length.data(), Length.size());
+    if (!m_keepAlive)
+        evbuffer_add(Output, "Connection: close\r\n", 19);
+    else if (m_http10)
+        evbuffer_add(Output, "Connection: keep-alive\r\n", 24);
+    appendBuffer(Output, m_headers);
+}
+
+void HttpResponse::writeTo(struct evbuffer* Output, bool HeadOnly)
+{
+    char length[64];
+    int len = snprintf(length, sizeof(length), "Content-Length: %zu\r\n", bodyLength());
+    writeHead(Output, std::string_view(length, static_cast<size_t>(len)));
+    evbuffer_add(Output, "\r\n", 2);
+    if (HeadOnly)
+        clearBody();
+    else
+        takeBody(Output);
+}
+
+void HttpResponse::writeHeadTo(struct evbuffer* Output, bool Chunked)
+{
+    writeHead(Output, Chunked ? std::string_view("Transfer-Encoding: chunked\r\n") : std::string_view());
+    evbuffer_add(Output, "\r\n", 2);
+}
+
+size_t HttpResponse::bodyLength() const
+{
+    size_t length = evbuffer_get_length(m_body) + (m_shared ? m_shared->size() : 0);
+    return length + static_cast<size_t>(m_file ? m_fileLength : 0);
+}
+
+void HttpResponse::takeBody(struct evbuffer* Into)
+{
+    appendBuffer(Into, m_body);
+    if (m_shared)
+        appendShared(Into, *m_shared.get());
+    if (m_file && m_fileLength > 0)
+        evbuffer_add_file_segment(Into, m_file.get(), m_fileOffset, m_fileLength);
+    m_shared.reset();
+    m_file.reset();
+}
+
+void HttpResponse::clearBody()
+{
+    evbuffer_drain(m_body, evbuffer_get_length(m_body));
+    m_shared.reset();
+    m_file.reset();
+}
+
+void HttpResponse::reset()
+{
+    m_status = 200;
+    m_keepAlive = true;
+    m_http10 = false;
+    evbuffer_drain(m_headers, evbuffer_get_length(m_headers));
+    evbuffer_drain(m_body, evbuffer_get_length(m_body));
+    m_shared.reset();
+    m_file.reset();
+}
+}   // namespace ToolKit
@@ -0,0 +1,154 @@
+#pragma once
+
+#include "Infra/SharedBuffer.h"
+
+#include <ctime>
+#include <memory>
+#include <string_view>
+#include <sys/types.h>
+
+struct evbuffer;
+struct evbuffer_file_segment;
+
+namespace ToolKit
+{
+/**
+ * @brief 获取状态码对应的标准原因短语
+ */
+std::string_view reasonPhrase(int Code);
+
+/**
+ * @brief 以 IMF-fixdate 格式（Sun, 06 Nov 1994 08:49:37 GMT）写入 Buffer，返回写入的视图
+ */
+std::string_view formatHttpDate(time_t Time, char (&Buffer)[32]);
+
+/**
+ * @brief 解析 IMF-fixdate 格式的日期，格式不符时返回 false
+ */
+bool parseHttpDate(std::string_view Text, time_t& Time);
+
+/**
+ * @brief If-None-Match 的弱比较：列表中任一实体标签去掉 W/ 前缀后与 Etag 相同，或为 *
+ */
+bool etagMatches(std::string_view Header, std::string_view Etag);
+
+/**
+ * @brief 把共享缓冲区追加到 Output：较小的与 appendBuffer 一样拷贝合并，较大的挂上引用，数据随输出缓冲区释放时归还
+ */
+void appendShared(struct evbuffer* Output, const SharedBuffer& Body);
+
+/**
+ * @brief HTTP 响应
+ * 首部在 addHeader 时直接序列化进内部 evbuffer，响应体同样是 evbuffer。
+ * writeTo 时较小的首部与响应体拷贝进输出缓冲区尾部，使同一批流水线响应合并成少量连续内存块；
+ * 较大的响应体通过 evbuffer_add_buffer 整体移动，不产生拷贝。
+ * 文件内容以 evbuffer_file_segment 的形式挂在响应体之后，writeTo 时直接加入输出缓冲区：
+ * 输出到套接字时由 libevent 以 sendfile 发送，否则按需 mmap，文件数据都不经过用户态拷贝。
+ * 共享的不可变响应体（如缓存命中）同样挂在响应体之后，较大时以 evbuffer_add_reference 引用，不拷贝数据。
+ * 对象可在同一连接上复用，reset 后不会释放已分配的缓冲区。
+ */
+class HttpResponse
+{
+public:
+    HttpResponse();
+    ~HttpResponse();
+    HttpResponse(const HttpResponse&) = delete;
+    const HttpResponse& operator=(const HttpResponse&) = delete;
+
+    void setStatus(int Code) { m_status = Code; }
+    int status() const { return m_status; }
+
+    void addHeader(std::string_view Name, std::string_view Value);
+
+    /**
+     * @brief 按名称（大小写不敏感）查找已添加的首部，不存在时返回空视图；视图在下一次修改首部之前有效
+     */
+    std::string_view header(std::string_view Name);
+
+    /**
+     * @brief 已添加首部的序列化形式（每行 Name: Value\r\n），视图在下一次修改首部之前有效
+     */
+    std::string_view serializedHeaders();
+
+    /**
+     * @brief 追加 serializedHeaders 格式的首部块
+     */
+    void addSerializedHeaders(std::string_view Headers);
+
+    /**
+     * @brief 删除所有名为 Name（大小写不敏感）的首部
+     */
+    void removeHeader(std::string_view Name);
+
+    /**
+     * @brief 响应体缓冲区，处理函数可直接向其中写入数据
+     */
+    struct evbuffer* body() { return m_body; }
+
+    /**
+     * @brief 以文件 Segment 中 [Offset, Offset + Length) 区间作为响应体的后续部分
+     * Segment 由响应持有到 writeTo 把它加入输出缓冲区为止，之后由输出缓冲区自身的引用保持有效。
+     */
+    void setFile(std::shared_ptr<struct evbuffer_file_segment> Segment, off_t Offset, off_t Length);
+    bool hasFile() const { return m_file != nullptr; }
+
+    /**
+     * @brief 以共享缓冲区作为响应体的后续部分，位于 body() 之后、文件之前
+     */
+    void setSharedBody(SharedBuffer::Ptr Body) { m_shared = std::move(Body); }
+    bool hasSharedBody() const { return static_cast<bool>(m_shared); }
+
+    /**
+     * @brief 响应体总长度：body()、共享缓冲区与文件区间之和
+     */
+    size_t bodyLength() const;
+
+    /**
+     * @brief 把完整的响应体按 writeTo 的方式移入 Into（文件区间按需 mmap），响应体随后为空
+     * 用于需要读取响应体内容的后续处理（如压缩），不拷贝较大的数据块。
+     */
+    void takeBody(struct evbuffer* Into);
+
+    /**
+     * @brief 丢弃响应体，包括共享缓冲区与文件区间
+     */
+    void clearBody();
+
+    void setKeepAlive(bool KeepAlive) { m_keepAlive = KeepAlive; }
+    bool keepAlive() const { return m_keepAlive; }
+
+    /**
+     * @brief 对应请求为 HTTP/1.0 时，保持连接需要显式回复 Connection: keep-alive
+     */
+    void setHttp10(bool Http10) { m_http10 = Http10; }
+
+    /**
+     * @brief 序列化状态行、首部与响应体到 Output，HeadOnly 为 true 时丢弃响应体（HEAD 请求）
+     */
+    void writeTo(struct evbuffer* Output, bool HeadOnly = false);
+
+    /**
+     * @brief 只序列化状态行与首部，响应体随后由调用方分段写出
+     * Chunked 为 true 时声明 Transfer-Encoding: chunked；否则不声明长度，以关闭连接结束响应体，调用前应 setKeepAlive(false)。
+     */
+    void writeHeadTo(struct evbuffer* Output, bool Chunked);
+
+    void reset();
+
+private:
+    /**
+     * @brief 状态行与 Length 指定的长度首部之后的首部块，不含结束空行
+     */
+    void writeHead(struct evbuffer* Output, std::string_view Length);
+
+    int m_status { 200 };
+    bool m_keepAlive { true };
+    bool m_http10 { false };
+    struct evbuffer* m_headers;
+    struct evbuffer* m_body;
+    SharedBuffer::Ptr m_shared;
+    std::shared_ptr<struct evbuffer_file_segment> m_file;
+    off_t m_fileOffset { 0 };
+    off_t m_fileLength { 0 };
+};
+}   // namespace ToolKit
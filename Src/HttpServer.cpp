@@ -1,12 +1,36 @@
 #include "HttpServer.h"
 
+#include "ConcurrencyLimiter.h"
 #include "ConfigControlImp.h"
+#include "EventStream.h"
+#include "Http2Session.h"
+#include "HttpContentHandler.h"
+#include "HttpCoroutine.h"
+#include "Infra/CpuAffinity.h"
+#include "Infra/SlabPool.h"
 #include "Infra/ThreadPool.h"
+#include "Infra/WorkStealingThreadPool.h"
+#include "PubSub.h"
+#include "RateLimiter.h"
+#include "Reactor.h"
+#include "ResponseCache.h"
+#include "ResponseCompressor.h"
+#include "Router.h"
+#include "SocketStream.h"
+#include "spdlog/fmt/ranges.h"
 #include "spdlog/spdlog.h"
 
+#include <algorithm>
+#include <atomic>
 #include <arpa/inet.h>
+#include <chrono>
 #include <cstddef>
 #include <cstring>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <event2/buffer.h>
 #include <event2/bufferevent.h>
 #include <event2/bufferevent_compat.h>
@@ -14,117 +38,524 @@
 #include <event2/listener.h>
 #include <event2/thread.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
 #include <sys/socket.h>
 #include <unistd.h>
 using namespace spdlog;
 using namespace std;
 
-static int socketReadTimeoutSeconds = 100;
-static int socketWriteTimeoutSeconds = 100;
-ToolKit::ThreadPool* threadPool;
+/* 首部读取超时从收到请求第一个字节开始计算，请求体读取与写超时在每次有进展时重新计算 */
+static chrono::seconds headerReadTimeout { 100 };
+static chrono::seconds bodyReadTimeout { 100 };
+static chrono::seconds idleTimeout { 100 };
+static chrono::seconds writeTimeout { 100 };
+static ToolKit::HttpConnectionOptions connectionOptions;
+static ToolKit::HttpHandler defaultHandler {
+    [](const ToolKit::HttpRequest&, ToolKit::HttpResponse& Response) { Response.setStatus(404); }
+};
+/* run 之前登记的路由，键为路由模式；run 时与 RouteRegistry 中静态注册的路由合并构建 router */
+static map<string, ToolKit::HttpHandler> pendingRoutes;
+/* run 之后只读，Reactor 线程并发匹配不需要加锁 */
+static ToolKit::Router router;
+static ToolKit::HttpHandlerResolver handlerResolver = [](ToolKit::HttpRequest& Request) -> const ToolKit::HttpHandler*
+{
+    ToolKit::RouteMatch match;
+    if (!router.match(Request.m_path, match))
+        return &defaultHandler;
+    Request.m_params.assign(match.m_params.begin(), match.m_params.begin() + match.m_paramCount);
+    return match.m_handler;
+};
+/* 由配置创建的内容处理器及其挂载前缀，运行统计随接收统计一起输出 */
+static vector<pair<string, shared_ptr<ToolKit::HttpContentHandler>>> contentHandlers;
+static unique_ptr<ToolKit::ResponseCache> responseCache;
+static unique_ptr<ToolKit::ResponseCompressor> responseCompressor;
+/* 按 Reactor 分片的发布订阅，分片 i 的投递在 reactors[i] 上执行 */
+static unique_ptr<ToolKit::PubSub> pubSub;
+/* 向阻塞线程池提交任务，未启用线程池时为空 */
+static function<void(ToolKit::SmallTask&&)> submitBlocking;
+/* 停机时置位，此后 Reactor 不再向线程池提交，阻塞调用就地执行 */
+static atomic<bool> blockingClosed { false };
+/* 阻塞调用的自适应并发限制，未配置时为空 */
+static unique_ptr<ToolKit::ConcurrencyLimiter> concurrencyLimiter;
+/* 按客户端的速率限制，未配置时为空 */
+static unique_ptr<ToolKit::RateLimiter> rateLimiter;
+static atomic<uint64_t> rateLimitedConnections { 0 };
+/* 所有 Reactor 上的连接数上限，0 表示不限；达到上限时暂停接受，降到 resumeConnections 以下再恢复 */
+static size_t maxConnections = 0;
+static size_t resumeConnections = 0;
+
+static constexpr size_t CACHE_LINE_SIZE = 64;
+
+struct Connection;
+static void offloadCall(Connection* Conn, ToolKit::BlockingCall& Call);
+static void onDeadline(Connection* Conn);
+static void applyAction(Connection* Conn, ToolKit::CONN_ACTION Action);
+static bool admitConnection();
+static void releaseConnection();
+
 /**
- * Struct to carry around connection (client)-specific data.
+ * Struct to carry around the state of one accepted socket.
+ * 对象由所属 Reactor 的 SlabPool 分配，连接关闭后连同 bufferevent（EPOLL 与 URING 后端为 SocketStream）及其 evbuffer
+ * 一起留给下一个连接复用。
  */
-typedef struct Client
+typedef struct alignas(CACHE_LINE_SIZE) Connection
+{
+    Connection() { m_timer.setCallback([this] { onDeadline(this); }); }
+    ~Connection()
+    {
+        if (m_bufEv != NULL)
+            bufferevent_free(m_bufEv);
+    }
+    Connection(const Connection&) = delete;
+    const Connection& operator=(const Connection&) = delete;
+
+    /* 每次回调都要访问的字段集中在对象开头的同一个缓存行 */
+
+    /* The bufferedevent for this connection. 复用时只替换其中的 fd；EPOLL 与 URING 后端不使用，保持为空 */
+    struct bufferevent* m_bufEv { nullptr };
+
+    /* EPOLL 与 URING 后端的套接字读写 */
+    ToolKit::SocketStream m_stream;
+
+    /* 连接所属的 Reactor，阻塞调用的完成回调投递到这里 */
+    ToolKit::Reactor* m_reactor { nullptr };
+
+    ToolKit::DEADLINE m_deadline { ToolKit::DEADLINE::NONE };
+
+    /* 阻塞调用进行中连接已关闭，套接字已关闭，等完成回调到达后再归还对象 */
+    bool m_orphaned { false };
+
+    /* 输出缓冲区写空后关闭连接 */
+    bool m_closeAfterWrite { false };
+
+    /* 输出积压过多，等待写回调把数据发出去后再继续读取 */
+    bool m_readPaused { false };
+
+    /* 挂在所属 Reactor 时间轮上的超时，同一时刻只有 m_deadline 对应的一种生效 */
+    ToolKit::WheelTimer m_timer;
+
+    /* 跨多次读回调保存的请求解析进度与待发送的响应；推送消息写入输出缓冲区后经 Notifier 回到 applyAction，
+     * 协程处理函数的 sleep 挂在所属 Reactor 的时间轮上 */
+    ToolKit::HttpConnection m_http { connectionOptions, handlerResolver,
+        submitBlocking ? ToolKit::HttpBlockingOffloader([this](ToolKit::BlockingCall& Call) { offloadCall(this, Call); })
+                       : nullptr,
+        [this](ToolKit::CONN_ACTION Action) { applyAction(this, Action); },
+        [this](ToolKit::WheelTimer& Timer, std::chrono::milliseconds Delay) { m_reactor->armTimer(Timer, Delay); } };
+} connection_t;
+
+/* 每个 Reactor 一个连接对象池，按 Reactor::index 访问，只在对应的 Reactor 线程上使用 */
+static vector<unique_ptr<ToolKit::SlabPool<connection_t>>> connectionPools;
+
+static struct evbuffer* inputOf(connection_t* Conn)
+{
+    return Conn->m_bufEv != NULL ? bufferevent_get_input(Conn->m_bufEv) : Conn->m_stream.input();
+}
+
+static struct evbuffer* outputOf(connection_t* Conn)
+{
+    return Conn->m_bufEv != NULL ? bufferevent_get_output(Conn->m_bufEv) : Conn->m_stream.output();
+}
+
+/* URING 后端发送在途时输出缓冲区可能已空，此时仍不能关闭连接 */
+static bool writePending(connection_t* Conn)
+{
+    return Conn->m_bufEv != NULL ? evbuffer_get_length(bufferevent_get_output(Conn->m_bufEv)) > 0 : Conn->m_stream.writePending();
+}
+
+static void setReading(connection_t* Conn, bool Enable)
+{
+    if (Conn->m_bufEv == NULL)
+        Enable ? Conn->m_stream.enableRead() : Conn->m_stream.disableRead();
+    else if (Enable)
+        bufferevent_enable(Conn->m_bufEv, EV_READ);
+    else
+        bufferevent_disable(Conn->m_bufEv, EV_READ);
+}
+
+/* 关闭套接字并清空缓冲区，bufferevent 本身保留给下一个连接 */
+static void detachSocket(connection_t* Conn)
+{
+    if (Conn->m_bufEv == NULL)
+    {
+        Conn->m_stream.detach();
+        return;
+    }
+    struct bufferevent* bev = Conn->m_bufEv;
+    evutil_socket_t fd = bufferevent_getfd(bev);
+    bufferevent_disable(bev, EV_READ | EV_WRITE);
+    bufferevent_setfd(bev, -1);
+    evutil_closesocket(fd);
+    struct evbuffer* input = bufferevent_get_input(bev);
+    struct evbuffer* output = bufferevent_get_output(bev);
+    evbuffer_drain(input, evbuffer_get_length(input));
+    evbuffer_drain(output, evbuffer_get_length(output));
+}
+
+static void freeConnection(connection_t* Conn)
+{
+    if (!Conn->m_orphaned)
+        detachSocket(Conn);
+    Conn->m_reactor->cancelTimer(Conn->m_timer);
+    Conn->m_http.reset();
+    Conn->m_deadline = ToolKit::DEADLINE::NONE;
+    Conn->m_orphaned = false;
+    Conn->m_closeAfterWrite = false;
+    Conn->m_readPaused = false;
+    connectionPools[Conn->m_reactor->index()]->release(Conn);
+    releaseConnection();
+}
+
+/* 关闭套接字；线程池仍持有连接内的 BlockingCall 时，连接对象留给完成回调归还 */
+static void closeConnection(connection_t* Conn)
+{
+    if (!Conn->m_http.blocked())
+    {
+        freeConnection(Conn);
+        return;
+    }
+    detachSocket(Conn);
+    Conn->m_orphaned = true;
+    Conn->m_reactor->cancelTimer(Conn->m_timer);
+}
+
+static void onDeadline(connection_t* Conn)
+{
+    info("{} connection deadline[{}] expired", __FUNCTION__, static_cast<int>(Conn->m_deadline));
+    closeConnection(Conn);
+}
+
+/* 按连接当前阶段布防超时：阶段不变时首部读取与空闲超时保持原截止时间，其余超时视为有进展而重新计算 */
+static void updateDeadline(connection_t* Conn)
+{
+    auto deadline = Conn->m_http.pendingDeadline(inputOf(Conn), outputOf(Conn));
+    if (deadline == Conn->m_deadline && (deadline == ToolKit::DEADLINE::HEADER_READ || deadline == ToolKit::DEADLINE::IDLE))
+        return;
+    Conn->m_deadline = deadline;
+    switch (deadline)
+    {
+        case ToolKit::DEADLINE::NONE:
+            Conn->m_reactor->cancelTimer(Conn->m_timer);
+            break;
+        case ToolKit::DEADLINE::HEADER_READ:
+            Conn->m_reactor->armTimer(Conn->m_timer, headerReadTimeout);
+            break;
+        case ToolKit::DEADLINE::BODY_READ:
+            Conn->m_reactor->armTimer(Conn->m_timer, bodyReadTimeout);
+            break;
+        case ToolKit::DEADLINE::IDLE:
+            Conn->m_reactor->armTimer(Conn->m_timer, idleTimeout);
+            break;
+        case ToolKit::DEADLINE::WRITE:
+            Conn->m_reactor->armTimer(Conn->m_timer, writeTimeout);
+            break;
+    }
+}
+
+static void applyAction(connection_t* Conn, ToolKit::CONN_ACTION Action)
+{
+    switch (Action)
+    {
+        case ToolKit::CONN_ACTION::KEEP_READING:
+            /* 阻塞调用完成后恢复读取 */
+            if (Conn->m_readPaused)
+            {
+                Conn->m_readPaused = false;
+                setReading(Conn, true);
+            }
+            break;
+        case ToolKit::CONN_ACTION::PAUSE_READING:
+            Conn->m_readPaused = true;
+            setReading(Conn, false);
+            break;
+        case ToolKit::CONN_ACTION::CLOSE_AFTER_WRITE:
+            /* 没有待发送的数据就不会再有写回调，直接关闭（例如对端 GOAWAY 后的 HTTP/2 连接） */
+            if (!writePending(Conn))
+            {
+                closeConnection(Conn);
+                return;
+            }
+            Conn->m_closeAfterWrite = true;
+            setReading(Conn, false);
+            break;
+    }
+    updateDeadline(Conn);
+}
+
+static void processInput(connection_t* Conn)
+{
+    applyAction(Conn, Conn->m_http.onInput(inputOf(Conn), outputOf(Conn)));
+}
+
+/* 在 Reactor 线程上执行，只有这里和其他 Reactor 回调会访问连接的缓冲区 */
+static void onBlockingDone(connection_t* Conn)
 {
-    /* The event_base for this client. */
-    struct event_base* m_evbase;
+    if (Conn->m_orphaned)
+    {
+        freeConnection(Conn);
+        return;
+    }
+    applyAction(Conn, Conn->m_http.onBlockingDone(inputOf(Conn), outputOf(Conn)));
+}
 
-    /* The bufferedevent for this client. */
-    struct bufferevent* m_bufEv;
+/* 在线程池中执行处理函数，再把完成回调投递回连接所属的 Reactor；两个闭包都足够小，提交过程不分配内存 */
+static void offloadCall(connection_t* Conn, ToolKit::BlockingCall& Call)
+{
+    if (blockingClosed.load(memory_order_relaxed))
+    {
+        Call.run();
+        Conn->m_reactor->runInLoop([Conn] { onBlockingDone(Conn); });
+        return;
+    }
+    submitBlocking(
+        [Conn, &Call]
+        {
+            Call.run();
+            Conn->m_reactor->runInLoop([Conn] { onBlockingDone(Conn); });
+        });
+}
 
-} client_t;
+static void onWritten(connection_t* Conn)
+{
+    if (Conn->m_closeAfterWrite)
+    {
+        if (!writePending(Conn))
+            freeConnection(Conn);
+        else
+            updateDeadline(Conn);
+        return;
+    }
+    /* 输出降到低水位以下，继续处理积压在输入缓冲区中的流水线请求 */
+    if (Conn->m_readPaused)
+    {
+        Conn->m_readPaused = false;
+        setReading(Conn, true);
+        processInput(Conn);
+        return;
+    }
+    updateDeadline(Conn);
+}
 
-static void onWrite(struct bufferevent* Bev, void* Arg) { }
+static void onWrite(struct bufferevent* Bev, void* Arg)
+{
+    onWritten(static_cast<connection_t*>(Arg));
+}
 
 static void onReadCb(struct bufferevent* Bev, void* Ctx)
 {
-    struct evbuffer* input = bufferevent_get_input(Bev);
-    struct evbuffer* output = bufferevent_get_output(Bev);
-    evbuffer_add_buffer(output, input);
+    processInput(static_cast<connection_t*>(Ctx));
 }
 static void echoEventCb(struct bufferevent* Bev, short Events, void* Ctx)
 {
     info("{} receive event[{}]", __FUNCTION__, Events);
+    if (Events & (BEV_EVENT_EOF | BEV_EVENT_ERROR))
+        closeConnection(static_cast<connection_t*>(Ctx));
 }
 
-static int threadNums = 0;
-static vector<struct Client*> clientVector;
-static int baseIndex = 0;
+static void onStreamRead(ToolKit::SocketStream& Stream, void* Arg)
+{
+    processInput(static_cast<connection_t*>(Arg));
+}
+
+static void onStreamWrite(ToolKit::SocketStream& Stream, void* Arg)
+{
+    onWritten(static_cast<connection_t*>(Arg));
+}
 
-static void closeAndFreeClient(client_t* Client)
+static void onStreamClose(ToolKit::SocketStream& Stream, void* Arg)
 {
-    for (auto iter = clientVector.begin(); iter != clientVector.end(); iter++)
+    closeConnection(static_cast<connection_t*>(Arg));
+}
+
+static vector<unique_ptr<ToolKit::Reactor>> reactors;
+static size_t nextReactor = 0;
+static atomic<size_t> sharedListenerAccepted { 0 };
+/* 单监听模式的监听器，以 LEV_OPT_THREADSAFE 创建，Reactor 线程可以直接启停 */
+static struct evconnlistener* sharedListener = nullptr;
+static atomic<size_t> liveConnections { 0 };
+static atomic<bool> acceptPaused { false };
+static atomic<uint64_t> rejectedConnections { 0 };
+static atomic<uint64_t> acceptPauses { 0 };
+/* 暂停与恢复在锁内复查连接数再切换，二者不会交错 */
+static mutex acceptGateMutex;
+
+/* 让监听状态与 acceptPaused 一致；各 Reactor 的监听套接字只能在各自线程上启停，
+ * 任务执行时读取最新状态，投递的先后顺序因此无关紧要 */
+static void syncAccepting()
+{
+    if (sharedListener != nullptr)
     {
-        if (*iter.base() == Client)
-        {
-            clientVector.erase(iter);
-            break;
-        }
+        acceptPaused.load() ? evconnlistener_disable(sharedListener) : evconnlistener_enable(sharedListener);
+        return;
     }
-    if (Client != NULL)
+    for (auto& reactor : reactors)
     {
-        if (Client->m_evbase != NULL)
-        {
-            event_base_free(Client->m_evbase);
-            Client->m_evbase = NULL;
-        }
-        free(Client);
+        if (reactor.get() == ToolKit::Reactor::current())
+            reactor->setAccepting(!acceptPaused.load());
+        else
+            reactor->runInLoop([target = reactor.get()] { target->setAccepting(!acceptPaused.load()); });
     }
 }
-static void serverJobFunction(struct Client* Client)
+
+static void pauseAccepting()
 {
-    event_base_dispatch(Client->m_evbase);
-    closeAndFreeClient(Client);
+    lock_guard<mutex> lock(acceptGateMutex);
+    if (acceptPaused.load() || liveConnections.load() < maxConnections)
+        return;
+    acceptPaused.store(true);
+    /* 其他 Reactor 的 releaseConnection 可能在置位之前读到未暂停而跳过恢复，置位后再看一次连接数；
+     * 两边都是顺序一致的原子操作，双方至少有一方能看到对方的修改 */
+    if (liveConnections.load() < resumeConnections)
+    {
+        acceptPaused.store(false);
+        return;
+    }
+    acceptPauses.fetch_add(1, memory_order_relaxed);
+    info("{} reach max connections[{}], pause accepting", __FUNCTION__, maxConnections);
+    syncAccepting();
 }
-static void onAcceptCb(struct evconnlistener* Listener, evutil_socket_t Fd, struct sockaddr* Addr, int Socklen, void* Ctx)
+
+static void resumeAccepting()
 {
-    struct Client* client = NULL;
-    bool addThreadPool = false;
-    if (clientVector.size() < threadNums)
+    lock_guard<mutex> lock(acceptGateMutex);
+    if (!acceptPaused.load() || liveConnections.load() >= resumeConnections)
+        return;
+    acceptPaused.store(false);
+    info("{} connections below [{}], resume accepting", __FUNCTION__, resumeConnections);
+    syncAccepting();
+}
+
+/* 新连接计入连接数；超过上限（暂停生效之前已被接受的连接）时返回 false，由调用方关闭 */
+static bool admitConnection()
+{
+    if (maxConnections == 0)
+        return true;
+    const size_t live = liveConnections.fetch_add(1) + 1;
+    if (live > maxConnections)
     {
-        client = new Client;
-        memset(client, 0, sizeof(*client));
-        if ((client->m_evbase = event_base_new()) == NULL)
+        liveConnections.fetch_sub(1);
+        rejectedConnections.fetch_add(1, memory_order_relaxed);
+        return false;
+    }
+    if (live == maxConnections)
+        pauseAccepting();
+    return true;
+}
+
+static void releaseConnection()
+{
+    if (maxConnections == 0)
+        return;
+    const size_t live = liveConnections.fetch_sub(1) - 1;
+    if (live < resumeConnections && acceptPaused.load())
+        resumeAccepting();
+}
+
+/* 在 Reactor 线程上为移交过来的 fd 建立连接，此后连接的全部回调都在该线程执行 */
+static void onConnectionHandoff(ToolKit::Reactor& Owner, evutil_socket_t Fd)
+{
+    /* 限速按对端地址，移交队列只传 fd，在这里取一次地址 */
+    uint64_t clientKey = 0;
+    if (rateLimiter)
+    {
+        struct sockaddr_storage peer;
+        socklen_t peerLength = sizeof(peer);
+        if (getpeername(Fd, reinterpret_cast<struct sockaddr*>(&peer), &peerLength) == 0)
+            clientKey = ToolKit::RateLimiter::addressKey(reinterpret_cast<struct sockaddr*>(&peer));
+    }
+    /* ReusePort 模式下连接直接在 Reactor 上被接受，在这里计数与限速；单监听模式已在接收回调中做过 */
+    if (Owner.listenFd() >= 0)
+    {
+        if (rateLimiter && rateLimiter->limitAccepts() && !rateLimiter->allow(clientKey))
+        {
+            rateLimitedConnections.fetch_add(1, memory_order_relaxed);
+            evutil_closesocket(Fd);
+            return;
+        }
+        if (!admitConnection())
         {
-            warn("client event_base creation failed");
-            closeAndFreeClient(client);
+            evutil_closesocket(Fd);
             return;
         }
-        clientVector.push_back(client);
-        addThreadPool = true;
     }
-    else
+    /* 首部与文件段分两次写出（HTTP/2 的每个 DATA 帧都是如此），不关闭 Nagle 会与对端的延迟确认叠加出 40ms 停顿 */
+    int noDelay = 1;
+    setsockopt(Fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+    auto* conn = connectionPools[Owner.index()]->acquire();
+    conn->m_reactor = &Owner;
+    conn->m_http.setClientKey(clientKey);
+    if (Owner.backend() != ToolKit::IO_BACKEND::LIBEVENT)
     {
-        client = clientVector[baseIndex];
-        baseIndex = ++baseIndex == clientVector.size() ? 0 : baseIndex;
+        /* 回调与低水位每次接管都重新设置，开销只是几次赋值 */
+        conn->m_stream.setCallbacks(onStreamRead, onStreamWrite, onStreamClose, conn);
+        conn->m_stream.setWriteLowWater(connectionOptions.m_outputHighWater / 2);
+        if (!conn->m_stream.attach(Owner.poller(), Fd))
+        {
+            warn("client socket stream attach failed");
+            evutil_closesocket(Fd);
+            connectionPools[Owner.index()]->release(conn);
+            releaseConnection();
+            return;
+        }
+        updateDeadline(conn);
+        return;
     }
-
-    if ((client->m_bufEv = bufferevent_socket_new(client->m_evbase, Fd, BEV_OPT_CLOSE_ON_FREE)) == NULL)
+    if (conn->m_bufEv != NULL)
     {
-        warn("client bufferevent creation failed");
-        closeAndFreeClient(client);
-        return;
+        /* 复用的 bufferevent 回调、水位都保持不变，只需换上新的 fd */
+        bufferevent_setfd(conn->m_bufEv, Fd);
+    }
+    else
+    {
+        if ((conn->m_bufEv = bufferevent_socket_new(Owner.base(), Fd, BEV_OPT_CLOSE_ON_FREE)) == NULL)
+        {
+            warn("client bufferevent creation failed");
+            evutil_closesocket(Fd);
+            connectionPools[Owner.index()]->release(conn);
+            releaseConnection();
+            return;
+        }
+        /*设置 bufferevent 的回调函数，这里设置了读和事件的回调函数*/
+        bufferevent_setcb(conn->m_bufEv, onReadCb, onWrite, echoEventCb, conn);
+        bufferevent_setwatermark(conn->m_bufEv, EV_WRITE, connectionOptions.m_outputHighWater / 2, 0);
     }
-    /*设置 bufferevent 的回调函数，这里设置了读和事件的回调函数*/
-    bufferevent_setcb(client->m_bufEv, onReadCb, onWrite, echoEventCb, NULL);
-
-    bufferevent_base_set(client->m_evbase, client->m_bufEv);
-    struct timeval readTimeOut;
-    readTimeOut.tv_sec = socketReadTimeoutSeconds;
-    readTimeOut.tv_usec = 0;
 
-    struct timeval rwriteTimeOut;
-    rwriteTimeOut.tv_sec = socketWriteTimeoutSeconds;
-    rwriteTimeOut.tv_usec = 0;
-    bufferevent_set_timeouts(client->m_bufEv, &readTimeOut, &rwriteTimeOut);
+    /* 超时由 Reactor 的时间轮管理，不再给每个 bufferevent 设置读写超时 */
+    updateDeadline(conn);
 
     /*
      * We have to enable it before our callbacks will be called.
      */
-    bufferevent_enable(client->m_bufEv, EV_READ | EV_WRITE);
-    if (addThreadPool)
-        threadPool->enqueue(serverJobFunction, client);
+    bufferevent_enable(conn->m_bufEv, EV_READ | EV_WRITE);
+}
+
+/* 接收回调只在监听线程上执行，轮询选择 Reactor；目标队列已满时顺延到下一个 */
+static void onAcceptCb(struct evconnlistener* Listener, evutil_socket_t Fd, struct sockaddr* Addr, int Socklen, void* Ctx)
+{
+    sharedListenerAccepted.fetch_add(1, memory_order_relaxed);
+    /* 超过速率的客户端在接收线程上直接关闭，不占用 Reactor */
+    if (rateLimiter && rateLimiter->limitAccepts() && !rateLimiter->allow(ToolKit::RateLimiter::addressKey(Addr)))
+    {
+        rateLimitedConnections.fetch_add(1, memory_order_relaxed);
+        evutil_closesocket(Fd);
+        return;
+    }
+    /* 达到上限时监听器在这里同步停用，libevent 不再继续本轮的 accept */
+    if (!admitConnection())
+    {
+        evutil_closesocket(Fd);
+        return;
+    }
+    for (size_t i = 0; i < reactors.size(); i++)
+    {
+        auto& reactor = reactors[nextReactor];
+        nextReactor = nextReactor + 1 == reactors.size() ? 0 : nextReactor + 1;
+        if (reactor->post(Fd))
+            return;
+    }
+    warn("{} all reactor queues are full, drop fd[{}]", __FUNCTION__, Fd);
+    evutil_closesocket(Fd);
+    releaseConnection();
 }
 
 static void acceptErrorCb(struct evconnlistener* Listener, void* Ctx)
@@ -139,6 +570,35 @@ static void acceptErrorCb(struct evconnlistener* Listener, void* Ctx)
     event_base_loopexit(base, NULL);
 }
 
+/* 先停止向线程池提交：置位后在每个运行中的 Reactor 上走一次屏障任务，此后 Reactor 线程不会再调用 submitBlocking；
+ * 再释放线程池，等它执行完已提交的阻塞调用（完成回调投递到仍在运行的 Reactor）；
+ * 然后停止 Reactor 线程，最后在 event_base 释放之前归还对象池中的 bufferevent */
+static void shutdownReactors()
+{
+    blockingClosed.store(true);
+    for (auto& reactor : reactors)
+    {
+        if (!reactor->running())
+            continue;
+        promise<void> passed;
+        reactor->runInLoop([&passed] { passed.set_value(); });
+        passed.get_future().wait();
+    }
+    submitBlocking = nullptr;
+    for (auto& reactor : reactors)
+        reactor->stop();
+    connectionPools.clear();
+    reactors.clear();
+}
+
+static void onAcceptStatsTimer(evutil_socket_t Fd, short Events, void* Arg)
+{
+    auto counts = ToolKit::HttpServer::instance()->acceptedPerListener();
+    info("accepted per listener {}", counts);
+    for (auto& [component, stats] : ToolKit::HttpServer::instance()->componentStats())
+        info("{} {}", component, stats);
+}
+
 namespace ToolKit
 {
 HttpServer::HttpServer()
@@ -150,28 +610,308 @@ HttpServer::HttpServer()
     info("Load ServerInfo Config is \n{}", serverConfigInfo.dump(4).c_str());
     m_sIpAddr = serverConfigInfo["IP"].get<string>();
     m_iPort = serverConfigInfo["Port"].get<int>();
-    m_iThreadNums = serverConfigInfo["threads"].get<int>();
-    threadNums = m_iThreadNums;
-    socketReadTimeoutSeconds = serverConfigInfo["ReadTimeOut_S"].get<int>();
-    socketWriteTimeoutSeconds = serverConfigInfo["WriteTimeOut_S"].get<int>();
-    threadPool = new ThreadPool { static_cast<size_t>(m_iThreadNums) };
+    m_iThreadNums = std::max(1, serverConfigInfo["threads"].get<int>());
+    chrono::seconds readTimeout { serverConfigInfo["ReadTimeOut_S"].get<int>() };
+    headerReadTimeout = chrono::seconds(serverConfigInfo.value("HeaderReadTimeOut_S", readTimeout.count()));
+    bodyReadTimeout = chrono::seconds(serverConfigInfo.value("BodyReadTimeOut_S", readTimeout.count()));
+    idleTimeout = chrono::seconds(serverConfigInfo.value("IdleTimeOut_S", readTimeout.count()));
+    writeTimeout = chrono::seconds(serverConfigInfo["WriteTimeOut_S"].get<int>());
+    m_timerTick = chrono::milliseconds(std::max(1, serverConfigInfo.value("TimerTick_Ms", 100)));
+    connectionOptions.m_maxHeaderBytes = serverConfigInfo.value("MaxHeaderBytes", DEFAULT_MAX_HEADER_BYTES);
+    connectionOptions.m_maxBodyBytes = serverConfigInfo.value("MaxBodyBytes", DEFAULT_MAX_BODY_BYTES);
+    connectionOptions.m_maxKeepAliveRequests =
+        serverConfigInfo.value("MaxKeepAliveRequests", connectionOptions.m_maxKeepAliveRequests);
+    connectionOptions.m_outputHighWater = serverConfigInfo.value("OutputHighWater", connectionOptions.m_outputHighWater);
+    m_reactorQueueCapacity = serverConfigInfo.value("ReactorQueueCapacity", Reactor::DEFAULT_QUEUE_CAPACITY);
+    m_connectionPoolSize = serverConfigInfo.value("ConnectionPoolSize", size_t(1024));
+    m_bReusePort = serverConfigInfo.value("ReusePort", false);
+    m_iListenBacklog = serverConfigInfo.value("ListenBacklog", 1024);
+    m_iAcceptStatsIntervalSeconds = serverConfigInfo.value("AcceptStatsInterval_S", 0);
+    m_iBlockingThreads = std::max(0, serverConfigInfo.value("BlockingThreads", 0));
+    m_sBlockingPool = serverConfigInfo.value("BlockingPool", string("mutex"));
+    m_sIoBackend = serverConfigInfo.value("IoBackend", string("libevent"));
+    maxConnections = serverConfigInfo.value("MaxConnections", size_t(0));
+    /* 至少为 1：上限为 1 时连接数降到 0 即恢复，否则第一个连接之后永远不再接受 */
+    if (maxConnections > 0)
+        resumeConnections = std::max<size_t>(1, maxConnections - std::max<size_t>(1, maxConnections / 10));
+    loadResponseCache(serverConfigInfo.value("ResponseCache", JSON::json::object()));
+    loadCompression(serverConfigInfo.value("Compression", JSON::json::object()));
+    loadHttp2(serverConfigInfo.value("Http2", JSON::json::object()));
+    loadPubSub(serverConfigInfo.value("PubSub", JSON::json::object()));
+    loadAffinity(serverConfigInfo.value("Affinity", JSON::json::object()));
+    loadConcurrencyLimit(serverConfigInfo.value("ConcurrencyLimit", JSON::json::object()));
+    loadRateLimit(serverConfigInfo.value("RateLimit", JSON::json::object()));
+    loadContentHandlers(serverConfigInfo.value("Handlers", JSON::json::array()));
 }
 
-void HttpServer::run()
+void HttpServer::loadResponseCache(const nlohmann::json& Config)
 {
-    struct event_base* base = event_base_new();
-    info("{} base ptr [{}]", __FUNCTION__, fmt::ptr(base));
-    if (!base)
-    {
-        warn("open event base failed");
+    ResponseCacheOptions options;
+    options.m_maxBytes = Config.value("MaxBytes", options.m_maxBytes);
+    if (options.m_maxBytes == 0)
+        return;
+    options.m_shards = std::max<size_t>(1, Config.value("Shards", options.m_shards));
+    options.m_maxEntryBytes = Config.value("MaxEntryBytes", options.m_maxEntryBytes);
+    options.m_defaultTtl = chrono::seconds(Config.value("DefaultTtl_S", options.m_defaultTtl.count()));
+    options.m_vary = Config.value("Vary", options.m_vary);
+    info("{} max bytes[{}] shards[{}] vary{}", __FUNCTION__, options.m_maxBytes, options.m_shards, options.m_vary);
+    responseCache = make_unique<ResponseCache>(std::move(options));
+    connectionOptions.m_responseCache = responseCache.get();
+}
+
+void HttpServer::loadCompression(const nlohmann::json& Config)
+{
+    ResponseCompressorOptions options;
+    options.m_level = std::min(9, Config.value("Level", 0));
+    if (options.m_level <= 0)
+        return;
+    options.m_minBytes = Config.value("MinBytes", options.m_minBytes);
+    options.m_maxBytes = Config.value("MaxBytes", options.m_maxBytes);
+    options.m_variantCacheBytes = Config.value("VariantCacheBytes", options.m_variantCacheBytes);
+    options.m_shards = std::max<size_t>(1, Config.value("Shards", options.m_shards));
+    options.m_types = Config.value("Types", options.m_types);
+    info("{} level[{}] min bytes[{}] variant cache bytes[{}] types{}", __FUNCTION__, options.m_level, options.m_minBytes,
+        options.m_variantCacheBytes, options.m_types);
+    responseCompressor = make_unique<ResponseCompressor>(std::move(options));
+    connectionOptions.m_compressor = responseCompressor.get();
+}
+
+void HttpServer::loadHttp2(const nlohmann::json& Config)
+{
+    auto& options = connectionOptions.m_http2;
+    options.m_enabled = Config.value("Enabled", options.m_enabled);
+    options.m_maxConcurrentStreams = std::max<uint32_t>(1, Config.value("MaxConcurrentStreams", options.m_maxConcurrentStreams));
+    /* 窗口不能小于协议默认值（连接窗口只能放大）也不能超过 2^31-1，帧大小限定在协议允许的范围内 */
+    options.m_streamWindow = std::clamp<uint32_t>(
+        Config.value("StreamWindow", options.m_streamWindow), ToolKit::HTTP2_DEFAULT_WINDOW, ToolKit::HTTP2_MAX_WINDOW);
+    options.m_connectionWindow = std::clamp<uint32_t>(
+        Config.value("ConnectionWindow", options.m_connectionWindow), ToolKit::HTTP2_DEFAULT_WINDOW, ToolKit::HTTP2_MAX_WINDOW);
+    options.m_maxFrameSize =
+        std::clamp<uint32_t>(Config.value("MaxFrameSize", options.m_maxFrameSize), ToolKit::HTTP2_DEFAULT_FRAME_SIZE, 0xffffff);
+    info("{} enabled[{}] max streams[{}] stream window[{}] connection window[{}] max frame[{}]", __FUNCTION__,
+        options.m_enabled, options.m_maxConcurrentStreams, options.m_streamWindow, options.m_connectionWindow,
+        options.m_maxFrameSize);
+}
+
+void HttpServer::loadAffinity(const nlohmann::json& Config)
+{
+    m_reactorCpus = parseCpuList(Config.value("ReactorCpus", string()));
+    m_blockingCpus = parseCpuList(Config.value("BlockingCpus", string()));
+    if (!m_reactorCpus.empty() || !m_blockingCpus.empty())
+        info("{} reactor cpus{} blocking cpus{}", __FUNCTION__, m_reactorCpus, m_blockingCpus);
+}
+
+void HttpServer::loadConcurrencyLimit(const nlohmann::json& Config)
+{
+    ConcurrencyLimiterOptions options;
+    options.m_maxLimit = Config.value("MaxLimit", options.m_maxLimit);
+    if (options.m_maxLimit == 0)
         return;
+    options.m_initialLimit = Config.value("InitialLimit", options.m_initialLimit);
+    options.m_minLimit = Config.value("MinLimit", options.m_minLimit);
+    options.m_window = chrono::milliseconds(std::max<int64_t>(1, Config.value("Window_Ms", options.m_window.count())));
+    options.m_minSamples = Config.value("MinSamples", options.m_minSamples);
+    options.m_tolerance = Config.value("Tolerance", options.m_tolerance);
+    options.m_smoothing = Config.value("Smoothing", options.m_smoothing);
+    concurrencyLimiter = make_unique<ConcurrencyLimiter>(options);
+    info("{} limit[{}] range[{}, {}] window[{}ms] tolerance[{}]", __FUNCTION__, concurrencyLimiter->limit(),
+        options.m_minLimit, options.m_maxLimit, options.m_window.count(), options.m_tolerance);
+    connectionOptions.m_limiter = concurrencyLimiter.get();
+}
+
+void HttpServer::loadRateLimit(const nlohmann::json& Config)
+{
+    RateLimiterOptions options;
+    options.m_rate = Config.value("Rate", options.m_rate);
+    if (options.m_rate <= 0)
+        return;
+    options.m_burst = Config.value("Burst", options.m_burst);
+    options.m_shards = std::max<size_t>(1, Config.value("Shards", options.m_shards));
+    options.m_slotsPerShard = Config.value("SlotsPerShard", options.m_slotsPerShard);
+    options.m_header = Config.value("Header", options.m_header);
+    options.m_limitAccepts = Config.value("LimitAccepts", options.m_limitAccepts);
+    info("{} rate[{}/s] burst[{}] shards[{}] slots per shard[{}] header[{}] limit accepts[{}]", __FUNCTION__, options.m_rate,
+        options.m_burst, options.m_shards, options.m_slotsPerShard, options.m_header, options.m_limitAccepts);
+    rateLimiter = make_unique<RateLimiter>(std::move(options));
+    connectionOptions.m_rateLimiter = rateLimiter.get();
+}
+
+void HttpServer::loadPubSub(const nlohmann::json& Config)
+{
+    PubSubOptions options;
+    options.m_maxPendingBytes = std::max<size_t>(1, Config.value("MaxPendingBytes", options.m_maxPendingBytes));
+    options.m_disconnectSlow = Config.value("DisconnectSlow", options.m_disconnectSlow);
+    info("{} max pending bytes[{}] disconnect slow[{}]", __FUNCTION__, options.m_maxPendingBytes, options.m_disconnectSlow);
+    /* 只有订阅者所在的分片会收到投递，订阅者都在已启动的 Reactor 上 */
+    pubSub = make_unique<PubSub>(
+        static_cast<size_t>(m_iThreadNums),
+        [](size_t Shard, SmallTask&& Task)
+        {
+            if (Shard < reactors.size())
+                reactors[Shard]->runInLoop(std::move(Task));
+        },
+        options);
+    connectionOptions.m_pubSub = pubSub.get();
+}
+
+void HttpServer::loadContentHandlers(const nlohmann::json& Handlers)
+{
+    for (const auto& config : Handlers)
+    {
+        auto type = config.value("Type", string());
+        auto prefix = config.value("Prefix", string());
+        shared_ptr<HttpContentHandler> handler = ContentHandlerFactory::instance().getProductClass(type, config);
+        if (!handler || prefix.empty())
+        {
+            warn("{} skip handler type[{}] prefix[{}]", __FUNCTION__, type, prefix);
+            continue;
+        }
+        addPrefixHandler(
+            prefix, [handler](const HttpRequest& Request, HttpResponse& Response) { handler->handle(Request, Response); },
+            config.value("Blocking", false) ? HANDLER_MODE::BLOCKING : HANDLER_MODE::INLINE);
+        contentHandlers.emplace_back(prefix, std::move(handler));
+    }
+}
+
+std::vector<size_t> HttpServer::acceptedPerListener() const
+{
+    if (!m_bReusePort)
+        return { sharedListenerAccepted.load(memory_order_relaxed) };
+    std::vector<size_t> counts;
+    for (auto& reactor : reactors)
+        counts.push_back(reactor->accepted());
+    return counts;
+}
+
+std::vector<std::pair<std::string, std::string>> HttpServer::componentStats() const
+{
+    std::vector<std::pair<std::string, std::string>> result;
+    if (responseCache)
+    {
+        auto stats = responseCache->stats();
+        result.emplace_back("response cache",
+            fmt::format("hits[{}] misses[{}] stores[{}] evictions[{}] expirations[{}] entries[{}] bytes[{}]", stats.m_hits,
+                stats.m_misses, stats.m_stores, stats.m_evictions, stats.m_expirations, stats.m_entries, stats.m_bytes));
+    }
+    if (responseCompressor)
+    {
+        auto stats = responseCompressor->stats();
+        result.emplace_back("compression",
+            fmt::format("compressed[{}] bytes[{} -> {}] variant hits[{}] stores[{}] evictions[{}] entries[{}] bytes[{}]",
+                stats.m_compressed, stats.m_bytesIn, stats.m_bytesOut, stats.m_variantHits, stats.m_variantStores,
+                stats.m_evictions, stats.m_entries, stats.m_bytes));
+    }
+    if (pubSub)
+    {
+        auto stats = pubSub->stats();
+        result.emplace_back("pubsub",
+            fmt::format("published[{}] deliveries[{}] dropped[{}] disconnected[{}] subscriptions[{}]", stats.m_published,
+                stats.m_deliveries, stats.m_dropped, stats.m_disconnected, stats.m_subscriptions));
+    }
+    if (concurrencyLimiter)
+    {
+        auto stats = concurrencyLimiter->stats();
+        result.emplace_back("concurrency limiter",
+            fmt::format("admitted[{}] shed[{}] limit[{}] inflight[{}] latency[{}us] baseline[{}us]", stats.m_admitted,
+                stats.m_shed, stats.m_limit, stats.m_inflight, stats.m_latency.count(), stats.m_baseline.count()));
+    }
+    if (rateLimiter)
+    {
+        auto stats = rateLimiter->stats();
+        result.emplace_back("rate limiter",
+            fmt::format("allowed[{}] limited[{}] limited connections[{}] clients[{}] evictions[{}] saturated[{}]",
+                stats.m_allowed, stats.m_limited, rateLimitedConnections.load(memory_order_relaxed), stats.m_entries,
+                stats.m_evictions, stats.m_saturated));
+    }
+    if (maxConnections > 0)
+    {
+        result.emplace_back("connections",
+            fmt::format("live[{}] max[{}] rejected[{}] accept pauses[{}] paused[{}]", liveConnections.load(memory_order_relaxed),
+                maxConnections, rejectedConnections.load(memory_order_relaxed), acceptPauses.load(memory_order_relaxed),
+                acceptPaused.load()));
     }
+    for (auto& [prefix, handler] : contentHandlers)
+    {
+        auto stats = handler->stats();
+        if (!stats.empty())
+            result.emplace_back("handler[" + prefix + "]", std::move(stats));
+    }
+    return result;
+}
+
+void HttpServer::setRequestHandler(HttpRequestHandler Handler)
+{
+    defaultHandler.m_handler = std::move(Handler);
+}
+
+void HttpServer::addHandler(const std::string& Path, HttpRequestHandler Handler, HANDLER_MODE Mode)
+{
+    addRoute(Path, std::move(Handler), Mode);
+}
+
+void HttpServer::addPrefixHandler(const std::string& Prefix, HttpRequestHandler Handler, HANDLER_MODE Mode)
+{
+    addRoute(Prefix + "*", std::move(Handler), Mode);
+}
+
+void HttpServer::addRoute(const std::string& Pattern, HttpRequestHandler Handler, HANDLER_MODE Mode)
+{
+    /* 同一模式上的 WebSocket 与推送流处理函数保留 */
+    auto& route = pendingRoutes[Pattern];
+    route.m_handler = std::move(Handler);
+    route.m_mode = Mode;
+}
+
+void HttpServer::addWebSocket(const std::string& Pattern, WebSocketHandler Handler)
+{
+    pendingRoutes[Pattern].m_webSocket = std::make_shared<const WebSocketHandler>(std::move(Handler));
+}
+
+void HttpServer::addEventStream(const std::string& Pattern, EventStreamHandler Handler)
+{
+    pendingRoutes[Pattern].m_eventStream = std::make_shared<const EventStreamHandler>(std::move(Handler));
+}
+
+void HttpServer::addCoroutineRoute(const std::string& Pattern, HttpCoroutineHandler Handler)
+{
+    pendingRoutes[Pattern].m_coroutine = std::make_shared<const CoroutineHandler>(CoroutineHandler { std::move(Handler) });
+}
+
+size_t HttpServer::publish(std::string_view Topic, std::string_view Data)
+{
+    return pubSub->publish(Topic, Data);
+}
+
+void HttpServer::buildRouter()
+{
+    /* 静态注册的路由在前，与 addRoute 登记的模式相同时后者覆盖前者 */
+    auto routes = RouteRegistry::instance().routes();
+    routes.erase(std::remove_if(routes.begin(), routes.end(),
+                     [](const auto& Route) { return pendingRoutes.count(Route.first) != 0; }),
+        routes.end());
+    routes.insert(routes.end(), pendingRoutes.begin(), pendingRoutes.end());
+    router = Router(routes);
+    info("{} {} routes", __FUNCTION__, router.size());
+}
+
+void HttpServer::run()
+{
+    buildRouter();
+    /* 对端已关闭时写套接字不能让进程退出，bufferevent 与 SocketStream 都按写出错关闭连接 */
+    signal(SIGPIPE, SIG_IGN);
     int ret = evthread_use_pthreads();
     if (ret != 0)
     {
         warn("set event use pthread failed");
         return;
     }
+    struct event_base* base = event_base_new();
+    info("{} base ptr [{}]", __FUNCTION__, fmt::ptr(base));
+    if (!base)
+    {
+        warn("open event base failed");
+        return;
+    }
     struct sockaddr_in serveraddr;
 
     memset(&serveraddr, 0, sizeof(serveraddr));
@@ -179,17 +919,80 @@ void HttpServer::run()
     serveraddr.sin_port = htons(m_iPort);
     serveraddr.sin_addr.s_addr = inet_addr(m_sIpAddr.c_str());
 
-    auto* listener = evconnlistener_new_bind(
-        base, onAcceptCb, NULL, LEV_OPT_REUSEABLE, 10, (const struct sockaddr*)(&serveraddr), sizeof(serveraddr));
-    if (!listener)
+    if (m_iBlockingThreads > 0)
     {
-        warn("Listener init error\n");
-        return;
+        info("blocking handlers run on {} pool with {} threads", m_sBlockingPool, m_iBlockingThreads);
+        blockingClosed.store(false);
+        if (m_sBlockingPool == "work-stealing")
+            submitBlocking = [pool = make_shared<WorkStealingThreadPool>(m_iBlockingThreads, m_blockingCpus)](SmallTask&& Task)
+            { pool->post(std::move(Task)); };
+        else
+            submitBlocking = [pool = make_shared<ThreadPool>(m_iBlockingThreads, m_blockingCpus)](SmallTask&& Task)
+            { pool->post(std::move(Task)); };
     }
-    evconnlistener_set_error_cb(listener, acceptErrorCb);
-    event_base_dispatch(base);
 
+    IO_BACKEND backend = parseIoBackend(m_sIoBackend);
+    info("reactors use {} io backend", ioBackendName(backend));
+    for (int i = 0; i < m_iThreadNums; i++)
+    {
+        /* Reactor 依次固定在 ReactorCpus 的各个 CPU 上，它的队列、Poller 与缓冲区环在所在节点上创建；
+           连接对象在 Reactor 线程上首次分配，随线程落在同一节点 */
+        int cpu = m_reactorCpus.empty() ? -1 : m_reactorCpus[i % m_reactorCpus.size()];
+        MemoryNodeScope nodeScope(cpu < 0 ? -1 : cpuNode(cpu));
+        connectionPools.emplace_back(std::make_unique<SlabPool<connection_t>>(m_connectionPoolSize));
+        reactors.emplace_back(std::make_unique<Reactor>(i, onConnectionHandoff, m_reactorQueueCapacity, backend));
+        reactors.back()->setCpuAffinity(cpu);
+        bool listening = !m_bReusePort
+            || reactors.back()->listen((const struct sockaddr*)(&serveraddr), sizeof(serveraddr), m_iListenBacklog);
+        if (!listening || !reactors.back()->enableTimers(m_timerTick) || !reactors.back()->start())
+        {
+            warn("reactor[{}] start failed", i);
+            shutdownReactors();
+            event_base_free(base);
+            return;
+        }
+    }
+
+    struct evconnlistener* listener = nullptr;
+    if (!m_bReusePort)
+    {
+        /* 连接数降下来时 Reactor 线程直接恢复监听，监听器需要自带锁 */
+        listener = evconnlistener_new_bind(base, onAcceptCb, NULL, LEV_OPT_REUSEABLE | LEV_OPT_CLOSE_ON_FREE | LEV_OPT_THREADSAFE,
+            m_iListenBacklog, (const struct sockaddr*)(&serveraddr), sizeof(serveraddr));
+        if (!listener)
+        {
+            warn("Listener init error\n");
+            shutdownReactors();
+            event_base_free(base);
+            return;
+        }
+        evconnlistener_set_error_cb(listener, acceptErrorCb);
+        lock_guard<mutex> lock(acceptGateMutex);
+        sharedListener = listener;
+    }
+
+    struct event* statsTimer = nullptr;
+    if (m_iAcceptStatsIntervalSeconds > 0)
+    {
+        struct timeval interval { m_iAcceptStatsIntervalSeconds, 0 };
+        statsTimer = event_new(base, -1, EV_PERSIST, onAcceptStatsTimer, nullptr);
+        event_add(statsTimer, &interval);
+    }
+
+    /* SO_REUSEPORT 模式下主线程上没有监听事件，仍需阻塞在事件循环中 */
+    event_base_loop(base, EVLOOP_NO_EXIT_ON_EMPTY);
+
+    if (statsTimer != nullptr)
+        event_free(statsTimer);
+    if (listener != nullptr)
+    {
+        {
+            lock_guard<mutex> lock(acceptGateMutex);
+            sharedListener = nullptr;
+        }
+        evconnlistener_free(listener);
+    }
+    shutdownReactors();
     event_base_free(base);
-    evconnlistener_free(listener);
 }
 }   // namespace ToolKit
@@ -1,5 +1,16 @@
 #pragma once
+#include "EventStream.h"
+#include "HttpConnection.h"
+#include "HttpCoroutine.h"
+#include "WebSocket.h"
+#include "nlohmann/json.hpp"
+
+#include <chrono>
+#include <cstddef>
 #include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 
 namespace ToolKit
@@ -16,12 +27,146 @@ public:
 public:
     void run();
 
+    /**
+     * @brief 设置请求处理函数，需在 run 之前调用；未设置时所有请求返回 404
+     */
+    void setRequestHandler(HttpRequestHandler Handler);
+
+    /**
+     * @brief 为路径精确匹配的请求注册处理函数，需在 run 之前调用，未匹配的请求交给 setRequestHandler 设置的函数
+     * Mode 为 BLOCKING 时处理函数在阻塞线程池中执行（配置项 BlockingThreads 为 0 时仍在 Reactor 线程执行）。
+     * Path 按路由模式解析，含 : 或 * 时等同于 addRoute。
+     */
+    void addHandler(const std::string& Path, HttpRequestHandler Handler, HANDLER_MODE Mode = HANDLER_MODE::INLINE);
+
+    /**
+     * @brief 为以 Prefix 开头的请求注册处理函数，等同于 addRoute(Prefix + "*")；更长的静态前缀与精确路径优先
+     * 配置项 Handlers 中的条目在构造时由 ContentHandlerFactory 按 Type 创建后通过这里挂载。
+     */
+    void addPrefixHandler(const std::string& Prefix, HttpRequestHandler Handler, HANDLER_MODE Mode = HANDLER_MODE::INLINE);
+
+    /**
+     * @brief 按路由模式注册处理函数，需在 run 之前调用，模式语法见 Router
+     * 路径参数通过 HttpRequest::param 读取。也可以在任意编译单元中用静态的 RouteRegistrar 注册，
+     * 两者模式相同时以这里注册的为准。
+     */
+    void addRoute(const std::string& Pattern, HttpRequestHandler Handler, HANDLER_MODE Mode = HANDLER_MODE::INLINE);
+
+    /**
+     * @brief 在路由模式上接受 WebSocket 升级，需在 run 之前调用；回调在连接所属的 Reactor 线程上执行
+     * 同一模式可以再用 addRoute 注册处理普通请求的函数，否则普通请求得到 426 响应。
+     */
+    void addWebSocket(const std::string& Pattern, WebSocketHandler Handler);
+
+    /**
+     * @brief 在路由模式上为 GET 请求提供推送流（SSE 或原始字节流），需在 run 之前调用
+     * 同一模式可以再用 addRoute 注册处理其他方法的函数，否则其他方法得到 405 响应。
+     */
+    void addEventStream(const std::string& Pattern, EventStreamHandler Handler);
+
+    /**
+     * @brief 在路由模式上注册协程处理函数，需在 run 之前调用；处理函数在连接所属的 Reactor 线程上运行，
+     * 可以 co_await 读取请求体、带背压写出响应、把计算交给阻塞线程池以及等待定时器，见 CoroutineSession
+     * 同一模式上 addWebSocket 注册的升级仍然生效；HTTP/2 连接上的请求不支持协程处理函数，得到 505 响应。
+     */
+    void addCoroutineRoute(const std::string& Pattern, HttpCoroutineHandler Handler);
+
+    /**
+     * @brief 向主题发布一条消息，可在任意线程调用；推送流与 WebSocket 会话通过 subscribe 订阅
+     * 消息按各订阅者的编码只生成一份，投递到订阅者所在的 Reactor，积压超过配置项 PubSub.MaxPendingBytes 的订阅者
+     * 丢弃该消息，DisconnectSlow 为 true 时同时断开。
+     *
+     * @return size_t 投递到的 Reactor 数，为 0 表示当前没有订阅者
+     */
+    size_t publish(std::string_view Topic, std::string_view Data);
+
+    /**
+     * @brief 每个监听套接字已接受的连接数
+     * 单监听模式下只有一个元素；ReusePort 模式下按 Reactor 顺序排列，可用来确认内核分发是否均匀。
+     */
+    std::vector<size_t> acceptedPerListener() const;
+
+    /**
+     * @brief 各组件的运行统计：响应缓存与压缩（启用时）、发布订阅、并发限制、速率限制与连接数上限（启用时，含拒绝数）
+     * 以及配置创建的内容处理器（如文件缓存命中率），处理器按挂载前缀列出
+     */
+    std::vector<std::pair<std::string, std::string>> componentStats() const;
+
 private:
     HttpServer();
 
+    /**
+     * @brief 合并静态注册与 addRoute 登记的路由，构建只读的 Router
+     */
+    void buildRouter();
+
+    /**
+     * @brief 按配置创建内容处理器：每个条目含 Type、Prefix、可选的 Blocking，其余字段交给具体处理器解析
+     */
+    void loadContentHandlers(const nlohmann::json& Handlers);
+
+    /**
+     * @brief 按配置创建响应缓存：MaxBytes 为 0 或缺省时不启用
+     */
+    void loadResponseCache(const nlohmann::json& Config);
+
+    /**
+     * @brief 按配置创建响应压缩：Level 为 0 或缺省时不启用
+     */
+    void loadCompression(const nlohmann::json& Config);
+
+    /**
+     * @brief 按配置设置 h2c：Enabled 为 false 时只提供 HTTP/1.1
+     */
+    void loadHttp2(const nlohmann::json& Config);
+
+    /**
+     * @brief 按配置设置发布订阅：MaxPendingBytes 为单个订阅者的积压上限，DisconnectSlow 决定超限时是否断开
+     */
+    void loadPubSub(const nlohmann::json& Config);
+
+    /**
+     * @brief 按配置设置线程的 CPU 亲和性：ReactorCpus 与 BlockingCpus 为 cpulist 格式（如 "0-3,8"），空串表示不限定
+     * Reactor 按顺序各占一个 CPU（Reactor 多于 CPU 时循环使用），ReusePort 模式下监听套接字同时设置 SO_INCOMING_CPU；
+     * 阻塞线程池的工作线程共享 BlockingCpus 中的全部 CPU。
+     */
+    void loadAffinity(const nlohmann::json& Config);
+
+    /**
+     * @brief 按配置创建阻塞调用的自适应并发限制：MaxLimit 为 0 或缺省时不启用，BlockingThreads 为 0 时不起作用
+     * 连接数上限由 ServerInfo 的 MaxConnections 设置（0 表示不限），达到上限时暂停接受新连接，
+     * 降到上限的九成（至少少一个）以下再恢复。
+     */
+    void loadConcurrencyLimit(const nlohmann::json& Config);
+
+    /**
+     * @brief 按配置创建按客户端的速率限制：Rate 为每秒令牌数，为 0 或缺省时不启用；Burst 为突发容量，
+     * Header 不为空时带该首部的请求在对端地址之外再按首部值限速；LimitAccepts 为 true 时新连接同样消耗令牌
+     */
+    void loadRateLimit(const nlohmann::json& Config);
+
 private:
     std::string m_sIpAddr;
     int m_iPort;
+    /* Reactor 线程数，每个线程独占一个事件循环 */
     int m_iThreadNums;
+    size_t m_reactorQueueCapacity;
+    /* 每个 Reactor 保留的空闲连接对象上限 */
+    size_t m_connectionPoolSize;
+    /* 每个 Reactor 以 SO_REUSEPORT 各自监听，取消单独的接收线程 */
+    bool m_bReusePort;
+    int m_iListenBacklog;
+    int m_iAcceptStatsIntervalSeconds;
+    /* Reactor 时间轮的刻度，连接超时的精度 */
+    std::chrono::milliseconds m_timerTick;
+    /* 执行 BLOCKING 处理函数的线程数，0 表示不启用线程池 */
+    int m_iBlockingThreads;
+    /* 阻塞线程池的实现：mutex 或 work-stealing */
+    std::string m_sBlockingPool;
+    /* Reactor 的 I/O 后端：libevent、epoll 或 io_uring（不可用时退回 epoll） */
+    std::string m_sIoBackend;
+    /* Reactor 线程与阻塞线程池可以运行的 CPU，为空表示不限定 */
+    std::vector<int> m_reactorCpus;
+    std::vector<int> m_blockingCpus;
 };
-}   // namespace ToolKit
\ No newline at end of file
+}   // namespace ToolKit
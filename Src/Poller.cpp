@@ -0,0 +1,295 @@
+#include "Poller.h"
+
+#include "UringPoller.h"
+
+#include "spdlog/spdlog.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <event2/event.h>
+#include <event2/thread.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+namespace ToolKit
+{
+const char* ioBackendName(IO_BACKEND Backend)
+{
+    switch (Backend)
+    {
+        case IO_BACKEND::EPOLL:
+            return "epoll";
+        case IO_BACKEND::URING:
+            return "io_uring";
+        default:
+            return "libevent";
+    }
+}
+
+IO_BACKEND parseIoBackend(const std::string& Name, IO_BACKEND Default)
+{
+    if (Name == "epoll")
+        return IO_BACKEND::EPOLL;
+    if (Name == "io_uring" || Name == "uring")
+        return IO_BACKEND::URING;
+    if (Name == "libevent")
+        return IO_BACKEND::LIBEVENT;
+    return Default;
+}
+
+std::unique_ptr<Poller> Poller::create(IO_BACKEND Backend)
+{
+    if (Backend == IO_BACKEND::URING)
+    {
+        auto uring = std::make_unique<UringPoller>();
+        if (uring->valid())
+            return uring;
+        spdlog::warn("{} io_uring unavailable, fall back to epoll", __FUNCTION__);
+        Backend = IO_BACKEND::EPOLL;
+    }
+    if (Backend == IO_BACKEND::EPOLL)
+        return std::make_unique<EpollPoller>();
+    return std::make_unique<LibeventPoller>();
+}
+
+void Poller::cancelDeferred(void* Arg)
+{
+    for (auto* list : { &m_deferred, &m_running })
+    {
+        for (auto& deferred : *list)
+        {
+            if (deferred.m_arg == Arg)
+                deferred.m_callback = nullptr;
+        }
+    }
+}
+
+void Poller::runDeferred()
+{
+    /* 回调中新登记的放到下一批，直到没有新的登记 */
+    while (!m_deferred.empty())
+    {
+        m_running.swap(m_deferred);
+        for (size_t i = 0; i < m_running.size(); i++)
+        {
+            if (m_running[i].m_callback != nullptr)
+                m_running[i].m_callback(-1, 0, m_running[i].m_arg);
+        }
+        m_running.clear();
+    }
+}
+
+bool Poller::armTick(std::chrono::milliseconds Interval, PollCallback Callback, void* Arg)
+{
+    if (m_tickCallback != nullptr)
+        return false;
+    m_tickInterval = std::max(Interval, std::chrono::milliseconds(1));
+    m_nextTick = std::chrono::steady_clock::now() + m_tickInterval;
+    m_tickCallback = Callback;
+    m_tickArg = Arg;
+    return true;
+}
+
+int Poller::tickTimeout() const
+{
+    if (m_tickCallback == nullptr)
+        return -1;
+    auto now = std::chrono::steady_clock::now();
+    if (now >= m_nextTick)
+        return 0;
+    /* 向上取整，避免在刻度到达之前醒来空转 */
+    return static_cast<int>(std::chrono::ceil<std::chrono::milliseconds>(m_nextTick - now).count());
+}
+
+void Poller::runTick()
+{
+    if (m_tickCallback == nullptr || std::chrono::steady_clock::now() < m_nextTick)
+        return;
+    /* 落后多个刻度时只回调一次，Reactor 按实际经过的时间推进时间轮 */
+    m_nextTick = std::max(m_nextTick + m_tickInterval, std::chrono::steady_clock::now());
+    m_tickCallback(-1, 0, m_tickArg);
+}
+
+LibeventPoller::LibeventPoller()
+{
+    /* 其他线程调用 event_active 需要 event_base 带锁并能被通知，须在创建 event_base 之前启用 */
+    static const int threadsEnabled = evthread_use_pthreads();
+    if (threadsEnabled == 0)
+        m_base = event_base_new();
+}
+
+LibeventPoller::~LibeventPoller()
+{
+    if (m_tick.m_event != nullptr)
+        event_free(m_tick.m_event);
+    if (m_base != nullptr)
+        event_base_free(m_base);
+}
+
+void LibeventPoller::onEvent(int Fd, short Events, void* Arg)
+{
+    auto* watch = static_cast<PollWatch*>(Arg);
+    uint32_t ready = 0;
+    if (Events & EV_READ)
+        ready |= POLL_READ;
+    if (Events & EV_WRITE)
+        ready |= POLL_WRITE;
+    if (Events & EV_CLOSED)
+        ready |= POLL_HANGUP | POLL_READ;
+    watch->m_callback(Fd, ready, watch->m_arg);
+}
+
+bool LibeventPoller::add(PollWatch& Watch, int Fd, uint32_t Events, PollCallback Callback, void* Arg)
+{
+    if (m_base == nullptr)
+        return false;
+    short what = EV_PERSIST;
+    if (Events & POLL_READ)
+        what |= EV_READ | EV_CLOSED;
+    if (Events & POLL_WRITE)
+        what |= EV_WRITE;
+    if (Events & POLL_EDGE)
+        what |= EV_ET;
+    Watch.m_fd = Fd;
+    Watch.m_callback = Callback;
+    Watch.m_arg = Arg;
+    Watch.m_event = event_new(m_base, Fd, what, onEvent, &Watch);
+    if (Watch.m_event == nullptr || event_add(Watch.m_event, nullptr) != 0)
+    {
+        remove(Watch);
+        return false;
+    }
+    return true;
+}
+
+void LibeventPoller::remove(PollWatch& Watch)
+{
+    /* event_free 同时撤销已激活但尚未执行的回调 */
+    if (Watch.m_event != nullptr)
+        event_free(Watch.m_event);
+    Watch.m_event = nullptr;
+    Watch.m_fd = -1;
+}
+
+bool LibeventPoller::setTick(std::chrono::milliseconds Interval, PollCallback Callback, void* Arg)
+{
+    if (m_base == nullptr || m_tick.m_event != nullptr)
+        return false;
+    auto micros = std::chrono::duration_cast<std::chrono::microseconds>(Interval).count();
+    struct timeval interval { static_cast<time_t>(micros / 1000000), static_cast<suseconds_t>(micros % 1000000) };
+    m_tick.m_callback = Callback;
+    m_tick.m_arg = Arg;
+    m_tick.m_event = event_new(m_base, -1, EV_PERSIST, onEvent, &m_tick);
+    return m_tick.m_event != nullptr && event_add(m_tick.m_event, &interval) == 0;
+}
+
+void LibeventPoller::run()
+{
+    m_broken = false;
+    /* 每次处理一轮就绪事件，之后执行延后的回调 */
+    while (!m_broken)
+    {
+        if (event_base_loop(m_base, EVLOOP_ONCE) != 0)
+            break;
+        runDeferred();
+    }
+}
+
+void LibeventPoller::breakLoop()
+{
+    m_broken = true;
+    event_base_loopbreak(m_base);
+}
+
+EpollPoller::EpollPoller()
+        : m_ready(MAX_EVENTS)
+{
+    m_epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (m_epollFd < 0)
+        spdlog::warn("{} epoll_create1 failed, error[{}]", __FUNCTION__, strerror(errno));
+}
+
+EpollPoller::~EpollPoller()
+{
+    if (m_epollFd >= 0)
+        close(m_epollFd);
+}
+
+bool EpollPoller::add(PollWatch& Watch, int Fd, uint32_t Events, PollCallback Callback, void* Arg)
+{
+    if (m_epollFd < 0)
+        return false;
+    struct epoll_event event {};
+    if (Events & POLL_READ)
+        event.events |= EPOLLIN | EPOLLRDHUP;
+    if (Events & POLL_WRITE)
+        event.events |= EPOLLOUT;
+    if (Events & POLL_EDGE)
+        event.events |= EPOLLET;
+    event.data.ptr = &Watch;
+    Watch.m_fd = Fd;
+    Watch.m_callback = Callback;
+    Watch.m_arg = Arg;
+    if (epoll_ctl(m_epollFd, EPOLL_CTL_ADD, Fd, &event) != 0)
+    {
+        spdlog::warn("{} epoll_ctl add fd[{}] failed, error[{}]", __FUNCTION__, Fd, strerror(errno));
+        Watch.m_fd = -1;
+        return false;
+    }
+    return true;
+}
+
+void EpollPoller::remove(PollWatch& Watch)
+{
+    if (Watch.m_fd < 0)
+        return;
+    epoll_ctl(m_epollFd, EPOLL_CTL_DEL, Watch.m_fd, nullptr);
+    Watch.m_fd = -1;
+    /* 同一轮中排在后面的就绪事件可能属于刚注销的 fd，它的存储马上会被复用 */
+    for (size_t i = m_dispatching; i < m_readyCount; i++)
+    {
+        if (m_ready[i].data.ptr == &Watch)
+            m_ready[i].data.ptr = nullptr;
+    }
+}
+
+bool EpollPoller::setTick(std::chrono::milliseconds Interval, PollCallback Callback, void* Arg)
+{
+    return armTick(Interval, Callback, Arg);
+}
+
+void EpollPoller::run()
+{
+    m_broken = false;
+    while (!m_broken)
+    {
+        int count = epoll_wait(m_epollFd, m_ready.data(), static_cast<int>(m_ready.size()), tickTimeout());
+        if (count < 0 && errno != EINTR)
+        {
+            spdlog::warn("{} epoll_wait failed, error[{}]", __FUNCTION__, strerror(errno));
+            break;
+        }
+        m_readyCount = static_cast<size_t>(std::max(count, 0));
+        for (m_dispatching = 0; m_dispatching < m_readyCount; m_dispatching++)
+        {
+            const auto& event = m_ready[m_dispatching];
+            auto* watch = static_cast<PollWatch*>(event.data.ptr);
+            if (watch == nullptr)
+                continue;
+            uint32_t ready = 0;
+            if (event.events & EPOLLIN)
+                ready |= POLL_READ;
+            if (event.events & EPOLLOUT)
+                ready |= POLL_WRITE;
+            /* 挂断与出错都要靠读取拿到 EOF 或错误码 */
+            if (event.events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR))
+                ready |= POLL_HANGUP | POLL_READ;
+            watch->m_callback(watch->m_fd, ready, watch->m_arg);
+        }
+        m_dispatching = m_readyCount = 0;
+        runTick();
+        runDeferred();
+    }
+}
+}   // namespace ToolKit
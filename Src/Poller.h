@@ -0,0 +1,196 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct epoll_event;
+struct event;
+struct event_base;
+
+namespace ToolKit
+{
+struct UringOp;
+
+/**
+ * @brief Reactor 的 I/O 多路复用后端
+ * LIBEVENT 以 event_base 驱动，连接使用 bufferevent；EPOLL 直接使用边沿触发的 epoll，连接使用 SocketStream；
+ * URING 以 io_uring 完成事件驱动，连接同样使用 SocketStream，内核不支持时 Poller::create 退回 EPOLL。
+ */
+enum class IO_BACKEND
+{
+    LIBEVENT,
+    EPOLL,
+    URING
+};
+
+const char* ioBackendName(IO_BACKEND Backend);
+
+/**
+ * @brief 按名称（libevent、epoll、io_uring）解析后端，无法识别时返回 Default
+ */
+IO_BACKEND parseIoBackend(const std::string& Name, IO_BACKEND Default = IO_BACKEND::LIBEVENT);
+
+/* 监视与就绪的事件 */
+constexpr uint32_t POLL_READ = 0x1;
+constexpr uint32_t POLL_WRITE = 0x2;
+/* 边沿触发：就绪后须读写到 EAGAIN，否则不会再次通知 */
+constexpr uint32_t POLL_EDGE = 0x4;
+/* 只出现在就绪事件中：对端关闭写方向、挂断或套接字出错，此时总是同时带 POLL_READ */
+constexpr uint32_t POLL_HANGUP = 0x8;
+
+using PollCallback = void (*)(int Fd, uint32_t Events, void* Arg);
+
+/**
+ * @brief 一个已注册的 fd，存储由调用方提供，注册期间地址不能改变
+ */
+struct PollWatch
+{
+    int m_fd { -1 };
+    PollCallback m_callback { nullptr };
+    void* m_arg { nullptr };
+    /* LIBEVENT 后端的事件对象 */
+    struct event* m_event { nullptr };
+    /* URING 后端的多次触发 poll 操作 */
+    UringOp* m_op { nullptr };
+};
+
+/**
+ * @brief 事件循环的最小接口，Reactor 只通过它等待 I/O 与定时刻度，两个后端都实现它
+ * 除 breakLoop 外都只能在事件循环线程上（或启动之前）调用。
+ * 每轮就绪事件分发完之后执行 defer 登记的回调，用来合并同一轮中对同一连接的多次写出。
+ */
+class Poller
+{
+public:
+    /**
+     * @brief 创建 Backend 对应的实现，URING 不可用时返回 EpollPoller，以 backend() 为准
+     */
+    static std::unique_ptr<Poller> create(IO_BACKEND Backend);
+
+    virtual ~Poller() = default;
+
+    virtual IO_BACKEND backend() const = 0;
+
+    /**
+     * @brief 注册 Fd，Events 为 POLL_READ、POLL_WRITE、POLL_EDGE 的组合；不改变 fd 的所有权
+     */
+    virtual bool add(PollWatch& Watch, int Fd, uint32_t Events, PollCallback Callback, void* Arg) = 0;
+
+    /**
+     * @brief 注销，本轮中尚未分发的就绪事件一并丢弃；须在关闭 fd 之前调用
+     */
+    virtual void remove(PollWatch& Watch) = 0;
+
+    /**
+     * @brief 每隔 Interval 调用一次 Callback（Fd 为 -1）
+     */
+    virtual bool setTick(std::chrono::milliseconds Interval, PollCallback Callback, void* Arg) = 0;
+
+    /**
+     * @brief 运行事件循环直到 breakLoop
+     */
+    virtual void run() = 0;
+
+    /**
+     * @brief 让 run 在本轮结束后返回，只能在事件循环线程上调用
+     */
+    virtual void breakLoop() = 0;
+
+    /**
+     * @brief LIBEVENT 后端的 event_base，其他后端为空
+     */
+    virtual struct event_base* base() const { return nullptr; }
+
+    /**
+     * @brief 在本轮就绪事件分发完之后调用 Callback（Fd 为 -1），回调中登记的会在同一轮继续执行
+     */
+    void defer(PollCallback Callback, void* Arg) { m_deferred.push_back({ Callback, Arg }); }
+
+    /**
+     * @brief 撤销以 Arg 登记的延后回调，对象销毁前调用
+     */
+    void cancelDeferred(void* Arg);
+
+protected:
+    void runDeferred();
+
+    /* 由等待超时驱动的时间刻度，EPOLL 与 URING 后端共用 */
+    bool armTick(std::chrono::milliseconds Interval, PollCallback Callback, void* Arg);
+    /**
+     * @brief 距下一个刻度的毫秒数，没有刻度时为 -1
+     */
+    int tickTimeout() const;
+    void runTick();
+
+private:
+    struct Deferred
+    {
+        PollCallback m_callback;
+        void* m_arg;
+    };
+
+    std::vector<Deferred> m_deferred;
+    std::vector<Deferred> m_running;
+    std::chrono::milliseconds m_tickInterval { 0 };
+    std::chrono::steady_clock::time_point m_nextTick;
+    PollCallback m_tickCallback { nullptr };
+    void* m_tickArg { nullptr };
+};
+
+/**
+ * @brief 以 libevent 的 event_base 实现，兼容原有的 bufferevent 连接
+ */
+class LibeventPoller : public Poller
+{
+public:
+    LibeventPoller();
+    ~LibeventPoller() override;
+
+    IO_BACKEND backend() const override { return IO_BACKEND::LIBEVENT; }
+    bool add(PollWatch& Watch, int Fd, uint32_t Events, PollCallback Callback, void* Arg) override;
+    void remove(PollWatch& Watch) override;
+    bool setTick(std::chrono::milliseconds Interval, PollCallback Callback, void* Arg) override;
+    void run() override;
+    void breakLoop() override;
+    struct event_base* base() const override { return m_base; }
+
+private:
+    static void onEvent(int Fd, short Events, void* Arg);
+
+    struct event_base* m_base { nullptr };
+    PollWatch m_tick;
+    bool m_broken { false };
+};
+
+/**
+ * @brief 直接使用 epoll，连接以 EPOLLET 注册一次后不再修改，暂停读取、等待可写都不需要 epoll_ctl
+ * 时间刻度由 epoll_wait 的超时实现，不额外占用 fd。
+ */
+class EpollPoller : public Poller
+{
+public:
+    static constexpr size_t MAX_EVENTS = 256;
+
+    EpollPoller();
+    ~EpollPoller() override;
+
+    IO_BACKEND backend() const override { return IO_BACKEND::EPOLL; }
+    bool add(PollWatch& Watch, int Fd, uint32_t Events, PollCallback Callback, void* Arg) override;
+    void remove(PollWatch& Watch) override;
+    bool setTick(std::chrono::milliseconds Interval, PollCallback Callback, void* Arg) override;
+    void run() override;
+    void breakLoop() override { m_broken = true; }
+
+private:
+    int m_epollFd { -1 };
+    /* 当前一轮的就绪事件，remove 把其中尚未分发的对应项清空 */
+    std::vector<struct epoll_event> m_ready;
+    size_t m_dispatching { 0 };
+    size_t m_readyCount { 0 };
+    bool m_broken { false };
+};
+}   // namespace ToolKit
@@ -0,0 +1,266 @@
+#include "PubSub.h"
+
+#include "HttpResponse.h"
+#include "Reactor.h"
+#include "WebSocket.h"
+
+#include <algorithm>
+#include <event2/buffer.h>
+#include <unordered_map>
+
+namespace ToolKit
+{
+/**
+ * @brief 一个分片上订阅同一主题的订阅者
+ */
+struct PubSubTopic
+{
+    std::string m_name;
+    std::vector<PubSubSubscriber*> m_members;
+};
+
+/**
+ * @brief 一次发布，各分片共享；m_payloads 按编码索引，没有订阅者使用的编码为空
+ */
+struct PubSub::Message
+{
+    std::string m_topic;
+    SharedBuffer::Ptr m_payloads[STREAM_FORMAT_COUNT];
+};
+
+struct PubSub::Shard
+{
+    /* 只在分片所在的线程上访问 */
+    std::unordered_map<std::string, std::unique_ptr<PubSubTopic>> m_topics;
+    std::vector<PubSubSubscriber*> m_slow;
+    /* 发布线程据此跳过没有订阅者的分片 */
+    std::atomic<size_t> m_subscriptions { 0 };
+    std::atomic<size_t> m_deliveries { 0 };
+    std::atomic<size_t> m_dropped { 0 };
+    std::atomic<size_t> m_disconnected { 0 };
+};
+
+std::string formatStreamMessage(STREAM_FORMAT Format, std::string_view Data)
+{
+    std::string out;
+    switch (Format)
+    {
+        case STREAM_FORMAT::RAW:
+            out.assign(Data);
+            break;
+        case STREAM_FORMAT::SSE:
+        {
+            /* 每行一个 data 字段，客户端按 "\n" 拼回原文 */
+            out.reserve(Data.size() + 8);
+            while (true)
+            {
+                auto eol = Data.find('\n');
+                out.append("data: ");
+                out.append(Data.substr(0, eol));
+                out.push_back('\n');
+                if (eol == std::string_view::npos)
+                    break;
+                Data.remove_prefix(eol + 1);
+            }
+            out.push_back('\n');
+            break;
+        }
+        case STREAM_FORMAT::WEBSOCKET_TEXT:
+        case STREAM_FORMAT::WEBSOCKET_BINARY:
+        {
+            unsigned char head[WS_MAX_SERVER_HEADER];
+            const auto opcode = Format == STREAM_FORMAT::WEBSOCKET_TEXT ? WS_OPCODE::TEXT : WS_OPCODE::BINARY;
+            const size_t headLength = encodeWebSocketHeader(opcode, true, Data.size(), head);
+            out.reserve(headLength + Data.size());
+            out.append(reinterpret_cast<const char*>(head), headLength);
+            out.append(Data);
+            break;
+        }
+    }
+    return out;
+}
+
+PubSubSubscriber::~PubSubSubscriber()
+{
+    if (m_hub != nullptr)
+        m_hub->unsubscribeAll(*this);
+}
+
+PubSub::PubSub(size_t Shards, Executor Exec, const PubSubOptions& Options)
+        : m_executor(std::move(Exec))
+        , m_options(Options)
+{
+    for (size_t i = 0; i < std::max<size_t>(Shards, 1); i++)
+        m_shards.push_back(std::make_unique<Shard>());
+}
+
+PubSub::~PubSub() = default;
+
+size_t PubSub::publish(std::string_view Topic, std::string_view Data)
+{
+    m_published.fetch_add(1, std::memory_order_relaxed);
+    std::shared_ptr<Message> message;
+    size_t posted = 0;
+    for (size_t i = 0; i < m_shards.size(); i++)
+    {
+        if (m_shards[i]->m_subscriptions.load(std::memory_order_relaxed) == 0)
+            continue;
+        if (message == nullptr)
+        {
+            /* 每种编码只生成一次，所有分片、所有订阅者共享 */
+            message = std::make_shared<Message>();
+            message->m_topic.assign(Topic);
+            for (size_t format = 0; format < STREAM_FORMAT_COUNT; format++)
+            {
+                if (m_formatSubscriptions[format].load(std::memory_order_relaxed) == 0)
+                    continue;
+                if (format == static_cast<size_t>(STREAM_FORMAT::RAW))
+                    message->m_payloads[format] = SharedBuffer::copyOf(Data.data(), Data.size());
+                else
+                {
+                    auto encoded = formatStreamMessage(static_cast<STREAM_FORMAT>(format), Data);
+                    message->m_payloads[format] = SharedBuffer::copyOf(encoded.data(), encoded.size());
+                }
+            }
+        }
+        m_executor(i, [this, i, message] { deliver(*m_shards[i], *message); });
+        posted++;
+    }
+    return posted;
+}
+
+void PubSub::deliver(Shard& Target, const Message& Item)
+{
+    auto found = Target.m_topics.find(Item.m_topic);
+    if (found == Target.m_topics.end())
+        return;
+    size_t deliveries = 0;
+    size_t dropped = 0;
+    auto& slow = Target.m_slow;
+    for (auto* subscriber : found->second->m_members)
+    {
+        const auto& payload = Item.m_payloads[static_cast<size_t>(subscriber->m_format)];
+        /* 发布之后才出现的编码，这条消息不属于它 */
+        if (!payload)
+            continue;
+        const size_t pending = evbuffer_get_length(subscriber->m_output);
+        const size_t limit = subscriber->m_maxPendingBytes != 0 ? subscriber->m_maxPendingBytes : m_options.m_maxPendingBytes;
+        /* 输出缓冲区为空时总是放行，单条消息大于上限也能送达 */
+        if (pending > 0 && pending + payload->size() > limit)
+        {
+            subscriber->m_dropped++;
+            dropped++;
+            if (m_options.m_disconnectSlow)
+                slow.push_back(subscriber);
+            continue;
+        }
+        appendShared(subscriber->m_output, *payload.get());
+        deliveries++;
+        if (pending == 0 && subscriber->m_notifier != nullptr && *subscriber->m_notifier)
+            (*subscriber->m_notifier)(CONN_ACTION::KEEP_READING);
+    }
+    Target.m_deliveries.fetch_add(deliveries, std::memory_order_relaxed);
+    Target.m_dropped.fetch_add(dropped, std::memory_order_relaxed);
+
+    /* 关闭连接会退订并修改成员数组，放到遍历之后 */
+    for (auto* subscriber : slow)
+    {
+        unsubscribeAll(*subscriber);
+        evbuffer_drain(subscriber->m_output, evbuffer_get_length(subscriber->m_output));
+        Target.m_disconnected.fetch_add(1, std::memory_order_relaxed);
+        if (subscriber->m_notifier != nullptr && *subscriber->m_notifier)
+            (*subscriber->m_notifier)(CONN_ACTION::CLOSE_AFTER_WRITE);
+    }
+    slow.clear();
+}
+
+void PubSub::subscribe(PubSubSubscriber& Subscriber, std::string_view Topic)
+{
+    if (Subscriber.m_hub == nullptr)
+    {
+        auto* reactor = Reactor::current();
+        Subscriber.m_hub = this;
+        Subscriber.m_shard = reactor != nullptr && reactor->index() < m_shards.size() ? reactor->index() : 0;
+    }
+    auto& shard = *m_shards[Subscriber.m_shard];
+    auto& topic = shard.m_topics[std::string(Topic)];
+    if (topic == nullptr)
+    {
+        topic = std::make_unique<PubSubTopic>();
+        topic->m_name.assign(Topic);
+    }
+    for (auto& membership : Subscriber.m_memberships)
+    {
+        if (membership.m_topic == topic.get())
+            return;
+    }
+    Subscriber.m_memberships.push_back({ topic.get(), topic->m_members.size() });
+    topic->m_members.push_back(&Subscriber);
+    shard.m_subscriptions.fetch_add(1, std::memory_order_relaxed);
+    m_formatSubscriptions[static_cast<size_t>(Subscriber.m_format)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void PubSub::unsubscribe(PubSubSubscriber& Subscriber, std::string_view Topic)
+{
+    for (size_t i = 0; i < Subscriber.m_memberships.size(); i++)
+    {
+        if (Subscriber.m_memberships[i].m_topic->m_name == Topic)
+        {
+            removeMembership(Subscriber, i);
+            break;
+        }
+    }
+    if (Subscriber.m_memberships.empty())
+        Subscriber.m_hub = nullptr;
+}
+
+void PubSub::unsubscribeAll(PubSubSubscriber& Subscriber)
+{
+    while (!Subscriber.m_memberships.empty())
+        removeMembership(Subscriber, Subscriber.m_memberships.size() - 1);
+    Subscriber.m_hub = nullptr;
+}
+
+void PubSub::removeMembership(PubSubSubscriber& Subscriber, size_t Position)
+{
+    auto& shard = *m_shards[Subscriber.m_shard];
+    auto membership = Subscriber.m_memberships[Position];
+    Subscriber.m_memberships[Position] = Subscriber.m_memberships.back();
+    Subscriber.m_memberships.pop_back();
+
+    /* 末尾成员移到空出的位置，并更新它记录的下标 */
+    auto& members = membership.m_topic->m_members;
+    auto* moved = members.back();
+    members[membership.m_index] = moved;
+    members.pop_back();
+    if (moved != &Subscriber)
+    {
+        for (auto& other : moved->m_memberships)
+        {
+            if (other.m_topic == membership.m_topic)
+            {
+                other.m_index = membership.m_index;
+                break;
+            }
+        }
+    }
+    if (members.empty())
+        shard.m_topics.erase(shard.m_topics.find(membership.m_topic->m_name));
+    shard.m_subscriptions.fetch_sub(1, std::memory_order_relaxed);
+    m_formatSubscriptions[static_cast<size_t>(Subscriber.m_format)].fetch_sub(1, std::memory_order_relaxed);
+}
+
+PubSubStats PubSub::stats() const
+{
+    PubSubStats result;
+    result.m_published = m_published.load(std::memory_order_relaxed);
+    for (auto& shard : m_shards)
+    {
+        result.m_deliveries += shard->m_deliveries.load(std::memory_order_relaxed);
+        result.m_dropped += shard->m_dropped.load(std::memory_order_relaxed);
+        result.m_disconnected += shard->m_disconnected.load(std::memory_order_relaxed);
+        result.m_subscriptions += shard->m_subscriptions.load(std::memory_order_relaxed);
+    }
+    return result;
+}
+}   // namespace ToolKit
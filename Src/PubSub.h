@@ -0,0 +1,163 @@
+#pragma once
+
+#include "HttpConnection.h"
+#include "Infra/SharedBuffer.h"
+#include "Infra/SmallTask.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct evbuffer;
+
+namespace ToolKit
+{
+/**
+ * @brief 推送消息在订阅者输出缓冲区中的编码
+ */
+enum class STREAM_FORMAT : uint8_t
+{
+    /* 原样输出 */
+    RAW,
+    /* Server-Sent Events：每行加 "data: " 前缀，以空行结束 */
+    SSE,
+    /* 服务端发出的 WebSocket 帧（不加掩码） */
+    WEBSOCKET_TEXT,
+    WEBSOCKET_BINARY
+};
+constexpr size_t STREAM_FORMAT_COUNT = 4;
+
+/**
+ * @brief 按 Format 编码一条消息
+ */
+std::string formatStreamMessage(STREAM_FORMAT Format, std::string_view Data);
+
+struct PubSubTopic;
+class PubSub;
+
+/**
+ * @brief 一个订阅者，通常是一个长连接的输出缓冲区，由连接的协议会话持有
+ * 只能在连接所属的 Reactor 线程上订阅与退订，析构时自动退订全部主题。
+ * 输出缓冲区的积压加上新消息超过 m_maxPendingBytes（为 0 时使用 PubSub 的默认值）时该消息对它丢弃；
+ * PubSub 配置为断开慢订阅者时，还会退订全部主题、清空输出缓冲区并通过 m_notifier 要求关闭连接。
+ * 输出缓冲区由空变为非空时通过 m_notifier 通知 KEEP_READING，让连接布防写超时。
+ * m_output 与 m_format 须在第一次订阅前设置好。
+ */
+class PubSubSubscriber
+{
+public:
+    PubSubSubscriber() = default;
+    ~PubSubSubscriber();
+    PubSubSubscriber(const PubSubSubscriber&) = delete;
+    const PubSubSubscriber& operator=(const PubSubSubscriber&) = delete;
+
+    /**
+     * @brief 已订阅的主题数
+     */
+    size_t topics() const { return m_memberships.size(); }
+
+    /**
+     * @brief 因积压超限丢弃的消息数
+     */
+    size_t dropped() const { return m_dropped; }
+
+    struct evbuffer* m_output { nullptr };
+    STREAM_FORMAT m_format { STREAM_FORMAT::SSE };
+    size_t m_maxPendingBytes { 0 };
+    const HttpActionNotifier* m_notifier { nullptr };
+
+private:
+    friend class PubSub;
+
+    /* 在主题成员数组中的位置，退订时以末尾成员填补 */
+    struct Membership
+    {
+        PubSubTopic* m_topic;
+        size_t m_index;
+    };
+
+    std::vector<Membership> m_memberships;
+    PubSub* m_hub { nullptr };
+    size_t m_shard { 0 };
+    size_t m_dropped { 0 };
+};
+
+struct PubSubOptions
+{
+    /* 单个订阅者输出缓冲区允许的积压 */
+    size_t m_maxPendingBytes { 1024 * 1024 };
+    /* 积压超限时断开订阅者，否则只丢弃消息 */
+    bool m_disconnectSlow { true };
+};
+
+struct PubSubStats
+{
+    size_t m_published { 0 };
+    /* 写入订阅者输出缓冲区的消息数 */
+    size_t m_deliveries { 0 };
+    size_t m_dropped { 0 };
+    size_t m_disconnected { 0 };
+    size_t m_subscriptions { 0 };
+};
+
+/**
+ * @brief 跨 Reactor 的发布订阅
+ * 订阅关系按 Reactor 分片，每个分片只由对应的 Reactor 线程访问，订阅、退订与投递都不需要加锁。
+ * publish 可以在任意线程调用：消息按订阅者使用的编码各生成一份不可变的 SharedBuffer，
+ * 再通过 Executor 投递到有订阅者的分片，由分片所在的 Reactor 线程写入本分片每个订阅者的输出缓冲区。
+ * 较大的消息以 evbuffer_add_reference 引用同一份数据，不按订阅者拷贝；最后一个输出缓冲区发送完毕时释放。
+ * 不在 Reactor 线程上（单元测试）订阅时归入分片 0。
+ */
+class PubSub
+{
+public:
+    /**
+     * @brief 让 Task 在分片 Shard 所在的线程上执行
+     */
+    using Executor = std::function<void(size_t Shard, SmallTask&& Task)>;
+
+    PubSub(size_t Shards, Executor Exec, const PubSubOptions& Options = {});
+    ~PubSub();
+    PubSub(const PubSub&) = delete;
+    const PubSub& operator=(const PubSub&) = delete;
+
+    /**
+     * @brief 向主题发布一条消息，可在任意线程调用
+     *
+     * @return size_t 投递到的分片数，为 0 表示当前没有订阅者
+     */
+    size_t publish(std::string_view Topic, std::string_view Data);
+
+    /**
+     * @brief 订阅主题，重复订阅被忽略；只能在订阅者所属的 Reactor 线程上调用，m_output 须已设置
+     */
+    void subscribe(PubSubSubscriber& Subscriber, std::string_view Topic);
+
+    void unsubscribe(PubSubSubscriber& Subscriber, std::string_view Topic);
+
+    void unsubscribeAll(PubSubSubscriber& Subscriber);
+
+    PubSubStats stats() const;
+
+    const PubSubOptions& options() const { return m_options; }
+
+private:
+    struct Message;
+    struct Shard;
+
+    void deliver(Shard& Target, const Message& Item);
+    void removeMembership(PubSubSubscriber& Subscriber, size_t Position);
+
+    const Executor m_executor;
+    const PubSubOptions m_options;
+    std::vector<std::unique_ptr<Shard>> m_shards;
+    /* 各编码的订阅数，发布时只生成有订阅者使用的编码 */
+    std::atomic<size_t> m_formatSubscriptions[STREAM_FORMAT_COUNT] {};
+    std::atomic<size_t> m_published { 0 };
+};
+}   // namespace ToolKit
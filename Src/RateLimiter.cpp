@@ -0,0 +1,243 @@
+#include "RateLimiter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <netinet/in.h>
+#include <string_view>
+#include <sys/socket.h>
+
+namespace
+{
+/* splitmix64 的末尾混合，让地址与首部值的各个比特都影响分片与槽位的选择 */
+uint64_t mix(uint64_t Value)
+{
+    Value ^= Value >> 30;
+    Value *= 0xbf58476d1ce4e5b9ULL;
+    Value ^= Value >> 27;
+    Value *= 0x94d049bb133111ebULL;
+    Value ^= Value >> 31;
+    return Value;
+}
+
+/* 0 留给空槽 */
+uint64_t nonZero(uint64_t Key)
+{
+    return Key == 0 ? 1 : Key;
+}
+
+size_t roundUpPowerOfTwo(size_t Value)
+{
+    size_t result = 1;
+    while (result < Value)
+        result <<= 1;
+    return result;
+}
+}   // namespace
+
+namespace ToolKit
+{
+RateLimiter::RateLimiter(RateLimiterOptions Options)
+        : m_options(std::move(Options))
+        , m_epoch(std::chrono::steady_clock::now())
+        , m_interval(std::max<int64_t>(1, static_cast<int64_t>(1e9 / std::max(m_options.m_rate, 1e-3))))
+        , m_tolerance(m_interval
+              * (std::max<int64_t>(1, m_options.m_burst != 0 ? m_options.m_burst : static_cast<int64_t>(std::ceil(m_options.m_rate)))
+                  - 1))
+        , m_slotMask(roundUpPowerOfTwo(std::max(m_options.m_slotsPerShard, PROBE)) - 1)
+        , m_shards(std::max<size_t>(1, m_options.m_shards))
+{
+    for (auto& shard : m_shards)
+        shard.m_slots = std::make_unique<Slot[]>(m_slotMask + 1);
+}
+
+bool RateLimiter::allow(uint64_t Key, std::chrono::steady_clock::time_point Now)
+{
+    if (Key == 0)
+        return true;
+    auto& shard = shardOf(Key);
+    const int64_t now = nanosecondsSince(Now);
+    auto* slot = slotOf(shard, Key, now);
+    if (slot == nullptr)
+    {
+        /* 表中没有可以挤占的空闲桶，新客户端被拒绝，不能挤掉正在限速中的客户端 */
+        shard.m_saturated.fetch_add(1, std::memory_order_relaxed);
+        shard.m_limited.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return consume(shard, *slot, now);
+}
+
+bool RateLimiter::allowRequest(const HttpRequest& Request, uint64_t ClientKey, std::chrono::steady_clock::time_point Now)
+{
+    /* 首部的值由客户端决定，每次换一个值就能得到一个满桶；地址的桶总是先扣，首部的桶在此之上再限一层 */
+    if (!allow(ClientKey, Now))
+        return false;
+    const uint64_t key = headerKey(Request);
+    if (key == 0)
+        return true;
+    auto& shard = shardOf(key);
+    const int64_t now = nanosecondsSince(Now);
+    auto* slot = slotOf(shard, key, now);
+    if (slot == nullptr)
+    {
+        /* 首部的桶放不下时只按地址限速 */
+        shard.m_saturated.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    return consume(shard, *slot, now);
+}
+
+bool RateLimiter::consume(Shard& Target, Slot& Bucket, int64_t Now)
+{
+    int64_t tat = Bucket.m_tat.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        /* 空闲过久的桶 tat 早于当前时间，等同于装满令牌 */
+        const int64_t base = std::max(tat, Now);
+        if (base - Now > m_tolerance)
+        {
+            Target.m_limited.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        if (Bucket.m_tat.compare_exchange_weak(tat, base + m_interval, std::memory_order_relaxed))
+        {
+            Target.m_allowed.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+}
+
+RateLimiter::Shard& RateLimiter::shardOf(uint64_t Key)
+{
+    return m_shards[(Key >> 32) % m_shards.size()];
+}
+
+int64_t RateLimiter::nanosecondsSince(std::chrono::steady_clock::time_point Now) const
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Now - m_epoch).count();
+}
+
+RateLimiter::Slot* RateLimiter::slotOf(Shard& Target, uint64_t Key, int64_t Now)
+{
+    Slot* slots = Target.m_slots.get();
+    const size_t start = static_cast<size_t>(Key) & m_slotMask;
+    for (;;)
+    {
+        Slot* empty = nullptr;
+        Slot* victim = nullptr;
+        uint64_t victimKey = 0;
+        int64_t oldest = std::numeric_limits<int64_t>::max();
+        for (size_t i = 0; i < PROBE; i++)
+        {
+            Slot& slot = slots[(start + i) & m_slotMask];
+            const uint64_t current = slot.m_key.load(std::memory_order_acquire);
+            if (current == Key)
+                return &slot;
+            if (current == 0)
+            {
+                /* 槽位只会被占用、挤占，不会变回空槽，第一个空槽之后不会再有已有的键 */
+                empty = &slot;
+                break;
+            }
+            /* 只有 tat 不晚于当前时间（桶已装满）的槽位可以挤占，挤掉它不丢失任何状态 */
+            const int64_t tat = slot.m_tat.load(std::memory_order_relaxed);
+            if (tat <= Now && tat < oldest)
+            {
+                oldest = tat;
+                victim = &slot;
+                victimKey = current;
+            }
+        }
+        if (empty != nullptr)
+        {
+            uint64_t expected = 0;
+            if (empty->m_key.compare_exchange_strong(expected, Key, std::memory_order_acq_rel))
+            {
+                empty->m_tat.store(0, std::memory_order_relaxed);
+                Target.m_entries.fetch_add(1, std::memory_order_relaxed);
+                return empty;
+            }
+            if (expected == Key)
+                return empty;
+            /* 空槽被其他键抢先占用，重新探测 */
+            continue;
+        }
+        if (victim == nullptr)
+            return nullptr;
+        if (victim->m_key.compare_exchange_strong(victimKey, Key, std::memory_order_acq_rel))
+        {
+            victim->m_tat.store(0, std::memory_order_relaxed);
+            Target.m_evictions.fetch_add(1, std::memory_order_relaxed);
+            return victim;
+        }
+        if (victimKey == Key)
+            return victim;
+    }
+}
+
+uint64_t RateLimiter::headerKey(const HttpRequest& Request) const
+{
+    if (m_options.m_header.empty())
+        return 0;
+    auto value = Request.header(m_options.m_header);
+    if (value.empty())
+        return 0;
+    /* 与地址的键错开，首部值恰好与某个地址同哈希也不会共用一个桶 */
+    return nonZero(mix(std::hash<std::string_view> {}(value) ^ 0x9e3779b97f4a7c15ULL));
+}
+
+uint64_t RateLimiter::addressKey(const struct sockaddr* Addr)
+{
+    if (Addr == nullptr)
+        return 0;
+    if (Addr->sa_family == AF_INET)
+    {
+        const auto* ipv4 = reinterpret_cast<const struct sockaddr_in*>(Addr);
+        return nonZero(mix(ipv4->sin_addr.s_addr));
+    }
+    if (Addr->sa_family != AF_INET6)
+        return 0;
+    const auto* ipv6 = reinterpret_cast<const struct sockaddr_in6*>(Addr);
+    const uint8_t* bytes = ipv6->sin6_addr.s6_addr;
+    /* IPv4 映射地址（::ffff:a.b.c.d）与直接的 IPv4 连接共用一个桶 */
+    static constexpr uint8_t MAPPED_PREFIX[12] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xff, 0xff };
+    if (memcmp(bytes, MAPPED_PREFIX, sizeof(MAPPED_PREFIX)) == 0)
+    {
+        uint32_t ipv4;
+        memcpy(&ipv4, bytes + 12, sizeof(ipv4));
+        return nonZero(mix(ipv4));
+    }
+    uint64_t high;
+    uint64_t low;
+    memcpy(&high, bytes, sizeof(high));
+    memcpy(&low, bytes + 8, sizeof(low));
+    return nonZero(mix(mix(high) ^ low ^ (uint64_t(1) << 40)));
+}
+
+RateLimiter::Stats RateLimiter::stats() const
+{
+    Stats stats;
+    for (auto& shard : m_shards)
+    {
+        stats.m_allowed += shard.m_allowed.load(std::memory_order_relaxed);
+        stats.m_limited += shard.m_limited.load(std::memory_order_relaxed);
+        stats.m_evictions += shard.m_evictions.load(std::memory_order_relaxed);
+        stats.m_saturated += shard.m_saturated.load(std::memory_order_relaxed);
+        stats.m_entries += shard.m_entries.load(std::memory_order_relaxed);
+    }
+    return stats;
+}
+
+const HttpHandler& rateLimitedHandler()
+{
+    static const HttpHandler handler { [](const HttpRequest&, HttpResponse& Response)
+        {
+            Response.setStatus(429);
+            Response.addHeader("Retry-After", "1");
+        } };
+    return handler;
+}
+}   // namespace ToolKit
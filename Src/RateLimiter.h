@@ -0,0 +1,128 @@
+#pragma once
+
+#include "HttpConnection.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct sockaddr;
+
+namespace ToolKit
+{
+struct RateLimiterOptions
+{
+    /* 每个客户端每秒补充的令牌数，0 表示不启用 */
+    double m_rate { 0 };
+    /* 令牌桶容量，即允许的突发请求数，0 时取 m_rate */
+    uint32_t m_burst { 0 };
+    size_t m_shards { 16 };
+    /* 每个分片的槽位数，向上取整为 2 的幂；同时活跃的客户端超过总槽位数时最久未活跃的被挤出 */
+    size_t m_slotsPerShard { 4096 };
+    /* 不为空时带有该首部的请求在对端地址之外，再按首部的值（如 API Key）限速 */
+    std::string m_header;
+    /* 新连接同样消耗地址桶的一个令牌，超限的连接在接受后立即关闭，不进入 Reactor */
+    bool m_limitAccepts { true };
+};
+
+/**
+ * @brief 按客户端限速的令牌桶，以 GCRA（理论到达时间）实现
+ * 每个客户端只有一个 64 位状态：下一个令牌的理论到达时间 tat。请求到达时 tat 不晚于 now + (burst - 1) * interval
+ * 即放行并把 tat 推后一个 interval，与容量 burst、速率 rate 的令牌桶等价，更新只需一次 CAS。
+ * 状态存放在按键哈希分片的开放寻址表中，每个槽位是键与 tat 两个原子量：查找在起始位置之后的 PROBE 个槽位内
+ * 线性探测，新键用 CAS 占用空槽；探测范围内没有空槽时挤占 tat 最早且已不晚于当前时间的槽位，即最久未活跃、
+ * 桶已装满的客户端，实现近似 LRU 的淘汰。这样的桶与新建的桶状态相同，挤掉它不丢失任何信息；
+ * 正在限速中的桶不会被挤掉，否则不断更换键的客户端就能把其他客户端的限速状态冲掉。
+ * 整个过程没有锁，Reactor 线程不会在这里阻塞；挤占与并发更新同一槽位时偶尔多放行一个请求，换取无锁。
+ */
+class RateLimiter
+{
+public:
+    struct Stats
+    {
+        uint64_t m_allowed { 0 };
+        uint64_t m_limited { 0 };
+        uint64_t m_evictions { 0 };
+        /* 没有可挤占的槽位而拒绝（地址）或只按地址限速（首部）的次数 */
+        uint64_t m_saturated { 0 };
+        /* 曾被占用过的槽位数 */
+        size_t m_entries { 0 };
+    };
+
+    explicit RateLimiter(RateLimiterOptions Options);
+    RateLimiter(const RateLimiter&) = delete;
+    const RateLimiter& operator=(const RateLimiter&) = delete;
+
+    /**
+     * @brief 为 Key 消耗一个令牌，有令牌时返回 true；表中放不下新的 Key 时返回 false；可并发调用
+     */
+    bool allow(uint64_t Key, std::chrono::steady_clock::time_point Now = std::chrono::steady_clock::now());
+
+    /**
+     * @brief 为一个请求消耗令牌：总是消耗对端地址 ClientKey 的桶；配置了首部且请求带有该首部时，
+     * 再消耗首部值对应的桶，首部的桶在表中放不下时只按地址限速
+     */
+    bool allowRequest(const HttpRequest& Request, uint64_t ClientKey,
+        std::chrono::steady_clock::time_point Now = std::chrono::steady_clock::now());
+
+    /**
+     * @brief 对端地址（IPv4 或 IPv6，不含端口）的键，其他地址族返回 0，此时 allow 总是放行
+     */
+    static uint64_t addressKey(const struct sockaddr* Addr);
+
+    bool limitAccepts() const { return m_options.m_limitAccepts; }
+
+    Stats stats() const;
+
+private:
+    static constexpr size_t PROBE = 8;
+
+    struct Slot
+    {
+        /* 0 表示空槽 */
+        std::atomic<uint64_t> m_key { 0 };
+        /* 理论到达时间，相对 m_epoch 的纳秒数 */
+        std::atomic<int64_t> m_tat { 0 };
+    };
+
+    struct alignas(64) Shard
+    {
+        std::unique_ptr<Slot[]> m_slots;
+        std::atomic<uint64_t> m_allowed { 0 };
+        std::atomic<uint64_t> m_limited { 0 };
+        std::atomic<uint64_t> m_evictions { 0 };
+        std::atomic<uint64_t> m_saturated { 0 };
+        std::atomic<size_t> m_entries { 0 };
+    };
+
+    /**
+     * @brief 找到或占用 Key 的槽位，没有空槽也没有可挤占的槽位时返回空
+     */
+    Slot* slotOf(Shard& Target, uint64_t Key, int64_t Now);
+    bool consume(Shard& Target, Slot& Bucket, int64_t Now);
+    Shard& shardOf(uint64_t Key);
+    int64_t nanosecondsSince(std::chrono::steady_clock::time_point Now) const;
+
+    /**
+     * @brief 首部值的键，未配置首部或请求不带该首部时返回 0
+     */
+    uint64_t headerKey(const HttpRequest& Request) const;
+
+    const RateLimiterOptions m_options;
+    const std::chrono::steady_clock::time_point m_epoch;
+    /* 相邻两个令牌的间隔，以及 tat 最多可以领先当前时间的量 */
+    const int64_t m_interval;
+    const int64_t m_tolerance;
+    const size_t m_slotMask;
+    std::vector<Shard> m_shards;
+};
+
+/**
+ * @brief 超过速率限制的请求交给它处理：回复 429 与 Retry-After，连接保持
+ */
+const HttpHandler& rateLimitedHandler();
+}   // namespace ToolKit
@@ -0,0 +1,332 @@
+#include "Reactor.h"
+
+#include "Infra/CpuAffinity.h"
+#include "UringPoller.h"
+
+#include "spdlog/spdlog.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <pthread.h>
+#include <string>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <utility>
+
+namespace
+{
+/* 当前线程所属的 Reactor，只在 Reactor 线程的事件循环期间不为空 */
+thread_local ToolKit::Reactor* currentReactor = nullptr;
+/* 一次可读事件中最多接受的连接数 */
+constexpr int ACCEPT_BATCH = 64;
+}   // namespace
+
+namespace ToolKit
+{
+Reactor* Reactor::current()
+{
+    return currentReactor;
+}
+
+Reactor::Reactor(size_t Index, const ConnectionHandler& Handler, size_t QueueCapacity, IO_BACKEND Backend)
+        : m_index(Index)
+        , m_handler(Handler)
+        , m_backend(Backend)
+        , m_pending(QueueCapacity)
+        , m_completions(QueueCapacity)
+{
+}
+
+Reactor::~Reactor()
+{
+    stop();
+    if (m_poller != nullptr)
+    {
+        if (m_acceptOp != nullptr)
+            static_cast<UringPoller&>(*m_poller).release(m_acceptOp);
+        m_poller->remove(m_listenWatch);
+        m_poller->remove(m_wakeupWatch);
+    }
+    if (m_listenFd >= 0)
+        close(m_listenFd);
+    if (m_wakeupFd >= 0)
+        close(m_wakeupFd);
+    m_poller.reset();
+}
+
+bool Reactor::init()
+{
+    if (m_poller != nullptr)
+        return true;
+    m_poller = Poller::create(m_backend);
+    m_backend = m_poller->backend();
+    if ((m_wakeupFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) < 0)
+    {
+        spdlog::warn("{} reactor[{}] eventfd creation failed", __FUNCTION__, m_index);
+        return false;
+    }
+    if (!m_poller->add(m_wakeupWatch, m_wakeupFd, POLL_READ, onWakeup, this))
+    {
+        spdlog::warn("{} reactor[{}] {} poller creation failed", __FUNCTION__, m_index, ioBackendName(m_backend));
+        return false;
+    }
+    return true;
+}
+
+bool Reactor::listen(const struct sockaddr* Addr, int AddrLen, int Backlog)
+{
+    if (!init())
+        return false;
+    /* 每个 Reactor 绑定同一地址的独立监听套接字，由内核按四元组哈希把新连接分散到各个监听队列 */
+    int one = 1;
+    m_listenFd = socket(Addr->sa_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    bool ok = m_listenFd >= 0 && setsockopt(m_listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) == 0
+        && setsockopt(m_listenFd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one)) == 0
+        && (m_cpu < 0 || setsockopt(m_listenFd, SOL_SOCKET, SO_INCOMING_CPU, &m_cpu, sizeof(m_cpu)) == 0)
+        && bind(m_listenFd, Addr, static_cast<socklen_t>(AddrLen)) == 0 && ::listen(m_listenFd, Backlog) == 0;
+    if (ok && m_backend == IO_BACKEND::URING)
+        ok = (m_acceptOp = static_cast<UringPoller&>(*m_poller).accept(m_listenFd, onAccepted, this)) != nullptr;
+    else if (ok)
+        ok = m_poller->add(m_listenWatch, m_listenFd, POLL_READ, onAccept, this);
+    if (!ok)
+    {
+        spdlog::warn("{} reactor[{}] bind listener failed, error[{}]", __FUNCTION__, m_index, strerror(errno));
+        if (m_listenFd >= 0)
+            close(m_listenFd);
+        m_listenFd = -1;
+        return false;
+    }
+    return true;
+}
+
+bool Reactor::enableTimers(std::chrono::milliseconds Tick)
+{
+    if (!init())
+        return false;
+    m_timerTick = std::max(Tick, std::chrono::milliseconds(1));
+    m_timerStart = std::chrono::steady_clock::now();
+    if (!m_poller->setTick(m_timerTick, onTimerTick, this))
+    {
+        spdlog::warn("{} reactor[{}] timer tick event creation failed", __FUNCTION__, m_index);
+        return false;
+    }
+    return true;
+}
+
+void Reactor::setAccepting(bool Enable)
+{
+    if (m_listenFd < 0 || m_accepting == Enable)
+        return;
+    m_accepting = Enable;
+    if (m_backend == IO_BACKEND::URING)
+    {
+        /* 多次触发的 accept 只能取消后重新提交，取消之后不再回调 */
+        auto& poller = static_cast<UringPoller&>(*m_poller);
+        if (!Enable)
+            poller.release(std::exchange(m_acceptOp, nullptr));
+        else if ((m_acceptOp = poller.accept(m_listenFd, onAccepted, this)) == nullptr)
+            spdlog::warn("{} reactor[{}] resume accept failed", __FUNCTION__, m_index);
+        return;
+    }
+    if (!Enable)
+        m_poller->remove(m_listenWatch);
+    else if (!m_poller->add(m_listenWatch, m_listenFd, POLL_READ, onAccept, this))
+        spdlog::warn("{} reactor[{}] resume accept failed", __FUNCTION__, m_index);
+}
+
+evutil_socket_t Reactor::listenFd() const
+{
+    return m_listenFd;
+}
+
+bool Reactor::start()
+{
+    if (!init())
+        return false;
+    m_thread = std::thread(&Reactor::loop, this);
+    auto name = "reactor-" + std::to_string(m_index);
+    pthread_setname_np(m_thread.native_handle(), name.c_str());
+    if (m_cpu >= 0 && !setThreadAffinity(m_thread.native_handle(), { m_cpu }))
+        spdlog::warn("{} reactor[{}] pin to cpu[{}] failed", __FUNCTION__, m_index, m_cpu);
+    return true;
+}
+
+void Reactor::stop()
+{
+    if (!m_thread.joinable())
+        return;
+    m_stopping.store(true);
+    wakeup();
+    m_thread.join();
+}
+
+bool Reactor::post(evutil_socket_t Fd)
+{
+    if (!m_pending.tryPush(Fd))
+        return false;
+    /* 上一次唤醒尚未被事件循环处理时无需再次写 eventfd，新的 fd 会在同一次 drain 中被取走 */
+    if (!m_wakeupPending.exchange(true))
+        wakeup();
+    return true;
+}
+
+void Reactor::runInLoop(SmallTask&& Task)
+{
+    Reactor* caller = current();
+    if (caller != nullptr)
+    {
+        /* 已有暂存的任务时新任务排在它们之后，保持投递顺序 */
+        if (!caller->m_deferred.empty() || !m_completions.tryPush(std::move(Task)))
+        {
+            caller->m_deferred.emplace_back(this, std::move(Task));
+            if (caller->m_deferred.size() == 1)
+                caller->wakeup();
+            return;
+        }
+    }
+    else
+    {
+        while (!m_completions.tryPush(std::move(Task)))
+            std::this_thread::yield();
+    }
+    /* 与 post 相同的合并方式：回调尚未取队列时，新任务会在同一次回调中被执行 */
+    if (!m_completionPending.exchange(true))
+        wakeup();
+}
+
+void Reactor::wakeup()
+{
+    uint64_t one = 1;
+    if (write(m_wakeupFd, &one, sizeof(one)) != sizeof(one))
+        spdlog::warn("{} reactor[{}] write eventfd failed", __FUNCTION__, m_index);
+}
+
+void Reactor::onWakeup(int Fd, uint32_t Events, void* Arg)
+{
+    auto* reactor = static_cast<Reactor*>(Arg);
+    uint64_t count;
+    (void)!read(Fd, &count, sizeof(count));
+    if (reactor->m_stopping.load())
+    {
+        reactor->m_poller->breakLoop();
+        return;
+    }
+    reactor->drain();
+    reactor->runCompletions();
+    reactor->flushDeferred();
+}
+
+void Reactor::runCompletions()
+{
+    m_completionPending.store(false);
+    SmallTask task;
+    while (m_completions.tryPop(task))
+    {
+        task();
+        task.reset();
+    }
+}
+
+void Reactor::flushDeferred()
+{
+    while (!m_deferred.empty())
+    {
+        auto& [target, task] = m_deferred.front();
+        if (!target->m_completions.tryPush(std::move(task)))
+        {
+            /* 目标仍然满，下一轮事件循环再试；期间本线程照常处理其他事件与自己的完成队列 */
+            wakeup();
+            return;
+        }
+        if (!target->m_completionPending.exchange(true))
+            target->wakeup();
+        m_deferred.pop_front();
+    }
+}
+
+uint64_t Reactor::currentTick() const
+{
+    return static_cast<uint64_t>((std::chrono::steady_clock::now() - m_timerStart) / m_timerTick);
+}
+
+void Reactor::armTimer(WheelTimer& Timer, std::chrono::milliseconds Delay)
+{
+    /* 时间轮只在刻度回调中推进，事件循环繁忙时可能落后于实际时间，把落后的刻度补到延迟上，避免提前到期 */
+    uint64_t lag = currentTick() - m_timers.now();
+    m_timers.arm(Timer, lag + static_cast<uint64_t>((Delay + m_timerTick - std::chrono::milliseconds(1)) / m_timerTick));
+}
+
+void Reactor::onTimerTick(int Fd, uint32_t Events, void* Arg)
+{
+    auto* reactor = static_cast<Reactor*>(Arg);
+    /* 按实际经过的时间推进，事件循环繁忙导致的延迟回调不会让时间轮落后 */
+    reactor->m_timers.advance(reactor->currentTick());
+}
+
+void Reactor::onAccept(int Fd, uint32_t Events, void* Arg)
+{
+    auto* reactor = static_cast<Reactor*>(Arg);
+    /* 监听套接字是水平触发的，一轮最多接受一批，剩下的留给下一轮，不让新连接挤占已有连接的处理 */
+    for (int i = 0; i < ACCEPT_BATCH; i++)
+    {
+        int fd = accept4(Fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0)
+        {
+            /* 多为 EMFILE 等瞬时错误，其他 Reactor 的监听套接字仍在工作，这里只记录不退出事件循环 */
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR && errno != ECONNABORTED)
+                spdlog::warn("{} reactor[{}] accept error {} ({})", __FUNCTION__, reactor->m_index, errno, strerror(errno));
+            return;
+        }
+        reactor->accepted(fd);
+        /* 连接数达到上限时处理函数会暂停接受，剩下的留在监听队列中 */
+        if (!reactor->m_accepting)
+            return;
+    }
+}
+
+void Reactor::onAccepted(int Result, const char* Data, void* Arg)
+{
+    auto* reactor = static_cast<Reactor*>(Arg);
+    if (Result >= 0)
+    {
+        reactor->accepted(Result);
+        return;
+    }
+    if (Result != -EAGAIN && Result != -EINTR && Result != -ECONNABORTED)
+        spdlog::warn("{} reactor[{}] accept error {} ({})", __FUNCTION__, reactor->m_index, -Result, strerror(-Result));
+}
+
+void Reactor::accepted(int Fd)
+{
+    m_accepted.fetch_add(1, std::memory_order_relaxed);
+    m_handler(*this, Fd);
+}
+
+void Reactor::drain()
+{
+    /* 先清除标志再取队列，保证清除之后 post 的 fd 要么在本次被取走，要么触发新的唤醒 */
+    m_wakeupPending.store(false);
+    evutil_socket_t fd;
+    while (m_pending.tryPop(fd))
+    {
+        m_handedOff.fetch_add(1, std::memory_order_relaxed);
+        m_handler(*this, fd);
+    }
+}
+
+void Reactor::loop()
+{
+    spdlog::info("{} reactor[{}] backend[{}]", __FUNCTION__, m_index, ioBackendName(m_backend));
+    currentReactor = this;
+    m_poller->run();
+    currentReactor = nullptr;
+
+    /* 退出时仍未移交的 fd 由 Reactor 负责关闭 */
+    evutil_socket_t fd;
+    while (m_pending.tryPop(fd))
+        evutil_closesocket(fd);
+}
+}   // namespace ToolKit
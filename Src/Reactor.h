@@ -0,0 +1,187 @@
+#pragma once
+
+#include "Infra/MpscQueue.h"
+#include "Infra/SmallTask.h"
+#include "Infra/TimerWheel.h"
+#include "Poller.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <event2/util.h>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <utility>
+
+struct event_base;
+struct sockaddr;
+
+namespace ToolKit
+{
+/**
+ * @brief 单线程事件循环
+ * 每个 Reactor 独占一个 Poller（libevent 的 event_base、原生 epoll 或 io_uring）与一个常驻线程，连接从移交到关闭都只在该线程上处理，
+ * 连接相关的回调之间因此不需要任何同步。
+ * 接收线程通过 post 把已接受的 fd 放入无锁 MPSC 队列，再经 eventfd 唤醒事件循环；
+ * 多次 post 在事件循环取走之前只会触发一次唤醒。
+ * 也可以通过 listen 让每个 Reactor 各自监听同一端口，由内核分发新连接，此时不再需要单独的接收线程。
+ * 其他线程（如执行阻塞处理函数的线程池）通过 runInLoop 把完成回调投递回来，连接与 bufferevent 始终只被
+ * Reactor 线程访问。移交与完成回调共用同一个 eventfd 唤醒事件循环。
+ * 每个 Reactor 还带一个分层时间轮，连接的各类超时都挂在上面，由 Poller 的周期刻度按粗粒度推进，
+ * 大量空闲连接不再各自占用 libevent 最小堆中的定时器。
+ */
+class Reactor
+{
+public:
+    /**
+     * @brief 在 Reactor 线程上为移交过来的 fd 建立连接，fd 的所有权随之转移
+     */
+    using ConnectionHandler = std::function<void(Reactor& Owner, evutil_socket_t Fd)>;
+
+    static constexpr size_t DEFAULT_QUEUE_CAPACITY = 4096;
+
+    Reactor(size_t Index, const ConnectionHandler& Handler, size_t QueueCapacity = DEFAULT_QUEUE_CAPACITY,
+        IO_BACKEND Backend = IO_BACKEND::LIBEVENT);
+    ~Reactor();
+    Reactor(const Reactor&) = delete;
+    const Reactor& operator=(const Reactor&) = delete;
+
+    /**
+     * @brief 把 Reactor 线程固定在 Cpu 上运行，需在 listen 与 start 之前调用
+     * 之后 listen 的套接字同时设置 SO_INCOMING_CPU，同一端口的 SO_REUSEPORT 组中内核优先把
+     * 在该 CPU 上处理的连接（即网卡队列中断所在的核）分给这个 Reactor，收包与处理请求都在同一个核上。
+     */
+    void setCpuAffinity(int Cpu) { m_cpu = Cpu; }
+
+    /**
+     * @brief 固定运行的 CPU，未设置时返回 -1
+     */
+    int cpu() const { return m_cpu; }
+
+    /**
+     * @brief 以 SO_REUSEPORT 绑定该 Reactor 自己的监听套接字，需在 start 之前调用
+     * 新连接直接在 Reactor 线程上被接受并交给 ConnectionHandler，不经过移交队列。
+     */
+    bool listen(const struct sockaddr* Addr, int AddrLen, int Backlog);
+
+    /**
+     * @brief 暂停或恢复接受该 Reactor 监听套接字上的新连接，只能在 Reactor 线程上调用
+     * 暂停期间新连接留在内核的监听队列中；未调用 listen 时不做任何事。
+     */
+    void setAccepting(bool Enable);
+
+    /**
+     * @brief 监听套接字，未调用 listen 时返回 -1
+     */
+    evutil_socket_t listenFd() const;
+
+    /**
+     * @brief 创建 Poller 与唤醒事件并启动线程，失败时返回 false
+     */
+    bool start();
+
+    /**
+     * @brief 通知事件循环退出并等待线程结束，可在任意线程调用（Reactor 线程自身除外）
+     */
+    void stop();
+
+    /**
+     * @brief 线程已启动且尚未 stop
+     */
+    bool running() const { return m_thread.joinable(); }
+
+    /**
+     * @brief 把 fd 移交给该 Reactor，可在任意线程调用；队列已满时返回 false，fd 所有权仍归调用方
+     */
+    bool post(evutil_socket_t Fd);
+
+    /**
+     * @brief 让 Task 在 Reactor 线程上执行，可在任意线程调用
+     * 任务进入无锁完成队列，由 eventfd 唤醒的回调统一取出执行，多次投递只唤醒一次。
+     * 队列已满时，普通线程让出 CPU 重试直到成功；Reactor 线程不能等待（投给自己的队列只有自己能取，
+     * 两个 Reactor 互相投递也会彼此等待），任务暂存在调用方 Reactor 的溢出列表中，由它的事件循环按顺序补投。
+     * 任务不会丢失；Reactor 停止后未执行的任务随 Reactor 一起销毁。
+     */
+    void runInLoop(SmallTask&& Task);
+
+    /**
+     * @brief 启用时间轮，以 Tick 为刻度推进，需在 start 之前调用
+     */
+    bool enableTimers(std::chrono::milliseconds Tick);
+
+    /**
+     * @brief 在 Delay 之后（向上取整到刻度）调用定时器回调，只能在 Reactor 线程上调用
+     */
+    void armTimer(WheelTimer& Timer, std::chrono::milliseconds Delay);
+
+    void cancelTimer(WheelTimer& Timer) { m_timers.cancel(Timer); }
+
+    /**
+     * @brief 调用线程所属的 Reactor，不在 Reactor 线程上时返回空
+     */
+    static Reactor* current();
+
+    /**
+     * @brief LIBEVENT 后端的 event_base，其他后端为空
+     */
+    struct event_base* base() const { return m_poller != nullptr ? m_poller->base() : nullptr; }
+    Poller& poller() { return *m_poller; }
+    /**
+     * @brief 实际使用的后端，URING 不可用而退回 EPOLL 时与构造参数不同
+     */
+    IO_BACKEND backend() const { return m_backend; }
+    size_t index() const { return m_index; }
+
+    /**
+     * @brief 已移交到该 Reactor 的连接数
+     */
+    size_t handedOff() const { return m_handedOff.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief 该 Reactor 的监听套接字上接受的连接数
+     */
+    size_t accepted() const { return m_accepted.load(std::memory_order_relaxed); }
+
+private:
+    static void onAccept(int Fd, uint32_t Events, void* Arg);
+    static void onAccepted(int Result, const char* Data, void* Arg);
+    void accepted(int Fd);
+    static void onWakeup(int Fd, uint32_t Events, void* Arg);
+    static void onTimerTick(int Fd, uint32_t Events, void* Arg);
+    uint64_t currentTick() const;
+    bool init();
+    void wakeup();
+    void drain();
+    void runCompletions();
+    void flushDeferred();
+    void loop();
+
+    const size_t m_index;
+    const ConnectionHandler m_handler;
+    IO_BACKEND m_backend;
+    MpscQueue<evutil_socket_t> m_pending;
+    MpscQueue<SmallTask> m_completions;
+    /* 本 Reactor 线程投递时目标队列已满的任务，只由本线程访问 */
+    std::deque<std::pair<Reactor*, SmallTask>> m_deferred;
+    std::unique_ptr<Poller> m_poller;
+    PollWatch m_wakeupWatch;
+    PollWatch m_listenWatch;
+    /* URING 后端的多次触发 accept */
+    UringOp* m_acceptOp { nullptr };
+    TimerWheel m_timers;
+    std::chrono::milliseconds m_timerTick { 1000 };
+    std::chrono::steady_clock::time_point m_timerStart;
+    int m_listenFd { -1 };
+    bool m_accepting { true };
+    int m_wakeupFd { -1 };
+    int m_cpu { -1 };
+    std::thread m_thread;
+    std::atomic<bool> m_wakeupPending { false };
+    std::atomic<bool> m_completionPending { false };
+    std::atomic<bool> m_stopping { false };
+    std::atomic<size_t> m_handedOff { 0 };
+    std::atomic<size_t> m_accepted { 0 };
+};
+}   // namespace ToolKit
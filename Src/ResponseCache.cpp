@@ -0,0 +1,365 @@
+#include "ResponseCache.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <event2/buffer.h>
+#include <strings.h>
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+/* 条目除键、首部与响应体之外的固定开销，计入字节预算 */
+constexpr size_t ENTRY_OVERHEAD = 256;
+
+bool equalsIgnoreCase(std::string_view Left, std::string_view Right)
+{
+    return Left.size() == Right.size() && strncasecmp(Left.data(), Right.data(), Left.size()) == 0;
+}
+
+std::string_view trim(std::string_view Text)
+{
+    while (!Text.empty() && (Text.front() == ' ' || Text.front() == '\t'))
+        Text.remove_prefix(1);
+    while (!Text.empty() && (Text.back() == ' ' || Text.back() == '\t'))
+        Text.remove_suffix(1);
+    return Text;
+}
+
+/**
+ * @brief 依次取出逗号分隔列表中的元素，列表为空时返回 false
+ */
+bool nextToken(std::string_view& List, std::string_view& Token)
+{
+    while (!List.empty())
+    {
+        auto comma = List.find(',');
+        Token = trim(List.substr(0, comma));
+        List = comma == std::string_view::npos ? std::string_view {} : List.substr(comma + 1);
+        if (!Token.empty())
+            return true;
+    }
+    return false;
+}
+
+/**
+ * @brief 解析 Cache-Control 中形如 Name=Seconds 的指令
+ */
+bool directiveSeconds(std::string_view Token, std::string_view Name, long long& Seconds)
+{
+    if (Token.size() <= Name.size() + 1 || Token[Name.size()] != '=' || !equalsIgnoreCase(Token.substr(0, Name.size()), Name))
+        return false;
+    auto value = Token.substr(Name.size() + 1);
+    if (value.size() >= 2 && value.front() == '"' && value.back() == '"')
+        value = value.substr(1, value.size() - 2);
+    auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), Seconds);
+    return ec == std::errc() && end == value.data() + value.size() && Seconds >= 0;
+}
+
+int hexValue(char C)
+{
+    if (C >= '0' && C <= '9')
+        return C - '0';
+    if (C >= 'a' && C <= 'f')
+        return C - 'a' + 10;
+    if (C >= 'A' && C <= 'F')
+        return C - 'A' + 10;
+    return -1;
+}
+
+bool unreserved(char C)
+{
+    return (C >= 'a' && C <= 'z') || (C >= 'A' && C <= 'Z') || (C >= '0' && C <= '9') || C == '-' || C == '.' || C == '_'
+        || C == '~';
+}
+
+/**
+ * @brief 按 RFC 3986 的语法规范化路径追加到 Key：解码非保留字符、百分号编码统一为大写，
+ * 再合并重复的 /、去掉 . 段并按 .. 段回退（不越过根）
+ */
+void appendNormalizedPath(std::pmr::string& Key, std::string_view Path)
+{
+    std::pmr::string decoded(Key.get_allocator());
+    decoded.reserve(Path.size());
+    for (size_t i = 0; i < Path.size(); i++)
+    {
+        int high = Path[i] == '%' && i + 2 < Path.size() ? hexValue(Path[i + 1]) : -1;
+        int low = high >= 0 ? hexValue(Path[i + 2]) : -1;
+        if (low < 0)
+        {
+            decoded.push_back(Path[i]);
+            continue;
+        }
+        char c = static_cast<char>(high * 16 + low);
+        if (unreserved(c))
+        {
+            decoded.push_back(c);
+        }
+        else
+        {
+            static constexpr char HEX[] = "0123456789ABCDEF";
+            decoded.push_back('%');
+            decoded.push_back(HEX[high]);
+            decoded.push_back(HEX[low]);
+        }
+        i += 2;
+    }
+    if (decoded.empty() || decoded.front() != '/')
+    {
+        Key.append(decoded);
+        return;
+    }
+
+    Key.push_back('/');
+    const size_t root = Key.size();
+    for (size_t pos = 1;;)
+    {
+        size_t slash = decoded.find('/', pos);
+        bool last = slash == std::pmr::string::npos;
+        std::string_view segment(decoded.data() + pos, (last ? decoded.size() : slash) - pos);
+        if (segment == "..")
+        {
+            /* 此时 Key 以 / 结尾，去掉它和前一个路径段 */
+            if (Key.size() > root)
+            {
+                Key.pop_back();
+                while (Key.size() > root && Key.back() != '/')
+                    Key.pop_back();
+            }
+        }
+        else if (!segment.empty() && segment != ".")
+        {
+            Key.append(segment);
+            if (!last)
+                Key.push_back('/');
+        }
+        if (last)
+            break;
+        pos = slash + 1;
+    }
+}
+
+/* FNV-1a，只用于给没有 ETag 的缓存响应生成版本标识 */
+uint64_t fnv1a(const char* Data, size_t Size)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < Size; i++)
+    {
+        hash ^= static_cast<unsigned char>(Data[i]);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+}   // namespace
+
+namespace ToolKit
+{
+ResponseCache::ResponseCache(ResponseCacheOptions Options)
+        : m_options(std::move(Options))
+        , m_shardBudget(m_options.m_maxBytes / std::max<size_t>(1, m_options.m_shards))
+        , m_shards(std::max<size_t>(1, m_options.m_shards))
+{
+}
+
+bool ResponseCache::buildKey(const HttpRequest& Request, const void* Handler, std::pmr::string& Key) const
+{
+    if (Request.m_method != "GET" && Request.m_method != "HEAD")
+        return false;
+    if (!Request.header("Authorization").empty())
+        return false;
+    Key.reserve(sizeof(Handler) + Request.m_path.size() + Request.m_query.size() + 16);
+    Key.append(reinterpret_cast<const char*>(&Handler), sizeof(Handler));
+    appendNormalizedPath(Key, Request.m_path);
+    if (!Request.m_query.empty())
+    {
+        Key.push_back('?');
+        Key.append(Request.m_query);
+    }
+    for (const auto& name : m_options.m_vary)
+    {
+        Key.push_back('\n');
+        Key.append(trim(Request.header(name)));
+    }
+    return true;
+}
+
+bool ResponseCache::cacheable(HttpResponse& Response, std::chrono::seconds& Ttl) const
+{
+    if (Response.status() != 200 || Response.hasFile() || !Response.header("Set-Cookie").empty())
+        return false;
+
+    long long maxAge = -1;
+    long long sharedMaxAge = -1;
+    auto cacheControl = Response.header("Cache-Control");
+    std::string_view token;
+    while (nextToken(cacheControl, token))
+    {
+        if (equalsIgnoreCase(token, "no-store") || equalsIgnoreCase(token, "private") || equalsIgnoreCase(token, "no-cache"))
+            return false;
+        long long seconds = 0;
+        if (directiveSeconds(token, "s-maxage", seconds))
+            sharedMaxAge = seconds;
+        else if (directiveSeconds(token, "max-age", seconds))
+            maxAge = seconds;
+    }
+    Ttl = sharedMaxAge >= 0 ? std::chrono::seconds(sharedMaxAge)
+        : maxAge >= 0       ? std::chrono::seconds(maxAge)
+                            : m_options.m_defaultTtl;
+    if (Ttl.count() <= 0)
+        return false;
+
+    auto vary = Response.header("Vary");
+    while (nextToken(vary, token))
+    {
+        bool known = std::any_of(m_options.m_vary.begin(), m_options.m_vary.end(),
+            [token](const std::string& Name) { return equalsIgnoreCase(token, Name); });
+        if (!known)
+            return false;
+    }
+    return true;
+}
+
+bool ResponseCache::lookup(const HttpRequest& Request, const void* Handler, HttpResponse& Response)
+{
+    /* 客户端要求重新验证时绕过缓存，处理结果仍可以保存 */
+    auto requestControl = Request.header("Cache-Control");
+    std::string_view token;
+    while (nextToken(requestControl, token))
+    {
+        long long seconds = 0;
+        if (equalsIgnoreCase(token, "no-cache") || equalsIgnoreCase(token, "no-store")
+            || (directiveSeconds(token, "max-age", seconds) && seconds == 0))
+            return false;
+    }
+    if (equalsIgnoreCase(trim(Request.header("Pragma")), "no-cache"))
+        return false;
+
+    std::pmr::string key(Request.arena());
+    if (!buildKey(Request, Handler, key))
+        return false;
+
+    Shard& shard = shardOf(key);
+    std::shared_ptr<const Entry> entry;
+    const auto now = Clock::now();
+    {
+        std::lock_guard<std::mutex> lk(shard.m_mutex);
+        auto it = shard.m_index.find(key);
+        if (it == shard.m_index.end())
+        {
+            shard.m_misses++;
+            return false;
+        }
+        if ((*it->second)->m_expires <= now)
+        {
+            erase(shard, it->second);
+            shard.m_expirations++;
+            shard.m_misses++;
+            return false;
+        }
+        shard.m_lru.splice(shard.m_lru.begin(), shard.m_lru, it->second);
+        shard.m_hits++;
+        entry = *it->second;
+    }
+
+    Response.addSerializedHeaders(entry->m_headers);
+    char age[24];
+    int ageLen = snprintf(age, sizeof(age), "%lld",
+        static_cast<long long>(std::chrono::duration_cast<std::chrono::seconds>(now - entry->m_stored).count()));
+    Response.addHeader("Age", std::string_view(age, static_cast<size_t>(ageLen)));
+
+    /* If-None-Match 存在时忽略 If-Modified-Since */
+    auto ifNoneMatch = Request.header("If-None-Match");
+    time_t since = 0;
+    bool notModified = !ifNoneMatch.empty() ? etagMatches(ifNoneMatch, entry->m_etag)
+                                            : entry->m_lastModified >= 0
+            && parseHttpDate(Request.header("If-Modified-Since"), since) && entry->m_lastModified <= since;
+    if (notModified)
+    {
+        Response.setStatus(304);
+        return true;
+    }
+    Response.setStatus(200);
+    Response.setSharedBody(entry->m_body);
+    return true;
+}
+
+void ResponseCache::store(const HttpRequest& Request, const void* Handler, HttpResponse& Response)
+{
+    if (Request.m_method != "GET" || Response.hasSharedBody())
+        return;
+    std::chrono::seconds ttl {};
+    if (!cacheable(Response, ttl))
+        return;
+    size_t bodyLength = evbuffer_get_length(Response.body());
+    if (bodyLength > m_options.m_maxEntryBytes)
+        return;
+
+    std::pmr::string key(Request.arena());
+    if (!buildKey(Request, Handler, key))
+        return;
+
+    auto entry = std::make_shared<Entry>();
+    entry->m_body = SharedBuffer::copyOf(evbuffer_pullup(Response.body(), -1), bodyLength);
+    auto etag = Response.header("ETag");
+    if (etag.empty())
+    {
+        char generated[24];
+        int len = snprintf(generated, sizeof(generated), "\"%016llx\"",
+            static_cast<unsigned long long>(fnv1a(entry->m_body->data(), bodyLength)));
+        Response.addHeader("ETag", std::string_view(generated, static_cast<size_t>(len)));
+        etag = Response.header("ETag");
+    }
+    entry->m_etag.assign(etag);
+    time_t lastModified = 0;
+    if (parseHttpDate(Response.header("Last-Modified"), lastModified))
+        entry->m_lastModified = lastModified;
+    entry->m_headers.assign(Response.serializedHeaders());
+    entry->m_key.assign(key.data(), key.size());
+    entry->m_stored = Clock::now();
+    entry->m_expires = entry->m_stored + ttl;
+    entry->m_bytes = entry->m_key.size() + entry->m_headers.size() + bodyLength + ENTRY_OVERHEAD;
+    if (entry->m_bytes > m_shardBudget)
+        return;
+
+    Shard& shard = shardOf(entry->m_key);
+    std::lock_guard<std::mutex> lk(shard.m_mutex);
+    auto existing = shard.m_index.find(entry->m_key);
+    if (existing != shard.m_index.end())
+        erase(shard, existing->second);
+    while (shard.m_bytes + entry->m_bytes > m_shardBudget && !shard.m_lru.empty())
+    {
+        erase(shard, std::prev(shard.m_lru.end()));
+        shard.m_evictions++;
+    }
+    shard.m_bytes += entry->m_bytes;
+    shard.m_lru.push_front(std::move(entry));
+    shard.m_index.emplace(shard.m_lru.front()->m_key, shard.m_lru.begin());
+    shard.m_stores++;
+}
+
+void ResponseCache::erase(Shard& Target, std::list<std::shared_ptr<const Entry>>::iterator Position)
+{
+    Target.m_bytes -= (*Position)->m_bytes;
+    Target.m_index.erase((*Position)->m_key);
+    Target.m_lru.erase(Position);
+}
+
+ResponseCache::Stats ResponseCache::stats() const
+{
+    Stats stats;
+    for (auto& shard : m_shards)
+    {
+        std::lock_guard<std::mutex> lk(shard.m_mutex);
+        stats.m_hits += shard.m_hits;
+        stats.m_misses += shard.m_misses;
+        stats.m_stores += shard.m_stores;
+        stats.m_evictions += shard.m_evictions;
+        stats.m_expirations += shard.m_expirations;
+        stats.m_entries += shard.m_lru.size();
+        stats.m_bytes += shard.m_bytes;
+    }
+    return stats;
+}
+}   // namespace ToolKit
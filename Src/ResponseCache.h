@@ -0,0 +1,126 @@
+#pragma once
+
+#include "HttpParser.h"
+#include "HttpResponse.h"
+#include "Infra/SharedBuffer.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <functional>
+#include <list>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace ToolKit
+{
+struct ResponseCacheOptions
+{
+    /* 缓存占用的总字节数上限，0 表示不启用 */
+    size_t m_maxBytes { 0 };
+    size_t m_shards { 16 };
+    /* 超过该大小的响应不缓存 */
+    size_t m_maxEntryBytes { 1024 * 1024 };
+    /* 响应没有 Cache-Control: max-age 时的缓存时间，0 表示只缓存显式声明了 max-age 的响应 */
+    std::chrono::seconds m_defaultTtl { 0 };
+    /* 参与缓存键的请求首部；响应的 Vary 只能引用这里列出的首部，否则不缓存 */
+    std::vector<std::string> m_vary;
+};
+
+/**
+ * @brief 位于处理函数之前的 GET/HEAD 响应缓存
+ * 键由处理函数、规范化后的路径（合并重复的 /、去掉 . 与 .. 段、统一百分号编码）、查询串以及配置的
+ * Vary 请求首部组成；HEAD 请求使用 GET 的条目，但只有 GET 的响应会被保存。
+ * 路径按哈希分片，每个分片一把锁、一条 LRU 链与 m_maxBytes / m_shards 的字节预算。
+ * 只保存 200、不带文件体与 Set-Cookie、Cache-Control 允许共享缓存的响应，缓存时间取 s-maxage、max-age
+ * 或 m_defaultTtl。没有 ETag 的响应在保存时按内容补上强 ETag，命中时据此回答 If-None-Match 与
+ * If-Modified-Since。响应体保存为不可变的 SharedBuffer，命中时挂到响应上，大响应体以引用方式进入输出缓冲区。
+ * 路径规范化意味着同一处理函数收到的不同写法会共享条目，返回可缓存响应的处理函数不能区分这些写法。
+ */
+class ResponseCache
+{
+public:
+    struct Stats
+    {
+        uint64_t m_hits { 0 };
+        uint64_t m_misses { 0 };
+        uint64_t m_stores { 0 };
+        uint64_t m_evictions { 0 };
+        uint64_t m_expirations { 0 };
+        size_t m_entries { 0 };
+        size_t m_bytes { 0 };
+    };
+
+    explicit ResponseCache(ResponseCacheOptions Options);
+    ResponseCache(const ResponseCache&) = delete;
+    const ResponseCache& operator=(const ResponseCache&) = delete;
+
+    /**
+     * @brief 查找 Handler 对 Request 的缓存响应，命中时填充 Response 并返回 true；可并发调用
+     */
+    bool lookup(const HttpRequest& Request, const void* Handler, HttpResponse& Response);
+
+    /**
+     * @brief 处理函数完成后调用，响应可缓存时保存一份；可能给 Response 补充 ETag 首部
+     */
+    void store(const HttpRequest& Request, const void* Handler, HttpResponse& Response);
+
+    Stats stats() const;
+
+private:
+    struct Entry
+    {
+        std::string m_key;
+        std::string m_headers;
+        SharedBuffer::Ptr m_body;
+        std::string m_etag;
+        /* 响应的 Last-Modified，没有时为 -1 */
+        time_t m_lastModified { -1 };
+        std::chrono::steady_clock::time_point m_stored;
+        std::chrono::steady_clock::time_point m_expires;
+        size_t m_bytes { 0 };
+    };
+
+    struct alignas(64) Shard
+    {
+        mutable std::mutex m_mutex;
+        /* 表头是最近使用的条目 */
+        std::list<std::shared_ptr<const Entry>> m_lru;
+        /* 键指向条目中的字符串 */
+        std::unordered_map<std::string_view, std::list<std::shared_ptr<const Entry>>::iterator> m_index;
+        size_t m_bytes { 0 };
+        uint64_t m_hits { 0 };
+        uint64_t m_misses { 0 };
+        uint64_t m_stores { 0 };
+        uint64_t m_evictions { 0 };
+        uint64_t m_expirations { 0 };
+    };
+
+    /**
+     * @brief 生成缓存键，请求不能使用共享缓存（非 GET/HEAD、带 Authorization）时返回 false
+     */
+    bool buildKey(const HttpRequest& Request, const void* Handler, std::pmr::string& Key) const;
+
+    /**
+     * @brief 根据响应首部判断能否缓存，可以时返回缓存时间
+     */
+    bool cacheable(HttpResponse& Response, std::chrono::seconds& Ttl) const;
+
+    Shard& shardOf(std::string_view Key) { return m_shards[std::hash<std::string_view> {}(Key) % m_shards.size()]; }
+
+    /**
+     * @brief 从分片中摘除条目，调用时持有分片锁
+     */
+    static void erase(Shard& Target, std::list<std::shared_ptr<const Entry>>::iterator Position);
+
+    const ResponseCacheOptions m_options;
+    const size_t m_shardBudget;
+    std::vector<Shard> m_shards;
+};
+}   // namespace ToolKit
@@ -0,0 +1,370 @@
+#include "ResponseCompressor.h"
+
+#include "spdlog/spdlog.h"
+
+#include <algorithm>
+#include <event2/buffer.h>
+#include <memory_resource>
+#include <strings.h>
+#include <zlib.h>
+
+namespace
+{
+using ToolKit::CONTENT_CODING;
+
+/* 每次为压缩输出预留的连续空间 */
+constexpr size_t OUTPUT_CHUNK = 16 * 1024;
+/* 条目除键与压缩数据之外的固定开销，计入字节预算 */
+constexpr size_t VARIANT_OVERHEAD = 128;
+/* q 值以千分之一为单位 */
+constexpr int Q_MAX = 1000;
+
+bool equalsIgnoreCase(std::string_view Left, std::string_view Right)
+{
+    return Left.size() == Right.size() && strncasecmp(Left.data(), Right.data(), Left.size()) == 0;
+}
+
+std::string_view trim(std::string_view Text)
+{
+    while (!Text.empty() && (Text.front() == ' ' || Text.front() == '\t'))
+        Text.remove_prefix(1);
+    while (!Text.empty() && (Text.back() == ' ' || Text.back() == '\t'))
+        Text.remove_suffix(1);
+    return Text;
+}
+
+bool nextToken(std::string_view& List, std::string_view& Token)
+{
+    while (!List.empty())
+    {
+        auto comma = List.find(',');
+        Token = trim(List.substr(0, comma));
+        List = comma == std::string_view::npos ? std::string_view {} : List.substr(comma + 1);
+        if (!Token.empty())
+            return true;
+    }
+    return false;
+}
+
+/**
+ * @brief 解析 ;q=0.5 形式的参数，没有 q 参数时为 Q_MAX，格式错误时返回 -1
+ */
+int qValueOf(std::string_view Params)
+{
+    while (!Params.empty())
+    {
+        auto semicolon = Params.find(';');
+        auto param = trim(Params.substr(0, semicolon));
+        Params = semicolon == std::string_view::npos ? std::string_view {} : Params.substr(semicolon + 1);
+        if (param.size() < 3 || (param[0] != 'q' && param[0] != 'Q') || param[1] != '=')
+            continue;
+        auto value = param.substr(2);
+        if (value[0] != '0' && value[0] != '1')
+            return -1;
+        int q = (value[0] - '0') * Q_MAX;
+        if (value.size() > 1)
+        {
+            if (value[1] != '.' || value.size() > 5)
+                return -1;
+            int scale = Q_MAX / 10;
+            for (char c : value.substr(2))
+            {
+                if (c < '0' || c > '9')
+                    return -1;
+                q += (c - '0') * scale;
+                scale /= 10;
+            }
+        }
+        return q > Q_MAX ? -1 : q;
+    }
+    return Q_MAX;
+}
+
+/**
+ * @brief 线程内复用的 zlib 压缩流，gzip 与 deflate 各一个，线程退出时释放
+ */
+struct DeflateStreams
+{
+    struct Slot
+    {
+        z_stream m_stream {};
+        bool m_ready { false };
+        int m_level { Z_DEFAULT_COMPRESSION };
+    };
+
+    ~DeflateStreams()
+    {
+        for (auto& slot : m_slots)
+        {
+            if (slot.m_ready)
+                deflateEnd(&slot.m_stream);
+        }
+    }
+
+    Slot m_slots[2];
+};
+
+z_stream* streamFor(CONTENT_CODING Coding, int Level)
+{
+    thread_local DeflateStreams streams;
+    auto& slot = streams.m_slots[Coding == CONTENT_CODING::GZIP ? 0 : 1];
+    if (!slot.m_ready)
+    {
+        /* windowBits 加 16 输出 gzip 封装，否则为 zlib 封装（HTTP 的 deflate 编码） */
+        int windowBits = Coding == CONTENT_CODING::GZIP ? MAX_WBITS + 16 : MAX_WBITS;
+        if (deflateInit2(&slot.m_stream, Level, Z_DEFLATED, windowBits, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+            return nullptr;
+        slot.m_ready = true;
+        slot.m_level = Level;
+        return &slot.m_stream;
+    }
+    deflateReset(&slot.m_stream);
+    if (slot.m_level != Level && deflateParams(&slot.m_stream, Level, Z_DEFAULT_STRATEGY) == Z_OK)
+        slot.m_level = Level;
+    return &slot.m_stream;
+}
+}   // namespace
+
+namespace ToolKit
+{
+CONTENT_CODING negotiateCoding(std::string_view AcceptEncoding)
+{
+    int gzip = -1;
+    int deflate = -1;
+    int identity = -1;
+    int any = -1;
+    std::string_view token;
+    while (nextToken(AcceptEncoding, token))
+    {
+        auto semicolon = token.find(';');
+        auto name = trim(token.substr(0, semicolon));
+        int q = semicolon == std::string_view::npos ? Q_MAX : qValueOf(token.substr(semicolon + 1));
+        if (q < 0)
+            continue;
+        if (equalsIgnoreCase(name, "gzip") || equalsIgnoreCase(name, "x-gzip"))
+            gzip = q;
+        else if (equalsIgnoreCase(name, "deflate"))
+            deflate = q;
+        else if (equalsIgnoreCase(name, "identity"))
+            identity = q;
+        else if (name == "*")
+            any = q;
+    }
+    /* 未列出的编码取 * 的权重；identity 总是可以接受，只有显式给出（或经 *）更高的权重时才优先于压缩 */
+    gzip = gzip < 0 ? any : gzip;
+    deflate = deflate < 0 ? any : deflate;
+    identity = identity < 0 ? any : identity;
+    int best = std::max(gzip, deflate);
+    if (best <= 0 || best < identity)
+        return CONTENT_CODING::IDENTITY;
+    return gzip >= deflate ? CONTENT_CODING::GZIP : CONTENT_CODING::DEFLATE;
+}
+
+std::string_view codingName(CONTENT_CODING Coding)
+{
+    switch (Coding)
+    {
+        case CONTENT_CODING::GZIP:
+            return "gzip";
+        case CONTENT_CODING::DEFLATE:
+            return "deflate";
+        default:
+            return {};
+    }
+}
+
+bool compressBuffer(CONTENT_CODING Coding, int Level, struct evbuffer* Source, struct evbuffer* Output)
+{
+    if (Coding == CONTENT_CODING::IDENTITY)
+        return evbuffer_add_buffer(Output, Source) == 0;
+    z_stream* stream = streamFor(Coding, Level);
+    if (stream == nullptr)
+        return false;
+
+    size_t remaining = evbuffer_get_length(Source);
+    do
+    {
+        /* 每次只取输入的第一个内存块，压缩完再从 Source 中移除 */
+        struct evbuffer_iovec chunk { nullptr, 0 };
+        if (remaining > 0)
+            evbuffer_peek(Source, -1, nullptr, &chunk, 1);
+        remaining -= chunk.iov_len;
+        stream->next_in = static_cast<Bytef*>(chunk.iov_base);
+        stream->avail_in = static_cast<uInt>(chunk.iov_len);
+        const int flush = remaining == 0 ? Z_FINISH : Z_NO_FLUSH;
+        int ret = Z_OK;
+        do
+        {
+            struct evbuffer_iovec space;
+            if (evbuffer_reserve_space(Output, OUTPUT_CHUNK, &space, 1) < 1)
+                return false;
+            stream->next_out = static_cast<Bytef*>(space.iov_base);
+            stream->avail_out = static_cast<uInt>(space.iov_len);
+            ret = deflate(stream, flush);
+            space.iov_len -= stream->avail_out;
+            evbuffer_commit_space(Output, &space, 1);
+            if (ret == Z_STREAM_ERROR)
+                return false;
+        } while (stream->avail_out == 0 || (flush == Z_FINISH && ret != Z_STREAM_END));
+        evbuffer_drain(Source, chunk.iov_len);
+    } while (remaining > 0);
+    return true;
+}
+
+ResponseCompressor::ResponseCompressor(ResponseCompressorOptions Options)
+        : m_options(std::move(Options))
+        , m_shardBudget(m_options.m_variantCacheBytes / std::max<size_t>(1, m_options.m_shards))
+        , m_shards(std::max<size_t>(1, m_options.m_shards))
+{
+}
+
+bool ResponseCompressor::compressibleType(std::string_view ContentType) const
+{
+    return std::any_of(m_options.m_types.begin(), m_options.m_types.end(),
+        [ContentType](const std::string& Prefix)
+        { return ContentType.size() >= Prefix.size() && equalsIgnoreCase(ContentType.substr(0, Prefix.size()), Prefix); });
+}
+
+void ResponseCompressor::apply(const HttpRequest& Request, const void* Handler, HttpResponse& Response)
+{
+    if (Response.status() != 200 || !Response.header("Content-Encoding").empty()
+        || !compressibleType(Response.header("Content-Type")))
+        return;
+    const size_t length = Response.bodyLength();
+    if (length < m_options.m_minBytes || length > m_options.m_maxBytes)
+        return;
+
+    /* 无论这次是否压缩，表示都随 Accept-Encoding 变化 */
+    auto vary = Response.header("Vary");
+    bool listed = vary == "*";
+    std::string_view token;
+    while (!listed && nextToken(vary, token))
+        listed = equalsIgnoreCase(token, "Accept-Encoding");
+    if (!listed)
+        Response.addHeader("Vary", "Accept-Encoding");
+
+    const auto coding = negotiateCoding(Request.header("Accept-Encoding"));
+    if (coding == CONTENT_CODING::IDENTITY)
+        return;
+
+    std::pmr::string etag(Response.header("ETag"), Request.arena());
+    const bool strong = !etag.empty() && etag.compare(0, 2, "W/") != 0;
+    std::pmr::string key(Request.arena());
+    SharedBuffer::Ptr variant;
+    if (strong && m_shardBudget > 0)
+    {
+        key.reserve(sizeof(Handler) + 1 + etag.size() + 1 + Request.m_path.size());
+        key.append(reinterpret_cast<const char*>(&Handler), sizeof(Handler));
+        key.push_back(static_cast<char>(coding));
+        key.append(etag);
+        key.push_back('\n');
+        key.append(Request.m_path);
+        variant = findVariant(key);
+    }
+
+    if (variant)
+    {
+        Response.clearBody();
+    }
+    else
+    {
+        struct evbuffer* source = evbuffer_new();
+        struct evbuffer* compressed = evbuffer_new();
+        Response.takeBody(source);
+        bool ok = compressBuffer(coding, m_options.m_level, source, compressed);
+        const size_t compressedLength = evbuffer_get_length(compressed);
+        if (ok)
+        {
+            m_compressed.fetch_add(1, std::memory_order_relaxed);
+            m_bytesIn.fetch_add(length, std::memory_order_relaxed);
+            m_bytesOut.fetch_add(compressedLength, std::memory_order_relaxed);
+            if (!key.empty())
+            {
+                variant = SharedBuffer::copyOf(evbuffer_pullup(compressed, -1), compressedLength);
+                storeVariant(key, variant);
+            }
+            else
+            {
+                evbuffer_add_buffer(Response.body(), compressed);
+            }
+        }
+        evbuffer_free(source);
+        evbuffer_free(compressed);
+        if (!ok)
+        {
+            spdlog::warn("{} {} compression failed", __FUNCTION__, codingName(coding));
+            Response.setStatus(500);
+            return;
+        }
+    }
+    if (variant)
+        Response.setSharedBody(std::move(variant));
+    Response.addHeader("Content-Encoding", codingName(coding));
+
+    /* 压缩结果与原内容逐字节不同，改为弱标签；If-None-Match 是弱比较，仍与原标签匹配 */
+    if (strong)
+    {
+        etag.insert(0, "W/");
+        Response.removeHeader("ETag");
+        Response.addHeader("ETag", etag);
+    }
+}
+
+SharedBuffer::Ptr ResponseCompressor::findVariant(std::string_view Key)
+{
+    Shard& shard = shardOf(Key);
+    std::lock_guard<std::mutex> lk(shard.m_mutex);
+    auto it = shard.m_index.find(Key);
+    if (it == shard.m_index.end())
+        return {};
+    shard.m_lru.splice(shard.m_lru.begin(), shard.m_lru, it->second);
+    shard.m_hits++;
+    return it->second->m_body;
+}
+
+void ResponseCompressor::storeVariant(std::string_view Key, const SharedBuffer::Ptr& Body)
+{
+    const size_t bytes = Key.size() + Body->size() + VARIANT_OVERHEAD;
+    if (bytes > m_shardBudget)
+        return;
+    Shard& shard = shardOf(Key);
+    /* 被淘汰的条目移到这里，解锁之后再释放 */
+    std::list<Variant> evicted;
+    {
+        std::lock_guard<std::mutex> lk(shard.m_mutex);
+        /* 并发的请求可能已经保存了同一内容 */
+        if (shard.m_index.count(Key) != 0)
+            return;
+        while (shard.m_bytes + bytes > m_shardBudget && !shard.m_lru.empty())
+        {
+            auto last = std::prev(shard.m_lru.end());
+            shard.m_bytes -= last->m_key.size() + last->m_body->size() + VARIANT_OVERHEAD;
+            shard.m_index.erase(last->m_key);
+            evicted.splice(evicted.begin(), shard.m_lru, last);
+            shard.m_evictions++;
+        }
+        shard.m_lru.push_front(Variant { std::string(Key), Body });
+        shard.m_index.emplace(shard.m_lru.front().m_key, shard.m_lru.begin());
+        shard.m_bytes += bytes;
+        shard.m_stores++;
+    }
+}
+
+ResponseCompressor::Stats ResponseCompressor::stats() const
+{
+    Stats stats;
+    stats.m_compressed = m_compressed.load(std::memory_order_relaxed);
+    stats.m_bytesIn = m_bytesIn.load(std::memory_order_relaxed);
+    stats.m_bytesOut = m_bytesOut.load(std::memory_order_relaxed);
+    for (auto& shard : m_shards)
+    {
+        std::lock_guard<std::mutex> lk(shard.m_mutex);
+        stats.m_variantHits += shard.m_hits;
+        stats.m_variantStores += shard.m_stores;
+        stats.m_evictions += shard.m_evictions;
+        stats.m_entries += shard.m_lru.size();
+        stats.m_bytes += shard.m_bytes;
+    }
+    return stats;
+}
+}   // namespace ToolKit
@@ -0,0 +1,129 @@
+#pragma once
+
+#include "HttpParser.h"
+#include "HttpResponse.h"
+#include "Infra/SharedBuffer.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+struct evbuffer;
+
+namespace ToolKit
+{
+enum class CONTENT_CODING
+{
+    IDENTITY,
+    GZIP,
+    DEFLATE
+};
+
+/**
+ * @brief 按 Accept-Encoding 的 q 值选择内容编码，同等权重时优先 gzip；identity 的权重高于压缩编码时不压缩
+ */
+CONTENT_CODING negotiateCoding(std::string_view AcceptEncoding);
+
+/**
+ * @brief Content-Encoding 中使用的编码名称，IDENTITY 返回空视图
+ */
+std::string_view codingName(CONTENT_CODING Coding);
+
+/**
+ * @brief 以 Coding 压缩 Source 的全部内容并追加到 Output，Source 随后被清空
+ * 逐块读取 Source 的内存块、直接压缩进 Output 预留的空间，不拼接输入也不产生中间拷贝。
+ * zlib 流按线程复用，每次压缩只做 deflateReset，不会为单个响应分配压缩器状态。
+ */
+bool compressBuffer(CONTENT_CODING Coding, int Level, struct evbuffer* Source, struct evbuffer* Output);
+
+struct ResponseCompressorOptions
+{
+    /* zlib 压缩级别 1-9，0 表示不启用 */
+    int m_level { 6 };
+    /* 小于该长度的响应体压缩收益有限，原样发送 */
+    size_t m_minBytes { 256 };
+    /* 超过该长度的响应体不压缩，避免在事件循环上长时间占用 CPU */
+    size_t m_maxBytes { 8 * 1024 * 1024 };
+    /* 压缩结果缓存的总字节数上限，0 表示不缓存 */
+    size_t m_variantCacheBytes { 32 * 1024 * 1024 };
+    size_t m_shards { 16 };
+    /* 可压缩的 Content-Type 前缀（大小写不敏感） */
+    std::vector<std::string> m_types { "text/", "application/json", "application/javascript", "application/xml",
+        "image/svg+xml" };
+};
+
+/**
+ * @brief 按 Accept-Encoding 协商 gzip/deflate 并压缩响应体
+ * 只处理 200、尚无 Content-Encoding、Content-Type 可压缩且长度在 [m_minBytes, m_maxBytes] 内的响应；
+ * 这类响应都会带上 Vary: Accept-Encoding，压缩后的 ETag 改为弱标签，仍能与原标签做 If-None-Match 弱比较。
+ * 带强 ETag 的响应（缓存命中、静态文件以及 ResponseCache 保存过的响应）内容由 ETag 标识，
+ * 压缩结果按处理函数、路径、ETag 与编码保存在分片 LRU 中，同一内容只压缩一次；其余响应每次压缩。
+ */
+class ResponseCompressor
+{
+public:
+    struct Stats
+    {
+        uint64_t m_compressed { 0 };
+        uint64_t m_variantHits { 0 };
+        uint64_t m_variantStores { 0 };
+        uint64_t m_evictions { 0 };
+        uint64_t m_bytesIn { 0 };
+        uint64_t m_bytesOut { 0 };
+        size_t m_entries { 0 };
+        size_t m_bytes { 0 };
+    };
+
+    explicit ResponseCompressor(ResponseCompressorOptions Options);
+    ResponseCompressor(const ResponseCompressor&) = delete;
+    const ResponseCompressor& operator=(const ResponseCompressor&) = delete;
+
+    /**
+     * @brief 处理函数或缓存给出响应之后调用，按需压缩 Response 的响应体；可并发调用
+     */
+    void apply(const HttpRequest& Request, const void* Handler, HttpResponse& Response);
+
+    Stats stats() const;
+
+private:
+    struct Variant
+    {
+        std::string m_key;
+        SharedBuffer::Ptr m_body;
+    };
+
+    struct alignas(64) Shard
+    {
+        mutable std::mutex m_mutex;
+        /* 表头是最近使用的条目 */
+        std::list<Variant> m_lru;
+        std::unordered_map<std::string_view, std::list<Variant>::iterator> m_index;
+        size_t m_bytes { 0 };
+        uint64_t m_hits { 0 };
+        uint64_t m_stores { 0 };
+        uint64_t m_evictions { 0 };
+    };
+
+    bool compressibleType(std::string_view ContentType) const;
+
+    SharedBuffer::Ptr findVariant(std::string_view Key);
+
+    void storeVariant(std::string_view Key, const SharedBuffer::Ptr& Body);
+
+    Shard& shardOf(std::string_view Key) { return m_shards[std::hash<std::string_view> {}(Key) % m_shards.size()]; }
+
+    const ResponseCompressorOptions m_options;
+    const size_t m_shardBudget;
+    std::vector<Shard> m_shards;
+    std::atomic<uint64_t> m_compressed { 0 };
+    std::atomic<uint64_t> m_bytesIn { 0 };
+    std::atomic<uint64_t> m_bytesOut { 0 };
+};
+}   // namespace ToolKit
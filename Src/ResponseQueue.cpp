@@ -0,0 +1,47 @@
+#include "ResponseQueue.h"
+
+namespace ToolKit
+{
+ResponseQueue::Slot& ResponseQueue::push(bool HeadOnly)
+{
+    std::unique_ptr<Slot> slot;
+    if (m_free.empty())
+    {
+        slot = std::make_unique<Slot>();
+    }
+    else
+    {
+        slot = std::move(m_free.back());
+        m_free.pop_back();
+    }
+    slot->m_headOnly = HeadOnly;
+    slot->m_ready = false;
+    m_pending.push_back(std::move(slot));
+    return *m_pending.back();
+}
+
+size_t ResponseQueue::flush(struct evbuffer* Output)
+{
+    size_t written = 0;
+    while (!m_pending.empty() && m_pending.front()->m_ready)
+    {
+        auto slot = std::move(m_pending.front());
+        m_pending.pop_front();
+        slot->m_response.writeTo(Output, slot->m_headOnly);
+        slot->m_response.reset();
+        m_free.push_back(std::move(slot));
+        written++;
+    }
+    return written;
+}
+
+void ResponseQueue::clear()
+{
+    while (!m_pending.empty())
+    {
+        m_pending.front()->m_response.reset();
+        m_free.push_back(std::move(m_pending.front()));
+        m_pending.pop_front();
+    }
+}
+}   // namespace ToolKit
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "HttpResponse.h"
+
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <vector>
+
+struct evbuffer;
+
+namespace ToolKit
+{
+/**
+ * @brief 流水线请求的响应队列
+ * 每个请求按到达顺序占用一个槽位，处理完成后标记就绪；flush 只按顺序输出队首连续就绪的响应，
+ * 保证 HTTP/1.1 流水线的响应顺序。槽位中的 HttpResponse 用完后回收复用，不会每个请求重新分配缓冲区。
+ */
+class ResponseQueue
+{
+public:
+    struct Slot
+    {
+        HttpResponse m_response;
+        bool m_headOnly { false };
+        bool m_ready { false };
+    };
+
+    /**
+     * @brief 为新请求在队尾分配槽位
+     */
+    Slot& push(bool HeadOnly);
+
+    void markReady(Slot& Target) { Target.m_ready = true; }
+
+    /**
+     * @brief 把队首连续就绪的响应一次性写入 Output
+     *
+     * @return size_t 写出的响应个数
+     */
+    size_t flush(struct evbuffer* Output);
+
+    bool empty() const { return m_pending.empty(); }
+    size_t size() const { return m_pending.size(); }
+
+    /**
+     * @brief 丢弃所有未输出的响应，连接关闭或复用时调用
+     */
+    void clear();
+
+private:
+    std::deque<std::unique_ptr<Slot>> m_pending;
+    std::vector<std::unique_ptr<Slot>> m_free;
+};
+}   // namespace ToolKit
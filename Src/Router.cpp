@@ -0,0 +1,311 @@
+#include "Router.h"
+
+#include "spdlog/spdlog.h"
+
+#include <algorithm>
+#include <memory>
+
+namespace
+{
+enum class TOKEN_KIND
+{
+    STATIC,
+    PARAM,
+    WILDCARD
+};
+
+struct PatternToken
+{
+    TOKEN_KIND m_kind;
+    std::string_view m_text;
+};
+
+bool validName(std::string_view Name)
+{
+    return std::all_of(Name.begin(), Name.end(),
+        [](char C) { return (C >= 'a' && C <= 'z') || (C >= 'A' && C <= 'Z') || (C >= '0' && C <= '9') || C == '_'; });
+}
+
+/**
+ * @brief 把路由模式拆成静态文本、参数与通配符，模式非法时返回 false
+ */
+bool parsePattern(std::string_view Pattern, std::vector<PatternToken>& Tokens)
+{
+    if (Pattern.empty() || Pattern.front() != '/')
+        return false;
+    size_t params = 0;
+    size_t pos = 0;
+    while (pos < Pattern.size())
+    {
+        if (Pattern[pos] == ':')
+        {
+            auto end = std::min(Pattern.find('/', pos), Pattern.size());
+            auto name = Pattern.substr(pos + 1, end - pos - 1);
+            if (name.empty() || !validName(name))
+                return false;
+            Tokens.push_back({ TOKEN_KIND::PARAM, name });
+            params++;
+            pos = end;
+        }
+        else if (Pattern[pos] == '*')
+        {
+            auto name = Pattern.substr(pos + 1);
+            if (!validName(name))
+                return false;
+            Tokens.push_back({ TOKEN_KIND::WILDCARD, name });
+            params++;
+            pos = Pattern.size();
+        }
+        else
+        {
+            auto end = std::min(Pattern.find_first_of(":*", pos), Pattern.size());
+            Tokens.push_back({ TOKEN_KIND::STATIC, Pattern.substr(pos, end - pos) });
+            pos = end;
+        }
+    }
+    return params <= ToolKit::MAX_ROUTE_PARAMS;
+}
+}   // namespace
+
+namespace ToolKit
+{
+/**
+ * @brief 构建期使用的普通树节点，压平后丢弃
+ */
+struct Router::BuildNode
+{
+    std::string m_label;
+    std::vector<std::unique_ptr<BuildNode>> m_children;
+    std::unique_ptr<BuildNode> m_param;
+    std::string m_wildcardName;
+    int32_t m_wildcard { -1 };
+    int32_t m_handler { -1 };
+
+    /**
+     * @brief 沿静态子节点插入 Text，必要时拆分已有标签，返回 Text 结束处的节点
+     */
+    BuildNode* insertStatic(std::string_view Text)
+    {
+        BuildNode* node = this;
+        while (!Text.empty())
+        {
+            auto it = std::find_if(node->m_children.begin(), node->m_children.end(),
+                [Text](const std::unique_ptr<BuildNode>& Child) { return Child->m_label.front() == Text.front(); });
+            if (it == node->m_children.end())
+            {
+                node->m_children.push_back(std::make_unique<BuildNode>());
+                node->m_children.back()->m_label.assign(Text);
+                return node->m_children.back().get();
+            }
+            auto& label = (*it)->m_label;
+            size_t common = 0;
+            while (common < label.size() && common < Text.size() && label[common] == Text[common])
+                common++;
+            if (common < label.size())
+            {
+                auto middle = std::make_unique<BuildNode>();
+                middle->m_label = label.substr(0, common);
+                label.erase(0, common);
+                middle->m_children.push_back(std::move(*it));
+                *it = std::move(middle);
+            }
+            node = it->get();
+            Text.remove_prefix(common);
+        }
+        return node;
+    }
+
+    /**
+     * @brief 把一条路由插入构建树，与已有路由冲突（同一位置参数名不同、通配符或终点重复）时返回 false
+     * 冲突前可能已经插入了不带处理函数的静态节点，它们只会让匹配多走一步回溯，不影响结果。
+     */
+    bool insert(const std::vector<PatternToken>& Tokens, int32_t Index)
+    {
+        BuildNode* node = this;
+        for (auto& token : Tokens)
+        {
+            if (token.m_kind == TOKEN_KIND::STATIC)
+            {
+                node = node->insertStatic(token.m_text);
+            }
+            else if (token.m_kind == TOKEN_KIND::PARAM)
+            {
+                if (!node->m_param)
+                {
+                    node->m_param = std::make_unique<BuildNode>();
+                    node->m_param->m_label.assign(token.m_text);
+                }
+                else if (node->m_param->m_label != token.m_text)
+                {
+                    return false;
+                }
+                node = node->m_param.get();
+            }
+            else
+            {
+                if (node->m_wildcard >= 0)
+                    return false;
+                node->m_wildcard = Index;
+                node->m_wildcardName.assign(token.m_text);
+                return true;
+            }
+        }
+        if (node->m_handler >= 0)
+            return false;
+        node->m_handler = Index;
+        return true;
+    }
+};
+
+Router::Router(const std::vector<std::pair<std::string, HttpHandler>>& Routes)
+{
+    BuildNode root;
+    std::vector<PatternToken> tokens;
+    for (auto& [pattern, handler] : Routes)
+    {
+        tokens.clear();
+        if (!parsePattern(pattern, tokens))
+        {
+            spdlog::warn("[{}] skip invalid route pattern [{}]", __FUNCTION__, pattern);
+            continue;
+        }
+        if (!root.insert(tokens, static_cast<int32_t>(m_handlers.size())))
+        {
+            spdlog::warn("[{}] skip route pattern [{}] that conflicts with an earlier route", __FUNCTION__, pattern);
+            continue;
+        }
+        m_handlers.push_back(handler);
+    }
+
+    /* 广度优先压平：处理到某个节点时把它的静态子节点按首字节排序后连续追加，参数子节点紧随其后 */
+    auto append = [this](const BuildNode& Source)
+    {
+        Node node;
+        node.m_labelOffset = static_cast<uint32_t>(m_labels.size());
+        node.m_labelLength = static_cast<uint32_t>(Source.m_label.size());
+        m_labels.append(Source.m_label);
+        m_nodes.push_back(node);
+        m_firstBytes.push_back(Source.m_label.empty() ? 0 : static_cast<unsigned char>(Source.m_label.front()));
+    };
+    std::vector<const BuildNode*> order { &root };
+    append(root);
+    std::vector<const BuildNode*> children;
+    for (size_t i = 0; i < order.size(); i++)
+    {
+        const BuildNode& source = *order[i];
+        children.clear();
+        for (auto& child : source.m_children)
+            children.push_back(child.get());
+        std::sort(children.begin(), children.end(),
+            [](const BuildNode* Left, const BuildNode* Right)
+            { return static_cast<unsigned char>(Left->m_label.front()) < static_cast<unsigned char>(Right->m_label.front()); });
+
+        m_nodes[i].m_firstChild = static_cast<uint32_t>(m_nodes.size());
+        m_nodes[i].m_childCount = static_cast<uint32_t>(children.size());
+        for (auto* child : children)
+        {
+            append(*child);
+            order.push_back(child);
+        }
+        if (source.m_param)
+        {
+            m_nodes[i].m_param = static_cast<int32_t>(m_nodes.size());
+            append(*source.m_param);
+            order.push_back(source.m_param.get());
+        }
+        m_nodes[i].m_handler = source.m_handler;
+        m_nodes[i].m_wildcard = source.m_wildcard;
+        m_nodes[i].m_wildcardOffset = static_cast<uint32_t>(m_labels.size());
+        m_nodes[i].m_wildcardLength = static_cast<uint32_t>(source.m_wildcardName.size());
+        m_labels.append(source.m_wildcardName);
+    }
+}
+
+bool Router::match(std::string_view Path, RouteMatch& Match) const
+{
+    Match.m_handler = nullptr;
+    Match.m_paramCount = 0;
+    return !m_nodes.empty() && matchNode(0, Path, Match);
+}
+
+bool Router::matchNode(uint32_t Index, std::string_view Rest, RouteMatch& Match) const
+{
+    const Node& node = m_nodes[Index];
+    if (Rest.empty())
+    {
+        if (node.m_handler >= 0)
+        {
+            Match.m_handler = &m_handlers[static_cast<size_t>(node.m_handler)];
+            return true;
+        }
+    }
+    else
+    {
+        /* 静态子节点的首字节互不相同，最多只有一个候选 */
+        auto first = m_firstBytes.begin() + node.m_firstChild;
+        auto last = first + node.m_childCount;
+        auto it = std::lower_bound(first, last, static_cast<unsigned char>(Rest.front()));
+        if (it != last && *it == static_cast<unsigned char>(Rest.front()))
+        {
+            const auto child = static_cast<uint32_t>(node.m_firstChild + (it - first));
+            auto text = label(m_nodes[child].m_labelOffset, m_nodes[child].m_labelLength);
+            if (Rest.compare(0, text.size(), text) == 0 && matchNode(child, Rest.substr(text.size()), Match))
+                return true;
+        }
+        if (node.m_param >= 0 && Match.m_paramCount < MAX_ROUTE_PARAMS)
+        {
+            auto value = Rest.substr(0, Rest.find('/'));
+            if (!value.empty())
+            {
+                const Node& param = m_nodes[static_cast<size_t>(node.m_param)];
+                Match.m_params[Match.m_paramCount++] = { label(param.m_labelOffset, param.m_labelLength), value };
+                if (matchNode(static_cast<uint32_t>(node.m_param), Rest.substr(value.size()), Match))
+                    return true;
+                Match.m_paramCount--;
+            }
+        }
+    }
+    if (node.m_wildcard >= 0 && Match.m_paramCount < MAX_ROUTE_PARAMS)
+    {
+        Match.m_params[Match.m_paramCount++] = { label(node.m_wildcardOffset, node.m_wildcardLength), Rest };
+        Match.m_handler = &m_handlers[static_cast<size_t>(node.m_wildcard)];
+        return true;
+    }
+    return false;
+}
+
+bool RouteRegistry::add(const std::string& Pattern, HttpHandler Handler)
+{
+    std::lock_guard<std::mutex> lk(m_mutex);
+    if (!m_routes.emplace(Pattern, std::move(Handler)).second)
+    {
+        spdlog::warn("[{}] Error with repeatedly register the route [{}], pls check it", __FUNCTION__, Pattern);
+        return false;
+    }
+    return true;
+}
+
+void RouteRegistry::remove(const std::string& Pattern)
+{
+    std::lock_guard<std::mutex> lk(m_mutex);
+    m_routes.erase(Pattern);
+}
+
+std::vector<std::pair<std::string, HttpHandler>> RouteRegistry::routes() const
+{
+    std::lock_guard<std::mutex> lk(m_mutex);
+    return { m_routes.begin(), m_routes.end() };
+}
+
+RouteRegistrar::RouteRegistrar(std::string Pattern, HttpRequestHandler Handler, HANDLER_MODE Mode)
+        : m_pattern(std::move(Pattern))
+{
+    m_needDelete = RouteRegistry::instance().add(m_pattern, HttpHandler { std::move(Handler), Mode });
+}
+
+RouteRegistrar::~RouteRegistrar()
+{
+    if (m_needDelete)
+        RouteRegistry::instance().remove(m_pattern);
+}
+}   // namespace ToolKit
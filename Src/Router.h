@@ -0,0 +1,140 @@
+#pragma once
+
+#include "HttpConnection.h"
+#include "HttpParser.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace ToolKit
+{
+/* 单条路由中路径参数（含通配符）的最大数量 */
+constexpr size_t MAX_ROUTE_PARAMS = 8;
+
+/**
+ * @brief 一次路由匹配的结果，由调用者在栈上提供，匹配过程不分配内存
+ */
+struct RouteMatch
+{
+    const HttpHandler* m_handler { nullptr };
+    std::array<RouteParam, MAX_ROUTE_PARAMS> m_params;
+    size_t m_paramCount { 0 };
+};
+
+/**
+ * @brief 启动时构建、之后只读的压缩基数树路由
+ * 路由模式以 / 开头：:name 匹配一段非空且不含 / 的内容，*name（名称可省略）只能出现在末尾、匹配剩余的全部内容（可以为空）。
+ * 同一位置上静态前缀优先于参数，参数优先于通配符；较具体的分支匹配失败时回溯到较宽泛的分支。
+ * 构造时先建出普通的树，再按广度优先压平到连续数组：同一节点的静态子节点相邻存放，另有一个数组保存它们
+ * 的首字节供二分查找，所有标签拼接在一个字符串中。匹配只读这几块连续内存，不加锁、不分配内存，
+ * 耗时取决于路径长度与树的深度，与路由总数基本无关。
+ */
+class Router
+{
+public:
+    Router() = default;
+
+    /**
+     * @brief 由 (模式, 处理函数) 列表构建路由，非法或相互冲突的模式记录告警后跳过
+     */
+    explicit Router(const std::vector<std::pair<std::string, HttpHandler>>& Routes);
+
+    /**
+     * @brief 匹配 Path，成功时填充 Match；参数名指向路由自身，参数值指向 Path
+     */
+    bool match(std::string_view Path, RouteMatch& Match) const;
+
+    /**
+     * @brief 成功加入的路由数
+     */
+    size_t size() const { return m_handlers.size(); }
+
+private:
+    struct Node
+    {
+        /* 静态节点为要匹配的字节，参数节点为参数名 */
+        uint32_t m_labelOffset { 0 };
+        uint32_t m_labelLength { 0 };
+        /* 静态子节点在 m_nodes 中连续存放 */
+        uint32_t m_firstChild { 0 };
+        uint32_t m_childCount { 0 };
+        int32_t m_param { -1 };
+        int32_t m_handler { -1 };
+        int32_t m_wildcard { -1 };
+        uint32_t m_wildcardOffset { 0 };
+        uint32_t m_wildcardLength { 0 };
+    };
+
+    struct BuildNode;
+
+    bool matchNode(uint32_t Index, std::string_view Rest, RouteMatch& Match) const;
+
+    std::string_view label(uint32_t Offset, uint32_t Length) const { return { m_labels.data() + Offset, Length }; }
+
+    std::vector<Node> m_nodes;
+    /* 与 m_nodes 一一对应的静态标签首字节 */
+    std::vector<unsigned char> m_firstBytes;
+    std::string m_labels;
+    std::vector<HttpHandler> m_handlers;
+};
+
+/**
+ * @brief 静态路由注册表，RouteRegistrar 在静态初始化期间向这里登记路由，HttpServer::run 时读取并构建 Router
+ */
+class RouteRegistry
+{
+public:
+    static RouteRegistry& instance()
+    {
+        static RouteRegistry instance;
+        return instance;
+    }
+
+    /**
+     * @brief 登记路由，模式重复时返回 false
+     */
+    bool add(const std::string& Pattern, HttpHandler Handler);
+    void remove(const std::string& Pattern);
+
+    /**
+     * @brief 当前登记的全部路由，按模式排序
+     */
+    std::vector<std::pair<std::string, HttpHandler>> routes() const;
+
+    RouteRegistry(const RouteRegistry&) = delete;
+    const RouteRegistry& operator=(const RouteRegistry&) = delete;
+
+private:
+    RouteRegistry() = default;
+
+    mutable std::mutex m_mutex;
+    std::map<std::string, HttpHandler> m_routes;
+};
+
+/**
+ * @brief 路由注册器，与 ProductClassRegistrar 一样以静态对象的形式在所在编译单元中注册，析构时注销
+ * ex:
+ *     static RouteRegistrar userRoute("/users/:id",
+ *         [](const HttpRequest& Request, HttpResponse& Response) { ... Request.param("id") ... });
+ */
+class RouteRegistrar
+{
+public:
+    RouteRegistrar(std::string Pattern, HttpRequestHandler Handler, HANDLER_MODE Mode = HANDLER_MODE::INLINE);
+    ~RouteRegistrar();
+
+    RouteRegistrar(const RouteRegistrar&) = delete;
+    const RouteRegistrar& operator=(const RouteRegistrar&) = delete;
+
+private:
+    std::string m_pattern;
+    bool m_needDelete;
+};
+}   // namespace ToolKit
@@ -0,0 +1,350 @@
+#include "SocketStream.h"
+
+#include "UringPoller.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <event2/buffer.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace ToolKit
+{
+SocketStream::~SocketStream()
+{
+    if (m_fd >= 0)
+        detach();
+    if (m_input != nullptr)
+        evbuffer_free(m_input);
+    if (m_output != nullptr)
+        evbuffer_free(m_output);
+}
+
+void SocketStream::setCallbacks(Callback OnRead, Callback OnWrite, Callback OnClose, void* Arg)
+{
+    m_onRead = OnRead;
+    m_onWrite = OnWrite;
+    m_onClose = OnClose;
+    m_arg = Arg;
+}
+
+bool SocketStream::attach(Poller& Owner, int Fd)
+{
+    if (m_input == nullptr)
+    {
+        m_input = evbuffer_new();
+        m_output = evbuffer_new();
+        m_outputCb = evbuffer_add_cb(m_output, onOutput, this);
+    }
+    m_readable = false;
+    m_hangup = false;
+    m_writeBlocked = false;
+    m_recvCancelling = m_pendingRead = m_eofPending = false;
+    if (Owner.backend() == IO_BACKEND::URING)
+    {
+        /* sendmsg 需要数据的地址，文件段要映射进内存而不是留给 sendfile */
+        evbuffer_clear_flags(m_output, EVBUFFER_FLAG_DRAINS_TO_FD);
+        m_uring = static_cast<UringPoller*>(&Owner);
+        m_poller = &Owner;
+        m_fd = Fd;
+        m_readEnabled = true;
+        startRecv();
+        return true;
+    }
+    evbuffer_set_flags(m_output, EVBUFFER_FLAG_DRAINS_TO_FD);
+    if (!Owner.add(m_watch, Fd, POLL_READ | POLL_WRITE | POLL_EDGE, onEvents, this))
+        return false;
+    m_poller = &Owner;
+    m_fd = Fd;
+    m_readEnabled = true;
+    return true;
+}
+
+void SocketStream::detach()
+{
+    if (m_alive != nullptr)
+    {
+        *m_alive = false;
+        m_alive = nullptr;
+    }
+    if (m_deferred)
+    {
+        m_poller->cancelDeferred(this);
+        m_deferred = false;
+    }
+    if (m_fd >= 0 && m_uring != nullptr)
+    {
+        /* 在途的操作持有套接字的引用，只关闭 fd 不会让阻塞中的发送结束 */
+        if (m_recvOp != nullptr || m_sendOp != nullptr)
+            shutdown(m_fd, SHUT_RDWR);
+        for (auto** op : { &m_recvOp, &m_sendOp })
+        {
+            if (*op != nullptr)
+                m_uring->release(*op);
+            *op = nullptr;
+        }
+    }
+    else if (m_fd >= 0)
+        m_poller->remove(m_watch);
+    if (m_fd >= 0)
+        close(m_fd);
+    m_fd = -1;
+    m_poller = nullptr;
+    m_uring = nullptr;
+    m_readEnabled = false;
+    evbuffer_drain(m_input, evbuffer_get_length(m_input));
+    evbuffer_drain(m_output, evbuffer_get_length(m_output));
+}
+
+void SocketStream::enableRead()
+{
+    m_readEnabled = true;
+    if (m_uring != nullptr)
+    {
+        /* 撤销尚未结束时等它结束再重新提交 */
+        if (m_recvOp == nullptr && !m_eofPending && m_fd >= 0)
+            startRecv();
+        m_pendingRead = true;
+        schedule();
+        return;
+    }
+    /* 暂停期间到达的可读边沿已经消耗掉，不会再有通知，由本轮结束时补读 */
+    if (m_readable)
+        schedule();
+}
+
+void SocketStream::disableRead()
+{
+    m_readEnabled = false;
+    if (m_recvOp != nullptr && !m_recvCancelling)
+    {
+        m_recvCancelling = true;
+        m_uring->cancel(m_recvOp);
+    }
+}
+
+bool SocketStream::writePending() const
+{
+    return m_sendOp != nullptr || (m_output != nullptr && evbuffer_get_length(m_output) > 0);
+}
+
+void SocketStream::startRecv()
+{
+    m_recvCancelling = false;
+    m_recvOp = m_uring->recv(m_fd, onReceived, this);
+}
+
+void SocketStream::schedule()
+{
+    if (m_deferred || m_poller == nullptr)
+        return;
+    m_deferred = true;
+    m_poller->defer(onDeferred, this);
+}
+
+void SocketStream::onOutput(struct evbuffer* Buffer, const struct evbuffer_cb_info* Info, void* Arg)
+{
+    auto* stream = static_cast<SocketStream*>(Arg);
+    /* 同一轮中的多次写入合并到本轮结束时一次写出；等待可写边沿或在途的发送完成时由它们触发写出 */
+    if (Info->n_added > 0 && !stream->m_writeBlocked && stream->m_sendOp == nullptr)
+        stream->schedule();
+}
+
+void SocketStream::onEvents(int Fd, uint32_t Events, void* Arg)
+{
+    auto* stream = static_cast<SocketStream*>(Arg);
+    CallbackScope scope(*stream);
+    if (Events & POLL_READ)
+        stream->m_readable = true;
+    if (Events & POLL_HANGUP)
+        stream->m_hangup = true;
+    if (Events & POLL_WRITE)
+        stream->m_writeBlocked = false;
+    if (!(Events & POLL_WRITE) || evbuffer_get_length(stream->m_output) == 0 || stream->flush())
+    {
+        if (stream->m_readable && stream->m_readEnabled)
+            stream->readSocket();
+    }
+}
+
+void SocketStream::onDeferred(int Fd, uint32_t Events, void* Arg)
+{
+    auto* stream = static_cast<SocketStream*>(Arg);
+    stream->m_deferred = false;
+    CallbackScope scope(*stream);
+    if (stream->m_uring != nullptr)
+    {
+        stream->completeRound();
+        return;
+    }
+    if (!stream->m_readable || !stream->m_readEnabled || stream->readSocket())
+    {
+        if (!stream->m_writeBlocked && evbuffer_get_length(stream->m_output) > 0)
+            stream->flush();
+    }
+}
+
+bool SocketStream::readSocket()
+{
+    bool* alive = m_alive;
+    while (m_readEnabled)
+    {
+        struct evbuffer_iovec vec[2];
+        struct iovec iov[2];
+        const int count = evbuffer_reserve_space(m_input, READ_CHUNK, vec, 2);
+        size_t reserved = 0;
+        for (int i = 0; i < count; i++)
+        {
+            iov[i].iov_base = vec[i].iov_base;
+            iov[i].iov_len = vec[i].iov_len;
+            reserved += vec[i].iov_len;
+        }
+        const ssize_t got = readv(m_fd, iov, count);
+        if (got < 0 && errno == EINTR)
+            continue;
+        if (got < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            m_readable = false;
+            break;
+        }
+        if (got <= 0)
+        {
+            fail();
+            return false;
+        }
+        size_t left = static_cast<size_t>(got);
+        int used = 0;
+        for (; used < count && left > 0; used++)
+        {
+            vec[used].iov_len = std::min(vec[used].iov_len, left);
+            left -= vec[used].iov_len;
+        }
+        evbuffer_commit_space(m_input, vec, used);
+        /* 没有读满说明内核缓冲区已空，省掉一次必然返回 EAGAIN 的 readv；之后到达的数据会带来新的边沿。
+         * 已经收到挂断时 FIN 不会再带来边沿，要一直读到 EOF */
+        if (static_cast<size_t>(got) < reserved && !m_hangup)
+            m_readable = false;
+        if (m_onRead != nullptr)
+        {
+            m_onRead(*this, m_arg);
+            if (!*alive)
+                return false;
+        }
+        if (!m_readable)
+            break;
+    }
+    return true;
+}
+
+bool SocketStream::flush()
+{
+    bool* alive = m_alive;
+    bool wrote = false;
+    while (evbuffer_get_length(m_output) > 0)
+    {
+        const int written = evbuffer_write_atmost(m_output, m_fd, -1);
+        if (written < 0 && errno == EINTR)
+            continue;
+        if (written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            m_writeBlocked = true;
+            break;
+        }
+        if (written < 0)
+        {
+            fail();
+            return false;
+        }
+        wrote = true;
+    }
+    if (wrote && m_onWrite != nullptr && evbuffer_get_length(m_output) <= m_writeLowWater)
+    {
+        m_onWrite(*this, m_arg);
+        if (!*alive)
+            return false;
+    }
+    return true;
+}
+
+void SocketStream::completeRound()
+{
+    bool* alive = m_alive;
+    if (m_pendingRead && m_readEnabled)
+    {
+        m_pendingRead = false;
+        if (evbuffer_get_length(m_input) > 0 && m_onRead != nullptr)
+        {
+            m_onRead(*this, m_arg);
+            if (!*alive)
+                return;
+        }
+        if (m_eofPending && m_readEnabled)
+        {
+            fail();
+            return;
+        }
+    }
+    if (m_sendOp == nullptr && evbuffer_get_length(m_output) > 0)
+        m_sendOp = m_uring->send(m_fd, m_output, onSent, this);
+}
+
+void SocketStream::onReceived(int Result, const char* Data, void* Arg)
+{
+    auto* stream = static_cast<SocketStream*>(Arg);
+    CallbackScope scope(*stream);
+    if (Result > 0)
+    {
+        evbuffer_add(stream->m_input, Data, static_cast<size_t>(Result));
+        if (stream->m_readEnabled && stream->m_onRead != nullptr)
+            stream->m_onRead(*stream, stream->m_arg);
+        return;
+    }
+    stream->m_recvOp = nullptr;
+    if (Result == -ECANCELED)
+    {
+        stream->m_recvCancelling = false;
+        if (stream->m_readEnabled)
+            stream->startRecv();
+        return;
+    }
+    /* 与就绪式后端一致，暂停读取期间不报告 EOF，输出照常写完 */
+    if (Result == 0 && !stream->m_readEnabled)
+    {
+        stream->m_eofPending = true;
+        return;
+    }
+    stream->fail();
+}
+
+void SocketStream::onSent(int Result, const char* Data, void* Arg)
+{
+    auto* stream = static_cast<SocketStream*>(Arg);
+    stream->m_sendOp = nullptr;
+    CallbackScope scope(*stream);
+    bool* alive = stream->m_alive;
+    if (Result < 0)
+    {
+        stream->fail();
+        return;
+    }
+    if (stream->m_onWrite != nullptr && evbuffer_get_length(stream->m_output) <= stream->m_writeLowWater)
+    {
+        stream->m_onWrite(*stream, stream->m_arg);
+        if (!*alive)
+            return;
+    }
+    /* 发送在途期间追加的输出 */
+    if (stream->m_sendOp == nullptr && evbuffer_get_length(stream->m_output) > 0)
+        stream->m_sendOp = stream->m_uring->send(stream->m_fd, stream->m_output, onSent, stream);
+}
+
+void SocketStream::fail()
+{
+    /* 没有关闭回调时停止读取，等待调用方 detach */
+    m_readEnabled = false;
+    m_readable = false;
+    if (m_onClose != nullptr)
+        m_onClose(*this, m_arg);
+}
+}   // namespace ToolKit
@@ -0,0 +1,154 @@
+#pragma once
+
+#include "Poller.h"
+
+#include <cstddef>
+#include <cstdint>
+
+struct evbuffer;
+struct evbuffer_cb_entry;
+struct evbuffer_cb_info;
+
+namespace ToolKit
+{
+class UringPoller;
+
+/**
+ * @brief 原生后端上一个已连接套接字的缓冲读写，替代 bufferevent
+ * 套接字以 POLL_READ | POLL_WRITE | POLL_EDGE 向 Poller 注册一次，之后暂停读取、等待可写都只改本地标志。
+ * 可读时以 readv 直接读进输入 evbuffer 预留的内存块，读满预留空间才继续读，否则认为内核缓冲区已读空；
+ * 输出 evbuffer 新增数据时登记一次延后写出，本轮事件分发完之后以 evbuffer_write_atmost（writev，文件段走 sendfile）
+ * 一次写出本轮累积的全部响应，写到 EAGAIN 时等待下一次可写边沿。
+ * URING 后端改为完成式：多次触发的 recv 把内核填好的环缓冲区复制进输入 evbuffer；本轮结束时把输出整体移交给
+ * 一个 sendmsg 操作，同一时刻每个连接只有一个发送在途，在途期间新增的输出等它完成后再发；暂停读取时撤销 recv，恢复时重新提交。
+ * 回调语义与 bufferevent 相同：读回调在输入新增数据后调用；写回调在一次写出之后输出降到低水位以下时调用；
+ * 关闭回调在读到 EOF 或读写出错时调用。回调中可以 detach 甚至销毁对象。
+ * 只能在所属 Poller 的事件循环线程上使用。
+ */
+class SocketStream
+{
+public:
+    using Callback = void (*)(SocketStream& Stream, void* Arg);
+
+    /* 每次 readv 预留的输入空间 */
+    static constexpr size_t READ_CHUNK = 16384;
+
+    SocketStream() = default;
+    ~SocketStream();
+    SocketStream(const SocketStream&) = delete;
+    const SocketStream& operator=(const SocketStream&) = delete;
+
+    void setCallbacks(Callback OnRead, Callback OnWrite, Callback OnClose, void* Arg);
+
+    void setWriteLowWater(size_t Bytes) { m_writeLowWater = Bytes; }
+
+    /**
+     * @brief 接管非阻塞的已连接套接字并开始读取，失败时不关闭 Fd
+     */
+    bool attach(Poller& Owner, int Fd);
+
+    /**
+     * @brief 注销并关闭套接字、清空缓冲区，对象保留给下一个套接字复用
+     */
+    void detach();
+
+    void enableRead();
+    void disableRead();
+
+    /**
+     * @brief 输出缓冲区或在途的发送中还有数据；URING 后端发送期间输出缓冲区可能已空
+     */
+    bool writePending() const;
+
+    struct evbuffer* input() const { return m_input; }
+    struct evbuffer* output() const { return m_output; }
+    int fd() const { return m_fd; }
+
+private:
+    /**
+     * @brief 一次事件回调的作用域，期间 m_alive 指向它的标志；对象在回调中被 detach 或销毁时不再回写对象
+     * 析构时只在对象仍然存活时清空 m_alive，GCC 无法看出这一点而误报悬空指针。
+     */
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdangling-pointer"
+#endif
+    class CallbackScope
+    {
+    public:
+        explicit CallbackScope(SocketStream& Stream)
+                : m_stream(Stream)
+        {
+            m_stream.m_alive = &m_alive;
+        }
+        ~CallbackScope()
+        {
+            if (m_alive)
+                m_stream.m_alive = nullptr;
+        }
+        CallbackScope(const CallbackScope&) = delete;
+        const CallbackScope& operator=(const CallbackScope&) = delete;
+
+    private:
+        SocketStream& m_stream;
+        bool m_alive { true };
+    };
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+    static void onEvents(int Fd, uint32_t Events, void* Arg);
+    static void onDeferred(int Fd, uint32_t Events, void* Arg);
+    static void onOutput(struct evbuffer* Buffer, const struct evbuffer_cb_info* Info, void* Arg);
+    static void onReceived(int Result, const char* Data, void* Arg);
+    static void onSent(int Result, const char* Data, void* Arg);
+
+    void schedule();
+    /**
+     * @brief 读到 EAGAIN、暂停读取或出错为止，出错或对象在回调中被 detach 时返回 false
+     */
+    bool readSocket();
+    /**
+     * @brief 写到输出为空或 EAGAIN，出错或对象在回调中被 detach 时返回 false
+     */
+    bool flush();
+    void fail();
+    void startRecv();
+    /**
+     * @brief URING 后端本轮结束时的处理：补发暂停期间收到的数据与 EOF，提交发送
+     */
+    void completeRound();
+
+    Poller* m_poller { nullptr };
+    PollWatch m_watch;
+    int m_fd { -1 };
+    struct evbuffer* m_input { nullptr };
+    struct evbuffer* m_output { nullptr };
+    struct evbuffer_cb_entry* m_outputCb { nullptr };
+    Callback m_onRead { nullptr };
+    Callback m_onWrite { nullptr };
+    Callback m_onClose { nullptr };
+    void* m_arg { nullptr };
+    size_t m_writeLowWater { 0 };
+    /* 回调期间指向栈上的标志，detach 把它置为 false，让调用者知道对象已不可再访问 */
+    bool* m_alive { nullptr };
+    bool m_readEnabled { false };
+    /* 收到可读边沿之后尚未读到 EAGAIN */
+    bool m_readable { false };
+    /* 对端已关闭写方向或套接字出错 */
+    bool m_hangup { false };
+    /* 写出遇到 EAGAIN，等待可写边沿 */
+    bool m_writeBlocked { false };
+    bool m_deferred { false };
+
+    /* URING 后端，其他后端为空 */
+    UringPoller* m_uring { nullptr };
+    UringOp* m_recvOp { nullptr };
+    UringOp* m_sendOp { nullptr };
+    /* 暂停读取时已请求撤销 recv，等待它以 -ECANCELED 结束 */
+    bool m_recvCancelling { false };
+    /* 暂停期间收到的数据与 EOF 留到恢复读取后交给回调 */
+    bool m_pendingRead { false };
+    bool m_eofPending { false };
+};
+}   // namespace ToolKit
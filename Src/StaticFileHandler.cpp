@@ -0,0 +1,287 @@
+#include "StaticFileHandler.h"
+
+#include "spdlog/spdlog.h"
+
+#include <cerrno>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <strings.h>
+
+namespace
+{
+ToolKit::ProductClassRegistrar<ToolKit::HttpContentHandler, ToolKit::StaticFileHandler, const nlohmann::json&> registrar(
+    ToolKit::StaticFileHandler::TYPE);
+
+struct MimeType
+{
+    std::string_view m_extension;
+    std::string_view m_type;
+};
+
+constexpr MimeType MIME_TYPES[] = {
+    { "html", "text/html; charset=utf-8" },
+    { "htm", "text/html; charset=utf-8" },
+    { "css", "text/css; charset=utf-8" },
+    { "js", "text/javascript; charset=utf-8" },
+    { "mjs", "text/javascript; charset=utf-8" },
+    { "json", "application/json" },
+    { "txt", "text/plain; charset=utf-8" },
+    { "xml", "application/xml" },
+    { "svg", "image/svg+xml" },
+    { "png", "image/png" },
+    { "jpg", "image/jpeg" },
+    { "jpeg", "image/jpeg" },
+    { "gif", "image/gif" },
+    { "webp", "image/webp" },
+    { "ico", "image/x-icon" },
+    { "woff", "font/woff" },
+    { "woff2", "font/woff2" },
+    { "wasm", "application/wasm" },
+    { "pdf", "application/pdf" },
+    { "zip", "application/zip" },
+    { "gz", "application/gzip" },
+    { "mp4", "video/mp4" },
+    { "webm", "video/webm" },
+    { "mp3", "audio/mpeg" },
+};
+
+bool equalsIgnoreCase(std::string_view Left, std::string_view Right)
+{
+    return Left.size() == Right.size() && strncasecmp(Left.data(), Right.data(), Left.size()) == 0;
+}
+
+std::string_view trim(std::string_view Text)
+{
+    while (!Text.empty() && (Text.front() == ' ' || Text.front() == '\t'))
+        Text.remove_prefix(1);
+    while (!Text.empty() && (Text.back() == ' ' || Text.back() == '\t'))
+        Text.remove_suffix(1);
+    return Text;
+}
+
+int hexValue(char C)
+{
+    if (C >= '0' && C <= '9')
+        return C - '0';
+    if (C >= 'a' && C <= 'f')
+        return C - 'a' + 10;
+    if (C >= 'A' && C <= 'F')
+        return C - 'A' + 10;
+    return -1;
+}
+
+bool parseOffset(std::string_view Text, off_t& Value)
+{
+    unsigned long long parsed = 0;
+    auto [end, ec] = std::from_chars(Text.data(), Text.data() + Text.size(), parsed);
+    if (ec != std::errc() || end != Text.data() + Text.size() || Text.empty())
+        return false;
+    /* 超出 off_t 的值按最大值处理，对应的区间必然越界或被截断到文件末尾 */
+    Value = parsed > static_cast<unsigned long long>(INT64_MAX) ? INT64_MAX : static_cast<off_t>(parsed);
+    return true;
+}
+}   // namespace
+
+namespace ToolKit
+{
+std::string_view mimeTypeOf(std::string_view Path)
+{
+    auto dot = Path.rfind('.');
+    auto slash = Path.rfind('/');
+    if (dot != std::string_view::npos && (slash == std::string_view::npos || dot > slash))
+    {
+        auto extension = Path.substr(dot + 1);
+        for (const auto& mime : MIME_TYPES)
+        {
+            if (equalsIgnoreCase(extension, mime.m_extension))
+                return mime.m_type;
+        }
+    }
+    return "application/octet-stream";
+}
+
+RANGE_STATUS parseByteRange(std::string_view Header, off_t Size, off_t& Offset, off_t& Length)
+{
+    Header = trim(Header);
+    if (Header.size() < 6 || !equalsIgnoreCase(Header.substr(0, 6), "bytes="))
+        return RANGE_STATUS::NONE;
+    auto spec = trim(Header.substr(6));
+    /* 多区间需要 multipart/byteranges，按规范可以忽略 Range 直接回复完整内容 */
+    auto dash = spec.find('-');
+    if (dash == std::string_view::npos || spec.find(',') != std::string_view::npos)
+        return RANGE_STATUS::NONE;
+    auto first = trim(spec.substr(0, dash));
+    auto last = trim(spec.substr(dash + 1));
+
+    off_t begin = 0;
+    off_t end = 0;
+    if (first.empty())
+    {
+        /* 后缀区间 -N 表示最后 N 个字节 */
+        off_t suffix = 0;
+        if (!parseOffset(last, suffix))
+            return RANGE_STATUS::NONE;
+        if (suffix == 0 || Size == 0)
+            return RANGE_STATUS::UNSATISFIABLE;
+        begin = suffix >= Size ? 0 : Size - suffix;
+        end = Size - 1;
+    }
+    else
+    {
+        if (!parseOffset(first, begin))
+            return RANGE_STATUS::NONE;
+        if (last.empty())
+            end = Size - 1;
+        else if (!parseOffset(last, end) || end < begin)
+            return RANGE_STATUS::NONE;
+        if (begin >= Size)
+            return RANGE_STATUS::UNSATISFIABLE;
+        if (end >= Size)
+            end = Size - 1;
+    }
+    Offset = begin;
+    Length = end - begin + 1;
+    return RANGE_STATUS::SATISFIABLE;
+}
+
+StaticFileHandler::StaticFileHandler(const nlohmann::json& Config)
+        : m_prefix(Config.value("Prefix", std::string("/")))
+        , m_root(Config.value("Root", std::string(".")))
+        , m_index(Config.value("Index", std::string("index.html")))
+        , m_cache(Config.value("CacheEntries", size_t(1024)), Config.value("CacheShards", size_t(16)))
+{
+    while (m_root.size() > 1 && m_root.back() == '/')
+        m_root.pop_back();
+    spdlog::info("{} serve [{}] from [{}], file cache {}", __FUNCTION__, m_prefix, m_root, m_cache.enabled() ? "on" : "off");
+}
+
+bool StaticFileHandler::resolvePath(std::string_view Path, std::string& File) const
+{
+    if (Path.substr(0, m_prefix.size()) != m_prefix)
+        return false;
+    auto relative = Path.substr(m_prefix.size());
+    File = m_root;
+    if (File.back() != '/')
+        File.push_back('/');
+    size_t segment = File.size();
+    /* 逐字节解码，在每个 / 处检查刚结束的路径段，编码后的 %2e%2e 与 %2f 同样受检查；
+     * 空段与 . 段直接去掉，同一文件只有一种写法，文件缓存的键与 inotify 事件还原出的路径一致 */
+    auto checkSegment = [&File, &segment]
+    {
+        size_t length = File.size() - segment;
+        if (length == 1 && File[segment] == '.')
+            File.pop_back();
+        return !(length == 2 && File.compare(segment, 2, "..") == 0);
+    };
+    for (size_t i = 0; i < relative.size(); i++)
+    {
+        char c = relative[i];
+        if (c == '%')
+        {
+            int high = i + 2 < relative.size() ? hexValue(relative[i + 1]) : -1;
+            int low = high >= 0 ? hexValue(relative[i + 2]) : -1;
+            if (low < 0)
+                return false;
+            c = static_cast<char>(high * 16 + low);
+            i += 2;
+        }
+        if (c == '\0')
+            return false;
+        if (c != '/')
+        {
+            File.push_back(c);
+            continue;
+        }
+        if (!checkSegment())
+            return false;
+        if (File.size() != segment)
+        {
+            File.push_back('/');
+            segment = File.size();
+        }
+    }
+    if (!checkSegment())
+        return false;
+    if (File.back() == '/')
+        File += m_index;
+    return true;
+}
+
+std::string StaticFileHandler::stats() const
+{
+    auto stats = m_cache.stats();
+    return fmt::format("file cache hits[{}] misses[{}] invalidations[{}] evictions[{}] entries[{}]", stats.m_hits,
+        stats.m_misses, stats.m_invalidations, stats.m_evictions, stats.m_entries);
+}
+
+void StaticFileHandler::handle(const HttpRequest& Request, HttpResponse& Response)
+{
+    if (Request.m_method != "GET" && Request.m_method != "HEAD")
+    {
+        Response.setStatus(405);
+        Response.addHeader("Allow", "GET, HEAD");
+        return;
+    }
+    std::string path;
+    if (!resolvePath(Request.m_path, path))
+    {
+        Response.setStatus(404);
+        return;
+    }
+    int error = 0;
+    auto file = m_cache.open(path, error);
+    if (!file)
+    {
+        Response.setStatus(error == EACCES ? 403 : 404);
+        return;
+    }
+
+    Response.addHeader("Last-Modified", file->m_lastModified);
+    Response.addHeader("ETag", file->m_etag);
+    Response.addHeader("Accept-Ranges", "bytes");
+
+    /* If-None-Match 存在时忽略 If-Modified-Since */
+    auto ifNoneMatch = Request.header("If-None-Match");
+    time_t since = 0;
+    bool notModified = !ifNoneMatch.empty()
+        ? etagMatches(ifNoneMatch, file->m_etag)
+        : parseHttpDate(Request.header("If-Modified-Since"), since) && file->m_mtime <= since;
+    if (notModified)
+    {
+        Response.setStatus(304);
+        return;
+    }
+    Response.addHeader("Content-Type", file->m_mimeType);
+
+    off_t offset = 0;
+    off_t length = file->m_size;
+    auto range = Request.header("Range");
+    auto ifRange = Request.header("If-Range");
+    time_t rangeDate = 0;
+    /* If-Range 与当前版本不一致时说明客户端缓存的片段已过期，回复完整内容 */
+    bool rangeValid = ifRange.empty() || trim(ifRange) == file->m_etag
+        || (parseHttpDate(ifRange, rangeDate) && rangeDate == file->m_mtime);
+    if (!range.empty() && rangeValid)
+    {
+        char contentRange[80];
+        switch (parseByteRange(range, file->m_size, offset, length))
+        {
+            case RANGE_STATUS::NONE:
+                break;
+            case RANGE_STATUS::SATISFIABLE:
+                Response.setStatus(206);
+                snprintf(contentRange, sizeof(contentRange), "bytes %lld-%lld/%lld", static_cast<long long>(offset),
+                    static_cast<long long>(offset + length - 1), static_cast<long long>(file->m_size));
+                Response.addHeader("Content-Range", contentRange);
+                break;
+            case RANGE_STATUS::UNSATISFIABLE:
+                Response.setStatus(416);
+                snprintf(contentRange, sizeof(contentRange), "bytes */%lld", static_cast<long long>(file->m_size));
+                Response.addHeader("Content-Range", contentRange);
+                return;
+        }
+    }
+    Response.setFile(file->m_segment, offset, length);
+}
+}   // namespace ToolKit
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "FileCache.h"
+#include "HttpContentHandler.h"
+
+#include <ctime>
+#include <string>
+#include <string_view>
+#include <sys/types.h>
+
+namespace ToolKit
+{
+/**
+ * @brief 按扩展名（大小写不敏感）查找 Content-Type，未知类型返回 application/octet-stream
+ */
+std::string_view mimeTypeOf(std::string_view Path);
+
+enum class RANGE_STATUS
+{
+    /* 没有 Range 或无法识别（含多区间请求），按完整内容回复 200 */
+    NONE,
+    SATISFIABLE,
+    UNSATISFIABLE
+};
+
+/**
+ * @brief 解析 Range 首部中的单个字节区间，Offset/Length 只在返回 SATISFIABLE 时有效
+ */
+RANGE_STATUS parseByteRange(std::string_view Header, off_t Size, off_t& Offset, off_t& Length);
+
+/**
+ * @brief 把挂载前缀下的请求映射到根目录中的文件并以零拷贝方式发送
+ * 配置项：Prefix 挂载前缀，Root 根目录，Index 请求以 / 结尾时使用的文件名（默认 index.html），
+ * CacheEntries 打开文件缓存的容量（默认 1024，0 表示不缓存），CacheShards 缓存分片数（默认 16）。
+ * 文件经 FileCache 打开，内容以 evbuffer_file_segment 交给响应，在套接字上由 sendfile 发送；支持 GET 与 HEAD、
+ * 单区间 Range（含 If-Range）、If-None-Match 与 If-Modified-Since 条件请求。
+ * 解码后含有 .. 段或 NUL 的路径一律回复 404，不会访问根目录之外的文件。
+ * open/fstat 可能阻塞在慢速磁盘上，这类部署可以在配置中把条目标记为 Blocking。
+ */
+class StaticFileHandler : public HttpContentHandler
+{
+public:
+    static constexpr const char* TYPE = "StaticFile";
+
+    explicit StaticFileHandler(const nlohmann::json& Config);
+
+    void handle(const HttpRequest& Request, HttpResponse& Response) override;
+
+    std::string stats() const override;
+
+private:
+    /**
+     * @brief 百分号解码请求路径并拼接出文件路径，路径不合法时返回 false
+     */
+    bool resolvePath(std::string_view Path, std::string& File) const;
+
+    std::string m_prefix;
+    std::string m_root;
+    std::string m_index;
+    FileCache m_cache;
+};
+}   // namespace ToolKit
@@ -0,0 +1,577 @@
+#include "UringPoller.h"
+
+#include "spdlog/spdlog.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <event2/buffer.h>
+#include <linux/io_uring.h>
+#include <linux/time_types.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <sys/utsname.h>
+#include <unistd.h>
+
+namespace ToolKit
+{
+enum class URING_OP
+{
+    POLL,
+    ACCEPT,
+    RECV,
+    SEND
+};
+
+/**
+ * @brief 一个提交给内核的操作，user_data 由下标与代数组成，回收后代数加一，迟到的完成事件与撤销请求都不会误伤新操作
+ */
+struct UringOp
+{
+    ~UringOp()
+    {
+        if (m_data != nullptr)
+            evbuffer_free(m_data);
+    }
+
+    URING_OP m_kind { URING_OP::POLL };
+    int m_fd { -1 };
+    uint64_t m_userData { 0 };
+    CompletionCallback m_callback { nullptr };
+    void* m_arg { nullptr };
+    /* POLL：就绪回调所在的 PollWatch 与 poll 事件 */
+    PollWatch* m_watch { nullptr };
+    uint32_t m_events { 0 };
+    /* 已提交且内核尚未交回最后一个完成事件 */
+    bool m_inflight { false };
+    bool m_released { false };
+    bool m_cancelRequested { false };
+    /* SEND：操作自有的待发送数据，发送期间只有内核读取它 */
+    struct evbuffer* m_data { nullptr };
+    size_t m_sent { 0 };
+    struct msghdr m_msg {};
+    struct iovec m_iov[UringPoller::SEND_IOVECS] {};
+};
+
+namespace
+{
+constexpr uint16_t BUFFER_GROUP = 0;
+
+int ioUringSetup(unsigned Entries, struct io_uring_params* Params)
+{
+    return static_cast<int>(syscall(__NR_io_uring_setup, Entries, Params));
+}
+
+int ioUringEnter(int Fd, unsigned ToSubmit, unsigned MinComplete, unsigned Flags, const void* Arg, size_t ArgSize)
+{
+    return static_cast<int>(syscall(__NR_io_uring_enter, Fd, ToSubmit, MinComplete, Flags, Arg, ArgSize));
+}
+
+int ioUringRegister(int Fd, unsigned Opcode, const void* Arg, unsigned Count)
+{
+    return static_cast<int>(syscall(__NR_io_uring_register, Fd, Opcode, Arg, Count));
+}
+
+/* 多次触发的 recv 从 6.0 开始支持，探测接口无法区分，只能看内核版本 */
+bool kernelAtLeast(int Major, int Minor)
+{
+    struct utsname name;
+    int major = 0;
+    int minor = 0;
+    if (uname(&name) != 0 || sscanf(name.release, "%d.%d", &major, &minor) != 2)
+        return false;
+    return major > Major || (major == Major && minor >= Minor);
+}
+
+bool opsSupported(int RingFd)
+{
+    constexpr unsigned PROBE_OPS = 256;
+    std::vector<char> memory(sizeof(struct io_uring_probe) + PROBE_OPS * sizeof(struct io_uring_probe_op), 0);
+    auto* probe = reinterpret_cast<struct io_uring_probe*>(memory.data());
+    if (ioUringRegister(RingFd, IORING_REGISTER_PROBE, probe, PROBE_OPS) != 0)
+        return false;
+    for (unsigned op : { IORING_OP_POLL_ADD, IORING_OP_ACCEPT, IORING_OP_RECV, IORING_OP_SENDMSG, IORING_OP_ASYNC_CANCEL })
+    {
+        if (op > probe->last_op || !(probe->ops[op].flags & IO_URING_OP_SUPPORTED))
+            return false;
+    }
+    return true;
+}
+}   // namespace
+
+UringPoller::UringPoller()
+{
+    if (!setup())
+        teardown();
+}
+
+UringPoller::~UringPoller()
+{
+    teardown();
+}
+
+void UringPoller::teardown()
+{
+    /* 关闭 ring 时内核撤销全部未完成的操作 */
+    if (m_ringFd >= 0)
+        close(m_ringFd);
+    if (m_sqes != nullptr)
+        munmap(m_sqes, m_sqesSize);
+    if (m_sqRing != nullptr)
+        munmap(m_sqRing, m_sqRingSize);
+    if (m_bufRing != nullptr)
+        munmap(m_bufRing, m_bufRingSize);
+    if (m_bufMemory != nullptr)
+        munmap(m_bufMemory, RECV_BUFFERS * RECV_BUFFER_SIZE);
+    m_ringFd = -1;
+    m_sqes = nullptr;
+    m_sqRing = nullptr;
+    m_bufRing = nullptr;
+    m_bufMemory = nullptr;
+}
+
+bool UringPoller::setup()
+{
+    if (!kernelAtLeast(6, 0))
+    {
+        spdlog::info("{} kernel older than 6.0, no multishot recv", __FUNCTION__);
+        return false;
+    }
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_COOP_TASKRUN;
+    /* 多次触发的操作一次提交产生多个完成事件，完成队列放大 */
+    params.cq_entries = RING_ENTRIES * 4;
+    m_ringFd = ioUringSetup(RING_ENTRIES, &params);
+    if (m_ringFd < 0)
+    {
+        spdlog::info("{} io_uring_setup failed, error[{}]", __FUNCTION__, strerror(errno));
+        return false;
+    }
+    /* 完成队列满时不丢事件、等待可带超时、两个队列单次映射 */
+    const uint32_t required = IORING_FEAT_NODROP | IORING_FEAT_EXT_ARG | IORING_FEAT_SUBMIT_STABLE | IORING_FEAT_SINGLE_MMAP;
+    if ((params.features & required) != required || !opsSupported(m_ringFd))
+    {
+        spdlog::info("{} io_uring features[{:#x}] missing required support", __FUNCTION__, params.features);
+        return false;
+    }
+
+    m_sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    /* IORING_FEAT_SINGLE_MMAP：提交队列与完成队列共用一次映射 */
+    m_sqRingSize = std::max(m_sqRingSize, params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe));
+    void* ring = mmap(nullptr, m_sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ringFd, IORING_OFF_SQ_RING);
+    if (ring == MAP_FAILED)
+        return false;
+    m_sqRing = ring;
+    m_sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+    void* sqes = mmap(nullptr, m_sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ringFd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED)
+        return false;
+    m_sqes = static_cast<struct io_uring_sqe*>(sqes);
+
+    auto* base = static_cast<char*>(ring);
+    m_sqHead = reinterpret_cast<unsigned*>(base + params.sq_off.head);
+    m_sqTail = reinterpret_cast<unsigned*>(base + params.sq_off.tail);
+    m_sqFlags = reinterpret_cast<unsigned*>(base + params.sq_off.flags);
+    m_sqArray = reinterpret_cast<unsigned*>(base + params.sq_off.array);
+    m_sqMask = *reinterpret_cast<unsigned*>(base + params.sq_off.ring_mask);
+    m_sqEntries = params.sq_entries;
+    m_cqHead = reinterpret_cast<unsigned*>(base + params.cq_off.head);
+    m_cqTail = reinterpret_cast<unsigned*>(base + params.cq_off.tail);
+    m_cqMask = *reinterpret_cast<unsigned*>(base + params.cq_off.ring_mask);
+    m_cqes = reinterpret_cast<struct io_uring_cqe*>(base + params.cq_off.cqes);
+    /* 提交项与下标一一对应，之后只需推进队尾 */
+    for (unsigned i = 0; i < m_sqEntries; i++)
+        m_sqArray[i] = i;
+    m_localTail = *m_sqTail;
+    return setupBufferRing();
+}
+
+bool UringPoller::setupBufferRing()
+{
+    m_bufRingSize = RECV_BUFFERS * sizeof(struct io_uring_buf);
+    void* ring = mmap(nullptr, m_bufRingSize, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+    if (ring == MAP_FAILED)
+        return false;
+    m_bufRing = static_cast<struct io_uring_buf_ring*>(ring);
+    void* memory = mmap(nullptr, RECV_BUFFERS * RECV_BUFFER_SIZE, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+    if (memory == MAP_FAILED)
+        return false;
+    m_bufMemory = static_cast<char*>(memory);
+
+    struct io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = reinterpret_cast<uint64_t>(m_bufRing);
+    reg.ring_entries = RECV_BUFFERS;
+    reg.bgid = BUFFER_GROUP;
+    if (ioUringRegister(m_ringFd, IORING_REGISTER_PBUF_RING, &reg, 1) != 0)
+    {
+        spdlog::info("{} register buffer ring failed, error[{}]", __FUNCTION__, strerror(errno));
+        return false;
+    }
+    for (uint16_t bid = 0; bid < RECV_BUFFERS; bid++)
+        recycleBuffer(bid);
+    __atomic_store_n(&m_bufRing->tail, m_bufTail, __ATOMIC_RELEASE);
+    return true;
+}
+
+void UringPoller::recycleBuffer(uint16_t Bid)
+{
+    /* 环的队尾与第一个元素的保留字段重叠，只写各个字段，不整体赋值；
+       头文件中 bufs 之前的空结构体在 C++ 中占一个字节，不能用 bufs 成员取元素 */
+    auto& buf = reinterpret_cast<struct io_uring_buf*>(m_bufRing)[m_bufTail & (RECV_BUFFERS - 1)];
+    buf.addr = reinterpret_cast<uint64_t>(m_bufMemory + Bid * RECV_BUFFER_SIZE);
+    buf.len = RECV_BUFFER_SIZE;
+    buf.bid = Bid;
+    m_bufTail++;
+}
+
+struct io_uring_sqe* UringPoller::getSqe()
+{
+    if (m_localTail - __atomic_load_n(m_sqHead, __ATOMIC_ACQUIRE) >= m_sqEntries)
+    {
+        /* 提交队列已满，先把已准备的提交给内核 */
+        enter(0);
+        if (m_localTail - __atomic_load_n(m_sqHead, __ATOMIC_ACQUIRE) >= m_sqEntries)
+            return nullptr;
+    }
+    auto* sqe = &m_sqes[m_localTail & m_sqMask];
+    memset(sqe, 0, sizeof(*sqe));
+    m_localTail++;
+    return sqe;
+}
+
+bool UringPoller::enter(int WaitMs)
+{
+    __atomic_store_n(m_sqTail, m_localTail, __ATOMIC_RELEASE);
+    unsigned toSubmit = m_localTail - __atomic_load_n(m_sqHead, __ATOMIC_ACQUIRE);
+    unsigned flags = 0;
+    unsigned minComplete = 0;
+    struct __kernel_timespec timeout { 0, 0 };
+    struct io_uring_getevents_arg arg;
+    memset(&arg, 0, sizeof(arg));
+    arg.sigmask_sz = _NSIG / 8;
+    if (WaitMs != 0)
+    {
+        flags |= IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG;
+        minComplete = 1;
+        if (WaitMs > 0)
+        {
+            timeout.tv_sec = WaitMs / 1000;
+            timeout.tv_nsec = (WaitMs % 1000) * 1000000LL;
+            arg.ts = reinterpret_cast<uint64_t>(&timeout);
+        }
+    }
+    /* 内核暂存了溢出的完成事件，需要 GETEVENTS 才会搬回完成队列 */
+    if (__atomic_load_n(m_sqFlags, __ATOMIC_RELAXED) & IORING_SQ_CQ_OVERFLOW)
+        flags |= IORING_ENTER_GETEVENTS;
+    if (toSubmit == 0 && flags == 0)
+        return true;
+    int ret = ioUringEnter(m_ringFd, toSubmit, minComplete, flags, (flags & IORING_ENTER_EXT_ARG) ? &arg : nullptr,
+        (flags & IORING_ENTER_EXT_ARG) ? sizeof(arg) : 0);
+    if (ret < 0 && errno != ETIME && errno != EINTR && errno != EBUSY && errno != EAGAIN)
+    {
+        spdlog::warn("{} io_uring_enter failed, error[{}]", __FUNCTION__, strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+UringOp* UringPoller::newOp(int Fd, CompletionCallback Callback, void* Arg)
+{
+    UringOp* op;
+    if (!m_freeOps.empty())
+    {
+        op = m_freeOps.back();
+        m_freeOps.pop_back();
+    }
+    else
+    {
+        m_ops.push_back(std::make_unique<UringOp>());
+        op = m_ops.back().get();
+        op->m_userData = m_ops.size();
+    }
+    op->m_fd = Fd;
+    op->m_callback = Callback;
+    op->m_arg = Arg;
+    return op;
+}
+
+void UringPoller::recycle(UringOp* Op)
+{
+    /* 代数在高 32 位，下标不变 */
+    Op->m_userData += uint64_t(1) << 32;
+    Op->m_fd = -1;
+    Op->m_callback = nullptr;
+    Op->m_arg = nullptr;
+    Op->m_watch = nullptr;
+    Op->m_inflight = Op->m_released = Op->m_cancelRequested = false;
+    if (Op->m_data != nullptr)
+        evbuffer_drain(Op->m_data, evbuffer_get_length(Op->m_data));
+    Op->m_sent = 0;
+    m_freeOps.push_back(Op);
+}
+
+void UringPoller::arm(UringOp* Op)
+{
+    auto* sqe = getSqe();
+    if (sqe == nullptr)
+    {
+        spdlog::warn("{} submission queue full, drop op kind[{}]", __FUNCTION__, static_cast<int>(Op->m_kind));
+        return;
+    }
+    sqe->fd = Op->m_fd;
+    sqe->user_data = Op->m_userData;
+    switch (Op->m_kind)
+    {
+        case URING_OP::POLL:
+            sqe->opcode = IORING_OP_POLL_ADD;
+            sqe->poll32_events = Op->m_events;
+            sqe->len = IORING_POLL_ADD_MULTI;
+            break;
+        case URING_OP::ACCEPT:
+            sqe->opcode = IORING_OP_ACCEPT;
+            sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+            sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+            break;
+        case URING_OP::RECV:
+            sqe->opcode = IORING_OP_RECV;
+            sqe->ioprio = IORING_RECV_MULTISHOT;
+            sqe->flags = IOSQE_BUFFER_SELECT;
+            sqe->buf_group = BUFFER_GROUP;
+            break;
+        case URING_OP::SEND:
+        {
+            struct evbuffer_iovec vecs[SEND_IOVECS];
+            int count = evbuffer_peek(Op->m_data, -1, nullptr, vecs, SEND_IOVECS);
+            count = std::min(count, SEND_IOVECS);
+            for (int i = 0; i < count; i++)
+            {
+                Op->m_iov[i].iov_base = vecs[i].iov_base;
+                Op->m_iov[i].iov_len = vecs[i].iov_len;
+            }
+            memset(&Op->m_msg, 0, sizeof(Op->m_msg));
+            Op->m_msg.msg_iov = Op->m_iov;
+            Op->m_msg.msg_iovlen = static_cast<size_t>(count);
+            sqe->opcode = IORING_OP_SENDMSG;
+            sqe->addr = reinterpret_cast<uint64_t>(&Op->m_msg);
+            sqe->len = 1;
+            sqe->msg_flags = MSG_NOSIGNAL;
+            break;
+        }
+    }
+    Op->m_inflight = true;
+}
+
+bool UringPoller::add(PollWatch& Watch, int Fd, uint32_t Events, PollCallback Callback, void* Arg)
+{
+    if (!valid())
+        return false;
+    auto* op = newOp(Fd, nullptr, nullptr);
+    op->m_kind = URING_OP::POLL;
+    op->m_watch = &Watch;
+    op->m_events = 0;
+    if (Events & POLL_READ)
+        op->m_events |= POLLIN | POLLRDHUP;
+    if (Events & POLL_WRITE)
+        op->m_events |= POLLOUT;
+    Watch.m_fd = Fd;
+    Watch.m_callback = Callback;
+    Watch.m_arg = Arg;
+    Watch.m_op = op;
+    arm(op);
+    return true;
+}
+
+void UringPoller::remove(PollWatch& Watch)
+{
+    if (Watch.m_op != nullptr)
+        release(Watch.m_op);
+    Watch.m_op = nullptr;
+    Watch.m_fd = -1;
+}
+
+bool UringPoller::setTick(std::chrono::milliseconds Interval, PollCallback Callback, void* Arg)
+{
+    return armTick(Interval, Callback, Arg);
+}
+
+UringOp* UringPoller::accept(int ListenFd, CompletionCallback Callback, void* Arg)
+{
+    auto* op = newOp(ListenFd, Callback, Arg);
+    op->m_kind = URING_OP::ACCEPT;
+    arm(op);
+    return op;
+}
+
+UringOp* UringPoller::recv(int Fd, CompletionCallback Callback, void* Arg)
+{
+    auto* op = newOp(Fd, Callback, Arg);
+    op->m_kind = URING_OP::RECV;
+    arm(op);
+    return op;
+}
+
+UringOp* UringPoller::send(int Fd, struct evbuffer* Data, CompletionCallback Callback, void* Arg)
+{
+    auto* op = newOp(Fd, Callback, Arg);
+    op->m_kind = URING_OP::SEND;
+    if (op->m_data == nullptr)
+        op->m_data = evbuffer_new();
+    /* 整块移动链表节点，不复制数据 */
+    evbuffer_add_buffer(op->m_data, Data);
+    arm(op);
+    return op;
+}
+
+void UringPoller::cancel(UringOp* Op)
+{
+    if (Op->m_cancelRequested)
+        return;
+    Op->m_cancelRequested = true;
+    if (!Op->m_inflight)
+        return;
+    auto* sqe = getSqe();
+    if (sqe == nullptr)
+        return;
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->addr = Op->m_userData;
+    /* 撤销请求自身的完成事件不需要处理 */
+    sqe->user_data = 0;
+}
+
+void UringPoller::release(UringOp* Op)
+{
+    Op->m_released = true;
+    Op->m_callback = nullptr;
+    if (Op->m_inflight)
+        cancel(Op);
+    else if (Op != m_dispatching)
+        recycle(Op);
+}
+
+void UringPoller::dispatch(UringOp* Op, int Result, uint32_t Flags)
+{
+    if (!(Flags & IORING_CQE_F_MORE))
+        Op->m_inflight = false;
+    const char* data = nullptr;
+    if (Flags & IORING_CQE_F_BUFFER)
+        data = m_bufMemory + (Flags >> IORING_CQE_BUFFER_SHIFT) * RECV_BUFFER_SIZE;
+
+    /* 回调已收到操作的最终结果 */
+    bool terminal = false;
+    m_dispatching = Op;
+    if (!Op->m_released)
+    {
+        switch (Op->m_kind)
+        {
+            case URING_OP::POLL:
+                if (Result > 0)
+                {
+                    uint32_t ready = 0;
+                    if (Result & POLLIN)
+                        ready |= POLL_READ;
+                    if (Result & POLLOUT)
+                        ready |= POLL_WRITE;
+                    if (Result & (POLLRDHUP | POLLHUP | POLLERR))
+                        ready |= POLL_HANGUP | POLL_READ;
+                    Op->m_watch->m_callback(Op->m_fd, ready, Op->m_watch->m_arg);
+                }
+                break;
+            case URING_OP::ACCEPT:
+                if (Result != -ECANCELED)
+                    Op->m_callback(Result, nullptr, Op->m_arg);
+                break;
+            case URING_OP::RECV:
+                /* 缓冲区环用尽时多次触发结束，缓冲区归还后重新提交 */
+                if (Result != -ENOBUFS && Result != -ECANCELED)
+                {
+                    terminal = Result <= 0;
+                    Op->m_callback(Result, data, Op->m_arg);
+                }
+                break;
+            case URING_OP::SEND:
+                if (Result > 0)
+                {
+                    evbuffer_drain(Op->m_data, static_cast<size_t>(Result));
+                    Op->m_sent += static_cast<size_t>(Result);
+                    if (evbuffer_get_length(Op->m_data) == 0)
+                    {
+                        terminal = true;
+                        Op->m_callback(static_cast<int>(Op->m_sent), nullptr, Op->m_arg);
+                    }
+                }
+                else if (Result != -ECANCELED)
+                {
+                    terminal = true;
+                    Op->m_callback(Result < 0 ? Result : -EPIPE, nullptr, Op->m_arg);
+                }
+                break;
+        }
+    }
+    if (data != nullptr)
+        recycleBuffer(static_cast<uint16_t>(Flags >> IORING_CQE_BUFFER_SHIFT));
+
+    if (!Op->m_inflight && !Op->m_released && !terminal)
+    {
+        if (!Op->m_cancelRequested)
+        {
+            /* 多次触发的操作被内核结束或发送只完成了一部分，继续提交 */
+            arm(Op);
+            m_dispatching = nullptr;
+            return;
+        }
+        if (Op->m_kind == URING_OP::RECV || Op->m_kind == URING_OP::SEND)
+            Op->m_callback(-ECANCELED, nullptr, Op->m_arg);
+    }
+    m_dispatching = nullptr;
+    if (!Op->m_inflight)
+        recycle(Op);
+}
+
+void UringPoller::reap()
+{
+    unsigned head = *m_cqHead;
+    for (;;)
+    {
+        unsigned tail = __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE);
+        if (head == tail)
+            break;
+        for (; head != tail; head++)
+        {
+            const auto& cqe = m_cqes[head & m_cqMask];
+            const uint64_t userData = cqe.user_data;
+            const int result = cqe.res;
+            const uint32_t flags = cqe.flags;
+            /* 先交还完成队列的位置，回调中产生的完成事件不会因此溢出 */
+            __atomic_store_n(m_cqHead, head + 1, __ATOMIC_RELEASE);
+            const size_t index = static_cast<size_t>(userData & 0xffffffff);
+            UringOp* op = index == 0 || index > m_ops.size() ? nullptr : m_ops[index - 1].get();
+            if (op != nullptr && op->m_userData == userData)
+                dispatch(op, result, flags);
+            else if (flags & IORING_CQE_F_BUFFER)
+                recycleBuffer(static_cast<uint16_t>(flags >> IORING_CQE_BUFFER_SHIFT));
+        }
+    }
+    __atomic_store_n(&m_bufRing->tail, m_bufTail, __ATOMIC_RELEASE);
+}
+
+void UringPoller::run()
+{
+    m_broken = false;
+    while (!m_broken)
+    {
+        /* 上一轮准备的提交项（包括所有连接的发送）与等待合并为一次系统调用 */
+        if (!enter(tickTimeout()))
+            break;
+        reap();
+        runTick();
+        runDeferred();
+    }
+}
+}   // namespace ToolKit
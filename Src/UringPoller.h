@@ -0,0 +1,129 @@
+#pragma once
+
+#include "Poller.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+struct evbuffer;
+struct io_uring_sqe;
+struct io_uring_cqe;
+struct io_uring_buf_ring;
+
+namespace ToolKit
+{
+/**
+ * @brief 操作完成回调
+ * 接收：Result 为新连接的 fd，小于 0 为错误码；接收数据：Result 为字节数，Data 指向本次数据，回调返回后缓冲区归还内核，
+ * Result 为 0（EOF）或错误码时操作结束；发送：全部发出后以总字节数回调一次，出错时为错误码，回调后操作结束。
+ */
+using CompletionCallback = void (*)(int Result, const char* Data, void* Arg);
+
+/**
+ * @brief 以 io_uring 实现的事件循环，直接使用系统调用，不依赖 liburing
+ * 除了 Poller 的就绪通知（多次触发的 poll，用于 eventfd），还提供完成式的网络操作：
+ * 多次触发的 accept、从注册的缓冲区环（provided buffer ring）取缓冲区的多次触发 recv，以及 sendmsg。
+ * 一轮中准备的所有提交项在下一次 io_uring_enter 时一并提交并等待完成事件，同一轮中所有连接的发送只需一次系统调用。
+ * 操作由 UringOp 标识，release 之后不再回调，对象在内核交回最后一个完成事件后回收。
+ */
+class UringPoller : public Poller
+{
+public:
+    static constexpr unsigned RING_ENTRIES = 1024;
+    /* 接收缓冲区环：个数为 2 的幂 */
+    static constexpr unsigned RECV_BUFFERS = 512;
+    static constexpr size_t RECV_BUFFER_SIZE = 4096;
+    /* 一次 sendmsg 最多携带的 iovec 个数，剩余部分在完成后续发 */
+    static constexpr int SEND_IOVECS = 64;
+
+    UringPoller();
+    ~UringPoller() override;
+
+    /**
+     * @brief 内核支持所需的全部特性且初始化成功
+     */
+    bool valid() const { return m_ringFd >= 0; }
+
+    IO_BACKEND backend() const override { return IO_BACKEND::URING; }
+    bool add(PollWatch& Watch, int Fd, uint32_t Events, PollCallback Callback, void* Arg) override;
+    void remove(PollWatch& Watch) override;
+    bool setTick(std::chrono::milliseconds Interval, PollCallback Callback, void* Arg) override;
+    void run() override;
+    void breakLoop() override { m_broken = true; }
+
+    /**
+     * @brief 在监听套接字上持续接受连接，新连接为非阻塞、CLOEXEC
+     */
+    UringOp* accept(int ListenFd, CompletionCallback Callback, void* Arg);
+
+    /**
+     * @brief 持续接收数据直到 EOF、出错或 cancel
+     */
+    UringOp* recv(int Fd, CompletionCallback Callback, void* Arg);
+
+    /**
+     * @brief 把 Data 的全部内容移入操作自有的缓冲区后发送，调用方可以立即继续向 Data 追加
+     * Data 中不能有未映射的文件段（即不能设置 EVBUFFER_FLAG_DRAINS_TO_FD）。
+     */
+    UringOp* send(int Fd, struct evbuffer* Data, CompletionCallback Callback, void* Arg);
+
+    /**
+     * @brief 请求内核提前结束操作，之前已到达的数据照常回调，最后以 -ECANCELED 结束
+     */
+    void cancel(UringOp* Op);
+
+    /**
+     * @brief 不再回调，操作在内核交回后回收；回调中也可以调用
+     */
+    void release(UringOp* Op);
+
+private:
+    bool setup();
+    void teardown();
+    bool setupBufferRing();
+    struct io_uring_sqe* getSqe();
+    void arm(UringOp* Op);
+    /**
+     * @brief 提交已准备的提交项，WaitMs 不为 0 时至少等待一个完成事件（-1 表示不限时）
+     */
+    bool enter(int WaitMs);
+    void reap();
+    void dispatch(UringOp* Op, int Result, uint32_t Flags);
+    void recycleBuffer(uint16_t Bid);
+    UringOp* newOp(int Fd, CompletionCallback Callback, void* Arg);
+    void recycle(UringOp* Op);
+
+    int m_ringFd { -1 };
+    /* 提交队列与完成队列的共用映射 */
+    void* m_sqRing { nullptr };
+    size_t m_sqRingSize { 0 };
+    struct io_uring_sqe* m_sqes { nullptr };
+    size_t m_sqesSize { 0 };
+    unsigned* m_sqHead { nullptr };
+    unsigned* m_sqTail { nullptr };
+    unsigned* m_sqFlags { nullptr };
+    unsigned* m_sqArray { nullptr };
+    unsigned m_sqMask { 0 };
+    unsigned m_sqEntries { 0 };
+    /* 本地的提交队列尾，enter 之前发布给内核 */
+    unsigned m_localTail { 0 };
+    unsigned* m_cqHead { nullptr };
+    unsigned* m_cqTail { nullptr };
+    unsigned m_cqMask { 0 };
+    struct io_uring_cqe* m_cqes { nullptr };
+
+    struct io_uring_buf_ring* m_bufRing { nullptr };
+    size_t m_bufRingSize { 0 };
+    char* m_bufMemory { nullptr };
+    /* 本地的缓冲区环尾，一批完成事件处理完后发布 */
+    uint16_t m_bufTail { 0 };
+
+    std::vector<std::unique_ptr<UringOp>> m_ops;
+    std::vector<UringOp*> m_freeOps;
+    /* 正在回调的操作，回调中 release 它时推迟到回调返回后再回收 */
+    UringOp* m_dispatching { nullptr };
+    bool m_broken { false };
+};
+}   // namespace ToolKit
@@ -0,0 +1,582 @@
+#include "WebSocket.h"
+
+#include "ByteScanner.h"
+#include "spdlog/spdlog.h"
+
+#include <algorithm>
+#include <cstring>
+#include <event2/buffer.h>
+
+namespace
+{
+constexpr std::string_view SWITCHING_PROTOCOLS
+    = "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\nSec-WebSocket-Accept: ";
+constexpr std::string_view ACCEPT_GUID = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+/* 帧头最长 14 字节：2 字节基本头、8 字节扩展长度、4 字节掩码 */
+constexpr size_t MAX_FRAME_HEADER = 14;
+/* 每次 evbuffer_peek 取出的内存块数，更多的块留给下一轮 */
+constexpr int PEEK_VECTORS = 8;
+
+uint32_t rotateLeft(uint32_t Value, int Bits)
+{
+    return (Value << Bits) | (Value >> (32 - Bits));
+}
+
+/**
+ * @brief 握手只对 60 字节左右的输入计算一次，按 RFC 3174 逐块实现即可
+ */
+void sha1(std::string_view Data, unsigned char Digest[20])
+{
+    uint32_t h[5] { 0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0 };
+    std::string message(Data);
+    message.push_back(static_cast<char>(0x80));
+    while (message.size() % 64 != 56)
+        message.push_back('\0');
+    const uint64_t bits = static_cast<uint64_t>(Data.size()) * 8;
+    for (int i = 7; i >= 0; i--)
+        message.push_back(static_cast<char>(bits >> (i * 8)));
+
+    for (size_t offset = 0; offset < message.size(); offset += 64)
+    {
+        uint32_t w[80];
+        const auto* block = reinterpret_cast<const unsigned char*>(message.data() + offset);
+        for (int i = 0; i < 16; i++)
+        {
+            w[i] = (static_cast<uint32_t>(block[i * 4]) << 24) | (static_cast<uint32_t>(block[i * 4 + 1]) << 16)
+                | (static_cast<uint32_t>(block[i * 4 + 2]) << 8) | block[i * 4 + 3];
+        }
+        for (int i = 16; i < 80; i++)
+            w[i] = rotateLeft(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+
+        uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+        for (int i = 0; i < 80; i++)
+        {
+            uint32_t f;
+            uint32_t k;
+            if (i < 20)
+            {
+                f = (b & c) | (~b & d);
+                k = 0x5A827999;
+            }
+            else if (i < 40)
+            {
+                f = b ^ c ^ d;
+                k = 0x6ED9EBA1;
+            }
+            else if (i < 60)
+            {
+                f = (b & c) | (b & d) | (c & d);
+                k = 0x8F1BBCDC;
+            }
+            else
+            {
+                f = b ^ c ^ d;
+                k = 0xCA62C1D6;
+            }
+            const uint32_t temp = rotateLeft(a, 5) + f + e + k + w[i];
+            e = d;
+            d = c;
+            c = rotateLeft(b, 30);
+            b = a;
+            a = temp;
+        }
+        h[0] += a;
+        h[1] += b;
+        h[2] += c;
+        h[3] += d;
+        h[4] += e;
+    }
+    for (int i = 0; i < 5; i++)
+    {
+        Digest[i * 4] = static_cast<unsigned char>(h[i] >> 24);
+        Digest[i * 4 + 1] = static_cast<unsigned char>(h[i] >> 16);
+        Digest[i * 4 + 2] = static_cast<unsigned char>(h[i] >> 8);
+        Digest[i * 4 + 3] = static_cast<unsigned char>(h[i]);
+    }
+}
+
+std::string encodeBase64(const unsigned char* Data, size_t Len)
+{
+    static constexpr char ALPHABET[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string out;
+    out.reserve((Len + 2) / 3 * 4);
+    size_t i = 0;
+    for (; i + 3 <= Len; i += 3)
+    {
+        const uint32_t group = (static_cast<uint32_t>(Data[i]) << 16) | (static_cast<uint32_t>(Data[i + 1]) << 8) | Data[i + 2];
+        out.push_back(ALPHABET[(group >> 18) & 0x3f]);
+        out.push_back(ALPHABET[(group >> 12) & 0x3f]);
+        out.push_back(ALPHABET[(group >> 6) & 0x3f]);
+        out.push_back(ALPHABET[group & 0x3f]);
+    }
+    if (i < Len)
+    {
+        uint32_t group = static_cast<uint32_t>(Data[i]) << 16;
+        if (i + 1 < Len)
+            group |= static_cast<uint32_t>(Data[i + 1]) << 8;
+        out.push_back(ALPHABET[(group >> 18) & 0x3f]);
+        out.push_back(ALPHABET[(group >> 12) & 0x3f]);
+        out.push_back(i + 1 < Len ? ALPHABET[(group >> 6) & 0x3f] : '=');
+        out.push_back('=');
+    }
+    return out;
+}
+
+bool isControl(ToolKit::WS_OPCODE Opcode)
+{
+    return (static_cast<uint8_t>(Opcode) & 0x8) != 0;
+}
+
+bool isKnownOpcode(uint8_t Opcode)
+{
+    return Opcode <= 2 || (Opcode >= 8 && Opcode <= 10);
+}
+
+/**
+ * @brief 关闭帧中允许出现的状态码：已定义的协议状态码与 3000-4999 的应用状态码
+ */
+bool isValidCloseCode(uint16_t Code)
+{
+    return (Code >= 1000 && Code <= 1003) || (Code >= 1007 && Code <= 1014) || (Code >= 3000 && Code <= 4999);
+}
+}   // namespace
+
+namespace ToolKit
+{
+std::string webSocketAccept(std::string_view Key)
+{
+    std::string input(Key);
+    input.append(ACCEPT_GUID);
+    unsigned char digest[20];
+    sha1(input, digest);
+    return encodeBase64(digest, sizeof(digest));
+}
+
+size_t encodeWebSocketHeader(WS_OPCODE Opcode, bool Final, size_t Len, unsigned char (&Out)[WS_MAX_SERVER_HEADER])
+{
+    Out[0] = static_cast<unsigned char>((Final ? 0x80 : 0) | static_cast<uint8_t>(Opcode));
+    if (Len < 126)
+    {
+        Out[1] = static_cast<unsigned char>(Len);
+        return 2;
+    }
+    if (Len <= 0xffff)
+    {
+        Out[1] = 126;
+        Out[2] = static_cast<unsigned char>(Len >> 8);
+        Out[3] = static_cast<unsigned char>(Len);
+        return 4;
+    }
+    Out[1] = 127;
+    for (int i = 0; i < 8; i++)
+        Out[2 + i] = static_cast<unsigned char>(static_cast<uint64_t>(Len) >> (56 - i * 8));
+    return WS_MAX_SERVER_HEADER;
+}
+
+bool isWebSocketUpgrade(const HttpRequest& Request)
+{
+    return Request.m_method == "GET" && Request.m_versionMinor == 1 && hasToken(Request.header("Upgrade"), "websocket")
+        && hasToken(Request.header("Connection"), "upgrade") && Request.header("Sec-WebSocket-Version") == "13"
+        && Request.header("Sec-WebSocket-Key").size() == 24;
+}
+
+bool Utf8Validator::feed(const char* Data, size_t Len)
+{
+    size_t i = 0;
+    while (i < Len)
+    {
+        if (m_need == 0)
+        {
+            /* 不在多字节字符中间时先成组跳过 ASCII */
+            for (; i + 8 <= Len; i += 8)
+            {
+                uint64_t word;
+                memcpy(&word, Data + i, 8);
+                if ((word & 0x8080808080808080ull) != 0)
+                    break;
+            }
+            if (i == Len)
+                break;
+            const auto c = static_cast<uint8_t>(Data[i++]);
+            if (c < 0x80)
+                continue;
+            if (c >= 0xC2 && c <= 0xDF)
+                m_need = 1;
+            else if (c == 0xE0)
+            {
+                m_need = 2;
+                m_lower = 0xA0;
+            }
+            else if (c == 0xED)
+            {
+                m_need = 2;
+                m_upper = 0x9F;
+            }
+            else if (c >= 0xE1 && c <= 0xEF)
+                m_need = 2;
+            else if (c == 0xF0)
+            {
+                m_need = 3;
+                m_lower = 0x90;
+            }
+            else if (c == 0xF4)
+            {
+                m_need = 3;
+                m_upper = 0x8F;
+            }
+            else if (c >= 0xF1 && c <= 0xF3)
+                m_need = 3;
+            else
+                return false;
+            continue;
+        }
+        const auto c = static_cast<uint8_t>(Data[i++]);
+        if (c < m_lower || c > m_upper)
+            return false;
+        m_lower = 0x80;
+        m_upper = 0xBF;
+        m_need--;
+    }
+    return true;
+}
+
+WebSocketSession::WebSocketSession(const HttpConnectionOptions& Options, const HttpActionNotifier* Notifier)
+        : m_options(Options)
+{
+    m_subscriber.m_notifier = Notifier;
+}
+
+void WebSocketSession::open(
+    std::shared_ptr<const WebSocketHandler> Handler, const HttpRequest& Request, struct evbuffer* Output)
+{
+    m_handler = std::move(Handler);
+    m_output = Output;
+    m_open = true;
+    m_subscriber.m_output = Output;
+    m_subscriber.m_format
+        = m_handler->m_pushOpcode == WS_OPCODE::BINARY ? STREAM_FORMAT::WEBSOCKET_BINARY : STREAM_FORMAT::WEBSOCKET_TEXT;
+    m_subscriber.m_maxPendingBytes = m_handler->m_maxPendingBytes;
+    const auto accept = webSocketAccept(Request.header("Sec-WebSocket-Key"));
+    evbuffer_add(Output, SWITCHING_PROTOCOLS.data(), SWITCHING_PROTOCOLS.size());
+    evbuffer_add(Output, accept.data(), accept.size());
+    evbuffer_add(Output, "\r\n\r\n", 4);
+    if (m_handler->m_onOpen)
+        m_handler->m_onOpen(*this, Request);
+}
+
+void WebSocketSession::reset()
+{
+    /* 套接字已经关闭，m_onClose 中不能再写输出缓冲区，它马上要交给下一个连接 */
+    m_closeSent = true;
+    unsubscribeAll();
+    if (m_open)
+        notifyClose(WS_CLOSE_ABNORMAL);
+    m_handler.reset();
+    m_output = nullptr;
+    m_subscriber.m_output = nullptr;
+    m_context.reset();
+    m_inFrame = false;
+    m_frameFinal = false;
+    m_remaining = 0;
+    m_maskPhase = 0;
+    m_inMessage = false;
+    m_utf8.reset();
+    m_receivedMessages = 0;
+    m_open = false;
+    m_closeSent = false;
+    m_finished = false;
+    m_closeNotified = false;
+}
+
+CONN_ACTION WebSocketSession::onInput(struct evbuffer* Input, struct evbuffer* Output)
+{
+    while (!m_finished)
+    {
+        /* 对端不读取时不再处理输入，避免 PONG 与处理函数的回复无限积压 */
+        if (evbuffer_get_length(Output) >= m_options.m_outputHighWater)
+            return CONN_ACTION::PAUSE_READING;
+        if (m_inFrame)
+        {
+            if (m_remaining > 0 && evbuffer_get_length(Input) == 0)
+                break;
+            readPayload(Input);
+            continue;
+        }
+        if (!readHeader(Input))
+            break;
+    }
+    return m_finished ? CONN_ACTION::CLOSE_AFTER_WRITE : CONN_ACTION::KEEP_READING;
+}
+
+bool WebSocketSession::readHeader(struct evbuffer* Input)
+{
+    unsigned char head[MAX_FRAME_HEADER];
+    const auto copied = evbuffer_copyout(Input, head, sizeof(head));
+    if (copied < 2)
+        return false;
+    const auto available = static_cast<size_t>(copied);
+    const bool final = (head[0] & 0x80) != 0;
+    const uint8_t opcodeBits = head[0] & 0x0f;
+    /* 未协商扩展，RSV 位必须为 0；客户端发来的帧必须加掩码 */
+    if ((head[0] & 0x70) != 0 || (head[1] & 0x80) == 0 || !isKnownOpcode(opcodeBits))
+    {
+        fail(WS_CLOSE_PROTOCOL_ERROR);
+        return false;
+    }
+    const auto opcode = static_cast<WS_OPCODE>(opcodeBits);
+    uint64_t length = head[1] & 0x7f;
+    if (isControl(opcode) && (!final || length > WS_MAX_CONTROL_PAYLOAD))
+    {
+        fail(WS_CLOSE_PROTOCOL_ERROR);
+        return false;
+    }
+    const size_t lengthBytes = length == 126 ? 2 : (length == 127 ? 8 : 0);
+    const size_t headerSize = 2 + lengthBytes + 4;
+    if (available < headerSize)
+        return false;
+    if (lengthBytes > 0)
+    {
+        length = 0;
+        for (size_t i = 0; i < lengthBytes; i++)
+            length = (length << 8) | head[2 + i];
+        if ((length >> 63) != 0)
+        {
+            fail(WS_CLOSE_PROTOCOL_ERROR);
+            return false;
+        }
+    }
+    memcpy(m_mask, head + headerSize - 4, 4);
+    memcpy(m_mask + 4, m_mask, 4);
+
+    if (isControl(opcode))
+    {
+        /* 控制帧可以插在分片消息中间，收齐后整帧处理 */
+        if (evbuffer_get_length(Input) < headerSize + length)
+            return false;
+        char payload[WS_MAX_CONTROL_PAYLOAD];
+        evbuffer_drain(Input, headerSize);
+        evbuffer_remove(Input, payload, static_cast<size_t>(length));
+        uint32_t key;
+        memcpy(&key, m_mask, sizeof(key));
+        applyMask(payload, static_cast<size_t>(length), key);
+        onControl(opcode, payload, static_cast<size_t>(length));
+        return !m_finished;
+    }
+
+    if (opcode == WS_OPCODE::CONTINUATION)
+    {
+        if (!m_inMessage)
+        {
+            fail(WS_CLOSE_PROTOCOL_ERROR);
+            return false;
+        }
+    }
+    else
+    {
+        if (m_inMessage)
+        {
+            fail(WS_CLOSE_PROTOCOL_ERROR);
+            return false;
+        }
+        m_inMessage = true;
+        m_messageOpcode = opcode;
+        m_utf8.reset();
+    }
+    evbuffer_drain(Input, headerSize);
+    m_inFrame = true;
+    m_frameFinal = final;
+    m_remaining = length;
+    m_maskPhase = 0;
+    return true;
+}
+
+void WebSocketSession::readPayload(struct evbuffer* Input)
+{
+    if (m_remaining == 0)
+    {
+        deliver(nullptr, 0);
+        return;
+    }
+    const auto available = static_cast<size_t>(std::min<uint64_t>(m_remaining, evbuffer_get_length(Input)));
+    struct evbuffer_iovec vectors[PEEK_VECTORS];
+    const int count = std::min(evbuffer_peek(Input, static_cast<ev_ssize_t>(available), nullptr, vectors, PEEK_VECTORS),
+        PEEK_VECTORS);
+    /* 已到达的负载在输入缓冲区的各个内存块上原地去掩码后交出，不拷贝也不等待整条消息 */
+    size_t consumed = 0;
+    for (int i = 0; i < count && !m_finished && consumed < available; i++)
+    {
+        const size_t length = std::min(vectors[i].iov_len, available - consumed);
+        deliver(static_cast<char*>(vectors[i].iov_base), length);
+        consumed += length;
+    }
+    evbuffer_drain(Input, consumed);
+}
+
+void WebSocketSession::deliver(char* Data, size_t Len)
+{
+    if (Len > 0)
+    {
+        uint32_t key;
+        memcpy(&key, m_mask + m_maskPhase, sizeof(key));
+        applyMask(Data, Len, key);
+        m_maskPhase = (m_maskPhase + Len) & 3;
+    }
+    m_remaining -= Len;
+    const bool final = m_frameFinal && m_remaining == 0;
+    if (m_remaining == 0)
+        m_inFrame = false;
+    if (m_messageOpcode == WS_OPCODE::TEXT && (!m_utf8.feed(Data, Len) || (final && !m_utf8.complete())))
+    {
+        fail(WS_CLOSE_INVALID_PAYLOAD);
+        return;
+    }
+    if (final)
+    {
+        m_inMessage = false;
+        m_receivedMessages++;
+    }
+    /* 空的中间分片不必通知；发出关闭帧之后收到的数据直接丢弃 */
+    if ((Len > 0 || final) && !m_closeSent && m_handler->m_onMessage)
+        m_handler->m_onMessage(*this, m_messageOpcode, std::string_view(Data, Len), final);
+}
+
+void WebSocketSession::onControl(WS_OPCODE Opcode, char* Data, size_t Len)
+{
+    switch (Opcode)
+    {
+        case WS_OPCODE::PING:
+            if (!m_closeSent)
+                writeFrame(WS_OPCODE::PONG, true, Data, Len);
+            break;
+        case WS_OPCODE::CLOSE:
+        {
+            uint16_t code = WS_CLOSE_NO_STATUS;
+            if (Len == 1)
+            {
+                fail(WS_CLOSE_PROTOCOL_ERROR);
+                return;
+            }
+            if (Len >= 2)
+            {
+                code = static_cast<uint16_t>((static_cast<uint8_t>(Data[0]) << 8) | static_cast<uint8_t>(Data[1]));
+                if (!isValidCloseCode(code))
+                {
+                    fail(WS_CLOSE_PROTOCOL_ERROR);
+                    return;
+                }
+                Utf8Validator reason;
+                if (!reason.feed(Data + 2, Len - 2) || !reason.complete())
+                {
+                    fail(WS_CLOSE_INVALID_PAYLOAD);
+                    return;
+                }
+            }
+            /* 回送对端的状态码完成关闭握手 */
+            if (!m_closeSent)
+            {
+                writeFrame(WS_OPCODE::CLOSE, true, Data, std::min<size_t>(Len, 2));
+                m_closeSent = true;
+            }
+            unsubscribeAll();
+            notifyClose(code);
+            m_finished = true;
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+void WebSocketSession::writeFrame(WS_OPCODE Opcode, bool Final, const char* Data, size_t Len)
+{
+    unsigned char head[WS_MAX_SERVER_HEADER];
+    evbuffer_add(m_output, head, encodeWebSocketHeader(Opcode, Final, Len, head));
+    if (Len > 0)
+        evbuffer_add(m_output, Data, Len);
+}
+
+void WebSocketSession::send(WS_OPCODE Opcode, std::string_view Data, bool Final)
+{
+    if (!m_open || m_closeSent)
+        return;
+    if (Opcode == WS_OPCODE::CLOSE)
+    {
+        close();
+        return;
+    }
+    if (isControl(Opcode))
+    {
+        Final = true;
+        Data = Data.substr(0, WS_MAX_CONTROL_PAYLOAD);
+    }
+    writeFrame(Opcode, Final, Data.data(), Data.size());
+}
+
+void WebSocketSession::close(uint16_t Code, std::string_view Reason)
+{
+    if (!m_open || m_closeSent)
+        return;
+    char payload[WS_MAX_CONTROL_PAYLOAD];
+    payload[0] = static_cast<char>(Code >> 8);
+    payload[1] = static_cast<char>(Code);
+    const size_t reasonLength = std::min(Reason.size(), WS_MAX_CONTROL_PAYLOAD - 2);
+    memcpy(payload + 2, Reason.data(), reasonLength);
+    writeFrame(WS_OPCODE::CLOSE, true, payload, 2 + reasonLength);
+    m_closeSent = true;
+    unsubscribeAll();
+}
+
+void WebSocketSession::fail(uint16_t Code)
+{
+    spdlog::warn("{} websocket protocol error, close code[{}]", __FUNCTION__, Code);
+    if (!m_closeSent)
+    {
+        const char payload[2] { static_cast<char>(Code >> 8), static_cast<char>(Code) };
+        writeFrame(WS_OPCODE::CLOSE, true, payload, sizeof(payload));
+        m_closeSent = true;
+    }
+    unsubscribeAll();
+    notifyClose(Code);
+    m_finished = true;
+}
+
+bool WebSocketSession::subscribe(std::string_view Topic)
+{
+    if (m_options.m_pubSub == nullptr || !m_open || m_closeSent)
+        return false;
+    m_options.m_pubSub->subscribe(m_subscriber, Topic);
+    return true;
+}
+
+void WebSocketSession::unsubscribe(std::string_view Topic)
+{
+    if (m_options.m_pubSub != nullptr)
+        m_options.m_pubSub->unsubscribe(m_subscriber, Topic);
+}
+
+void WebSocketSession::unsubscribeAll()
+{
+    if (m_options.m_pubSub != nullptr)
+        m_options.m_pubSub->unsubscribeAll(m_subscriber);
+}
+
+void WebSocketSession::notifyClose(uint16_t Code)
+{
+    if (m_closeNotified)
+        return;
+    m_closeNotified = true;
+    if (m_handler != nullptr && m_handler->m_onClose)
+        m_handler->m_onClose(*this, Code);
+}
+
+DEADLINE WebSocketSession::pendingDeadline(struct evbuffer* Input, struct evbuffer* Output) const
+{
+    if (evbuffer_get_length(Output) > 0)
+        return DEADLINE::WRITE;
+    if (m_closeSent)
+        return DEADLINE::IDLE;
+    if (m_inFrame || evbuffer_get_length(Input) > 0)
+        return DEADLINE::BODY_READ;
+    return DEADLINE::NONE;
+}
+}   // namespace ToolKit
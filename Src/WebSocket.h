@@ -0,0 +1,226 @@
+#pragma once
+
+#include "HttpConnection.h"
+#include "PubSub.h"
+
+#include <any>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+
+struct evbuffer;
+
+namespace ToolKit
+{
+enum class WS_OPCODE : uint8_t
+{
+    CONTINUATION = 0,
+    TEXT = 1,
+    BINARY = 2,
+    CLOSE = 8,
+    PING = 9,
+    PONG = 10
+};
+
+/* 关闭帧状态码，见 RFC 6455 7.4.1 */
+constexpr uint16_t WS_CLOSE_NORMAL = 1000;
+constexpr uint16_t WS_CLOSE_GOING_AWAY = 1001;
+constexpr uint16_t WS_CLOSE_PROTOCOL_ERROR = 1002;
+constexpr uint16_t WS_CLOSE_UNSUPPORTED_DATA = 1003;
+/* 以下两个只用于通知本端，不能出现在关闭帧中 */
+constexpr uint16_t WS_CLOSE_NO_STATUS = 1005;
+constexpr uint16_t WS_CLOSE_ABNORMAL = 1006;
+constexpr uint16_t WS_CLOSE_INVALID_PAYLOAD = 1007;
+constexpr uint16_t WS_CLOSE_MESSAGE_TOO_BIG = 1009;
+constexpr uint16_t WS_CLOSE_INTERNAL_ERROR = 1011;
+
+/* 控制帧负载的上限 */
+constexpr size_t WS_MAX_CONTROL_PAYLOAD = 125;
+
+class WebSocketSession;
+
+/**
+ * @brief 一个 WebSocket 路由的回调，都在连接所属的事件循环线程上执行
+ * m_onMessage 按到达顺序收到消息的各个片段：Opcode 为消息的类型（TEXT 或 BINARY，不会是 CONTINUATION），
+ * Data 是已去掉掩码的一段负载，只在回调期间有效；Final 为 true 表示这是消息的最后一段。
+ * 一条消息可能被切成任意多段（对端的分片与输入缓冲区的分块都会造成切分），需要完整消息的处理函数自行拼接。
+ * TEXT 消息的每一段都已通过 UTF-8 校验，但多字节字符可能跨段。
+ * m_onClose 在连接结束时恰好调用一次，Code 为对端关闭帧中的状态码，或本端因协议错误关闭时使用的状态码，
+ * 连接未经关闭握手就断开时为 WS_CLOSE_ABNORMAL。
+ * 会话订阅的主题消息以 m_pushOpcode（TEXT 或 BINARY）类型的单帧推送，m_maxPendingBytes 为 0 时使用 PubSub 的默认积压上限。
+ */
+struct WebSocketHandler
+{
+    std::function<void(WebSocketSession& Session, const HttpRequest& Request)> m_onOpen;
+    std::function<void(WebSocketSession& Session, WS_OPCODE Opcode, std::string_view Data, bool Final)> m_onMessage;
+    std::function<void(WebSocketSession& Session, uint16_t Code)> m_onClose;
+    WS_OPCODE m_pushOpcode { WS_OPCODE::TEXT };
+    size_t m_maxPendingBytes { 0 };
+};
+
+/* 服务端帧头最长 10 字节：2 字节基本头加 8 字节扩展长度 */
+constexpr size_t WS_MAX_SERVER_HEADER = 10;
+
+/**
+ * @brief 编码服务端发出的帧头（不加掩码），返回写入 Out 的字节数
+ */
+size_t encodeWebSocketHeader(WS_OPCODE Opcode, bool Final, size_t Len, unsigned char (&Out)[WS_MAX_SERVER_HEADER]);
+
+/**
+ * @brief 由 Sec-WebSocket-Key 计算 Sec-WebSocket-Accept
+ */
+std::string webSocketAccept(std::string_view Key);
+
+/**
+ * @brief 请求是否为合法的 WebSocket 升级请求（HTTP/1.1 GET，Upgrade: websocket，Connection: Upgrade，版本 13）
+ */
+bool isWebSocketUpgrade(const HttpRequest& Request);
+
+/**
+ * @brief 增量的 UTF-8 校验，多字节字符可以跨越多次 feed
+ * 拒绝过长编码、代理区码点与超出 U+10FFFF 的码点；连续的 ASCII 按 8 字节一组跳过。
+ */
+class Utf8Validator
+{
+public:
+    /**
+     * @brief 校验下一段数据，出现非法字节时返回 false，之后的结果没有意义
+     */
+    bool feed(const char* Data, size_t Len);
+
+    /**
+     * @brief 已输入的数据是否在字符边界上结束
+     */
+    bool complete() const { return m_need == 0; }
+
+    void reset()
+    {
+        m_need = 0;
+        m_lower = 0x80;
+        m_upper = 0xBF;
+    }
+
+private:
+    /* 当前字符还缺少的后续字节数，以及下一个后续字节的取值范围 */
+    uint8_t m_need { 0 };
+    uint8_t m_lower { 0x80 };
+    uint8_t m_upper { 0xBF };
+};
+
+/**
+ * @brief 一个 WebSocket 连接的协议状态，由 HttpConnection 在完成升级握手后接管
+ * 与 HttpConnection 一样只在输入、输出两个 evbuffer 上工作。帧头从输入缓冲区中拷出至多 14 字节解析，
+ * 数据帧的负载不做拼接：每次只取已到达的部分，经 evbuffer_peek 在输入缓冲区的内存块上原地去掉掩码
+ * （applyMask，按 ByteScanner 的指令集级别分派）后直接交给 m_onMessage，随后丢弃。控制帧不超过 125 字节，
+ * 收齐后再处理：PING 立即回复 PONG，CLOSE 回送关闭帧后在输出写完时关闭连接。
+ * 协议错误按 RFC 6455 发送 1002/1007 关闭帧并关闭连接。本端发出的帧不加掩码。
+ * 输出积压超过高水位时暂停读取。没有收发中的帧时不设超时，适合长期保持的推送连接；
+ * 本端发出关闭帧后以空闲超时等待对端的关闭帧。
+ * 会话可以订阅 PubSub 的主题，发出关闭帧时退订全部主题，关闭帧之后不会再有推送的数据帧。
+ */
+class WebSocketSession
+{
+public:
+    explicit WebSocketSession(const HttpConnectionOptions& Options, const HttpActionNotifier* Notifier = nullptr);
+    WebSocketSession(const WebSocketSession&) = delete;
+    const WebSocketSession& operator=(const WebSocketSession&) = delete;
+
+    /**
+     * @brief 写出 101 响应并调用 m_onOpen，Request 须是通过 isWebSocketUpgrade 检查的请求
+     * 之后 send 等函数写入 Output，Output 须在会话存续期间有效。
+     */
+    void open(std::shared_ptr<const WebSocketHandler> Handler, const HttpRequest& Request, struct evbuffer* Output);
+
+    CONN_ACTION onInput(struct evbuffer* Input, struct evbuffer* Output);
+
+    DEADLINE pendingDeadline(struct evbuffer* Input, struct evbuffer* Output) const;
+
+    /**
+     * @brief 恢复初始状态以便随连接对象复用；连接未完成关闭握手时以 WS_CLOSE_ABNORMAL 调用 m_onClose
+     */
+    void reset();
+
+    /**
+     * @brief 发送一帧，只能在事件循环线程上调用
+     * 分片发送时第一帧用消息的类型、Final 为 false，后续帧用 CONTINUATION。控制帧的负载超过 125 字节时截断。
+     * 已发出关闭帧后调用被忽略。
+     */
+    void send(WS_OPCODE Opcode, std::string_view Data, bool Final = true);
+    void sendText(std::string_view Data) { send(WS_OPCODE::TEXT, Data); }
+    void sendBinary(std::string_view Data) { send(WS_OPCODE::BINARY, Data); }
+    void ping(std::string_view Data = {}) { send(WS_OPCODE::PING, Data); }
+
+    /**
+     * @brief 发起关闭握手，之后收到的数据帧不再交给处理函数，收到对端的关闭帧后关闭连接
+     */
+    void close(uint16_t Code = WS_CLOSE_NORMAL, std::string_view Reason = {});
+
+    /**
+     * @brief 订阅主题，HttpConnectionOptions 中没有配置 PubSub 或已发出关闭帧时返回 false
+     */
+    bool subscribe(std::string_view Topic);
+    void unsubscribe(std::string_view Topic);
+
+    /**
+     * @brief 推送消息因积压超限被丢弃的条数
+     */
+    size_t dropped() const { return m_subscriber.dropped(); }
+
+    /**
+     * @brief 是否已发出关闭帧
+     */
+    bool closeSent() const { return m_closeSent; }
+
+    /**
+     * @brief 已完整收到的数据消息数
+     */
+    size_t receivedMessages() const { return m_receivedMessages; }
+
+    /**
+     * @brief 处理函数挂载的连接级数据，随会话复用清空
+     */
+    std::any& context() { return m_context; }
+
+private:
+    /**
+     * @brief 解析一个帧头，控制帧收齐后一并处理；输入不足或出现协议错误时返回 false
+     */
+    bool readHeader(struct evbuffer* Input);
+    void readPayload(struct evbuffer* Input);
+    void onControl(WS_OPCODE Opcode, char* Data, size_t Len);
+    void deliver(char* Data, size_t Len);
+    void writeFrame(WS_OPCODE Opcode, bool Final, const char* Data, size_t Len);
+    void fail(uint16_t Code);
+    void notifyClose(uint16_t Code);
+    void unsubscribeAll();
+
+    const HttpConnectionOptions& m_options;
+    std::shared_ptr<const WebSocketHandler> m_handler;
+    PubSubSubscriber m_subscriber;
+    struct evbuffer* m_output { nullptr };
+    std::any m_context;
+
+    /* 当前帧：帧头已经丢弃，只剩负载的剩余长度与掩码相位 */
+    bool m_inFrame { false };
+    bool m_frameFinal { false };
+    uint64_t m_remaining { 0 };
+    /* 掩码重复两遍，从相位 k 开始的 4 字节就是轮转后的掩码 */
+    unsigned char m_mask[8] {};
+    size_t m_maskPhase { 0 };
+
+    /* 当前消息：第一帧之后等待 CONTINUATION */
+    bool m_inMessage { false };
+    WS_OPCODE m_messageOpcode { WS_OPCODE::TEXT };
+    Utf8Validator m_utf8;
+    size_t m_receivedMessages { 0 };
+
+    bool m_open { false };
+    bool m_closeSent { false };
+    /* 关闭握手已完成或出现协议错误，输出写完后关闭连接 */
+    bool m_finished { false };
+    bool m_closeNotified { false };
+};
+}   // namespace ToolKit
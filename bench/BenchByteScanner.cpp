@@ -0,0 +1,141 @@
+#include "ByteScanner.h"
+#include "HttpParser.h"
+
+#include <chrono>
+#include <cstdio>
+#include <event2/buffer.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace ToolKit;
+using namespace std;
+
+#ifndef BENCH_CORPUS_DIR
+#define BENCH_CORPUS_DIR ""
+#endif
+
+namespace
+{
+volatile size_t benchSink = 0;
+
+/**
+ * @brief 读取录制的请求流，按首部结束符切分成单个请求
+ */
+vector<string> loadCorpus(const string& Name)
+{
+    ifstream in(string(BENCH_CORPUS_DIR) + Name, ios::binary);
+    stringstream content;
+    content << in.rdbuf();
+    string all = content.str();
+
+    vector<string> requests;
+    size_t begin = 0;
+    size_t end;
+    while ((end = all.find("\r\n\r\n", begin)) != string::npos)
+    {
+        requests.push_back(all.substr(begin, end + 4 - begin));
+        begin = end + 4;
+    }
+    return requests;
+}
+
+/**
+ * @brief 对整个语料循环执行 Func，返回每个请求的平均耗时（纳秒）
+ */
+template <class F>
+double measure(const vector<string>& Requests, F&& Func)
+{
+    const size_t rounds = 2000;
+    for (const auto& request : Requests)
+        Func(request);
+
+    auto start = chrono::steady_clock::now();
+    for (size_t r = 0; r < rounds; r++)
+    {
+        for (const auto& request : Requests)
+            Func(request);
+    }
+    auto elapsed = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+    return elapsed / static_cast<double>(rounds * Requests.size());
+}
+
+void runCorpus(const string& Name)
+{
+    auto requests = loadCorpus(Name);
+    if (requests.empty())
+    {
+        printf("corpus %s not found under %s\n", Name.c_str(), BENCH_CORPUS_DIR);
+        return;
+    }
+    size_t bytes = 0;
+    for (const auto& request : requests)
+        bytes += request.size();
+    double avgBytes = static_cast<double>(bytes) / static_cast<double>(requests.size());
+    printf("\n%s: %zu requests, %.0f bytes/request\n", Name.c_str(), requests.size(), avgBytes);
+    printf("%-10s %-14s %12s %12s\n", "level", "bench", "ns/request", "MB/s");
+
+    vector<SCAN_LEVEL> levels { SCAN_LEVEL::SCALAR, SCAN_LEVEL::SSE42, SCAN_LEVEL::AVX2 };
+    struct evbuffer* input = evbuffer_new();
+    HttpRequestParser parser;
+    HttpRequest parsed;
+    for (auto level : levels)
+    {
+        if (setScanLevel(level) != level)
+            continue;
+
+        /* 只扫描首部结束符 */
+        double terminator = measure(requests,
+            [](const string& Request) { benchSink = benchSink + static_cast<size_t>(scanHeadTerminator(Request.data(), Request.size())); });
+
+        /* 按行切分首部名与首部值，模拟解析器在首部区的全部扫描工作 */
+        double fields = measure(requests,
+            [](const string& Request)
+            {
+                const char* cur = Request.data() + Request.find("\r\n") + 2;
+                const char* end = Request.data() + Request.size() - 2;
+                while (cur < end)
+                {
+                    const char* colon = cur + scanTokenLength(cur, static_cast<size_t>(end - cur));
+                    const char* eol = colon + 1 + scanFieldValueLength(colon + 1, static_cast<size_t>(end - colon - 1));
+                    benchSink = benchSink + static_cast<size_t>(eol - cur);
+                    cur = eol + 2;
+                }
+            });
+
+        /* 完整解析：从 evbuffer 读取、校验并生成视图 */
+        double full = measure(requests,
+            [&](const string& Request)
+            {
+                evbuffer_add_reference(input, Request.data(), Request.size(), nullptr, nullptr);
+                parser.parse(input, parsed);
+                benchSink = benchSink + parsed.m_headers.size();
+                parser.consume(input, parsed);
+            });
+
+        auto report = [&](const char* Bench, double Ns)
+        { printf("%-10s %-14s %12.1f %12.1f\n", scanLevelName(level), Bench, Ns, avgBytes / Ns * 1000.0); };
+        report("terminator", terminator);
+        report("fields", fields);
+        report("full-parse", full);
+    }
+    evbuffer_free(input);
+    setScanLevel(supportedScanLevel());
+}
+}   // namespace
+
+int main(int argc, char* argv[])
+{
+    printf("cpu supports: %s\n", scanLevelName(supportedScanLevel()));
+    if (argc > 1)
+    {
+        for (int i = 1; i < argc; i++)
+            runCorpus(argv[i]);
+        return 0;
+    }
+    runCorpus("browser.http");
+    runCorpus("tracing.http");
+    runCorpus("api.http");
+    return 0;
+}
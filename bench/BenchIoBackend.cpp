@@ -0,0 +1,216 @@
+#include "HttpConnection.h"
+#include "Reactor.h"
+#include "SocketStream.h"
+
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <event2/buffer.h>
+#include <event2/bufferevent.h>
+#include <event2/event.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace ToolKit;
+using namespace std;
+
+namespace
+{
+constexpr int CLIENTS = 4;
+constexpr size_t REQUESTS_PER_CLIENT = 20000;
+const string REQUEST = "GET /hello HTTP/1.1\r\nHost: bench\r\n\r\n";
+
+HttpConnectionOptions options;
+HttpHandler helloHandler { [](const HttpRequest&, HttpResponse& Response) { evbuffer_add(Response.body(), "hello", 5); } };
+HttpHandlerResolver resolver = [](HttpRequest&) -> const HttpHandler* { return &helloHandler; };
+atomic<int> liveConnections { 0 };
+
+/**
+ * @brief 与 HttpServer 相同的连接结构的精简版：LIBEVENT 后端用 bufferevent，EPOLL 与 URING 后端用 SocketStream
+ * 请求都是短小的 keep-alive GET，不处理暂停读取与超时。
+ */
+struct BenchConnection
+{
+    ~BenchConnection()
+    {
+        if (m_bufEv != nullptr)
+            bufferevent_free(m_bufEv);
+        liveConnections.fetch_sub(1);
+    }
+
+    struct evbuffer* input() { return m_bufEv != nullptr ? bufferevent_get_input(m_bufEv) : m_stream.input(); }
+    struct evbuffer* output() { return m_bufEv != nullptr ? bufferevent_get_output(m_bufEv) : m_stream.output(); }
+
+    void process()
+    {
+        if (m_http.onInput(input(), output()) == CONN_ACTION::CLOSE_AFTER_WRITE)
+            delete this;
+    }
+
+    struct bufferevent* m_bufEv { nullptr };
+    SocketStream m_stream;
+    HttpConnection m_http { options, resolver };
+};
+
+void onBufferRead(struct bufferevent*, void* Arg)
+{
+    static_cast<BenchConnection*>(Arg)->process();
+}
+
+void onBufferEvent(struct bufferevent*, short Events, void* Arg)
+{
+    if (Events & (BEV_EVENT_EOF | BEV_EVENT_ERROR))
+        delete static_cast<BenchConnection*>(Arg);
+}
+
+void onStreamRead(SocketStream&, void* Arg)
+{
+    static_cast<BenchConnection*>(Arg)->process();
+}
+
+void onStreamClose(SocketStream& Stream, void* Arg)
+{
+    Stream.detach();
+    delete static_cast<BenchConnection*>(Arg);
+}
+
+void onConnection(Reactor& Owner, evutil_socket_t Fd)
+{
+    int noDelay = 1;
+    setsockopt(Fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+    auto* conn = new BenchConnection;
+    liveConnections.fetch_add(1);
+    if (Owner.backend() != IO_BACKEND::LIBEVENT)
+    {
+        conn->m_stream.setCallbacks(onStreamRead, nullptr, onStreamClose, conn);
+        if (!conn->m_stream.attach(Owner.poller(), Fd))
+        {
+            close(Fd);
+            delete conn;
+        }
+        return;
+    }
+    conn->m_bufEv = bufferevent_socket_new(Owner.base(), Fd, BEV_OPT_CLOSE_ON_FREE);
+    bufferevent_setcb(conn->m_bufEv, onBufferRead, nullptr, onBufferEvent, conn);
+    bufferevent_enable(conn->m_bufEv, EV_READ | EV_WRITE);
+}
+
+/* 读满 Bytes 字节，对端关闭时返回 false */
+bool readExactly(int Fd, char* Buffer, size_t Bytes)
+{
+    size_t got = 0;
+    while (got < Bytes)
+    {
+        ssize_t n = read(Fd, Buffer + got, Bytes - got);
+        if (n <= 0)
+            return false;
+        got += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+/* 响应没有随时间变化的首部，长度固定，先完整读一次得到它 */
+size_t probeResponseSize(int Fd)
+{
+    if (write(Fd, REQUEST.data(), REQUEST.size()) != ssize_t(REQUEST.size()))
+        return 0;
+    string head;
+    char c;
+    while (head.size() < 4 || head.compare(head.size() - 4, 4, "\r\n\r\n") != 0)
+    {
+        if (read(Fd, &c, 1) != 1)
+            return 0;
+        head.push_back(c);
+    }
+    auto pos = head.find("Content-Length: ");
+    size_t bodyBytes = pos == string::npos ? 0 : stoul(head.substr(pos + 16));
+    vector<char> body(bodyBytes);
+    if (!readExactly(Fd, body.data(), bodyBytes))
+        return 0;
+    return head.size() + bodyBytes;
+}
+
+/**
+ * @brief 一个 Reactor 服务 CLIENTS 个 keep-alive 连接，每个客户端线程一次写出 Pipeline 个请求再读回全部响应，
+ * 返回每秒完成的请求数
+ */
+double measure(IO_BACKEND Backend, size_t Pipeline)
+{
+    Reactor reactor(0, onConnection, Reactor::DEFAULT_QUEUE_CAPACITY, Backend);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (!reactor.listen(reinterpret_cast<const struct sockaddr*>(&addr), sizeof(addr), 128))
+        return 0;
+    socklen_t addrLen = sizeof(addr);
+    getsockname(reactor.listenFd(), reinterpret_cast<struct sockaddr*>(&addr), &addrLen);
+    if (!reactor.start())
+        return 0;
+
+    string batch;
+    for (size_t i = 0; i < Pipeline; i++)
+        batch += REQUEST;
+    atomic<size_t> completed { 0 };
+    auto start = chrono::steady_clock::now();
+    vector<thread> clients;
+    for (int i = 0; i < CLIENTS; i++)
+        clients.emplace_back(
+            [&]
+            {
+                int fd = socket(AF_INET, SOCK_STREAM, 0);
+                int noDelay = 1;
+                setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+                if (connect(fd, reinterpret_cast<const struct sockaddr*>(&addr), sizeof(addr)) != 0)
+                {
+                    close(fd);
+                    return;
+                }
+                size_t responseSize = probeResponseSize(fd);
+                vector<char> responses(responseSize * Pipeline);
+                size_t done = 1;
+                while (responseSize > 0 && done < REQUESTS_PER_CLIENT)
+                {
+                    if (write(fd, batch.data(), batch.size()) != ssize_t(batch.size())
+                        || !readExactly(fd, responses.data(), responses.size()))
+                        break;
+                    done += Pipeline;
+                }
+                completed.fetch_add(done);
+                close(fd);
+            });
+    for (auto& client : clients)
+        client.join();
+    auto elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    /* bufferevent 要在 event_base 释放之前释放，等服务端处理完所有连接的 EOF */
+    while (liveConnections.load() > 0)
+        this_thread::yield();
+    reactor.stop();
+    return static_cast<double>(completed.load()) / elapsed;
+}
+}   // namespace
+
+int main()
+{
+    signal(SIGPIPE, SIG_IGN);
+    printf("clients: %d, requests per client: %zu\n", CLIENTS, REQUESTS_PER_CLIENT);
+    printf("%-10s %14s %14s %14s\n", "pipeline", "libevent req/s", "epoll req/s", "io_uring req/s");
+    for (size_t pipeline : { 1, 16 })
+    {
+        double libeventRate = measure(IO_BACKEND::LIBEVENT, pipeline);
+        double epollRate = measure(IO_BACKEND::EPOLL, pipeline);
+        /* 内核不支持时 Reactor 退回 epoll，这一列与 epoll 相同 */
+        double uringRate = measure(IO_BACKEND::URING, pipeline);
+        printf("%-10zu %14.0f %14.0f %14.0f\n", pipeline, libeventRate, epollRate, uringRate);
+    }
+    return 0;
+}
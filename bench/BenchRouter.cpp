@@ -0,0 +1,133 @@
+#include "Router.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <random>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+using namespace ToolKit;
+using namespace std;
+
+namespace
+{
+constexpr size_t LOOKUPS = 2000000;
+
+using Clock = chrono::steady_clock;
+
+double nsPerLookup(Clock::time_point Start)
+{
+    return chrono::duration<double, nano>(Clock::now() - Start).count() / static_cast<double>(LOOKUPS);
+}
+
+/**
+ * @brief 每个资源三条路由：列表、按 id 访问与其下的子资源，另有一条静态文件前缀
+ */
+vector<pair<string, HttpHandler>> makeRoutes(size_t Resources)
+{
+    vector<pair<string, HttpHandler>> routes;
+    HttpHandler handler { [](const HttpRequest&, HttpResponse&) {} };
+    for (size_t i = 0; i < Resources; i++)
+    {
+        auto base = "/api/v1/resource" + to_string(i);
+        routes.emplace_back(base, handler);
+        routes.emplace_back(base + "/:id", handler);
+        routes.emplace_back(base + "/:id/items", handler);
+    }
+    routes.emplace_back("/static/*path", handler);
+    return routes;
+}
+
+vector<string> makePaths(size_t Resources)
+{
+    mt19937 random(1);
+    vector<string> paths(4096);
+    for (auto& path : paths)
+    {
+        auto base = "/api/v1/resource" + to_string(random() % Resources);
+        switch (random() % 4)
+        {
+        case 0: path = base; break;
+        case 1: path = base + "/" + to_string(random()); break;
+        case 2: path = base + "/" + to_string(random()) + "/items"; break;
+        default: path = "/static/css/site" + to_string(random() % 100) + ".css"; break;
+        }
+    }
+    return paths;
+}
+
+/**
+ * @brief 替换前的匹配方式：精确路径查 map，失败后按长度降序逐个比较前缀。
+ * 它不支持参数，这里把 :id 路由当作以 base + "/" 为前缀的路由，只用来对比随路由数增长的开销。
+ */
+class LinearResolver
+{
+public:
+    explicit LinearResolver(const vector<pair<string, HttpHandler>>& Routes)
+    {
+        for (auto& [pattern, handler] : Routes)
+        {
+            auto special = pattern.find_first_of(":*");
+            if (special == string::npos)
+                m_paths.emplace(pattern, handler);
+            else
+                m_prefixes.emplace_back(pattern.substr(0, special), handler);
+        }
+        stable_sort(m_prefixes.begin(), m_prefixes.end(),
+            [](const auto& Left, const auto& Right) { return Left.first.size() > Right.first.size(); });
+    }
+
+    const HttpHandler* match(string_view Path) const
+    {
+        auto it = m_paths.find(Path);
+        if (it != m_paths.end())
+            return &it->second;
+        for (auto& [prefix, handler] : m_prefixes)
+        {
+            if (Path.substr(0, prefix.size()) == prefix)
+                return &handler;
+        }
+        return nullptr;
+    }
+
+private:
+    map<string, HttpHandler, less<>> m_paths;
+    vector<pair<string, HttpHandler>> m_prefixes;
+};
+
+void bench(size_t Resources)
+{
+    auto routes = makeRoutes(Resources);
+    auto paths = makePaths(Resources);
+    Router router(routes);
+    LinearResolver linear(routes);
+
+    size_t hits = 0;
+    auto start = Clock::now();
+    for (size_t i = 0; i < LOOKUPS; i++)
+    {
+        RouteMatch match;
+        hits += router.match(paths[i % paths.size()], match);
+    }
+    printf("%-8zu %-8s %12.1f   (hits %zu)\n", router.size(), "radix", nsPerLookup(start), hits);
+
+    hits = 0;
+    start = Clock::now();
+    for (size_t i = 0; i < LOOKUPS; i++)
+        hits += linear.match(paths[i % paths.size()]) != nullptr;
+    printf("%-8zu %-8s %12.1f   (hits %zu)\n", router.size(), "linear", nsPerLookup(start), hits);
+}
+}   // namespace
+
+int main()
+{
+    printf("lookups: %zu\n", LOOKUPS);
+    printf("%-8s %-8s %12s\n", "routes", "impl", "ns/lookup");
+    for (size_t resources : { 3, 30, 300, 1000 })
+        bench(resources);
+    return 0;
+}
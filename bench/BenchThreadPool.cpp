@@ -0,0 +1,96 @@
+#include "Infra/ThreadPool.h"
+#include "Infra/WorkStealingThreadPool.h"
+#include "ThreadCompetition.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <thread>
+
+using namespace ToolKit;
+using namespace std;
+
+namespace
+{
+constexpr size_t POOL_THREADS = 4;
+constexpr size_t TOTAL_TASKS = 400000;
+
+/**
+ * @brief 多个生产者同时向线程池提交空任务，返回每个任务从提交到执行完毕的平均耗时（纳秒）
+ * 生产者由 ThreadCompetition 预先就位，notifyAllThreads 后同时开始，以制造最大的入队竞争。
+ */
+template <class Pool>
+double producersContend(size_t Producers)
+{
+    atomic<size_t> done { 0 };
+    const size_t perProducer = TOTAL_TASKS / Producers;
+    const size_t total = perProducer * Producers;
+
+    Pool pool(POOL_THREADS);
+    chrono::steady_clock::time_point start;
+    {
+        ThreadCompetition producers(Producers);
+        for (size_t i = 0; i < Producers; i++)
+            producers.enqueue(
+                [&pool, &done, perProducer]
+                {
+                    for (size_t n = 0; n < perProducer; n++)
+                        pool.enqueue([&done] { done.fetch_add(1, memory_order_relaxed); });
+                },
+                i);
+        start = chrono::steady_clock::now();
+        producers.notifyAllThreads();
+    }
+    while (done.load() < total)
+        this_thread::yield();
+    auto elapsed = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+    return elapsed / static_cast<double>(total);
+}
+
+/**
+ * @brief 任务在工作线程内部递归拆分，只有一个外部提交，考察本地队列与窃取的开销
+ */
+template <class Pool>
+double nestedFanOut()
+{
+    constexpr int DEPTH = 18;
+    atomic<size_t> leaves { 0 };
+    function<void(int)> split;
+    auto start = chrono::steady_clock::now();
+    {
+        Pool pool(POOL_THREADS);
+        split = [&](int Depth)
+        {
+            if (Depth == 0)
+            {
+                leaves.fetch_add(1, memory_order_relaxed);
+                return;
+            }
+            pool.enqueue(split, Depth - 1);
+            pool.enqueue(split, Depth - 1);
+        };
+        pool.enqueue(split, DEPTH);
+        /* ThreadPool 停止后拒绝新任务，必须在析构前等待整棵树执行完 */
+        while (leaves.load() < (size_t(1) << DEPTH))
+            this_thread::yield();
+    }
+    auto elapsed = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+    /* 二叉树共 2^(DEPTH+1)-1 个任务 */
+    return elapsed / static_cast<double>((size_t(1) << (DEPTH + 1)) - 1);
+}
+}   // namespace
+
+int main()
+{
+    printf("pool threads: %zu, tasks per run: %zu\n", POOL_THREADS, TOTAL_TASKS);
+    printf("%-20s %10s %16s %16s\n", "bench", "producers", "mutex ns/task", "stealing ns/task");
+    for (size_t producers : { 1, 2, 4, 8 })
+    {
+        double mutexNs = producersContend<ThreadPool>(producers);
+        double stealingNs = producersContend<WorkStealingThreadPool>(producers);
+        printf("%-20s %10zu %16.1f %16.1f\n", "external-submit", producers, mutexNs, stealingNs);
+    }
+    printf("%-20s %10s %16.1f %16.1f\n", "nested-fan-out", "-", nestedFanOut<ThreadPool>(), nestedFanOut<WorkStealingThreadPool>());
+    return 0;
+}
@@ -0,0 +1,121 @@
+#include "Infra/TimerWheel.h"
+
+#include <chrono>
+#include <cstdio>
+#include <event2/event.h>
+#include <event2/event_struct.h>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace ToolKit;
+using namespace std;
+
+namespace
+{
+constexpr size_t TIMERS = 1000000;
+/* 以 100ms 为刻度时约 1000 秒，对应默认的连接超时 */
+constexpr uint64_t MAX_DELAY_TICKS = 10000;
+
+using Clock = chrono::steady_clock;
+
+double nsPerTimer(Clock::time_point Start)
+{
+    return chrono::duration<double, nano>(Clock::now() - Start).count() / static_cast<double>(TIMERS);
+}
+
+vector<uint64_t> randomDelays(uint32_t Seed)
+{
+    mt19937_64 random(Seed);
+    vector<uint64_t> delays(TIMERS);
+    for (auto& delay : delays)
+        delay = 1 + random() % MAX_DELAY_TICKS;
+    return delays;
+}
+
+/**
+ * @brief 时间轮：布防、全部重新布防（模拟持久连接上每个请求推迟一次超时）、取消一半、推进到全部到期
+ */
+void benchWheel(const vector<uint64_t>& Arm, const vector<uint64_t>& Rearm)
+{
+    TimerWheel wheel;
+    size_t fired = 0;
+    vector<WheelTimer> timers(TIMERS);
+    for (auto& timer : timers)
+        timer.setCallback([&fired] { fired++; });
+
+    auto start = Clock::now();
+    for (size_t i = 0; i < TIMERS; i++)
+        wheel.arm(timers[i], Arm[i]);
+    printf("%-10s %-10s %12.1f\n", "wheel", "arm", nsPerTimer(start));
+
+    start = Clock::now();
+    for (size_t i = 0; i < TIMERS; i++)
+        wheel.arm(timers[i], Rearm[i]);
+    printf("%-10s %-10s %12.1f\n", "wheel", "re-arm", nsPerTimer(start));
+
+    start = Clock::now();
+    for (size_t i = 0; i < TIMERS; i += 2)
+        wheel.cancel(timers[i]);
+    printf("%-10s %-10s %12.1f\n", "wheel", "cancel", nsPerTimer(start) * 2);
+
+    start = Clock::now();
+    wheel.advance(MAX_DELAY_TICKS);
+    printf("%-10s %-10s %12.1f   (fired %zu)\n", "wheel", "expire", nsPerTimer(start) * 2, fired);
+}
+
+/**
+ * @brief 同样的操作序列作用在 libevent 的最小堆定时器上，即每个连接各自设置 bufferevent 超时的开销
+ */
+void benchLibevent(const vector<uint64_t>& Arm, const vector<uint64_t>& Rearm)
+{
+    struct event_config* config = event_config_new();
+    event_config_set_flag(config, EVENT_BASE_FLAG_NOLOCK);
+    struct event_base* base = event_base_new_with_config(config);
+    event_config_free(config);
+
+    unique_ptr<struct event[]> events(new struct event[TIMERS]);
+    for (size_t i = 0; i < TIMERS; i++)
+        event_assign(&events[i], base, -1, 0, [](evutil_socket_t, short, void*) {}, nullptr);
+
+    auto toTimeval = [](uint64_t Ticks)
+    {
+        struct timeval tv { static_cast<time_t>(Ticks / 10), static_cast<suseconds_t>((Ticks % 10) * 100000) };
+        return tv;
+    };
+
+    auto start = Clock::now();
+    for (size_t i = 0; i < TIMERS; i++)
+    {
+        auto tv = toTimeval(Arm[i]);
+        event_add(&events[i], &tv);
+    }
+    printf("%-10s %-10s %12.1f\n", "libevent", "arm", nsPerTimer(start));
+
+    start = Clock::now();
+    for (size_t i = 0; i < TIMERS; i++)
+    {
+        auto tv = toTimeval(Rearm[i]);
+        event_add(&events[i], &tv);
+    }
+    printf("%-10s %-10s %12.1f\n", "libevent", "re-arm", nsPerTimer(start));
+
+    start = Clock::now();
+    for (size_t i = 0; i < TIMERS; i++)
+        event_del(&events[i]);
+    printf("%-10s %-10s %12.1f\n", "libevent", "cancel", nsPerTimer(start));
+
+    event_base_free(base);
+}
+}   // namespace
+
+int main()
+{
+    auto arm = randomDelays(1);
+    auto rearm = randomDelays(2);
+    printf("timers: %zu, delay: 1..%llu ticks\n", TIMERS, static_cast<unsigned long long>(MAX_DELAY_TICKS));
+    printf("%-10s %-10s %12s\n", "impl", "op", "ns/timer");
+    benchWheel(arm, rearm);
+    benchLibevent(arm, rearm);
+    return 0;
+}
@@ -0,0 +1,146 @@
+#include "ByteScanner.h"
+#include "WebSocket.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <event2/buffer.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace ToolKit;
+using namespace std;
+
+namespace
+{
+using Clock = chrono::steady_clock;
+
+volatile size_t benchSink = 0;
+
+const unsigned char MASK[4] { 0x9a, 0x0b, 0x5c, 0xe1 };
+
+/**
+ * @brief 逐字节异或的朴素实现，作为对照
+ */
+void maskBytewise(char* Data, size_t Len)
+{
+    for (size_t i = 0; i < Len; i++)
+        Data[i] = static_cast<char>(Data[i] ^ MASK[i & 3]);
+}
+
+template <class F>
+double bytesPerNs(size_t Size, F&& Func)
+{
+    string data(Size, 'x');
+    /* 每轮大约处理 256MB，小负载的轮数相应增多 */
+    const size_t rounds = max<size_t>(1, (256u << 20) / Size);
+    Func(data.data(), Size);
+    auto start = Clock::now();
+    for (size_t r = 0; r < rounds; r++)
+        Func(data.data(), Size);
+    auto elapsed = chrono::duration<double, nano>(Clock::now() - start).count();
+    benchSink = benchSink + static_cast<size_t>(data[0]);
+    return static_cast<double>(Size * rounds) / elapsed;
+}
+
+void runUnmask()
+{
+    printf("\nunmask throughput (GB/s)\n%-10s", "level");
+    const vector<size_t> sizes { 16, 125, 1024, 16384, 1 << 20 };
+    for (auto size : sizes)
+        printf(" %10zu", size);
+    printf("\n%-10s", "bytewise");
+    for (auto size : sizes)
+        printf(" %10.2f", bytesPerNs(size, maskBytewise));
+    printf("\n");
+
+    uint32_t key;
+    memcpy(&key, MASK, sizeof(key));
+    for (auto level : { SCAN_LEVEL::SCALAR, SCAN_LEVEL::SSE42, SCAN_LEVEL::AVX2 })
+    {
+        if (setScanLevel(level) != level)
+            continue;
+        printf("%-10s", scanLevelName(level));
+        for (auto size : sizes)
+            printf(" %10.2f", bytesPerNs(size, [key](char* Data, size_t Len) { applyMask(Data, Len, key); }));
+        printf("\n");
+    }
+    setScanLevel(supportedScanLevel());
+}
+
+string clientFrame(const string& Payload)
+{
+    string frame { static_cast<char>(0x82) };
+    if (Payload.size() < 126)
+        frame.push_back(static_cast<char>(0x80 | Payload.size()));
+    else
+    {
+        frame.push_back(static_cast<char>(0x80 | 126));
+        frame.push_back(static_cast<char>(Payload.size() >> 8));
+        frame.push_back(static_cast<char>(Payload.size()));
+    }
+    frame.append(reinterpret_cast<const char*>(MASK), 4);
+    for (size_t i = 0; i < Payload.size(); i++)
+        frame.push_back(static_cast<char>(Payload[i] ^ MASK[i & 3]));
+    return frame;
+}
+
+/**
+ * @brief 一次输入中到达大量小消息时会话的处理速率：帧头解析、去掩码与回调
+ */
+void runMessages()
+{
+    printf("\nmessage rate (single core, frames already in the input buffer)\n");
+    printf("%-10s %10s %14s %10s\n", "level", "payload", "messages/s", "MB/s");
+    HttpConnectionOptions options;
+    auto handler = make_shared<WebSocketHandler>();
+    handler->m_onMessage = [](WebSocketSession&, WS_OPCODE, string_view Data, bool Final)
+    { benchSink = benchSink + Data.size() + Final; };
+    HttpRequest request;
+    const size_t batch = 10000;
+
+    for (auto level : { SCAN_LEVEL::SCALAR, SCAN_LEVEL::SSE42, SCAN_LEVEL::AVX2 })
+    {
+        if (setScanLevel(level) != level)
+            continue;
+        for (size_t size : { 32, 256, 4096 })
+        {
+            string frames;
+            for (size_t i = 0; i < batch; i++)
+                frames += clientFrame(string(size, static_cast<char>('a' + i % 26)));
+
+            struct evbuffer* input = evbuffer_new();
+            struct evbuffer* output = evbuffer_new();
+            WebSocketSession session(options);
+            session.open(handler, request, output);
+            evbuffer_drain(output, evbuffer_get_length(output));
+
+            const size_t rounds = 50;
+            double elapsed = 0;
+            for (size_t r = 0; r < rounds; r++)
+            {
+                evbuffer_add(input, frames.data(), frames.size());
+                auto start = Clock::now();
+                session.onInput(input, output);
+                elapsed += chrono::duration<double>(Clock::now() - start).count();
+            }
+            const double messages = static_cast<double>(batch * rounds);
+            printf("%-10s %10zu %14.0f %10.1f\n", scanLevelName(level), size, messages / elapsed,
+                messages * static_cast<double>(size) / elapsed / 1e6);
+            session.reset();
+            evbuffer_free(input);
+            evbuffer_free(output);
+        }
+    }
+    setScanLevel(supportedScanLevel());
+}
+}   // namespace
+
+int main()
+{
+    printf("cpu supports: %s\n", scanLevelName(supportedScanLevel()));
+    runUnmask();
+    runMessages();
+    return 0;
+}
@@ -0,0 +1,104 @@
+#include "Infra/Arena.h"
+#include "catch2/catch.hpp"
+
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+using namespace ToolKit;
+
+namespace
+{
+/**
+ * @brief 统计向上游申请与归还次数的内存资源
+ */
+class CountingResource : public std::pmr::memory_resource
+{
+public:
+    size_t m_allocations { 0 };
+    size_t m_deallocations { 0 };
+
+protected:
+    void* do_allocate(size_t Bytes, size_t Alignment) override
+    {
+        m_allocations++;
+        return std::pmr::new_delete_resource()->allocate(Bytes, Alignment);
+    }
+    void do_deallocate(void* Ptr, size_t Bytes, size_t Alignment) override
+    {
+        m_deallocations++;
+        std::pmr::new_delete_resource()->deallocate(Ptr, Bytes, Alignment);
+    }
+    bool do_is_equal(const std::pmr::memory_resource& Other) const noexcept override { return this == &Other; }
+};
+}   // namespace
+
+TEST_CASE("Arena hands out aligned memory from retained blocks", "[Arena]")
+{
+    CountingResource upstream;
+    {
+        Arena arena(1024, &upstream);
+        REQUIRE(arena.blockCount() == 0);
+
+        auto* a = static_cast<char*>(arena.allocate(3, 1));
+        auto* b = arena.allocate(8, 8);
+        auto* c = arena.allocate(16, 64);
+        REQUIRE(reinterpret_cast<uintptr_t>(b) % 8 == 0);
+        REQUIRE(reinterpret_cast<uintptr_t>(c) % 64 == 0);
+        REQUIRE(static_cast<char*>(b) >= a + 3);
+        REQUIRE(upstream.m_allocations == 1);
+        REQUIRE(arena.used() == 27);
+
+        /* 填满第一块后向上游申请第二块 */
+        for (int i = 0; i < 8; i++)
+            (void)arena.allocate(200, 8);
+        REQUIRE(arena.blockCount() == 2);
+        REQUIRE(upstream.m_allocations == 2);
+
+        /* reset 后从第一块开始复用，已保留的块不再向上游申请 */
+        arena.reset();
+        REQUIRE(arena.used() == 0);
+        REQUIRE(arena.allocate(3, 1) == a);
+        for (int i = 0; i < 8; i++)
+            (void)arena.allocate(200, 8);
+        REQUIRE(upstream.m_allocations == 2);
+        REQUIRE(upstream.m_deallocations == 0);
+    }
+    REQUIRE(upstream.m_deallocations == 2);
+}
+
+TEST_CASE("Arena returns oversized allocations on reset", "[Arena]")
+{
+    CountingResource upstream;
+    Arena arena(512, &upstream);
+    (void)arena.allocate(16, 8);
+    void* big = arena.allocate(4096, 16);
+    REQUIRE(reinterpret_cast<uintptr_t>(big) % 16 == 0);
+    REQUIRE(arena.blockCount() == 1);
+    REQUIRE(upstream.m_allocations == 2);
+
+    arena.reset();
+    REQUIRE(upstream.m_deallocations == 1);
+    (void)arena.allocate(16, 8);
+    REQUIRE(upstream.m_allocations == 2);
+}
+
+TEST_CASE("Arena works as a memory resource for pmr containers", "[Arena]")
+{
+    CountingResource upstream;
+    Arena arena(Arena::DEFAULT_BLOCK_SIZE, &upstream);
+    for (int round = 0; round < 100; round++)
+    {
+        {
+            std::pmr::vector<int> numbers(&arena);
+            for (int i = 0; i < 100; i++)
+                numbers.push_back(i);
+            std::pmr::string text("a request scoped string that does not fit the small string buffer", &arena);
+            REQUIRE(numbers[99] == 99);
+            REQUIRE(text.size() > 40);
+        }
+        arena.reset();
+    }
+    REQUIRE(upstream.m_allocations == arena.blockCount());
+}
@@ -0,0 +1,124 @@
+#include "ByteScanner.h"
+#include "catch2/catch.hpp"
+
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace ToolKit;
+using namespace std;
+
+namespace
+{
+vector<SCAN_LEVEL> availableLevels()
+{
+    vector<SCAN_LEVEL> levels { SCAN_LEVEL::SCALAR };
+    if (supportedScanLevel() >= SCAN_LEVEL::SSE42)
+        levels.push_back(SCAN_LEVEL::SSE42);
+    if (supportedScanLevel() >= SCAN_LEVEL::AVX2)
+        levels.push_back(SCAN_LEVEL::AVX2);
+    return levels;
+}
+
+/**
+ * @brief 退出作用域时恢复原来的扫描级别
+ */
+struct ScanLevelGuard
+{
+    SCAN_LEVEL m_saved { currentScanLevel() };
+    ~ScanLevelGuard() { setScanLevel(m_saved); }
+};
+}   // namespace
+
+TEST_CASE("Every scan level finds the header terminator at any offset", "[ByteScanner]")
+{
+    ScanLevelGuard guard;
+    for (auto level : availableLevels())
+    {
+        REQUIRE(setScanLevel(level) == level);
+        for (size_t pos = 0; pos < 100; pos++)
+        {
+            string data(pos, 'a');
+            /* 干扰项：单独的 CRLF 与 "\n\r\n" */
+            if (pos > 4)
+                data[pos / 2] = '\n';
+            data += "\r\n\r\nbody";
+            INFO("level " << scanLevelName(level) << " pos " << pos);
+            REQUIRE(scanHeadTerminator(data.data(), data.size()) == static_cast<ptrdiff_t>(pos + 4));
+        }
+        string none = string(70, 'x') + "\r\n\r" + string(40, 'y') + "\n\r\n";
+        REQUIRE(scanHeadTerminator(none.data(), none.size()) == -1);
+    }
+}
+
+TEST_CASE("Every scan level agrees with the scalar kernels", "[ByteScanner]")
+{
+    ScanLevelGuard guard;
+    mt19937 rng(20211017);
+    const string alphabet = "abcXYZ019-_.!|~ :;\t\r\n\"(){}\x7f\x01\x80\xff/";
+    uniform_int_distribution<size_t> pick(0, alphabet.size() - 1);
+    uniform_int_distribution<size_t> length(0, 200);
+
+    for (int round = 0; round < 2000; round++)
+    {
+        string data(length(rng), 'a');
+        /* 以合法字符为主，随机插入少量分隔符，让停止位置分布在不同的块内 */
+        for (auto& c : data)
+            c = rng() % 8 == 0 ? alphabet[pick(rng)] : alphabet[pick(rng) % 10];
+
+        setScanLevel(SCAN_LEVEL::SCALAR);
+        auto token = scanTokenLength(data.data(), data.size());
+        auto value = scanFieldValueLength(data.data(), data.size());
+        auto visible = scanVisibleLength(data.data(), data.size());
+        auto terminator = scanHeadTerminator(data.data(), data.size());
+        for (auto level : availableLevels())
+        {
+            setScanLevel(level);
+            INFO("level " << scanLevelName(level) << " data " << data);
+            REQUIRE(scanTokenLength(data.data(), data.size()) == token);
+            REQUIRE(scanFieldValueLength(data.data(), data.size()) == value);
+            REQUIRE(scanVisibleLength(data.data(), data.size()) == visible);
+            REQUIRE(scanHeadTerminator(data.data(), data.size()) == terminator);
+        }
+    }
+}
+
+TEST_CASE("Token scan stops at the header colon", "[ByteScanner]")
+{
+    ScanLevelGuard guard;
+    string line = "X-Very-Long-Tracing-Header-Name|With~Specials:value";
+    for (auto level : availableLevels())
+    {
+        setScanLevel(level);
+        REQUIRE(scanTokenLength(line.data(), line.size()) == line.find(':'));
+    }
+}
+
+TEST_CASE("Every scan level applies the WebSocket mask byte by byte", "[ByteScanner]")
+{
+    ScanLevelGuard guard;
+    const unsigned char mask[4] { 0x37, 0xfa, 0x21, 0x3d };
+    uint32_t key;
+    memcpy(&key, mask, sizeof(key));
+    for (auto level : availableLevels())
+    {
+        setScanLevel(level);
+        /* 覆盖各级别的展开块、单个向量块与尾部字节，起始地址也不对齐 */
+        for (size_t length = 0; length < 300; length += 7)
+        {
+            for (size_t offset = 0; offset < 3; offset++)
+            {
+                string data(offset + length, '\0');
+                for (size_t i = 0; i < data.size(); i++)
+                    data[i] = static_cast<char>(i * 31 + 5);
+                string expected = data;
+                for (size_t i = 0; i < length; i++)
+                    expected[offset + i] = static_cast<char>(expected[offset + i] ^ mask[i & 3]);
+                applyMask(data.data() + offset, length, key);
+                INFO("level " << scanLevelName(level) << " length " << length << " offset " << offset);
+                REQUIRE(data == expected);
+            }
+        }
+    }
+}
@@ -0,0 +1,68 @@
+#include "Infra/ChaseLevDeque.h"
+#include "catch2/catch.hpp"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace ToolKit;
+
+TEST_CASE("Chase-Lev deque is LIFO for the owner and FIFO for thieves", "[ChaseLevDeque]")
+{
+    ChaseLevDeque<int> deque(2);
+    int items[5] = { 0, 1, 2, 3, 4 };
+    REQUIRE(deque.pop() == nullptr);
+    REQUIRE(deque.steal() == nullptr);
+
+    /* 超过初始容量时自动扩容 */
+    for (auto& item : items)
+        deque.push(&item);
+    REQUIRE(deque.steal() == &items[0]);
+    REQUIRE(deque.pop() == &items[4]);
+    REQUIRE(deque.steal() == &items[1]);
+    REQUIRE(deque.pop() == &items[3]);
+    REQUIRE(deque.pop() == &items[2]);
+    REQUIRE(deque.pop() == nullptr);
+    REQUIRE(deque.empty());
+}
+
+TEST_CASE("Chase-Lev deque hands out every item exactly once under stealing", "[ChaseLevDeque]")
+{
+    constexpr int ITEMS = 200000;
+    constexpr int THIEVES = 3;
+    ChaseLevDeque<int> deque(16);
+    std::vector<int> items(ITEMS);
+    std::vector<std::atomic<int>> taken(ITEMS);
+    for (auto& count : taken)
+        count = 0;
+
+    std::atomic<bool> done { false };
+    std::vector<std::thread> thieves;
+    for (int t = 0; t < THIEVES; t++)
+        thieves.emplace_back(
+            [&]
+            {
+                while (!done.load() || !deque.empty())
+                    if (int* item = deque.steal())
+                        taken[item - items.data()]++;
+            });
+
+    for (int i = 0; i < ITEMS; i++)
+    {
+        deque.push(&items[i]);
+        /* 所有者交替 push/pop，与窃取者在最后一个元素上竞争 */
+        if (i % 3 == 0)
+            if (int* item = deque.pop())
+                taken[item - items.data()]++;
+    }
+    while (int* item = deque.pop())
+        taken[item - items.data()]++;
+    done = true;
+    for (auto& thief : thieves)
+        thief.join();
+
+    bool exactlyOnce = true;
+    for (auto& count : taken)
+        exactlyOnce = exactlyOnce && count == 1;
+    REQUIRE(exactlyOnce);
+}
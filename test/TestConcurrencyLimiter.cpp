@@ -0,0 +1,146 @@
+#include "ConcurrencyLimiter.h"
+#include "catch2/catch.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace ToolKit;
+using namespace std;
+
+namespace
+{
+ConcurrencyLimiterOptions testOptions()
+{
+    ConcurrencyLimiterOptions options;
+    options.m_initialLimit = 20;
+    options.m_minLimit = 4;
+    options.m_maxLimit = 200;
+    options.m_window = chrono::milliseconds(100);
+    options.m_minSamples = 4;
+    return options;
+}
+
+/* 占满 Concurrency 个名额后以 Latency 全部归还，归还时间落在下一个窗口结束之后 */
+void runWindow(ConcurrencyLimiter& Limiter, uint32_t Concurrency, chrono::milliseconds Latency, chrono::steady_clock::time_point& Now)
+{
+    Now += chrono::milliseconds(101);
+    uint32_t acquired = 0;
+    while (acquired < Concurrency && Limiter.tryAcquire())
+        acquired++;
+    for (uint32_t i = 0; i < acquired; i++)
+        Limiter.release(Latency, Now);
+}
+}   // namespace
+
+TEST_CASE("Admission stops at the limit and resumes after a release", "[ConcurrencyLimiter]")
+{
+    auto options = testOptions();
+    options.m_initialLimit = 8;
+    ConcurrencyLimiter limiter(options);
+
+    for (int i = 0; i < 8; i++)
+        REQUIRE(limiter.tryAcquire());
+    REQUIRE_FALSE(limiter.tryAcquire());
+    REQUIRE(limiter.inflight() == 8);
+
+    limiter.release(chrono::milliseconds(1));
+    REQUIRE(limiter.inflight() == 7);
+    REQUIRE(limiter.tryAcquire());
+
+    auto stats = limiter.stats();
+    REQUIRE(stats.m_admitted == 9);
+    REQUIRE(stats.m_shed == 1);
+    REQUIRE(stats.m_limit == 8);
+}
+
+TEST_CASE("The limit follows observed latency", "[ConcurrencyLimiter]")
+{
+    ConcurrencyLimiter limiter(testOptions());
+    auto now = chrono::steady_clock::now();
+
+    SECTION("Steady latency under full load lets the limit grow up to the maximum")
+    {
+        uint32_t previous = limiter.limit();
+        for (int i = 0; i < 20; i++)
+        {
+            runWindow(limiter, limiter.limit(), chrono::milliseconds(1), now);
+            REQUIRE(limiter.limit() >= previous);
+            previous = limiter.limit();
+        }
+        REQUIRE(limiter.limit() > 20);
+        for (int i = 0; i < 500; i++)
+            runWindow(limiter, limiter.limit(), chrono::milliseconds(1), now);
+        REQUIRE(limiter.limit() == 200);
+        REQUIRE(limiter.stats().m_baseline == chrono::milliseconds(1));
+    }
+
+    SECTION("Queueing latency shrinks the limit but never below the minimum")
+    {
+        for (int i = 0; i < 5; i++)
+            runWindow(limiter, limiter.limit(), chrono::milliseconds(1), now);
+        const uint32_t before = limiter.limit();
+        for (int i = 0; i < 10; i++)
+            runWindow(limiter, limiter.limit(), chrono::milliseconds(50), now);
+        REQUIRE(limiter.limit() < before);
+        for (int i = 0; i < 50; i++)
+        {
+            runWindow(limiter, limiter.limit(), chrono::milliseconds(50), now);
+            REQUIRE(limiter.limit() >= 4);
+        }
+        REQUIRE(limiter.stats().m_latency == chrono::milliseconds(50));
+    }
+
+    SECTION("Light load does not move the limit")
+    {
+        for (int i = 0; i < 20; i++)
+            runWindow(limiter, 5, chrono::milliseconds(i + 1), now);
+        REQUIRE(limiter.limit() == 20);
+    }
+
+    SECTION("A window needs enough samples before it closes")
+    {
+        runWindow(limiter, 3, chrono::milliseconds(1), now);
+        REQUIRE(limiter.stats().m_latency.count() == 0);
+        runWindow(limiter, 1, chrono::milliseconds(5), now);
+        REQUIRE(limiter.stats().m_latency == chrono::microseconds(2000));
+    }
+}
+
+TEST_CASE("Concurrent admission never exceeds the limit", "[ConcurrencyLimiter]")
+{
+    auto options = testOptions();
+    options.m_window = chrono::milliseconds(1);
+    ConcurrencyLimiter limiter(options);
+    constexpr int THREADS = 4;
+    constexpr int ROUNDS = 20000;
+    atomic<uint32_t> inflight { 0 };
+    atomic<uint32_t> peak { 0 };
+    vector<thread> workers;
+    for (int t = 0; t < THREADS; t++)
+        workers.emplace_back(
+            [&]
+            {
+                for (int i = 0; i < ROUNDS; i++)
+                {
+                    if (!limiter.tryAcquire())
+                        continue;
+                    auto current = ++inflight;
+                    auto seen = peak.load();
+                    while (current > seen && !peak.compare_exchange_weak(seen, current))
+                        ;
+                    --inflight;
+                    limiter.release(chrono::microseconds(10 + i % 50));
+                }
+            });
+    for (auto& worker : workers)
+        worker.join();
+
+    auto stats = limiter.stats();
+    REQUIRE(stats.m_inflight == 0);
+    REQUIRE(stats.m_admitted + stats.m_shed == THREADS * ROUNDS);
+    REQUIRE(peak.load() <= 200);
+    REQUIRE(stats.m_limit >= 4);
+    REQUIRE(stats.m_limit <= 200);
+}
@@ -0,0 +1,74 @@
+#include "Infra/CpuAffinity.h"
+#include "Infra/ThreadPool.h"
+#include "Infra/WorkStealingThreadPool.h"
+#include "catch2/catch.hpp"
+
+#include <future>
+#include <sched.h>
+#include <vector>
+
+using namespace ToolKit;
+
+namespace
+{
+/* 测试进程允许运行的最后一个 CPU，容器中不一定从 0 开始 */
+int lastAllowedCpu()
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    REQUIRE(sched_getaffinity(0, sizeof(set), &set) == 0);
+    int last = -1;
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+    {
+        if (CPU_ISSET(cpu, &set))
+            last = cpu;
+    }
+    return last;
+}
+}   // namespace
+
+TEST_CASE("CPU lists parse ranges and reject malformed input", "[CpuAffinity]")
+{
+    REQUIRE(parseCpuList("") == std::vector<int> {});
+    REQUIRE(parseCpuList("3") == std::vector<int> { 3 });
+    REQUIRE(parseCpuList("0-3,8,10-11") == std::vector<int> { 0, 1, 2, 3, 8, 10, 11 });
+    /* 保持书写顺序，Reactor 按这个顺序依次取 CPU */
+    REQUIRE(parseCpuList("6,2-3") == std::vector<int> { 6, 2, 3 });
+    REQUIRE(parseCpuList("3-1").empty());
+    REQUIRE(parseCpuList("1,,2").empty());
+    REQUIRE(parseCpuList("a").empty());
+    REQUIRE(parseCpuList("-1").empty());
+    REQUIRE(parseCpuList("1-").empty());
+    REQUIRE(parseCpuList("2 ").empty());
+}
+
+TEMPLATE_TEST_CASE("Thread pools keep their workers on the configured CPUs", "[CpuAffinity]", ThreadPool, WorkStealingThreadPool)
+{
+    int cpu = lastAllowedCpu();
+    REQUIRE(cpu >= 0);
+    TestType pool(2, { cpu });
+    std::vector<std::future<int>> results;
+    for (int i = 0; i < 16; i++)
+        results.emplace_back(pool.enqueue([] { return sched_getcpu(); }));
+    for (auto& result : results)
+        REQUIRE(result.get() == cpu);
+}
+
+TEST_CASE("Memory node scope restores the previous policy", "[CpuAffinity]")
+{
+    int before = -1;
+    REQUIRE(syscall(SYS_get_mempolicy, &before, nullptr, 0UL, nullptr, 0UL) == 0);
+    {
+        /* 非 NUMA 环境中 cpuNode 可能返回 -1，此时作用域不做任何事 */
+        MemoryNodeScope scope(cpuNode(lastAllowedCpu()));
+        int inside = -1;
+        REQUIRE(syscall(SYS_get_mempolicy, &inside, nullptr, 0UL, nullptr, 0UL) == 0);
+        REQUIRE(inside == (scope.active() ? MPOL_PREFERRED : before));
+    }
+    int after = -1;
+    REQUIRE(syscall(SYS_get_mempolicy, &after, nullptr, 0UL, nullptr, 0UL) == 0);
+    REQUIRE(after == before);
+
+    MemoryNodeScope none(-1);
+    REQUIRE_FALSE(none.active());
+}
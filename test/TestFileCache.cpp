@@ -0,0 +1,223 @@
+#include "FileCache.h"
+#include "catch2/catch.hpp"
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <event2/buffer.h>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <thread>
+
+using namespace ToolKit;
+using namespace std;
+
+namespace
+{
+struct TempDirectory
+{
+    TempDirectory()
+    {
+        char pattern[] = "/tmp/FileCacheTestXXXXXX";
+        m_path = mkdtemp(pattern);
+    }
+    ~TempDirectory() { filesystem::remove_all(m_path); }
+
+    string write(const string& Name, const string& Content)
+    {
+        ofstream(m_path + "/" + Name) << Content;
+        return m_path + "/" + Name;
+    }
+
+    string m_path;
+};
+
+/* inotify 事件由后台线程异步处理，失效需要等待 */
+bool eventually(const function<bool()>& Condition)
+{
+    for (int i = 0; i < 200; i++)
+    {
+        if (Condition())
+            return true;
+        this_thread::sleep_for(chrono::milliseconds(10));
+    }
+    return false;
+}
+
+string contentOf(const CachedFile& File)
+{
+    struct evbuffer* buffer = evbuffer_new();
+    evbuffer_add_file_segment(buffer, File.m_segment.get(), 0, File.m_size);
+    size_t len = evbuffer_get_length(buffer);
+    string text(reinterpret_cast<const char*>(evbuffer_pullup(buffer, -1)), len);
+    evbuffer_free(buffer);
+    return text;
+}
+}   // namespace
+
+TEST_CASE("Repeated lookups hit the cache", "[FileCache]")
+{
+    TempDirectory dir;
+    auto path = dir.write("a.css", "body{}");
+    FileCache cache(16, 4);
+    REQUIRE(cache.enabled());
+
+    int error = 0;
+    auto first = cache.open(path, error);
+    REQUIRE(first != nullptr);
+    REQUIRE(first->m_size == 6);
+    REQUIRE(first->m_mimeType == "text/css; charset=utf-8");
+    REQUIRE_FALSE(first->m_etag.empty());
+    REQUIRE_FALSE(first->m_lastModified.empty());
+    REQUIRE(contentOf(*first) == "body{}");
+
+    auto second = cache.open(path, error);
+    REQUIRE(second == first);
+    auto stats = cache.stats();
+    REQUIRE(stats.m_hits == 1);
+    REQUIRE(stats.m_misses == 1);
+    REQUIRE(stats.m_entries == 1);
+
+    REQUIRE(cache.open(dir.m_path + "/missing", error) == nullptr);
+    REQUIRE(error == ENOENT);
+    REQUIRE(cache.open(dir.m_path, error) == nullptr);
+    REQUIRE(cache.stats().m_entries == 1);
+}
+
+TEST_CASE("Changes on disk invalidate cached entries", "[FileCache]")
+{
+    TempDirectory dir;
+    auto path = dir.write("page.html", "v1");
+    FileCache cache(16, 4);
+    int error = 0;
+    auto original = cache.open(path, error);
+    REQUIRE(original != nullptr);
+
+    SECTION("In-place modification")
+    {
+        dir.write("page.html", "version2");
+        REQUIRE(eventually([&] { return cache.open(path, error)->m_size == 8; }));
+        REQUIRE(contentOf(*cache.open(path, error)) == "version2");
+    }
+
+    SECTION("Atomic replacement by rename")
+    {
+        auto staged = dir.write(".page.tmp", "replaced");
+        REQUIRE(rename(staged.c_str(), path.c_str()) == 0);
+        REQUIRE(eventually([&] { return contentOf(*cache.open(path, error)) == "replaced"; }));
+    }
+
+    SECTION("Deletion")
+    {
+        filesystem::remove(path);
+        REQUIRE(eventually([&] { return cache.open(path, error) == nullptr; }));
+        REQUIRE(error == ENOENT);
+    }
+
+    REQUIRE(cache.stats().m_invalidations >= 1);
+    /* 已经取出的旧条目仍能读到打开时的内容 */
+    REQUIRE(original->m_size == 2);
+}
+
+TEST_CASE("Removing the watched directory clears the cache", "[FileCache]")
+{
+    TempDirectory dir;
+    filesystem::create_directory(dir.m_path + "/sub");
+    auto path = dir.write("sub/x.txt", "x");
+    FileCache cache(16, 4);
+    int error = 0;
+    REQUIRE(cache.open(path, error) != nullptr);
+
+    filesystem::rename(dir.m_path + "/sub", dir.m_path + "/moved");
+    REQUIRE(eventually([&] { return cache.stats().m_entries == 0; }));
+    REQUIRE(cache.open(path, error) == nullptr);
+}
+
+TEST_CASE("The LRU bound evicts the least recently used files", "[FileCache]")
+{
+    TempDirectory dir;
+    FileCache cache(4, 1);
+    int error = 0;
+    vector<string> paths;
+    for (int i = 0; i < 6; i++)
+        paths.push_back(dir.write("f" + to_string(i), string(static_cast<size_t>(i + 1), 'x')));
+
+    auto oldest = cache.open(paths[0], error);
+    for (int i = 1; i < 4; i++)
+        cache.open(paths[i], error);
+    /* 访问 f0 使其成为最近使用，接下来淘汰 f1、f2 */
+    cache.open(paths[0], error);
+    cache.open(paths[4], error);
+    cache.open(paths[5], error);
+
+    auto stats = cache.stats();
+    REQUIRE(stats.m_entries == 4);
+    REQUIRE(stats.m_evictions == 2);
+
+    auto hits = stats.m_hits;
+    cache.open(paths[0], error);
+    REQUIRE(cache.stats().m_hits == hits + 1);
+    cache.open(paths[1], error);
+    REQUIRE(cache.stats().m_hits == hits + 1);
+
+    /* 被淘汰的条目仍在使用时文件保持打开 */
+    REQUIRE(contentOf(*oldest) == "x");
+}
+
+TEST_CASE("A zero sized cache opens files on every lookup", "[FileCache]")
+{
+    TempDirectory dir;
+    auto path = dir.write("a.txt", "abc");
+    FileCache cache(0);
+    REQUIRE_FALSE(cache.enabled());
+    int error = 0;
+    auto first = cache.open(path, error);
+    auto second = cache.open(path, error);
+    REQUIRE(first != nullptr);
+    REQUIRE(first != second);
+    REQUIRE(contentOf(*second) == "abc");
+    auto stats = cache.stats();
+    REQUIRE(stats.m_hits == 0);
+    REQUIRE(stats.m_misses == 2);
+    REQUIRE(stats.m_entries == 0);
+}
+
+TEST_CASE("Concurrent lookups share entries", "[FileCache]")
+{
+    TempDirectory dir;
+    vector<string> paths;
+    for (int i = 0; i < 32; i++)
+        paths.push_back(dir.write("c" + to_string(i), to_string(i)));
+    FileCache cache(16, 4);
+
+    /* Catch 的断言不是线程安全的，工作线程只记录错误次数 */
+    atomic<int> wrong { 0 };
+    vector<thread> threads;
+    for (int t = 0; t < 4; t++)
+    {
+        threads.emplace_back(
+            [&]
+            {
+                int error = 0;
+                for (int round = 0; round < 200; round++)
+                {
+                    for (size_t i = 0; i < paths.size(); i++)
+                    {
+                        auto file = cache.open(paths[i], error);
+                        if (file == nullptr || file->m_size != static_cast<off_t>(to_string(i).size()))
+                            wrong++;
+                    }
+                }
+            });
+    }
+    for (auto& thread : threads)
+        thread.join();
+    REQUIRE(wrong == 0);
+
+    auto stats = cache.stats();
+    REQUIRE(stats.m_hits + stats.m_misses == 4 * 200 * 32);
+    REQUIRE(stats.m_entries <= 16);
+}
@@ -0,0 +1,232 @@
+#include "Hpack.h"
+#include "catch2/catch.hpp"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace ToolKit;
+using namespace std;
+
+namespace
+{
+string fromHex(const string& Hex)
+{
+    string out;
+    for (size_t i = 0; i + 1 < Hex.size();)
+    {
+        if (Hex[i] == ' ')
+        {
+            i++;
+            continue;
+        }
+        out.push_back(static_cast<char>(stoi(Hex.substr(i, 2), nullptr, 16)));
+        i += 2;
+    }
+    return out;
+}
+
+using FieldList = vector<pair<string, string>>;
+
+FieldList decodeBlock(HpackDecoder& Decoder, const string& Block)
+{
+    string storage;
+    vector<HpackField> fields;
+    REQUIRE(Decoder.decode(Block, storage, fields));
+    FieldList out;
+    for (auto& field : fields)
+    {
+        out.emplace_back(storage.substr(field.m_nameOffset, field.m_nameLength),
+            storage.substr(field.m_valueOffset, field.m_valueLength));
+    }
+    return out;
+}
+}   // namespace
+
+TEST_CASE("Huffman encoding matches RFC 7541 examples", "[Hpack]")
+{
+    string encoded;
+    huffmanEncode("www.example.com", encoded);
+    REQUIRE(encoded == fromHex("f1e3c2e5f23a6ba0ab90f4ff"));
+    REQUIRE(huffmanEncodedLength("www.example.com") == encoded.size());
+
+    string decoded;
+    REQUIRE(huffmanDecode(encoded, decoded));
+    REQUIRE(decoded == "www.example.com");
+
+    decoded.clear();
+    REQUIRE(huffmanDecode(fromHex("a8eb10649cbf"), decoded));
+    REQUIRE(decoded == "no-cache");
+
+    /* 恰好在字节边界结束、没有填充的编码，最后一个码字也要解出来 */
+    encoded.clear();
+    huffmanEncode("one", encoded);
+    REQUIRE(encoded == fromHex("3d45"));
+    decoded.clear();
+    REQUIRE(huffmanDecode(encoded, decoded));
+    REQUIRE(decoded == "one");
+}
+
+TEST_CASE("Huffman round trip covers every byte value", "[Hpack]")
+{
+    string text;
+    for (int i = 0; i < 256; i++)
+        text.push_back(static_cast<char>(i));
+    string encoded;
+    huffmanEncode(text, encoded);
+    string decoded;
+    REQUIRE(huffmanDecode(encoded, decoded));
+    REQUIRE(decoded == text);
+}
+
+TEST_CASE("Huffman decoding rejects invalid padding", "[Hpack]")
+{
+    string decoded;
+    /* 'a' 为 00011，填充必须是全 1 */
+    REQUIRE_FALSE(huffmanDecode(fromHex("18"), decoded));
+    /* 一整个字节的填充超过 7 位 */
+    decoded.clear();
+    REQUIRE_FALSE(huffmanDecode(fromHex("1fff"), decoded));
+    /* 显式编码的 EOS */
+    decoded.clear();
+    REQUIRE_FALSE(huffmanDecode(fromHex("ffffffff"), decoded));
+}
+
+TEST_CASE("Decoder handles RFC 7541 request examples without Huffman", "[Hpack]")
+{
+    HpackDecoder decoder;
+    REQUIRE(decodeBlock(decoder, fromHex("828684410f7777772e6578616d706c652e636f6d"))
+        == FieldList { { ":method", "GET" }, { ":scheme", "http" }, { ":path", "/" }, { ":authority", "www.example.com" } });
+    REQUIRE(decodeBlock(decoder, fromHex("828684be58086e6f2d6361636865"))
+        == FieldList { { ":method", "GET" }, { ":scheme", "http" }, { ":path", "/" }, { ":authority", "www.example.com" },
+            { "cache-control", "no-cache" } });
+    REQUIRE(decodeBlock(decoder, fromHex("828785bf400a637573746f6d2d6b65790c637573746f6d2d76616c7565"))
+        == FieldList { { ":method", "GET" }, { ":scheme", "https" }, { ":path", "/index.html" },
+            { ":authority", "www.example.com" }, { "custom-key", "custom-value" } });
+}
+
+TEST_CASE("Decoder handles RFC 7541 request examples with Huffman", "[Hpack]")
+{
+    HpackDecoder decoder;
+    REQUIRE(decodeBlock(decoder, fromHex("828684418cf1e3c2e5f23a6ba0ab90f4ff"))
+        == FieldList { { ":method", "GET" }, { ":scheme", "http" }, { ":path", "/" }, { ":authority", "www.example.com" } });
+    REQUIRE(decodeBlock(decoder, fromHex("828684be5886a8eb10649cbf"))
+        == FieldList { { ":method", "GET" }, { ":scheme", "http" }, { ":path", "/" }, { ":authority", "www.example.com" },
+            { "cache-control", "no-cache" } });
+    REQUIRE(decodeBlock(decoder, fromHex("828785bf408825a849e95ba97d7f8925a849e95bb8e8b4bf"))
+        == FieldList { { ":method", "GET" }, { ":scheme", "https" }, { ":path", "/index.html" },
+            { ":authority", "www.example.com" }, { "custom-key", "custom-value" } });
+    /* 三个字段的条目大小：每个字段名称加值再加 32 */
+    REQUIRE(decoder.lastBlockSize() == (7 + 3 + 32) + (7 + 5 + 32) + (5 + 11 + 32) + (10 + 15 + 32) + (10 + 12 + 32));
+}
+
+TEST_CASE("Decoder rejects malformed blocks", "[Hpack]")
+{
+    string storage;
+    vector<HpackField> fields;
+    /* 索引 0 */
+    REQUIRE_FALSE(HpackDecoder().decode(fromHex("80"), storage, fields));
+    /* 超出静态表且动态表为空 */
+    REQUIRE_FALSE(HpackDecoder().decode(fromHex("be"), storage, fields));
+    /* 字面量长度超出块 */
+    REQUIRE_FALSE(HpackDecoder().decode(fromHex("410f7777"), storage, fields));
+    /* 表大小更新超过通告的上限 */
+    REQUIRE_FALSE(HpackDecoder(4096).decode(fromHex("3fe21f"), storage, fields));
+    /* 表大小更新只能出现在块开头 */
+    REQUIRE_FALSE(HpackDecoder().decode(fromHex("823f09"), storage, fields));
+}
+
+TEST_CASE("Decoder stops expanding a block once it exceeds the size limit", "[Hpack]")
+{
+    HpackDecoder decoder;
+    /* 一个约 4KB 的增量索引字段，随后上万次 1 字节的引用，最后再插入一个表项 */
+    string block = fromHex("40 06") + "x-bomb" + fromHex("7f a1 1e") + string(4000, 'a');
+    block += string(10000, '\xbe');
+    block += fromHex("40 01") + "y" + fromHex("01") + "z";
+    string storage = "kept";
+    vector<HpackField> fields(1);
+    REQUIRE(decoder.decode(block, storage, fields, 1024));
+    REQUIRE(decoder.lastBlockSize() > 1024);
+    /* 调用前已有的内容保留，本块的字段全部撤回 */
+    REQUIRE(storage == "kept");
+    REQUIRE(fields.size() == 1);
+    REQUIRE(storage.capacity() < 16 * 1024);
+
+    /* 超限后的增量索引字段仍然进入动态表 */
+    auto next = decodeBlock(decoder, fromHex("be bf"));
+    REQUIRE(next == FieldList { { "y", "z" }, { "x-bomb", string(4000, 'a') } });
+}
+
+TEST_CASE("Dynamic table evicts the oldest entries", "[Hpack]")
+{
+    HpackDynamicTable table(100);
+    table.add("a", "1");
+    table.add("b", "2");
+    table.add("c", "3");
+    /* 每条 34 字节，只能容纳两条 */
+    REQUIRE(table.count() == 2);
+    REQUIRE(table.at(0).m_name == "c");
+    REQUIRE(table.at(1).m_name == "b");
+    bool exact = false;
+    REQUIRE(table.find("b", "x", exact) == 1);
+    REQUIRE_FALSE(exact);
+    REQUIRE(table.find("a", "1", exact) == -1);
+    table.setMaxSize(40);
+    REQUIRE(table.count() == 1);
+    table.add("long-name", string(100, 'x'));
+    REQUIRE(table.count() == 0);
+    REQUIRE(table.size() == 0);
+}
+
+TEST_CASE("Encoder output decodes back and reuses the dynamic table", "[Hpack]")
+{
+    HpackEncoder encoder;
+    HpackDecoder decoder;
+    const FieldList headers { { "content-type", "text/html; charset=utf-8" }, { "server", "CppHttpServer" },
+        { "content-length", "1234" }, { "x-custom", "value" } };
+    size_t firstSize = 0;
+    for (int round = 0; round < 3; round++)
+    {
+        string block;
+        encoder.beginBlock(block);
+        encoder.encodeStatus(round == 0 ? 200 : 404, block);
+        for (auto& [name, value] : headers)
+            encoder.encode(name, value, block);
+        FieldList expected { { ":status", round == 0 ? "200" : "404" } };
+        expected.insert(expected.end(), headers.begin(), headers.end());
+        REQUIRE(decodeBlock(decoder, block) == expected);
+        if (round == 0)
+            firstSize = block.size();
+        else
+            REQUIRE(block.size() < firstSize / 2);
+    }
+}
+
+TEST_CASE("Encoder signals table size changes to the decoder", "[Hpack]")
+{
+    HpackEncoder encoder;
+    HpackDecoder decoder;
+    string block;
+    encoder.beginBlock(block);
+    encoder.encode("x-first", "one", block);
+    decodeBlock(decoder, block);
+
+    /* 先缩到 0 再恢复，块开头需要依次带上最小值与最终值，旧条目因此失效 */
+    encoder.setMaxTableSize(0);
+    encoder.setMaxTableSize(4096);
+    block.clear();
+    encoder.beginBlock(block);
+    encoder.encode("x-first", "one", block);
+    REQUIRE(static_cast<uint8_t>(block[0]) == 0x20);
+    REQUIRE(decodeBlock(decoder, block) == FieldList { { "x-first", "one" } });
+
+    /* 对端禁用动态表后编码端不再加入条目 */
+    encoder.setMaxTableSize(0);
+    for (int i = 0; i < 2; i++)
+    {
+        block.clear();
+        encoder.beginBlock(block);
+        encoder.encode("x-second", "two", block);
+        REQUIRE(decodeBlock(decoder, block) == FieldList { { "x-second", "two" } });
+    }
+}
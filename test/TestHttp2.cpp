@@ -0,0 +1,631 @@
+#include "Http2Session.h"
+#include "HttpConnection.h"
+#include "catch2/catch.hpp"
+
+#include <event2/buffer.h>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace ToolKit;
+using namespace std;
+
+namespace
+{
+using FieldList = vector<pair<string, string>>;
+
+struct Frame
+{
+    HTTP2_FRAME m_type;
+    uint8_t m_flags;
+    uint32_t m_stream;
+    string m_payload;
+    /* HEADERS 帧解码后的字段 */
+    FieldList m_fields;
+};
+
+string be32(uint32_t Value)
+{
+    return { static_cast<char>(Value >> 24), static_cast<char>(Value >> 16), static_cast<char>(Value >> 8),
+        static_cast<char>(Value) };
+}
+
+uint32_t readBe32(const string& Data, size_t Offset = 0)
+{
+    auto byte = [&Data](size_t I) { return static_cast<uint32_t>(static_cast<uint8_t>(Data[I])); };
+    return (byte(Offset) << 24) | (byte(Offset + 1) << 16) | (byte(Offset + 2) << 8) | byte(Offset + 3);
+}
+
+string frame(HTTP2_FRAME Type, uint8_t Flags, uint32_t StreamId, const string& Payload = string())
+{
+    string out;
+    out.push_back(static_cast<char>(Payload.size() >> 16));
+    out.push_back(static_cast<char>(Payload.size() >> 8));
+    out.push_back(static_cast<char>(Payload.size()));
+    out.push_back(static_cast<char>(Type));
+    out.push_back(static_cast<char>(Flags));
+    out += be32(StreamId);
+    return out + Payload;
+}
+
+string setting(HTTP2_SETTING Id, uint32_t Value)
+{
+    return string { static_cast<char>(static_cast<uint16_t>(Id) >> 8), static_cast<char>(Id) } + be32(Value);
+}
+
+/**
+ * @brief 测试侧的最小 HTTP/2 客户端：构造请求帧，解析服务端输出并解码响应首部
+ */
+class TestPeer
+{
+public:
+    string request(uint32_t StreamId, const string& Method, const string& Path, bool EndStream, FieldList Extra = {})
+    {
+        string block;
+        m_encoder.beginBlock(block);
+        m_encoder.encode(":method", Method, block);
+        m_encoder.encode(":scheme", "http", block);
+        m_encoder.encode(":path", Path, block);
+        m_encoder.encode(":authority", "test", block);
+        for (auto& [name, value] : Extra)
+            m_encoder.encode(name, value, block);
+        return frame(HTTP2_FRAME::HEADERS, HTTP2_FLAG_END_HEADERS | (EndStream ? HTTP2_FLAG_END_STREAM : 0), StreamId, block);
+    }
+
+    vector<Frame> read(struct evbuffer* Output)
+    {
+        size_t length = evbuffer_get_length(Output);
+        string data(reinterpret_cast<const char*>(evbuffer_pullup(Output, -1)), length);
+        evbuffer_drain(Output, length);
+        vector<Frame> frames;
+        size_t pos = 0;
+        while (pos + HTTP2_FRAME_HEADER_SIZE <= data.size())
+        {
+            size_t payload = (static_cast<size_t>(static_cast<uint8_t>(data[pos])) << 16)
+                | (static_cast<size_t>(static_cast<uint8_t>(data[pos + 1])) << 8) | static_cast<uint8_t>(data[pos + 2]);
+            REQUIRE(pos + HTTP2_FRAME_HEADER_SIZE + payload <= data.size());
+            Frame item { static_cast<HTTP2_FRAME>(data[pos + 3]), static_cast<uint8_t>(data[pos + 4]),
+                readBe32(data, pos + 5) & HTTP2_MAX_WINDOW, data.substr(pos + HTTP2_FRAME_HEADER_SIZE, payload), {} };
+            if (item.m_type == HTTP2_FRAME::HEADERS)
+            {
+                string storage;
+                vector<HpackField> fields;
+                REQUIRE(m_decoder.decode(item.m_payload, storage, fields));
+                for (auto& field : fields)
+                {
+                    item.m_fields.emplace_back(storage.substr(field.m_nameOffset, field.m_nameLength),
+                        storage.substr(field.m_valueOffset, field.m_valueLength));
+                }
+            }
+            frames.push_back(std::move(item));
+            pos += HTTP2_FRAME_HEADER_SIZE + payload;
+        }
+        REQUIRE(pos == data.size());
+        return frames;
+    }
+
+private:
+    HpackEncoder m_encoder;
+    HpackDecoder m_decoder;
+};
+
+string fieldOf(const Frame& Item, const string& Name)
+{
+    for (auto& [name, value] : Item.m_fields)
+    {
+        if (name == Name)
+            return value;
+    }
+    return string();
+}
+
+const Frame* findFrame(const vector<Frame>& Frames, HTTP2_FRAME Type, uint32_t StreamId)
+{
+    for (auto& item : Frames)
+    {
+        if (item.m_type == Type && item.m_stream == StreamId)
+            return &item;
+    }
+    return nullptr;
+}
+
+/**
+ * @brief 拼接一个流上所有 DATA 帧的负载，Ended 表示最后一帧带 END_STREAM
+ */
+string bodyOf(const vector<Frame>& Frames, uint32_t StreamId, bool& Ended)
+{
+    string body;
+    Ended = false;
+    for (auto& item : Frames)
+    {
+        if (item.m_type != HTTP2_FRAME::DATA || item.m_stream != StreamId)
+            continue;
+        REQUIRE_FALSE(Ended);
+        body += item.m_payload;
+        Ended = (item.m_flags & HTTP2_FLAG_END_STREAM) != 0;
+    }
+    return body;
+}
+
+HTTP2_ERROR goAwayError(const vector<Frame>& Frames)
+{
+    auto* goAway = findFrame(Frames, HTTP2_FRAME::GOAWAY, 0);
+    REQUIRE(goAway != nullptr);
+    return static_cast<HTTP2_ERROR>(readBe32(goAway->m_payload, 4));
+}
+
+void feed(struct evbuffer* Input, const string& Data)
+{
+    evbuffer_add(Input, Data.data(), Data.size());
+}
+
+/* 把请求方法、路径与请求体作为响应体返回，路径为 /big 时返回 100000 字节 */
+const HttpRequestHandler ECHO_HANDLER = [](const HttpRequest& Request, HttpResponse& Response)
+{
+    if (Request.m_path == "/big")
+    {
+        string big(100000, 'x');
+        evbuffer_add(Response.body(), big.data(), big.size());
+        return;
+    }
+    string text = string(Request.m_method) + " " + string(Request.m_path) + " " + string(Request.m_body);
+    evbuffer_add(Response.body(), text.data(), text.size());
+    Response.addHeader("Content-Type", "text/plain");
+};
+const HttpHandler ECHO { ECHO_HANDLER };
+const HttpHandlerResolver ECHO_RESOLVER = [](const HttpRequest&) { return &ECHO; };
+
+/* 插入一个 100 字节的表项后引用它 References 次，不带伪首部 */
+string bombBlock(size_t References)
+{
+    return string("\x40\x06x-bomb\x64", 9) + string(100, 'a') + string(References, '\xbe');
+}
+
+const string CLIENT_START = string(HTTP2_PREFACE) + frame(HTTP2_FRAME::SETTINGS, 0, 0);
+}   // namespace
+
+TEST_CASE("Prior knowledge connections multiplex requests", "[Http2]")
+{
+    HttpConnectionOptions options;
+    HttpConnection connection(options, ECHO_RESOLVER);
+    TestPeer peer;
+    struct evbuffer* input = evbuffer_new();
+    struct evbuffer* output = evbuffer_new();
+
+    /* 连接前言分两次到达，凑齐之前不做任何输出 */
+    feed(input, CLIENT_START.substr(0, 10));
+    REQUIRE(connection.onInput(input, output) == CONN_ACTION::KEEP_READING);
+    REQUIRE(evbuffer_get_length(output) == 0);
+
+    /* 同一个编码器上的首部块必须按发送顺序生成，逐个写入而不是在一个表达式里拼接 */
+    feed(input, CLIENT_START.substr(10));
+    feed(input, peer.request(1, "GET", "/a", true));
+    feed(input, peer.request(3, "GET", "/b?q=1", true));
+    REQUIRE(connection.onInput(input, output) == CONN_ACTION::KEEP_READING);
+    REQUIRE(connection.handledRequests() == 2);
+    auto frames = peer.read(output);
+
+    /* 本端 SETTINGS 在最前，随后是连接窗口的放大与对客户端 SETTINGS 的确认 */
+    REQUIRE(frames.front().m_type == HTTP2_FRAME::SETTINGS);
+    REQUIRE(frames.front().m_flags == 0);
+    auto* windowUpdate = findFrame(frames, HTTP2_FRAME::WINDOW_UPDATE, 0);
+    REQUIRE(windowUpdate != nullptr);
+    REQUIRE(readBe32(windowUpdate->m_payload) == options.m_http2.m_connectionWindow - HTTP2_DEFAULT_WINDOW);
+    bool acked = false;
+    for (auto& item : frames)
+        acked = acked || (item.m_type == HTTP2_FRAME::SETTINGS && item.m_flags == HTTP2_FLAG_ACK);
+    REQUIRE(acked);
+
+    for (auto [streamId, expected] : { pair<uint32_t, string> { 1, "GET /a " }, { 3, "GET /b " } })
+    {
+        auto* headers = findFrame(frames, HTTP2_FRAME::HEADERS, streamId);
+        REQUIRE(headers != nullptr);
+        REQUIRE(fieldOf(*headers, ":status") == "200");
+        REQUIRE(fieldOf(*headers, "content-type") == "text/plain");
+        REQUIRE(fieldOf(*headers, "content-length") == to_string(expected.size()));
+        bool ended = false;
+        REQUIRE(bodyOf(frames, streamId, ended) == expected);
+        REQUIRE(ended);
+    }
+
+    /* 第二轮的响应首部命中动态表，编码长度明显变短 */
+    feed(input, peer.request(5, "GET", "/a", true));
+    REQUIRE(connection.onInput(input, output) == CONN_ACTION::KEEP_READING);
+    auto again = peer.read(output);
+    auto* first = findFrame(frames, HTTP2_FRAME::HEADERS, 1);
+    auto* second = findFrame(again, HTTP2_FRAME::HEADERS, 5);
+    REQUIRE(second != nullptr);
+    REQUIRE(second->m_fields == first->m_fields);
+    REQUIRE(second->m_payload.size() < first->m_payload.size());
+    REQUIRE(connection.pendingDeadline(input, output) == DEADLINE::IDLE);
+
+    evbuffer_free(input);
+    evbuffer_free(output);
+}
+
+TEST_CASE("Request bodies arrive in DATA frames", "[Http2]")
+{
+    HttpConnectionOptions options;
+    options.m_maxBodyBytes = 64;
+    HttpConnection connection(options, ECHO_RESOLVER);
+    TestPeer peer;
+    struct evbuffer* input = evbuffer_new();
+    struct evbuffer* output = evbuffer_new();
+    feed(input, CLIENT_START);
+    REQUIRE(connection.onInput(input, output) == CONN_ACTION::KEEP_READING);
+    peer.read(output);
+
+    SECTION("Body split across frames, one of them padded")
+    {
+        string padded = string(1, '\x03') + "world" + string(3, '\0');
+        feed(input, peer.request(1, "POST", "/p", false) + frame(HTTP2_FRAME::DATA, 0, 1, "hello "));
+        REQUIRE(connection.onInput(input, output) == CONN_ACTION::KEEP_READING);
+        REQUIRE(connection.pendingDeadline(input, output) == DEADLINE::BODY_READ);
+        REQUIRE(peer.read(output).empty());
+
+        feed(input, frame(HTTP2_FRAME::DATA, HTTP2_FLAG_END_STREAM | HTTP2_FLAG_PADDED, 1, padded));
+        REQUIRE(connection.onInput(input, output) == CONN_ACTION::KEEP_READING);
+        bool ended = false;
+        REQUIRE(bodyOf(peer.read(output), 1, ended) == "POST /p hello world");
+        REQUIRE(ended);
+    }
+
+    SECTION("Oversized bodies are answered with 413 and the stream is reset")
+    {
+        feed(input, peer.request(1, "POST", "/p", false) + frame(HTTP2_FRAME::DATA, 0, 1, string(100, 'x')));
+        REQUIRE(connection.onInput(input, output) == CONN_ACTION::KEEP_READING);
+        auto frames = peer.read(output);
+        auto* headers = findFrame(frames, HTTP2_FRAME::HEADERS, 1);
+        REQUIRE(headers != nullptr);
+        REQUIRE(fieldOf(*headers, ":status") == "413");
+        REQUIRE(findFrame(frames, HTTP2_FRAME::RST_STREAM, 1) != nullptr);
+
+        /* 已重置的流上仍在途中的数据直接丢弃，连接不受影响 */
+        feed(input, frame(HTTP2_FRAME::DATA, HTTP2_FLAG_END_STREAM, 1, "late") + peer.request(3, "GET", "/ok", true));
+        REQUIRE(connection.onInput(input, output) == CONN_ACTION::KEEP_READING);
+        auto later = peer.read(output);
+        REQUIRE(findFrame(later, HTTP2_FRAME::GOAWAY, 0) == nullptr);
+        REQUIRE(findFrame(later, HTTP2_FRAME::HEADERS, 3) != nullptr);
+    }
+
+    evbuffer_free(input);
+    evbuffer_free(output);
+}
+
+TEST_CASE("Response bodies respect the peer's flow control windows", "[Http2]")
+{
+    HttpConnectionOptions options;
+    HttpConnection connection(options, ECHO_RESOLVER);
+    TestPeer peer;
+    struct evbuffer* input = evbuffer_new();
+    struct evbuffer* output = evbuffer_new();
+
+    /* 对端使用默认的 65535 字节窗口与 16384 字节最大帧 */
+    feed(input, CLIENT_START + peer.request(1, "GET", "/big", true));
+    REQUIRE(connection.onInput(input, output) == CONN_ACTION::KEEP_READING);
+    auto frames = peer.read(output);
+    bool ended = false;
+    auto body = bodyOf(frames, 1, ended);
+    REQUIRE(body.size() == HTTP2_DEFAULT_WINDOW);
+    REQUIRE_FALSE(ended);
+    for (auto& item : frames)
+        REQUIRE(item.m_payload.size() <= HTTP2_DEFAULT_FRAME_SIZE);
+    /* 对端窗口耗尽导致的积压同样由写超时兜底 */
+    REQUIRE(connection.pendingDeadline(input, output) == DEADLINE::WRITE);
+
+    /* 只补充流窗口不够，连接窗口同样耗尽 */
+    feed(input, frame(HTTP2_FRAME::WINDOW_UPDATE, 0, 1, be32(100000)));
+    REQUIRE(connection.onInput(input, output) == CONN_ACTION::KEEP_READING);
+    REQUIRE(peer.read(output).empty());
+
+    feed(input, frame(HTTP2_FRAME::WINDOW_UPDATE, 0, 0, be32(100000)));
+    REQUIRE(connection.onInput(input, output) == CONN_ACTION::KEEP_READING);
+    body += bodyOf(peer.read(output), 1, ended);
+    REQUIRE(body == string(100000, 'x'));
+    REQUIRE(ended);
+
+    SECTION("A larger initial window from SETTINGS applies to new streams")
+    {
+        feed(input,
+            frame(HTTP2_FRAME::SETTINGS, 0, 0, setting(HTTP2_SETTING::INITIAL_WINDOW_SIZE, 200000))
+                + frame(HTTP2_FRAME::WINDOW_UPDATE, 0, 0, be32(200000)) + peer.request(3, "GET", "/big", true));
+        REQUIRE(connection.onInput(input, output) == CONN_ACTION::KEEP_READING);
+        REQUIRE(bodyOf(peer.read(output), 3, ended).size() == 100000);
+        REQUIRE(ended);
+    }
+
+    SECTION("Window overflow is a connection error")
+    {
+        feed(input, frame(HTTP2_FRAME::WINDOW_UPDATE, 0, 0, be32(HTTP2_MAX_WINDOW)));
+        REQUIRE(connection.onInput(input, output) == CONN_ACTION::CLOSE_AFTER_WRITE);
+        REQUIRE(goAwayError(peer.read(output)) == HTTP2_ERROR::FLOW_CONTROL_ERROR);
+    }
+
+    evbuffer_free(input);
+    evbuffer_free(output);
+}
+
+TEST_CASE("Upgrade: h2c switches an HTTP/1.1 connection", "[Http2]")
+{
+    HttpConnectionOptions options;
+    HttpConnection connection(options, ECHO_RESOLVER);
+    TestPeer peer;
+    struct evbuffer* input = evbuffer_new();
+    struct evbuffer* output = evbuffer_new();
+
+    /* HTTP2-Settings 为 base64url 编码的 SETTINGS 负载：MAX_CONCURRENT_STREAMS=100 */
+    string upgrade = "POST /up HTTP/1.1\r\nHost: x\r\nConnection: Upgrade, HTTP2-Settings\r\nUpgrade: websocket, h2c\r\n"
+                     "HTTP2-Settings: AAMAAABk\r\nContent-Length: 4\r\n\r\nbody";
+    feed(input, upgrade);
+    REQUIRE(connection.onInput(input, output) == CONN_ACTION::KEEP_READING);
+    size_t length = evbuffer_get_length(output);
+    string text(reinterpret_cast<const char*>(evbuffer_pullup(output, -1)), length);
+    auto end = text.find("\r\n\r\n");
+    REQUIRE(text.compare(0, 12, "HTTP/1.1 101") == 0);
+    REQUIRE(text.find("Upgrade: h2c") < end);
+    evbuffer_drain(output, end + 4);
+
+    /* 升级请求的响应在流 1 上，首部块的解码与客户端之后的帧无关 */
+    auto frames = peer.read(output);
+    REQUIRE(frames.front().m_type == HTTP2_FRAME::SETTINGS);
+    bool ended = false;
+    REQUIRE(bodyOf(frames, 1, ended) == "POST /up body");
+    REQUIRE(ended);
+
+    feed(input, CLIENT_START + peer.request(3, "GET", "/next", true));
+    REQUIRE(connection.onInput(input, output) == CONN_ACTION::KEEP_READING);
+    REQUIRE(bodyOf(peer.read(output), 3, ended) == "GET /next ");
+    REQUIRE(connection.handledRequests() == 2);
+
+    SECTION("Reset returns the connection to HTTP/1.1")
+    {
+        connection.reset();
+        feed(input, "GET /plain HTTP/1.1\r\n\r\n");
+        REQUIRE(connection.onInput(input, output) == CONN_ACTION::KEEP_READING);
+        length = evbuffer_get_length(output);
+        text.assign(reinterpret_cast<const char*>(evbuffer_pullup(output, -1)), length);
+        REQUIRE(text.find("HTTP/1.1 200 OK") == 0);
+        evbuffer_drain(output, length);
+    }
+
+    evbuffer_free(input);
+    evbuffer_free(output);
+}
+
+TEST_CASE("Malformed HTTP2-Settings keeps the request on HTTP/1.1", "[Http2]")
+{
+    HttpConnectionOptions options;
+    HttpConnection connection(options, ECHO_RESOLVER);
+    struct evbuffer* input = evbuffer_new();
+    struct evbuffer* output = evbuffer_new();
+
+    feed(input, "GET /up HTTP/1.1\r\nConnection: Upgrade, HTTP2-Settings\r\nUpgrade: h2c\r\nHTTP2-Settings: AAM\r\n\r\n");
+    REQUIRE(connection.onInput(input, output) == CONN_ACTION::KEEP_READING);
+    size_t length = evbuffer_get_length(output);
+    string text(reinterpret_cast<const char*>(evbuffer_pullup(output, -1)), length);
+    REQUIRE(text.find("HTTP/1.1 200 OK") == 0);
+    REQUIRE(text.find("GET /up") != string::npos);
+
+    evbuffer_free(input);
+    evbuffer_free(output);
+}
+
+TEST_CASE("Control frames and protocol errors", "[Http2]")
+{
+    HttpConnectionOptions options;
+    HttpConnection connection(options, ECHO_RESOLVER);
+    TestPeer peer;
+    struct evbuffer* input = evbuffer_new();
+    struct evbuffer* output = evbuffer_new();
+    feed(input, CLIENT_START);
+    REQUIRE(connection.onInput(input, output) == CONN_ACTION::KEEP_READING);
+    peer.read(output);
+
+    SECTION("PING is acknowledged with the same payload")
+    {
+        feed(input, frame(HTTP2_FRAME::PING, 0, 0, "12345678"));
+        REQUIRE(connection.onInput(input, output) == CONN_ACTION::KEEP_READING);
+        auto frames = peer.read(output);
+        REQUIRE(frames.size() == 1);
+        REQUIRE(frames[0].m_type == HTTP2_FRAME::PING);
+        REQUIRE(frames[0].m_flags == HTTP2_FLAG_ACK);
+        REQUIRE(frames[0].m_payload == "12345678");
+    }
+
+    SECTION("Header blocks continue across CONTINUATION frames")
+    {
+        auto headers = peer.request(1, "GET", "/cont", true);
+        string block = headers.substr(HTTP2_FRAME_HEADER_SIZE);
+        feed(input,
+            frame(HTTP2_FRAME::HEADERS, HTTP2_FLAG_END_STREAM, 1, block.substr(0, 3))
+                + frame(HTTP2_FRAME::CONTINUATION, HTTP2_FLAG_END_HEADERS, 1, block.substr(3)));
+        REQUIRE(connection.onInput(input, output) == CONN_ACTION::KEEP_READING);
+        bool ended = false;
+        REQUIRE(bodyOf(peer.read(output), 1, ended) == "GET /cont ");
+    }
+
+    SECTION("Frames interleaved with a header block are a connection error")
+    {
+        string block = peer.request(1, "GET", "/x", true).substr(HTTP2_FRAME_HEADER_SIZE);
+        feed(input, frame(HTTP2_FRAME::HEADERS, 0, 1, block) + frame(HTTP2_FRAME::PING, 0, 0, "12345678"));
+        REQUIRE(connection.onInput(input, output) == CONN_ACTION::CLOSE_AFTER_WRITE);
+        REQUIRE(goAwayError(peer.read(output)) == HTTP2_ERROR::PROTOCOL_ERROR);
+    }
+
+    SECTION("Even stream ids are a connection error")
+    {
+        feed(input, peer.request(2, "GET", "/x", true));
+        REQUIRE(connection.onInput(input, output) == CONN_ACTION::CLOSE_AFTER_WRITE);
+        REQUIRE(goAwayError(peer.read(output)) == HTTP2_ERROR::PROTOCOL_ERROR);
+    }
+
+    SECTION("HEADERS on a closed stream is a connection error")
+    {
+        feed(input, peer.request(1, "GET", "/x", true));
+        REQUIRE(connection.onInput(input, output) == CONN_ACTION::KEEP_READING);
+        bool ended = false;
+        REQUIRE(bodyOf(peer.read(output), 1, ended) == "GET /x ");
+        REQUIRE(ended);
+        feed(input, peer.request(1, "GET", "/again", true));
+        REQUIRE(connection.onInput(input, output) == CONN_ACTION::CLOSE_AFTER_WRITE);
+        REQUIRE(goAwayError(peer.read(output)) == HTTP2_ERROR::STREAM_CLOSED);
+    }
+
+    SECTION("Undecodable header blocks are a compression error")
+    {
+        feed(input, frame(HTTP2_FRAME::HEADERS, HTTP2_FLAG_END_HEADERS | HTTP2_FLAG_END_STREAM, 1, "\x80"));
+        REQUIRE(connection.onInput(input, output) == CONN_ACTION::CLOSE_AFTER_WRITE);
+        REQUIRE(goAwayError(peer.read(output)) == HTTP2_ERROR::COMPRESSION_ERROR);
+    }
+
+    SECTION("Frames larger than the advertised maximum are a frame size error")
+    {
+        feed(input, frame(HTTP2_FRAME::DATA, 0, 1, string(options.m_http2.m_maxFrameSize + 1, 'x')));
+        REQUIRE(connection.onInput(input, output) == CONN_ACTION::CLOSE_AFTER_WRITE);
+        REQUIRE(goAwayError(peer.read(output)) == HTTP2_ERROR::FRAME_SIZE_ERROR);
+    }
+
+    SECTION("Requests missing pseudo headers are reset")
+    {
+        string block;
+        HpackEncoder encoder;
+        encoder.encode(":method", "GET", block);
+        feed(input, frame(HTTP2_FRAME::HEADERS, HTTP2_FLAG_END_HEADERS | HTTP2_FLAG_END_STREAM, 1, block));
+        REQUIRE(connection.onInput(input, output) == CONN_ACTION::KEEP_READING);
+        auto frames = peer.read(output);
+        auto* reset = findFrame(frames, HTTP2_FRAME::RST_STREAM, 1);
+        REQUIRE(reset != nullptr);
+        REQUIRE(static_cast<HTTP2_ERROR>(readBe32(reset->m_payload)) == HTTP2_ERROR::PROTOCOL_ERROR);
+    }
+
+    SECTION("GOAWAY from the peer closes once streams finish")
+    {
+        feed(input, frame(HTTP2_FRAME::GOAWAY, 0, 0, be32(0) + be32(0)));
+        REQUIRE(connection.onInput(input, output) == CONN_ACTION::CLOSE_AFTER_WRITE);
+    }
+
+    evbuffer_free(input);
+    evbuffer_free(output);
+}
+
+TEST_CASE("Stream limits are enforced per connection", "[Http2]")
+{
+    HttpConnectionOptions options;
+    options.m_http2.m_maxConcurrentStreams = 1;
+    options.m_maxHeaderBytes = 256;
+    HttpConnection connection(options, ECHO_RESOLVER);
+    TestPeer peer;
+    struct evbuffer* input = evbuffer_new();
+    struct evbuffer* output = evbuffer_new();
+    feed(input, CLIENT_START);
+    REQUIRE(connection.onInput(input, output) == CONN_ACTION::KEEP_READING);
+    peer.read(output);
+
+    SECTION("Streams beyond the concurrency limit are refused")
+    {
+        feed(input, peer.request(1, "POST", "/open", false));
+        feed(input, peer.request(3, "GET", "/x", true));
+        REQUIRE(connection.onInput(input, output) == CONN_ACTION::KEEP_READING);
+        auto frames = peer.read(output);
+        auto* reset = findFrame(frames, HTTP2_FRAME::RST_STREAM, 3);
+        REQUIRE(reset != nullptr);
+        REQUIRE(static_cast<HTTP2_ERROR>(readBe32(reset->m_payload)) == HTTP2_ERROR::REFUSED_STREAM);
+        REQUIRE(findFrame(frames, HTTP2_FRAME::HEADERS, 3) == nullptr);
+    }
+
+    SECTION("Oversized header lists are answered with 431")
+    {
+        feed(input, peer.request(1, "GET", "/x", true, { { "x-long", string(400, 'a') } }));
+        REQUIRE(connection.onInput(input, output) == CONN_ACTION::KEEP_READING);
+        auto frames = peer.read(output);
+        auto* headers = findFrame(frames, HTTP2_FRAME::HEADERS, 1);
+        REQUIRE(headers != nullptr);
+        REQUIRE(fieldOf(*headers, ":status") == "431");
+    }
+
+    SECTION("Repeated references to a table entry are cut off at the header list limit")
+    {
+        /* :method GET、:scheme http、:path / 之后是反复引用的表项 */
+        feed(input,
+            frame(HTTP2_FRAME::HEADERS, HTTP2_FLAG_END_HEADERS | HTTP2_FLAG_END_STREAM, 1, "\x82\x86\x84" + bombBlock(5000)));
+        REQUIRE(connection.onInput(input, output) == CONN_ACTION::KEEP_READING);
+        auto frames = peer.read(output);
+        auto* headers = findFrame(frames, HTTP2_FRAME::HEADERS, 1);
+        REQUIRE(headers != nullptr);
+        REQUIRE(fieldOf(*headers, ":status") == "431");
+    }
+
+    SECTION("Oversized trailers are a connection error")
+    {
+        feed(input, peer.request(1, "POST", "/x", false));
+        feed(input, frame(HTTP2_FRAME::HEADERS, HTTP2_FLAG_END_HEADERS | HTTP2_FLAG_END_STREAM, 1, bombBlock(5000)));
+        REQUIRE(connection.onInput(input, output) == CONN_ACTION::CLOSE_AFTER_WRITE);
+        REQUIRE(goAwayError(peer.read(output)) == HTTP2_ERROR::ENHANCE_YOUR_CALM);
+    }
+
+    evbuffer_free(input);
+    evbuffer_free(output);
+}
+
+TEST_CASE("Blocking handlers run one at a time without stalling other streams", "[Http2]")
+{
+    HttpConnectionOptions options;
+    const HttpHandler slow { ECHO_HANDLER, HANDLER_MODE::BLOCKING };
+    const HttpHandlerResolver resolver = [&slow](const HttpRequest& Request)
+    { return Request.m_path == "/slow" ? &slow : &ECHO; };
+    BlockingCall* offloaded = nullptr;
+    HttpConnection connection(options, resolver, [&offloaded](BlockingCall& Call) { offloaded = &Call; });
+    auto runOffloaded = [&offloaded]
+    {
+        REQUIRE(offloaded != nullptr);
+        std::thread worker([call = offloaded] { call->run(); });
+        worker.join();
+        offloaded = nullptr;
+    };
+    TestPeer peer;
+    struct evbuffer* input = evbuffer_new();
+    struct evbuffer* output = evbuffer_new();
+
+    feed(input, CLIENT_START);
+    feed(input, peer.request(1, "GET", "/slow", true));
+    feed(input, peer.request(3, "GET", "/slow", true));
+    feed(input, peer.request(5, "GET", "/fast", true));
+    REQUIRE(connection.onInput(input, output) == CONN_ACTION::KEEP_READING);
+    REQUIRE(connection.blocked());
+    auto frames = peer.read(output);
+    REQUIRE(connection.pendingDeadline(input, output) == DEADLINE::NONE);
+    REQUIRE(findFrame(frames, HTTP2_FRAME::HEADERS, 5) != nullptr);
+    REQUIRE(findFrame(frames, HTTP2_FRAME::HEADERS, 1) == nullptr);
+
+    SECTION("Queued calls follow in order")
+    {
+        runOffloaded();
+        REQUIRE(connection.onBlockingDone(input, output) == CONN_ACTION::KEEP_READING);
+        REQUIRE(connection.blocked());
+        bool ended = false;
+        REQUIRE(bodyOf(peer.read(output), 1, ended) == "GET /slow ");
+        runOffloaded();
+        REQUIRE(connection.onBlockingDone(input, output) == CONN_ACTION::KEEP_READING);
+        REQUIRE_FALSE(connection.blocked());
+        REQUIRE(bodyOf(peer.read(output), 3, ended) == "GET /slow ");
+        REQUIRE(connection.handledRequests() == 3);
+    }
+
+    SECTION("A stream reset while its call runs produces no response")
+    {
+        feed(input, frame(HTTP2_FRAME::RST_STREAM, 0, 1, be32(static_cast<uint32_t>(HTTP2_ERROR::CANCEL))));
+        REQUIRE(connection.onInput(input, output) == CONN_ACTION::KEEP_READING);
+        REQUIRE(connection.blocked());
+        runOffloaded();
+        REQUIRE(connection.onBlockingDone(input, output) == CONN_ACTION::KEEP_READING);
+        auto later = peer.read(output);
+        REQUIRE(findFrame(later, HTTP2_FRAME::HEADERS, 1) == nullptr);
+        runOffloaded();
+        REQUIRE(connection.onBlockingDone(input, output) == CONN_ACTION::KEEP_READING);
+        REQUIRE(findFrame(peer.read(output), HTTP2_FRAME::HEADERS, 3) != nullptr);
+    }
+
+    evbuffer_free(input);
+    evbuffer_free(output);
+}
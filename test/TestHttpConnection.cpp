@@ -0,0 +1,394 @@
+#include "HttpConnection.h"
+#include "RateLimiter.h"
+#include "TestHttpHelpers.h"
+#include "catch2/catch.hpp"
+
+#include <chrono>
+#include <event2/buffer.h>
+#include <memory_resource>
+#include <string>
+#include <thread>
+
+using namespace ToolKit;
+using namespace TestHttp;
+using namespace std;
+
+namespace
+{
+size_t countOf(const string& Text, const string& Pattern)
+{
+    size_t count = 0;
+    for (size_t pos = Text.find(Pattern); pos != string::npos; pos = Text.find(Pattern, pos + 1))
+        count++;
+    return count;
+}
+
+/* 把请求路径作为响应体返回 */
+const HttpRequestHandler ECHO_PATH_HANDLER = [](const HttpRequest& Request, HttpResponse& Response)
+{ evbuffer_add(Response.body(), Request.m_path.data(), Request.m_path.size()); };
+const HttpHandler ECHO_PATH { ECHO_PATH_HANDLER };
+const HttpHandlerResolver ECHO_PATH_RESOLVER = [](const HttpRequest&) { return &ECHO_PATH; };
+}   // namespace
+
+TEST_CASE("Pipelined requests are answered in order from one input callback", "[HttpConnection]")
+{
+    HttpConnectionOptions options;
+    HttpConnection connection(options, ECHO_PATH_RESOLVER);
+    struct evbuffer* input = evbuffer_new();
+    struct evbuffer* output = evbuffer_new();
+
+    string raw;
+    for (int i = 0; i < 32; i++)
+        raw += "GET /r" + to_string(i) + " HTTP/1.1\r\nHost: x\r\n\r\n";
+    /* 最后一个请求只到达了一半 */
+    raw += "GET /partial HTTP/1.1\r\nHo";
+    evbuffer_add(input, raw.data(), raw.size());
+
+    REQUIRE(connection.onInput(input, output) == CONN_ACTION::KEEP_READING);
+    REQUIRE(connection.handledRequests() == 32);
+
+    SECTION("Small responses are coalesced into a few contiguous chunks for one writev")
+    {
+        REQUIRE(evbuffer_peek(output, -1, nullptr, nullptr, 0) <= 2);
+    }
+
+    auto text = drainAll(output);
+    REQUIRE(countOf(text, "HTTP/1.1 200 OK") == 32);
+    size_t last = 0;
+    for (int i = 0; i < 32; i++)
+    {
+        auto pos = text.find("\r\n\r\n/r" + to_string(i) + "HTTP/");
+        if (i == 31)
+            pos = text.find("\r\n\r\n/r31");
+        REQUIRE(pos != string::npos);
+        REQUIRE(pos >= last);
+        last = pos;
+    }
+
+    string rest = "st: x\r\n\r\n";
+    evbuffer_add(input, rest.data(), rest.size());
+    REQUIRE(connection.onInput(input, output) == CONN_ACTION::KEEP_READING);
+    REQUIRE(drainAll(output).find("/partial") != string::npos);
+
+    evbuffer_free(input);
+    evbuffer_free(output);
+}
+
+TEST_CASE("Connection close stops processing later pipelined requests", "[HttpConnection]")
+{
+    HttpConnectionOptions options;
+    HttpConnection connection(options, ECHO_PATH_RESOLVER);
+    struct evbuffer* input = evbuffer_new();
+    struct evbuffer* output = evbuffer_new();
+
+    string raw = "GET /a HTTP/1.1\r\n\r\nGET /b HTTP/1.1\r\nConnection: close\r\n\r\nGET /c HTTP/1.1\r\n\r\n";
+    evbuffer_add(input, raw.data(), raw.size());
+    REQUIRE(connection.onInput(input, output) == CONN_ACTION::CLOSE_AFTER_WRITE);
+    auto text = drainAll(output);
+    REQUIRE(countOf(text, "HTTP/1.1 200 OK") == 2);
+    REQUIRE(text.find("Connection: close") != string::npos);
+    REQUIRE(text.find("/c") == string::npos);
+
+    evbuffer_free(input);
+    evbuffer_free(output);
+}
+
+TEST_CASE("Keep-alive semantics of persistent connections", "[HttpConnection]")
+{
+    struct evbuffer* input = evbuffer_new();
+    struct evbuffer* output = evbuffer_new();
+
+    SECTION("HTTP/1.0 keep-alive is acknowledged explicitly")
+    {
+        HttpConnectionOptions options;
+        HttpConnection connection(options, ECHO_PATH_RESOLVER);
+        string raw = "GET / HTTP/1.0\r\nConnection: keep-alive\r\n\r\n";
+        evbuffer_add(input, raw.data(), raw.size());
+        REQUIRE(connection.onInput(input, output) == CONN_ACTION::KEEP_READING);
+        REQUIRE(drainAll(output).find("Connection: keep-alive\r\n") != string::npos);
+    }
+
+    SECTION("HTTP/1.0 without keep-alive closes")
+    {
+        HttpConnectionOptions options;
+        HttpConnection connection(options, ECHO_PATH_RESOLVER);
+        string raw = "GET / HTTP/1.0\r\n\r\n";
+        evbuffer_add(input, raw.data(), raw.size());
+        REQUIRE(connection.onInput(input, output) == CONN_ACTION::CLOSE_AFTER_WRITE);
+    }
+
+    SECTION("The connection closes after the configured number of requests")
+    {
+        HttpConnectionOptions options;
+        options.m_maxKeepAliveRequests = 3;
+        HttpConnection connection(options, ECHO_PATH_RESOLVER);
+        string raw;
+        for (int i = 0; i < 5; i++)
+            raw += "GET / HTTP/1.1\r\n\r\n";
+        evbuffer_add(input, raw.data(), raw.size());
+        REQUIRE(connection.onInput(input, output) == CONN_ACTION::CLOSE_AFTER_WRITE);
+        REQUIRE(countOf(drainAll(output), "HTTP/1.1 200 OK") == 3);
+    }
+
+    SECTION("A malformed request is answered and closes the connection")
+    {
+        HttpConnectionOptions options;
+        HttpConnection connection(options, ECHO_PATH_RESOLVER);
+        string raw = "GET / HTTP/1.1\r\n\r\nBAD\r\n\r\n";
+        evbuffer_add(input, raw.data(), raw.size());
+        REQUIRE(connection.onInput(input, output) == CONN_ACTION::CLOSE_AFTER_WRITE);
+        auto text = drainAll(output);
+        REQUIRE(text.find("HTTP/1.1 200 OK") < text.find("HTTP/1.1 400 Bad Request"));
+    }
+    evbuffer_free(input);
+    evbuffer_free(output);
+}
+
+TEST_CASE("Pipelined processing pauses when the peer stops reading", "[HttpConnection]")
+{
+    HttpConnectionOptions options;
+    options.m_outputHighWater = 1024;
+    const HttpRequestHandler bigHandler = [](const HttpRequest&, HttpResponse& Response)
+    {
+        string body(600, 'x');
+        evbuffer_add(Response.body(), body.data(), body.size());
+    };
+    const HttpHandler big { bigHandler };
+    const HttpHandlerResolver resolver = [&big](const HttpRequest&) { return &big; };
+    HttpConnection connection(options, resolver);
+    struct evbuffer* input = evbuffer_new();
+    struct evbuffer* output = evbuffer_new();
+
+    string raw;
+    for (int i = 0; i < 4; i++)
+        raw += "GET / HTTP/1.1\r\n\r\n";
+    evbuffer_add(input, raw.data(), raw.size());
+
+    REQUIRE(connection.onInput(input, output) == CONN_ACTION::PAUSE_READING);
+    REQUIRE(connection.handledRequests() == 2);
+    evbuffer_drain(output, evbuffer_get_length(output));
+    REQUIRE(connection.onInput(input, output) == CONN_ACTION::PAUSE_READING);
+    evbuffer_drain(output, evbuffer_get_length(output));
+    REQUIRE(connection.onInput(input, output) == CONN_ACTION::KEEP_READING);
+    REQUIRE(connection.handledRequests() == 4);
+
+    evbuffer_free(input);
+    evbuffer_free(output);
+}
+
+TEST_CASE("Blocking handlers are offloaded and their responses keep pipeline order", "[HttpConnection]")
+{
+    HttpConnectionOptions options;
+    const HttpHandler slow { [](const HttpRequest& Request, HttpResponse& Response)
+        {
+            ECHO_PATH_HANDLER(Request, Response);
+            if (Request.m_query == "close")
+                Response.setKeepAlive(false);
+        },
+        HANDLER_MODE::BLOCKING };
+    const HttpHandlerResolver resolver = [&slow](const HttpRequest& Request)
+    { return Request.m_path == "/slow" ? &slow : &ECHO_PATH; };
+    struct evbuffer* input = evbuffer_new();
+    struct evbuffer* output = evbuffer_new();
+
+    BlockingCall* offloaded = nullptr;
+    HttpConnection connection(options, resolver, [&offloaded](BlockingCall& Call) { offloaded = &Call; });
+    /* 模拟线程池：在另一个线程上执行，结束后回到当前线程调用 onBlockingDone */
+    auto runOffloaded = [&offloaded]
+    {
+        REQUIRE(offloaded != nullptr);
+        std::thread worker([call = offloaded] { call->run(); });
+        worker.join();
+        offloaded = nullptr;
+    };
+
+    SECTION("Later pipelined requests wait for the blocking response")
+    {
+        string raw = "GET /a HTTP/1.1\r\n\r\nGET /slow HTTP/1.1\r\n\r\nGET /c HTTP/1.1\r\n\r\n";
+        evbuffer_add(input, raw.data(), raw.size());
+        REQUIRE(connection.onInput(input, output) == CONN_ACTION::PAUSE_READING);
+        REQUIRE(connection.blocked());
+        REQUIRE(connection.handledRequests() == 2);
+        auto first = drainAll(output);
+        REQUIRE(countOf(first, "HTTP/1.1 200 OK") == 1);
+        REQUIRE(first.find("/a") != string::npos);
+
+        /* 阻塞期间新到的数据只进入输入缓冲区；拷贝后的请求不受输入缓冲区变化的影响 */
+        string more = "GET /d HTTP/1.1\r\n\r\n";
+        evbuffer_add(input, more.data(), more.size());
+        REQUIRE(connection.onInput(input, output) == CONN_ACTION::PAUSE_READING);
+        REQUIRE(evbuffer_get_length(output) == 0);
+        evbuffer_pullup(input, -1);
+        runOffloaded();
+
+        REQUIRE(connection.onBlockingDone(input, output) == CONN_ACTION::KEEP_READING);
+        REQUIRE_FALSE(connection.blocked());
+        auto rest = drainAll(output);
+        REQUIRE(countOf(rest, "HTTP/1.1 200 OK") == 3);
+        REQUIRE(rest.find("/slow") < rest.find("/c"));
+        REQUIRE(rest.find("/c") < rest.find("/d"));
+        REQUIRE(connection.handledRequests() == 4);
+    }
+
+    SECTION("Consecutive blocking requests are offloaded one at a time")
+    {
+        string raw = "GET /slow HTTP/1.1\r\n\r\nGET /slow HTTP/1.1\r\n\r\n";
+        evbuffer_add(input, raw.data(), raw.size());
+        REQUIRE(connection.onInput(input, output) == CONN_ACTION::PAUSE_READING);
+        runOffloaded();
+        REQUIRE(connection.onBlockingDone(input, output) == CONN_ACTION::PAUSE_READING);
+        REQUIRE(connection.blocked());
+        runOffloaded();
+        REQUIRE(connection.onBlockingDone(input, output) == CONN_ACTION::KEEP_READING);
+        REQUIRE(countOf(drainAll(output), "\r\n\r\n/slow") == 2);
+    }
+
+    SECTION("A blocking handler can close the connection")
+    {
+        string raw = "GET /slow?close HTTP/1.1\r\n\r\nGET /c HTTP/1.1\r\n\r\n";
+        evbuffer_add(input, raw.data(), raw.size());
+        REQUIRE(connection.onInput(input, output) == CONN_ACTION::PAUSE_READING);
+        runOffloaded();
+        REQUIRE(connection.onBlockingDone(input, output) == CONN_ACTION::CLOSE_AFTER_WRITE);
+        auto text = drainAll(output);
+        REQUIRE(text.find("Connection: close") != string::npos);
+        REQUIRE(text.find("/c") == string::npos);
+    }
+
+    evbuffer_free(input);
+    evbuffer_free(output);
+}
+
+TEST_CASE("Blocking requests over the concurrency limit are answered with 503", "[HttpConnection]")
+{
+    ConcurrencyLimiterOptions limits;
+    limits.m_initialLimit = 1;
+    limits.m_minLimit = 1;
+    limits.m_maxLimit = 1;
+    ConcurrencyLimiter limiter(limits);
+    HttpConnectionOptions options;
+    options.m_limiter = &limiter;
+    const HttpHandler slow { ECHO_PATH_HANDLER, HANDLER_MODE::BLOCKING };
+    const HttpHandlerResolver resolver = [&slow](const HttpRequest& Request)
+    { return Request.m_path == "/slow" ? &slow : &ECHO_PATH; };
+    BlockingCall* offloaded = nullptr;
+    HttpConnection connection(options, resolver, [&offloaded](BlockingCall& Call) { offloaded = &Call; });
+    struct evbuffer* input = evbuffer_new();
+    struct evbuffer* output = evbuffer_new();
+
+    /* 另一个连接占着唯一的名额，拒绝后连接照常处理后续请求 */
+    REQUIRE(limiter.tryAcquire());
+    string raw = "GET /slow HTTP/1.1\r\n\r\nGET /c HTTP/1.1\r\n\r\n";
+    evbuffer_add(input, raw.data(), raw.size());
+    REQUIRE(connection.onInput(input, output) == CONN_ACTION::KEEP_READING);
+    REQUIRE(offloaded == nullptr);
+    auto text = drainAll(output);
+    REQUIRE(text.find("HTTP/1.1 503 ") == 0);
+    REQUIRE(text.find("Retry-After: 1\r\n") != string::npos);
+    REQUIRE(text.find("/slow") == string::npos);
+    REQUIRE(text.find("\r\n\r\n/c") != string::npos);
+    REQUIRE(limiter.stats().m_shed == 1);
+
+    /* 名额归还后的阻塞请求正常交给线程池，执行完毕时归还名额 */
+    limiter.release(chrono::milliseconds(1));
+    raw = "GET /slow HTTP/1.1\r\n\r\n";
+    evbuffer_add(input, raw.data(), raw.size());
+    REQUIRE(connection.onInput(input, output) == CONN_ACTION::PAUSE_READING);
+    REQUIRE(offloaded != nullptr);
+    REQUIRE(limiter.inflight() == 1);
+    offloaded->run();
+    REQUIRE(limiter.inflight() == 0);
+    REQUIRE(connection.onBlockingDone(input, output) == CONN_ACTION::KEEP_READING);
+    REQUIRE(drainAll(output).find("\r\n\r\n/slow") != string::npos);
+
+    evbuffer_free(input);
+    evbuffer_free(output);
+}
+
+TEST_CASE("Requests over the client rate are answered with 429 on the same connection", "[HttpConnection]")
+{
+    RateLimiterOptions limits;
+    limits.m_rate = 0.001;
+    limits.m_burst = 2;
+    limits.m_header = "X-Api-Key";
+    RateLimiter limiter(limits);
+    HttpConnectionOptions options;
+    options.m_rateLimiter = &limiter;
+    HttpConnection connection(options, ECHO_PATH_RESOLVER);
+    connection.setClientKey(42);
+    struct evbuffer* input = evbuffer_new();
+    struct evbuffer* output = evbuffer_new();
+
+    /* 地址的桶只有两个令牌，换一个首部值也不能绕过，第三个请求被拒绝，之后的请求照常处理 */
+    string raw = "GET /a HTTP/1.1\r\nX-Api-Key: k\r\n\r\nGET /b HTTP/1.1\r\n\r\n"
+                 "GET /c HTTP/1.1\r\nX-Api-Key: other\r\n\r\n";
+    evbuffer_add(input, raw.data(), raw.size());
+    REQUIRE(connection.onInput(input, output) == CONN_ACTION::KEEP_READING);
+    auto text = drainAll(output);
+    REQUIRE(countOf(text, "HTTP/1.1 200 ") == 2);
+    REQUIRE(countOf(text, "HTTP/1.1 429 ") == 1);
+    REQUIRE(text.find("Retry-After: 1\r\n") != string::npos);
+    REQUIRE(text.find("\r\n\r\n/b") != string::npos);
+    REQUIRE(text.find("/c") == string::npos);
+    REQUIRE(limiter.stats().m_limited == 1);
+
+    evbuffer_free(input);
+    evbuffer_free(output);
+}
+
+TEST_CASE("Blocking handlers run inline without an offloader", "[HttpConnection]")
+{
+    HttpConnectionOptions options;
+    const HttpHandler slow { ECHO_PATH_HANDLER, HANDLER_MODE::BLOCKING };
+    const HttpHandlerResolver resolver = [&slow](const HttpRequest&) { return &slow; };
+    HttpConnection connection(options, resolver);
+    struct evbuffer* input = evbuffer_new();
+    struct evbuffer* output = evbuffer_new();
+
+    string raw = "GET /x HTTP/1.1\r\n\r\nGET /y HTTP/1.1\r\n\r\n";
+    evbuffer_add(input, raw.data(), raw.size());
+    REQUIRE(connection.onInput(input, output) == CONN_ACTION::KEEP_READING);
+    REQUIRE_FALSE(connection.blocked());
+    REQUIRE(countOf(drainAll(output), "HTTP/1.1 200 OK") == 2);
+
+    evbuffer_free(input);
+    evbuffer_free(output);
+}
+
+TEST_CASE("Request scoped memory is recycled across keep-alive requests", "[HttpConnection]")
+{
+    HttpConnectionOptions options;
+    /* 处理函数在请求的 Arena 上申请临时数据 */
+    const HttpHandler scratch { [](const HttpRequest& Request, HttpResponse& Response)
+        {
+            std::pmr::string text(Request.arena());
+            for (auto& header : Request.m_headers)
+                text.append(header.m_name).append("=").append(header.m_value).append(";");
+            std::pmr::vector<std::pmr::string> copies(Request.arena());
+            for (int i = 0; i < 8; i++)
+                copies.emplace_back(text);
+            evbuffer_add(Response.body(), copies.back().data(), copies.back().size());
+        } };
+    const HttpHandlerResolver resolver = [&scratch](const HttpRequest&) { return &scratch; };
+    HttpConnection connection(options, resolver);
+    struct evbuffer* input = evbuffer_new();
+    struct evbuffer* output = evbuffer_new();
+
+    string raw = "GET / HTTP/1.1\r\nHost: example.com\r\nUser-Agent: test-client/1.0\r\nAccept: */*\r\n\r\n";
+    evbuffer_add(input, raw.data(), raw.size());
+    REQUIRE(connection.onInput(input, output) == CONN_ACTION::KEEP_READING);
+    const size_t blocks = connection.arena().blockCount();
+    REQUIRE(blocks > 0);
+    REQUIRE(connection.arena().used() == 0);
+
+    for (int i = 0; i < 200; i++)
+        evbuffer_add(input, raw.data(), raw.size());
+    REQUIRE(connection.onInput(input, output) == CONN_ACTION::KEEP_READING);
+    REQUIRE(connection.handledRequests() == 201);
+    REQUIRE(connection.arena().blockCount() == blocks);
+    auto text = drainAll(output);
+    REQUIRE(countOf(text, "Host=example.com;User-Agent=test-client/1.0;Accept=*/*;") == 201);
+
+    evbuffer_free(input);
+    evbuffer_free(output);
+}
@@ -0,0 +1,426 @@
+#include "ConcurrencyLimiter.h"
+#include "HttpCoroutine.h"
+#include "Infra/TimerWheel.h"
+#include "TestHttpHelpers.h"
+#include "catch2/catch.hpp"
+
+#include <event2/buffer.h>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace ToolKit;
+using namespace TestHttp;
+using namespace std;
+
+namespace
+{
+void feed(struct evbuffer* Buffer, const string& Data)
+{
+    evbuffer_add(Buffer, Data.data(), Data.size());
+}
+
+HttpHandler coroutineRoute(HttpCoroutineHandler Handler)
+{
+    HttpHandler handler;
+    handler.m_coroutine = make_shared<const CoroutineHandler>(CoroutineHandler { std::move(Handler) });
+    return handler;
+}
+
+/* 逐段读完请求体，把读到的段数与内容作为响应体 */
+HttpTask<> echoBody(CoroutineSession& Session)
+{
+    string body;
+    int pieces = 0;
+    for (auto chunk = co_await Session.read(); !chunk.empty(); chunk = co_await Session.read())
+    {
+        body.append(chunk);
+        pieces++;
+    }
+    auto text = to_string(pieces) + ":" + body;
+    evbuffer_add(Session.response().body(), text.data(), text.size());
+}
+
+const HttpHandler PLAIN_ROUTE { [](const HttpRequest& Request, HttpResponse& Response)
+    { evbuffer_add(Response.body(), "plain", 5); } };
+
+struct Buffers
+{
+    Buffers()
+            : m_input(evbuffer_new())
+            , m_output(evbuffer_new())
+    {
+    }
+    ~Buffers()
+    {
+        evbuffer_free(m_input);
+        evbuffer_free(m_output);
+    }
+    struct evbuffer* m_input;
+    struct evbuffer* m_output;
+};
+}   // namespace
+
+TEST_CASE("Coroutine handlers read a Content-Length body as it arrives", "[HttpCoroutine]")
+{
+    HttpConnectionOptions options;
+    const HttpHandler echo = coroutineRoute(echoBody);
+    const HttpHandlerResolver resolver = [&echo](const HttpRequest& Request)
+    { return Request.m_path == "/echo" ? &echo : &PLAIN_ROUTE; };
+    HttpConnection connection(options, resolver);
+    Buffers buffers;
+
+    feed(buffers.m_input, "POST /echo HTTP/1.1\r\nHost: x\r\nContent-Length: 11\r\n\r\nhello");
+    REQUIRE(connection.onInput(buffers.m_input, buffers.m_output) == CONN_ACTION::KEEP_READING);
+    REQUIRE(evbuffer_get_length(buffers.m_output) == 0);
+    REQUIRE(connection.pendingDeadline(buffers.m_input, buffers.m_output) == DEADLINE::BODY_READ);
+
+    /* 请求体的剩余部分与下一个流水线请求一起到达 */
+    feed(buffers.m_input, " world");
+    feed(buffers.m_input, "GET /plain HTTP/1.1\r\nHost: x\r\n\r\n");
+    REQUIRE(connection.onInput(buffers.m_input, buffers.m_output) == CONN_ACTION::KEEP_READING);
+    auto text = drainAll(buffers.m_output);
+    REQUIRE(text.find("Content-Length: 13\r\n") != string::npos);
+    REQUIRE(text.find("\r\n\r\n2:hello world") != string::npos);
+    REQUIRE(text.find("\r\n\r\nplain") != string::npos);
+    REQUIRE(connection.handledRequests() == 2);
+    REQUIRE(evbuffer_get_length(buffers.m_input) == 0);
+}
+
+TEST_CASE("Chunked request bodies are decoded incrementally and streamed back chunked", "[HttpCoroutine]")
+{
+    HttpConnectionOptions options;
+    const HttpHandler stream = coroutineRoute(
+        [](CoroutineSession& Session) -> HttpTask<>
+        {
+            Session.response().addHeader("Content-Type", "text/plain");
+            for (auto chunk = co_await Session.read(); !chunk.empty(); chunk = co_await Session.read())
+                co_await Session.write(chunk);
+        });
+    const HttpHandlerResolver resolver = [&stream](const HttpRequest&) { return &stream; };
+    HttpConnection connection(options, resolver);
+    Buffers buffers;
+
+    feed(buffers.m_input, "POST /up HTTP/1.1\r\nHost: x\r\nTransfer-Encoding: chunked\r\n\r\n5\r\nhel");
+    REQUIRE(connection.onInput(buffers.m_input, buffers.m_output) == CONN_ACTION::KEEP_READING);
+    auto head = drainAll(buffers.m_output);
+    REQUIRE(head.find("HTTP/1.1 200 OK\r\n") == 0);
+    REQUIRE(head.find("Transfer-Encoding: chunked\r\n") != string::npos);
+    REQUIRE(head.find("Content-Length") == string::npos);
+    REQUIRE(head.find("Content-Type: text/plain\r\n") != string::npos);
+    REQUIRE(head.find("\r\n\r\n3\r\nhel\r\n") != string::npos);
+
+    feed(buffers.m_input, "lo\r\n6;ext=1\r\n world\r\n0\r\nTrailer: x\r\n\r\n");
+    REQUIRE(connection.onInput(buffers.m_input, buffers.m_output) == CONN_ACTION::KEEP_READING);
+    REQUIRE(drainAll(buffers.m_output) == "2\r\nlo\r\n6\r\n world\r\n0\r\n\r\n");
+    REQUIRE(evbuffer_get_length(buffers.m_input) == 0);
+    REQUIRE(connection.handledRequests() == 1);
+    REQUIRE(connection.pendingDeadline(buffers.m_input, buffers.m_output) == DEADLINE::IDLE);
+}
+
+TEST_CASE("Malformed or oversized streamed bodies are rejected and close the connection", "[HttpCoroutine]")
+{
+    HttpConnectionOptions options;
+    options.m_maxBodyBytes = 8;
+    const HttpHandler echo = coroutineRoute(echoBody);
+    const HttpHandlerResolver resolver = [&echo](const HttpRequest&) { return &echo; };
+    HttpConnection connection(options, resolver);
+    Buffers buffers;
+
+    SECTION("Bad chunk size")
+    {
+        feed(buffers.m_input, "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\nzz\r\n");
+        REQUIRE(connection.onInput(buffers.m_input, buffers.m_output) == CONN_ACTION::CLOSE_AFTER_WRITE);
+        REQUIRE(drainAll(buffers.m_output).find("HTTP/1.1 400 ") == 0);
+    }
+    SECTION("Decoded length over MaxBodyBytes")
+    {
+        feed(buffers.m_input, "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n5\r\n12345\r\n5\r\n");
+        REQUIRE(connection.onInput(buffers.m_input, buffers.m_output) == CONN_ACTION::CLOSE_AFTER_WRITE);
+        auto text = drainAll(buffers.m_output);
+        REQUIRE(text.find("HTTP/1.1 413 ") == 0);
+        /* 处理函数读到的部分请求体不会再写出 */
+        REQUIRE(text.find("12345") == string::npos);
+    }
+    SECTION("Declared Content-Length over MaxBodyBytes never reaches the handler")
+    {
+        feed(buffers.m_input, "POST / HTTP/1.1\r\nContent-Length: 9\r\n\r\n");
+        REQUIRE(connection.onInput(buffers.m_input, buffers.m_output) == CONN_ACTION::CLOSE_AFTER_WRITE);
+        REQUIRE(drainAll(buffers.m_output).find("HTTP/1.1 413 ") == 0);
+    }
+}
+
+TEST_CASE("Streamed writes suspend while the output is over the high water mark", "[HttpCoroutine]")
+{
+    HttpConnectionOptions options;
+    options.m_outputHighWater = 256;
+    int written = 0;
+    const HttpHandler stream = coroutineRoute(
+        [&written](CoroutineSession& Session) -> HttpTask<>
+        {
+            const string block(200, 'x');
+            for (; written < 4; written++)
+                co_await Session.write(block);
+        });
+    const HttpHandlerResolver resolver = [&stream](const HttpRequest& Request)
+    { return Request.m_path == "/stream" ? &stream : &PLAIN_ROUTE; };
+    HttpConnection connection(options, resolver);
+    Buffers buffers;
+
+    feed(buffers.m_input, "GET /stream HTTP/1.1\r\nHost: x\r\n\r\nGET /plain HTTP/1.1\r\nHost: x\r\n\r\n");
+    REQUIRE(connection.onInput(buffers.m_input, buffers.m_output) == CONN_ACTION::PAUSE_READING);
+    REQUIRE(written == 1);
+    REQUIRE(connection.pendingDeadline(buffers.m_input, buffers.m_output) == DEADLINE::WRITE);
+
+    /* 写回调在输出降下来后重新处理输入，每次恢复写出一块后又超过高水位 */
+    string text;
+    for (int round = 0; round < 3; round++)
+    {
+        text += drainAll(buffers.m_output);
+        connection.onInput(buffers.m_input, buffers.m_output);
+    }
+    text += drainAll(buffers.m_output);
+    REQUIRE(written == 4);
+    REQUIRE(text.find("0\r\n\r\n") != string::npos);
+    /* 流式响应结束后继续处理积压的流水线请求 */
+    REQUIRE(text.find("\r\n\r\nplain") > text.find("0\r\n\r\n"));
+    REQUIRE(connection.handledRequests() == 2);
+}
+
+TEST_CASE("Offloaded work runs on the pool and resumes on the loop thread", "[HttpCoroutine]")
+{
+    HttpConnectionOptions options;
+    thread::id workerId;
+    const HttpHandler compute = coroutineRoute(
+        [&workerId](CoroutineSession& Session) -> HttpTask<>
+        {
+            auto sum = co_await Session.offload(
+                [&workerId]
+                {
+                    workerId = this_thread::get_id();
+                    return 40 + 2;
+                });
+            auto text = to_string(sum);
+            evbuffer_add(Session.response().body(), text.data(), text.size());
+            try
+            {
+                co_await Session.offload([]() -> int { throw runtime_error("boom"); });
+            }
+            catch (const runtime_error&)
+            {
+                evbuffer_add(Session.response().body(), ",caught", 7);
+            }
+        });
+    const HttpHandlerResolver resolver = [&compute](const HttpRequest&) { return &compute; };
+    Buffers buffers;
+
+    SECTION("With an offloader the connection blocks until each call completes")
+    {
+        BlockingCall* offloaded = nullptr;
+        HttpConnection connection(options, resolver, [&offloaded](BlockingCall& Call) { offloaded = &Call; });
+        feed(buffers.m_input, "GET / HTTP/1.1\r\nHost: x\r\n\r\n");
+        REQUIRE(connection.onInput(buffers.m_input, buffers.m_output) == CONN_ACTION::PAUSE_READING);
+        REQUIRE(connection.blocked());
+        REQUIRE(connection.pendingDeadline(buffers.m_input, buffers.m_output) == DEADLINE::NONE);
+
+        for (int call = 0; call < 2; call++)
+        {
+            REQUIRE(offloaded != nullptr);
+            auto* current = std::exchange(offloaded, nullptr);
+            thread worker([current] { current->run(); });
+            worker.join();
+            connection.onBlockingDone(buffers.m_input, buffers.m_output);
+        }
+        REQUIRE_FALSE(connection.blocked());
+        REQUIRE(workerId != this_thread::get_id());
+        REQUIRE(drainAll(buffers.m_output).find("\r\n\r\n42,caught") != string::npos);
+    }
+    SECTION("Without an offloader the work runs inline")
+    {
+        HttpConnection connection(options, resolver);
+        feed(buffers.m_input, "GET / HTTP/1.1\r\nHost: x\r\n\r\n");
+        REQUIRE(connection.onInput(buffers.m_input, buffers.m_output) == CONN_ACTION::KEEP_READING);
+        REQUIRE(workerId == this_thread::get_id());
+        REQUIRE(drainAll(buffers.m_output).find("\r\n\r\n42,caught") != string::npos);
+    }
+
+    SECTION("An exhausted concurrency limit fails the offload with 503")
+    {
+        ConcurrencyLimiterOptions limits;
+        limits.m_initialLimit = 1;
+        limits.m_maxLimit = 1;
+        ConcurrencyLimiter limiter(limits);
+        REQUIRE(limiter.tryAcquire());
+        options.m_limiter = &limiter;
+        BlockingCall* offloaded = nullptr;
+        HttpConnection connection(options, resolver, [&offloaded](BlockingCall& Call) { offloaded = &Call; });
+        feed(buffers.m_input, "GET / HTTP/1.1\r\nHost: x\r\n\r\n");
+        REQUIRE(connection.onInput(buffers.m_input, buffers.m_output) == CONN_ACTION::CLOSE_AFTER_WRITE);
+        REQUIRE(offloaded == nullptr);
+        auto text = drainAll(buffers.m_output);
+        REQUIRE(text.find("HTTP/1.1 503 ") == 0);
+        REQUIRE(text.find("Retry-After: 1\r\n") != string::npos);
+    }
+}
+
+TEST_CASE("Sleeping handlers resume from the timer and report through the notifier", "[HttpCoroutine]")
+{
+    HttpConnectionOptions options;
+    const HttpHandler delayed = coroutineRoute(
+        [](CoroutineSession& Session) -> HttpTask<>
+        {
+            co_await Session.write("a");
+            co_await Session.sleep(std::chrono::milliseconds(3));
+            co_await Session.write("b");
+        });
+    const HttpHandlerResolver resolver = [&delayed](const HttpRequest& Request)
+    { return Request.m_path == "/sleep" ? &delayed : &PLAIN_ROUTE; };
+    TimerWheel wheel;
+    vector<CONN_ACTION> actions;
+    HttpConnection connection(options, resolver, nullptr, [&actions](CONN_ACTION Action) { actions.push_back(Action); },
+        [&wheel](WheelTimer& Timer, std::chrono::milliseconds Delay) { wheel.arm(Timer, static_cast<uint64_t>(Delay.count())); });
+    Buffers buffers;
+
+    feed(buffers.m_input, "GET /sleep HTTP/1.1\r\nHost: x\r\n\r\n");
+    REQUIRE(connection.onInput(buffers.m_input, buffers.m_output) == CONN_ACTION::KEEP_READING);
+    REQUIRE(drainAll(buffers.m_output).find("\r\n\r\n1\r\na\r\n") != string::npos);
+    REQUIRE(connection.pendingDeadline(buffers.m_input, buffers.m_output) == DEADLINE::NONE);
+
+    /* 等待期间到达的流水线请求留在输入缓冲区中 */
+    feed(buffers.m_input, "GET /plain HTTP/1.1\r\nHost: x\r\n\r\n");
+    REQUIRE(connection.onInput(buffers.m_input, buffers.m_output) == CONN_ACTION::KEEP_READING);
+    REQUIRE(evbuffer_get_length(buffers.m_output) == 0);
+
+    REQUIRE(wheel.advance(2) == 0);
+    REQUIRE(actions.empty());
+    REQUIRE(wheel.advance(3) == 1);
+    REQUIRE(actions == vector<CONN_ACTION> { CONN_ACTION::PAUSE_READING });
+    REQUIRE(drainAll(buffers.m_output) == "1\r\nb\r\n0\r\n\r\n");
+
+    /* 写回调随后重新处理输入 */
+    REQUIRE(connection.onInput(buffers.m_input, buffers.m_output) == CONN_ACTION::KEEP_READING);
+    REQUIRE(drainAll(buffers.m_output).find("\r\n\r\nplain") != string::npos);
+    REQUIRE(connection.handledRequests() == 2);
+}
+
+TEST_CASE("Handler failures and unread bodies end the connection cleanly", "[HttpCoroutine]")
+{
+    HttpConnectionOptions options;
+    bool afterHead = false;
+    const HttpHandler failing = coroutineRoute(
+        [&afterHead](CoroutineSession& Session) -> HttpTask<>
+        {
+            if (afterHead)
+                co_await Session.write("partial");
+            throw runtime_error("handler failed");
+        });
+    const HttpHandler ignoring = coroutineRoute([](CoroutineSession& Session) -> HttpTask<> { co_return; });
+    const HttpHandlerResolver resolver = [&](const HttpRequest& Request)
+    { return Request.m_path == "/fail" ? &failing : &ignoring; };
+    HttpConnection connection(options, resolver);
+    Buffers buffers;
+
+    SECTION("An exception before the head is sent becomes a 500")
+    {
+        feed(buffers.m_input, "GET /fail HTTP/1.1\r\nHost: x\r\n\r\n");
+        REQUIRE(connection.onInput(buffers.m_input, buffers.m_output) == CONN_ACTION::CLOSE_AFTER_WRITE);
+        REQUIRE(drainAll(buffers.m_output).find("HTTP/1.1 500 ") == 0);
+    }
+    SECTION("An exception after the head is sent truncates the chunked response")
+    {
+        afterHead = true;
+        feed(buffers.m_input, "GET /fail HTTP/1.1\r\nHost: x\r\n\r\n");
+        REQUIRE(connection.onInput(buffers.m_input, buffers.m_output) == CONN_ACTION::CLOSE_AFTER_WRITE);
+        auto text = drainAll(buffers.m_output);
+        REQUIRE(text.find("7\r\npartial\r\n") != string::npos);
+        REQUIRE(text.find("0\r\n\r\n") == string::npos);
+    }
+    SECTION("A body the handler did not read closes the connection after the response")
+    {
+        feed(buffers.m_input, "POST /skip HTTP/1.1\r\nHost: x\r\nContent-Length: 4\r\n\r\nbody");
+        REQUIRE(connection.onInput(buffers.m_input, buffers.m_output) == CONN_ACTION::CLOSE_AFTER_WRITE);
+        auto text = drainAll(buffers.m_output);
+        REQUIRE(text.find("HTTP/1.1 200 OK\r\n") == 0);
+        REQUIRE(text.find("Connection: close\r\n") != string::npos);
+    }
+}
+
+TEST_CASE("Coroutine frames are recycled from the connection's pool", "[HttpCoroutine]")
+{
+    HttpConnectionOptions options;
+    vector<const void*> frames;
+    const HttpHandler handler = coroutineRoute(
+        [&frames](CoroutineSession& Session) -> HttpTask<>
+        {
+            /* 跨越挂起点的局部变量位于协程帧中 */
+            int local = 0;
+            co_await Session.read();
+            frames.push_back(&local);
+        });
+    const HttpHandlerResolver resolver = [&handler](const HttpRequest&) { return &handler; };
+    HttpConnection connection(options, resolver);
+    Buffers buffers;
+
+    for (int i = 0; i < 3; i++)
+        feed(buffers.m_input, "GET / HTTP/1.1\r\nHost: x\r\n\r\n");
+    REQUIRE(connection.onInput(buffers.m_input, buffers.m_output) == CONN_ACTION::KEEP_READING);
+    REQUIRE(frames.size() == 3);
+    REQUIRE(frames[1] == frames[0]);
+    REQUIRE(frames[2] == frames[0]);
+
+    /* 连接对象复用后仍使用同一个内存池 */
+    connection.reset();
+    drainAll(buffers.m_output);
+    feed(buffers.m_input, "GET / HTTP/1.1\r\nHost: x\r\n\r\n");
+    connection.onInput(buffers.m_input, buffers.m_output);
+    REQUIRE(frames.size() == 4);
+    REQUIRE(frames[3] == frames[0]);
+}
+
+namespace
+{
+/* 读完请求体并返回其长度的辅助协程，由处理函数 co_await */
+HttpTask<size_t> bodyLength(CoroutineSession& Session)
+{
+    size_t length = 0;
+    for (auto chunk = co_await Session.read(); !chunk.empty(); chunk = co_await Session.read())
+        length += chunk.size();
+    co_return length;
+}
+
+HttpTask<size_t> failingHelper()
+{
+    throw std::logic_error("helper failed");
+    co_return 0;
+}
+}   // namespace
+
+TEST_CASE("Handlers compose helper coroutines and see their results and exceptions", "[HttpCoroutine]")
+{
+    HttpConnectionOptions options;
+    const HttpHandler handler = coroutineRoute(
+        [](CoroutineSession& Session) -> HttpTask<>
+        {
+            auto length = co_await bodyLength(Session);
+            string text = to_string(length);
+            try
+            {
+                co_await failingHelper();
+            }
+            catch (const std::logic_error& e)
+            {
+                text += string(",") + e.what();
+            }
+            co_await Session.write(text);
+        });
+    const HttpHandlerResolver resolver = [&handler](const HttpRequest&) { return &handler; };
+    HttpConnection connection(options, resolver);
+    Buffers buffers;
+
+    feed(buffers.m_input, "PUT / HTTP/1.1\r\nHost: x\r\nContent-Length: 5\r\n\r\nab");
+    REQUIRE(connection.onInput(buffers.m_input, buffers.m_output) == CONN_ACTION::KEEP_READING);
+    feed(buffers.m_input, "cde");
+    REQUIRE(connection.onInput(buffers.m_input, buffers.m_output) == CONN_ACTION::KEEP_READING);
+    REQUIRE(drainAll(buffers.m_output).find("\r\n\r\nf\r\n5,helper failed\r\n0\r\n\r\n") != string::npos);
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "HttpConnection.h"
+
+#include <event2/buffer.h>
+#include <memory>
+#include <string>
+
+namespace TestHttp
+{
+/**
+ * @brief 取出并清空缓冲区中的全部数据
+ */
+inline std::string drainAll(struct evbuffer* Buffer)
+{
+    size_t len = evbuffer_get_length(Buffer);
+    std::string text(reinterpret_cast<const char*>(evbuffer_pullup(Buffer, -1)), len);
+    evbuffer_drain(Buffer, len);
+    return text;
+}
+
+/**
+ * @brief HTTP/1.1 响应中首部 Name 的值，没有该首部时返回空串
+ */
+inline std::string headerOf(const std::string& Response, const std::string& Name)
+{
+    auto pos = Response.find("\r\n" + Name + ": ");
+    if (pos == std::string::npos)
+        return std::string();
+    pos += Name.size() + 4;
+    return Response.substr(pos, Response.find("\r\n", pos) - pos);
+}
+
+inline std::string bodyOf(const std::string& Response)
+{
+    return Response.substr(Response.find("\r\n\r\n") + 4);
+}
+
+/**
+ * @brief 单个 HttpConnection 的测试夹具，请求经过连接完整地解析与序列化
+ * 所有请求都交给 m_handler；派生的夹具设置好 m_handler 与 m_options 之后调用 connect。
+ */
+struct ConnectionHarness
+{
+    ConnectionHarness()
+    {
+        m_resolver = [this](const ToolKit::HttpRequest&) { return &m_handler; };
+    }
+    ~ConnectionHarness()
+    {
+        m_connection.reset();
+        evbuffer_free(m_input);
+        evbuffer_free(m_output);
+    }
+    ConnectionHarness(const ConnectionHarness&) = delete;
+    const ConnectionHarness& operator=(const ConnectionHarness&) = delete;
+
+    void connect() { m_connection = std::make_unique<ToolKit::HttpConnection>(m_options, m_resolver); }
+
+    /**
+     * @brief 发送一个不带请求体的请求，返回连接写出的全部数据
+     */
+    std::string request(const std::string& Method, const std::string& Target, const std::string& Headers = "")
+    {
+        std::string raw = Method + " " + Target + " HTTP/1.1\r\nHost: x\r\n" + Headers + "\r\n";
+        evbuffer_add(m_input, raw.data(), raw.size());
+        m_connection->onInput(m_input, m_output);
+        return drainAll(m_output);
+    }
+
+    ToolKit::HttpHandler m_handler;
+    ToolKit::HttpHandlerResolver m_resolver;
+    ToolKit::HttpConnectionOptions m_options;
+    std::unique_ptr<ToolKit::HttpConnection> m_connection;
+    struct evbuffer* m_input { evbuffer_new() };
+    struct evbuffer* m_output { evbuffer_new() };
+};
+}   // namespace TestHttp
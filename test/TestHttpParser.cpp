@@ -0,0 +1,218 @@
+#include "HttpParser.h"
+#include "HttpResponse.h"
+#include "catch2/catch.hpp"
+
+#include <event2/buffer.h>
+#include <string>
+#include <vector>
+
+using namespace ToolKit;
+using namespace std;
+
+namespace
+{
+/**
+ * @brief 每个片段单独作为一个 chain 追加，用于模拟数据跨越多个内存块
+ */
+void addAsChains(struct evbuffer* Buffer, const vector<string>& Pieces)
+{
+    for (const auto& piece : Pieces)
+        evbuffer_add_reference(Buffer, piece.data(), piece.size(), nullptr, nullptr);
+}
+}   // namespace
+
+TEST_CASE("Parse a simple GET request", "[HttpParser]")
+{
+    struct evbuffer* input = evbuffer_new();
+    string raw = "GET /index.html?a=1 HTTP/1.1\r\nHost: localhost\r\nX-Trace:  abc \r\n\r\n";
+    evbuffer_add(input, raw.data(), raw.size());
+
+    HttpRequestParser parser;
+    HttpRequest request;
+    REQUIRE(parser.parse(input, request) == PARSE_STATUS::COMPLETE);
+    REQUIRE(request.m_method == "GET");
+    REQUIRE(request.m_target == "/index.html?a=1");
+    REQUIRE(request.m_path == "/index.html");
+    REQUIRE(request.m_query == "a=1");
+    REQUIRE(request.m_versionMinor == 1);
+    REQUIRE(request.m_headers.size() == 2);
+    REQUIRE(request.header("host") == "localhost");
+    REQUIRE(request.header("X-TRACE") == "abc");
+    REQUIRE(request.header("Missing").empty());
+    REQUIRE(request.m_keepAlive);
+
+    SECTION("Views point into the input buffer instead of copies")
+    {
+        auto* base = reinterpret_cast<const char*>(evbuffer_pullup(input, -1));
+        REQUIRE(request.m_method.data() == base);
+    }
+
+    parser.consume(input, request);
+    REQUIRE(evbuffer_get_length(input) == 0);
+    evbuffer_free(input);
+}
+
+TEST_CASE("Parse a request delivered one byte at a time", "[HttpParser]")
+{
+    struct evbuffer* input = evbuffer_new();
+    string raw = "POST /upload HTTP/1.1\r\nContent-Length: 5\r\n\r\nhello";
+
+    HttpRequestParser parser;
+    HttpRequest request;
+    for (size_t i = 0; i + 1 < raw.size(); i++)
+    {
+        evbuffer_add(input, raw.data() + i, 1);
+        REQUIRE(parser.parse(input, request) == PARSE_STATUS::NEED_MORE);
+    }
+    evbuffer_add(input, raw.data() + raw.size() - 1, 1);
+    REQUIRE(parser.parse(input, request) == PARSE_STATUS::COMPLETE);
+    REQUIRE(request.m_method == "POST");
+    REQUIRE(request.m_body == "hello");
+    evbuffer_free(input);
+}
+
+TEST_CASE("Parse a request split across buffer chains", "[HttpParser]")
+{
+    struct evbuffer* input = evbuffer_new();
+    vector<string> pieces { "GET / HTTP/1.1\r", "\nHost: a\r\n\r", "\n" };
+    addAsChains(input, pieces);
+
+    HttpRequestParser parser;
+    HttpRequest request;
+    REQUIRE(parser.parse(input, request) == PARSE_STATUS::COMPLETE);
+    REQUIRE(request.m_path == "/");
+    REQUIRE(request.header("Host") == "a");
+    parser.consume(input, request);
+    REQUIRE(evbuffer_get_length(input) == 0);
+    evbuffer_free(input);
+}
+
+TEST_CASE("Parse pipelined requests from one buffer", "[HttpParser]")
+{
+    struct evbuffer* input = evbuffer_new();
+    string raw = "GET /a HTTP/1.1\r\n\r\nGET /b HTTP/1.1\r\nConnection: close\r\n\r\n";
+    evbuffer_add(input, raw.data(), raw.size());
+
+    HttpRequestParser parser;
+    HttpRequest request;
+    REQUIRE(parser.parse(input, request) == PARSE_STATUS::COMPLETE);
+    REQUIRE(request.m_path == "/a");
+    REQUIRE(request.m_keepAlive);
+    parser.consume(input, request);
+
+    REQUIRE(parser.parse(input, request) == PARSE_STATUS::COMPLETE);
+    REQUIRE(request.m_path == "/b");
+    REQUIRE_FALSE(request.m_keepAlive);
+    parser.consume(input, request);
+    REQUIRE(parser.parse(input, request) == PARSE_STATUS::NEED_MORE);
+    evbuffer_free(input);
+}
+
+TEST_CASE("Parse a chunked request body", "[HttpParser]")
+{
+    struct evbuffer* input = evbuffer_new();
+    vector<string> pieces { "PUT /c HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n", "5;ext=1\r\nhello\r\n",
+        "7\r\n, world\r\n0\r\nX-Trailer: t\r\n", "\r\nGET /next HTTP/1.1\r\n\r\n" };
+
+    HttpRequestParser parser;
+    HttpRequest request;
+    for (size_t i = 0; i + 1 < pieces.size(); i++)
+    {
+        evbuffer_add_reference(input, pieces[i].data(), pieces[i].size(), nullptr, nullptr);
+        REQUIRE(parser.parse(input, request) == PARSE_STATUS::NEED_MORE);
+    }
+    evbuffer_add_reference(input, pieces.back().data(), pieces.back().size(), nullptr, nullptr);
+    REQUIRE(parser.parse(input, request) == PARSE_STATUS::COMPLETE);
+    REQUIRE(request.m_body == "hello, world");
+    parser.consume(input, request);
+
+    REQUIRE(parser.parse(input, request) == PARSE_STATUS::COMPLETE);
+    REQUIRE(request.m_path == "/next");
+    evbuffer_free(input);
+}
+
+TEST_CASE("Stream a chunked body chain by chain after parsing only the header", "[HttpParser]")
+{
+    struct evbuffer* input = evbuffer_new();
+    vector<string> pieces { "POST /up HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n", "7\r\nabc", "defg\r\n3\r",
+        "\nxyz\r\n0\r\n\r\nGET / HTTP/1.1\r\n\r\n" };
+    addAsChains(input, pieces);
+
+    HttpRequestParser parser;
+    HttpRequest request;
+    REQUIRE(parser.parseHeader(input, request) == PARSE_STATUS::COMPLETE);
+    REQUIRE(parser.chunked());
+    evbuffer_drain(input, parser.headLength());
+    parser.reset();
+
+    HttpBodyReader reader;
+    reader.start(0, true);
+    vector<string> chunks;
+    string_view chunk;
+    while (reader.next(input, chunk) == PARSE_STATUS::COMPLETE && !chunk.empty())
+        chunks.emplace_back(chunk);
+    /* 每段只来自一个内存块，块中的数据按原地址交出 */
+    REQUIRE(chunks == vector<string> { "abc", "defg", "xyz" });
+    REQUIRE(reader.done());
+    REQUIRE(reader.received() == 10);
+    REQUIRE(parser.parse(input, request) == PARSE_STATUS::COMPLETE);
+    REQUIRE(request.m_method == "GET");
+    evbuffer_free(input);
+}
+
+TEST_CASE("Reject malformed requests", "[HttpParser]")
+{
+    auto parseRaw = [](const string& Raw, size_t MaxHeaderBytes = DEFAULT_MAX_HEADER_BYTES)
+    {
+        struct evbuffer* input = evbuffer_new();
+        evbuffer_add(input, Raw.data(), Raw.size());
+        HttpRequestParser parser { MaxHeaderBytes, 16 };
+        HttpRequest request;
+        auto status = parser.parse(input, request);
+        evbuffer_free(input);
+        return status;
+    };
+
+    REQUIRE(parseRaw("G@T / HTTP/1.1\r\n\r\n") == PARSE_STATUS::BAD_REQUEST);
+    REQUIRE(parseRaw("GET / HTTP/1.1\r\nBad Header: x\r\n\r\n") == PARSE_STATUS::BAD_REQUEST);
+    REQUIRE(parseRaw("GET / HTTP/1.1\r\nA: b\r\n folded\r\n\r\n") == PARSE_STATUS::BAD_REQUEST);
+    REQUIRE(parseRaw("GET / HTTP/2.0\r\n\r\n") == PARSE_STATUS::VERSION_NOT_SUPPORTED);
+    REQUIRE(parseRaw("POST / HTTP/1.1\r\nContent-Length: 1\r\nTransfer-Encoding: chunked\r\n\r\n")
+        == PARSE_STATUS::BAD_REQUEST);
+    REQUIRE(parseRaw("POST / HTTP/1.1\r\nContent-Length: 1\r\nContent-Length: 2\r\n\r\n") == PARSE_STATUS::BAD_REQUEST);
+    REQUIRE(parseRaw("POST / HTTP/1.1\r\nTransfer-Encoding: gzip\r\n\r\n") == PARSE_STATUS::NOT_IMPLEMENTED);
+    REQUIRE(parseRaw("POST / HTTP/1.1\r\nContent-Length: 17\r\n\r\n") == PARSE_STATUS::PAYLOAD_TOO_LARGE);
+    REQUIRE(parseRaw("GET / HTTP/1.1\r\nX: " + string(64, 'a'), 32) == PARSE_STATUS::HEADER_TOO_LARGE);
+}
+
+TEST_CASE("HTTP/1.0 keep-alive negotiation", "[HttpParser]")
+{
+    struct evbuffer* input = evbuffer_new();
+    string raw = "GET / HTTP/1.0\r\n\r\nGET / HTTP/1.0\r\nConnection: Keep-Alive\r\n\r\n";
+    evbuffer_add(input, raw.data(), raw.size());
+
+    HttpRequestParser parser;
+    HttpRequest request;
+    REQUIRE(parser.parse(input, request) == PARSE_STATUS::COMPLETE);
+    REQUIRE_FALSE(request.m_keepAlive);
+    parser.consume(input, request);
+    REQUIRE(parser.parse(input, request) == PARSE_STATUS::COMPLETE);
+    REQUIRE(request.m_keepAlive);
+    evbuffer_free(input);
+}
+
+TEST_CASE("Serialize a response", "[HttpParser]")
+{
+    struct evbuffer* output = evbuffer_new();
+    HttpResponse response;
+    response.setStatus(404);
+    response.addHeader("Content-Type", "text/plain");
+    evbuffer_add(response.body(), "nope", 4);
+    response.setKeepAlive(false);
+    response.writeTo(output);
+
+    size_t len = evbuffer_get_length(output);
+    string text(reinterpret_cast<const char*>(evbuffer_pullup(output, -1)), len);
+    REQUIRE(text == "HTTP/1.1 404 Not Found\r\nContent-Length: 4\r\nConnection: close\r\nContent-Type: text/plain\r\n\r\nnope");
+    evbuffer_free(output);
+}
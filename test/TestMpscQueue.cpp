@@ -0,0 +1,81 @@
+#include "Infra/MpscQueue.h"
+#include "catch2/catch.hpp"
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace ToolKit;
+
+TEST_CASE("Bounded MPSC queue basic behaviour", "[MpscQueue]")
+{
+    MpscQueue<int> queue(3);
+    REQUIRE(queue.capacity() == 4);
+
+    int value = 0;
+    REQUIRE_FALSE(queue.tryPop(value));
+    for (int i = 0; i < 4; i++)
+        REQUIRE(queue.tryPush(i));
+    REQUIRE_FALSE(queue.tryPush(4));
+
+    REQUIRE(queue.tryPop(value));
+    REQUIRE(value == 0);
+    REQUIRE(queue.tryPush(4));
+    for (int i = 1; i <= 4; i++)
+    {
+        REQUIRE(queue.tryPop(value));
+        REQUIRE(value == i);
+    }
+    REQUIRE_FALSE(queue.tryPop(value));
+}
+
+TEST_CASE("MPSC queue destroys the elements it still holds", "[MpscQueue]")
+{
+    auto tracked = std::make_shared<int>(1);
+    std::shared_ptr<int> out;
+    {
+        MpscQueue<std::shared_ptr<int>> queue(8);
+        REQUIRE(queue.tryPush(tracked));
+        REQUIRE(queue.tryPush(std::shared_ptr<int>(tracked)));
+        REQUIRE(queue.tryPop(out));
+        REQUIRE(tracked.use_count() == 3);
+    }
+    /* 析构时未取出的元素同样被销毁 */
+    REQUIRE(tracked.use_count() == 2);
+}
+
+TEST_CASE("MPSC queue keeps per-producer order under contention", "[MpscQueue]")
+{
+    constexpr int PRODUCERS = 4;
+    constexpr int ITEMS = 100000;
+    MpscQueue<int> queue(256);
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < PRODUCERS; p++)
+        producers.emplace_back(
+            [&queue, p]
+            {
+                for (int i = 0; i < ITEMS; i++)
+                    while (!queue.tryPush(p * ITEMS + i))
+                        std::this_thread::yield();
+            });
+
+    std::vector<int> last(PRODUCERS, -1);
+    int received = 0;
+    bool ordered = true;
+    while (received < PRODUCERS * ITEMS)
+    {
+        int value;
+        if (!queue.tryPop(value))
+            continue;
+        int producer = value / ITEMS;
+        ordered = ordered && value % ITEMS == last[producer] + 1;
+        last[producer] = value % ITEMS;
+        received++;
+    }
+    for (auto& producer : producers)
+        producer.join();
+
+    REQUIRE(ordered);
+    REQUIRE(last == std::vector<int>(PRODUCERS, ITEMS - 1));
+}
@@ -0,0 +1,325 @@
+#include "EventStream.h"
+#include "HttpConnection.h"
+#include "PubSub.h"
+#include "WebSocket.h"
+#include "TestHttpHelpers.h"
+#include "catch2/catch.hpp"
+
+#include <event2/buffer.h>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace ToolKit;
+using namespace TestHttp;
+using namespace std;
+
+namespace
+{
+/**
+ * @brief 把投递任务攒起来，由测试在“Reactor 线程”上统一执行
+ */
+struct QueuedExecutor
+{
+    PubSub::Executor executor()
+    {
+        return [this](size_t Shard, SmallTask&& Task) { m_tasks.emplace_back(Shard, std::move(Task)); };
+    }
+
+    size_t runAll()
+    {
+        auto tasks = std::move(m_tasks);
+        m_tasks.clear();
+        for (auto& task : tasks)
+            task.second();
+        return tasks.size();
+    }
+
+    vector<pair<size_t, SmallTask>> m_tasks;
+};
+
+/**
+ * @brief 一个订阅者连同它的输出缓冲区与收到的通知
+ */
+struct TestSubscriber
+{
+    explicit TestSubscriber(STREAM_FORMAT Format = STREAM_FORMAT::RAW, size_t MaxPendingBytes = 0)
+    {
+        m_subscriber.m_output = m_output;
+        m_subscriber.m_format = Format;
+        m_subscriber.m_maxPendingBytes = MaxPendingBytes;
+        m_subscriber.m_notifier = &m_notifier;
+    }
+
+    ~TestSubscriber() { evbuffer_free(m_output); }
+
+    struct evbuffer* m_output { evbuffer_new() };
+    vector<CONN_ACTION> m_actions;
+    HttpActionNotifier m_notifier { [this](CONN_ACTION Action) { m_actions.push_back(Action); } };
+    PubSubSubscriber m_subscriber;
+};
+}   // namespace
+
+TEST_CASE("Stream messages are encoded per format", "[PubSub]")
+{
+    REQUIRE(formatStreamMessage(STREAM_FORMAT::RAW, "a\nb") == "a\nb");
+    REQUIRE(formatStreamMessage(STREAM_FORMAT::SSE, "hello") == "data: hello\n\n");
+    REQUIRE(formatStreamMessage(STREAM_FORMAT::SSE, "a\nb\n") == "data: a\ndata: b\ndata: \n\n");
+    REQUIRE(formatStreamMessage(STREAM_FORMAT::WEBSOCKET_TEXT, "hi") == string("\x81\x02hi"));
+    auto binary = formatStreamMessage(STREAM_FORMAT::WEBSOCKET_BINARY, string(300, 'x'));
+    REQUIRE(binary.size() == 304);
+    REQUIRE(binary.substr(0, 4) == string("\x82\x7e\x01\x2c", 4));
+}
+
+TEST_CASE("Publish reaches only the subscribers of the topic", "[PubSub]")
+{
+    QueuedExecutor queue;
+    PubSub hub(2, queue.executor());
+    TestSubscriber first, second, other;
+    hub.subscribe(first.m_subscriber, "news");
+    hub.subscribe(second.m_subscriber, "news");
+    hub.subscribe(second.m_subscriber, "news");
+    hub.subscribe(other.m_subscriber, "sport");
+    REQUIRE(second.m_subscriber.topics() == 1);
+
+    /* 没有 Reactor 时订阅者都在分片 0，分片 1 没有订阅者，不会收到投递 */
+    REQUIRE(hub.publish("news", "one") == 1);
+    REQUIRE(queue.m_tasks.size() == 1);
+    REQUIRE(queue.m_tasks.front().first == 0);
+    REQUIRE(queue.runAll() == 1);
+    REQUIRE(drainAll(first.m_output) == "one");
+    REQUIRE(drainAll(second.m_output) == "one");
+    REQUIRE(evbuffer_get_length(other.m_output) == 0);
+
+    /* 输出缓冲区由空变非空时通知连接布防写超时 */
+    REQUIRE(first.m_actions == vector<CONN_ACTION> { CONN_ACTION::KEEP_READING });
+
+    hub.unsubscribe(first.m_subscriber, "news");
+    hub.publish("news", "two");
+    queue.runAll();
+    REQUIRE(evbuffer_get_length(first.m_output) == 0);
+    REQUIRE(drainAll(second.m_output) == "two");
+
+    auto stats = hub.stats();
+    REQUIRE(stats.m_published == 2);
+    REQUIRE(stats.m_deliveries == 3);
+    REQUIRE(stats.m_subscriptions == 2);
+
+    hub.unsubscribeAll(second.m_subscriber);
+    hub.unsubscribeAll(other.m_subscriber);
+    REQUIRE(hub.publish("news", "three") == 0);
+    REQUIRE(queue.m_tasks.empty());
+}
+
+TEST_CASE("Large messages share one buffer across subscribers", "[PubSub]")
+{
+    QueuedExecutor queue;
+    PubSub hub(1, queue.executor());
+    vector<unique_ptr<TestSubscriber>> subscribers;
+    for (int i = 0; i < 8; i++)
+    {
+        subscribers.push_back(make_unique<TestSubscriber>());
+        hub.subscribe(subscribers.back()->m_subscriber, "feed");
+    }
+    const string payload(64 * 1024, 'p');
+    hub.publish("feed", payload);
+    queue.runAll();
+
+    const void* shared = nullptr;
+    for (auto& subscriber : subscribers)
+    {
+        struct evbuffer_iovec vec;
+        REQUIRE(evbuffer_peek(subscriber->m_output, -1, nullptr, &vec, 1) == 1);
+        REQUIRE(vec.iov_len == payload.size());
+        if (shared == nullptr)
+            shared = vec.iov_base;
+        /* 每个输出缓冲区引用同一块内存 */
+        REQUIRE(vec.iov_base == shared);
+        REQUIRE(drainAll(subscriber->m_output) == payload);
+    }
+}
+
+TEST_CASE("Subscribers with different formats get their own encoding", "[PubSub]")
+{
+    QueuedExecutor queue;
+    PubSub hub(1, queue.executor());
+    TestSubscriber raw(STREAM_FORMAT::RAW), sse(STREAM_FORMAT::SSE), ws(STREAM_FORMAT::WEBSOCKET_TEXT);
+    for (auto* subscriber : { &raw, &sse, &ws })
+        hub.subscribe(subscriber->m_subscriber, "t");
+    hub.publish("t", "x\ny");
+    queue.runAll();
+    REQUIRE(drainAll(raw.m_output) == "x\ny");
+    REQUIRE(drainAll(sse.m_output) == "data: x\ndata: y\n\n");
+    REQUIRE(drainAll(ws.m_output) == string("\x81\x03x\ny"));
+}
+
+TEST_CASE("Slow subscribers are dropped or disconnected", "[PubSub]")
+{
+    QueuedExecutor queue;
+    SECTION("disconnect")
+    {
+        PubSub hub(1, queue.executor());
+        TestSubscriber slow(STREAM_FORMAT::RAW, 10), fast(STREAM_FORMAT::RAW, 10);
+        hub.subscribe(slow.m_subscriber, "t");
+        hub.subscribe(slow.m_subscriber, "u");
+        hub.subscribe(fast.m_subscriber, "t");
+
+        /* 缓冲区为空时即使超过上限也放行 */
+        hub.publish("t", "0123456789ab");
+        queue.runAll();
+        drainAll(fast.m_output);
+        hub.publish("t", "xy");
+        queue.runAll();
+
+        REQUIRE(slow.m_subscriber.dropped() == 1);
+        REQUIRE(slow.m_subscriber.topics() == 0);
+        REQUIRE(evbuffer_get_length(slow.m_output) == 0);
+        REQUIRE(slow.m_actions == vector<CONN_ACTION> { CONN_ACTION::KEEP_READING, CONN_ACTION::CLOSE_AFTER_WRITE });
+        REQUIRE(drainAll(fast.m_output) == "xy");
+
+        auto stats = hub.stats();
+        REQUIRE(stats.m_dropped == 1);
+        REQUIRE(stats.m_disconnected == 1);
+        REQUIRE(stats.m_subscriptions == 1);
+    }
+    SECTION("drop only")
+    {
+        PubSubOptions options;
+        options.m_maxPendingBytes = 4;
+        options.m_disconnectSlow = false;
+        PubSub hub(1, queue.executor(), options);
+        TestSubscriber subscriber;
+        hub.subscribe(subscriber.m_subscriber, "t");
+        for (auto message : { "abc", "d", "efg", "h" })
+            hub.publish("t", message);
+        queue.runAll();
+        REQUIRE(drainAll(subscriber.m_output) == "abcd");
+        REQUIRE(subscriber.m_subscriber.dropped() == 2);
+        REQUIRE(subscriber.m_subscriber.topics() == 1);
+        hub.unsubscribeAll(subscriber.m_subscriber);
+    }
+}
+
+TEST_CASE("Unsubscribing keeps the remaining members reachable", "[PubSub]")
+{
+    QueuedExecutor queue;
+    PubSub hub(1, queue.executor());
+    vector<unique_ptr<TestSubscriber>> subscribers;
+    for (int i = 0; i < 5; i++)
+    {
+        subscribers.push_back(make_unique<TestSubscriber>());
+        hub.subscribe(subscribers.back()->m_subscriber, "a");
+        hub.subscribe(subscribers.back()->m_subscriber, "b");
+    }
+    /* 从中间、开头退订，再析构一个订阅者，末尾成员填补空位后下标仍然正确 */
+    hub.unsubscribe(subscribers[2]->m_subscriber, "a");
+    hub.unsubscribe(subscribers[0]->m_subscriber, "a");
+    subscribers[4].reset();
+    hub.unsubscribe(subscribers[3]->m_subscriber, "a");
+    hub.publish("a", "A");
+    hub.publish("b", "B");
+    queue.runAll();
+    REQUIRE(drainAll(subscribers[0]->m_output) == "B");
+    REQUIRE(drainAll(subscribers[1]->m_output) == "AB");
+    REQUIRE(drainAll(subscribers[2]->m_output) == "B");
+    REQUIRE(drainAll(subscribers[3]->m_output) == "B");
+    REQUIRE(hub.stats().m_subscriptions == 5);
+    for (auto& subscriber : subscribers)
+    {
+        if (subscriber)
+            hub.unsubscribeAll(subscriber->m_subscriber);
+    }
+}
+
+TEST_CASE("Event streams subscribe through the connection", "[PubSub]")
+{
+    QueuedExecutor queue;
+    PubSub hub(1, queue.executor());
+    HttpConnectionOptions options;
+    options.m_pubSub = &hub;
+
+    HttpHandler route;
+    auto handler = make_shared<EventStreamHandler>();
+    size_t closed = 0;
+    handler->m_onOpen = [](EventStreamSession& Session, const HttpRequest& Request)
+    {
+        Session.subscribe(Request.param("topic"));
+        Session.send("welcome");
+    };
+    handler->m_onClose = [&closed](EventStreamSession&) { closed++; };
+    route.m_eventStream = handler;
+    HttpHandlerResolver resolver = [&route](HttpRequest& Request)
+    {
+        Request.m_params.push_back({ "topic", "news" });
+        return &route;
+    };
+    vector<CONN_ACTION> actions;
+    HttpConnection connection(options, resolver, nullptr, [&actions](CONN_ACTION Action) { actions.push_back(Action); });
+
+    struct evbuffer* input = evbuffer_new();
+    struct evbuffer* output = evbuffer_new();
+    const string request = "GET /events HTTP/1.1\r\nHost: x\r\n\r\n";
+    evbuffer_add(input, request.data(), request.size());
+    REQUIRE(connection.onInput(input, output) == CONN_ACTION::KEEP_READING);
+    auto head = drainAll(output);
+    REQUIRE(head.find("HTTP/1.1 200 OK\r\n") == 0);
+    REQUIRE(head.find("Content-Type: text/event-stream\r\n") != string::npos);
+    REQUIRE(head.find("data: welcome\n\n") != string::npos);
+    REQUIRE(connection.pendingDeadline(input, output) == DEADLINE::NONE);
+
+    hub.publish("news", "hello");
+    queue.runAll();
+    REQUIRE(drainAll(output) == "data: hello\n\n");
+    REQUIRE(actions == vector<CONN_ACTION> { CONN_ACTION::KEEP_READING });
+
+    /* 对端之后发来的数据被丢弃 */
+    evbuffer_add(input, "ignored", 7);
+    REQUIRE(connection.onInput(input, output) == CONN_ACTION::KEEP_READING);
+    REQUIRE(evbuffer_get_length(input) == 0);
+
+    connection.reset();
+    REQUIRE(closed == 1);
+    REQUIRE(hub.stats().m_subscriptions == 0);
+
+    /* 其他方法得到 405 */
+    const string post = "POST /events HTTP/1.1\r\nHost: x\r\nContent-Length: 0\r\n\r\n";
+    evbuffer_add(input, post.data(), post.size());
+    connection.onInput(input, output);
+    auto response = drainAll(output);
+    REQUIRE(response.find("HTTP/1.1 405") == 0);
+    REQUIRE(response.find("Allow: GET\r\n") != string::npos);
+    connection.reset();
+    evbuffer_free(input);
+    evbuffer_free(output);
+}
+
+TEST_CASE("WebSocket sessions receive published messages as frames", "[PubSub]")
+{
+    QueuedExecutor queue;
+    PubSub hub(1, queue.executor());
+    HttpConnectionOptions options;
+    options.m_pubSub = &hub;
+    HttpActionNotifier notifier = [](CONN_ACTION) {};
+    WebSocketSession session(options, &notifier);
+
+    auto handler = make_shared<WebSocketHandler>();
+    handler->m_pushOpcode = WS_OPCODE::BINARY;
+    handler->m_onOpen = [](WebSocketSession& Session, const HttpRequest&) { REQUIRE(Session.subscribe("ticks")); };
+    HttpRequest request;
+    struct evbuffer* output = evbuffer_new();
+    session.open(handler, request, output);
+    drainAll(output);
+
+    hub.publish("ticks", "42");
+    queue.runAll();
+    REQUIRE(drainAll(output) == string("\x82\x02" "42"));
+
+    /* 发出关闭帧后退订，不会在关闭帧之后再推送数据帧 */
+    session.close();
+    drainAll(output);
+    REQUIRE(hub.publish("ticks", "43") == 0);
+    REQUIRE(!session.subscribe("ticks"));
+    session.reset();
+    evbuffer_free(output);
+}
@@ -0,0 +1,231 @@
+#include "RateLimiter.h"
+#include "catch2/catch.hpp"
+
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <netinet/in.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace ToolKit;
+using namespace std;
+
+namespace
+{
+RateLimiterOptions testOptions()
+{
+    RateLimiterOptions options;
+    options.m_rate = 10;
+    options.m_burst = 5;
+    return options;
+}
+
+uint64_t ipv4Key(const char* Address)
+{
+    struct sockaddr_in addr { };
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(1234);
+    inet_pton(AF_INET, Address, &addr.sin_addr);
+    return RateLimiter::addressKey(reinterpret_cast<struct sockaddr*>(&addr));
+}
+
+uint64_t ipv6Key(const char* Address, uint16_t Port = 1234)
+{
+    struct sockaddr_in6 addr { };
+    addr.sin6_family = AF_INET6;
+    addr.sin6_port = htons(Port);
+    inet_pton(AF_INET6, Address, &addr.sin6_addr);
+    return RateLimiter::addressKey(reinterpret_cast<struct sockaddr*>(&addr));
+}
+}   // namespace
+
+TEST_CASE("A client gets its burst and then tokens at the configured rate", "[RateLimiter]")
+{
+    RateLimiter limiter(testOptions());
+    auto now = chrono::steady_clock::now();
+
+    for (int i = 0; i < 5; i++)
+        REQUIRE(limiter.allow(7, now));
+    REQUIRE_FALSE(limiter.allow(7, now));
+
+    /* 10 个每秒，100ms 补充一个令牌 */
+    now += chrono::milliseconds(99);
+    REQUIRE_FALSE(limiter.allow(7, now));
+    now += chrono::milliseconds(1);
+    REQUIRE(limiter.allow(7, now));
+    REQUIRE_FALSE(limiter.allow(7, now));
+
+    /* 长时间空闲后桶装满，但不超过容量 */
+    now += chrono::seconds(10);
+    for (int i = 0; i < 5; i++)
+        REQUIRE(limiter.allow(7, now));
+    REQUIRE_FALSE(limiter.allow(7, now));
+
+    auto stats = limiter.stats();
+    REQUIRE(stats.m_allowed == 11);
+    REQUIRE(stats.m_limited == 4);
+    REQUIRE(stats.m_entries == 1);
+}
+
+TEST_CASE("Clients are limited independently", "[RateLimiter]")
+{
+    RateLimiter limiter(testOptions());
+    auto now = chrono::steady_clock::now();
+    for (int i = 0; i < 5; i++)
+        REQUIRE(limiter.allow(1, now));
+    REQUIRE_FALSE(limiter.allow(1, now));
+    for (int i = 0; i < 5; i++)
+        REQUIRE(limiter.allow(2, now));
+    /* 无法识别的客户端不限速 */
+    for (int i = 0; i < 100; i++)
+        REQUIRE(limiter.allow(0, now));
+    REQUIRE(limiter.stats().m_entries == 2);
+}
+
+TEST_CASE("Burst defaults to one second worth of tokens", "[RateLimiter]")
+{
+    RateLimiterOptions options;
+    options.m_rate = 3;
+    RateLimiter limiter(options);
+    auto now = chrono::steady_clock::now();
+    for (int i = 0; i < 3; i++)
+        REQUIRE(limiter.allow(9, now));
+    REQUIRE_FALSE(limiter.allow(9, now));
+}
+
+TEST_CASE("Address keys ignore the port and fold mapped IPv4 addresses", "[RateLimiter]")
+{
+    REQUIRE(ipv4Key("10.0.0.1") != 0);
+    REQUIRE(ipv4Key("10.0.0.1") == ipv4Key("10.0.0.1"));
+    REQUIRE(ipv4Key("10.0.0.1") != ipv4Key("10.0.0.2"));
+    REQUIRE(ipv6Key("::ffff:10.0.0.1") == ipv4Key("10.0.0.1"));
+    REQUIRE(ipv6Key("2001:db8::1") == ipv6Key("2001:db8::1", 80));
+    REQUIRE(ipv6Key("2001:db8::1") != ipv6Key("2001:db8::2"));
+    REQUIRE(ipv6Key("2001:db8::1") != ipv4Key("10.0.0.1"));
+
+    struct sockaddr local { };
+    local.sa_family = AF_UNIX;
+    REQUIRE(RateLimiter::addressKey(&local) == 0);
+    REQUIRE(RateLimiter::addressKey(nullptr) == 0);
+}
+
+TEST_CASE("Requests with the configured header are charged to the address and the header value", "[RateLimiter]")
+{
+    auto options = testOptions();
+    options.m_header = "X-Api-Key";
+    RateLimiter limiter(options);
+    auto now = chrono::steady_clock::now();
+    auto withKey = [](const char* Value)
+    {
+        HttpRequest request;
+        request.m_headers.push_back({ "x-api-key", Value });
+        return request;
+    };
+    const auto alpha = withKey("alpha");
+
+    SECTION("Rotating header values do not escape the address bucket")
+    {
+        for (int i = 0; i < 5; i++)
+            REQUIRE(limiter.allowRequest(withKey(to_string(i).c_str()), 42, now));
+        REQUIRE_FALSE(limiter.allowRequest(withKey("fresh"), 42, now));
+        REQUIRE_FALSE(limiter.allowRequest(HttpRequest(), 42, now));
+    }
+
+    SECTION("One header value is limited across addresses")
+    {
+        for (uint64_t address = 100; address < 105; address++)
+            REQUIRE(limiter.allowRequest(alpha, address, now));
+        REQUIRE_FALSE(limiter.allowRequest(alpha, 105, now));
+        /* 同一地址不带首部的请求只受地址桶限制 */
+        REQUIRE(limiter.allowRequest(HttpRequest(), 105, now));
+    }
+
+    SECTION("Without a configured header only the address is charged")
+    {
+        RateLimiter byAddress(testOptions());
+        now = chrono::steady_clock::now();
+        for (int i = 0; i < 5; i++)
+            REQUIRE(byAddress.allowRequest(alpha, 42, now));
+        REQUIRE_FALSE(byAddress.allowRequest(alpha, 42, now));
+        REQUIRE(byAddress.allowRequest(alpha, 43, now));
+        REQUIRE(byAddress.stats().m_entries == 2);
+    }
+}
+
+TEST_CASE("A full table only evicts clients whose bucket has refilled", "[RateLimiter]")
+{
+    auto options = testOptions();
+    options.m_shards = 1;
+    options.m_slotsPerShard = 8;
+    options.m_header = "X-Api-Key";
+    RateLimiter limiter(options);
+    auto now = chrono::steady_clock::now();
+
+    /* 8 个客户端占满唯一的探测范围并耗尽令牌，客户端 1 最久未活跃 */
+    for (uint64_t key = 1; key <= 8; key++)
+    {
+        now += chrono::milliseconds(1);
+        for (int i = 0; i < 5; i++)
+            REQUIRE(limiter.allow(key, now));
+    }
+    REQUIRE(limiter.stats().m_entries == 8);
+
+    /* 正在限速中的桶不能被挤掉：新地址被拒绝，新首部值只按地址限速 */
+    REQUIRE_FALSE(limiter.allow(100, now));
+    HttpRequest request;
+    request.m_headers.push_back({ "X-Api-Key", "new" });
+    REQUIRE(limiter.allowRequest(request, 0, now));
+    auto stats = limiter.stats();
+    REQUIRE(stats.m_evictions == 0);
+    REQUIRE(stats.m_saturated == 2);
+
+    /* 桶都装满之后挤占 tat 最早的客户端 1 */
+    now += chrono::seconds(1);
+    REQUIRE(limiter.allow(100, now));
+    REQUIRE(limiter.stats().m_evictions == 1);
+    /* 客户端 2 仍在表中 */
+    REQUIRE(limiter.allow(2, now));
+    REQUIRE(limiter.stats().m_evictions == 1);
+    /* 客户端 1 回来时挤掉的是空闲的客户端 3，而不是刚刚活跃过的 100 与 2 */
+    REQUIRE(limiter.allow(1, now));
+    REQUIRE(limiter.stats().m_evictions == 2);
+    REQUIRE(limiter.allow(100, now));
+    REQUIRE(limiter.allow(2, now));
+    REQUIRE(limiter.stats().m_evictions == 2);
+    REQUIRE(limiter.stats().m_entries == 8);
+}
+
+TEST_CASE("Concurrent callers never exceed the burst", "[RateLimiter]")
+{
+    RateLimiterOptions options;
+    options.m_rate = 0.001;
+    options.m_burst = 100;
+    options.m_shards = 4;
+    options.m_slotsPerShard = 64;
+    RateLimiter limiter(options);
+    constexpr int THREADS = 4;
+    constexpr int ROUNDS = 2000;
+    constexpr uint64_t CLIENTS = 16;
+    const auto now = chrono::steady_clock::now();
+    atomic<uint64_t> allowed { 0 };
+    vector<thread> workers;
+    for (int t = 0; t < THREADS; t++)
+        workers.emplace_back(
+            [&, t]
+            {
+                for (int i = 0; i < ROUNDS; i++)
+                {
+                    if (limiter.allow(ipv4Key("192.0.2.1") + (i + t) % CLIENTS, now))
+                        allowed.fetch_add(1);
+                }
+            });
+    for (auto& worker : workers)
+        worker.join();
+
+    auto stats = limiter.stats();
+    REQUIRE(stats.m_allowed + stats.m_limited == THREADS * ROUNDS);
+    REQUIRE(stats.m_evictions == 0);
+    REQUIRE(allowed.load() == CLIENTS * 100);
+}
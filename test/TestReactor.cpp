@@ -0,0 +1,330 @@
+#include "Reactor.h"
+#include "catch2/catch.hpp"
+
+#include <arpa/inet.h>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <netinet/in.h>
+#include <sched.h>
+#include <set>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace ToolKit;
+
+TEST_CASE("Reactors receive handed off fds on their own threads", "[Reactor]")
+{
+    auto backend = GENERATE(IO_BACKEND::LIBEVENT, IO_BACKEND::EPOLL, IO_BACKEND::URING);
+    constexpr int REACTORS = 3;
+    constexpr int PRODUCERS = 4;
+    constexpr int FDS_PER_PRODUCER = 200;
+
+    std::mutex mutex;
+    std::condition_variable done;
+    std::map<size_t, std::set<std::thread::id>> threadsOfReactor;
+    int handled = 0;
+
+    const Reactor::ConnectionHandler handler = [&](Reactor& Owner, evutil_socket_t Fd)
+    {
+        evutil_closesocket(Fd);
+        std::lock_guard<std::mutex> lock(mutex);
+        threadsOfReactor[Owner.index()].insert(std::this_thread::get_id());
+        if (++handled == PRODUCERS * FDS_PER_PRODUCER)
+            done.notify_one();
+    };
+
+    std::vector<std::unique_ptr<Reactor>> reactors;
+    for (int i = 0; i < REACTORS; i++)
+    {
+        reactors.emplace_back(std::make_unique<Reactor>(i, handler, 16, backend));
+        REQUIRE(reactors.back()->start());
+    }
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < PRODUCERS; p++)
+        producers.emplace_back(
+            [&reactors, p]
+            {
+                for (int i = 0; i < FDS_PER_PRODUCER; i++)
+                {
+                    int pair[2];
+                    socketpair(AF_UNIX, SOCK_STREAM, 0, pair);
+                    close(pair[1]);
+                    auto& reactor = reactors[(p + i) % REACTORS];
+                    /* 队列容量很小，满了就等待 Reactor 取走 */
+                    while (!reactor->post(pair[0]))
+                        std::this_thread::yield();
+                }
+            });
+    for (auto& producer : producers)
+        producer.join();
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        REQUIRE(done.wait_for(lock, std::chrono::seconds(10), [&] { return handled == PRODUCERS * FDS_PER_PRODUCER; }));
+    }
+
+    std::set<std::thread::id> allThreads;
+    size_t handedOff = 0;
+    for (auto& reactor : reactors)
+    {
+        REQUIRE(threadsOfReactor[reactor->index()].size() == 1);
+        allThreads.insert(*threadsOfReactor[reactor->index()].begin());
+        handedOff += reactor->handedOff();
+    }
+    REQUIRE(allThreads.size() == REACTORS);
+    REQUIRE(allThreads.count(std::this_thread::get_id()) == 0);
+    REQUIRE(handedOff == PRODUCERS * FDS_PER_PRODUCER);
+
+    reactors.clear();
+}
+
+TEST_CASE("Stopping a reactor is idempotent and safe before start", "[Reactor]")
+{
+    auto backend = GENERATE(IO_BACKEND::LIBEVENT, IO_BACKEND::EPOLL, IO_BACKEND::URING);
+    const Reactor::ConnectionHandler handler = [](Reactor&, evutil_socket_t Fd) { evutil_closesocket(Fd); };
+    Reactor idle(0, handler);
+    idle.stop();
+
+    Reactor running(1, handler, Reactor::DEFAULT_QUEUE_CAPACITY, backend);
+    REQUIRE(running.start());
+    running.stop();
+    running.stop();
+}
+
+TEST_CASE("Reactors share one port through SO_REUSEPORT listeners", "[Reactor]")
+{
+    auto backend = GENERATE(IO_BACKEND::LIBEVENT, IO_BACKEND::EPOLL, IO_BACKEND::URING);
+    constexpr int REACTORS = 2;
+    constexpr int CLIENTS = 64;
+
+    std::mutex mutex;
+    std::condition_variable done;
+    std::map<size_t, std::set<std::thread::id>> threadsOfReactor;
+    int handled = 0;
+    const Reactor::ConnectionHandler handler = [&](Reactor& Owner, evutil_socket_t Fd)
+    {
+        evutil_closesocket(Fd);
+        std::lock_guard<std::mutex> lock(mutex);
+        threadsOfReactor[Owner.index()].insert(std::this_thread::get_id());
+        if (++handled == CLIENTS)
+            done.notify_one();
+    };
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    std::vector<std::unique_ptr<Reactor>> reactors;
+    for (int i = 0; i < REACTORS; i++)
+    {
+        reactors.emplace_back(std::make_unique<Reactor>(i, handler, Reactor::DEFAULT_QUEUE_CAPACITY, backend));
+        REQUIRE(reactors.back()->listen((const struct sockaddr*)&addr, sizeof(addr), 128));
+        /* 第一个监听套接字绑定随机端口，其余 Reactor 复用同一端口 */
+        socklen_t len = sizeof(addr);
+        getsockname(reactors.back()->listenFd(), (struct sockaddr*)&addr, &len);
+        REQUIRE(reactors.back()->start());
+    }
+
+    for (int i = 0; i < CLIENTS; i++)
+    {
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        REQUIRE(connect(fd, (const struct sockaddr*)&addr, sizeof(addr)) == 0);
+        close(fd);
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        REQUIRE(done.wait_for(lock, std::chrono::seconds(10), [&] { return handled == CLIENTS; }));
+    }
+    size_t accepted = 0;
+    for (auto& reactor : reactors)
+    {
+        /* 源端口各不相同，内核哈希后每个监听套接字都应分到连接 */
+        REQUIRE(reactor->accepted() > 0);
+        REQUIRE(reactor->handedOff() == 0);
+        REQUIRE(threadsOfReactor[reactor->index()].size() == 1);
+        accepted += reactor->accepted();
+    }
+    REQUIRE(accepted == CLIENTS);
+}
+
+TEST_CASE("A pinned reactor runs on its CPU and tags its listener with it", "[Reactor]")
+{
+    auto backend = GENERATE(IO_BACKEND::LIBEVENT, IO_BACKEND::EPOLL, IO_BACKEND::URING);
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    REQUIRE(sched_getaffinity(0, sizeof(allowed), &allowed) == 0);
+    int cpu = 0;
+    while (!CPU_ISSET(cpu, &allowed))
+        cpu++;
+
+    const Reactor::ConnectionHandler handler = [](Reactor&, evutil_socket_t Fd) { evutil_closesocket(Fd); };
+    Reactor reactor(0, handler, Reactor::DEFAULT_QUEUE_CAPACITY, backend);
+    reactor.setCpuAffinity(cpu);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    REQUIRE(reactor.listen((const struct sockaddr*)&addr, sizeof(addr), 16));
+    int incomingCpu = -1;
+    socklen_t len = sizeof(incomingCpu);
+    REQUIRE(getsockopt(reactor.listenFd(), SOL_SOCKET, SO_INCOMING_CPU, &incomingCpu, &len) == 0);
+    REQUIRE(incomingCpu == cpu);
+    REQUIRE(reactor.start());
+
+    std::promise<int> ranOn;
+    reactor.runInLoop([&] { ranOn.set_value(sched_getcpu()); });
+    auto result = ranOn.get_future();
+    REQUIRE(result.wait_for(std::chrono::seconds(10)) == std::future_status::ready);
+    REQUIRE(result.get() == cpu);
+}
+
+TEST_CASE("Completions posted from other threads run on the reactor thread in order", "[Reactor]")
+{
+    auto backend = GENERATE(IO_BACKEND::LIBEVENT, IO_BACKEND::EPOLL, IO_BACKEND::URING);
+    constexpr int PRODUCERS = 4;
+    constexpr int TASKS_PER_PRODUCER = 2000;
+
+    const Reactor::ConnectionHandler handler = [](Reactor&, evutil_socket_t Fd) { evutil_closesocket(Fd); };
+    /* 队列容量远小于任务数，覆盖队列满时的重试路径 */
+    Reactor reactor(0, handler, 16, backend);
+    REQUIRE(reactor.start());
+
+    std::mutex mutex;
+    std::condition_variable done;
+    std::set<std::thread::id> threads;
+    std::vector<int> lastSeen(PRODUCERS, -1);
+    bool ordered = true;
+    int handled = 0;
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < PRODUCERS; p++)
+        producers.emplace_back(
+            [&, p]
+            {
+                for (int i = 0; i < TASKS_PER_PRODUCER; i++)
+                    reactor.runInLoop(
+                        [&, p, i]
+                        {
+                            /* 任务只在 Reactor 线程上执行，这里的锁只为主线程读取结果 */
+                            std::lock_guard<std::mutex> lock(mutex);
+                            threads.insert(std::this_thread::get_id());
+                            ordered = ordered && lastSeen[p] == i - 1;
+                            lastSeen[p] = i;
+                            if (++handled == PRODUCERS * TASKS_PER_PRODUCER)
+                                done.notify_one();
+                        });
+            });
+    for (auto& producer : producers)
+        producer.join();
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        REQUIRE(done.wait_for(lock, std::chrono::seconds(10), [&] { return handled == PRODUCERS * TASKS_PER_PRODUCER; }));
+        REQUIRE(ordered);
+        REQUIRE(threads.size() == 1);
+        REQUIRE(threads.count(std::this_thread::get_id()) == 0);
+    }
+    reactor.stop();
+}
+
+TEST_CASE("Reactor threads never wait on full completion queues", "[Reactor]")
+{
+    auto backend = GENERATE(IO_BACKEND::LIBEVENT, IO_BACKEND::EPOLL, IO_BACKEND::URING);
+    constexpr int TASKS = 2000;
+
+    const Reactor::ConnectionHandler handler = [](Reactor&, evutil_socket_t Fd) { evutil_closesocket(Fd); };
+    /* 两个 Reactor 同时向自己和对方投递远超队列容量的任务，等待队列腾出空间会自锁或互锁 */
+    Reactor first(0, handler, 16, backend);
+    Reactor second(1, handler, 16, backend);
+    REQUIRE(first.start());
+    REQUIRE(second.start());
+    Reactor* reactors[] = { &first, &second };
+
+    std::mutex mutex;
+    std::condition_variable done;
+    /* 按（来源, 目标）记录最后执行的序号，检查补投不打乱顺序 */
+    int lastSeen[2][2] = { { -1, -1 }, { -1, -1 } };
+    bool ordered = true;
+    bool onTarget = true;
+    int handled = 0;
+
+    for (int source = 0; source < 2; source++)
+        reactors[source]->runInLoop(
+            [&, source]
+            {
+                for (int i = 0; i < TASKS; i++)
+                {
+                    for (int target = 0; target < 2; target++)
+                        reactors[target]->runInLoop(
+                            [&, source, target, i]
+                            {
+                                std::lock_guard<std::mutex> lock(mutex);
+                                onTarget = onTarget && Reactor::current() == reactors[target];
+                                ordered = ordered && lastSeen[source][target] == i - 1;
+                                lastSeen[source][target] = i;
+                                if (++handled == 4 * TASKS)
+                                    done.notify_one();
+                            });
+                }
+            });
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        REQUIRE(done.wait_for(lock, std::chrono::seconds(10), [&] { return handled == 4 * TASKS; }));
+        REQUIRE(ordered);
+        REQUIRE(onTarget);
+    }
+    first.stop();
+    second.stop();
+}
+
+TEST_CASE("Reactor timers fire on the reactor thread after their delay", "[Reactor]")
+{
+    auto backend = GENERATE(IO_BACKEND::LIBEVENT, IO_BACKEND::EPOLL, IO_BACKEND::URING);
+    const Reactor::ConnectionHandler handler = [](Reactor&, evutil_socket_t Fd) { evutil_closesocket(Fd); };
+    Reactor reactor(0, handler, Reactor::DEFAULT_QUEUE_CAPACITY, backend);
+    REQUIRE(reactor.enableTimers(std::chrono::milliseconds(5)));
+    REQUIRE(reactor.start());
+
+    std::mutex mutex;
+    std::condition_variable done;
+    std::thread::id firedOn;
+    bool fired = false;
+    bool cancelledFired = false;
+    WheelTimer timer(
+        [&]
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            firedOn = std::this_thread::get_id();
+            fired = true;
+            done.notify_one();
+        });
+    WheelTimer cancelled([&] { cancelledFired = true; });
+
+    auto armedAt = std::chrono::steady_clock::now();
+    reactor.runInLoop(
+        [&]
+        {
+            reactor.armTimer(timer, std::chrono::milliseconds(40));
+            reactor.armTimer(cancelled, std::chrono::milliseconds(20));
+            reactor.cancelTimer(cancelled);
+        });
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        REQUIRE(done.wait_for(lock, std::chrono::seconds(10), [&] { return fired; }));
+        REQUIRE(std::chrono::steady_clock::now() - armedAt >= std::chrono::milliseconds(35));
+        REQUIRE(firedOn != std::this_thread::get_id());
+    }
+    reactor.stop();
+    REQUIRE_FALSE(cancelledFired);
+}
@@ -0,0 +1,265 @@
+#include "ResponseCache.h"
+#include "TestHttpHelpers.h"
+#include "catch2/catch.hpp"
+
+#include <chrono>
+#include <event2/buffer.h>
+#include <memory>
+#include <string>
+#include <thread>
+
+using namespace ToolKit;
+using namespace TestHttp;
+using namespace std;
+
+namespace
+{
+/**
+ * @brief 经过 HttpConnection 的缓存：处理函数记录被调用的次数，响应首部由各用例设置
+ */
+struct CacheFixture : ConnectionHarness
+{
+    explicit CacheFixture(ResponseCacheOptions Options = defaultOptions())
+            : m_cache(std::move(Options))
+    {
+        m_options.m_responseCache = &m_cache;
+        m_handler.m_handler = [this](const HttpRequest& Request, HttpResponse& Response)
+        {
+            m_calls++;
+            if (!m_cacheControl.empty())
+                Response.addHeader("Cache-Control", m_cacheControl);
+            for (auto& [name, value] : m_extraHeaders)
+                Response.addHeader(name, value);
+            string body = m_body.empty() ? "body of " + string(Request.m_target) : m_body;
+            evbuffer_add(Response.body(), body.data(), body.size());
+        };
+        connect();
+    }
+
+    static ResponseCacheOptions defaultOptions()
+    {
+        ResponseCacheOptions options;
+        options.m_maxBytes = 1024 * 1024;
+        options.m_shards = 4;
+        options.m_vary = { "Accept-Encoding" };
+        return options;
+    }
+
+    ResponseCache m_cache;
+    int m_calls { 0 };
+    string m_cacheControl { "max-age=60" };
+    vector<pair<string, string>> m_extraHeaders;
+    string m_body;
+};
+}   // namespace
+
+TEST_CASE("Cacheable responses are served without calling the handler", "[ResponseCache]")
+{
+    CacheFixture fixture;
+    auto first = fixture.request("GET", "/a?x=1");
+    REQUIRE(first.rfind("HTTP/1.1 200 OK\r\n", 0) == 0);
+    REQUIRE(bodyOf(first) == "body of /a?x=1");
+    REQUIRE_FALSE(headerOf(first, "ETag").empty());
+
+    auto second = fixture.request("GET", "/a?x=1");
+    REQUIRE(fixture.m_calls == 1);
+    REQUIRE(bodyOf(second) == "body of /a?x=1");
+    REQUIRE(headerOf(second, "Content-Length") == "14");
+    REQUIRE(headerOf(second, "Cache-Control") == "max-age=60");
+    REQUIRE(headerOf(second, "ETag") == headerOf(first, "ETag"));
+    REQUIRE(headerOf(second, "Age") == "0");
+
+    /* 查询串不同是不同的条目 */
+    fixture.request("GET", "/a?x=2");
+    REQUIRE(fixture.m_calls == 2);
+
+    auto stats = fixture.m_cache.stats();
+    REQUIRE(stats.m_hits == 1);
+    REQUIRE(stats.m_stores == 2);
+    REQUIRE(stats.m_entries == 2);
+}
+
+TEST_CASE("Equivalent paths share one entry", "[ResponseCache]")
+{
+    CacheFixture fixture;
+    fixture.request("GET", "/docs/page");
+    auto target = GENERATE(as<string> {}, "//docs/./page", "/docs/x/../page", "/%64ocs/page", "/../docs/page");
+    auto response = fixture.request("GET", target);
+    REQUIRE(fixture.m_calls == 1);
+    REQUIRE(bodyOf(response) == "body of /docs/page");
+
+    fixture.request("GET", "/docs/page/");
+    fixture.request("GET", "/docs/%2Fpage");
+    REQUIRE(fixture.m_calls == 3);
+    fixture.request("GET", "/docs/%2fpage");
+    REQUIRE(fixture.m_calls == 3);
+}
+
+TEST_CASE("HEAD is answered from the GET entry", "[ResponseCache]")
+{
+    CacheFixture fixture;
+    auto head = fixture.request("HEAD", "/h");
+    REQUIRE(fixture.m_calls == 1);
+    REQUIRE(fixture.m_cache.stats().m_stores == 0);
+
+    fixture.request("GET", "/h");
+    head = fixture.request("HEAD", "/h");
+    REQUIRE(fixture.m_calls == 2);
+    REQUIRE(headerOf(head, "Content-Length") == "10");
+    REQUIRE(bodyOf(head).empty());
+}
+
+TEST_CASE("Responses that forbid shared caching are not stored", "[ResponseCache]")
+{
+    CacheFixture fixture;
+    SECTION("Cache-Control")
+    {
+        fixture.m_cacheControl = GENERATE(as<string> {}, "no-store", "private, max-age=60", "no-cache", "max-age=0", "");
+    }
+    SECTION("Set-Cookie")
+    {
+        fixture.m_extraHeaders = { { "Set-Cookie", "id=1" } };
+    }
+    SECTION("Vary on a header outside the key")
+    {
+        fixture.m_extraHeaders = { { "Vary", "Accept-Encoding, Cookie" } };
+    }
+    fixture.request("GET", "/p");
+    fixture.request("GET", "/p");
+    REQUIRE(fixture.m_calls == 2);
+    REQUIRE(fixture.m_cache.stats().m_entries == 0);
+}
+
+TEST_CASE("Requests may bypass the cache", "[ResponseCache]")
+{
+    CacheFixture fixture;
+    fixture.request("GET", "/b");
+    auto headers = GENERATE(as<string> {}, "Cache-Control: no-cache\r\n", "Cache-Control: max-age=0\r\n",
+        "Pragma: no-cache\r\n", "Authorization: Basic eDp5\r\n");
+    fixture.request("GET", "/b", headers);
+    REQUIRE(fixture.m_calls == 2);
+    fixture.request("POST", "/b");
+    REQUIRE(fixture.m_calls == 3);
+}
+
+TEST_CASE("Configured request headers are part of the key", "[ResponseCache]")
+{
+    CacheFixture fixture;
+    fixture.m_extraHeaders = { { "Vary", "accept-encoding" } };
+    fixture.request("GET", "/v", "Accept-Encoding: gzip\r\n");
+    fixture.request("GET", "/v", "Accept-Encoding: gzip\r\n");
+    REQUIRE(fixture.m_calls == 1);
+    fixture.request("GET", "/v");
+    REQUIRE(fixture.m_calls == 2);
+    fixture.request("GET", "/v", "Accept-Encoding: br\r\n");
+    REQUIRE(fixture.m_calls == 3);
+}
+
+TEST_CASE("Entries expire after their freshness lifetime", "[ResponseCache]")
+{
+    auto options = CacheFixture::defaultOptions();
+    options.m_defaultTtl = chrono::seconds(1);
+    CacheFixture fixture(options);
+    fixture.m_cacheControl.clear();
+    fixture.request("GET", "/t");
+    fixture.request("GET", "/t");
+    REQUIRE(fixture.m_calls == 1);
+
+    this_thread::sleep_for(chrono::milliseconds(1100));
+    fixture.request("GET", "/t");
+    REQUIRE(fixture.m_calls == 2);
+    REQUIRE(fixture.m_cache.stats().m_expirations == 1);
+
+    /* s-maxage 优先于 max-age */
+    fixture.m_cacheControl = "max-age=60, s-maxage=0";
+    fixture.request("GET", "/s");
+    fixture.request("GET", "/s");
+    REQUIRE(fixture.m_calls == 4);
+}
+
+TEST_CASE("Conditional requests are answered from the entry", "[ResponseCache]")
+{
+    CacheFixture fixture;
+    fixture.m_extraHeaders = { { "Last-Modified", "Sun, 06 Nov 1994 08:49:37 GMT" } };
+    auto first = fixture.request("GET", "/c");
+    auto etag = headerOf(first, "ETag");
+
+    auto notModified = fixture.request("GET", "/c", "If-None-Match: \"other\", " + etag + "\r\n");
+    REQUIRE(notModified.rfind("HTTP/1.1 304 Not Modified\r\n", 0) == 0);
+    REQUIRE(headerOf(notModified, "ETag") == etag);
+    REQUIRE(headerOf(notModified, "Content-Length").empty());
+    REQUIRE(bodyOf(notModified).empty());
+
+    auto changed = fixture.request("GET", "/c", "If-None-Match: \"other\"\r\n");
+    REQUIRE(changed.rfind("HTTP/1.1 200 OK\r\n", 0) == 0);
+
+    auto since = fixture.request("GET", "/c", "If-Modified-Since: Sun, 06 Nov 1994 08:49:37 GMT\r\n");
+    REQUIRE(since.rfind("HTTP/1.1 304 Not Modified\r\n", 0) == 0);
+    /* If-None-Match 存在时忽略 If-Modified-Since */
+    auto both = fixture.request(
+        "GET", "/c", "If-None-Match: \"other\"\r\nIf-Modified-Since: Sun, 06 Nov 1994 08:49:37 GMT\r\n");
+    REQUIRE(both.rfind("HTTP/1.1 200 OK\r\n", 0) == 0);
+    REQUIRE(fixture.m_calls == 1);
+}
+
+TEST_CASE("The byte budget evicts the least recently used entries", "[ResponseCache]")
+{
+    ResponseCacheOptions options;
+    options.m_maxBytes = 4096;
+    options.m_shards = 1;
+    CacheFixture fixture(options);
+    fixture.m_body = string(1000, 'x');
+    for (int i = 0; i < 3; i++)
+        fixture.request("GET", "/e" + to_string(i));
+    REQUIRE(fixture.m_cache.stats().m_entries == 3);
+
+    /* 访问 /e0 使其成为最近使用，接下来淘汰 /e1 */
+    fixture.request("GET", "/e0");
+    fixture.request("GET", "/e3");
+    auto stats = fixture.m_cache.stats();
+    REQUIRE(stats.m_evictions == 1);
+    REQUIRE(stats.m_entries == 3);
+    REQUIRE(stats.m_bytes <= options.m_maxBytes);
+
+    int calls = fixture.m_calls;
+    fixture.request("GET", "/e0");
+    REQUIRE(fixture.m_calls == calls);
+    fixture.request("GET", "/e1");
+    REQUIRE(fixture.m_calls == calls + 1);
+
+    /* 超过单条上限的响应不缓存 */
+    fixture.m_body = string(8192, 'y');
+    fixture.request("GET", "/big");
+    fixture.request("GET", "/big");
+    REQUIRE(fixture.m_calls == calls + 3);
+}
+
+TEST_CASE("Large cached bodies are shared rather than copied", "[ResponseCache]")
+{
+    CacheFixture fixture;
+    fixture.m_body = string(64 * 1024, 'z');
+    fixture.request("GET", "/large");
+
+    /* 缓冲区中保留两份响应，它们的响应体指向同一块内存 */
+    string raw = "GET /large HTTP/1.1\r\nHost: x\r\n\r\n";
+    evbuffer_add(fixture.m_input, raw.data(), raw.size());
+    evbuffer_add(fixture.m_input, raw.data(), raw.size());
+    fixture.m_connection->onInput(fixture.m_input, fixture.m_output);
+    REQUIRE(fixture.m_calls == 1);
+
+    struct evbuffer_ptr pos = evbuffer_search(fixture.m_output, "\r\n\r\n", 4, nullptr);
+    REQUIRE(pos.pos >= 0);
+    evbuffer_drain(fixture.m_output, static_cast<size_t>(pos.pos) + 4);
+    struct evbuffer_iovec first;
+    REQUIRE(evbuffer_peek(fixture.m_output, -1, nullptr, &first, 1) >= 1);
+    REQUIRE(first.iov_len == fixture.m_body.size());
+    evbuffer_drain(fixture.m_output, first.iov_len);
+
+    pos = evbuffer_search(fixture.m_output, "\r\n\r\n", 4, nullptr);
+    REQUIRE(pos.pos >= 0);
+    evbuffer_drain(fixture.m_output, static_cast<size_t>(pos.pos) + 4);
+    struct evbuffer_iovec second;
+    REQUIRE(evbuffer_peek(fixture.m_output, -1, nullptr, &second, 1) >= 1);
+    REQUIRE(second.iov_base == first.iov_base);
+    REQUIRE(evbuffer_get_length(fixture.m_output) == fixture.m_body.size());
+}
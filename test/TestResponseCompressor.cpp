@@ -0,0 +1,286 @@
+#include "ResponseCache.h"
+#include "ResponseCompressor.h"
+#include "StaticFileHandler.h"
+#include "TestHttpHelpers.h"
+#include "catch2/catch.hpp"
+
+#include <chrono>
+#include <event2/buffer.h>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <zlib.h>
+
+using namespace ToolKit;
+using namespace TestHttp;
+using namespace std;
+
+namespace
+{
+/**
+ * @brief 用 zlib 解压 gzip 或 zlib 封装的数据
+ */
+string inflateAll(const string& Data, CONTENT_CODING Coding)
+{
+    z_stream stream {};
+    REQUIRE(inflateInit2(&stream, Coding == CONTENT_CODING::GZIP ? MAX_WBITS + 16 : MAX_WBITS) == Z_OK);
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(Data.data()));
+    stream.avail_in = static_cast<uInt>(Data.size());
+    string result;
+    char chunk[4096];
+    int ret = Z_OK;
+    while (ret == Z_OK)
+    {
+        stream.next_out = reinterpret_cast<Bytef*>(chunk);
+        stream.avail_out = sizeof(chunk);
+        ret = inflate(&stream, Z_NO_FLUSH);
+        result.append(chunk, sizeof(chunk) - stream.avail_out);
+    }
+    inflateEnd(&stream);
+    REQUIRE(ret == Z_STREAM_END);
+    return result;
+}
+
+string textOf(size_t Size)
+{
+    string text;
+    while (text.size() < Size)
+        text += "line " + to_string(text.size()) + " of a highly compressible text body\n";
+    text.resize(Size);
+    return text;
+}
+
+/**
+ * @brief 经过 HttpConnection 的压缩：处理函数返回可配置的内容，记录被调用的次数
+ */
+struct CompressorFixture : ConnectionHarness
+{
+    explicit CompressorFixture(ResponseCompressorOptions Options = {})
+            : m_compressor(std::move(Options))
+    {
+        m_options.m_compressor = &m_compressor;
+        m_handler.m_handler = [this](const HttpRequest&, HttpResponse& Response)
+        {
+            m_calls++;
+            Response.setStatus(m_status);
+            Response.addHeader("Content-Type", m_contentType);
+            for (auto& [name, value] : m_extraHeaders)
+                Response.addHeader(name, value);
+            evbuffer_add(Response.body(), m_body.data(), m_body.size());
+        };
+        connect();
+    }
+
+    ResponseCompressor m_compressor;
+    int m_calls { 0 };
+    int m_status { 200 };
+    string m_contentType { "text/html; charset=utf-8" };
+    vector<pair<string, string>> m_extraHeaders;
+    string m_body { textOf(4096) };
+};
+}   // namespace
+
+TEST_CASE("Accept-Encoding negotiation honours q-values", "[ResponseCompressor]")
+{
+    REQUIRE(negotiateCoding("") == CONTENT_CODING::IDENTITY);
+    REQUIRE(negotiateCoding("gzip") == CONTENT_CODING::GZIP);
+    REQUIRE(negotiateCoding("deflate, gzip") == CONTENT_CODING::GZIP);
+    REQUIRE(negotiateCoding("deflate") == CONTENT_CODING::DEFLATE);
+    REQUIRE(negotiateCoding("gzip;q=0.5, deflate;q=0.8") == CONTENT_CODING::DEFLATE);
+    REQUIRE(negotiateCoding("gzip;q=0, deflate;q=0") == CONTENT_CODING::IDENTITY);
+    REQUIRE(negotiateCoding("GZIP ; Q=1.000") == CONTENT_CODING::GZIP);
+    REQUIRE(negotiateCoding("x-gzip") == CONTENT_CODING::GZIP);
+    REQUIRE(negotiateCoding("br") == CONTENT_CODING::IDENTITY);
+    REQUIRE(negotiateCoding("*") == CONTENT_CODING::GZIP);
+    REQUIRE(negotiateCoding("gzip;q=0, *") == CONTENT_CODING::DEFLATE);
+    REQUIRE(negotiateCoding("gzip;q=0.1, identity") == CONTENT_CODING::IDENTITY);
+    REQUIRE(negotiateCoding("gzip;q=0.1, identity;q=0") == CONTENT_CODING::GZIP);
+    /* 格式错误的 q 值忽略整个元素 */
+    REQUIRE(negotiateCoding("gzip;q=2") == CONTENT_CODING::IDENTITY);
+    REQUIRE(negotiateCoding("gzip;q=abc, deflate") == CONTENT_CODING::DEFLATE);
+
+    REQUIRE(codingName(CONTENT_CODING::GZIP) == "gzip");
+    REQUIRE(codingName(CONTENT_CODING::DEFLATE) == "deflate");
+    REQUIRE(codingName(CONTENT_CODING::IDENTITY).empty());
+}
+
+TEST_CASE("Compression streams every input chunk", "[ResponseCompressor]")
+{
+    auto coding = GENERATE(CONTENT_CODING::GZIP, CONTENT_CODING::DEFLATE);
+    auto size = GENERATE(size_t(0), size_t(100), size_t(300 * 1024));
+    string text = textOf(size);
+
+    /* 输入由许多小块组成，压缩器逐块读取 */
+    struct evbuffer* source = evbuffer_new();
+    for (size_t pos = 0; pos < text.size(); pos += 1000)
+        evbuffer_add_reference(source, text.data() + pos, min<size_t>(1000, text.size() - pos), nullptr, nullptr);
+    struct evbuffer* output = evbuffer_new();
+    REQUIRE(compressBuffer(coding, 6, source, output));
+    REQUIRE(evbuffer_get_length(source) == 0);
+    auto compressed = drainAll(output);
+    if (size > 1000)
+        REQUIRE(compressed.size() < text.size() / 4);
+    REQUIRE(inflateAll(compressed, coding) == text);
+
+    /* 同一线程上的流被复用，再压缩一次结果相同 */
+    evbuffer_add(source, text.data(), text.size());
+    REQUIRE(compressBuffer(coding, 6, source, output));
+    REQUIRE(drainAll(output) == compressed);
+    evbuffer_free(source);
+    evbuffer_free(output);
+}
+
+TEST_CASE("Responses are compressed according to Accept-Encoding", "[ResponseCompressor]")
+{
+    CompressorFixture fixture;
+    fixture.m_extraHeaders = { { "ETag", "\"v1\"" } };
+    auto gzip = fixture.request("GET", "/page", "Accept-Encoding: gzip, deflate\r\n");
+    REQUIRE(gzip.rfind("HTTP/1.1 200 OK\r\n", 0) == 0);
+    REQUIRE(headerOf(gzip, "Content-Encoding") == "gzip");
+    REQUIRE(headerOf(gzip, "Vary") == "Accept-Encoding");
+    REQUIRE(headerOf(gzip, "ETag") == "W/\"v1\"");
+    REQUIRE(headerOf(gzip, "Content-Length") == to_string(bodyOf(gzip).size()));
+    REQUIRE(inflateAll(bodyOf(gzip), CONTENT_CODING::GZIP) == fixture.m_body);
+
+    auto deflate = fixture.request("GET", "/page", "Accept-Encoding: deflate\r\n");
+    REQUIRE(headerOf(deflate, "Content-Encoding") == "deflate");
+    REQUIRE(inflateAll(bodyOf(deflate), CONTENT_CODING::DEFLATE) == fixture.m_body);
+
+    auto identity = fixture.request("GET", "/page");
+    REQUIRE(headerOf(identity, "Content-Encoding").empty());
+    REQUIRE(headerOf(identity, "Vary") == "Accept-Encoding");
+    REQUIRE(headerOf(identity, "ETag") == "\"v1\"");
+    REQUIRE(bodyOf(identity) == fixture.m_body);
+
+    auto head = fixture.request("HEAD", "/page", "Accept-Encoding: gzip\r\n");
+    REQUIRE(headerOf(head, "Content-Length") == headerOf(gzip, "Content-Length"));
+    REQUIRE(bodyOf(head).empty());
+}
+
+TEST_CASE("Only eligible responses are compressed", "[ResponseCompressor]")
+{
+    CompressorFixture fixture;
+    SECTION("Too small")
+    {
+        fixture.m_body = "short";
+    }
+    SECTION("Too large")
+    {
+        ResponseCompressorOptions options;
+        options.m_maxBytes = 1024;
+        CompressorFixture limited(options);
+        auto response = limited.request("GET", "/", "Accept-Encoding: gzip\r\n");
+        REQUIRE(headerOf(response, "Content-Encoding").empty());
+        REQUIRE(bodyOf(response) == limited.m_body);
+        return;
+    }
+    SECTION("Binary content type")
+    {
+        fixture.m_contentType = "image/png";
+    }
+    SECTION("Already encoded")
+    {
+        fixture.m_extraHeaders = { { "Content-Encoding", "br" } };
+    }
+    SECTION("Not a 200")
+    {
+        fixture.m_status = 404;
+    }
+    auto response = fixture.request("GET", "/", "Accept-Encoding: gzip\r\n");
+    REQUIRE(headerOf(response, "Content-Encoding") != "gzip");
+    REQUIRE(bodyOf(response) == fixture.m_body);
+    REQUIRE(fixture.m_compressor.stats().m_compressed == 0);
+}
+
+TEST_CASE("Responses without a strong ETag are compressed every time", "[ResponseCompressor]")
+{
+    CompressorFixture fixture;
+    fixture.m_extraHeaders = { { "ETag", "W/\"weak\"" } };
+    fixture.request("GET", "/d", "Accept-Encoding: gzip\r\n");
+    auto second = fixture.request("GET", "/d", "Accept-Encoding: gzip\r\n");
+    REQUIRE(headerOf(second, "ETag") == "W/\"weak\"");
+    REQUIRE(inflateAll(bodyOf(second), CONTENT_CODING::GZIP) == fixture.m_body);
+    auto stats = fixture.m_compressor.stats();
+    REQUIRE(stats.m_compressed == 2);
+    REQUIRE(stats.m_variantStores == 0);
+    REQUIRE(stats.m_bytesIn == 2 * fixture.m_body.size());
+    REQUIRE(stats.m_bytesOut < stats.m_bytesIn / 4);
+}
+
+TEST_CASE("Cached responses are compressed once per coding", "[ResponseCompressor]")
+{
+    CompressorFixture fixture;
+    ResponseCacheOptions cacheOptions;
+    cacheOptions.m_maxBytes = 1024 * 1024;
+    ResponseCache cache(cacheOptions);
+    fixture.m_options.m_responseCache = &cache;
+    fixture.m_extraHeaders = { { "Cache-Control", "max-age=60" } };
+
+    auto first = fixture.request("GET", "/c", "Accept-Encoding: gzip\r\n");
+    auto etag = headerOf(first, "ETag");
+    REQUIRE(etag.rfind("W/\"", 0) == 0);
+    for (int i = 0; i < 3; i++)
+    {
+        auto again = fixture.request("GET", "/c", "Accept-Encoding: gzip\r\n");
+        REQUIRE(bodyOf(again) == bodyOf(first));
+        REQUIRE(headerOf(again, "ETag") == etag);
+    }
+    fixture.request("GET", "/c", "Accept-Encoding: deflate\r\n");
+    auto identity = fixture.request("GET", "/c");
+    REQUIRE(bodyOf(identity) == fixture.m_body);
+    REQUIRE("W/" + headerOf(identity, "ETag") == etag);
+
+    /* 客户端保存的弱标签仍能得到 304 */
+    auto notModified = fixture.request("GET", "/c", "Accept-Encoding: gzip\r\nIf-None-Match: " + etag + "\r\n");
+    REQUIRE(notModified.rfind("HTTP/1.1 304 Not Modified\r\n", 0) == 0);
+
+    REQUIRE(fixture.m_calls == 1);
+    auto stats = fixture.m_compressor.stats();
+    REQUIRE(stats.m_compressed == 2);
+    REQUIRE(stats.m_variantStores == 2);
+    REQUIRE(stats.m_variantHits == 3);
+    REQUIRE(stats.m_entries == 2);
+}
+
+TEST_CASE("Static files are compressed once and served from the variant cache", "[ResponseCompressor]")
+{
+    char pattern[] = "/tmp/CompressorTestXXXXXX";
+    string root = mkdtemp(pattern);
+    string text = textOf(100 * 1024);
+    ofstream(root + "/app.js") << text;
+
+    const nlohmann::json config { { "Prefix", "/" }, { "Root", root } };
+    unique_ptr<HttpContentHandler> product = ContentHandlerFactory::instance().getProductClass(StaticFileHandler::TYPE, config);
+    CompressorFixture fixture;
+    fixture.m_handler.m_handler = [&product](const HttpRequest& Request, HttpResponse& Response)
+    { product->handle(Request, Response); };
+
+    auto first = fixture.request("GET", "/app.js", "Accept-Encoding: gzip\r\n");
+    REQUIRE(headerOf(first, "Content-Encoding") == "gzip");
+    REQUIRE(inflateAll(bodyOf(first), CONTENT_CODING::GZIP) == text);
+    auto second = fixture.request("GET", "/app.js", "Accept-Encoding: gzip\r\n");
+    REQUIRE(bodyOf(second) == bodyOf(first));
+    auto stats = fixture.m_compressor.stats();
+    REQUIRE(stats.m_compressed == 1);
+    REQUIRE(stats.m_variantHits == 1);
+
+    /* 区间请求按原始内容回复 */
+    auto range = fixture.request("GET", "/app.js", "Accept-Encoding: gzip\r\nRange: bytes=0-9\r\n");
+    REQUIRE(range.rfind("HTTP/1.1 206 Partial Content\r\n", 0) == 0);
+    REQUIRE(bodyOf(range) == text.substr(0, 10));
+
+    /* 文件变化后 ETag 随之改变，不会命中旧的压缩结果 */
+    ofstream(root + "/app.js") << text << "tail";
+    string updated;
+    for (int i = 0; i < 200 && updated.size() != text.size() + 4; i++)
+    {
+        this_thread::sleep_for(chrono::milliseconds(10));
+        updated = inflateAll(bodyOf(fixture.request("GET", "/app.js", "Accept-Encoding: gzip\r\n")), CONTENT_CODING::GZIP);
+    }
+    REQUIRE(updated == text + "tail");
+
+    product.reset();
+    filesystem::remove_all(root);
+}
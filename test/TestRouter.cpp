@@ -0,0 +1,216 @@
+#include "HttpConnection.h"
+#include "Router.h"
+#include "catch2/catch.hpp"
+
+#include <algorithm>
+#include <event2/buffer.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace ToolKit;
+using namespace std;
+
+namespace
+{
+/**
+ * @brief 每条路由的处理函数把自己的模式写进响应体，用来确认匹配到了哪一条
+ */
+HttpHandler tagged(const string& Tag)
+{
+    return HttpHandler { [Tag](const HttpRequest&, HttpResponse& Response)
+        { evbuffer_add(Response.body(), Tag.data(), Tag.size()); } };
+}
+
+Router routerOf(const vector<string>& Patterns)
+{
+    vector<pair<string, HttpHandler>> routes;
+    for (auto& pattern : Patterns)
+        routes.emplace_back(pattern, tagged(pattern));
+    return Router(routes);
+}
+
+/**
+ * @brief 匹配 Path 并返回命中的模式，未命中时返回空串；Match 中的参数值指向 Path，Path 须比 Match 活得久
+ */
+string matchedPattern(const Router& Table, string_view Path, RouteMatch& Match)
+{
+    if (!Table.match(Path, Match))
+        return string();
+    HttpRequest request;
+    HttpResponse response;
+    Match.m_handler->m_handler(request, response);
+    size_t len = evbuffer_get_length(response.body());
+    return string(reinterpret_cast<const char*>(evbuffer_pullup(response.body(), -1)), len);
+}
+
+string paramOf(const RouteMatch& Match, string_view Name)
+{
+    for (size_t i = 0; i < Match.m_paramCount; i++)
+    {
+        if (Match.m_params[i].m_name == Name)
+            return string(Match.m_params[i].m_value);
+    }
+    return "<none>";
+}
+}   // namespace
+
+TEST_CASE("Static routes match exactly", "[Router]")
+{
+    auto table = routerOf({ "/", "/users", "/users/list", "/user", "/about" });
+    REQUIRE(table.size() == 5);
+    RouteMatch match;
+    REQUIRE(matchedPattern(table, "/", match) == "/");
+    REQUIRE(matchedPattern(table, "/users", match) == "/users");
+    REQUIRE(matchedPattern(table, "/users/list", match) == "/users/list");
+    REQUIRE(matchedPattern(table, "/user", match) == "/user");
+    REQUIRE(matchedPattern(table, "/about", match) == "/about");
+    REQUIRE(match.m_paramCount == 0);
+    REQUIRE(matchedPattern(table, "/users/", match).empty());
+    REQUIRE(matchedPattern(table, "/use", match).empty());
+    REQUIRE(matchedPattern(table, "/abouts", match).empty());
+    REQUIRE(matchedPattern(table, "", match).empty());
+}
+
+TEST_CASE("Parameters capture one path segment", "[Router]")
+{
+    auto table = routerOf({ "/users/:id", "/users/:id/posts/:post", "/files/:name.txt", "/v:version/status" });
+    RouteMatch match;
+    REQUIRE(matchedPattern(table, "/users/42", match) == "/users/:id");
+    REQUIRE(paramOf(match, "id") == "42");
+
+    REQUIRE(matchedPattern(table, "/users/7/posts/hello-world", match) == "/users/:id/posts/:post");
+    REQUIRE(match.m_paramCount == 2);
+    REQUIRE(paramOf(match, "id") == "7");
+    REQUIRE(paramOf(match, "post") == "hello-world");
+
+    REQUIRE(matchedPattern(table, "/v2/status", match) == "/v:version/status");
+    REQUIRE(paramOf(match, "version") == "2");
+
+    /* 参数不能为空，也不跨越 / */
+    REQUIRE(matchedPattern(table, "/users/", match).empty());
+    REQUIRE(matchedPattern(table, "/users/1/2", match).empty());
+    /* 参数名只允许字母、数字与下划线，/files/:name.txt 整条被跳过 */
+    REQUIRE(matchedPattern(table, "/files/a.txt", match).empty());
+}
+
+TEST_CASE("Wildcards capture the rest of the path", "[Router]")
+{
+    auto table = routerOf({ "/static/*path", "/assets*", "/*" });
+    RouteMatch match;
+    REQUIRE(matchedPattern(table, "/static/css/site.css", match) == "/static/*path");
+    REQUIRE(paramOf(match, "path") == "css/site.css");
+    REQUIRE(matchedPattern(table, "/static/", match) == "/static/*path");
+    REQUIRE(paramOf(match, "path").empty());
+    REQUIRE(matchedPattern(table, "/assets-v2/x", match) == "/assets*");
+    REQUIRE(paramOf(match, "") == "-v2/x");
+    REQUIRE(matchedPattern(table, "/anything/else", match) == "/*");
+    REQUIRE(matchedPattern(table, "/", match) == "/*");
+}
+
+TEST_CASE("Static segments beat parameters which beat wildcards", "[Router]")
+{
+    auto table = routerOf({ "/users/me", "/users/:id", "/users/:id/settings", "/users/*rest", "/users/meta/info" });
+    RouteMatch match;
+    REQUIRE(matchedPattern(table, "/users/me", match) == "/users/me");
+    REQUIRE(matchedPattern(table, "/users/mo", match) == "/users/:id");
+    REQUIRE(matchedPattern(table, "/users/1", match) == "/users/:id");
+    /* /users/me 的静态分支走到底失败后回溯到参数分支 */
+    REQUIRE(matchedPattern(table, "/users/me/settings", match) == "/users/:id/settings");
+    REQUIRE(paramOf(match, "id") == "me");
+    REQUIRE(matchedPattern(table, "/users/meta/info", match) == "/users/meta/info");
+    REQUIRE(matchedPattern(table, "/users/meta", match) == "/users/:id");
+    /* 参数分支也失败时由通配符兜底，回溯时撤销已记录的参数 */
+    REQUIRE(matchedPattern(table, "/users/1/other", match) == "/users/*rest");
+    REQUIRE(match.m_paramCount == 1);
+    REQUIRE(paramOf(match, "rest") == "1/other");
+}
+
+TEST_CASE("Invalid and conflicting patterns are skipped", "[Router]")
+{
+    auto table = routerOf({ "/a/:id", "/a/:name", "/a/:id", "no-slash", "/b/*x/y", "/c/:", "/d/:bad-name", "/e/*", "/e/*other",
+        "/f/:a/:b/:c/:d/:e/:f/:g/:h/:i" });
+    REQUIRE(table.size() == 2);
+    RouteMatch match;
+    REQUIRE(matchedPattern(table, "/a/1", match) == "/a/:id");
+    REQUIRE(paramOf(match, "id") == "1");
+    REQUIRE(matchedPattern(table, "/e/z", match) == "/e/*");
+    REQUIRE(matchedPattern(table, "/b/q/y", match).empty());
+}
+
+TEST_CASE("Large route tables match every route", "[Router]")
+{
+    vector<string> patterns;
+    for (int i = 0; i < 500; i++)
+    {
+        patterns.push_back("/api/v1/resource" + to_string(i));
+        patterns.push_back("/api/v1/resource" + to_string(i) + "/:id");
+        patterns.push_back("/api/v1/resource" + to_string(i) + "/:id/items/*rest");
+    }
+    auto table = routerOf(patterns);
+    REQUIRE(table.size() == patterns.size());
+    RouteMatch match;
+    int wrong = 0;
+    for (int i = 0; i < 500; i++)
+    {
+        auto base = "/api/v1/resource" + to_string(i);
+        auto byId = base + "/x" + to_string(i);
+        auto items = base + "/9/items/a/b";
+        wrong += matchedPattern(table, base, match) != base;
+        wrong += matchedPattern(table, byId, match) != base + "/:id";
+        wrong += paramOf(match, "id") != "x" + to_string(i);
+        wrong += matchedPattern(table, items, match) != base + "/:id/items/*rest";
+        wrong += paramOf(match, "rest") != "a/b";
+    }
+    REQUIRE(wrong == 0);
+    REQUIRE(matchedPattern(table, "/api/v1/resource500", match).empty());
+}
+
+TEST_CASE("Static registrars add routes to the registry", "[Router]")
+{
+    {
+        RouteRegistrar first("/registered/:id", tagged("first").m_handler);
+        RouteRegistrar duplicate("/registered/:id", tagged("duplicate").m_handler, HANDLER_MODE::BLOCKING);
+        auto routes = RouteRegistry::instance().routes();
+        auto it = find_if(routes.begin(), routes.end(), [](const auto& Route) { return Route.first == "/registered/:id"; });
+        REQUIRE(it != routes.end());
+        REQUIRE(it->second.m_mode == HANDLER_MODE::INLINE);
+
+        Router table(routes);
+        RouteMatch match;
+        REQUIRE(matchedPattern(table, "/registered/5", match) == "first");
+    }
+    /* 析构时注销，重复注册失败的注册器不会误删别人的路由 */
+    auto routes = RouteRegistry::instance().routes();
+    REQUIRE(none_of(routes.begin(), routes.end(), [](const auto& Route) { return Route.first == "/registered/:id"; }));
+}
+
+TEST_CASE("Route parameters reach the handler through the request", "[Router]")
+{
+    string seen;
+    vector<pair<string, HttpHandler>> routes { { "/items/:id/*tail",
+        HttpHandler { [&seen](const HttpRequest& Request, HttpResponse&)
+            { seen = string(Request.param("id")) + "|" + string(Request.param("tail")) + "|" + string(Request.param("x")); } } } };
+    Router table(routes);
+    HttpHandler notFound { [](const HttpRequest&, HttpResponse& Response) { Response.setStatus(404); } };
+    const HttpHandlerResolver resolver = [&](HttpRequest& Request) -> const HttpHandler*
+    {
+        RouteMatch match;
+        if (!table.match(Request.m_path, match))
+            return &notFound;
+        Request.m_params.assign(match.m_params.begin(), match.m_params.begin() + match.m_paramCount);
+        return match.m_handler;
+    };
+    HttpConnectionOptions options;
+    HttpConnection connection(options, resolver);
+    struct evbuffer* input = evbuffer_new();
+    struct evbuffer* output = evbuffer_new();
+    string raw = "GET /items/12/a/b?q=1 HTTP/1.1\r\nHost: x\r\n\r\nGET /other HTTP/1.1\r\nHost: x\r\n\r\n";
+    evbuffer_add(input, raw.data(), raw.size());
+    connection.onInput(input, output);
+    REQUIRE(seen == "12|a/b|");
+    string text(reinterpret_cast<const char*>(evbuffer_pullup(output, -1)), evbuffer_get_length(output));
+    REQUIRE(text.find("HTTP/1.1 404 Not Found") != string::npos);
+    evbuffer_free(input);
+    evbuffer_free(output);
+}
@@ -0,0 +1,80 @@
+#include "Infra/SlabPool.h"
+#include "catch2/catch.hpp"
+
+#include <cstdint>
+#include <set>
+#include <vector>
+
+using namespace ToolKit;
+
+namespace
+{
+struct alignas(64) Tracked
+{
+    explicit Tracked(int Value = 0)
+            : m_value(Value)
+    {
+        m_live++;
+    }
+    ~Tracked() { m_live--; }
+
+    static int m_live;
+    int m_value;
+    int m_uses { 0 };
+};
+int Tracked::m_live = 0;
+}   // namespace
+
+TEST_CASE("SlabPool recycles released objects without destroying them", "[SlabPool]")
+{
+    {
+        SlabPool<Tracked, 4> pool;
+        std::vector<Tracked*> objects;
+        for (int i = 0; i < 6; i++)
+        {
+            objects.push_back(pool.acquire(i));
+            REQUIRE(reinterpret_cast<uintptr_t>(objects.back()) % 64 == 0);
+        }
+        REQUIRE(Tracked::m_live == 6);
+        REQUIRE(pool.capacity() == 8);
+
+        objects[2]->m_uses = 1;
+        pool.release(objects[2]);
+        REQUIRE(pool.idle() == 1);
+        REQUIRE(Tracked::m_live == 6);
+
+        /* 复用的对象保持原状态，构造参数被忽略 */
+        Tracked* reused = pool.acquire(100);
+        REQUIRE(reused == objects[2]);
+        REQUIRE(reused->m_value == 2);
+        REQUIRE(reused->m_uses == 1);
+
+        for (auto* object : objects)
+            pool.release(object);
+        REQUIRE(pool.idle() == 6);
+    }
+    REQUIRE(Tracked::m_live == 0);
+}
+
+TEST_CASE("SlabPool destroys objects beyond the idle limit but keeps their slots", "[SlabPool]")
+{
+    SlabPool<Tracked, 4> pool(2);
+    std::vector<Tracked*> objects;
+    for (int i = 0; i < 4; i++)
+        objects.push_back(pool.acquire(i));
+    for (auto* object : objects)
+        pool.release(object);
+    REQUIRE(pool.idle() == 2);
+    REQUIRE(Tracked::m_live == 2);
+
+    std::set<Tracked*> slots(objects.begin(), objects.end());
+    for (int i = 0; i < 4; i++)
+    {
+        objects[i] = pool.acquire(i);
+        REQUIRE(slots.count(objects[i]) == 1);
+    }
+    REQUIRE(Tracked::m_live == 4);
+    REQUIRE(pool.capacity() == 4);
+    for (auto* object : objects)
+        pool.release(object);
+}
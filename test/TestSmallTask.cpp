@@ -0,0 +1,201 @@
+#include "Infra/SmallTask.h"
+#include "Infra/ThreadPool.h"
+#include "Infra/WorkStealingThreadPool.h"
+#include "catch2/catch.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <new>
+#include <thread>
+#include <vector>
+
+using namespace ToolKit;
+
+namespace
+{
+std::atomic<bool> countAllocations { false };
+std::atomic<size_t> allocationCount { 0 };
+
+/**
+ * @brief 统计区间内全进程的 operator new 调用次数
+ */
+class AllocationCounter
+{
+public:
+    AllocationCounter()
+    {
+        allocationCount = 0;
+        countAllocations = true;
+    }
+    ~AllocationCounter() { countAllocations = false; }
+    size_t count() const { return allocationCount.load(); }
+};
+
+void waitFor(const std::atomic<size_t>& Counter, size_t Expected)
+{
+    while (Counter.load() < Expected)
+        std::this_thread::yield();
+}
+}   // namespace
+
+void* operator new(size_t Size)
+{
+    if (countAllocations.load(std::memory_order_relaxed))
+        allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(Size == 0 ? 1 : Size))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* Ptr) noexcept
+{
+    std::free(Ptr);
+}
+
+void operator delete(void* Ptr, size_t) noexcept
+{
+    std::free(Ptr);
+}
+
+TEST_CASE("SmallTask stores small callables inline", "[SmallTask]")
+{
+    auto tracker = std::make_shared<int>(0);
+    std::array<char, 24> padding {};
+    size_t allocations;
+    {
+        AllocationCounter counter;
+        SmallTask task([tracker, padding] { (*tracker) += 1 + padding[0]; });
+        SmallTask moved(std::move(task));
+        moved();
+        SmallTask assigned;
+        assigned = std::move(moved);
+        assigned();
+        allocations = counter.count();
+        REQUIRE_FALSE(static_cast<bool>(task));
+    }
+    REQUIRE(allocations == 0);
+    REQUIRE(*tracker == 2);
+    /* 所有拷贝都已销毁，捕获的 shared_ptr 只剩一个引用 */
+    REQUIRE(tracker.use_count() == 1);
+    REQUIRE(sizeof(SmallTask) == 64);
+}
+
+TEST_CASE("SmallTask falls back to one heap allocation for large callables", "[SmallTask]")
+{
+    std::array<char, SmallTask::INLINE_SIZE + 1> big {};
+    big[0] = 7;
+    int result = 0;
+    size_t allocations;
+    {
+        AllocationCounter counter;
+        SmallTask task([big, &result] { result = big[0]; });
+        SmallTask moved(std::move(task));
+        moved();
+        allocations = counter.count();
+    }
+    REQUIRE(allocations == 1);
+    REQUIRE(result == 7);
+}
+
+TEST_CASE("SmallTask holds move-only callables", "[SmallTask]")
+{
+    std::packaged_task<int()> packaged([] { return 42; });
+    auto future = packaged.get_future();
+    SmallTask task(std::move(packaged));
+    task();
+    REQUIRE(future.get() == 42);
+
+    auto owned = std::make_unique<int>(5);
+    int value = 0;
+    SmallTask ownsPointer([owned = std::move(owned), &value] { value = *owned; });
+    ownsPointer();
+    REQUIRE(value == 5);
+}
+
+TEMPLATE_TEST_CASE("Posting small tasks does not allocate in steady state", "[SmallTask]", ThreadPool, WorkStealingThreadPool)
+{
+    constexpr size_t TASKS = 10000;
+    std::atomic<size_t> done { 0 };
+    TestType pool(2);
+
+    /* 第一轮先阻塞所有工作线程，让任务队列、收件箱与节点链表增长到最大所需容量 */
+    std::atomic<size_t> blocked { 0 };
+    std::atomic<bool> release { false };
+    for (size_t i = 0; i < 2; i++)
+        pool.post(
+            [&]
+            {
+                blocked++;
+                while (!release)
+                    std::this_thread::yield();
+            });
+    waitFor(blocked, 2);
+    for (size_t i = 0; i < TASKS; i++)
+        pool.post([&done] { done++; });
+    release = true;
+    waitFor(done, TASKS);
+
+    size_t allocations;
+    {
+        AllocationCounter counter;
+        for (size_t i = 0; i < TASKS; i++)
+            pool.post([&done](size_t Step) { done += Step; }, size_t(1));
+        waitFor(done, 2 * TASKS);
+        allocations = counter.count();
+    }
+    REQUIRE(allocations == 0);
+}
+
+TEST_CASE("ThreadPool post is allocation free and enqueue allocates only the future state", "[SmallTask]")
+{
+    constexpr size_t TASKS = 1000;
+    std::atomic<size_t> done { 0 };
+    ThreadPool pool(1);
+    for (size_t i = 0; i < TASKS; i++)
+        pool.post([&done] { done++; });
+    waitFor(done, TASKS);
+
+    size_t postAllocations;
+    {
+        AllocationCounter counter;
+        for (size_t i = 0; i < TASKS; i++)
+            pool.post([&done] { done++; });
+        waitFor(done, 2 * TASKS);
+        postAllocations = counter.count();
+    }
+    REQUIRE(postAllocations == 0);
+
+    std::vector<std::future<void>> futures;
+    futures.reserve(TASKS);
+    size_t enqueueAllocations;
+    {
+        AllocationCounter counter;
+        for (size_t i = 0; i < TASKS; i++)
+            futures.push_back(pool.enqueue([&done] { done++; }));
+        waitFor(done, 3 * TASKS);
+        enqueueAllocations = counter.count();
+    }
+    /* packaged_task 的共享状态与 future 的结果对象各一次，不再有 make_shared、bind 与 std::function 的分配 */
+    REQUIRE(enqueueAllocations <= 2 * TASKS);
+}
+
+TEMPLATE_TEST_CASE("enqueueBulk submits a batch of tasks", "[SmallTask]", ThreadPool, WorkStealingThreadPool)
+{
+    std::atomic<size_t> done { 0 };
+    {
+        TestType pool(3);
+        std::vector<std::function<void()>> batch;
+        for (size_t i = 1; i <= 100; i++)
+            batch.emplace_back([&done, i] { done += i; });
+        pool.enqueueBulk(batch.begin(), batch.end());
+
+        std::vector<SmallTask> tasks;
+        for (size_t i = 0; i < 10; i++)
+            tasks.emplace_back([&done] { done += 1000; });
+        pool.enqueueBulk(tasks.begin(), tasks.end());
+    }
+    REQUIRE(done == 5050 + 10000);
+}
@@ -0,0 +1,227 @@
+#include "StaticFileHandler.h"
+#include "TestHttpHelpers.h"
+#include "catch2/catch.hpp"
+
+#include <cstdlib>
+#include <event2/buffer.h>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace ToolKit;
+using namespace TestHttp;
+using namespace std;
+
+namespace
+{
+/**
+ * @brief 临时根目录下的静态文件处理器
+ */
+struct StaticFileFixture : ConnectionHarness
+{
+    StaticFileFixture()
+    {
+        char pattern[] = "/tmp/StaticFileTestXXXXXX";
+        m_root = mkdtemp(pattern);
+        writeFile("hello.txt", "0123456789abcdefghij");
+        mkdir((m_root + "/docs").c_str(), 0755);
+        writeFile("docs/index.html", "<p>index</p>");
+        writeFile("empty.bin", "");
+
+        /* 注册器的参数类型是 const json&，这里必须以 const 左值传入 */
+        const nlohmann::json config { { "Prefix", "/static/" }, { "Root", m_root } };
+        m_product = ContentHandlerFactory::instance().getProductClass(StaticFileHandler::TYPE, config);
+        m_handler.m_handler = [this](const HttpRequest& Request, HttpResponse& Response)
+        { m_product->handle(Request, Response); };
+        connect();
+    }
+    ~StaticFileFixture() { filesystem::remove_all(m_root); }
+
+    void writeFile(const string& Name, const string& Content) { ofstream(m_root + "/" + Name) << Content; }
+
+    string m_root;
+    unique_ptr<HttpContentHandler> m_product;
+};
+}   // namespace
+
+TEST_CASE("Static files are served with validators and content type", "[StaticFile]")
+{
+    StaticFileFixture fixture;
+
+    auto response = fixture.request("GET", "/static/hello.txt");
+    REQUIRE(response.rfind("HTTP/1.1 200 OK\r\n", 0) == 0);
+    REQUIRE(headerOf(response, "Content-Length") == "20");
+    REQUIRE(headerOf(response, "Content-Type") == "text/plain; charset=utf-8");
+    REQUIRE(headerOf(response, "Accept-Ranges") == "bytes");
+    REQUIRE_FALSE(headerOf(response, "ETag").empty());
+    REQUIRE_FALSE(headerOf(response, "Last-Modified").empty());
+    REQUIRE(bodyOf(response) == "0123456789abcdefghij");
+
+    SECTION("HEAD reports the length without a body")
+    {
+        auto head = fixture.request("HEAD", "/static/hello.txt");
+        REQUIRE(headerOf(head, "Content-Length") == "20");
+        REQUIRE(bodyOf(head).empty());
+    }
+
+    SECTION("Directory requests fall back to the index file")
+    {
+        auto index = fixture.request("GET", "/static/docs/");
+        REQUIRE(headerOf(index, "Content-Type") == "text/html; charset=utf-8");
+        REQUIRE(bodyOf(index) == "<p>index</p>");
+        REQUIRE(fixture.request("GET", "/static/docs").rfind("HTTP/1.1 404", 0) == 0);
+    }
+
+    SECTION("Empty files have a zero length body")
+    {
+        auto empty = fixture.request("GET", "/static/empty.bin");
+        REQUIRE(headerOf(empty, "Content-Length") == "0");
+        REQUIRE(headerOf(empty, "Content-Type") == "application/octet-stream");
+    }
+
+    SECTION("Unsupported methods are rejected")
+    {
+        auto post = fixture.request("DELETE", "/static/hello.txt");
+        REQUIRE(post.rfind("HTTP/1.1 405", 0) == 0);
+        REQUIRE(headerOf(post, "Allow") == "GET, HEAD");
+    }
+}
+
+TEST_CASE("Conditional requests answer 304 without a body", "[StaticFile]")
+{
+    StaticFileFixture fixture;
+    auto response = fixture.request("GET", "/static/hello.txt");
+    auto etag = headerOf(response, "ETag");
+    auto lastModified = headerOf(response, "Last-Modified");
+
+    auto byEtag = fixture.request("GET", "/static/hello.txt", "If-None-Match: \"other\", W/" + etag + "\r\n");
+    REQUIRE(byEtag.rfind("HTTP/1.1 304 Not Modified\r\n", 0) == 0);
+    REQUIRE(headerOf(byEtag, "Content-Length").empty());
+    REQUIRE(bodyOf(byEtag).empty());
+
+    auto byDate = fixture.request("GET", "/static/hello.txt", "If-Modified-Since: " + lastModified + "\r\n");
+    REQUIRE(byDate.rfind("HTTP/1.1 304", 0) == 0);
+
+    /* If-None-Match 不匹配时忽略 If-Modified-Since */
+    auto stale = fixture.request(
+        "GET", "/static/hello.txt", "If-None-Match: \"other\"\r\nIf-Modified-Since: " + lastModified + "\r\n");
+    REQUIRE(stale.rfind("HTTP/1.1 200", 0) == 0);
+
+    auto older = fixture.request("GET", "/static/hello.txt", "If-Modified-Since: Thu, 01 Jan 1970 00:00:00 GMT\r\n");
+    REQUIRE(older.rfind("HTTP/1.1 200", 0) == 0);
+}
+
+TEST_CASE("Range requests return partial content", "[StaticFile]")
+{
+    StaticFileFixture fixture;
+
+    auto partial = fixture.request("GET", "/static/hello.txt", "Range: bytes=2-5\r\n");
+    REQUIRE(partial.rfind("HTTP/1.1 206 Partial Content\r\n", 0) == 0);
+    REQUIRE(headerOf(partial, "Content-Range") == "bytes 2-5/20");
+    REQUIRE(headerOf(partial, "Content-Length") == "4");
+    REQUIRE(bodyOf(partial) == "2345");
+
+    REQUIRE(bodyOf(fixture.request("GET", "/static/hello.txt", "Range: bytes=-3\r\n")) == "hij");
+    REQUIRE(bodyOf(fixture.request("GET", "/static/hello.txt", "Range: bytes=15-\r\n")) == "fghij");
+    REQUIRE(bodyOf(fixture.request("GET", "/static/hello.txt", "Range: bytes=18-100\r\n")) == "ij");
+
+    auto outside = fixture.request("GET", "/static/hello.txt", "Range: bytes=20-\r\n");
+    REQUIRE(outside.rfind("HTTP/1.1 416", 0) == 0);
+    REQUIRE(headerOf(outside, "Content-Range") == "bytes */20");
+
+    /* 多区间与无法识别的 Range 按完整内容回复 */
+    REQUIRE(fixture.request("GET", "/static/hello.txt", "Range: bytes=0-1,4-5\r\n").rfind("HTTP/1.1 200", 0) == 0);
+    REQUIRE(fixture.request("GET", "/static/hello.txt", "Range: items=0-1\r\n").rfind("HTTP/1.1 200", 0) == 0);
+
+    SECTION("If-Range only honours the range for the current version")
+    {
+        auto etag = headerOf(partial, "ETag");
+        auto current = fixture.request("GET", "/static/hello.txt", "Range: bytes=0-0\r\nIf-Range: " + etag + "\r\n");
+        REQUIRE(current.rfind("HTTP/1.1 206", 0) == 0);
+        auto changed = fixture.request("GET", "/static/hello.txt", "Range: bytes=0-0\r\nIf-Range: \"stale\"\r\n");
+        REQUIRE(changed.rfind("HTTP/1.1 200", 0) == 0);
+        REQUIRE(bodyOf(changed).size() == 20);
+    }
+}
+
+TEST_CASE("Paths outside the root are never served", "[StaticFile]")
+{
+    StaticFileFixture fixture;
+    fixture.writeFile("../StaticFileSecret", "secret");
+
+    auto traversal = GENERATE(as<string> {}, "/static/../StaticFileSecret", "/static/docs/../../StaticFileSecret",
+        "/static/%2e%2e/StaticFileSecret", "/static/docs%2f..%2f..%2fStaticFileSecret", "/static/hello.txt%00",
+        "/static/bad%zz", "/static/missing.txt");
+    CAPTURE(traversal);
+    REQUIRE(fixture.request("GET", traversal).rfind("HTTP/1.1 404", 0) == 0);
+
+    REQUIRE(bodyOf(fixture.request("GET", "/static/hello%2etxt")) == "0123456789abcdefghij");
+    REQUIRE(bodyOf(fixture.request("GET", "/static//docs/./index.html")) == "<p>index</p>");
+    REQUIRE(bodyOf(fixture.request("GET", "/static/docs/.")) == "<p>index</p>");
+    unlink((fixture.m_root + "/../StaticFileSecret").c_str());
+}
+
+TEST_CASE("File bodies are written to sockets without staging in memory", "[StaticFile]")
+{
+    StaticFileFixture fixture;
+    string content(256 * 1024, '\0');
+    for (size_t i = 0; i < content.size(); i++)
+        content[i] = static_cast<char>('a' + i % 26);
+    fixture.writeFile("large.bin", content);
+
+    string raw = "GET /static/large.bin HTTP/1.1\r\nHost: x\r\n\r\n";
+    evbuffer_add(fixture.m_input, raw.data(), raw.size());
+    /* 套接字的输出缓冲区与 bufferevent 一样标记为直接写往 fd，文件段以 sendfile 发送 */
+    evbuffer_set_flags(fixture.m_output, EVBUFFER_FLAG_DRAINS_TO_FD);
+    fixture.m_connection->onInput(fixture.m_input, fixture.m_output);
+
+    int fds[2];
+    REQUIRE(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    string received;
+    char buffer[65536];
+    while (evbuffer_get_length(fixture.m_output) > 0)
+    {
+        REQUIRE(evbuffer_write(fixture.m_output, fds[0]) > 0);
+        ssize_t n = read(fds[1], buffer, sizeof(buffer));
+        REQUIRE(n > 0);
+        received.append(buffer, static_cast<size_t>(n));
+    }
+    ssize_t n = 0;
+    shutdown(fds[0], SHUT_WR);
+    while ((n = read(fds[1], buffer, sizeof(buffer))) > 0)
+        received.append(buffer, static_cast<size_t>(n));
+    close(fds[0]);
+    close(fds[1]);
+
+    REQUIRE(headerOf(received, "Content-Length") == to_string(content.size()));
+    REQUIRE(bodyOf(received) == content);
+}
+
+TEST_CASE("Range and date helpers", "[StaticFile]")
+{
+    off_t offset = 0;
+    off_t length = 0;
+    REQUIRE(parseByteRange("bytes=0-0", 10, offset, length) == RANGE_STATUS::SATISFIABLE);
+    REQUIRE((offset == 0 && length == 1));
+    REQUIRE(parseByteRange("bytes=-20", 10, offset, length) == RANGE_STATUS::SATISFIABLE);
+    REQUIRE((offset == 0 && length == 10));
+    REQUIRE(parseByteRange("bytes=-0", 10, offset, length) == RANGE_STATUS::UNSATISFIABLE);
+    REQUIRE(parseByteRange("bytes=0-", 0, offset, length) == RANGE_STATUS::UNSATISFIABLE);
+    REQUIRE(parseByteRange("bytes=5-3", 10, offset, length) == RANGE_STATUS::NONE);
+    REQUIRE(parseByteRange("bytes=a-3", 10, offset, length) == RANGE_STATUS::NONE);
+    REQUIRE(parseByteRange("bytes=0-99999999999999999999999", 10, offset, length) == RANGE_STATUS::NONE);
+
+    char buffer[32];
+    REQUIRE(formatHttpDate(784111777, buffer) == "Sun, 06 Nov 1994 08:49:37 GMT");
+    time_t parsed = 0;
+    REQUIRE(parseHttpDate("Sun, 06 Nov 1994 08:49:37 GMT", parsed));
+    REQUIRE(parsed == 784111777);
+    REQUIRE_FALSE(parseHttpDate("Sunday, 06-Nov-94 08:49:37 GMT", parsed));
+
+    REQUIRE(mimeTypeOf("/a/b.PNG") == "image/png");
+    REQUIRE(mimeTypeOf("/a.dir/file") == "application/octet-stream");
+}
@@ -1,7 +1,13 @@
 #include "Infra/ThreadPool.h"
+#include "Infra/WorkStealingThreadPool.h"
 #include "catch2/catch.hpp"
 
+#include <atomic>
+#include <chrono>
 #include <iostream>
+#include <mutex>
+#include <set>
+#include <thread>
 
 TEST_CASE("Try use threadpool", "[ThreadPool]")
 {
@@ -17,4 +23,65 @@ TEST_CASE("Try use threadpool", "[ThreadPool]")
     for (auto&& result : results)
         res.push_back(result.get());
     REQUIRE_THAT(res, Catch::Matchers::UnorderedEquals(std::vector<int> { 0, 1, 4, 9, 16, 25, 36, 49 }));
-}
\ No newline at end of file
+}
+
+TEMPLATE_TEST_CASE("Thread pools run every task exactly once", "[ThreadPool]", ToolKit::ThreadPool, ToolKit::WorkStealingThreadPool)
+{
+    constexpr int PRODUCERS = 4;
+    constexpr int TASKS = 10000;
+    std::atomic<int> sum { 0 };
+    {
+        TestType pool(4);
+        std::vector<std::thread> producers;
+        for (int p = 0; p < PRODUCERS; p++)
+            producers.emplace_back(
+                [&pool, &sum]
+                {
+                    for (int i = 0; i < TASKS; i++)
+                        pool.enqueue([&sum, i] { sum += i; });
+                });
+        for (auto& producer : producers)
+            producer.join();
+    }
+    /* 析构时队列中剩余的任务全部执行完毕 */
+    REQUIRE(sum == PRODUCERS * (TASKS - 1) * TASKS / 2);
+}
+
+TEST_CASE("Work stealing pool spreads nested tasks across workers", "[ThreadPool]")
+{
+    std::mutex mutex;
+    std::set<std::thread::id> threads;
+    std::atomic<int> leaves { 0 };
+    std::function<void(int)> split;
+    {
+        ToolKit::WorkStealingThreadPool pool(4);
+        /* 在工作线程内部提交的任务进入本地队列，其他空闲线程只能通过窃取拿到 */
+        split = [&](int Depth)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                threads.insert(std::this_thread::get_id());
+            }
+            if (Depth == 0)
+            {
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+                leaves++;
+                return;
+            }
+            pool.enqueue(split, Depth - 1);
+            pool.enqueue(split, Depth - 1);
+        };
+        pool.enqueue(split, 10);
+    }
+    REQUIRE(leaves == 1024);
+    REQUIRE(threads.size() > 1);
+}
+
+TEST_CASE("Work stealing pool returns results through futures", "[ThreadPool]")
+{
+    ToolKit::WorkStealingThreadPool pool(2);
+    auto square = pool.enqueue([](int Value) { return Value * Value; }, 12);
+    auto failed = pool.enqueue([]() -> int { throw std::runtime_error("task failed"); });
+    REQUIRE(square.get() == 144);
+    REQUIRE_THROWS_AS(failed.get(), std::runtime_error);
+}
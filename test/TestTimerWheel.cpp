@@ -0,0 +1,141 @@
+#include "Infra/TimerWheel.h"
+#include "catch2/catch.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace ToolKit;
+
+TEST_CASE("Timers fire on their expiry tick", "[TimerWheel]")
+{
+    TimerWheel wheel;
+    int fired = 0;
+    WheelTimer timer([&] { fired++; });
+
+    wheel.arm(timer, 5);
+    REQUIRE(timer.armed());
+    REQUIRE(timer.expiry() == 5);
+    REQUIRE(wheel.advance(4) == 0);
+    REQUIRE(fired == 0);
+    REQUIRE(wheel.advance(5) == 1);
+    REQUIRE(fired == 1);
+    REQUIRE_FALSE(timer.armed());
+
+    SECTION("Re-arming moves the deadline")
+    {
+        wheel.arm(timer, 3);
+        wheel.advance(7);
+        wheel.arm(timer, 10);
+        REQUIRE(wheel.advance(16) == 0);
+        REQUIRE(wheel.advance(17) == 1);
+        REQUIRE(fired == 2);
+    }
+
+    SECTION("Cancelled and destroyed timers never fire")
+    {
+        wheel.arm(timer, 2);
+        wheel.cancel(timer);
+        REQUIRE_FALSE(timer.armed());
+        {
+            WheelTimer scoped([&] { fired++; });
+            wheel.arm(scoped, 1000);
+        }
+        REQUIRE(wheel.advance(5000) == 0);
+        REQUIRE(fired == 1);
+    }
+}
+
+TEST_CASE("Timers at every distance fire exactly on time across cascades", "[TimerWheel]")
+{
+    /* 起点靠近各层进位边界，覆盖低层转完一圈时的逐层分配 */
+    const uint64_t start = GENERATE(uint64_t(0), (uint64_t(1) << 14) - 3, (uint64_t(1) << 26) - 70);
+    TimerWheel wheel(start);
+    std::mt19937_64 random(42);
+
+    constexpr size_t TIMERS = 20000;
+    std::vector<std::unique_ptr<WheelTimer>> timers;
+    std::vector<uint64_t> expected(TIMERS);
+    std::vector<uint64_t> firedAt(TIMERS, 0);
+    for (size_t i = 0; i < TIMERS; i++)
+    {
+        timers.emplace_back(std::make_unique<WheelTimer>([&wheel, &firedAt, i] { firedAt[i] = wheel.now(); }));
+        /* 距离按数量级均匀分布，并包含少量超出最大跨度的定时器 */
+        uint64_t ticks = random() % (uint64_t(1) << (random() % 28));
+        expected[i] = start + (ticks == 0 ? 1 : ticks);
+        wheel.arm(*timers[i], ticks);
+    }
+
+    size_t fired = 0;
+    uint64_t now = start;
+    const uint64_t end = start + (uint64_t(1) << 27) + 10;
+    while (now < end)
+    {
+        now += 1 + random() % 4096;
+        fired += wheel.advance(now);
+    }
+    REQUIRE(fired == TIMERS);
+    for (size_t i = 0; i < TIMERS; i++)
+        REQUIRE(firedAt[i] == expected[i]);
+}
+
+TEST_CASE("Callbacks may re-arm, cancel and destroy timers", "[TimerWheel]")
+{
+    TimerWheel wheel;
+
+    SECTION("A periodic timer re-arms itself")
+    {
+        std::vector<uint64_t> ticks;
+        WheelTimer periodic;
+        periodic.setCallback(
+            [&]
+            {
+                ticks.push_back(wheel.now());
+                if (ticks.size() < 4)
+                    wheel.arm(periodic, 300);
+            });
+        wheel.arm(periodic, 300);
+        wheel.advance(10000);
+        REQUIRE(ticks == std::vector<uint64_t> { 300, 600, 900, 1200 });
+    }
+
+    SECTION("A callback cancels another timer due on the same tick")
+    {
+        int fired = 0;
+        WheelTimer first;
+        WheelTimer second;
+        first.setCallback(
+            [&]
+            {
+                fired++;
+                wheel.cancel(second);
+            });
+        second.setCallback(
+            [&]
+            {
+                fired++;
+                wheel.cancel(first);
+            });
+        wheel.arm(first, 9);
+        wheel.arm(second, 9);
+        REQUIRE(wheel.advance(9) == 1);
+        REQUIRE(fired == 1);
+    }
+
+    SECTION("A callback destroys its own timer")
+    {
+        auto owned = std::make_unique<WheelTimer>();
+        bool fired = false;
+        owned->setCallback(
+            [&]
+            {
+                fired = true;
+                owned.reset();
+            });
+        wheel.arm(*owned, 1);
+        REQUIRE(wheel.advance(1) == 1);
+        REQUIRE(fired);
+        REQUIRE(owned == nullptr);
+    }
+}
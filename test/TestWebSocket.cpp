@@ -0,0 +1,386 @@
+#include "HttpConnection.h"
+#include "WebSocket.h"
+#include "TestHttpHelpers.h"
+#include "catch2/catch.hpp"
+
+#include <event2/buffer.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace ToolKit;
+using namespace TestHttp;
+using namespace std;
+
+namespace
+{
+const string UPGRADE_REQUEST = "GET /ws HTTP/1.1\r\nHost: x\r\nUpgrade: websocket\r\nConnection: keep-alive, Upgrade\r\n"
+                               "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Version: 13\r\n\r\n";
+
+/**
+ * @brief 按客户端的方式编码一帧：加掩码，长度按需使用扩展字段
+ */
+string clientFrame(uint8_t FirstByte, const string& Payload, bool Masked = true)
+{
+    const unsigned char mask[4] { 0x9a, 0x0b, 0x5c, 0xe1 };
+    string frame(1, static_cast<char>(FirstByte));
+    const uint8_t maskBit = Masked ? 0x80 : 0;
+    if (Payload.size() < 126)
+        frame.push_back(static_cast<char>(maskBit | Payload.size()));
+    else if (Payload.size() <= 0xffff)
+    {
+        frame.push_back(static_cast<char>(maskBit | 126));
+        frame.push_back(static_cast<char>(Payload.size() >> 8));
+        frame.push_back(static_cast<char>(Payload.size()));
+    }
+    else
+    {
+        frame.push_back(static_cast<char>(maskBit | 127));
+        for (int i = 7; i >= 0; i--)
+            frame.push_back(static_cast<char>(static_cast<uint64_t>(Payload.size()) >> (i * 8)));
+    }
+    if (!Masked)
+        return frame + Payload;
+    frame.append(reinterpret_cast<const char*>(mask), 4);
+    for (size_t i = 0; i < Payload.size(); i++)
+        frame.push_back(static_cast<char>(Payload[i] ^ mask[i & 3]));
+    return frame;
+}
+
+string closePayload(uint16_t Code, const string& Reason = "")
+{
+    return string { static_cast<char>(Code >> 8), static_cast<char>(Code) } + Reason;
+}
+
+/**
+ * @brief 服务端发出的帧（不加掩码）
+ */
+string serverFrame(uint8_t FirstByte, const string& Payload)
+{
+    string frame(1, static_cast<char>(FirstByte));
+    frame.push_back(static_cast<char>(Payload.size()));
+    return frame + Payload;
+}
+
+struct Chunk
+{
+    WS_OPCODE m_opcode;
+    string m_data;
+    bool m_final;
+};
+
+/**
+ * @brief 记录回调的测试连接：收到完整消息时原样回送
+ */
+struct TestPeer
+{
+    TestPeer()
+    {
+        auto handler = make_shared<WebSocketHandler>();
+        handler->m_onOpen = [this](WebSocketSession&, const HttpRequest& Request) { m_openPath = string(Request.m_path); };
+        handler->m_onMessage = [this](WebSocketSession& Session, WS_OPCODE Opcode, string_view Data, bool Final)
+        {
+            m_chunks.push_back({ Opcode, string(Data), Final });
+            m_message.append(Data);
+            if (Final && m_echo)
+            {
+                Session.send(Opcode, m_message);
+                m_message.clear();
+            }
+        };
+        handler->m_onClose = [this](WebSocketSession&, uint16_t Code) { m_closeCodes.push_back(Code); };
+        m_route.m_webSocket = handler;
+    }
+
+    ~TestPeer()
+    {
+        evbuffer_free(m_input);
+        evbuffer_free(m_output);
+    }
+
+    CONN_ACTION feed(const string& Data)
+    {
+        evbuffer_add(m_input, Data.data(), Data.size());
+        return m_connection.onInput(m_input, m_output);
+    }
+
+    void handshake()
+    {
+        REQUIRE(feed(UPGRADE_REQUEST) == CONN_ACTION::KEEP_READING);
+        auto response = drainAll(m_output);
+        REQUIRE(response.find("HTTP/1.1 101 Switching Protocols\r\n") == 0);
+        REQUIRE(response.find("Sec-WebSocket-Accept: s3pPLMBiTxaQ9kYGzzhZRbK+xOo=\r\n") != string::npos);
+        REQUIRE(m_openPath == "/ws");
+    }
+
+    HttpHandler m_route;
+    HttpConnectionOptions m_options;
+    HttpHandlerResolver m_resolver = [this](HttpRequest&) { return &m_route; };
+    HttpConnection m_connection { m_options, m_resolver };
+    struct evbuffer* m_input = evbuffer_new();
+    struct evbuffer* m_output = evbuffer_new();
+    string m_openPath;
+    vector<Chunk> m_chunks;
+    string m_message;
+    bool m_echo { true };
+    vector<uint16_t> m_closeCodes;
+};
+}   // namespace
+
+TEST_CASE("Accept key matches the RFC 6455 example", "[WebSocket]")
+{
+    REQUIRE(webSocketAccept("dGhlIHNhbXBsZSBub25jZQ==") == "s3pPLMBiTxaQ9kYGzzhZRbK+xOo=");
+}
+
+TEST_CASE("UTF-8 validation works across chunk boundaries", "[WebSocket]")
+{
+    const string valid = "plain ascii text, then \xce\xba\xe1\xbd\xb9\xcf\x83\xce\xbc\xce\xb5 and \xf0\x9f\x98\x80";
+    /* 任意切分位置都应通过校验，且只有在字符边界上才算完整 */
+    for (size_t split = 0; split <= valid.size(); split++)
+    {
+        Utf8Validator validator;
+        REQUIRE(validator.feed(valid.data(), split));
+        REQUIRE(validator.feed(valid.data() + split, valid.size() - split));
+        REQUIRE(validator.complete());
+    }
+    Utf8Validator partial;
+    REQUIRE(partial.feed("\xf0\x9f", 2));
+    REQUIRE_FALSE(partial.complete());
+
+    /* 过长编码、代理区、超出范围的码点与孤立的后续字节 */
+    for (const string bad : { "\xc0\xaf", "\xe0\x80\xaf", "\xed\xa0\x80", "\xf4\x90\x80\x80", "\xf5\x80\x80\x80", "abc\x80" })
+    {
+        Utf8Validator validator;
+        INFO("bytes " << bad.size());
+        REQUIRE_FALSE(validator.feed(bad.data(), bad.size()));
+    }
+}
+
+TEST_CASE("Upgrade switches the connection and echoes masked frames", "[WebSocket]")
+{
+    TestPeer peer;
+    peer.handshake();
+
+    /* 同一次输入中的多个帧依次处理 */
+    REQUIRE(peer.feed(clientFrame(0x81, "Hello") + clientFrame(0x82, string(300, 'b'))) == CONN_ACTION::KEEP_READING);
+    auto output = drainAll(peer.m_output);
+    REQUIRE(output.substr(0, 7) == serverFrame(0x81, "Hello"));
+    /* 126 到 65535 字节的负载使用 2 字节扩展长度 */
+    REQUIRE(output.substr(7, 4) == string { '\x82', 126, 1, 44 });
+    REQUIRE(output.substr(11) == string(300, 'b'));
+    REQUIRE(peer.m_chunks.size() == 2);
+    REQUIRE(peer.m_chunks[0].m_opcode == WS_OPCODE::TEXT);
+    REQUIRE(peer.m_chunks[1].m_opcode == WS_OPCODE::BINARY);
+    REQUIRE(peer.m_connection.handledRequests() == 1);
+    REQUIRE_FALSE(peer.m_connection.blocked());
+    /* 没有收发中的帧时不设超时 */
+    REQUIRE(peer.m_connection.pendingDeadline(peer.m_input, peer.m_output) == DEADLINE::NONE);
+}
+
+TEST_CASE("Large frames are delivered as their bytes arrive", "[WebSocket]")
+{
+    TestPeer peer;
+    peer.handshake();
+
+    string payload(100000, '\0');
+    for (size_t i = 0; i < payload.size(); i++)
+        payload[i] = static_cast<char>(i * 7 + i / 251);
+    const auto frame = clientFrame(0x82, payload);
+    /* 每次到达的字节数不是 4 的倍数，每段的掩码相位都不同 */
+    size_t fed = 0;
+    for (size_t step = 1001; fed < frame.size(); fed += step)
+    {
+        REQUIRE(peer.feed(frame.substr(fed, step)) == CONN_ACTION::KEEP_READING);
+        if (fed + step < frame.size())
+        {
+            REQUIRE(evbuffer_get_length(peer.m_output) == 0);
+            REQUIRE(peer.m_connection.pendingDeadline(peer.m_input, peer.m_output) == DEADLINE::BODY_READ);
+        }
+    }
+    REQUIRE(peer.m_chunks.size() > 90);
+    string received;
+    for (size_t i = 0; i < peer.m_chunks.size(); i++)
+    {
+        REQUIRE(peer.m_chunks[i].m_final == (i + 1 == peer.m_chunks.size()));
+        received += peer.m_chunks[i].m_data;
+    }
+    REQUIRE(received == payload);
+    /* 回送使用 8 字节扩展长度 */
+    auto output = drainAll(peer.m_output);
+    REQUIRE(output.substr(0, 2) == string { '\x82', 127 });
+    REQUIRE(output.substr(10) == payload);
+}
+
+TEST_CASE("Fragmented messages interleave with control frames", "[WebSocket]")
+{
+    TestPeer peer;
+    peer.handshake();
+
+    /* "κόσμε" 的一个多字节字符跨越两个分片 */
+    const string text = "\xce\xba\xe1\xbd\xb9\xcf\x83\xce\xbc\xce\xb5";
+    REQUIRE(peer.feed(clientFrame(0x01, text.substr(0, 4))) == CONN_ACTION::KEEP_READING);
+    REQUIRE(peer.m_chunks.size() == 1);
+    REQUIRE_FALSE(peer.m_chunks[0].m_final);
+    REQUIRE(peer.feed(clientFrame(0x89, "ping!")) == CONN_ACTION::KEEP_READING);
+    REQUIRE(drainAll(peer.m_output) == serverFrame(0x8a, "ping!"));
+    /* 空的中间分片不会通知处理函数 */
+    REQUIRE(peer.feed(clientFrame(0x00, "") + clientFrame(0x80, text.substr(4))) == CONN_ACTION::KEEP_READING);
+    REQUIRE(peer.m_chunks.size() == 2);
+    REQUIRE(peer.m_chunks[1].m_opcode == WS_OPCODE::TEXT);
+    REQUIRE(peer.m_chunks[1].m_final);
+    REQUIRE(drainAll(peer.m_output) == serverFrame(0x81, text));
+    /* 空消息也会收到一次 Final 通知，PONG 直接忽略 */
+    REQUIRE(peer.feed(clientFrame(0x8a, "") + clientFrame(0x81, "")) == CONN_ACTION::KEEP_READING);
+    REQUIRE(peer.m_chunks.size() == 3);
+    REQUIRE(peer.m_chunks[2].m_final);
+    REQUIRE(drainAll(peer.m_output) == serverFrame(0x81, ""));
+}
+
+TEST_CASE("Close frames complete the closing handshake", "[WebSocket]")
+{
+    SECTION("Peer initiated close is echoed")
+    {
+        TestPeer peer;
+        peer.handshake();
+        REQUIRE(peer.feed(clientFrame(0x88, closePayload(1000, "bye")) + clientFrame(0x81, "late")) == CONN_ACTION::CLOSE_AFTER_WRITE);
+        REQUIRE(drainAll(peer.m_output) == serverFrame(0x88, closePayload(1000)));
+        REQUIRE(peer.m_closeCodes == vector<uint16_t> { 1000 });
+        REQUIRE(peer.m_chunks.empty());
+        peer.m_connection.reset();
+        REQUIRE(peer.m_closeCodes.size() == 1);
+    }
+    SECTION("Close without a status code")
+    {
+        TestPeer peer;
+        peer.handshake();
+        REQUIRE(peer.feed(clientFrame(0x88, "")) == CONN_ACTION::CLOSE_AFTER_WRITE);
+        REQUIRE(drainAll(peer.m_output) == serverFrame(0x88, ""));
+        REQUIRE(peer.m_closeCodes == vector<uint16_t> { WS_CLOSE_NO_STATUS });
+    }
+    SECTION("Server initiated close waits for the peer")
+    {
+        TestPeer peer;
+        peer.m_echo = false;
+        WebSocketSession* session = nullptr;
+        auto handler = make_shared<WebSocketHandler>(*peer.m_route.m_webSocket);
+        handler->m_onOpen = [&session](WebSocketSession& Session, const HttpRequest&) { session = &Session; };
+        peer.m_route.m_webSocket = handler;
+        REQUIRE(peer.feed(UPGRADE_REQUEST) == CONN_ACTION::KEEP_READING);
+        drainAll(peer.m_output);
+        REQUIRE(session != nullptr);
+
+        session->close(WS_CLOSE_GOING_AWAY, "restart");
+        REQUIRE(session->closeSent());
+        session->sendText("ignored");
+        REQUIRE(drainAll(peer.m_output) == serverFrame(0x88, closePayload(1001, "restart")));
+        REQUIRE(peer.m_connection.pendingDeadline(peer.m_input, peer.m_output) == DEADLINE::IDLE);
+        /* 关闭握手期间收到的数据帧丢弃 */
+        REQUIRE(peer.feed(clientFrame(0x81, "late")) == CONN_ACTION::KEEP_READING);
+        REQUIRE(peer.m_chunks.empty());
+        REQUIRE(peer.feed(clientFrame(0x88, closePayload(1001))) == CONN_ACTION::CLOSE_AFTER_WRITE);
+        REQUIRE(evbuffer_get_length(peer.m_output) == 0);
+        REQUIRE(peer.m_closeCodes == vector<uint16_t> { 1001 });
+    }
+    SECTION("Dropped connections report an abnormal closure")
+    {
+        TestPeer peer;
+        peer.handshake();
+        peer.m_connection.reset();
+        REQUIRE(peer.m_closeCodes == vector<uint16_t> { WS_CLOSE_ABNORMAL });
+        /* 复用后的连接重新按 HTTP/1.1 处理 */
+        peer.m_route.m_handler = [](const HttpRequest&, HttpResponse&) {};
+        REQUIRE(peer.feed("GET / HTTP/1.1\r\nHost: x\r\n\r\n") == CONN_ACTION::KEEP_READING);
+        REQUIRE(drainAll(peer.m_output).find("HTTP/1.1 200 OK") == 0);
+    }
+}
+
+TEST_CASE("Protocol violations fail the connection", "[WebSocket]")
+{
+    struct Case
+    {
+        const char* m_name;
+        string m_input;
+        uint16_t m_code;
+    };
+    const vector<Case> cases {
+        { "unmasked frame", clientFrame(0x81, "x", false), WS_CLOSE_PROTOCOL_ERROR },
+        { "reserved bits", clientFrame(0xc1, "x"), WS_CLOSE_PROTOCOL_ERROR },
+        { "unknown opcode", clientFrame(0x83, "x"), WS_CLOSE_PROTOCOL_ERROR },
+        { "continuation without a message", clientFrame(0x80, "x"), WS_CLOSE_PROTOCOL_ERROR },
+        { "new message inside a fragmented one", clientFrame(0x01, "x") + clientFrame(0x81, "y"), WS_CLOSE_PROTOCOL_ERROR },
+        { "fragmented ping", clientFrame(0x09, "x"), WS_CLOSE_PROTOCOL_ERROR },
+        { "oversized control frame", clientFrame(0x89, string(126, 'p')), WS_CLOSE_PROTOCOL_ERROR },
+        { "invalid close code", clientFrame(0x88, closePayload(1005)), WS_CLOSE_PROTOCOL_ERROR },
+        { "invalid UTF-8 text", clientFrame(0x81, "ok\xff"), WS_CLOSE_INVALID_PAYLOAD },
+        { "truncated UTF-8 at the end of a message", clientFrame(0x81, "\xce"), WS_CLOSE_INVALID_PAYLOAD },
+        { "invalid UTF-8 close reason", clientFrame(0x88, closePayload(1000, "\xc0\xaf")), WS_CLOSE_INVALID_PAYLOAD },
+    };
+    for (const auto& test : cases)
+    {
+        INFO(test.m_name);
+        TestPeer peer;
+        peer.handshake();
+        REQUIRE(peer.feed(test.m_input) == CONN_ACTION::CLOSE_AFTER_WRITE);
+        REQUIRE(drainAll(peer.m_output) == serverFrame(0x88, closePayload(test.m_code)));
+        REQUIRE(peer.m_closeCodes == vector<uint16_t> { test.m_code });
+        /* 出错之前的分片可能已经交出，但消息不会完成 */
+        for (auto& chunk : peer.m_chunks)
+            REQUIRE_FALSE(chunk.m_final);
+    }
+}
+
+TEST_CASE("Routes choose between WebSocket and plain HTTP", "[WebSocket]")
+{
+    SECTION("A WebSocket only route answers plain requests with 426")
+    {
+        TestPeer peer;
+        REQUIRE(peer.feed("GET /ws HTTP/1.1\r\nHost: x\r\n\r\n") == CONN_ACTION::KEEP_READING);
+        auto response = drainAll(peer.m_output);
+        REQUIRE(response.find("HTTP/1.1 426 ") == 0);
+        REQUIRE(response.find("Sec-WebSocket-Version: 13\r\n") != string::npos);
+        /* 不支持的版本同样不会升级 */
+        string oldVersion = UPGRADE_REQUEST;
+        oldVersion.replace(oldVersion.find("Version: 13"), 11, "Version: 8");
+        REQUIRE(peer.feed(oldVersion) == CONN_ACTION::KEEP_READING);
+        REQUIRE(drainAll(peer.m_output).find("HTTP/1.1 426 ") == 0);
+        REQUIRE(peer.m_openPath.empty());
+    }
+    SECTION("Routes without WebSocket ignore the upgrade")
+    {
+        TestPeer peer;
+        peer.m_route.m_webSocket.reset();
+        peer.m_route.m_handler = [](const HttpRequest&, HttpResponse& Response) { evbuffer_add(Response.body(), "plain", 5); };
+        REQUIRE(peer.feed(UPGRADE_REQUEST) == CONN_ACTION::KEEP_READING);
+        auto response = drainAll(peer.m_output);
+        REQUIRE(response.find("HTTP/1.1 200 OK") == 0);
+        REQUIRE(response.substr(response.size() - 5) == "plain");
+    }
+    SECTION("Pipelined requests before the upgrade are answered first")
+    {
+        TestPeer peer;
+        peer.m_route.m_handler = [](const HttpRequest&, HttpResponse& Response) { evbuffer_add(Response.body(), "plain", 5); };
+        REQUIRE(peer.feed("GET /a HTTP/1.1\r\nHost: x\r\n\r\n" + UPGRADE_REQUEST + clientFrame(0x81, "hi")) == CONN_ACTION::KEEP_READING);
+        auto output = drainAll(peer.m_output);
+        auto upgrade = output.find("HTTP/1.1 101 ");
+        REQUIRE(output.find("HTTP/1.1 200 OK") == 0);
+        REQUIRE(upgrade != string::npos);
+        REQUIRE(output.substr(output.size() - 4) == serverFrame(0x81, "hi"));
+    }
+}
+
+TEST_CASE("Reading pauses while the peer does not drain output", "[WebSocket]")
+{
+    TestPeer peer;
+    peer.m_options.m_outputHighWater = 1024;
+    peer.handshake();
+    string frames;
+    for (int i = 0; i < 10; i++)
+        frames += clientFrame(0x82, string(500, 'x'));
+    REQUIRE(peer.feed(frames) == CONN_ACTION::PAUSE_READING);
+    REQUIRE(peer.m_chunks.size() == 3);
+    /* 模拟写回调：输出发走后继续处理积压的帧 */
+    drainAll(peer.m_output);
+    while (peer.m_connection.onInput(peer.m_input, peer.m_output) == CONN_ACTION::PAUSE_READING)
+        drainAll(peer.m_output);
+    REQUIRE(peer.m_chunks.size() == 10);
+}